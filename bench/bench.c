@@ -0,0 +1,1133 @@
+/* bench.c
+ *
+ * Copyright (C) 2021 wolfSSL Inc.
+ *
+ * This file is part of wolfProvider.
+ *
+ * wolfProvider is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfProvider is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wolfProvider.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include <openssl/evp.h>
+#include <openssl/core_names.h>
+#include <openssl/params.h>
+#include <openssl/provider.h>
+#include <openssl/kdf.h>
+
+#include <wolfprovider/wp_wolfprov.h>
+
+/* Maximum number of data sizes to benchmark. */
+#define BENCH_MAX_SIZES     16
+/* Maximum number of threads to benchmark with. */
+#define BENCH_MAX_THREADS   64
+/* Number of operations between checks of the time. */
+#define BENCH_BATCH         16
+/* Length of keys, IVs and KDF output used. */
+#define BENCH_KEY_LEN       64
+/* Minimum size of output buffer - large enough for signatures and secrets. */
+#define BENCH_MIN_BUF_LEN   1024
+
+/* Kinds of algorithm benchmarked. */
+#define BENCH_CIPHER        0
+#define BENCH_DIGEST        1
+#define BENCH_MAC           2
+#define BENCH_KDF           3
+#define BENCH_SIGN          4
+#define BENCH_KEYEXCH       5
+
+/* Algorithm to benchmark. */
+typedef struct BENCH_ALG {
+    /* Name to display. */
+    const char* name;
+    /* Kind of algorithm: BENCH_*. */
+    int kind;
+    /* Name of algorithm to fetch or key type. */
+    const char* alg;
+    /* Digest, cipher or group name. Bits for RSA. NULL when not needed. */
+    const char* param;
+} BENCH_ALG;
+
+/* Algorithms benchmarked - those in wolfProvider's algorithm tables. */
+static const BENCH_ALG bench_algs[] = {
+    { "AES-128-ECB",        BENCH_CIPHER,  "AES-128-ECB",       NULL        },
+    { "AES-128-CBC",        BENCH_CIPHER,  "AES-128-CBC",       NULL        },
+    { "AES-256-CBC",        BENCH_CIPHER,  "AES-256-CBC",       NULL        },
+    { "AES-128-CTR",        BENCH_CIPHER,  "AES-128-CTR",       NULL        },
+    { "AES-256-CTR",        BENCH_CIPHER,  "AES-256-CTR",       NULL        },
+    { "AES-128-GCM",        BENCH_CIPHER,  "AES-128-GCM",       NULL        },
+    { "AES-256-GCM",        BENCH_CIPHER,  "AES-256-GCM",       NULL        },
+    { "AES-128-XTS",        BENCH_CIPHER,  "AES-128-XTS",       NULL        },
+    { "ChaCha20-Poly1305",  BENCH_CIPHER,  "ChaCha20-Poly1305", NULL        },
+    { "MD5",                BENCH_DIGEST,  "MD5",               NULL        },
+    { "SHA1",               BENCH_DIGEST,  "SHA1",              NULL        },
+    { "SHA224",             BENCH_DIGEST,  "SHA224",            NULL        },
+    { "SHA256",             BENCH_DIGEST,  "SHA256",            NULL        },
+    { "SHA384",             BENCH_DIGEST,  "SHA384",            NULL        },
+    { "SHA512",             BENCH_DIGEST,  "SHA512",            NULL        },
+    { "SHA3-256",           BENCH_DIGEST,  "SHA3-256",          NULL        },
+    { "SHA3-512",           BENCH_DIGEST,  "SHA3-512",          NULL        },
+    { "HMAC-SHA256",        BENCH_MAC,     "HMAC",              "SHA256"    },
+    { "HMAC-SHA512",        BENCH_MAC,     "HMAC",              "SHA512"    },
+    { "CMAC-AES-128",       BENCH_MAC,     "CMAC",              "AES-128-CBC" },
+    { "GMAC-AES-128",       BENCH_MAC,     "GMAC",              "AES-128-GCM" },
+    { "HKDF-SHA256",        BENCH_KDF,     "HKDF",              "SHA256"    },
+    { "TLS1-PRF-SHA256",    BENCH_KDF,     "TLS1-PRF",          "SHA256"    },
+    { "PBKDF2-SHA256",      BENCH_KDF,     "PBKDF2",            "SHA256"    },
+    { "RSA-2048",           BENCH_SIGN,    "RSA",               "2048"      },
+    { "RSA-3072",           BENCH_SIGN,    "RSA",               "3072"      },
+    { "ECDSA-P256",         BENCH_SIGN,    "EC",                "P-256"     },
+    { "ECDSA-P384",         BENCH_SIGN,    "EC",                "P-384"     },
+    { "Ed25519",            BENCH_SIGN,    "ED25519",           NULL        },
+    { "Ed448",              BENCH_SIGN,    "ED448",             NULL        },
+    { "ECDH-P256",          BENCH_KEYEXCH, "EC",                "P-256"     },
+    { "ECDH-P384",          BENCH_KEYEXCH, "EC",                "P-384"     },
+    { "X25519",             BENCH_KEYEXCH, "X25519",            NULL        },
+    { "X448",               BENCH_KEYEXCH, "X448",              NULL        },
+    { "DH-ffdhe2048",       BENCH_KEYEXCH, "DH",                "ffdhe2048" },
+};
+#define BENCH_ALG_CNT   (int)(sizeof(bench_algs) / sizeof(*bench_algs))
+
+/* State of one benchmark of an algorithm. */
+typedef struct BENCH_STATE {
+    const BENCH_ALG* alg;
+    OSSL_LIB_CTX* libCtx;
+    size_t size;
+    unsigned char key[BENCH_KEY_LEN];
+    unsigned char iv[BENCH_KEY_LEN];
+    unsigned char* in;
+    unsigned char* out;
+    size_t bufLen;
+    size_t outLen;
+    EVP_CIPHER* cipher;
+    EVP_CIPHER_CTX* cipherCtx;
+    EVP_MD* md;
+    EVP_MD_CTX* mdCtx;
+    EVP_MAC* mac;
+    EVP_MAC_CTX* macCtx;
+    EVP_KDF* kdf;
+    EVP_KDF_CTX* kdfCtx;
+    EVP_PKEY* pkey;
+    EVP_PKEY* peer;
+    OSSL_PARAM params[6];
+    /* Parameters to re-initialize MAC with - IV for GMAC. */
+    OSSL_PARAM* reinit;
+    OSSL_PARAM ivParams[2];
+    unsigned int iter;
+} BENCH_STATE;
+
+/* Options of run. */
+typedef struct BENCH_OPTS {
+    /* Directory of wolfProvider shared library. */
+    const char* dir;
+    /* Name of wolfProvider. */
+    const char* name;
+    /* Seconds to run each benchmark for. */
+    double secs;
+    /* Data sizes to benchmark. */
+    size_t sizes[BENCH_MAX_SIZES];
+    /* Number of data sizes. */
+    int sizeCnt;
+    /* Number of threads to run each benchmark on. */
+    int threads;
+    /* Each thread has its own library context. */
+    int isolate;
+    /* Benchmark default provider as well. */
+    int compare;
+    /* Only benchmark algorithms whose name contains this. */
+    const char* filter;
+    /* Run handshake-shaped scaling benchmark instead. */
+    int scaling;
+    /* Sign with ECDSA instead of RSA in scaling benchmark. */
+    int ecdsa;
+} BENCH_OPTS;
+
+/* Work and results of one benchmark thread. */
+typedef struct BENCH_THREAD {
+    pthread_t thread;
+    int started;
+    const BENCH_OPTS* opts;
+    const BENCH_ALG* alg;
+    OSSL_LIB_CTX* libCtx;
+    /* Provider to load when isolated. */
+    const char* provName;
+    size_t size;
+    unsigned long ops;
+    double elapsed;
+    unsigned long long cycles;
+    int err;
+} BENCH_THREAD;
+
+/* Result of a benchmark. */
+typedef struct BENCH_RESULT {
+    double opsPerSec;
+    double cyclesPerByte;
+    double cyclesPerOp;
+    int err;
+} BENCH_RESULT;
+
+
+/**
+ * Get the current time in seconds.
+ *
+ * @return  Monotonic time in seconds.
+ */
+static double bench_time(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+}
+
+/**
+ * Get the CPU's cycle counter.
+ *
+ * @return  Cycle count when available.
+ * @return  0 otherwise.
+ */
+static unsigned long long bench_cycles(void)
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    return __builtin_ia32_rdtsc();
+#else
+    return 0;
+#endif
+}
+
+/**
+ * Generate a key of the algorithm.
+ *
+ * @param [in] libCtx  Library context to use.
+ * @param [in] alg     Algorithm to generate key for.
+ * @return  Key on success.
+ * @return  NULL on failure.
+ */
+static EVP_PKEY* bench_keygen(OSSL_LIB_CTX* libCtx, const BENCH_ALG* alg)
+{
+    EVP_PKEY* pkey = NULL;
+    EVP_PKEY_CTX* ctx;
+    OSSL_PARAM params[2];
+    size_t bits = 0;
+
+    params[0] = OSSL_PARAM_construct_end();
+    if (alg->param != NULL) {
+        if (strcmp(alg->alg, "RSA") == 0) {
+            bits = (size_t)atoi(alg->param);
+            params[0] = OSSL_PARAM_construct_size_t(OSSL_PKEY_PARAM_RSA_BITS,
+                &bits);
+        }
+        else {
+            params[0] = OSSL_PARAM_construct_utf8_string(
+                OSSL_PKEY_PARAM_GROUP_NAME, (char*)alg->param, 0);
+        }
+    }
+    params[1] = OSSL_PARAM_construct_end();
+
+    ctx = EVP_PKEY_CTX_new_from_name(libCtx, alg->alg, NULL);
+    if ((ctx != NULL) && ((EVP_PKEY_keygen_init(ctx) != 1) ||
+            (EVP_PKEY_CTX_set_params(ctx, params) != 1) ||
+            (EVP_PKEY_keygen(ctx, &pkey) != 1))) {
+        EVP_PKEY_free(pkey);
+        pkey = NULL;
+    }
+    EVP_PKEY_CTX_free(ctx);
+
+    return pkey;
+}
+
+/**
+ * Set up the objects needed to perform the operation.
+ *
+ * @param [in, out] st  Benchmark state with algorithm, library context and
+ *                      size set.
+ * @return  0 on success.
+ * @return  1 on failure.
+ */
+static int bench_setup(BENCH_STATE* st)
+{
+    int err = 0;
+    const BENCH_ALG* alg = st->alg;
+    size_t i;
+
+    /* Distinct bytes as XTS rejects identical key halves. */
+    for (i = 0; i < sizeof(st->key); i++) {
+        st->key[i] = (unsigned char)(i + 1);
+        st->iv[i] = (unsigned char)(0x80 + i);
+    }
+    st->bufLen = st->size + 2 * BENCH_KEY_LEN;
+    if (st->bufLen < BENCH_MIN_BUF_LEN) {
+        st->bufLen = BENCH_MIN_BUF_LEN;
+    }
+    st->in = (unsigned char*)malloc(st->bufLen);
+    st->out = (unsigned char*)malloc(st->bufLen);
+    if ((st->in == NULL) || (st->out == NULL)) {
+        err = 1;
+    }
+    else {
+        memset(st->in, 0x33, st->bufLen);
+    }
+
+    if ((err == 0) && (alg->kind == BENCH_CIPHER)) {
+        st->cipher = EVP_CIPHER_fetch(st->libCtx, alg->alg, NULL);
+        st->cipherCtx = EVP_CIPHER_CTX_new();
+        err = (st->cipher == NULL) || (st->cipherCtx == NULL);
+        if ((err == 0) && (EVP_EncryptInit_ex2(st->cipherCtx, st->cipher,
+                st->key, st->iv, NULL) != 1)) {
+            err = 1;
+        }
+        if (err == 0) {
+            EVP_CIPHER_CTX_set_padding(st->cipherCtx, 0);
+        }
+    }
+    else if ((err == 0) && (alg->kind == BENCH_DIGEST)) {
+        st->md = EVP_MD_fetch(st->libCtx, alg->alg, NULL);
+        st->mdCtx = EVP_MD_CTX_new();
+        err = (st->md == NULL) || (st->mdCtx == NULL);
+    }
+    else if ((err == 0) && (alg->kind == BENCH_MAC)) {
+        st->mac = EVP_MAC_fetch(st->libCtx, alg->alg, NULL);
+        err = st->mac == NULL;
+        if (err == 0) {
+            st->macCtx = EVP_MAC_CTX_new(st->mac);
+            err = st->macCtx == NULL;
+        }
+        if (err == 0) {
+            const char* key = OSSL_MAC_PARAM_DIGEST;
+            int i = 0;
+
+            if (strcmp(alg->alg, "HMAC") != 0) {
+                key = OSSL_MAC_PARAM_CIPHER;
+            }
+            st->params[i++] = OSSL_PARAM_construct_utf8_string(key,
+                (char*)alg->param, 0);
+            if (strcmp(alg->alg, "GMAC") == 0) {
+                st->ivParams[0] = OSSL_PARAM_construct_octet_string(
+                    OSSL_MAC_PARAM_IV, st->iv, 12);
+                st->ivParams[1] = OSSL_PARAM_construct_end();
+                st->params[i++] = st->ivParams[0];
+                st->reinit = st->ivParams;
+            }
+            st->params[i] = OSSL_PARAM_construct_end();
+            st->outLen = EVP_MAX_MD_SIZE;
+            if (EVP_MAC_init(st->macCtx, st->key, 16, st->params) != 1) {
+                err = 1;
+            }
+        }
+    }
+    else if ((err == 0) && (alg->kind == BENCH_KDF)) {
+        st->kdf = EVP_KDF_fetch(st->libCtx, alg->alg, NULL);
+        err = st->kdf == NULL;
+        if (err == 0) {
+            st->kdfCtx = EVP_KDF_CTX_new(st->kdf);
+            err = st->kdfCtx == NULL;
+        }
+        if (err == 0) {
+            int i = 0;
+
+            st->params[i++] = OSSL_PARAM_construct_utf8_string(
+                OSSL_KDF_PARAM_DIGEST, (char*)alg->param, 0);
+            if (strcmp(alg->alg, "PBKDF2") == 0) {
+                st->iter = 1000;
+                st->params[i++] = OSSL_PARAM_construct_octet_string(
+                    OSSL_KDF_PARAM_PASSWORD, st->key, 16);
+                st->params[i++] = OSSL_PARAM_construct_octet_string(
+                    OSSL_KDF_PARAM_SALT, st->iv, 16);
+                st->params[i++] = OSSL_PARAM_construct_uint(
+                    OSSL_KDF_PARAM_ITER, &st->iter);
+            }
+            else if (strcmp(alg->alg, "TLS1-PRF") == 0) {
+                st->params[i++] = OSSL_PARAM_construct_octet_string(
+                    OSSL_KDF_PARAM_SECRET, st->key, 48);
+                st->params[i++] = OSSL_PARAM_construct_octet_string(
+                    OSSL_KDF_PARAM_SEED, st->iv, 64);
+            }
+            else {
+                st->params[i++] = OSSL_PARAM_construct_octet_string(
+                    OSSL_KDF_PARAM_KEY, st->key, 32);
+                st->params[i++] = OSSL_PARAM_construct_octet_string(
+                    OSSL_KDF_PARAM_SALT, st->iv, 32);
+            }
+            st->params[i] = OSSL_PARAM_construct_end();
+            if (EVP_KDF_CTX_set_params(st->kdfCtx, st->params) != 1) {
+                err = 1;
+            }
+        }
+    }
+    else if ((err == 0) && (alg->kind == BENCH_SIGN)) {
+        st->pkey = bench_keygen(st->libCtx, alg);
+        st->mdCtx = EVP_MD_CTX_new();
+        err = (st->pkey == NULL) || (st->mdCtx == NULL);
+    }
+    else if ((err == 0) && (alg->kind == BENCH_KEYEXCH)) {
+        st->pkey = bench_keygen(st->libCtx, alg);
+        st->peer = bench_keygen(st->libCtx, alg);
+        err = (st->pkey == NULL) || (st->peer == NULL);
+    }
+
+    return err;
+}
+
+/**
+ * Perform one operation of the algorithm.
+ *
+ * Ciphers, digests and MACs process size bytes. KDFs derive BENCH_KEY_LEN
+ * bytes. Signature algorithms sign size bytes of data. Key exchange
+ * algorithms derive a shared secret.
+ *
+ * @param [in, out] st  Benchmark state.
+ * @return  0 on success.
+ * @return  1 on failure.
+ */
+static int bench_op(BENCH_STATE* st)
+{
+    int err = 0;
+    int len = 0;
+    size_t sLen = 0;
+    unsigned int uLen = 0;
+
+    switch (st->alg->kind) {
+        case BENCH_CIPHER:
+            err = (EVP_EncryptInit_ex2(st->cipherCtx, NULL, NULL, st->iv,
+                      NULL) != 1) ||
+                  (EVP_EncryptUpdate(st->cipherCtx, st->out, &len, st->in,
+                      (int)st->size) != 1) ||
+                  (EVP_EncryptFinal_ex(st->cipherCtx, st->out + len,
+                      &len) != 1);
+            break;
+        case BENCH_DIGEST:
+            err = (EVP_DigestInit_ex2(st->mdCtx, st->md, NULL) != 1) ||
+                  (EVP_DigestUpdate(st->mdCtx, st->in, st->size) != 1) ||
+                  (EVP_DigestFinal_ex(st->mdCtx, st->out, &uLen) != 1);
+            break;
+        case BENCH_MAC:
+            err = (EVP_MAC_init(st->macCtx, NULL, 0, st->reinit) != 1) ||
+                  (EVP_MAC_update(st->macCtx, st->in, st->size) != 1) ||
+                  (EVP_MAC_final(st->macCtx, st->out, &sLen,
+                      st->outLen) != 1);
+            break;
+        case BENCH_KDF:
+            err = EVP_KDF_derive(st->kdfCtx, st->out, BENCH_KEY_LEN,
+                NULL) != 1;
+            break;
+        case BENCH_SIGN:
+        {
+            const char* mdName = "SHA256";
+            EVP_PKEY_CTX* pctx = NULL;
+
+            if (strncmp(st->alg->alg, "ED", 2) == 0) {
+                mdName = NULL;
+            }
+            sLen = st->bufLen;
+            err = (EVP_DigestSignInit_ex(st->mdCtx, &pctx, mdName,
+                      st->libCtx, NULL, st->pkey, NULL) != 1) ||
+                  (EVP_DigestSign(st->mdCtx, st->out, &sLen, st->in,
+                      st->size) != 1);
+            break;
+        }
+        case BENCH_KEYEXCH:
+        {
+            EVP_PKEY_CTX* pctx;
+
+            pctx = EVP_PKEY_CTX_new_from_pkey(st->libCtx, st->pkey, NULL);
+            sLen = st->bufLen;
+            err = (pctx == NULL) || (EVP_PKEY_derive_init(pctx) != 1) ||
+                  (EVP_PKEY_derive_set_peer(pctx, st->peer) != 1) ||
+                  (EVP_PKEY_derive(pctx, NULL, &sLen) != 1) ||
+                  (EVP_PKEY_derive(pctx, st->out, &sLen) != 1);
+            EVP_PKEY_CTX_free(pctx);
+            break;
+        }
+        default:
+            err = 1;
+            break;
+    }
+
+    return err;
+}
+
+/**
+ * Dispose of the objects of the benchmark.
+ *
+ * @param [in, out] st  Benchmark state.
+ */
+static void bench_cleanup(BENCH_STATE* st)
+{
+    EVP_PKEY_free(st->peer);
+    EVP_PKEY_free(st->pkey);
+    EVP_KDF_CTX_free(st->kdfCtx);
+    EVP_KDF_free(st->kdf);
+    EVP_MAC_CTX_free(st->macCtx);
+    EVP_MAC_free(st->mac);
+    EVP_MD_CTX_free(st->mdCtx);
+    EVP_MD_free(st->md);
+    EVP_CIPHER_CTX_free(st->cipherCtx);
+    EVP_CIPHER_free(st->cipher);
+    free(st->out);
+    free(st->in);
+}
+
+/**
+ * Load a provider into a new library context.
+ *
+ * @param [in]  opts     Options of run.
+ * @param [in]  name     Name of provider to load.
+ * @param [out] provOut  Provider loaded.
+ * @return  Library context on success.
+ * @return  NULL on failure.
+ */
+static OSSL_LIB_CTX* bench_libctx_new(const BENCH_OPTS* opts, const char* name,
+    OSSL_PROVIDER** provOut)
+{
+    OSSL_LIB_CTX* libCtx;
+    OSSL_PROVIDER* prov = NULL;
+
+    libCtx = OSSL_LIB_CTX_new();
+    if (libCtx != NULL) {
+        if (strcmp(name, "default") != 0) {
+            OSSL_PROVIDER_set_default_search_path(libCtx, opts->dir);
+        }
+        prov = OSSL_PROVIDER_load(libCtx, name);
+        if (prov == NULL) {
+            OSSL_LIB_CTX_free(libCtx);
+            libCtx = NULL;
+        }
+    }
+    *provOut = prov;
+
+    return libCtx;
+}
+
+/**
+ * Run the benchmark on one thread.
+ *
+ * @param [in, out] arg  Benchmark thread.
+ * @return  NULL always.
+ */
+static void* bench_thread(void* arg)
+{
+    BENCH_THREAD* t = (BENCH_THREAD*)arg;
+    BENCH_STATE st;
+    OSSL_PROVIDER* prov = NULL;
+    double start = 0;
+    double now = 0;
+    unsigned long long cycles = 0;
+    int i;
+
+    memset(&st, 0, sizeof(st));
+    st.alg = t->alg;
+    st.size = t->size;
+    st.libCtx = t->libCtx;
+    if (t->opts->isolate) {
+        st.libCtx = bench_libctx_new(t->opts, t->provName, &prov);
+    }
+    t->err = st.libCtx == NULL;
+    if (t->err == 0) {
+        t->err = bench_setup(&st);
+    }
+    if (t->err == 0) {
+        /* Warm up caches and lazily created objects. */
+        t->err = bench_op(&st);
+    }
+    if (t->err == 0) {
+        start = bench_time();
+        cycles = bench_cycles();
+        do {
+            for (i = 0; (t->err == 0) && (i < BENCH_BATCH); i++) {
+                t->err = bench_op(&st);
+            }
+            t->ops += i;
+            now = bench_time();
+        }
+        while ((t->err == 0) && (now - start < t->opts->secs));
+        t->cycles = bench_cycles() - cycles;
+        t->elapsed = now - start;
+    }
+
+    bench_cleanup(&st);
+    if (t->opts->isolate) {
+        OSSL_PROVIDER_unload(prov);
+        OSSL_LIB_CTX_free(st.libCtx);
+    }
+
+    return NULL;
+}
+
+/**
+ * Benchmark an algorithm with one provider at one size.
+ *
+ * @param [in]  opts      Options of run.
+ * @param [in]  alg       Algorithm to benchmark.
+ * @param [in]  libCtx    Library context with provider loaded.
+ * @param [in]  provName  Name of provider in library context.
+ * @param [in]  size      Size of data in bytes.
+ * @param [out] res       Result of benchmark.
+ */
+static void bench_run(const BENCH_OPTS* opts, const BENCH_ALG* alg,
+    OSSL_LIB_CTX* libCtx, const char* provName, size_t size,
+    BENCH_RESULT* res)
+{
+    BENCH_THREAD t[BENCH_MAX_THREADS];
+    unsigned long long cycles = 0;
+    double ops = 0;
+    int i;
+
+    memset(t, 0, sizeof(t));
+    memset(res, 0, sizeof(*res));
+    for (i = 0; i < opts->threads; i++) {
+        t[i].opts = opts;
+        t[i].alg = alg;
+        t[i].libCtx = libCtx;
+        t[i].provName = provName;
+        t[i].size = size;
+    }
+    if (opts->threads == 1) {
+        (void)bench_thread(&t[0]);
+    }
+    else {
+        for (i = 0; i < opts->threads; i++) {
+            if (pthread_create(&t[i].thread, NULL, bench_thread, &t[i]) != 0) {
+                t[i].err = 1;
+            }
+            else {
+                t[i].started = 1;
+            }
+        }
+        for (i = 0; i < opts->threads; i++) {
+            if (t[i].started) {
+                pthread_join(t[i].thread, NULL);
+            }
+        }
+    }
+
+    for (i = 0; i < opts->threads; i++) {
+        if (t[i].err || (t[i].elapsed <= 0)) {
+            res->err = 1;
+        }
+        else {
+            res->opsPerSec += t[i].ops / t[i].elapsed;
+            ops += t[i].ops;
+            cycles += t[i].cycles;
+        }
+    }
+    if ((res->err == 0) && (ops > 0)) {
+        res->cyclesPerOp = cycles / ops;
+        if ((size > 0) && (alg->kind != BENCH_KDF) &&
+                (alg->kind != BENCH_SIGN) && (alg->kind != BENCH_KEYEXCH)) {
+            res->cyclesPerByte = res->cyclesPerOp / size;
+        }
+    }
+}
+
+/**
+ * Print the result of a benchmark.
+ *
+ * @param [in] alg   Algorithm benchmarked.
+ * @param [in] prov  Name of provider displayed.
+ * @param [in] size  Size of data in bytes. 0 when not relevant.
+ * @param [in] res   Result of benchmark.
+ */
+static void bench_print(const BENCH_ALG* alg, const char* prov, size_t size,
+    const BENCH_RESULT* res)
+{
+    printf("%-20s %-8s %7lu ", alg->name, prov, (unsigned long)size);
+    if (res->err) {
+        printf("%14s\n", "not available");
+    }
+    else {
+        printf("%14.1f ", res->opsPerSec);
+        if (res->cyclesPerByte > 0) {
+            printf("%10.2f %10.2f\n",
+                res->opsPerSec * size / (1024.0 * 1024.0),
+                res->cyclesPerByte);
+        }
+        else if (res->cyclesPerOp > 0) {
+            printf("%10s %10s %12.0f\n", "-", "-", res->cyclesPerOp);
+        }
+        else {
+            printf("%10s %10s\n", "-", "-");
+        }
+    }
+}
+
+/* Number of TLS records encrypted in a handshake-shaped operation. */
+#define BENCH_HS_RECORDS    4
+/* Size of TLS records encrypted in a handshake-shaped operation. */
+#define BENCH_HS_RECORD_LEN 1024
+/* Number of HKDF derivations in a handshake-shaped operation. */
+#define BENCH_HS_KDFS       6
+
+/* Objects shared by all threads of the scaling benchmark. */
+typedef struct BENCH_HS_SHARED {
+    /* Library context with provider loaded. */
+    OSSL_LIB_CTX* libCtx;
+    /* Key to sign with. */
+    EVP_PKEY* sigKey;
+    /* Peer's ephemeral key. */
+    EVP_PKEY* peer;
+} BENCH_HS_SHARED;
+
+/* Work and results of one scaling benchmark thread. */
+typedef struct BENCH_HS_THREAD {
+    pthread_t thread;
+    int started;
+    const BENCH_OPTS* opts;
+    const BENCH_HS_SHARED* shared;
+    unsigned long ops;
+    double elapsed;
+    int err;
+} BENCH_HS_THREAD;
+
+/* Key exchange of handshake-shaped operation. */
+static const BENCH_ALG bench_hs_kex =
+    { "ECDHE-P256", BENCH_KEYEXCH, "EC", "P-256" };
+/* Signature algorithms of handshake-shaped operation. */
+static const BENCH_ALG bench_hs_rsa =
+    { "RSA-2048", BENCH_SIGN, "RSA", "2048" };
+static const BENCH_ALG bench_hs_ecdsa =
+    { "ECDSA-P256", BENCH_SIGN, "EC", "P-256" };
+
+/**
+ * Perform the cryptographic operations of a server's TLS handshake.
+ *
+ * Generates an ephemeral key, derives the shared secret with the peer, signs
+ * with the shared key, runs the key schedule with HKDF and encrypts a few
+ * records with AES-GCM.
+ *
+ * @param [in] shared  Objects shared by all threads.
+ * @param [in] md      SHA-256 digest.
+ * @param [in] kdf     HKDF algorithm.
+ * @param [in] cipher  AES-128-GCM cipher.
+ * @return  0 on success.
+ * @return  1 on failure.
+ */
+static int bench_hs_op(const BENCH_HS_SHARED* shared, EVP_MD* md, EVP_KDF* kdf,
+    EVP_CIPHER* cipher)
+{
+    int err = 0;
+    EVP_PKEY* eph = NULL;
+    EVP_PKEY_CTX* pctx = NULL;
+    EVP_MD_CTX* mdCtx = NULL;
+    EVP_KDF_CTX* kdfCtx = NULL;
+    EVP_CIPHER_CTX* cipherCtx = NULL;
+    OSSL_PARAM params[4];
+    unsigned char secret[64];
+    size_t secretLen = sizeof(secret);
+    unsigned char key[32];
+    unsigned char sig[512];
+    size_t sigLen = sizeof(sig);
+    unsigned char rec[BENCH_HS_RECORD_LEN + 16];
+    int len;
+    int i;
+
+    memset(rec, 0x5a, sizeof(rec));
+
+    /* Ephemeral key generation and key exchange. */
+    eph = bench_keygen(shared->libCtx, &bench_hs_kex);
+    err = eph == NULL;
+    if (err == 0) {
+        pctx = EVP_PKEY_CTX_new_from_pkey(shared->libCtx, eph, NULL);
+        err = (pctx == NULL) || (EVP_PKEY_derive_init(pctx) != 1) ||
+              (EVP_PKEY_derive_set_peer(pctx, shared->peer) != 1) ||
+              (EVP_PKEY_derive(pctx, secret, &secretLen) != 1);
+    }
+
+    /* Signature over the handshake transcript. */
+    if (err == 0) {
+        mdCtx = EVP_MD_CTX_new();
+        err = (mdCtx == NULL) ||
+              (EVP_DigestSignInit_ex(mdCtx, NULL, "SHA256", shared->libCtx,
+                  NULL, shared->sigKey, NULL) != 1) ||
+              (EVP_DigestSign(mdCtx, sig, &sigLen, rec, 256) != 1);
+    }
+
+    /* Key schedule. */
+    if (err == 0) {
+        kdfCtx = EVP_KDF_CTX_new(kdf);
+        err = kdfCtx == NULL;
+    }
+    for (i = 0; (err == 0) && (i < BENCH_HS_KDFS); i++) {
+        params[0] = OSSL_PARAM_construct_utf8_string(OSSL_KDF_PARAM_DIGEST,
+            (char*)EVP_MD_get0_name(md), 0);
+        params[1] = OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_KEY,
+            secret, secretLen);
+        params[2] = OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_INFO,
+            rec, 32);
+        params[3] = OSSL_PARAM_construct_end();
+        err = EVP_KDF_derive(kdfCtx, key, sizeof(key), params) != 1;
+    }
+
+    /* Application data records. */
+    if (err == 0) {
+        cipherCtx = EVP_CIPHER_CTX_new();
+        err = (cipherCtx == NULL) || (EVP_EncryptInit_ex2(cipherCtx, cipher,
+            key, secret, NULL) != 1);
+    }
+    for (i = 0; (err == 0) && (i < BENCH_HS_RECORDS); i++) {
+        err = (EVP_EncryptInit_ex2(cipherCtx, NULL, NULL, secret + i,
+                  NULL) != 1) ||
+              (EVP_EncryptUpdate(cipherCtx, rec, &len, rec,
+                  BENCH_HS_RECORD_LEN) != 1) ||
+              (EVP_EncryptFinal_ex(cipherCtx, rec + len, &len) != 1);
+    }
+
+    EVP_CIPHER_CTX_free(cipherCtx);
+    EVP_KDF_CTX_free(kdfCtx);
+    EVP_MD_CTX_free(mdCtx);
+    EVP_PKEY_CTX_free(pctx);
+    EVP_PKEY_free(eph);
+
+    return err;
+}
+
+/**
+ * Run handshake-shaped operations on one thread.
+ *
+ * @param [in, out] arg  Scaling benchmark thread.
+ * @return  NULL always.
+ */
+static void* bench_hs_thread(void* arg)
+{
+    BENCH_HS_THREAD* t = (BENCH_HS_THREAD*)arg;
+    OSSL_LIB_CTX* libCtx = t->shared->libCtx;
+    EVP_MD* md;
+    EVP_KDF* kdf;
+    EVP_CIPHER* cipher;
+    double start;
+    double now;
+
+    md = EVP_MD_fetch(libCtx, "SHA256", NULL);
+    kdf = EVP_KDF_fetch(libCtx, "HKDF", NULL);
+    cipher = EVP_CIPHER_fetch(libCtx, "AES-128-GCM", NULL);
+    t->err = (md == NULL) || (kdf == NULL) || (cipher == NULL);
+    if (t->err == 0) {
+        t->err = bench_hs_op(t->shared, md, kdf, cipher);
+    }
+    if (t->err == 0) {
+        start = bench_time();
+        do {
+            t->err = bench_hs_op(t->shared, md, kdf, cipher);
+            t->ops++;
+            now = bench_time();
+        }
+        while ((t->err == 0) && (now - start < t->opts->secs));
+        t->elapsed = now - start;
+    }
+
+    EVP_CIPHER_free(cipher);
+    EVP_KDF_free(kdf);
+    EVP_MD_free(md);
+
+    return NULL;
+}
+
+/**
+ * Run handshake-shaped operations with increasing numbers of threads.
+ *
+ * All threads use the same library context, signing key and peer key so that
+ * contention on shared objects shows up as poor scaling. Thread counts double
+ * from 1 up to the number of threads in the options.
+ *
+ * @param [in] opts    Options of run.
+ * @param [in] libCtx  Library context with provider loaded.
+ * @param [in] prov    Name of provider displayed.
+ * @return  0 on success.
+ * @return  1 on failure.
+ */
+static int bench_scaling(const BENCH_OPTS* opts, OSSL_LIB_CTX* libCtx,
+    const char* prov)
+{
+    int err = 0;
+    BENCH_HS_SHARED shared;
+    BENCH_HS_THREAD t[BENCH_MAX_THREADS];
+    double single = 0;
+    int threads;
+    int i;
+
+    shared.libCtx = libCtx;
+    shared.sigKey = bench_keygen(libCtx,
+        opts->ecdsa ? &bench_hs_ecdsa : &bench_hs_rsa);
+    shared.peer = bench_keygen(libCtx, &bench_hs_kex);
+    if ((shared.sigKey == NULL) || (shared.peer == NULL)) {
+        printf("%-8s failed to generate keys\n", prov);
+        err = 1;
+    }
+
+    threads = 1;
+    while ((err == 0) && (threads <= opts->threads)) {
+        double total = 0;
+
+        memset(t, 0, sizeof(t));
+        for (i = 0; i < threads; i++) {
+            t[i].opts = opts;
+            t[i].shared = &shared;
+            if (pthread_create(&t[i].thread, NULL, bench_hs_thread,
+                    &t[i]) == 0) {
+                t[i].started = 1;
+            }
+            else {
+                t[i].err = 1;
+            }
+        }
+        for (i = 0; i < threads; i++) {
+            if (t[i].started) {
+                pthread_join(t[i].thread, NULL);
+            }
+            if (t[i].err || (t[i].elapsed <= 0)) {
+                err = 1;
+            }
+            else {
+                total += t[i].ops / t[i].elapsed;
+            }
+        }
+        if (err) {
+            printf("%-8s %7d %14s\n", prov, threads, "failed");
+        }
+        else {
+            if (threads == 1) {
+                single = total;
+            }
+            printf("%-8s %7d %14.1f %14.1f %9.1f%%\n", prov, threads, total,
+                total / threads, 100.0 * total / (single * threads));
+        }
+
+        /* Double threads each time but always finish with maximum. */
+        if (threads == opts->threads) {
+            break;
+        }
+        threads *= 2;
+        if (threads > opts->threads) {
+            threads = opts->threads;
+        }
+    }
+
+    EVP_PKEY_free(shared.peer);
+    EVP_PKEY_free(shared.sigKey);
+
+    return err;
+}
+
+/**
+ * Print usage of benchmark program.
+ */
+static void usage(void)
+{
+    printf("\n");
+    printf("Usage: wp_bench [options]\n");
+    printf("  --help            Show this usage information.\n");
+    printf("  --dir <path>      Location of wolfprovider shared library.\n");
+    printf("                    Default: .libs\n");
+    printf("  --provider <str>  Name of wolfssl provider. "
+                               "Default: libwolfprov\n");
+    printf("  --secs <num>      Seconds to run each benchmark. Default: 1\n");
+    printf("  --sizes <list>    Comma separated data sizes in bytes.\n");
+    printf("                    Default: 16,256,1024,8192,16384\n");
+    printf("  --threads <num>   Number of threads. Default: 1\n");
+    printf("  --isolate         Each thread uses its own library context.\n");
+    printf("  --compare         Also benchmark OpenSSL's default provider.\n");
+    printf("  --scaling         Run handshake-shaped operations (ECDHE,\n");
+    printf("                    sign, HKDF, AES-GCM) on 1 up to --threads\n");
+    printf("                    threads sharing keys and library context.\n");
+    printf("  --ecdsa           Sign with ECDSA P-256 in --scaling instead\n");
+    printf("                    of RSA-2048.\n");
+    printf("  --list            Display all algorithms.\n");
+    printf("  <name>            Only benchmark algorithms containing name.\n");
+    printf("\n");
+    printf("Columns: ops/sec, MB/sec and cycles/byte for data algorithms;\n");
+    printf("ops/sec and cycles/op for KDF, signing and key exchange.\n");
+}
+
+/**
+ * Parse comma separated list of sizes.
+ *
+ * @param [in, out] opts  Options of run.
+ * @param [in]      str   Comma separated list of sizes.
+ * @return  0 on success.
+ * @return  1 on failure.
+ */
+static int bench_parse_sizes(BENCH_OPTS* opts, const char* str)
+{
+    int err = 0;
+    char* end = NULL;
+
+    opts->sizeCnt = 0;
+    while ((err == 0) && (*str != '\0')) {
+        long n = strtol(str, &end, 10);
+
+        if ((end == str) || (n <= 0) || (n > 0x7fffffff) ||
+                (opts->sizeCnt == BENCH_MAX_SIZES)) {
+            err = 1;
+        }
+        else {
+            opts->sizes[opts->sizeCnt++] = (size_t)n;
+            str = end;
+            if (*str == ',') {
+                str++;
+            }
+        }
+    }
+    if (opts->sizeCnt == 0) {
+        err = 1;
+    }
+
+    return err;
+}
+
+int main(int argc, char* argv[])
+{
+    int err = 0;
+    int run = 1;
+    BENCH_OPTS opts;
+    OSSL_LIB_CTX* wpLibCtx = NULL;
+    OSSL_LIB_CTX* osslLibCtx = NULL;
+    OSSL_PROVIDER* wpProv = NULL;
+    OSSL_PROVIDER* osslProv = NULL;
+    BENCH_RESULT res;
+    int i;
+    int j;
+
+    memset(&opts, 0, sizeof(opts));
+    opts.dir = ".libs";
+    opts.name = wolfprovider_id;
+    opts.secs = 1;
+    opts.threads = 1;
+    (void)bench_parse_sizes(&opts, "16,256,1024,8192,16384");
+
+    for (--argc, ++argv; (err == 0) && (argc > 0); argc--, argv++) {
+        if (strcmp(*argv, "--help") == 0) {
+            usage();
+            run = 0;
+        }
+        else if ((strcmp(*argv, "--dir") == 0) && (argc > 1)) {
+            opts.dir = *(++argv);
+            argc--;
+        }
+        else if ((strcmp(*argv, "--provider") == 0) && (argc > 1)) {
+            opts.name = *(++argv);
+            argc--;
+        }
+        else if ((strcmp(*argv, "--secs") == 0) && (argc > 1)) {
+            opts.secs = atof(*(++argv));
+            argc--;
+            err = opts.secs <= 0;
+        }
+        else if ((strcmp(*argv, "--sizes") == 0) && (argc > 1)) {
+            err = bench_parse_sizes(&opts, *(++argv));
+            argc--;
+        }
+        else if ((strcmp(*argv, "--threads") == 0) && (argc > 1)) {
+            opts.threads = atoi(*(++argv));
+            argc--;
+            err = (opts.threads <= 0) || (opts.threads > BENCH_MAX_THREADS);
+        }
+        else if (strcmp(*argv, "--isolate") == 0) {
+            opts.isolate = 1;
+        }
+        else if (strcmp(*argv, "--compare") == 0) {
+            opts.compare = 1;
+        }
+        else if (strcmp(*argv, "--scaling") == 0) {
+            opts.scaling = 1;
+        }
+        else if (strcmp(*argv, "--ecdsa") == 0) {
+            opts.ecdsa = 1;
+        }
+        else if (strcmp(*argv, "--list") == 0) {
+            for (i = 0; i < BENCH_ALG_CNT; i++) {
+                printf("%s\n", bench_algs[i].name);
+            }
+            run = 0;
+        }
+        else if (**argv != '-') {
+            opts.filter = *argv;
+        }
+        else {
+            err = 1;
+        }
+        if (err) {
+            printf("Invalid option: %s\n", *argv);
+            usage();
+        }
+    }
+
+    if ((err == 0) && run) {
+        wpLibCtx = bench_libctx_new(&opts, opts.name, &wpProv);
+        if (wpLibCtx == NULL) {
+            printf("Failed to load provider: %s\n", opts.name);
+            err = 1;
+        }
+    }
+    if ((err == 0) && run && opts.compare) {
+        osslLibCtx = bench_libctx_new(&opts, "default", &osslProv);
+        if (osslLibCtx == NULL) {
+            printf("Failed to load default provider\n");
+            err = 1;
+        }
+    }
+
+    if ((err == 0) && run && opts.scaling) {
+        printf("Handshake-shaped operations, %s signing, seconds: %.2f\n",
+            opts.ecdsa ? "ECDSA P-256" : "RSA-2048", opts.secs);
+        printf("%-8s %7s %14s %14s %10s\n", "Provider", "Threads", "ops/sec",
+            "ops/sec/thr", "scaling");
+        err = bench_scaling(&opts, wpLibCtx, "wolfprov");
+        if ((err == 0) && opts.compare) {
+            err = bench_scaling(&opts, osslLibCtx, "default");
+        }
+    }
+    else if ((err == 0) && run) {
+        printf("Threads: %d%s, seconds: %.2f\n", opts.threads,
+            opts.isolate ? " (isolated library contexts)" : "", opts.secs);
+        printf("%-20s %-8s %7s %14s %10s %10s %12s\n", "Algorithm",
+            "Provider", "Size", "ops/sec", "MB/sec", "cycles/B", "cycles/op");
+        for (i = 0; i < BENCH_ALG_CNT; i++) {
+            const BENCH_ALG* alg = &bench_algs[i];
+            int sizeCnt = opts.sizeCnt;
+
+            if ((opts.filter != NULL) && (strstr(alg->name,
+                    opts.filter) == NULL)) {
+                continue;
+            }
+            if ((alg->kind == BENCH_KDF) || (alg->kind == BENCH_KEYEXCH)) {
+                /* Size of data not relevant. */
+                sizeCnt = 1;
+            }
+            for (j = 0; j < sizeCnt; j++) {
+                size_t size = opts.sizes[j];
+
+                if ((alg->kind == BENCH_KDF) ||
+                        (alg->kind == BENCH_KEYEXCH)) {
+                    size = 0;
+                }
+                bench_run(&opts, alg, wpLibCtx, opts.name, size, &res);
+                bench_print(alg, "wolfprov", size, &res);
+                if (opts.compare) {
+                    bench_run(&opts, alg, osslLibCtx, "default", size, &res);
+                    bench_print(alg, "default", size, &res);
+                }
+            }
+        }
+    }
+
+    OSSL_PROVIDER_unload(osslProv);
+    OSSL_LIB_CTX_free(osslLibCtx);
+    OSSL_PROVIDER_unload(wpProv);
+    OSSL_LIB_CTX_free(wpLibCtx);
+
+    return err;
+}
@@ -40,6 +40,7 @@
 #include <wolfssl/wolfcrypt/ed448.h>
 #include <wolfssl/wolfcrypt/dh.h>
 #include <wolfssl/wolfcrypt/aes.h>
+#include <wolfssl/wolfcrypt/chacha20_poly1305.h>
 #include <wolfssl/wolfcrypt/sha256.h>
 #include <wolfssl/wolfcrypt/sha512.h>
 #include <wolfssl/wolfcrypt/sha3.h>
@@ -47,6 +48,11 @@
 #include <wolfssl/wolfcrypt/random.h>
 #include <wolfssl/wolfcrypt/pwdbased.h>
 #include <wolfssl/wolfcrypt/kdf.h>
+#if defined(WOLFSSL_HAVE_MLKEM)
+#include <wolfssl/wolfcrypt/mlkem.h>
+#elif defined(WOLFSSL_HAVE_KYBER)
+#include <wolfssl/wolfcrypt/kyber.h>
+#endif
 
 #include <wolfprovider/internal.h>
 #include <wolfprovider/wp_logging.h>
@@ -83,6 +89,7 @@ typedef void (*DFUNC)(void);
 #define WP_NAMES_SHA3_384      "SHA3-384:2.16.840.1.101.3.4.2.9"
 #define WP_NAMES_SHA3_512      "SHA3-512:2.16.840.1.101.3.4.2.10"
 
+#define WP_NAMES_SHAKE_128     "SHAKE-128:SHAKE128:2.16.840.1.101.3.4.2.11"
 #define WP_NAMES_SHAKE_256     "SHAKE-256:SHAKE256:2.16.840.1.101.3.4.2.12"
 
 /* Cipher names. */
@@ -99,6 +106,11 @@ typedef void (*DFUNC)(void);
 #define WP_NAMES_AES_192_CBC "AES-192-CBC:AES192:2.16.840.1.101.3.4.1.22"
 #define WP_NAMES_AES_128_CBC "AES-128-CBC:AES128:2.16.840.1.101.3.4.1.2"
 
+#define WP_NAMES_AES_256_CBC_HMAC_SHA1      "AES-256-CBC-HMAC-SHA1"
+#define WP_NAMES_AES_128_CBC_HMAC_SHA1      "AES-128-CBC-HMAC-SHA1"
+#define WP_NAMES_AES_256_CBC_HMAC_SHA256    "AES-256-CBC-HMAC-SHA256"
+#define WP_NAMES_AES_128_CBC_HMAC_SHA256    "AES-128-CBC-HMAC-SHA256"
+
 #define WP_NAMES_AES_256_ECB "AES-256-ECB:2.16.840.1.101.3.4.1.41"
 #define WP_NAMES_AES_192_ECB "AES-192-ECB:2.16.840.1.101.3.4.1.21"
 #define WP_NAMES_AES_128_ECB "AES-128-ECB:2.16.840.1.101.3.4.1.1"
@@ -107,6 +119,12 @@ typedef void (*DFUNC)(void);
 #define WP_NAMES_AES_192_CTR "AES-192-CTR"
 #define WP_NAMES_AES_128_CTR "AES-128-CTR"
 
+#define WP_NAMES_AES_256_XTS "AES-256-XTS:1.3.111.2.1619.0.1.2"
+#define WP_NAMES_AES_128_XTS "AES-128-XTS:1.3.111.2.1619.0.1.1"
+
+#define WP_NAMES_CHACHA20_POLY1305 \
+    "ChaCha20-Poly1305:1.2.840.113549.1.9.16.3.18"
+
 #define WP_NAMES_AES_256_WRAP   \
     "AES-256-WRAP:id-aes256-wrap:AES256-WRAP:2.16.840.1.101.3.4.1.45"
 #define WP_NAMES_AES_192_WRAP \
@@ -133,6 +151,7 @@ typedef void (*DFUNC)(void);
 #define WP_NAMES_PBKDF2         "PBKDF2:1.2.840.113549.1.5.12"
 #define WP_NAMES_PKCS12KDF      "PKCS12KDF"
 #define WP_NAMES_TLS1_3_KDF     "TLS13-KDF"
+#define WP_NAMES_TLS13_KEY_SCHEDULE "TLS13-KEY-SCHEDULE"
 #define WP_NAMES_TLS1_PRF       "TLS1-PRF"
 
 /* Signature names. */
@@ -150,6 +169,11 @@ typedef void (*DFUNC)(void);
 #define WP_NAMES_ED25519        "ED25519"
 #define WP_NAMES_ED448          "ED448"
 
+/* ML-KEM names. */
+#define WP_NAMES_MLKEM_768      "ML-KEM-768:MLKEM768:2.16.840.1.101.3.4.4.2"
+#define WP_NAMES_X25519MLKEM768 "X25519MLKEM768"
+#define WP_NAMES_SECP256R1MLKEM768 "SecP256r1MLKEM768"
+
 /* DH names. */
 #define WP_NAMES_DH             "DH"
 #define WP_NAMES_DHX            "DHX"
@@ -178,6 +202,8 @@ RsaKey* wp_rsa_get_key(wp_Rsa* rsa);
 void wp_rsa_get_pss_mds(wp_Rsa* rsa, char** mdName, char** mgfMdName);
 int wp_rsa_get_pss_salt_len(wp_Rsa* rsa);
 int wp_rsa_check_key_size(wp_Rsa* rsa, int allow1024);
+int wp_rsa_mp_init(void);
+void wp_rsa_mp_cleanup(void);
 
 /* Internal ECC types and functions. */
 typedef struct wp_Ecc wp_Ecc;
@@ -185,7 +211,10 @@ typedef struct wp_Ecc wp_Ecc;
 int wp_ecc_up_ref(wp_Ecc* ecc);
 void wp_ecc_free(wp_Ecc* ecc);
 ecc_key* wp_ecc_get_key(wp_Ecc* ecc);
+ecc_key* wp_ecc_acquire_key(wp_Ecc* ecc);
+void wp_ecc_release_key(wp_Ecc* ecc);
 WC_RNG* wp_ecc_get_rng(wp_Ecc* ecc);
+int wp_ecc_copy_priv(ecc_key* src, ecc_key* dst, int devId);
 int wp_ecc_get_size(wp_Ecc* ecc);
 
 /* Internal ECX types and functions. */
@@ -195,6 +224,21 @@ int wp_ecx_up_ref(wp_Ecx* ecx);
 void wp_ecx_free(wp_Ecx* ecx);
 void* wp_ecx_get_key(wp_Ecx* ecx);
 
+#if defined(WOLFSSL_HAVE_MLKEM) || defined(WOLFSSL_HAVE_KYBER)
+/* Internal ML-KEM types and functions. */
+typedef struct wp_MlKem wp_MlKem;
+
+int wp_mlkem_up_ref(wp_MlKem* mlkem);
+void wp_mlkem_free(wp_MlKem* mlkem);
+int wp_mlkem_has_pub(const wp_MlKem* mlkem);
+int wp_mlkem_has_priv(const wp_MlKem* mlkem);
+size_t wp_mlkem_get_ct_len(const wp_MlKem* mlkem);
+size_t wp_mlkem_get_ss_len(const wp_MlKem* mlkem);
+int wp_mlkem_encap(wp_MlKem* mlkem, unsigned char* ct, unsigned char* ss);
+int wp_mlkem_decap(wp_MlKem* mlkem, const unsigned char* ct, size_t ctLen,
+    unsigned char* ss);
+#endif
+
 /* Internal DH types and functions. */
 typedef struct wp_Dh wp_Dh;
 
@@ -209,12 +253,19 @@ int wp_dh_match(const wp_Dh* dh1, const wp_Dh* dh2, int selection);
 /* Internal MAC types and functions. */
 typedef struct wp_Mac wp_Mac;
 
+/** Size of name of digest or cipher a MAC context is keyed for. */
+#define WP_MAC_ALG_NAME_SIZE                                        \
+    ((WP_MAX_MD_NAME_SIZE > WP_MAX_CIPH_NAME_SIZE) ?                \
+     WP_MAX_MD_NAME_SIZE : WP_MAX_CIPH_NAME_SIZE)
+
 int wp_mac_up_ref(wp_Mac* mac);
 void wp_mac_free(wp_Mac* mac);
 int wp_mac_get_type(wp_Mac* mac);
 int wp_mac_get_private_key(wp_Mac* mac, unsigned char** priv, size_t* privLen);
 char* wp_mac_get_ciphername(wp_Mac* mac);
 char* wp_mac_get_properties(wp_Mac* mac);
+EVP_MAC_CTX* wp_mac_get_template(wp_Mac* mac, const char* alg);
+void wp_mac_set_template(wp_Mac* mac, EVP_MAC_CTX* macCtx, const char* alg);
 
 /* Internal KDF types and functions. */
 typedef struct wp_Kdf wp_Kdf;
@@ -239,6 +290,9 @@ extern const OSSL_DISPATCH wp_sha3_256_functions[];
 extern const OSSL_DISPATCH wp_sha3_384_functions[];
 extern const OSSL_DISPATCH wp_sha3_512_functions[];
 
+#ifdef WOLFSSL_SHAKE128
+extern const OSSL_DISPATCH wp_shake_128_functions[];
+#endif
 extern const OSSL_DISPATCH wp_shake_256_functions[];
 
 /* Cipher implementations. */
@@ -254,6 +308,17 @@ extern const OSSL_DISPATCH wp_aes256cbc_functions[];
 extern const OSSL_DISPATCH wp_aes192cbc_functions[];
 extern const OSSL_DISPATCH wp_aes128cbc_functions[];
 
+#if defined(HAVE_AES_CBC) && !defined(NO_HMAC)
+#ifndef NO_SHA
+extern const OSSL_DISPATCH wp_aes256cbchmacsha1_functions[];
+extern const OSSL_DISPATCH wp_aes128cbchmacsha1_functions[];
+#endif
+#ifndef NO_SHA256
+extern const OSSL_DISPATCH wp_aes256cbchmacsha256_functions[];
+extern const OSSL_DISPATCH wp_aes128cbchmacsha256_functions[];
+#endif
+#endif
+
 extern const OSSL_DISPATCH wp_aes256ecb_functions[];
 extern const OSSL_DISPATCH wp_aes192ecb_functions[];
 extern const OSSL_DISPATCH wp_aes128ecb_functions[];
@@ -262,6 +327,15 @@ extern const OSSL_DISPATCH wp_aes256ctr_functions[];
 extern const OSSL_DISPATCH wp_aes192ctr_functions[];
 extern const OSSL_DISPATCH wp_aes128ctr_functions[];
 
+#ifdef WOLFSSL_AES_XTS
+extern const OSSL_DISPATCH wp_aes256xts_functions[];
+extern const OSSL_DISPATCH wp_aes128xts_functions[];
+#endif
+
+#if defined(HAVE_CHACHA) && defined(HAVE_POLY1305)
+extern const OSSL_DISPATCH wp_chacha20_poly1305_functions[];
+#endif
+
 extern const OSSL_DISPATCH wp_aes256wrap_functions[];
 extern const OSSL_DISPATCH wp_aes192wrap_functions[];
 extern const OSSL_DISPATCH wp_aes128wrap_functions[];
@@ -276,6 +350,7 @@ extern const OSSL_DISPATCH wp_kdf_hkdf_functions[];
 extern const OSSL_DISPATCH wp_kdf_pbkdf2_functions[];
 extern const OSSL_DISPATCH wp_kdf_pkcs12_functions[];
 extern const OSSL_DISPATCH wp_kdf_tls1_3_kdf_functions[];
+extern const OSSL_DISPATCH wp_kdf_tls13_ks_functions[];
 extern const OSSL_DISPATCH wp_kdf_tls1_prf_functions[];
 
 /* Signature implementations. */
@@ -289,6 +364,11 @@ extern const OSSL_DISPATCH wp_cmac_signature_functions[];
 /* Asymmetric cipher implementations. */
 extern const OSSL_DISPATCH wp_rsa_asym_cipher_functions[];
 
+#if defined(WOLFSSL_HAVE_MLKEM) || defined(WOLFSSL_HAVE_KYBER)
+/* KEM implementations. */
+extern const OSSL_DISPATCH wp_mlkem_kem_functions[];
+#endif
+
 /* Key Management implemenations. */
 extern const OSSL_DISPATCH wp_rsa_keymgmt_functions[];
 extern const OSSL_DISPATCH wp_rsapss_keymgmt_functions[];
@@ -301,6 +381,11 @@ extern const OSSL_DISPATCH wp_dh_keymgmt_functions[];
 extern const OSSL_DISPATCH wp_hmac_keymgmt_functions[];
 extern const OSSL_DISPATCH wp_cmac_keymgmt_functions[];
 extern const OSSL_DISPATCH wp_kdf_keymgmt_functions[];
+#if defined(WOLFSSL_HAVE_MLKEM) || defined(WOLFSSL_HAVE_KYBER)
+extern const OSSL_DISPATCH wp_mlkem768_keymgmt_functions[];
+extern const OSSL_DISPATCH wp_x25519mlkem768_keymgmt_functions[];
+extern const OSSL_DISPATCH wp_p256mlkem768_keymgmt_functions[];
+#endif
 
 /* Key exchange implementations. */
 extern const OSSL_DISPATCH wp_ecdh_keyexch_functions[];
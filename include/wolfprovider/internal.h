@@ -20,6 +20,7 @@
 
 #include <openssl/core.h>
 #include <openssl/core_names.h>
+#include <openssl/core_dispatch.h>
 #include <openssl/types.h>
 
 #ifdef WOLFENGINE_USER_SETTINGS
@@ -33,6 +34,13 @@
 #include <wolfssl/wolfcrypt/wc_encrypt.h>
 #include <wolfssl/wolfcrypt/coding.h>
 #include <wolfssl/wolfcrypt/asn_public.h>
+#ifdef WOLFSSL_ASYNC_CRYPT
+    #include <wolfssl/wolfcrypt/async.h>
+#endif
+
+#ifndef WP_SINGLE_THREADED
+    #include <pthread.h>
+#endif
 
 #include "wp_params.h"
 
@@ -42,6 +50,9 @@
 /** Maximum value of a size_t. */
 #define MAX_SIZE_T    ((size_t)-1)
 
+/** Maximum size in bytes of a DRBG's output buffer. */
+#define WP_DRBG_MAX_BUF_SIZE    (1 << 16)
+
 /** Maximum supported digest name size. */
 #define WP_MAX_MD_NAME_SIZE     15
 /** Maximum supported cipher name size. */
@@ -114,6 +125,34 @@ enum {
 };
 
 
+#ifndef WP_PROV_RNG_RESEED_INTERVAL
+/** Number of uses of a per-thread provider RNG before it is re-instantiated
+ * with fresh entropy. */
+#define WP_PROV_RNG_RESEED_INTERVAL     (1 << 16)
+#endif
+
+#ifndef WP_SINGLE_THREADED
+/**
+ * Per-thread random number generator owned by a provider context.
+ */
+typedef struct wp_ThreadRng {
+    /** Random number generator. */
+    WC_RNG rng;
+    /** Number of uses since last instantiation. */
+    word32 useCnt;
+    /** NUMA node RNG was allocated on. */
+    int node;
+    /** Number of uses from a thread running on another NUMA node. */
+    word64 remoteCnt;
+    /** Provider context that owns this RNG. */
+    struct WOLFPROV_CTX* provCtx;
+    /** Next RNG in list of all thread RNGs of provider context. */
+    struct wp_ThreadRng* next;
+    /** Previous RNG in list of all thread RNGs of provider context. */
+    struct wp_ThreadRng* prev;
+} wp_ThreadRng;
+#endif
+
 /**
  * wolfSSL provider context.
  */
@@ -122,21 +161,285 @@ typedef struct WOLFPROV_CTX {
     const OSSL_CORE_HANDLE *handle;
     /** Library context to use in all cases. */
     OSSL_LIB_CTX *libCtx;
-   /** Random number generator. */
-   WC_RNG rng;
-#ifndef WP_SINGLE_THREADED
-   /** Mutex for use of random number generator. */
-   wolfSSL_Mutex rng_mutex;
+#ifdef WP_SINGLE_THREADED
+    /** Random number generator. */
+    WC_RNG rng;
+    /** Random number generator has been instantiated. Done on first use. */
+    int rngInit;
+#else
+    /** Key to thread specific random number generator. */
+    pthread_key_t rngKey;
+    /** List of all thread specific random number generators. */
+    wp_ThreadRng* rngList;
+    /** Mutex for list of thread random number generators and counters. */
+    wolfSSL_Mutex rng_mutex;
+#endif
+    /** Number of random number generator instantiations. */
+    word32 rngInstCnt;
+    /** Number of random number generator reseeds. */
+    word32 rngReseedCnt;
+    /** Number of uses of RNGs from another NUMA node by exited threads. */
+    word64 rngRemoteCnt;
+#if defined(FP_ECC) && !defined(WP_SINGLE_THREADED)
+    /** Key marking threads that have an ECC fixed point cache to dispose of.
+     */
+    pthread_key_t eccFpKey;
 #endif
+    /** Pool of pre-generated ephemeral keys. NULL when not configured. */
+    struct wp_KeyPool* keyPool;
+    /** Idle file store decoder contexts. NULL when not configured. */
+    struct wp_DecCache* decCache;
+    /** Expanded forms of compact ECC keys. NULL when keys not compact. */
+    struct wp_EccCache* eccCache;
+    /** Keys derived with PBKDF2 when decrypting private keys. NULL when not
+     * configured. */
+    struct wp_Pbkdf2Cache* pbkdf2Cache;
+    /** Device id passed to wolfCrypt objects for crypto callbacks and async
+     * hardware. INVALID_DEVID when not configured. */
+    int devId;
+    /** Size in bytes of output buffer of new DRBGs. 0 when not buffered. */
+    size_t drbgBufSize;
+    /** New DRBGs use additional input and prediction resistance. */
+    int drbgUseAdIn;
+    /** Seed pool in use by this provider context and to be released. */
+    int seedPool;
+    /** Per-thread arenas used for public key operation temporaries. */
+    int arena;
+#ifdef WOLFSSL_ASYNC_CRYPT
+    /** Async device opened by provider and to be closed on unload. */
+    int asyncDevOpen;
+#endif
+    /** Implementations to return for each operation when some have been
+     * disabled by configuration. NULL when full table is returned. */
+    OSSL_ALGORITHM* algs[OSSL_OP__HIGHEST + 1];
+    /** Time taken to initialize provider in nanoseconds. */
+    word64 initTime;
 } WOLFPROV_CTX;
 
+#if !defined(WP_SINGLE_THREADED) && (defined(__GNUC__) || defined(__clang__))
+    /* Use compiler atomic builtins for reference counts. */
+    #define WP_ATOMIC_REFCNT
+#endif
+
+/**
+ * Reference count of a shared object.
+ *
+ * Atomic when supported by compiler, otherwise protected by a mutex.
+ */
+typedef struct wp_RefCnt {
+#if !defined(WP_SINGLE_THREADED) && !defined(WP_ATOMIC_REFCNT)
+    /** Mutex for reference count updating. */
+    wolfSSL_Mutex mutex;
+#endif
+    /** Count of references. */
+    int cnt;
+} wp_RefCnt;
+
+int wp_refcnt_init(wp_RefCnt* ref);
+void wp_refcnt_free(wp_RefCnt* ref);
+int wp_refcnt_up(wp_RefCnt* ref);
+int wp_refcnt_down(wp_RefCnt* ref);
+
+/**
+ * Encoding memoized on a key object - DER or serialized numbers for export.
+ *
+ * Encoding of len bytes follows this object in the same allocation.
+ */
+typedef struct wp_Der {
+    /** Length of encoding in bytes. */
+    size_t len;
+} wp_Der;
+
+/** Get a pointer to the encoding held by a DER object. */
+#define WP_DER_DATA(der)        ((unsigned char*)((der) + 1))
+
+wp_Der* wp_der_new(size_t len);
+wp_Der* wp_der_get(wp_Der* const* cache);
+int wp_der_set(wp_Der** cache, wp_Der** der);
+void wp_der_free(wp_Der** cache);
+int wp_der_get_item(const unsigned char* data, word32 len, word32* idx,
+    unsigned char tag, word32* itemLen);
 
+
+int wp_provctx_rng_init(WOLFPROV_CTX* provCtx);
+void wp_provctx_rng_free(WOLFPROV_CTX* provCtx);
 WC_RNG* wp_provctx_get_rng(WOLFPROV_CTX* provCtx);
-#ifndef WP_SINGLE_THREADED
-int wp_provctx_lock_rng(WOLFPROV_CTX* provCtx);
-void wp_provctx_unlock_rng(WOLFPROV_CTX* provCtx);
+int wp_provctx_rng_stats(WOLFPROV_CTX* provCtx, word32* instCnt,
+    word32* reseedCnt);
+int wp_provctx_rng_remote(WOLFPROV_CTX* provCtx, word64* remoteCnt);
+
+/** Maximum number of NUMA nodes that shared caches are sharded across.
+ * Static shard initializers list this many entries. */
+#define WP_NUMA_MAX_NODES       4
+
+int wp_numa_node(void);
+void* wp_numa_zalloc(size_t size);
+void wp_numa_clear_free(void* ptr, size_t size);
+
+#ifdef WOLFSSL_ASYNC_CRYPT
+/** Async device of a wolfCrypt key object. */
+#define WP_ASYNC_DEV(key)       (&(key)->asyncDev)
+int wp_async_pending(int* rc, WC_ASYNC_DEV* dev);
+#else
+/** Async device of a wolfCrypt key object - none without async support. */
+#define WP_ASYNC_DEV(key)       NULL
+/** Operations never pending without async support. */
+#define wp_async_pending(rc, dev)   0
 #endif
 
+/**
+ * Verify one item of a batch.
+ *
+ * @param [in] ctx     Signature context object.
+ * @param [in] sig     Signature data.
+ * @param [in] sigLen  Length of signature data in bytes.
+ * @param [in] tbs     Data that was signed.
+ * @param [in] tbsLen  Length of data that was signed in bytes.
+ * @return  1 when signature verified.
+ * @return  0 otherwise.
+ */
+typedef int (*WP_BATCH_VERIFY_FN)(void* ctx, const unsigned char* sig,
+    size_t sigLen, const unsigned char* tbs, size_t tbsLen);
+
+int wp_batch_get_field(const unsigned char* data, size_t len, size_t* idx,
+    const unsigned char** field, size_t* fLen);
+int wp_batch_verify(void* ctx, WP_BATCH_VERIFY_FN verify,
+    const unsigned char* data, size_t len, unsigned char** res,
+    size_t* resLen);
+
+int wp_provctx_ecc_fp_init(WOLFPROV_CTX* provCtx);
+void wp_provctx_ecc_fp_free(WOLFPROV_CTX* provCtx);
+void wp_provctx_ecc_fp_use(WOLFPROV_CTX* provCtx);
+
+/* Slots of key pool - curves that have keys pre-generated. */
+/** NIST P-256 ECC keys. */
+#define WP_KEY_POOL_P256            0
+/** NIST P-384 ECC keys. */
+#define WP_KEY_POOL_P384            1
+/** NIST P-521 ECC keys. */
+#define WP_KEY_POOL_P521            2
+/** X25519 keys. */
+#define WP_KEY_POOL_X25519          3
+/** X448 keys. */
+#define WP_KEY_POOL_X448            4
+/** ML-KEM-768 keys. */
+#define WP_KEY_POOL_MLKEM768        5
+/** X25519MLKEM768 hybrid keys. */
+#define WP_KEY_POOL_X25519MLKEM768  6
+/** SecP256r1MLKEM768 hybrid keys. */
+#define WP_KEY_POOL_P256MLKEM768    7
+/** 2048-bit RSA keys. */
+#define WP_KEY_POOL_RSA2048         8
+/** 3072-bit RSA keys. */
+#define WP_KEY_POOL_RSA3072         9
+/** 4096-bit RSA keys. */
+#define WP_KEY_POOL_RSA4096         10
+/** Number of slots in key pool. */
+#define WP_KEY_POOL_CNT             11
+/** First slot of RSA keys - slots from here use RSA depth. */
+#define WP_KEY_POOL_RSA_FIRST       WP_KEY_POOL_RSA2048
+
+/** Pool of pre-generated ephemeral keys. */
+typedef struct wp_KeyPool wp_KeyPool;
+
+/** Type of function that generates a key pair for a key pool slot. */
+typedef void* (*WP_KEY_POOL_GEN_FN)(WOLFPROV_CTX* provCtx, const void* arg);
+/** Type of function that disposes of a key from a key pool slot. */
+typedef void (*WP_KEY_POOL_FREE_FN)(void* key);
+
+int wp_key_pool_init(WOLFPROV_CTX* provCtx, int depth, int rsaDepth,
+    int threads);
+void wp_key_pool_free(WOLFPROV_CTX* provCtx);
+void* wp_key_pool_get(WOLFPROV_CTX* provCtx, int id, WP_KEY_POOL_GEN_FN gen,
+    WP_KEY_POOL_FREE_FN freeKey, const void* arg);
+
+/** Cache of idle file store decoder contexts. */
+typedef struct wp_DecCache wp_DecCache;
+
+int wp_dec_cache_init(WOLFPROV_CTX* provCtx, int size);
+void wp_dec_cache_free(WOLFPROV_CTX* provCtx);
+
+/** Cache of expanded forms of compact ECC keys. */
+typedef struct wp_EccCache wp_EccCache;
+
+int wp_ecc_cache_init(WOLFPROV_CTX* provCtx, int size);
+void wp_ecc_cache_free(WOLFPROV_CTX* provCtx);
+
+/** Cache of keys derived with PBKDF2 when decrypting private keys. */
+typedef struct wp_Pbkdf2Cache wp_Pbkdf2Cache;
+
+int wp_pbkdf2_cache_init(WOLFPROV_CTX* provCtx, int size, int ttl);
+void wp_pbkdf2_cache_free(WOLFPROV_CTX* provCtx);
+word64 wp_pbkdf2_cache_hits(WOLFPROV_CTX* provCtx);
+
+void wp_log_init(void);
+void wp_log_cleanup(void);
+
+int wp_pool_init(void);
+void wp_pool_cleanup(void);
+void* wp_pool_zalloc(size_t size);
+void wp_pool_clear_free(void* ptr, size_t size);
+int wp_pool_stats(word32* hits, word32* misses);
+
+/** Thread's arena for wolfCrypt temporaries of public key operations. */
+typedef struct wp_Arena wp_Arena;
+
+int wp_arena_init(int size);
+void wp_arena_cleanup(void);
+wp_Arena* wp_arena_begin(void);
+void wp_arena_end(wp_Arena* arena);
+void wp_arena_stats(word64* allocs, word64* fallbacks, word64* escapes);
+
+int wp_seed_pool_init(void);
+void wp_seed_pool_cleanup(void);
+
+/* Operations that metrics are recorded for. */
+/** Digest update. */
+#define WP_METRIC_DIGEST_UPDATE         0
+/** AES-GCM TLS record encryption/decryption. */
+#define WP_METRIC_AES_GCM_TLS           1
+/** ChaCha20-Poly1305 TLS record encryption/decryption. */
+#define WP_METRIC_CHACHA20_POLY1305_TLS 2
+/** RSA signing. */
+#define WP_METRIC_RSA_SIGN              3
+/** RSA verification. */
+#define WP_METRIC_RSA_VERIFY            4
+/** ECDSA signing. */
+#define WP_METRIC_ECDSA_SIGN            5
+/** ECDSA verification. */
+#define WP_METRIC_ECDSA_VERIFY          6
+/** ECDH secret derivation. */
+#define WP_METRIC_ECDH_DERIVE           7
+/** X25519/X448 secret derivation. */
+#define WP_METRIC_ECX_DERIVE            8
+/** DH secret derivation. */
+#define WP_METRIC_DH_DERIVE             9
+/** RSA key generation. */
+#define WP_METRIC_RSA_KEYGEN            10
+/** EC key generation. */
+#define WP_METRIC_EC_KEYGEN             11
+/** X25519/X448/Ed25519/Ed448 key generation. */
+#define WP_METRIC_ECX_KEYGEN            12
+/** Random number generation. */
+#define WP_METRIC_RNG_GENERATE          13
+/** ML-KEM and hybrid key generation. */
+#define WP_METRIC_MLKEM_KEYGEN          14
+/** ML-KEM and hybrid encapsulation. */
+#define WP_METRIC_MLKEM_ENCAP           15
+/** ML-KEM and hybrid decapsulation. */
+#define WP_METRIC_MLKEM_DECAP           16
+/** Number of operations that metrics are recorded for. */
+#define WP_METRIC_CNT                   17
+/** Number of buckets in latency histogram. */
+#define WP_METRIC_HIST_CNT              16
+
+int wp_metrics_init(void);
+void wp_metrics_enable(void);
+void wp_metrics_cleanup(void);
+word64 wp_metrics_start(void);
+void wp_metrics_record(int id, word64 start, size_t bytes);
+int wp_metrics_get_param(OSSL_PARAM* p);
+
 int wolfssl_prov_get_capabilities(void *provctx, const char *capability,
     OSSL_CALLBACK *cb, void *arg);
 
@@ -155,6 +458,7 @@ int wp_encrypt_key(WOLFPROV_CTX* provCtx, const char* cipherName,
     unsigned char* keyData, size_t* keyLen, word32 pkcs8Len,
     OSSL_PASSPHRASE_CALLBACK *pwCb, void *pwCbArg, byte** cipherInfo);
 
+int wp_read_bio(BIO* bio, unsigned char** data, word32* len);
 int wp_read_der_bio(OSSL_CORE_BIO *coreBio, unsigned char** data, word32* len);
 BIO* wp_corebio_get_bio(OSSL_CORE_BIO *coreBio);
 
@@ -67,6 +67,11 @@
  * WOLFPROV_LOG_PRINTF  Define to Use printf instead of fprintf (to stderr)
  *                        for logs. Not applicable if using WOLFPROV_USER_LOG
  *                        or custom logging callback.
+ * WOLFPROV_MIN_LOG_LEVEL  Least severe log level to compile in. Levels are
+ *                        ordered by severity: WP_LOG_ERROR, WP_LOG_INFO,
+ *                        WP_LOG_ENTER and WP_LOG_LEAVE, then WP_LOG_VERBOSE.
+ *                        Calls for less severe levels are compiled out.
+ *                        Defaults to WP_LOG_VERBOSE (all).
  */
 enum wolfProv_LogType {
     WP_LOG_ERROR   = 0x0001,  /* logs errors */
@@ -126,9 +131,38 @@ void wolfProv_Debugging_OFF(void);
 int wolfProv_SetLogLevel(int levelMask);
 /* Set which components are logged, bitmask of wolfProv_LogComponents */
 int wolfProv_SetLogComponents(int componentMask);
+/* Log through a ring written out by a background thread, 0 slots to stop */
+int wolfProv_SetLogAsync(int slots);
+/* Get number of messages dropped as the log ring was full */
+int wolfProv_GetLogDropped(unsigned long* cnt);
 
 #ifdef WOLFPROV_DEBUG
 
+#ifndef WOLFPROV_MIN_LOG_LEVEL
+#define WOLFPROV_MIN_LOG_LEVEL WP_LOG_VERBOSE
+#endif
+
+/* Log levels enabled at runtime. 0 when logging is turned off. */
+extern int wolfProv_LogLevelMask;
+/* Components enabled at runtime. */
+extern int wolfProv_LogComponentMask;
+
+/* Severity rank of a log level - lower is more severe. Level values are
+ * bitmask flags and not ordered by severity. */
+#define WOLFPROV_LOG_RANK(level)                                            \
+    (((level) == WP_LOG_ERROR) ? 0 :                                        \
+     ((level) == WP_LOG_INFO) ? 1 :                                         \
+     (((level) == WP_LOG_ENTER) || ((level) == WP_LOG_LEAVE)) ? 2 : 3)
+
+/* Check whether messages of the level and component are logged.
+ * Evaluated at the call site so that disabled messages cost one branch and
+ * their arguments are not evaluated. */
+#define WOLFPROV_LOG_ON(level, type)                                        \
+    ((WOLFPROV_LOG_RANK(level) <=                                           \
+      WOLFPROV_LOG_RANK(WOLFPROV_MIN_LOG_LEVEL)) &&                         \
+     ((wolfProv_LogLevelMask & (level)) == (level)) &&                      \
+     ((wolfProv_LogComponentMask & (type)) == (type)))
+
 #define WOLFPROV_ERROR(type, err)                                           \
     WOLFPROV_ERROR_LINE(type, err, __FILE__, __LINE__)
 #define WOLFPROV_ERROR_MSG(type, msg)                                       \
@@ -152,6 +186,55 @@ void WOLFPROV_ERROR_FUNC_NULL_LINE(int type, const char* funcName,
 void WOLFPROV_BUFFER(int type, const unsigned char* buffer,
     unsigned int length);
 
+/* Call the logging functions only when the message will be logged.
+ * Function names in parentheses are not macro expanded. */
+#define WOLFPROV_ENTER(type, msg)                                           \
+    do {                                                                    \
+        if (WOLFPROV_LOG_ON(WP_LOG_ENTER, type))                            \
+            (WOLFPROV_ENTER)(type, msg);                                    \
+    } while (0)
+#define WOLFPROV_LEAVE(type, msg, ret)                                      \
+    do {                                                                    \
+        if (WOLFPROV_LOG_ON(WP_LOG_LEAVE, type))                            \
+            (WOLFPROV_LEAVE)(type, msg, ret);                               \
+    } while (0)
+#define WOLFPROV_MSG(type, ...)                                             \
+    do {                                                                    \
+        if (WOLFPROV_LOG_ON(WP_LOG_INFO, type))                             \
+            (WOLFPROV_MSG)(type, __VA_ARGS__);                              \
+    } while (0)
+#define WOLFPROV_MSG_VERBOSE(type, ...)                                     \
+    do {                                                                    \
+        if (WOLFPROV_LOG_ON(WP_LOG_VERBOSE, type))                          \
+            (WOLFPROV_MSG_VERBOSE)(type, __VA_ARGS__);                      \
+    } while (0)
+#define WOLFPROV_ERROR_LINE(type, err, file, line)                          \
+    do {                                                                    \
+        if (WOLFPROV_LOG_ON(WP_LOG_ERROR, type))                            \
+            (WOLFPROV_ERROR_LINE)(type, err, file, line);                   \
+    } while (0)
+#define WOLFPROV_ERROR_MSG_LINE(type, msg, file, line)                      \
+    do {                                                                    \
+        if (WOLFPROV_LOG_ON(WP_LOG_ERROR, type))                            \
+            (WOLFPROV_ERROR_MSG_LINE)(type, msg, file, line);               \
+    } while (0)
+#define WOLFPROV_ERROR_FUNC_LINE(type, funcName, ret, file, line)           \
+    do {                                                                    \
+        if (WOLFPROV_LOG_ON(WP_LOG_ERROR, type))                            \
+            (WOLFPROV_ERROR_FUNC_LINE)(type, funcName, ret, file, line);    \
+    } while (0)
+#define WOLFPROV_ERROR_FUNC_NULL_LINE(type, funcName, ret, file, line)      \
+    do {                                                                    \
+        if (WOLFPROV_LOG_ON(WP_LOG_ERROR, type))                            \
+            (WOLFPROV_ERROR_FUNC_NULL_LINE)(type, funcName, ret, file,      \
+                line);                                                      \
+    } while (0)
+#define WOLFPROV_BUFFER(type, buffer, length)                               \
+    do {                                                                    \
+        if (WOLFPROV_LOG_ON(WP_LOG_VERBOSE, type))                          \
+            (WOLFPROV_BUFFER)(type, buffer, length);                        \
+    } while (0)
+
 #else
 
 #define WOLFPROV_ENTER(t, m)
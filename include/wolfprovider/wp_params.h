@@ -34,7 +34,185 @@
 /* Used by OSSL_PARAM_free to indicate key type that is data to be freed. */
 #define OSSL_PARAM_ALLOCATED_END    127
 
+/* Provider parameter: number of RNG instantiations (unsigned integer). */
+#define WP_PROV_PARAM_RNG_INST_CNT          "rng-instantiations"
+/* Provider parameter: number of RNG reseeds (unsigned integer). */
+#define WP_PROV_PARAM_RNG_RESEED_CNT        "rng-reseeds"
+/* Number of context allocations satisfied from the pool. */
+#define WP_PROV_PARAM_POOL_HITS             "pool-hits"
+/* Number of context allocations that went to the allocator. */
+#define WP_PROV_PARAM_POOL_MISSES           "pool-misses"
+/* Provider parameter: number of wolfCrypt allocations during public key
+ * operations satisfied from a thread's arena (unsigned integer). */
+#define WP_PROV_PARAM_ARENA_ALLOCS          "arena-allocs"
+/* Provider parameter: number of wolfCrypt allocations during public key
+ * operations that did not fit in the thread's arena (unsigned integer). */
+#define WP_PROV_PARAM_ARENA_FALLBACKS       "arena-fallbacks"
+/* Provider parameter: number of arena allocations not freed by the end of an
+ * operation and left to the allocator (unsigned integer). */
+#define WP_PROV_PARAM_ARENA_ESCAPES         "arena-escapes"
+/* Provider parameter: number of keys found in the PBKDF2 cache when
+ * decrypting - PBKDF2 not performed (unsigned integer). */
+#define WP_PROV_PARAM_PBKDF2_CACHE_HITS     "pbkdf2-cache-hits"
+/* Provider parameter: nanoseconds taken to initialize the provider when
+ * loaded (unsigned integer). */
+#define WP_PROV_PARAM_INIT_TIME             "init-time"
+/* Provider parameter: number of uses of a thread's RNG while the thread ran
+ * on a different NUMA node to the RNG's memory (unsigned integer). Always 0
+ * unless built with NUMA support. */
+#define WP_PROV_PARAM_NUMA_REMOTE           "numa-remote-accesses"
+/* Report of operation metrics (UTF-8 string). One line per operation:
+ * "<name> calls=<n> bytes=<n> hist=<n>,...". Empty counts unless enabled. */
+#define WP_PROV_PARAM_METRICS               "metrics"
 
+/* Provider configuration: number of ephemeral keys to pre-generate for each
+ * ECDHE/X25519/X448 curve in use. No keys are pre-generated when 0 (default).
+ */
+#define WP_PROV_CONF_KEYGEN_POOL_DEPTH      "keygen-pool-depth"
+/* Provider configuration: number of RSA key pairs to pre-generate for each of
+ * 2048, 3072 and 4096 bits with public exponent 65537, once a size is used.
+ * No RSA keys are pre-generated when 0 (default). */
+#define WP_PROV_CONF_KEYGEN_POOL_RSA_DEPTH  "keygen-pool-rsa-depth"
+/* Provider configuration: number of threads pre-generating ephemeral keys.
+ * Defaults to 1. */
+#define WP_PROV_CONF_KEYGEN_POOL_THREADS    "keygen-pool-threads"
+/* Provider configuration: number of idle file store decoder contexts to keep
+ * for reuse by later opens. Cached decoders keep providers referenced until
+ * this provider is unloaded. None are kept when 0 (default). */
+#define WP_PROV_CONF_DECODER_CACHE_SIZE     "decoder-cache-size"
+/* Provider configuration: record operation metrics when 1. Metrics are not
+ * recorded when 0 (default). */
+#define WP_PROV_CONF_METRICS                "metrics"
+/* Provider configuration: wolfCrypt device id for crypto callbacks, passed to
+ * all wolfCrypt objects created. No device is used when not set (default). */
+#define WP_PROV_CONF_DEVICE_ID              "device-id"
+/* Provider configuration: open the wolfCrypt async device (QAT, Nitrox) when
+ * 1 and use its device id. Only with wolfSSL built with async crypto. */
+#define WP_PROV_CONF_ASYNC_DEVICE           "async-device"
+/* Provider configuration: size in bytes, up to 65536, of the output buffer of
+ * each DRBG. Small requests are served from the buffer, which is refilled with
+ * one DRBG generate. Not buffered when 0 (default). */
+#define WP_PROV_CONF_DRBG_BUFFER_SIZE       "drbg-buffer-size"
+/* Provider configuration: DRBGs use additional input and prediction
+ * resistance, unbuffered, when 1. Both are ignored when 0 (default). */
+#define WP_PROV_CONF_DRBG_USE_ADIN          "drbg-use-additional-input"
+/* Provider configuration: seed wolfCrypt DRBGs from a health tested pool of
+ * entropy, filled from RDSEED/RNDRRS when available, when 1. Only with wolfSSL
+ * built with WC_RNG_SEED_CB. Seeded from the OS each time when 0 (default). */
+#define WP_PROV_CONF_SEED_POOL              "seed-pool"
+/* Provider configuration: comma separated names of algorithms not to
+ * advertise. Any of an algorithm's names matches, case insensitive. Disabled
+ * algorithms are fetched from other providers instead. */
+#define WP_PROV_CONF_DISABLE_ALGS           "disable-algorithms"
+/* Provider configuration: number of expanded compact ECC keys to keep. When
+ * non-zero, decoded ECC private keys are stored as the private scalar and
+ * public point only and expanded when used. Not compact when 0 (default). */
+#define WP_PROV_CONF_COMPACT_KEYS           "compact-keys"
+/* Provider configuration: number of keys derived with PBKDF2 when decrypting
+ * PBES2 AES-CBC encrypted private keys to keep, zeroized when dropped. Keys
+ * are identified by an HMAC, under a random secret, of the password and PBKDF2
+ * parameters. None are kept when 0 (default). */
+#define WP_PROV_CONF_PBKDF2_CACHE_SIZE      "pbkdf2-cache-size"
+/* Provider configuration: number of seconds a key derived with PBKDF2 is kept
+ * for. Defaults to 300. */
+#define WP_PROV_CONF_PBKDF2_CACHE_TTL       "pbkdf2-cache-ttl"
+/* Provider configuration: size in bytes, up to 16MB, of each thread's arena
+ * that wolfCrypt temporaries of RSA, DH and ECDH operations are allocated
+ * from. Replaces the wolfSSL allocator callbacks. Only with wolfSSL built
+ * with replaceable allocator callbacks. No arenas when 0 (default). */
+#define WP_PROV_CONF_BIGNUM_ARENA_SIZE      "bignum-arena-size"
+
+/* Key parameter: number of bytes of memory kept by the key object (size_t).
+ * Excludes the expanded form of a compact key while it is cached. */
+#define WP_PKEY_PARAM_KEY_BYTES             "wolfprov-key-bytes"
+
+/* Signature parameter: batch of items to verify (octet string).
+ * Each item is a 4 byte big-endian length and data followed by a 4 byte
+ * big-endian length and signature. Data is the digest for ECDSA and the
+ * message for EdDSA. */
+#define WP_SIGNATURE_PARAM_BATCH_VERIFY     "wolfprov-batch-verify"
+/* Signature parameter: result of batch verification (octet string).
+ * Bit i (bit i % 8 of byte i / 8) set when item i verified. */
+#define WP_SIGNATURE_PARAM_BATCH_RESULT     "wolfprov-batch-result"
+
+/* Digest context parameter: messages to hash as a batch (octet string).
+ * Each message is a 4 byte big-endian length followed by the message. */
+#define WP_DIGEST_PARAM_BATCH_MSGS          "wolfprov-batch-msgs"
+/* Digest context parameter: digests of the batch of messages (octet string).
+ * Digests are concatenated in the order of the messages. */
+#define WP_DIGEST_PARAM_BATCH_DIGESTS       "wolfprov-batch-digests"
+
+/* DRBG parameter: size in bytes of output buffer (size_t). Small requests are
+ * served from the buffer. Not buffered when 0. */
+#define WP_DRBG_PARAM_BUFFER_SIZE           "wolfprov-buffer-size"
+/* DRBG parameter: use additional input and prediction resistance (int).
+ * Requests with either are not served from the output buffer. */
+#define WP_DRBG_PARAM_USE_ADIN              "wolfprov-use-additional-input"
+
+/* Cipher parameter: AES-XTS data unit size in bytes (size_t).
+ * When non-zero, each update is a sequence of whole data units and the tweak
+ * is incremented, as a 128-bit little-endian number, after each unit. */
+#define WP_CIPHER_PARAM_XTS_DATA_UNIT_SIZE  "wolfprov-xts-data-unit-size"
+/* Cipher parameter: AES key wrap batch item size in bytes (size_t).
+ * When non-zero, each update wraps a sequence of keys of this size or unwraps
+ * a sequence of wrapped keys of this size plus 8. */
+#define WP_CIPHER_PARAM_WRAP_BATCH_ITEM_SIZE "wolfprov-wrap-batch-item-size"
+/* Cipher parameter: result of last AES key wrap batch (octet string).
+ * Bit i (bit i % 8 of byte i / 8) set when item i unwrapped. The output of an
+ * item that failed to unwrap is zeroized. */
+#define WP_CIPHER_PARAM_WRAP_BATCH_RESULT   "wolfprov-wrap-batch-result"
+/* Cipher parameter: TLS AADs of a batch of AES-CCM records (octet string).
+ * Concatenation of 13 byte AADs as would be set with
+ * OSSL_CIPHER_PARAM_AEAD_TLS1_AAD, one per record. The next update processes,
+ * in place, the records laid out one after the other. */
+#define WP_CIPHER_PARAM_CCM_TLS_BATCH_AAD   "wolfprov-ccm-tls-batch-aad"
+/* Cipher parameter: result of last AES-CCM TLS batch (octet string).
+ * Bit i (bit i % 8 of byte i / 8) set when record i encrypted or
+ * authenticated. The payload of a record that failed is zeroized. */
+#define WP_CIPHER_PARAM_CCM_TLS_BATCH_RESULT "wolfprov-ccm-tls-batch-result"
+
+/* PBKDF2 parameter: number of threads to compute output blocks on
+ * (unsigned integer). Blocks are computed on the calling thread when 0 or 1.
+ */
+#define WP_KDF_PARAM_THREADS                "wolfprov-threads"
+
+/* TLS1 PRF parameter: label and seed of the key block (octet string).
+ * When set, the secret is the pre-master secret and output is the 48 byte
+ * master secret followed by the key block. The master secret then replaces
+ * the secret, already keyed, and the seeds are cleared for the next derive. */
+#define WP_KDF_PARAM_TLS1_KEY_BLOCK_SEED    "wolfprov-tls1-key-block-seed"
+
+/* TLS 1.3 KDF parameter: labels to expand in one request (octet string).
+ * Each item is a 2 byte big-endian output length, a 1 byte label length and
+ * the label without prefix. Output is the expansion of each label in turn, of
+ * the key with the same data. Derive length must be the sum of the lengths. */
+#define WP_KDF_PARAM_TLS13_EXPAND_LABELS    "wolfprov-tls13-expand-labels"
+
+/* TLS 1.3 key schedule parameter: pre-shared key (octet string).
+ * Zeros of digest length are used when not set. */
+#define WP_KDF_PARAM_TLS13_PSK              "wolfprov-tls13-psk"
+/* TLS 1.3 key schedule parameter: hash of ClientHello..ServerHello
+ * (octet string). */
+#define WP_KDF_PARAM_TLS13_HS_HASH          "wolfprov-tls13-handshake-hash"
+/* TLS 1.3 key schedule parameter: hash of ClientHello..server Finished
+ * (octet string). Application secrets are only derived when set. */
+#define WP_KDF_PARAM_TLS13_APP_HASH         "wolfprov-tls13-application-hash"
+/* TLS 1.3 key schedule parameter: length of traffic keys (size_t).
+ * Traffic keys and IVs are only derived when non-zero. */
+#define WP_KDF_PARAM_TLS13_KEY_LEN          "wolfprov-tls13-key-len"
+/* TLS 1.3 key schedule parameter: length of traffic IVs (size_t).
+ * Default is 12. */
+#define WP_KDF_PARAM_TLS13_IV_LEN           "wolfprov-tls13-iv-len"
+
+/* Key exchange KDF type: put the shared secret through HKDF-Extract with the
+ * KDF digest. Output is the pseudorandom key of digest length. */
+#define WP_EXCHANGE_KDF_NAME_HKDF_EXTRACT   "HKDF-EXTRACT"
+/* Key exchange parameter: salt for HKDF-Extract (octet string).
+ * Zeros of digest length are used when not set as in RFC 5869. */
+#define WP_EXCHANGE_PARAM_KDF_SALT          "wolfprov-kdf-salt"
+
+
+void wp_bytes_reverse(unsigned char* out, const unsigned char* in, size_t len);
 int wp_mp_read_unsigned_bin_le(mp_int* a, const unsigned char* data,
     size_t len);
 int wp_mp_to_unsigned_bin_le(mp_int* mp, unsigned char* data, size_t len);
@@ -46,9 +224,13 @@ void wp_param_set_octet_string_ptr(OSSL_PARAM* p, const char* key,
 void wp_param_set_int(OSSL_PARAM* p, const char* key, int* val);
 int wp_param_set_mp(OSSL_PARAM* p, const char* key, mp_int* mp,
     unsigned char* data, size_t* idx);
+void wp_param_set_mp_ptr(OSSL_PARAM* p, const char* key, mp_int* mp,
+    unsigned char* data, size_t* idx);
 void wp_param_set_mp_buf(OSSL_PARAM* p, const char* key, unsigned char* num,
     size_t nLen, unsigned char* data, size_t* idx);
 
+void wp_params_index(const OSSL_PARAM* params, const char* const* keys,
+    size_t cnt, const OSSL_PARAM** found);
 int wp_params_get_digest(const OSSL_PARAM* params, char* name,
     OSSL_LIB_CTX* libCtx, enum wc_HashType* type, size_t* len);
 int wp_params_get_mp(const OSSL_PARAM* params, const char* key, mp_int* mp);
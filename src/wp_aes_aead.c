@@ -29,6 +29,57 @@
 
 #include <wolfssl/wolfcrypt/error-crypt.h>
 
+#if !defined(WOLFSSL_AESGCM_STREAM) && defined(WOLFSSL_AES_DIRECT)
+    /* wolfSSL has no streaming GCM - provider implements incremental GCM. */
+    #define WP_AESGCM_INCREMENTAL
+#endif
+
+#ifdef HAVE_AES_ECB
+    /* Provider implements single pass CCM - CBC-MAC and CTR blocks are
+     * encrypted together with one multi-block ECB call. */
+    #define WP_AESCCM_INTERLEAVED
+#endif
+
+/** Maximum number of records in an AES-CCM TLS batch. */
+#define WP_AESCCM_TLS_BATCH_MAX       32
+
+#ifdef WP_AESGCM_INCREMENTAL
+/**
+ * State of incremental AES-GCM operation.
+ */
+typedef struct wp_GcmState {
+    /** High 64 bits of multiples of hash key H for 4-bit GHASH. */
+    word64 hh[16];
+    /** Low 64 bits of multiples of hash key H for 4-bit GHASH. */
+    word64 hl[16];
+    /** Running GHASH value. */
+    byte x[AES_BLOCK_SIZE];
+    /** Pre-counter block - encrypted to mask tag. */
+    byte j0[AES_BLOCK_SIZE];
+    /** Counter block for next block of key stream. */
+    byte ctr[AES_BLOCK_SIZE];
+    /** Current block of key stream. */
+    byte ks[AES_BLOCK_SIZE];
+    /** Total length of AAD in bytes. */
+    word64 aadLen;
+    /** Total length of cipher text in bytes. */
+    word64 ctLen;
+    /** Number of bytes absorbed into current GHASH block. */
+    word32 xLen;
+    /** Number of bytes of current key stream block used. */
+    word32 ksUsed;
+    /** Message started - IV/nonce processed. */
+    unsigned int started:1;
+    /** All AAD absorbed and cipher text started. */
+    unsigned int inData:1;
+} wp_GcmState;
+#endif
+
+/** Size of AAD buffer in AEAD context. Larger AAD is allocated. */
+#ifndef WP_AEAD_INLINE_AAD_SZ
+    #define WP_AEAD_INLINE_AAD_SZ     64
+#endif
+
 /**
  * Authenticated Encryption with Associated Data structure.
  */
@@ -86,8 +137,30 @@ typedef struct wp_AeadCtx {
 
     /** Length of AAD data cached.  */
     size_t aadLen;
-    /** CCM is not streaming and needs to cache AAD data. */
+    /** CCM is not streaming and needs to cache AAD data.
+     * Points to aadBuf or allocated memory when too big. */
     unsigned char* aad;
+    /** Buffer for small amounts of AAD data. */
+    unsigned char aadBuf[WP_AEAD_INLINE_AAD_SZ];
+
+    /** Key that AES key schedule (and GCM GHASH table) were expanded for.
+     * Also used to key a duplicate. */
+    unsigned char expKey[AES_256_KEY_SIZE];
+    /** Length of expanded key. 0 when no key expanded. */
+    size_t expKeyLen;
+
+    /** TLS AADs of records in CCM batch. Allocated when batch first set. */
+    unsigned char* tlsBatchAad;
+    /** Number of records in CCM batch. 0 when no batch set. */
+    size_t tlsBatchCnt;
+    /** Number of records in last CCM batch processed. */
+    size_t tlsBatchResCnt;
+    /** Result of last CCM batch: bit set when record processed. */
+    unsigned char tlsBatchRes[WP_AESCCM_TLS_BATCH_MAX / 8];
+#ifdef WP_AESGCM_INCREMENTAL
+    /** State of incremental GCM operation. */
+    wp_GcmState gcm;
+#endif
 } wp_AeadCtx;
 
 
@@ -146,6 +219,7 @@ const OSSL_DISPATCH wp_aes##kbits##lc##_functions[] = {                        \
     { OSSL_FUNC_CIPHER_NEWCTX,                                                 \
                                   (DFUNC)wp_aes_##lc##_##kbits##lc##_newctx }, \
     { OSSL_FUNC_CIPHER_FREECTX,         (DFUNC)wp_aes_##lc##_freectx        }, \
+    { OSSL_FUNC_CIPHER_DUPCTX,          (DFUNC)wp_aead_dupctx               }, \
     { OSSL_FUNC_CIPHER_ENCRYPT_INIT,    (DFUNC)wp_aes##lc##_einit           }, \
     { OSSL_FUNC_CIPHER_DECRYPT_INIT,    (DFUNC)wp_aes##lc##_dinit           }, \
     { OSSL_FUNC_CIPHER_UPDATE,          (DFUNC)wp_aes##lc##_stream_update   }, \
@@ -179,6 +253,9 @@ static int wp_aesgcm_tls_iv_set_fixed(wp_AeadCtx* ctx, unsigned char* iv,
     size_t len);
 static int wp_aesccm_tls_iv_set_fixed(wp_AeadCtx* ctx, unsigned char* iv,
     size_t len);
+#ifdef WP_AESGCM_INCREMENTAL
+static int wp_aesgcm_inc_set_key(wp_AeadCtx* ctx);
+#endif
 
 
 /**
@@ -254,18 +331,36 @@ static int wp_aead_cache_aad(wp_AeadCtx *ctx, const unsigned char *in,
     size_t inLen)
 {
     int ok = 1;
-    unsigned char *p;
+    unsigned char *p = NULL;
 
-    if (inLen > 0) {
+    if ((inLen > 0) && (ctx->aad == NULL)) {
+        ctx->aad = ctx->aadBuf;
+    }
+    if ((inLen > 0) && (ctx->aad == ctx->aadBuf)) {
+        if (ctx->aadLen + inLen <= sizeof(ctx->aadBuf)) {
+            p = ctx->aadBuf;
+        }
+        else {
+            /* Move out of context buffer into allocated memory. */
+            p = (unsigned char*)OPENSSL_malloc(ctx->aadLen + inLen);
+            if (p == NULL) {
+                ok = 0;
+            }
+            else {
+                XMEMCPY(p, ctx->aadBuf, ctx->aadLen);
+            }
+        }
+    }
+    else if (inLen > 0) {
         p = (unsigned char*)OPENSSL_realloc(ctx->aad, ctx->aadLen + inLen);
         if (p == NULL) {
             ok = 0;
         }
-        if (ok) {
-            ctx->aad = p;
-            XMEMCPY(ctx->aad + ctx->aadLen, in, inLen);
-            ctx->aadLen += inLen;
-        }
+    }
+    if (ok && (inLen > 0)) {
+        ctx->aad = p;
+        XMEMCPY(ctx->aad + ctx->aadLen, in, inLen);
+        ctx->aadLen += inLen;
     }
     if (ok) {
         ctx->aadSet = 1;
@@ -274,6 +369,147 @@ static int wp_aead_cache_aad(wp_AeadCtx *ctx, const unsigned char *in,
     return ok;
 }
 
+/**
+ * Dispose of cached Additional Authentication Data in AEAD context object.
+ *
+ * @param [in, out] ctx  AEAD context object.
+ */
+static void wp_aead_clear_aad(wp_AeadCtx *ctx)
+{
+    if (ctx->aad != ctx->aadBuf) {
+        OPENSSL_free(ctx->aad);
+    }
+    ctx->aad = NULL;
+    ctx->aadLen = 0;
+    ctx->aadSet = 0;
+}
+
+/**
+ * Remember the key that was expanded into the AES object.
+ *
+ * @param [in, out] ctx     AEAD context object.
+ * @param [in]      key     Private key.
+ * @param [in]      keyLen  Length of key in bytes.
+ */
+static void wp_aead_key_store(wp_AeadCtx* ctx, const unsigned char *key,
+    size_t keyLen)
+{
+    if (keyLen <= sizeof(ctx->expKey)) {
+        XMEMCPY(ctx->expKey, key, keyLen);
+        ctx->expKeyLen = keyLen;
+    }
+}
+
+/**
+ * Set the key, and IV/nonce when in use, into the AES object of a duplicate.
+ *
+ * The wolfSSL AES object is not copied as it may hold pointers and state of
+ * hardware or streaming operations.
+ *
+ * @param [in, out] dst  Duplicate AEAD context object. AES object initialized.
+ * @param [in]      src  AEAD context object copied.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_aead_dup_key(wp_AeadCtx *dst, const wp_AeadCtx *src)
+{
+    int ok = 1;
+    int rc;
+
+    if (src->expKeyLen == 0) {
+        /* No key set. */
+    }
+    else if (src->mode == EVP_CIPH_CCM_MODE) {
+        rc = wc_AesCcmSetKey(&dst->aes, src->expKey, (word32)src->expKeyLen);
+        if (rc != 0) {
+            ok = 0;
+        }
+    }
+    else {
+        rc = wc_AesGcmSetKey(&dst->aes, src->expKey, (word32)src->expKeyLen);
+        if (rc != 0) {
+            ok = 0;
+        }
+#ifdef WOLFSSL_AESGCM_STREAM
+        /* Start message again with IV/nonce when set. */
+        if (ok && (src->ivState == IV_STATE_BUFFERED)) {
+            rc = wc_AesGcmInit(&dst->aes, NULL, 0, src->iv,
+                (word32)src->ivLen);
+            if (rc != 0) {
+                ok = 0;
+            }
+        }
+#else
+        /* IV/nonce in AES object - next one to use held in counter. */
+        if (ok && src->ivSet) {
+            rc = wc_AesGcmSetExtIV(&dst->aes, (const byte*)src->aes.reg,
+                (word32)src->ivLen);
+            if (rc != 0) {
+                ok = 0;
+            }
+        }
+#endif
+    }
+
+    return ok;
+}
+
+/**
+ * Duplicate the AEAD context object.
+ *
+ * The AES object is initialized and keyed again from the stored key.
+ *
+ * @param [in] src  AEAD context object to copy.
+ * @return  NULL on failure.
+ * @return  AEAD context object.
+ */
+static void *wp_aead_dupctx(wp_AeadCtx *src)
+{
+    wp_AeadCtx *dst = NULL;
+    int ok = 1;
+
+    if (wolfssl_prov_is_running()) {
+        dst = OPENSSL_malloc(sizeof(*dst));
+    }
+    if (dst != NULL) {
+        /* Fields other than AES object are plain data. */
+        XMEMCPY(dst, src, sizeof(*src));
+        XMEMSET(&dst->aes, 0, sizeof(dst->aes));
+        /* Batch of records is not carried over. */
+        dst->tlsBatchAad = NULL;
+        dst->tlsBatchCnt = 0;
+        if (src->aad != src->aadBuf) {
+            dst->aad = NULL;
+        }
+        if (wc_AesInit(&dst->aes, NULL, src->provCtx->devId) != 0) {
+            OPENSSL_clear_free(dst, sizeof(*dst));
+            dst = NULL;
+        }
+    }
+    if (dst != NULL) {
+        ok = wp_aead_dup_key(dst, src);
+        if (src->aad == src->aadBuf) {
+            dst->aad = dst->aadBuf;
+        }
+        else if (ok && (src->aad != NULL)) {
+            dst->aad = OPENSSL_malloc(src->aadLen);
+            if (dst->aad == NULL) {
+                ok = 0;
+            }
+            else {
+                XMEMCPY(dst->aad, src->aad, src->aadLen);
+            }
+        }
+        if (!ok) {
+            wc_AesFree(&dst->aes);
+            OPENSSL_clear_free(dst, sizeof(*dst));
+            dst = NULL;
+        }
+    }
+
+    return dst;
+}
+
 /**
  * Get the AEAD context parameters.
  *
@@ -359,6 +595,13 @@ static int wp_aead_get_ctx_params(wp_AeadCtx* ctx, OSSL_PARAM params[])
             }
         }
     }
+    if (ok && (ctx->mode == EVP_CIPH_CCM_MODE)) {
+        p = OSSL_PARAM_locate(params, WP_CIPHER_PARAM_CCM_TLS_BATCH_RESULT);
+        if ((p != NULL) && (!OSSL_PARAM_set_octet_string(p, ctx->tlsBatchRes,
+                (ctx->tlsBatchResCnt + 7) / 8))) {
+            ok = 0;
+        }
+    }
     if (ok && (ctx->mode == EVP_CIPH_GCM_MODE)) {
         p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_AEAD_TLS1_GET_IV_GEN);
         if (p != NULL) {
@@ -374,21 +617,18 @@ static int wp_aead_get_ctx_params(wp_AeadCtx* ctx, OSSL_PARAM params[])
 }
 
 /**
- * Set the AEAD tag from the parameters.
+ * Set the AEAD tag from the parameter.
  *
- * @param [in, out] ctx     AEAD context object.
- * @param [in]      params  Array of parameters and values.
+ * @param [in, out] ctx  AEAD context object.
+ * @param [in]      p    Parameter. May be NULL.
  * @return  1 on success.
  * @return  0 on failure.
  */
-static int wp_aead_set_param_tag(wp_AeadCtx* ctx,
-    const OSSL_PARAM params[])
+static int wp_aead_set_param_tag(wp_AeadCtx* ctx, const OSSL_PARAM* p)
 {
     int ok = 1;
-    const OSSL_PARAM* p;
     size_t sz;
 
-    p = OSSL_PARAM_locate_const(params, OSSL_CIPHER_PARAM_AEAD_TAG);
     if (p != NULL) {
         void* vp = ctx->buf;
         if (p->data != NULL) {
@@ -410,21 +650,18 @@ static int wp_aead_set_param_tag(wp_AeadCtx* ctx,
 }
 
 /**
- * Set the IV length from the parameters.
+ * Set the IV length from the parameter.
  *
- * @param [in, out] ctx     AEAD context object.
- * @param [in]      params  Array of parameters and values.
+ * @param [in, out] ctx  AEAD context object.
+ * @param [in]      p    Parameter. May be NULL.
  * @return  1 on success.
  * @return  0 on failure.
  */
-static int wp_aead_set_param_iv_len(wp_AeadCtx* ctx,
-    const OSSL_PARAM params[])
+static int wp_aead_set_param_iv_len(wp_AeadCtx* ctx, const OSSL_PARAM* p)
 {
     int ok = 1;
-    const OSSL_PARAM* p;
     size_t sz;
 
-    p = OSSL_PARAM_locate_const(params, OSSL_CIPHER_PARAM_AEAD_IVLEN);
     if (p != NULL) {
         if (!OSSL_PARAM_get_size_t(p, &sz)) {
             ok = 0;
@@ -441,21 +678,18 @@ static int wp_aead_set_param_iv_len(wp_AeadCtx* ctx,
 }
 
 /**
- * Set the TLS1 AAD from the parameters.
+ * Set the TLS1 AAD from the parameter.
  *
- * @param [in, out] ctx     AEAD context object.
- * @param [in]      params  Array of parameters and values.
+ * @param [in, out] ctx  AEAD context object.
+ * @param [in]      p    Parameter. May be NULL.
  * @return  1 on success.
  * @return  0 on failure.
  */
-static int wp_aead_set_param_tls1_aad(wp_AeadCtx* ctx,
-    const OSSL_PARAM params[])
+static int wp_aead_set_param_tls1_aad(wp_AeadCtx* ctx, const OSSL_PARAM* p)
 {
     int ok = 1;
-    const OSSL_PARAM* p;
     size_t sz;
 
-    p = OSSL_PARAM_locate_const(params, OSSL_CIPHER_PARAM_AEAD_TLS1_AAD);
     if (p != NULL) {
         if (p->data_type != OSSL_PARAM_OCTET_STRING) {
             ok = 0;
@@ -473,20 +707,17 @@ static int wp_aead_set_param_tls1_aad(wp_AeadCtx* ctx,
 }
 
 /**
- * Set the TLS1 fixed IV from the parameters.
+ * Set the TLS1 fixed IV from the parameter.
  *
- * @param [in, out] ctx     AEAD context object.
- * @param [in]      params  Array of parameters and values.
+ * @param [in, out] ctx  AEAD context object.
+ * @param [in]      p    Parameter. May be NULL.
  * @return  1 on success.
  * @return  0 on failure.
  */
-static int wp_aead_set_param_tls1_iv_fixed(wp_AeadCtx* ctx,
-    const OSSL_PARAM params[])
+static int wp_aead_set_param_tls1_iv_fixed(wp_AeadCtx* ctx, const OSSL_PARAM* p)
 {
     int ok = 1;
-    const OSSL_PARAM* p;
 
-    p = OSSL_PARAM_locate_const(params, OSSL_CIPHER_PARAM_AEAD_TLS1_IV_FIXED);
     if (p != NULL) {
         if (p->data_type != OSSL_PARAM_OCTET_STRING) {
             ok = 0;
@@ -507,20 +738,17 @@ static int wp_aead_set_param_tls1_iv_fixed(wp_AeadCtx* ctx,
 }
 
 /**
- * Set a random IV with fixed part from the parameters.
+ * Set a random IV with fixed part from the parameter.
  *
- * @param [in, out] ctx     AEAD context object.
- * @param [in]      params  Array of parameters and values.
+ * @param [in, out] ctx  AEAD context object.
+ * @param [in]      p    Parameter. May be NULL.
  * @return  1 on success.
  * @return  0 on failure.
  */
-static int wp_aead_set_param_tls1_iv_rand(wp_AeadCtx* ctx,
-    const OSSL_PARAM params[])
+static int wp_aead_set_param_tls1_iv_rand(wp_AeadCtx* ctx, const OSSL_PARAM* p)
 {
     int ok = 1;
-    const OSSL_PARAM* p;
 
-    p = OSSL_PARAM_locate_const(params, OSSL_CIPHER_PARAM_AEAD_TLS1_SET_IV_INV);
     if (p != NULL) {
         if (p->data == NULL) {
             ok = 0;
@@ -536,6 +764,88 @@ static int wp_aead_set_param_tls1_iv_rand(wp_AeadCtx* ctx,
     return ok;
 }
 
+/**
+ * Set the TLS AADs of a batch of CCM records from the parameter.
+ *
+ * Each AAD is corrected for explicit IV and tag as for a single record.
+ *
+ * @param [in, out] ctx  AEAD context object.
+ * @param [in]      p    Parameter. May be NULL.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_aead_set_param_ccm_tls_batch(wp_AeadCtx* ctx,
+    const OSSL_PARAM* p)
+{
+    int ok = 1;
+    size_t cnt = 0;
+    size_t sz = 0;
+    size_t i;
+
+    if (p != NULL) {
+        if ((ctx->mode != EVP_CIPH_CCM_MODE) ||
+                (p->data_type != OSSL_PARAM_OCTET_STRING) ||
+                (p->data_size == 0) ||
+                (p->data_size % EVP_AEAD_TLS1_AAD_LEN != 0)) {
+            ok = 0;
+        }
+        if (ok) {
+            cnt = p->data_size / EVP_AEAD_TLS1_AAD_LEN;
+            if (cnt > WP_AESCCM_TLS_BATCH_MAX) {
+                ok = 0;
+            }
+        }
+        if (ok && (ctx->tlsBatchAad == NULL)) {
+            ctx->tlsBatchAad = (unsigned char*)OPENSSL_malloc(
+                WP_AESCCM_TLS_BATCH_MAX * EVP_AEAD_TLS1_AAD_LEN);
+            if (ctx->tlsBatchAad == NULL) {
+                ok = 0;
+            }
+        }
+        for (i = 0; ok && (i < cnt); i++) {
+            sz = wp_aead_tls_init(ctx,
+                (unsigned char*)p->data + i * EVP_AEAD_TLS1_AAD_LEN,
+                EVP_AEAD_TLS1_AAD_LEN);
+            if (sz == 0) {
+                ok = 0;
+            }
+            else {
+                XMEMCPY(ctx->tlsBatchAad + i * EVP_AEAD_TLS1_AAD_LEN,
+                    ctx->buf, EVP_AEAD_TLS1_AAD_LEN);
+            }
+        }
+        ctx->tlsBatchCnt = ok ? cnt : 0;
+        ctx->tlsAadPadSz = sz;
+    }
+
+    return ok;
+}
+
+/** Index of AEAD tag in parameters set. */
+#define WP_AEAD_PARAM_TAG               0
+/** Index of IV length in parameters set. */
+#define WP_AEAD_PARAM_IVLEN             1
+/** Index of TLS1 AAD in parameters set. */
+#define WP_AEAD_PARAM_TLS1_AAD          2
+/** Index of TLS1 fixed IV in parameters set. */
+#define WP_AEAD_PARAM_TLS1_IV_FIXED     3
+/** Index of TLS1 invocation IV in parameters set. */
+#define WP_AEAD_PARAM_TLS1_SET_IV_INV   4
+/** Index of CCM TLS batch AADs in parameters set. */
+#define WP_AEAD_PARAM_CCM_TLS_BATCH     5
+/** Number of parameters that can be set. */
+#define WP_AEAD_PARAM_CNT               6
+
+/** Keys of parameters that can be set, in order of index. */
+static const char* const wp_aead_param_keys[WP_AEAD_PARAM_CNT] = {
+    OSSL_CIPHER_PARAM_AEAD_TAG,
+    OSSL_CIPHER_PARAM_AEAD_IVLEN,
+    OSSL_CIPHER_PARAM_AEAD_TLS1_AAD,
+    OSSL_CIPHER_PARAM_AEAD_TLS1_IV_FIXED,
+    OSSL_CIPHER_PARAM_AEAD_TLS1_SET_IV_INV,
+    WP_CIPHER_PARAM_CCM_TLS_BATCH_AAD,
+};
+
 /**
  * Set the AEAD context parameters.
  *
@@ -547,22 +857,32 @@ static int wp_aead_set_param_tls1_iv_rand(wp_AeadCtx* ctx,
 static int wp_aead_set_ctx_params(wp_AeadCtx* ctx, const OSSL_PARAM params[])
 {
     int ok = 1;
+    const OSSL_PARAM* p[WP_AEAD_PARAM_CNT];
 
     if (params != NULL) {
-        if ((!wp_aead_set_param_tag(ctx, params))) {
+        wp_params_index(params, wp_aead_param_keys, WP_AEAD_PARAM_CNT, p);
+
+        if ((!wp_aead_set_param_tag(ctx, p[WP_AEAD_PARAM_TAG]))) {
             ok = 0;
         }
-        if (ok && (!wp_aead_set_param_iv_len(ctx, params))) {
+        if (ok && (!wp_aead_set_param_iv_len(ctx, p[WP_AEAD_PARAM_IVLEN]))) {
             ok = 0;
         }
-        if (ok && (!wp_aead_set_param_tls1_aad(ctx, params))) {
+        if (ok && (!wp_aead_set_param_tls1_aad(ctx,
+                p[WP_AEAD_PARAM_TLS1_AAD]))) {
             ok = 0;
         }
-        if (ok && (!wp_aead_set_param_tls1_iv_fixed(ctx, params))) {
+        if (ok && (!wp_aead_set_param_tls1_iv_fixed(ctx,
+                p[WP_AEAD_PARAM_TLS1_IV_FIXED]))) {
             ok = 0;
         }
         if (ok && (ctx->mode == EVP_CIPH_GCM_MODE) &&
-                (!wp_aead_set_param_tls1_iv_rand(ctx, params))) {
+                (!wp_aead_set_param_tls1_iv_rand(ctx,
+                    p[WP_AEAD_PARAM_TLS1_SET_IV_INV]))) {
+            ok = 0;
+        }
+        if (ok && (!wp_aead_set_param_ccm_tls_batch(ctx,
+                p[WP_AEAD_PARAM_CCM_TLS_BATCH]))) {
             ok = 0;
         }
     }
@@ -683,6 +1003,7 @@ static const OSSL_PARAM *wp_aead_gettable_ctx_params(wp_AeadCtx* ctx,
         OSSL_PARAM_size_t(OSSL_CIPHER_PARAM_AEAD_TLS1_AAD_PAD, NULL),
         OSSL_PARAM_octet_string(OSSL_CIPHER_PARAM_AEAD_TLS1_GET_IV_GEN, NULL,
             0),
+        OSSL_PARAM_octet_string(WP_CIPHER_PARAM_CCM_TLS_BATCH_RESULT, NULL, 0),
         OSSL_PARAM_END
     };
     (void)ctx;
@@ -710,6 +1031,7 @@ static const OSSL_PARAM *wp_aead_settable_ctx_params(wp_AeadCtx* ctx,
         OSSL_PARAM_octet_string(OSSL_CIPHER_PARAM_AEAD_TLS1_IV_FIXED, NULL, 0),
         OSSL_PARAM_octet_string(OSSL_CIPHER_PARAM_AEAD_TLS1_SET_IV_INV, NULL,
             0),
+        OSSL_PARAM_octet_string(WP_CIPHER_PARAM_CCM_TLS_BATCH_AAD, NULL, 0),
         OSSL_PARAM_END
     };
     (void)ctx;
@@ -722,12 +1044,31 @@ static const OSSL_PARAM *wp_aead_settable_ctx_params(wp_AeadCtx* ctx,
  * AES-GCM
  */
 
+/**
+ * Increment the invocation field of the IV/nonce.
+ *
+ * @param [in, out] ctx  AEAD context object.
+ */
+static void wp_aesgcm_inc_iv(wp_AeadCtx* ctx)
+{
+    int i;
+    unsigned char* p = ctx->iv + ctx->ivLen - 8;
+
+    for (i = 7; i >= 0 && (++p[i]) == 0; i--) {
+        /* Nothing to do. */
+    }
+}
+
 /**
  * Get the random part of the IV/nonce.
  *
  * FIPS 140 requires the encryptor to generate a random part for the IV.
  * This has to be sent to the other side.
  *
+ * The wolfSSL object's invocation counter is advanced so that each call gets
+ * a new IV/nonce. Without streaming, the IV/nonce is advanced by the caller
+ * after use.
+ *
  * @param [in, out] ctx   AEAD context object.
  * @param [out]     out   Buffer to hold random part of IV.
  * @param [in]      olen  Length of random in bytes.
@@ -744,15 +1085,18 @@ static int wp_aesgcm_get_rand_iv(wp_AeadCtx* ctx, unsigned char* out,
     if ((!ctx->ivGen) || (!ctx->keySet)) {
         ok = 0;
     }
+#ifdef WOLFSSL_AESGCM_STREAM
     if (ok) {
         int rc;
 
+        /* Copies out current IV/nonce and increments invocation counter. */
         rc = wc_AesGcmEncryptInit_ex(&ctx->aes, NULL, 0, ctx->iv,
             ctx->ivLen);
         if (rc != 0) {
             ok = 0;
         }
     }
+#endif
     if (ok) {
         /* Use all the IV/nonce length if none specified or too much. */
         if ((olen == 0) || (olen > ctx->ivLen)) {
@@ -760,12 +1104,7 @@ static int wp_aesgcm_get_rand_iv(wp_AeadCtx* ctx, unsigned char* out,
         }
         XMEMCPY(out, ctx->iv + ctx->ivLen - olen, olen);
         if (inc) {
-            int i;
-            unsigned char* p = ctx->iv + ctx->ivLen - 8;
-
-            for (i = 7; i >= 0 && (++p[i]) == 0; i--) {
-                /* Nothing to do. */
-            }
+            wp_aesgcm_inc_iv(ctx);
         }
         ctx->ivState = IV_STATE_COPIED;
     }
@@ -830,22 +1169,17 @@ static int wp_aesgcm_tls_iv_set_fixed(wp_AeadCtx* ctx, unsigned char* iv,
         }
         if (ctx->enc) {
             int rc;
+            WC_RNG* rng = wp_provctx_get_rng(ctx->provCtx);
 
-        #ifndef WP_SINGLE_THREADED
-            if (!wp_provctx_lock_rng(ctx->provCtx)) {
+            if (rng == NULL) {
                 ok = 0;
             }
-        #endif
             if (ok) {
-                rc = wc_AesGcmSetIV(&ctx->aes, ctx->ivLen, iv, len,
-                    wp_provctx_get_rng(ctx->provCtx));
+                rc = wc_AesGcmSetIV(&ctx->aes, ctx->ivLen, iv, len, rng);
                 if (rc != 0) {
                     ok = 0;
                 }
             }
-        #ifndef WP_SINGLE_THREADED
-            wp_provctx_unlock_rng(ctx->provCtx);
-        #endif
             if (ok && len > 0) {
                 XMEMCPY(ctx->iv, ctx->aes.reg, ctx->ivLen);
                 ctx->ivSet = 1;
@@ -861,6 +1195,37 @@ static int wp_aesgcm_tls_iv_set_fixed(wp_AeadCtx* ctx, unsigned char* iv,
     return ok;
 }
 
+/**
+ * Check whether the key has already been expanded into the AES GCM object.
+ *
+ * Re-initializing with the same key, as done for each message, need not
+ * compute the AES key schedule and GHASH table again.
+ * When a different key is passed, the remembered key is forgotten as the
+ * object is about to be re-keyed.
+ *
+ * @param [in, out] ctx     AEAD context object.
+ * @param [in]      key     Private key. May be NULL.
+ * @param [in]      keyLen  Length of key in bytes.
+ * @return  1 when key already expanded.
+ * @return  0 otherwise.
+ */
+static int wp_aesgcm_key_expanded(wp_AeadCtx* ctx, const unsigned char *key,
+    size_t keyLen)
+{
+    int expanded = 0;
+
+    if (key != NULL) {
+        expanded = (ctx->expKeyLen != 0) && (keyLen == ctx->expKeyLen) &&
+                   (CRYPTO_memcmp(key, ctx->expKey, keyLen) == 0);
+        if (!expanded) {
+            OPENSSL_cleanse(ctx->expKey, sizeof(ctx->expKey));
+            ctx->expKeyLen = 0;
+        }
+    }
+
+    return expanded;
+}
+
 /**
  * Initialize AES GCM cipher for encryption.
  *
@@ -889,6 +1254,11 @@ static int wp_aesgcm_einit(wp_AeadCtx* ctx, const unsigned char *key,
     if (ok) {
         int rc;
 
+        if (wp_aesgcm_key_expanded(ctx, key, keyLen)) {
+            /* Keep key schedule and GHASH table already computed. */
+            key = NULL;
+            ctx->keySet = 1;
+        }
         if (ivLen == 0) {
             if (key != NULL) {
                 rc = wc_AesGcmSetKey(aes, key, keyLen);
@@ -908,13 +1278,29 @@ static int wp_aesgcm_einit(wp_AeadCtx* ctx, const unsigned char *key,
                 ctx->ivSet = 0;
             }
         }
+        if (ok && (key != NULL)) {
+            wp_aead_key_store(ctx, key, keyLen);
+        }
     }
 #else
+    if (ok && wp_aesgcm_key_expanded(ctx, key, keyLen)) {
+        /* Keep key schedule and GHASH table already computed. */
+        ctx->keySet = 1;
+        key = NULL;
+    }
     if (ok && (key != NULL)) {
         int rc = wc_AesGcmSetKey(aes, key, keyLen);
         if (rc != 0) {
             ok = 0;
         }
+    #ifdef WP_AESGCM_INCREMENTAL
+        if (ok) {
+            ok = wp_aesgcm_inc_set_key(ctx);
+        }
+    #endif
+        if (ok) {
+            wp_aead_key_store(ctx, key, keyLen);
+        }
     }
     if (ok && (iv != NULL)) {
         if (ivLen != ctx->ivLen) {
@@ -926,6 +1312,9 @@ static int wp_aesgcm_einit(wp_AeadCtx* ctx, const unsigned char *key,
             ctx->ivSet = 0;
         }
     }
+#ifdef WP_AESGCM_INCREMENTAL
+    ctx->gcm.started = 0;
+#endif
 #endif
     if (ok) {
         ctx->enc = 1;
@@ -962,20 +1351,41 @@ static int wp_aesgcm_dinit(wp_AeadCtx *ctx, const unsigned char *key,
         ok = 0;
     }
 #ifdef WOLFSSL_AESGCM_STREAM
+    if (ok && wp_aesgcm_key_expanded(ctx, key, keyLen)) {
+        /* Keep key schedule and GHASH table already computed. */
+        key = NULL;
+        ctx->keySet = 1;
+    }
     if (ok && (wc_AesGcmDecryptInit(aes, key, keyLen, iv, ivLen) != 0)) {
         ok = 0;
     }
+    if (ok && (key != NULL)) {
+        wp_aead_key_store(ctx, key, keyLen);
+    }
     if (ok) {
         XMEMCPY(ctx->iv, iv, ivLen);
         ctx->ivState = IV_STATE_BUFFERED;
         ctx->ivSet = 0;
     }
 #else
+    if (ok && wp_aesgcm_key_expanded(ctx, key, keyLen)) {
+        /* Keep key schedule and GHASH table already computed. */
+        ctx->keySet = 1;
+        key = NULL;
+    }
     if (ok && (key != NULL)) {
         int rc = wc_AesGcmSetKey(aes, key, keyLen);
         if (rc != 0) {
             ok = 0;
         }
+    #ifdef WP_AESGCM_INCREMENTAL
+        if (ok) {
+            ok = wp_aesgcm_inc_set_key(ctx);
+        }
+    #endif
+        if (ok) {
+            wp_aead_key_store(ctx, key, keyLen);
+        }
     }
     if (ok && (iv != NULL)) {
         if (ivLen != ctx->ivLen) {
@@ -987,6 +1397,9 @@ static int wp_aesgcm_dinit(wp_AeadCtx *ctx, const unsigned char *key,
             ctx->ivSet = 0;
         }
     }
+#ifdef WP_AESGCM_INCREMENTAL
+    ctx->gcm.started = 0;
+#endif
 #endif
     if (ok) {
         ctx->enc = 0;
@@ -1014,6 +1427,7 @@ static int wp_aesgcm_tls_cipher(wp_AeadCtx* ctx, unsigned char* out,
 {
     int ok = 1;
     size_t oLen = 0;
+    word64 mStart = wp_metrics_start();
 
     if (!wolfssl_prov_is_running() || !ctx->keySet) {
         ok = 0;
@@ -1056,6 +1470,10 @@ static int wp_aesgcm_tls_cipher(wp_AeadCtx* ctx, unsigned char* out,
             if (rc != 0) {
                 ok = 0;
             }
+        #ifndef WOLFSSL_AESGCM_STREAM
+            /* Never use the same IV/nonce for the next record. */
+            wp_aesgcm_inc_iv(ctx);
+        #endif
         }
         else {
             rc = wc_AesGcmDecrypt(&ctx->aes, out, in, len, ctx->iv,
@@ -1072,6 +1490,7 @@ static int wp_aesgcm_tls_cipher(wp_AeadCtx* ctx, unsigned char* out,
         if (ctx->enc) {
             oLen += EVP_GCM_TLS_EXPLICIT_IV_LEN + EVP_GCM_TLS_TAG_LEN;
         }
+        wp_metrics_record(WP_METRIC_AES_GCM_TLS, mStart, len);
     }
 
     ctx->ivState = IV_STATE_FINISHED;
@@ -1201,52 +1620,501 @@ static int wp_aesgcm_stream_final(wp_AeadCtx *ctx, unsigned char *out,
 
     return ok;
 }
-#else
+#elif defined(WP_AESGCM_INCREMENTAL)
+
+/** Reduction values for 4-bit GHASH multiplication. */
+static const word64 wp_gcm_last4[16] = {
+    0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+    0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0
+};
 
 /**
- * Encrypt/decrypt the data using AES-GCM.
+ * Load a big-endian 64-bit value.
  *
- * @param [in, out] ctx      AEAD context object.
- * @param [out]     out      Buffer to hold decrypted/encrypted data.
- * @param [in]      in       Data to be encrypted/decrypted.
- * @param [in]      inLen    Length of data to be encrypted/decrypted.
+ * @param [in] a  Array of 8 bytes.
+ * @return  64-bit value.
+ */
+static word64 wp_gcm_load64(const byte* a)
+{
+    return ((word64)a[0] << 56) | ((word64)a[1] << 48) |
+           ((word64)a[2] << 40) | ((word64)a[3] << 32) |
+           ((word64)a[4] << 24) | ((word64)a[5] << 16) |
+           ((word64)a[6] <<  8) | ((word64)a[7] <<  0);
+}
+
+/**
+ * Store a 64-bit value big-endian.
+ *
+ * @param [out] a  Array of 8 bytes.
+ * @param [in]  v  64-bit value.
+ */
+static void wp_gcm_store64(byte* a, word64 v)
+{
+    int i;
+
+    for (i = 7; i >= 0; i--) {
+        a[i] = (byte)v;
+        v >>= 8;
+    }
+}
+
+/**
+ * Set the hash key from the AES key and compute GHASH table.
+ *
+ * @param [in, out] ctx  AEAD context object. AES key set.
  * @return  1 on success.
  * @return  0 on failure.
  */
-static int wp_aesgcm_encdec(wp_AeadCtx *ctx, unsigned char *out,
-    const unsigned char *in, size_t inLen)
+static int wp_aesgcm_inc_set_key(wp_AeadCtx* ctx)
 {
     int ok = 1;
-    int rc;
-
-    if (ctx->tagLen == UNINITIALISED_SIZET) {
-        ctx->tagLen = EVP_GCM_TLS_TAG_LEN;
+    wp_GcmState* gcm = &ctx->gcm;
+    byte h[AES_BLOCK_SIZE];
+    word64 vh;
+    word64 vl;
+    int i;
+    int j;
+
+    XMEMSET(h, 0, sizeof(h));
+    if (wc_AesEncryptDirect(&ctx->aes, h, h) != 0) {
+        ok = 0;
     }
-
-    if (ctx->enc) {
-        if (!ctx->ivSet) {
-            rc = wc_AesGcmSetExtIV(&ctx->aes, ctx->iv, ctx->ivLen);
-            if (rc != 0) {
-                ok = 0;
-            }
-        }
-        if (ok) {
-            ctx->ivSet = 1;
-            /* IV coming out in this call. */
-            rc = wc_AesGcmEncrypt_ex(&ctx->aes, out, in, (word32)inLen,
-                ctx->iv, ctx->ivLen, ctx->buf, ctx->tagLen, ctx->aad,
-                ctx->aadLen);
-            if (rc != 0) {
-                ok = 0;
+    if (ok) {
+        vh = wp_gcm_load64(h);
+        vl = wp_gcm_load64(h + 8);
+        gcm->hh[0] = 0;
+        gcm->hl[0] = 0;
+        gcm->hh[8] = vh;
+        gcm->hl[8] = vl;
+        for (i = 4; i > 0; i >>= 1) {
+            word64 t = (vl & 1) * (word64)0xe1000000U;
+            vl = (vh << 63) | (vl >> 1);
+            vh = (vh >> 1) ^ (t << 32);
+            gcm->hh[i] = vh;
+            gcm->hl[i] = vl;
+        }
+        for (i = 2; i <= 8; i *= 2) {
+            vh = gcm->hh[i];
+            vl = gcm->hl[i];
+            for (j = 1; j < i; j++) {
+                gcm->hh[i + j] = vh ^ gcm->hh[j];
+                gcm->hl[i + j] = vl ^ gcm->hl[j];
             }
         }
     }
-    else {
-        rc = wc_AesGcmDecrypt(&ctx->aes, out, in, (word32)inLen,
-            ctx->iv, ctx->ivLen, ctx->buf, ctx->tagLen, ctx->aad,
-            ctx->aadLen);
-        if (rc == AES_GCM_AUTH_E) {
-            ctx->authErr = 1;
+    OPENSSL_cleanse(h, sizeof(h));
+
+    return ok;
+}
+
+/**
+ * Multiply running GHASH value by hash key H.
+ *
+ * @param [in, out] gcm  GCM state.
+ */
+static void wp_gcm_gmult(wp_GcmState* gcm)
+{
+    byte* x = gcm->x;
+    word64 zh;
+    word64 zl;
+    byte rem;
+    byte lo;
+    byte hi;
+    int i;
+
+    lo = x[15] & 0xf;
+    zh = gcm->hh[lo];
+    zl = gcm->hl[lo];
+    for (i = 15; i >= 0; i--) {
+        lo = x[i] & 0xf;
+        hi = (x[i] >> 4) & 0xf;
+        if (i != 15) {
+            rem = (byte)zl & 0xf;
+            zl = (zh << 60) | (zl >> 4);
+            zh = (zh >> 4) ^ (wp_gcm_last4[rem] << 48);
+            zh ^= gcm->hh[lo];
+            zl ^= gcm->hl[lo];
+        }
+        rem = (byte)zl & 0xf;
+        zl = (zh << 60) | (zl >> 4);
+        zh = (zh >> 4) ^ (wp_gcm_last4[rem] << 48);
+        zh ^= gcm->hh[hi];
+        zl ^= gcm->hl[hi];
+    }
+    wp_gcm_store64(x, zh);
+    wp_gcm_store64(x + 8, zl);
+}
+
+/**
+ * Absorb data into running GHASH value.
+ *
+ * @param [in, out] gcm   GCM state.
+ * @param [in]      data  Data to absorb.
+ * @param [in]      len   Length of data in bytes.
+ */
+static void wp_gcm_ghash_update(wp_GcmState* gcm, const byte* data,
+    size_t len)
+{
+    while (len > 0) {
+        size_t n = AES_BLOCK_SIZE - gcm->xLen;
+        size_t i;
+
+        if (n > len) {
+            n = len;
+        }
+        for (i = 0; i < n; i++) {
+            gcm->x[gcm->xLen + i] ^= data[i];
+        }
+        gcm->xLen += (word32)n;
+        data += n;
+        len -= n;
+        if (gcm->xLen == AES_BLOCK_SIZE) {
+            wp_gcm_gmult(gcm);
+            gcm->xLen = 0;
+        }
+    }
+}
+
+/**
+ * Complete a partial block of running GHASH value - implicit zero padding.
+ *
+ * @param [in, out] gcm   GCM state.
+ */
+static void wp_gcm_ghash_flush(wp_GcmState* gcm)
+{
+    if (gcm->xLen > 0) {
+        wp_gcm_gmult(gcm);
+        gcm->xLen = 0;
+    }
+}
+
+/**
+ * Increment the last 32 bits of the counter block.
+ *
+ * @param [in, out] ctr  Counter block.
+ */
+static void wp_gcm_inc32(byte* ctr)
+{
+    int i;
+
+    for (i = AES_BLOCK_SIZE - 1; i >= AES_BLOCK_SIZE - 4; i--) {
+        if (++ctr[i] != 0) {
+            break;
+        }
+    }
+}
+
+/**
+ * Start an incremental GCM operation by processing the IV/nonce.
+ *
+ * When encrypting, the IV/nonce may have been generated by wolfSSL and is
+ * taken from the AES object as wc_AesGcmEncrypt_ex() does.
+ *
+ * @param [in, out] ctx  AEAD context object.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_aesgcm_inc_start(wp_AeadCtx* ctx)
+{
+    int ok = 1;
+    wp_GcmState* gcm = &ctx->gcm;
+
+    if (ctx->enc) {
+        if ((!ctx->ivSet) &&
+                (wc_AesGcmSetExtIV(&ctx->aes, ctx->iv, ctx->ivLen) != 0)) {
+            ok = 0;
+        }
+        if (ok) {
+            ctx->ivSet = 1;
+            XMEMCPY(ctx->iv, ctx->aes.reg, ctx->ivLen);
+        }
+    }
+    if (ok) {
+        XMEMSET(gcm->x, 0, sizeof(gcm->x));
+        gcm->xLen = 0;
+        if (ctx->ivLen == GCM_NONCE_MID_SZ) {
+            XMEMCPY(gcm->j0, ctx->iv, ctx->ivLen);
+            XMEMSET(gcm->j0 + ctx->ivLen, 0, AES_BLOCK_SIZE - ctx->ivLen);
+            gcm->j0[AES_BLOCK_SIZE - 1] = 1;
+        }
+        else {
+            byte lenBlock[AES_BLOCK_SIZE];
+
+            /* J0 = GHASH(IV || 0s || [len(IV)]64) */
+            wp_gcm_ghash_update(gcm, ctx->iv, ctx->ivLen);
+            wp_gcm_ghash_flush(gcm);
+            XMEMSET(lenBlock, 0, 8);
+            wp_gcm_store64(lenBlock + 8, (word64)ctx->ivLen * 8);
+            wp_gcm_ghash_update(gcm, lenBlock, sizeof(lenBlock));
+            XMEMCPY(gcm->j0, gcm->x, AES_BLOCK_SIZE);
+            XMEMSET(gcm->x, 0, sizeof(gcm->x));
+        }
+        XMEMCPY(gcm->ctr, gcm->j0, AES_BLOCK_SIZE);
+        gcm->aadLen = 0;
+        gcm->ctLen = 0;
+        gcm->ksUsed = AES_BLOCK_SIZE;
+        gcm->inData = 0;
+        gcm->started = 1;
+        ctx->authErr = 0;
+    }
+
+    return ok;
+}
+
+/**
+ * Encrypt/decrypt more data with incremental GCM.
+ *
+ * Cipher text is hashed as it is produced or consumed. Supports in-place.
+ *
+ * @param [in, out] ctx    AEAD context object.
+ * @param [out]     out    Buffer to hold encrypted/decrypted data.
+ * @param [in]      in     Data to be encrypted/decrypted.
+ * @param [in]      inLen  Length of data to be encrypted/decrypted.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_aesgcm_inc_crypt(wp_AeadCtx* ctx, unsigned char* out,
+    const unsigned char* in, size_t inLen)
+{
+    int ok = 1;
+    wp_GcmState* gcm = &ctx->gcm;
+
+    if (!gcm->inData) {
+        wp_gcm_ghash_flush(gcm);
+        gcm->inData = 1;
+    }
+    gcm->ctLen += inLen;
+    while (ok && (inLen > 0)) {
+        size_t n;
+        size_t i;
+
+        if (gcm->ksUsed == AES_BLOCK_SIZE) {
+            wp_gcm_inc32(gcm->ctr);
+            if (wc_AesEncryptDirect(&ctx->aes, gcm->ks, gcm->ctr) != 0) {
+                ok = 0;
+                break;
+            }
+            gcm->ksUsed = 0;
+        }
+        n = AES_BLOCK_SIZE - gcm->ksUsed;
+        if (n > inLen) {
+            n = inLen;
+        }
+        if (!ctx->enc) {
+            wp_gcm_ghash_update(gcm, in, n);
+        }
+        for (i = 0; i < n; i++) {
+            out[i] = in[i] ^ gcm->ks[gcm->ksUsed + i];
+        }
+        if (ctx->enc) {
+            wp_gcm_ghash_update(gcm, out, n);
+        }
+        gcm->ksUsed += (word32)n;
+        in += n;
+        out += n;
+        inLen -= n;
+    }
+
+    return ok;
+}
+
+/**
+ * Finish incremental GCM - calculate tag and check when decrypting.
+ *
+ * @param [in, out] ctx  AEAD context object.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_aesgcm_inc_final(wp_AeadCtx* ctx)
+{
+    int ok = 1;
+    wp_GcmState* gcm = &ctx->gcm;
+    byte lenBlock[AES_BLOCK_SIZE];
+    byte tag[AES_BLOCK_SIZE];
+    size_t i;
+
+    wp_gcm_ghash_flush(gcm);
+    wp_gcm_store64(lenBlock, gcm->aadLen * 8);
+    wp_gcm_store64(lenBlock + 8, gcm->ctLen * 8);
+    wp_gcm_ghash_update(gcm, lenBlock, sizeof(lenBlock));
+    if (wc_AesEncryptDirect(&ctx->aes, tag, gcm->j0) != 0) {
+        ok = 0;
+    }
+    if (ok) {
+        for (i = 0; i < AES_BLOCK_SIZE; i++) {
+            tag[i] ^= gcm->x[i];
+        }
+        if (ctx->enc) {
+            int j;
+            byte* iv = (byte*)ctx->aes.reg;
+
+            XMEMCPY(ctx->buf, tag, AES_BLOCK_SIZE);
+            /* Next generated IV/nonce, as wc_AesGcmEncrypt_ex() does. */
+            for (j = (int)ctx->ivLen - 1; j >= 0; j--) {
+                if (++iv[j] != 0) {
+                    break;
+                }
+            }
+        }
+        else {
+            if ((ctx->tagLen > AES_BLOCK_SIZE) ||
+                    (CRYPTO_memcmp(tag, ctx->buf, ctx->tagLen) != 0)) {
+                ctx->authErr = 1;
+                ok = 0;
+            }
+            XMEMCPY(ctx->iv, ctx->aes.reg, ctx->ivLen);
+        }
+    }
+    OPENSSL_cleanse(tag, sizeof(tag));
+    gcm->started = 0;
+
+    return ok;
+}
+
+/**
+ * Streaming update of AES GCM cipher.
+ *
+ * @param [in, out] ctx      AEAD context object.
+ * @param [out]     out      Buffer to hold encrypted/decrypted data.
+ * @param [out]     outLen   Length of data in output buffer.
+ * @param [in]      outSize  Size of output buffer in bytes.
+ * @param [in]      in       Data to be encrypted/decrypted.
+ * @param [in]      inLen    Length of data to be encrypted/decrypted.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_aesgcm_stream_update(wp_AeadCtx *ctx, unsigned char *out,
+    size_t *outLen, size_t outSize, const unsigned char *in, size_t inLen)
+{
+    int ok = 1;
+
+    if (ctx->tlsAadLen != UNINITIALISED_SIZET) {
+        ok = wp_aesgcm_tls_cipher(ctx, out, outLen, in, inLen);
+    }
+    else {
+        size_t oLen = 0;
+
+        if ((out == NULL) && (in == NULL)) {
+            /* Nothing to do. */
+            oLen = inLen;
+        }
+        else if ((out != NULL) && (outSize < inLen)) {
+            ok = 0;
+        }
+        else if (inLen > 0) {
+            if ((!ctx->gcm.started) && (!wp_aesgcm_inc_start(ctx))) {
+                ok = 0;
+            }
+            if (ok && (out == NULL)) {
+                /* AAD only. */
+                if (ctx->gcm.inData) {
+                    ok = 0;
+                }
+                else {
+                    wp_gcm_ghash_update(&ctx->gcm, in, inLen);
+                    ctx->gcm.aadLen += inLen;
+                }
+            }
+            else if (ok) {
+                ok = wp_aesgcm_inc_crypt(ctx, out, in, inLen);
+            }
+            if (ok) {
+                oLen = inLen;
+            }
+        }
+
+        *outLen = oLen;
+    }
+
+    return ok;
+}
+
+/**
+ * Streaming final of AES GCM cipher.
+ *
+ * @param [in, out] ctx      AEAD context object.
+ * @param [out]     out      Buffer to hold encrypted/decrypted data.
+ * @param [out]     outLen   Length of data in output buffer.
+ * @param [in]      outSize  Size of output buffer in bytes.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_aesgcm_stream_final(wp_AeadCtx *ctx, unsigned char *out,
+    size_t *outLen, size_t outSize)
+{
+    int ok = 1;
+    (void)outSize;
+
+    if (ctx->tlsAadLen != UNINITIALISED_SIZET) {
+        ok = wp_aesgcm_tls_cipher(ctx, out, outLen, NULL, 0);
+    }
+    else {
+        if ((!ctx->enc) && (ctx->tagLen == UNINITIALISED_SIZET)) {
+            ok = 0;
+        }
+        if (ok && (ctx->tagLen == UNINITIALISED_SIZET)) {
+            ctx->tagLen = EVP_GCM_TLS_TAG_LEN;
+        }
+        if (ok && (!ctx->gcm.started) && (!wp_aesgcm_inc_start(ctx))) {
+            ok = 0;
+        }
+        if (ok) {
+            ok = wp_aesgcm_inc_final(ctx);
+        }
+        ctx->ivSet = 0;
+        ctx->ivState = IV_STATE_FINISHED;
+        *outLen = 0;
+    }
+
+    return ok;
+}
+
+#else
+
+/**
+ * Encrypt/decrypt the data using AES-GCM.
+ *
+ * @param [in, out] ctx      AEAD context object.
+ * @param [out]     out      Buffer to hold decrypted/encrypted data.
+ * @param [in]      in       Data to be encrypted/decrypted.
+ * @param [in]      inLen    Length of data to be encrypted/decrypted.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_aesgcm_encdec(wp_AeadCtx *ctx, unsigned char *out,
+    const unsigned char *in, size_t inLen)
+{
+    int ok = 1;
+    int rc;
+
+    if (ctx->tagLen == UNINITIALISED_SIZET) {
+        ctx->tagLen = EVP_GCM_TLS_TAG_LEN;
+    }
+
+    if (ctx->enc) {
+        if (!ctx->ivSet) {
+            rc = wc_AesGcmSetExtIV(&ctx->aes, ctx->iv, ctx->ivLen);
+            if (rc != 0) {
+                ok = 0;
+            }
+        }
+        if (ok) {
+            ctx->ivSet = 1;
+            /* IV coming out in this call. */
+            rc = wc_AesGcmEncrypt_ex(&ctx->aes, out, in, (word32)inLen,
+                ctx->iv, ctx->ivLen, ctx->buf, ctx->tagLen, ctx->aad,
+                ctx->aadLen);
+            if (rc != 0) {
+                ok = 0;
+            }
+        }
+    }
+    else {
+        rc = wc_AesGcmDecrypt(&ctx->aes, out, in, (word32)inLen,
+            ctx->iv, ctx->ivLen, ctx->buf, ctx->tagLen, ctx->aad,
+            ctx->aadLen);
+        if (rc == AES_GCM_AUTH_E) {
+            ctx->authErr = 1;
             rc = 0;
         }
         if (rc != 0) {
@@ -1257,10 +2125,7 @@ static int wp_aesgcm_encdec(wp_AeadCtx *ctx, unsigned char *out,
         }
     }
 
-    OPENSSL_free(ctx->aad);
-    ctx->aad = NULL;
-    ctx->aadLen = 0;
-    ctx->aadSet = 0;
+    wp_aead_clear_aad(ctx);
 
     return ok;
 }
@@ -1411,7 +2276,7 @@ static void *wp_aes_gcm_newctx(WOLFPROV_CTX* provCtx, size_t keyBits)
         ctx->tagLen = UNINITIALISED_SIZET;
         ctx->mode = EVP_CIPH_GCM_MODE;
 
-        if (wc_AesInit(&ctx->aes, NULL, INVALID_DEVID) != 0) {
+        if (wc_AesInit(&ctx->aes, NULL, provCtx->devId) != 0) {
             OPENSSL_free(ctx);
             ctx = NULL;
         }
@@ -1426,8 +2291,9 @@ static void *wp_aes_gcm_newctx(WOLFPROV_CTX* provCtx, size_t keyBits)
  */
 static void wp_aes_gcm_freectx(wp_AeadCtx* ctx)
 {
+    wp_aead_clear_aad(ctx);
     wc_AesFree(&ctx->aes);
-    OPENSSL_free(ctx);
+    OPENSSL_clear_free(ctx, sizeof(*ctx));
 }
 
 
@@ -1495,6 +2361,9 @@ static int wp_aesccm_init(wp_AeadCtx* ctx, const unsigned char *key,
         if (rc != 0) {
             ok = 0;
         }
+        if (ok) {
+            wp_aead_key_store(ctx, key, keyLen);
+        }
     }
     if (ok && (iv != NULL)) {
         if (ivLen != ctx->ivLen) {
@@ -1557,6 +2426,245 @@ static int wp_aesccm_dinit(wp_AeadCtx* ctx, const unsigned char* key,
 }
 
 
+#ifdef WP_AESCCM_INTERLEAVED
+/**
+ * Increment a big-endian number.
+ *
+ * @param [in, out] a    Number to increment.
+ * @param [in]      len  Length of number in bytes.
+ */
+static void wp_aesccm_inc(unsigned char* a, size_t len)
+{
+    size_t i;
+
+    for (i = len; i > 0; i--) {
+        if (++a[i - 1] != 0) {
+            break;
+        }
+    }
+}
+
+/**
+ * Encrypt/decrypt and authenticate data with AES-CCM in a single pass.
+ *
+ * The CBC-MAC block and the counter block of each step are independent and
+ * are encrypted with one ECB call so that the AES implementation can
+ * pipeline them. The counter block for a data block is encrypted a step ahead
+ * so that, when decrypting, the plaintext is available to MAC.
+ *
+ * Nonce is ctx->iv of ctx->ivLen bytes.
+ *
+ * @param [in, out] ctx     AEAD context object.
+ * @param [out]     out     Buffer to hold encrypted/decrypted data.
+ * @param [in]      in      Data to be encrypted/decrypted. May be same as out.
+ * @param [in]      len     Length of data in bytes.
+ * @param [in]      aad     Additional authentication data.
+ * @param [in]      aadLen  Length of AAD in bytes.
+ * @param [in, out] tag     Tag calculated when encrypting. Tag to check when
+ *                          decrypting.
+ * @return  1 on success.
+ * @return  0 on failure, including the tag not matching. Output zeroized.
+ */
+static int wp_aesccm_one_pass(wp_AeadCtx* ctx, unsigned char* out,
+    const unsigned char* in, size_t len, const unsigned char* aad,
+    size_t aadLen, unsigned char* tag)
+{
+    int ok = 1;
+    int rc;
+    /* Lane 0: CBC-MAC, lane 1: key stream, lane 2: first key stream block. */
+    unsigned char blk[3 * AES_BLOCK_SIZE];
+    unsigned char ctr[AES_BLOCK_SIZE];
+    unsigned char s0[AES_BLOCK_SIZE];
+    unsigned char* x = blk;
+    unsigned char* ks = blk + AES_BLOCK_SIZE;
+    size_t q = AES_BLOCK_SIZE - 1 - ctx->ivLen;
+    size_t i;
+    size_t j;
+    size_t n;
+    size_t pos;
+
+    /* Nonce: 7..13 bytes, tag: 4..16 bytes and even. */
+    if ((ctx->ivLen < 7) || (ctx->ivLen > 13) || (ctx->tagLen < 4) ||
+            (ctx->tagLen > AES_BLOCK_SIZE) || ((ctx->tagLen & 1) != 0)) {
+        ok = 0;
+    }
+    /* Length must fit in q bytes. */
+    if (ok && (q < sizeof(size_t)) && ((len >> (8 * q)) != 0)) {
+        ok = 0;
+    }
+    if (ok && ((word64)aadLen > 0xffffffffUL)) {
+        ok = 0;
+    }
+
+    if (ok) {
+        /* B0: flags, nonce and message length. */
+        x[0] = (unsigned char)(((aadLen > 0) ? 0x40 : 0x00) |
+            (((ctx->tagLen - 2) / 2) << 3) | (q - 1));
+        XMEMCPY(x + 1, ctx->iv, ctx->ivLen);
+        for (i = 0, n = len; i < q; i++, n >>= 8) {
+            x[AES_BLOCK_SIZE - 1 - i] = (unsigned char)n;
+        }
+        /* Counter block 0 encrypts tag, counter block 1 the first block. */
+        XMEMSET(ctr, 0, sizeof(ctr));
+        ctr[0] = (unsigned char)(q - 1);
+        XMEMCPY(ctr + 1, ctx->iv, ctx->ivLen);
+        XMEMCPY(ks, ctr, AES_BLOCK_SIZE);
+        wp_aesccm_inc(ctr, AES_BLOCK_SIZE);
+        XMEMCPY(blk + 2 * AES_BLOCK_SIZE, ctr, AES_BLOCK_SIZE);
+
+        rc = wc_AesEcbEncrypt(&ctx->aes, blk, blk,
+            ((len > 0) ? 3 : 2) * AES_BLOCK_SIZE);
+        if (rc != 0) {
+            ok = 0;
+        }
+        else {
+            XMEMCPY(s0, ks, AES_BLOCK_SIZE);
+            XMEMCPY(ks, blk + 2 * AES_BLOCK_SIZE, AES_BLOCK_SIZE);
+        }
+    }
+    if (ok && (aadLen > 0)) {
+        /* Encoded length of AAD then AAD, zero padded to block. */
+        if (aadLen < 0xff00) {
+            x[0] ^= (unsigned char)(aadLen >> 8);
+            x[1] ^= (unsigned char)aadLen;
+            pos = 2;
+        }
+        else {
+            x[0] ^= 0xff;
+            x[1] ^= 0xfe;
+            x[2] ^= (unsigned char)(aadLen >> 24);
+            x[3] ^= (unsigned char)(aadLen >> 16);
+            x[4] ^= (unsigned char)(aadLen >> 8);
+            x[5] ^= (unsigned char)aadLen;
+            pos = 6;
+        }
+        for (i = 0; ok && (i < aadLen); i += n) {
+            n = aadLen - i;
+            if (n > AES_BLOCK_SIZE - pos) {
+                n = AES_BLOCK_SIZE - pos;
+            }
+            for (j = 0; j < n; j++) {
+                x[pos + j] ^= aad[i + j];
+            }
+            pos += n;
+            if ((pos == AES_BLOCK_SIZE) || (i + n == aadLen)) {
+                rc = wc_AesEcbEncrypt(&ctx->aes, x, x, AES_BLOCK_SIZE);
+                if (rc != 0) {
+                    ok = 0;
+                }
+                pos = 0;
+            }
+        }
+    }
+    for (i = 0; ok && (i < len); i += n) {
+        n = len - i;
+        if (n > AES_BLOCK_SIZE) {
+            n = AES_BLOCK_SIZE;
+        }
+        /* MAC the plaintext - read before written when in place. */
+        if (ctx->enc) {
+            for (j = 0; j < n; j++) {
+                x[j] ^= in[i + j];
+                out[i + j] = in[i + j] ^ ks[j];
+            }
+        }
+        else {
+            for (j = 0; j < n; j++) {
+                out[i + j] = in[i + j] ^ ks[j];
+                x[j] ^= out[i + j];
+            }
+        }
+        if (i + n < len) {
+            /* Next CBC-MAC block and key stream block together. */
+            wp_aesccm_inc(ctr, AES_BLOCK_SIZE);
+            XMEMCPY(ks, ctr, AES_BLOCK_SIZE);
+            rc = wc_AesEcbEncrypt(&ctx->aes, blk, blk, 2 * AES_BLOCK_SIZE);
+        }
+        else {
+            rc = wc_AesEcbEncrypt(&ctx->aes, x, x, AES_BLOCK_SIZE);
+        }
+        if (rc != 0) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        for (j = 0; j < ctx->tagLen; j++) {
+            x[j] ^= s0[j];
+        }
+        if (ctx->enc) {
+            XMEMCPY(tag, x, ctx->tagLen);
+        }
+        else if (CRYPTO_memcmp(x, tag, ctx->tagLen) != 0) {
+            ok = 0;
+        }
+    }
+    if ((!ok) && (out != NULL)) {
+        OPENSSL_cleanse(out, len);
+    }
+
+    OPENSSL_cleanse(blk, sizeof(blk));
+    OPENSSL_cleanse(s0, sizeof(s0));
+    return ok;
+}
+#endif /* WP_AESCCM_INTERLEAVED */
+
+/**
+ * Encrypt or decrypt a TLS record with AES CCM in place.
+ *
+ * Record is explicit IV, payload and tag.
+ *
+ * @param [in, out] ctx  AEAD context object.
+ * @param [in, out] rec  Record to encrypt/decrypt.
+ * @param [in]      len  Length of payload in bytes.
+ * @param [in]      aad  TLS AAD of record.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_aesccm_tls_record(wp_AeadCtx* ctx, unsigned char* rec,
+    size_t len, unsigned char* aad)
+{
+    int ok = 1;
+    unsigned char* data = rec + EVP_CCM_TLS_EXPLICIT_IV_LEN;
+#ifndef WP_AESCCM_INTERLEAVED
+    int rc;
+#endif
+
+    if (ctx->enc) {
+        XMEMCPY(rec, aad, EVP_CCM_TLS_EXPLICIT_IV_LEN);
+    }
+    XMEMCPY(ctx->iv + EVP_CCM_TLS_FIXED_IV_LEN, rec,
+        EVP_CCM_TLS_EXPLICIT_IV_LEN);
+
+#ifdef WP_AESCCM_INTERLEAVED
+    ok = wp_aesccm_one_pass(ctx, data, data, len, aad, EVP_AEAD_TLS1_AAD_LEN,
+        data + len);
+#else
+    if (ctx->enc) {
+        rc = wc_AesCcmSetNonce(&ctx->aes, ctx->iv, ctx->ivLen);
+        if (rc != 0) {
+            ok = 0;
+        }
+        else {
+            rc = wc_AesCcmEncrypt_ex(&ctx->aes, data, data, (word32)len,
+                ctx->iv, ctx->ivLen, data + len, ctx->tagLen, aad,
+                EVP_AEAD_TLS1_AAD_LEN);
+            if (rc != 0) {
+                ok = 0;
+            }
+        }
+    }
+    else {
+        rc = wc_AesCcmDecrypt(&ctx->aes, data, data, (word32)len, ctx->iv,
+            ctx->ivLen, data + len, ctx->tagLen, aad, EVP_AEAD_TLS1_AAD_LEN);
+        if (rc != 0) {
+            ok = 0;
+        }
+    }
+#endif
+
+    return ok;
+}
+
 /**
  * Encrypt or decrypt with AES CCM for TLS 1.2 and below.
  *
@@ -1584,39 +2692,8 @@ static int wp_aesccm_tls_cipher(wp_AeadCtx* ctx, unsigned char* out,
     }
 
     if (ok) {
-        int rc;
-
-        if (ctx->enc) {
-            XMEMCPY(out, ctx->buf, EVP_CCM_TLS_EXPLICIT_IV_LEN);
-        }
-        XMEMCPY(ctx->iv + EVP_CCM_TLS_FIXED_IV_LEN, in,
-            EVP_CCM_TLS_EXPLICIT_IV_LEN);
-
         len -= EVP_CCM_TLS_EXPLICIT_IV_LEN + ctx->tagLen;
-        in += EVP_CCM_TLS_EXPLICIT_IV_LEN;
-        out += EVP_CCM_TLS_EXPLICIT_IV_LEN;
-
-        if (ctx->enc) {
-            rc = wc_AesCcmSetNonce(&ctx->aes, ctx->iv, ctx->ivLen);
-            if (rc != 0) {
-                ok = 0;
-            }
-            else {
-                rc = wc_AesCcmEncrypt_ex(&ctx->aes, out, in, (word32)len,
-                    ctx->iv, ctx->ivLen, out + len, ctx->tagLen, ctx->buf,
-                    ctx->tlsAadLen);
-                if (rc != 0) {
-                    ok = 0;
-                }
-            }
-        }
-        else {
-            rc = wc_AesCcmDecrypt(&ctx->aes, out, in, (word32)len, ctx->iv,
-                ctx->ivLen, in + len, ctx->tagLen, ctx->buf, ctx->tlsAadLen);
-            if (rc != 0) {
-                ok = 0;
-            }
-        }
+        ok = wp_aesccm_tls_record(ctx, out, len, ctx->buf);
     }
     if (ok) {
         olen = len;
@@ -1629,6 +2706,69 @@ static int wp_aesccm_tls_cipher(wp_AeadCtx* ctx, unsigned char* out,
     return ok;
 }
 
+/**
+ * Encrypt or decrypt a batch of TLS records with AES CCM in place.
+ *
+ * Records are laid out one after the other. Length of each record is taken
+ * from its AAD. A record that fails only clears its bit in the result.
+ *
+ * @param [in, out] ctx     AEAD context object.
+ * @param [out]     out     Buffer to hold encrypted/decrypted records.
+ * @param [out]     outLen  Length of data in output buffer.
+ * @param [in]      in      Records to be encrypted/decrypted.
+ * @param [in]      len     Length of records in bytes.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_aesccm_tls_batch(wp_AeadCtx* ctx, unsigned char* out,
+    size_t* outLen, const unsigned char* in, size_t len)
+{
+    int ok = 1;
+    size_t i;
+    size_t off = 0;
+    size_t dataLen;
+    unsigned char* aad;
+
+    if (!wolfssl_prov_is_running()) {
+        ok = 0;
+    }
+    if (ok && ((in == NULL) || (out != in))) {
+        ok = 0;
+    }
+    /* Records must exactly fill the buffer. */
+    for (i = 0; ok && (i < ctx->tlsBatchCnt); i++) {
+        aad = ctx->tlsBatchAad + i * EVP_AEAD_TLS1_AAD_LEN;
+        dataLen = ((size_t)aad[EVP_AEAD_TLS1_AAD_LEN - 2] << 8) |
+            aad[EVP_AEAD_TLS1_AAD_LEN - 1];
+        off += EVP_CCM_TLS_EXPLICIT_IV_LEN + dataLen + ctx->tagLen;
+    }
+    if (ok && (off != len)) {
+        ok = 0;
+    }
+    if (ok) {
+        XMEMSET(ctx->tlsBatchRes, 0, sizeof(ctx->tlsBatchRes));
+        for (i = 0, off = 0; i < ctx->tlsBatchCnt; i++) {
+            aad = ctx->tlsBatchAad + i * EVP_AEAD_TLS1_AAD_LEN;
+            dataLen = ((size_t)aad[EVP_AEAD_TLS1_AAD_LEN - 2] << 8) |
+                aad[EVP_AEAD_TLS1_AAD_LEN - 1];
+            if (wp_aesccm_tls_record(ctx, out + off, dataLen, aad)) {
+                ctx->tlsBatchRes[i / 8] |= (unsigned char)(1 << (i % 8));
+            }
+            else {
+                OPENSSL_cleanse(out + off + EVP_CCM_TLS_EXPLICIT_IV_LEN,
+                    dataLen);
+            }
+            off += EVP_CCM_TLS_EXPLICIT_IV_LEN + dataLen + ctx->tagLen;
+        }
+        ctx->tlsBatchResCnt = ctx->tlsBatchCnt;
+    }
+    /* Batch is used once. */
+    ctx->tlsBatchCnt = 0;
+
+    *outLen = ok ? len : 0;
+    return ok;
+}
+
 /**
  * Encrypt/decrypt the data using AES-CCM.
  *
@@ -1643,12 +2783,30 @@ static int wp_aesccm_encdec(wp_AeadCtx *ctx, unsigned char *out,
     const unsigned char *in, size_t inLen)
 {
     int ok = 1;
+#ifndef WP_AESCCM_INTERLEAVED
     int rc;
+#endif
 
     if (ctx->tagLen == UNINITIALISED_SIZET) {
         ctx->tagLen = EVP_CCM_TLS_TAG_LEN;
     }
 
+#ifdef WP_AESCCM_INTERLEAVED
+    if (ctx->enc) {
+        /* Same nonce sequence as wc_AesCcmEncrypt_ex(). */
+        if (ctx->ivSet) {
+            wp_aesccm_inc(ctx->iv, ctx->ivLen);
+        }
+        ctx->ivSet = 1;
+        ok = wp_aesccm_one_pass(ctx, out, in, inLen, ctx->aad, ctx->aadLen,
+            ctx->buf);
+    }
+    else if (!wp_aesccm_one_pass(ctx, out, in, inLen, ctx->aad, ctx->aadLen,
+            ctx->buf)) {
+        ctx->authErr = 1;
+        ok = 0;
+    }
+#else
     if (ctx->enc) {
         if (!ctx->ivSet) {
             rc = wc_AesCcmSetNonce(&ctx->aes, ctx->iv, ctx->ivLen);
@@ -1681,11 +2839,9 @@ static int wp_aesccm_encdec(wp_AeadCtx *ctx, unsigned char *out,
             XMEMCPY(ctx->iv, ctx->aes.reg, ctx->ivLen);
         }
     }
+#endif
 
-    OPENSSL_free(ctx->aad);
-    ctx->aad = NULL;
-    ctx->aadLen = 0;
-    ctx->aadSet = 0;
+    wp_aead_clear_aad(ctx);
 
     return ok;
 }
@@ -1706,7 +2862,10 @@ static int wp_aesccm_stream_update(wp_AeadCtx *ctx, unsigned char *out,
 {
     int ok = 1;
 
-    if (ctx->tlsAadLen != UNINITIALISED_SIZET) {
+    if (ctx->tlsBatchCnt > 0) {
+        ok = wp_aesccm_tls_batch(ctx, out, outLen, in, inLen);
+    }
+    else if (ctx->tlsAadLen != UNINITIALISED_SIZET) {
         ok = wp_aesccm_tls_cipher(ctx, out, outLen, in, inLen);
     }
     else {
@@ -1837,7 +2996,7 @@ static void *wp_aes_ccm_newctx(WOLFPROV_CTX* provCtx, size_t keyBits)
         ctx->mode = EVP_CIPH_CCM_MODE;
         ctx->tlsAadLen = UNINITIALISED_SIZET;
 
-        if (wc_AesInit(&ctx->aes, NULL, INVALID_DEVID) != 0) {
+        if (wc_AesInit(&ctx->aes, NULL, provCtx->devId) != 0) {
             OPENSSL_free(ctx);
             ctx = NULL;
         }
@@ -1852,9 +3011,11 @@ static void *wp_aes_ccm_newctx(WOLFPROV_CTX* provCtx, size_t keyBits)
  */
 static void wp_aes_ccm_freectx(wp_AeadCtx* ctx)
 {
-    OPENSSL_free(ctx->aad);
+    wp_aead_clear_aad(ctx);
+    OPENSSL_clear_free(ctx->tlsBatchAad,
+        WP_AESCCM_TLS_BATCH_MAX * EVP_AEAD_TLS1_AAD_LEN);
     wc_AesFree(&ctx->aes);
-    OPENSSL_free(ctx);
+    OPENSSL_clear_free(ctx, sizeof(*ctx));
 }
 
 /* Implement AES CCM for key sizes: 128, 192 and 256 bits. */
@@ -296,9 +296,6 @@ static int wp_aes_block_init(wp_AesBlockCtx *ctx, const unsigned char *key,
             (!wp_aes_init_iv(ctx, iv, ivLen))) {
         ok = 0;
     }
-    if (ok && (iv == NULL) && ctx->ivSet && (ctx->mode == EVP_CIPH_CBC_MODE)) {
-        XMEMCPY(ctx->iv, ctx->oiv, ctx->ivLen);
-    }
 
     if (ok && (key != NULL)) {
         if (keyLen != ctx->keyLen) {
@@ -313,6 +310,15 @@ static int wp_aes_block_init(wp_AesBlockCtx *ctx, const unsigned char *key,
         }
     }
 
+    /* The chaining value lives in the wolfSSL object - restart from the
+     * original IV. */
+    if (ok && (iv == NULL) && ctx->ivSet && (ctx->mode == EVP_CIPH_CBC_MODE)) {
+        XMEMCPY(ctx->iv, ctx->oiv, ctx->ivLen);
+        if (wc_AesSetIV(&ctx->aes, ctx->oiv) != 0) {
+            ok = 0;
+        }
+    }
+
     if (ok) {
         ok = wp_aes_block_set_ctx_params(ctx, params);
     }
@@ -363,6 +369,8 @@ static int wp_aes_block_dinit(wp_AesBlockCtx *ctx, const unsigned char *key,
  *
  * Assumes out has inLen bytes available.
  * Assumes whole blocks only.
+ * The CBC chaining value is left in the wolfSSL object and only copied out
+ * when the updated IV is requested.
  *
  * @param [in]  ctx    AES block context object.
  * @param [out] out    Buffer to hold encrypted/decrypted result.
@@ -383,7 +391,6 @@ static int wp_aes_block_doit(wp_AesBlockCtx *ctx, unsigned char *out,
         else {
             rc = wc_AesCbcDecrypt(&ctx->aes, out, in, inLen);
         }
-        XMEMCPY(ctx->iv, ctx->aes.reg, ctx->ivLen);
     }
     else if (ctx->mode == EVP_CIPH_ECB_MODE) {
         if (ctx->enc) {
@@ -398,7 +405,7 @@ static int wp_aes_block_doit(wp_AesBlockCtx *ctx, unsigned char *out,
 }
 
 /**
- * Update encryption/decryption with more data.
+ * Update encryption/decryption with more data, buffering partial blocks.
  *
  * @param [in]  ctx      AES block context object.
  * @param [out] out      Buffer to hold encrypted/decrypted result.
@@ -409,7 +416,7 @@ static int wp_aes_block_doit(wp_AesBlockCtx *ctx, unsigned char *out,
  * @return  1 on success.
  * @return  0 on failure.
  */
-static int wp_aes_block_update(wp_AesBlockCtx *ctx, unsigned char *out,
+static int wp_aes_block_update_buf(wp_AesBlockCtx *ctx, unsigned char *out,
     size_t *outLen, size_t outSize, const unsigned char *in, size_t inLen)
 {
     int ok = 1;
@@ -498,6 +505,46 @@ static int wp_aes_block_update(wp_AesBlockCtx *ctx, unsigned char *out,
     return ok;
 }
 
+/**
+ * Update encryption/decryption with more data.
+ *
+ * Whole blocks with nothing cached are processed directly from the input
+ * when no block needs to be held back for padding removal.
+ *
+ * @param [in]  ctx      AES block context object.
+ * @param [out] out      Buffer to hold encrypted/decrypted result.
+ * @param [out] outLen   Length of encrypted/decrypted data in bytes.
+ * @param [in]  outSize  Size of output buffer in bytes.
+ * @param [in]  in       Data to encrypt/decrypt.
+ * @param [in]  inLen    Length of data in bytes.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_aes_block_update(wp_AesBlockCtx *ctx, unsigned char *out,
+    size_t *outLen, size_t outSize, const unsigned char *in, size_t inLen)
+{
+    int ok = 1;
+
+    if ((ctx->bufSz == 0) && (ctx->tls_version == 0) &&
+            ((inLen & (AES_BLOCK_SIZE - 1)) == 0) &&
+            (ctx->enc || (!ctx->pad))) {
+        if (outSize < inLen) {
+            ok = 0;
+        }
+        if (ok && (inLen > 0) && (!wp_aes_block_doit(ctx, out, in, inLen))) {
+            ok = 0;
+        }
+        if (ok) {
+            *outLen = inLen;
+        }
+    }
+    else {
+        ok = wp_aes_block_update_buf(ctx, out, outLen, outSize, in, inLen);
+    }
+
+    return ok;
+}
+
 /**
  * Finalize AES block encryption.
  *
@@ -708,6 +755,10 @@ static int wp_aes_block_get_ctx_params(wp_AesBlockCtx* ctx, OSSL_PARAM params[])
     }
     if (ok) {
         p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_UPDATED_IV);
+        if ((p != NULL) && ctx->ivSet) {
+            /* Sync the chaining value out of the wolfSSL object on demand. */
+            XMEMCPY(ctx->iv, ctx->aes.reg, ctx->ivLen);
+        }
         if ((p != NULL) &&
             (!OSSL_PARAM_set_octet_ptr(p, &ctx->iv, ctx->ivLen)) &&
             (!OSSL_PARAM_set_octet_string(p, &ctx->iv, ctx->ivLen))) {
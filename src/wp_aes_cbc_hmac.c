@@ -0,0 +1,1017 @@
+/* wp_aes_cbc_hmac.c
+ *
+ * Copyright (C) 2021 wolfSSL Inc.
+ *
+ * This file is part of wolfProvider.
+ *
+ * wolfProvider is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfProvider is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wolfProvider.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <openssl/err.h>
+#include <openssl/proverr.h>
+#include <openssl/core_dispatch.h>
+#include <openssl/core_names.h>
+#include <openssl/params.h>
+#include <openssl/evp.h>
+#include <openssl/prov_ssl.h>
+
+#include <wolfprovider/alg_funcs.h>
+
+/*
+ * AES-CBC-HMAC-SHA1/SHA256 "stitched" ciphers for TLS MAC-then-encrypt.
+ *
+ * libssl uses these instead of AES-CBC and a separate HMAC, for TLS 1.0-1.2
+ * CBC cipher suites when encrypt-then-MAC has not been negotiated. The MAC
+ * key is set with OSSL_CIPHER_PARAM_AEAD_MAC_KEY and the record header with
+ * OSSL_CIPHER_PARAM_AEAD_TLS1_AAD before each record.
+ *
+ * Encryption computes the MAC over a chunk of the payload and encrypts that
+ * chunk while it is still in cache. Decryption checks the padding and MAC in
+ * constant time, with the same number of hash compressions for any amount of
+ * padding.
+ */
+
+#if defined(HAVE_AES_CBC) && !defined(NO_HMAC)
+
+/** Payload length when not processing a TLS record. */
+#define WP_NO_PAYLOAD_LEN           ((size_t)-1)
+/** Maximum TLS CBC padding length. */
+#define WP_TLS_CBC_MAX_PAD          255
+/** Number of bytes to MAC and then encrypt at a time. */
+#define WP_AES_CBC_HMAC_CHUNK_SZ    1024
+/** Block size of SHA-1 and SHA-256. */
+#define WP_AES_CBC_HMAC_BLOCK_SZ    64
+/** Length encoding and end marker in last block of SHA-1 and SHA-256. */
+#define WP_AES_CBC_HMAC_LEN_SZ      9
+/** Number of hash compressions for header and payload of length. */
+#define WP_AES_CBC_HMAC_BLOCKS(len)                                            \
+    ((EVP_AEAD_TLS1_AAD_LEN + (len) + WP_AES_CBC_HMAC_LEN_SZ +                 \
+      WP_AES_CBC_HMAC_BLOCK_SZ - 1) / WP_AES_CBC_HMAC_BLOCK_SZ)
+
+/**
+ * Data structure for AES-CBC-HMAC ciphers.
+ */
+typedef struct wp_AesCbcHmacCtx {
+    /** wolfSSL AES object.  */
+    Aes aes;
+    /** wolfSSL HMAC object keyed with MAC key. */
+    Hmac hmac;
+
+    /** Provider context that we are constructed from. */
+    WOLFPROV_CTX* provCtx;
+
+    /** wolfSSL hash type of HMAC. */
+    int hashType;
+    /** Size of MAC in bytes. */
+    size_t macSz;
+    /** Length of key in bytes. */
+    size_t keyLen;
+
+    /** Length of TLS record payload. WP_NO_PAYLOAD_LEN when not TLS. */
+    size_t payloadLen;
+    /** Padding and MAC length to return for TLS AAD. */
+    size_t tlsAadPad;
+    /** TLS AAD - sequence number, type, version and length. */
+    unsigned char tlsAad[EVP_AEAD_TLS1_AAD_LEN];
+
+    /** Operation being performed is encryption. */
+    unsigned int enc:1;
+    /** AES key has been set. */
+    unsigned int keySet:1;
+    /** MAC key has been set. */
+    unsigned int macKeySet:1;
+    /** TLS record has an explicit IV - TLS 1.1 and above. */
+    unsigned int explicitIv:1;
+
+    /** IV set at initialization. */
+    unsigned char iv[AES_BLOCK_SIZE];
+    /** AES key - used to key a duplicate. */
+    unsigned char key[AES_256_KEY_SIZE];
+    /** MAC key - used to key a duplicate. */
+    unsigned char macKey[WP_AES_CBC_HMAC_BLOCK_SZ];
+    /** Length of MAC key in bytes. 0 when too long to keep. */
+    size_t macKeyLen;
+} wp_AesCbcHmacCtx;
+
+
+/* Prototype for initialization to call. */
+static int wp_aes_cbc_hmac_set_ctx_params(wp_AesCbcHmacCtx *ctx,
+    const OSSL_PARAM params[]);
+
+
+/**
+ * Create a new AES-CBC-HMAC context object.
+ *
+ * @param [in] provCtx   Provider context object.
+ * @param [in] kBits     Number of bits in a valid key.
+ * @param [in] hashType  wolfSSL hash type of HMAC.
+ * @param [in] macSz     Size of MAC in bytes.
+ * @return  NULL on failure.
+ * @return  AES-CBC-HMAC context object on success.
+ */
+static wp_AesCbcHmacCtx* wp_aes_cbc_hmac_newctx(WOLFPROV_CTX* provCtx,
+    size_t kBits, int hashType, size_t macSz)
+{
+    wp_AesCbcHmacCtx *ctx = NULL;
+
+    if (wolfssl_prov_is_running()) {
+        ctx = OPENSSL_zalloc(sizeof(*ctx));
+    }
+    if (ctx != NULL) {
+        ctx->provCtx = provCtx;
+        ctx->keyLen = kBits / 8;
+        ctx->hashType = hashType;
+        ctx->macSz = macSz;
+        ctx->payloadLen = WP_NO_PAYLOAD_LEN;
+
+        if (wc_AesInit(&ctx->aes, NULL, provCtx->devId) != 0) {
+            OPENSSL_free(ctx);
+            ctx = NULL;
+        }
+    }
+    if ((ctx != NULL) && (wc_HmacInit(&ctx->hmac, NULL, provCtx->devId) != 0)) {
+        wc_AesFree(&ctx->aes);
+        OPENSSL_free(ctx);
+        ctx = NULL;
+    }
+
+    return ctx;
+}
+
+/**
+ * Free the AES-CBC-HMAC context object.
+ *
+ * @param [in, out] ctx  AES-CBC-HMAC context object.
+ */
+static void wp_aes_cbc_hmac_freectx(wp_AesCbcHmacCtx *ctx)
+{
+    wc_HmacFree(&ctx->hmac);
+    wc_AesFree(&ctx->aes);
+    OPENSSL_clear_free(ctx, sizeof(*ctx));
+}
+
+/**
+ * Duplicate the AES-CBC-HMAC context object.
+ *
+ * The wolfSSL AES and HMAC objects are not copied as they may hold pointers.
+ * They are initialized and keyed again from the stored keys, continuing the
+ * CBC chain from the current IV.
+ *
+ * @param [in] src  AES-CBC-HMAC context object to copy.
+ * @return  NULL on failure.
+ * @return  AES-CBC-HMAC context object.
+ */
+static void *wp_aes_cbc_hmac_dupctx(wp_AesCbcHmacCtx *src)
+{
+    wp_AesCbcHmacCtx *dst = NULL;
+    int ok = 1;
+
+    if (wolfssl_prov_is_running()) {
+        dst = OPENSSL_malloc(sizeof(*dst));
+    }
+    if (dst != NULL) {
+        /* Fields other than AES and HMAC objects are plain data. */
+        XMEMCPY(dst, src, sizeof(*src));
+        XMEMSET(&dst->aes, 0, sizeof(dst->aes));
+        XMEMSET(&dst->hmac, 0, sizeof(dst->hmac));
+        if (wc_AesInit(&dst->aes, NULL, src->provCtx->devId) != 0) {
+            OPENSSL_clear_free(dst, sizeof(*dst));
+            dst = NULL;
+        }
+    }
+    if ((dst != NULL) &&
+            (wc_HmacInit(&dst->hmac, NULL, src->provCtx->devId) != 0)) {
+        wc_AesFree(&dst->aes);
+        OPENSSL_clear_free(dst, sizeof(*dst));
+        dst = NULL;
+    }
+    if ((dst != NULL) && src->keySet) {
+        int rc = wc_AesSetKey(&dst->aes, src->key, (word32)src->keyLen,
+            (const byte*)src->aes.reg,
+            src->enc ? AES_ENCRYPTION : AES_DECRYPTION);
+        if (rc != 0) {
+            ok = 0;
+        }
+    }
+    if ((dst != NULL) && ok && src->macKeySet) {
+        /* MAC key too long to keep can't be set. */
+        if (src->macKeyLen == 0) {
+            ok = 0;
+        }
+        else if (wc_HmacSetKey(&dst->hmac, src->hashType, src->macKey,
+                (word32)src->macKeyLen) != 0) {
+            ok = 0;
+        }
+    }
+    if ((dst != NULL) && (!ok)) {
+        wp_aes_cbc_hmac_freectx(dst);
+        dst = NULL;
+    }
+
+    return dst;
+}
+
+/**
+ * Returns the parameters that can be retrieved.
+ *
+ * @param [in] provCtx  wolfProvider context object. Unused.
+ * @return  Array of parameters.
+ */
+static const OSSL_PARAM *wp_aes_cbc_hmac_gettable_params(
+    WOLFPROV_CTX *provCtx)
+{
+    /**
+     * Parameters able to be retrieved for a stitched cipher.
+     */
+    static const OSSL_PARAM wp_aes_cbc_hmac_supported_gettable_params[] = {
+        OSSL_PARAM_uint(OSSL_CIPHER_PARAM_MODE, NULL),
+        OSSL_PARAM_size_t(OSSL_CIPHER_PARAM_KEYLEN, NULL),
+        OSSL_PARAM_size_t(OSSL_CIPHER_PARAM_IVLEN, NULL),
+        OSSL_PARAM_size_t(OSSL_CIPHER_PARAM_BLOCK_SIZE, NULL),
+        OSSL_PARAM_int(OSSL_CIPHER_PARAM_AEAD, NULL),
+        OSSL_PARAM_int(OSSL_CIPHER_PARAM_CUSTOM_IV, NULL),
+        OSSL_PARAM_int(OSSL_CIPHER_PARAM_HAS_RAND_KEY, NULL),
+        OSSL_PARAM_END
+    };
+    (void)provCtx;
+    return wp_aes_cbc_hmac_supported_gettable_params;
+}
+
+/**
+ * Get the values for the parameters of a stitched cipher.
+ *
+ * @param [in, out] params  Array of parameters to retrieve.
+ * @param [in]      kBits   Number of bits in key.
+ * @return 1 on success.
+ * @return 0 on failure.
+ */
+static int wp_aes_cbc_hmac_get_params(OSSL_PARAM params[], size_t kBits)
+{
+    int ok = 1;
+    OSSL_PARAM *p;
+
+    p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_MODE);
+    if ((p != NULL) && (!OSSL_PARAM_set_uint(p, EVP_CIPH_CBC_MODE))) {
+        ok = 0;
+    }
+    if (ok) {
+        p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_AEAD);
+        if ((p != NULL) && (!OSSL_PARAM_set_int(p, 1))) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_CUSTOM_IV);
+        if ((p != NULL) && (!OSSL_PARAM_set_int(p, 0))) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_HAS_RAND_KEY);
+        if ((p != NULL) && (!OSSL_PARAM_set_int(p, 0))) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_KEYLEN);
+        if ((p != NULL) && (!OSSL_PARAM_set_size_t(p, kBits / 8))) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_BLOCK_SIZE);
+        if ((p != NULL) && (!OSSL_PARAM_set_size_t(p, AES_BLOCK_SIZE))) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_IVLEN);
+        if ((p != NULL) && (!OSSL_PARAM_set_size_t(p, AES_BLOCK_SIZE))) {
+            ok = 0;
+        }
+    }
+
+    return ok;
+}
+
+/**
+ * Returns the parameters of a cipher context that can be retrieved.
+ *
+ * @param [in] ctx      AES-CBC-HMAC context object. Unused.
+ * @param [in] provCtx  wolfProvider context object. Unused.
+ * @return  Array of parameters.
+ */
+static const OSSL_PARAM* wp_aes_cbc_hmac_gettable_ctx_params(
+    wp_AesCbcHmacCtx* ctx, WOLFPROV_CTX* provCtx)
+{
+    /**
+     * Parameters able to be retrieved for a cipher context.
+     */
+    static const OSSL_PARAM wp_aes_cbc_hmac_supported_gettable_ctx_params[] = {
+        OSSL_PARAM_size_t(OSSL_CIPHER_PARAM_KEYLEN, NULL),
+        OSSL_PARAM_size_t(OSSL_CIPHER_PARAM_IVLEN, NULL),
+        OSSL_PARAM_octet_string(OSSL_CIPHER_PARAM_IV, NULL, 0),
+        OSSL_PARAM_size_t(OSSL_CIPHER_PARAM_AEAD_TLS1_AAD_PAD, NULL),
+        OSSL_PARAM_END
+    };
+    (void)ctx;
+    (void)provCtx;
+    return wp_aes_cbc_hmac_supported_gettable_ctx_params;
+}
+
+/**
+ * Returns the parameters of a cipher context that can be set.
+ *
+ * @param [in] ctx      AES-CBC-HMAC context object. Unused.
+ * @param [in] provCtx  wolfProvider context object. Unused.
+ * @return  Array of parameters.
+ */
+static const OSSL_PARAM* wp_aes_cbc_hmac_settable_ctx_params(
+    wp_AesCbcHmacCtx* ctx, WOLFPROV_CTX *provCtx)
+{
+    /*
+     * Parameters able to be set into a cipher context.
+     */
+    static const OSSL_PARAM wp_aes_cbc_hmac_supported_settable_ctx_params[] = {
+        OSSL_PARAM_size_t(OSSL_CIPHER_PARAM_KEYLEN, NULL),
+        OSSL_PARAM_octet_string(OSSL_CIPHER_PARAM_AEAD_MAC_KEY, NULL, 0),
+        OSSL_PARAM_octet_string(OSSL_CIPHER_PARAM_AEAD_TLS1_AAD, NULL, 0),
+        OSSL_PARAM_END
+    };
+    (void)ctx;
+    (void)provCtx;
+    return wp_aes_cbc_hmac_supported_settable_ctx_params;
+}
+
+/**
+ * Initialization of an AES-CBC-HMAC cipher.
+ *
+ * Internal. Handles both encrypt and decrypt.
+ *
+ * @param [in, out] ctx     AES-CBC-HMAC context object.
+ * @param [in]      key     Private key data. May be NULL.
+ * @param [in]      keyLen  Length of private key in bytes.
+ * @param [in]      iv      IV data. May be NULL.
+ * @param [in]      ivLen   Length of IV in bytes.
+ * @param [in]      params  Parameters to set against context object.
+ * @param [in]      enc     Initializing for encryption.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_aes_cbc_hmac_init(wp_AesCbcHmacCtx *ctx,
+    const unsigned char *key, size_t keyLen, const unsigned char *iv,
+    size_t ivLen, const OSSL_PARAM params[], int enc)
+{
+    int ok = 1;
+
+    ctx->enc = enc;
+    ctx->payloadLen = WP_NO_PAYLOAD_LEN;
+
+    if (!wolfssl_prov_is_running()) {
+        ok = 0;
+    }
+    if (ok && (iv != NULL)) {
+        if (ivLen != AES_BLOCK_SIZE) {
+            ok = 0;
+        }
+        if (ok) {
+            XMEMCPY(ctx->iv, iv, ivLen);
+        }
+    }
+    if (ok && (key != NULL)) {
+        if (keyLen != ctx->keyLen) {
+            ok = 0;
+        }
+        if (ok) {
+            int rc = wc_AesSetKey(&ctx->aes, key, (word32)ctx->keyLen, iv,
+                enc ? AES_ENCRYPTION : AES_DECRYPTION);
+            if (rc != 0) {
+                ok = 0;
+            }
+        }
+        if (ok) {
+            XMEMCPY(ctx->key, key, keyLen);
+            ctx->keySet = 1;
+        }
+    }
+    else if (ok && (iv != NULL)) {
+        if (wc_AesSetIV(&ctx->aes, iv) != 0) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        ok = wp_aes_cbc_hmac_set_ctx_params(ctx, params);
+    }
+
+    return ok;
+}
+
+/**
+ * Initialization of an AES-CBC-HMAC encryption.
+ *
+ * @param [in, out] ctx     AES-CBC-HMAC context object.
+ * @param [in]      key     Private key data. May be NULL.
+ * @param [in]      keyLen  Length of private key in bytes.
+ * @param [in]      iv      IV data. May be NULL.
+ * @param [in]      ivLen   Length of IV in bytes.
+ * @param [in]      params  Parameters to set against context object.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_aes_cbc_hmac_einit(wp_AesCbcHmacCtx *ctx,
+    const unsigned char *key, size_t keyLen, const unsigned char *iv,
+    size_t ivLen, const OSSL_PARAM params[])
+{
+    return wp_aes_cbc_hmac_init(ctx, key, keyLen, iv, ivLen, params, 1);
+}
+
+/**
+ * Initialization of an AES-CBC-HMAC decryption.
+ *
+ * @param [in, out] ctx     AES-CBC-HMAC context object.
+ * @param [in]      key     Private key data. May be NULL.
+ * @param [in]      keyLen  Length of private key in bytes.
+ * @param [in]      iv      IV data. May be NULL.
+ * @param [in]      ivLen   Length of IV in bytes.
+ * @param [in]      params  Parameters to set against context object.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_aes_cbc_hmac_dinit(wp_AesCbcHmacCtx *ctx,
+    const unsigned char *key, size_t keyLen, const unsigned char *iv,
+    size_t ivLen, const OSSL_PARAM params[])
+{
+    return wp_aes_cbc_hmac_init(ctx, key, keyLen, iv, ivLen, params, 0);
+}
+
+/**
+ * MAC a TLS record and encrypt it with padding.
+ *
+ * The payload is MACed and encrypted a chunk at a time so that it is only
+ * brought into cache once.
+ *
+ * @param [in]  ctx   AES-CBC-HMAC context object.
+ * @param [out] out   Buffer holding record. Encrypted record on success.
+ * @param [in]  in    Record with space for MAC and padding.
+ * @param [in]  len   Length of record with MAC and padding in bytes.
+ * @param [in]  plen  Length of record without MAC and padding in bytes.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_aes_cbc_hmac_tls_enc(wp_AesCbcHmacCtx *ctx, unsigned char *out,
+    const unsigned char *in, size_t len, size_t plen)
+{
+    int ok = 1;
+    int rc;
+    size_t ivSz = ctx->explicitIv ? AES_BLOCK_SIZE : 0;
+    size_t encLen = plen & (~(size_t)(AES_BLOCK_SIZE - 1));
+    size_t off = 0;
+    size_t macOff;
+    size_t i;
+
+    if (len != ((plen + ctx->macSz + AES_BLOCK_SIZE) &
+            (~(size_t)(AES_BLOCK_SIZE - 1)))) {
+        ok = 0;
+    }
+    if (ok && (in != out)) {
+        XMEMMOVE(out, in, plen);
+    }
+    if (ok) {
+        rc = wc_HmacUpdate(&ctx->hmac, ctx->tlsAad, EVP_AEAD_TLS1_AAD_LEN);
+        if (rc != 0) {
+            ok = 0;
+        }
+    }
+    /* MAC a chunk and encrypt it while it is in cache. Explicit IV is not
+     * MACed. */
+    while (ok && (off < encLen)) {
+        size_t sz = encLen - off;
+
+        if (sz > WP_AES_CBC_HMAC_CHUNK_SZ) {
+            sz = WP_AES_CBC_HMAC_CHUNK_SZ;
+        }
+        macOff = (off < ivSz) ? ivSz : off;
+        if ((off + sz > macOff) && (wc_HmacUpdate(&ctx->hmac, out + macOff,
+                (word32)(off + sz - macOff)) != 0)) {
+            ok = 0;
+        }
+        if (ok && (wc_AesCbcEncrypt(&ctx->aes, out + off, out + off,
+                (word32)sz) != 0)) {
+            ok = 0;
+        }
+        off += sz;
+    }
+    if (ok) {
+        macOff = (off < ivSz) ? ivSz : off;
+        if ((plen > macOff) && (wc_HmacUpdate(&ctx->hmac, out + macOff,
+                (word32)(plen - macOff)) != 0)) {
+            ok = 0;
+        }
+    }
+    if (ok && (wc_HmacFinal(&ctx->hmac, out + plen) != 0)) {
+        ok = 0;
+    }
+    if (ok) {
+        unsigned char pad = (unsigned char)(len - plen - ctx->macSz - 1);
+
+        for (i = plen + ctx->macSz; i < len; i++) {
+            out[i] = pad;
+        }
+        if (wc_AesCbcEncrypt(&ctx->aes, out + off, out + off,
+                (word32)(len - off)) != 0) {
+            ok = 0;
+        }
+    }
+
+    return ok;
+}
+
+/**
+ * Hash blocks of dummy data so that the number of hash compressions does not
+ * depend on the padding length.
+ *
+ * @param [in] ctx     AES-CBC-HMAC context object.
+ * @param [in] blocks  Number of blocks to hash.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_aes_cbc_hmac_dummy_hash(wp_AesCbcHmacCtx *ctx, int blocks)
+{
+    int ok = 1;
+    wc_HashAlg hash;
+    unsigned char dummy[WP_AES_CBC_HMAC_BLOCK_SZ];
+    int i;
+
+    XMEMSET(dummy, 0, sizeof(dummy));
+    if (wc_HashInit(&hash, (enum wc_HashType)ctx->hashType) != 0) {
+        ok = 0;
+    }
+    for (i = 0; ok && (i < blocks); i++) {
+        if (wc_HashUpdate(&hash, (enum wc_HashType)ctx->hashType, dummy,
+                sizeof(dummy)) != 0) {
+            ok = 0;
+        }
+    }
+    wc_HashFree(&hash, (enum wc_HashType)ctx->hashType);
+
+    return ok;
+}
+
+/**
+ * Check the padding and MAC of a decrypted TLS record in constant time.
+ *
+ * All bytes that may be padding are checked and the MAC is copied out of all
+ * positions it may be at, with masks, so that neither the time taken nor the
+ * memory accessed depend on the padding length. The checks are branch-free
+ * loops over windows that only depend on the record length.
+ *
+ * @param [in]  ctx      AES-CBC-HMAC context object.
+ * @param [in]  rec      Decrypted record without explicit IV.
+ * @param [in]  len      Length of decrypted record in bytes.
+ * @param [out] dataLen  Length of payload in bytes.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_aes_cbc_hmac_tls_check(wp_AesCbcHmacCtx *ctx,
+    const unsigned char *rec, int len, int *dataLen)
+{
+    int ok = 1;
+    int macSz = (int)ctx->macSz;
+    unsigned char mac[WC_MAX_DIGEST_SIZE];
+    unsigned char recvMac[WC_MAX_DIGEST_SIZE];
+    unsigned char header[EVP_AEAD_TLS1_AAD_LEN];
+    int maxPad = len - macSz - 1;
+    int pad;
+    int dLen;
+    int extra;
+    byte good;
+    int i;
+    int j;
+
+    if (maxPad > WP_TLS_CBC_MAX_PAD) {
+        maxPad = WP_TLS_CBC_MAX_PAD;
+    }
+
+    /* Use maximum padding when invalid to keep accesses within record. */
+    pad = rec[len - 1];
+    good = wp_ct_int_mask_gte(maxPad, pad);
+    pad = maxPad ^ ((pad ^ maxPad) & (0 - (int)(good & 1)));
+    dLen = len - macSz - 1 - pad;
+
+    /* Check every byte that may be padding. */
+    for (i = 0; i <= maxPad; i++) {
+        good &= ~(wp_ct_int_mask_gte(pad, i) &
+                  wp_ct_byte_mask_ne(rec[len - 1 - i], (byte)pad));
+    }
+
+    /* MAC of header with actual payload length and payload. */
+    XMEMCPY(header, ctx->tlsAad, sizeof(header));
+    header[EVP_AEAD_TLS1_AAD_LEN - 2] = (unsigned char)(dLen >> 8);
+    header[EVP_AEAD_TLS1_AAD_LEN - 1] = (unsigned char)dLen;
+    if (wc_HmacUpdate(&ctx->hmac, header, sizeof(header)) != 0) {
+        ok = 0;
+    }
+    if (ok && (wc_HmacUpdate(&ctx->hmac, rec, (word32)dLen) != 0)) {
+        ok = 0;
+    }
+    if (ok && (wc_HmacFinal(&ctx->hmac, mac) != 0)) {
+        ok = 0;
+    }
+    if (ok) {
+        /* Compressions for longest payload less those for actual. */
+        extra = WP_AES_CBC_HMAC_BLOCKS(len - macSz - 1) -
+                WP_AES_CBC_HMAC_BLOCKS(dLen);
+        ok = wp_aes_cbc_hmac_dummy_hash(ctx, extra);
+    }
+
+    /* Copy out MAC from every position it may start at. */
+    XMEMSET(recvMac, 0, sizeof(recvMac));
+    for (i = len - macSz - 1 - maxPad; i <= len - macSz - 1; i++) {
+        byte m = wp_ct_int_mask_gte(i, dLen) & wp_ct_int_mask_gte(dLen, i);
+
+        for (j = 0; j < macSz; j++) {
+            recvMac[j] |= rec[i + j] & m;
+        }
+    }
+    good &= wp_ct_byte_mask_eq((byte)CRYPTO_memcmp(recvMac, mac, macSz), 0);
+
+    if (ok && (good != 0xff)) {
+        ok = 0;
+    }
+    if (ok) {
+        *dataLen = dLen;
+    }
+
+    OPENSSL_cleanse(mac, sizeof(mac));
+    return ok;
+}
+
+/**
+ * Decrypt a TLS record and check padding and MAC.
+ *
+ * @param [in]  ctx      AES-CBC-HMAC context object.
+ * @param [out] out      Buffer to hold decrypted record.
+ * @param [out] outLen   Length of payload in bytes.
+ * @param [in]  in       Encrypted record.
+ * @param [in]  len      Length of encrypted record in bytes.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_aes_cbc_hmac_tls_dec(wp_AesCbcHmacCtx *ctx, unsigned char *out,
+    size_t *outLen, const unsigned char *in, size_t len)
+{
+    int ok = 1;
+    size_t ivSz = ctx->explicitIv ? AES_BLOCK_SIZE : 0;
+    int dataLen = 0;
+
+    if (len < ivSz + ctx->macSz + 1) {
+        ok = 0;
+    }
+    if (ok && (wc_AesCbcDecrypt(&ctx->aes, out, in, (word32)len) != 0)) {
+        ok = 0;
+    }
+    if (ok) {
+        ok = wp_aes_cbc_hmac_tls_check(ctx, out + ivSz, (int)(len - ivSz),
+            &dataLen);
+    }
+    if (ok) {
+        /* Caller skips explicit IV. */
+        *outLen = dataLen;
+    }
+
+    return ok;
+}
+
+/**
+ * Encrypt/decrypt data, with MAC and padding when a TLS record.
+ *
+ * @param [in]  ctx      AES-CBC-HMAC context object.
+ * @param [out] out      Buffer to hold encrypted/decrypted result.
+ * @param [out] outLen   Length of encrypted/decrypted data in bytes.
+ * @param [in]  outSize  Size of output buffer in bytes.
+ * @param [in]  in       Data to encrypt/decrypt.
+ * @param [in]  inLen    Length of data in bytes.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_aes_cbc_hmac_update(wp_AesCbcHmacCtx *ctx, unsigned char *out,
+    size_t *outLen, size_t outSize, const unsigned char *in, size_t inLen)
+{
+    int ok = 1;
+    size_t plen = ctx->payloadLen;
+
+    /* TLS AAD only applies to one record. */
+    ctx->payloadLen = WP_NO_PAYLOAD_LEN;
+
+    if (!wolfssl_prov_is_running()) {
+        ok = 0;
+    }
+    if (ok && (((inLen % AES_BLOCK_SIZE) != 0) || (outSize < inLen))) {
+        ok = 0;
+    }
+    if (ok && (plen != WP_NO_PAYLOAD_LEN) && (!ctx->macKeySet)) {
+        ok = 0;
+    }
+    if (ok && (plen == WP_NO_PAYLOAD_LEN)) {
+        int rc;
+
+        if (ctx->enc) {
+            rc = wc_AesCbcEncrypt(&ctx->aes, out, in, (word32)inLen);
+        }
+        else {
+            rc = wc_AesCbcDecrypt(&ctx->aes, out, in, (word32)inLen);
+        }
+        if (rc != 0) {
+            ok = 0;
+        }
+        if (ok) {
+            *outLen = inLen;
+        }
+    }
+    else if (ok && ctx->enc) {
+        ok = wp_aes_cbc_hmac_tls_enc(ctx, out, in, inLen, plen);
+        if (ok) {
+            *outLen = inLen;
+        }
+    }
+    else if (ok) {
+        ok = wp_aes_cbc_hmac_tls_dec(ctx, out, outLen, in, inLen);
+    }
+
+    return ok;
+}
+
+/**
+ * Finalize AES-CBC-HMAC encryption/decryption. Nothing to do.
+ *
+ * @param [in]  ctx      AES-CBC-HMAC context object.
+ * @param [out] out      Buffer to hold encrypted/decrypted data.
+ * @param [out] outLen   Length of data encrypted/decrypted in bytes.
+ * @param [in]  outSize  Size of buffer.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_aes_cbc_hmac_final(wp_AesCbcHmacCtx* ctx, unsigned char *out,
+    size_t *outLen, size_t outSize)
+{
+    int ok = 1;
+
+    (void)ctx;
+    (void)out;
+    (void)outSize;
+
+    if (!wolfssl_prov_is_running()) {
+        ok = 0;
+    }
+    if (ok) {
+        *outLen = 0;
+    }
+
+    return ok;
+}
+
+/**
+ * Set the TLS record header to MAC.
+ *
+ * When encrypting, the padding and MAC length that will be added is
+ * calculated. When decrypting, the length is replaced by the payload length
+ * when the record has been decrypted.
+ *
+ * @param [in, out] ctx     AES-CBC-HMAC context object.
+ * @param [in]      aad     TLS AAD.
+ * @param [in]      aadLen  Length of TLS AAD in bytes.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_aes_cbc_hmac_set_tls_aad(wp_AesCbcHmacCtx *ctx,
+    const unsigned char *aad, size_t aadLen)
+{
+    int ok = 1;
+    size_t len = 0;
+    unsigned int ver = 0;
+
+    if (aadLen != EVP_AEAD_TLS1_AAD_LEN) {
+        ok = 0;
+    }
+    if (ok) {
+        XMEMCPY(ctx->tlsAad, aad, aadLen);
+        len = ((size_t)aad[aadLen - 2] << 8) | aad[aadLen - 1];
+        ver = ((unsigned int)aad[aadLen - 4] << 8) | aad[aadLen - 3];
+        ctx->explicitIv = (ver >= TLS1_1_VERSION);
+    }
+    if (ok && ctx->enc) {
+        ctx->payloadLen = len;
+        if (ctx->explicitIv) {
+            if (len < AES_BLOCK_SIZE) {
+                ok = 0;
+            }
+            else {
+                /* Explicit IV is not MACed. */
+                len -= AES_BLOCK_SIZE;
+                ctx->tlsAad[aadLen - 2] = (unsigned char)(len >> 8);
+                ctx->tlsAad[aadLen - 1] = (unsigned char)len;
+            }
+        }
+        if (ok) {
+            ctx->tlsAadPad = ((len + ctx->macSz + AES_BLOCK_SIZE) &
+                (~(size_t)(AES_BLOCK_SIZE - 1))) - len;
+        }
+    }
+    else if (ok) {
+        ctx->payloadLen = aadLen;
+        ctx->tlsAadPad = ctx->macSz;
+    }
+    if (!ok) {
+        ctx->payloadLen = WP_NO_PAYLOAD_LEN;
+    }
+
+    return ok;
+}
+
+/**
+ * Put values from the AES-CBC-HMAC context object into parameters objects.
+ *
+ * @param [in]      ctx     AES-CBC-HMAC context object.
+ * @param [in, out] params  Array of parameters objects.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_aes_cbc_hmac_get_ctx_params(wp_AesCbcHmacCtx* ctx,
+    OSSL_PARAM params[])
+{
+    int ok = 1;
+    OSSL_PARAM* p;
+
+    p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_IVLEN);
+    if ((p != NULL) && (!OSSL_PARAM_set_size_t(p, AES_BLOCK_SIZE))) {
+        ok = 0;
+    }
+    if (ok) {
+        p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_IV);
+        if ((p != NULL) &&
+            (!OSSL_PARAM_set_octet_ptr(p, &ctx->iv, AES_BLOCK_SIZE)) &&
+            (!OSSL_PARAM_set_octet_string(p, &ctx->iv, AES_BLOCK_SIZE))) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_KEYLEN);
+        if ((p != NULL) && (!OSSL_PARAM_set_size_t(p, ctx->keyLen))) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_AEAD_TLS1_AAD_PAD);
+        if ((p != NULL) && (!OSSL_PARAM_set_size_t(p, ctx->tlsAadPad))) {
+            ok = 0;
+        }
+    }
+
+    return ok;
+}
+
+/**
+ * Sets the parameters to use into AES-CBC-HMAC context object.
+ *
+ * @param [in, out] ctx     AES-CBC-HMAC context object.
+ * @param [in]      params  Array of parameter objects.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_aes_cbc_hmac_set_ctx_params(wp_AesCbcHmacCtx *ctx,
+    const OSSL_PARAM params[])
+{
+    int ok = 1;
+
+    if (params != NULL) {
+        size_t keyLen = ctx->keyLen;
+        unsigned char* data = NULL;
+        size_t len = 0;
+
+        if (!wp_params_get_size_t(params, OSSL_CIPHER_PARAM_KEYLEN,
+                &keyLen)) {
+            ok = 0;
+        }
+        if (ok && (keyLen != ctx->keyLen)) {
+            ok = 0;
+        }
+
+        if (ok && (!wp_params_get_octet_string_ptr(params,
+                OSSL_CIPHER_PARAM_AEAD_MAC_KEY, &data, &len))) {
+            ok = 0;
+        }
+        if (ok && (data != NULL)) {
+            int rc = wc_HmacSetKey(&ctx->hmac, ctx->hashType, data,
+                (word32)len);
+            if (rc != 0) {
+                ok = 0;
+            }
+            if (ok) {
+                ctx->macKeySet = 1;
+                ctx->macKeyLen = 0;
+                if (len <= sizeof(ctx->macKey)) {
+                    XMEMCPY(ctx->macKey, data, len);
+                    ctx->macKeyLen = len;
+                }
+            }
+        }
+
+        data = NULL;
+        if (ok && (!wp_params_get_octet_string_ptr(params,
+                OSSL_CIPHER_PARAM_AEAD_TLS1_AAD, &data, &len))) {
+            ok = 0;
+        }
+        if (ok && (data != NULL)) {
+            ok = wp_aes_cbc_hmac_set_tls_aad(ctx, data, len);
+        }
+    }
+
+    return ok;
+}
+
+/** Implement the get params API for a stitched cipher. */
+#define IMPLEMENT_AES_CBC_HMAC_GET_PARAMS(kBits, sha)                          \
+/**                                                                            \
+ * Get the values from the AES-CBC-HMAC context for the parameters.            \
+ *                                                                             \
+ * @param [in, out] params  Array of parameters to retrieve.                   \
+ * @return 1 on success.                                                       \
+ * @return 0 on failure.                                                       \
+ */                                                                            \
+static int wp_aes_##kBits##_cbc_hmac_##sha##_get_params(OSSL_PARAM params[])   \
+{                                                                              \
+    return wp_aes_cbc_hmac_get_params(params, kBits);                          \
+}
+
+/** Implement the new context API for a stitched cipher. */
+#define IMPLEMENT_AES_CBC_HMAC_NEWCTX(kBits, sha, hashType, macSz)             \
+/**                                                                            \
+ * Create a new AES-CBC-HMAC context object.                                   \
+ *                                                                             \
+ * @param [in] provCtx  Provider context object.                               \
+ * @return  NULL on failure.                                                   \
+ * @return  AES-CBC-HMAC context object on success.                            \
+ */                                                                            \
+static wp_AesCbcHmacCtx* wp_aes_##kBits##_cbc_hmac_##sha##_newctx(             \
+    WOLFPROV_CTX *provCtx)                                                     \
+{                                                                              \
+    return wp_aes_cbc_hmac_newctx(provCtx, kBits, hashType, macSz);            \
+}
+
+/** Implement the dispatch table for a stitched cipher. */
+#define IMPLEMENT_AES_CBC_HMAC_DISPATCH(kBits, sha)                            \
+const OSSL_DISPATCH wp_aes##kBits##cbchmac##sha##_functions[] = {              \
+    { OSSL_FUNC_CIPHER_NEWCTX,                                                 \
+                            (DFUNC)wp_aes_##kBits##_cbc_hmac_##sha##_newctx }, \
+    { OSSL_FUNC_CIPHER_FREECTX,         (DFUNC)wp_aes_cbc_hmac_freectx      }, \
+    { OSSL_FUNC_CIPHER_DUPCTX,          (DFUNC)wp_aes_cbc_hmac_dupctx       }, \
+    { OSSL_FUNC_CIPHER_ENCRYPT_INIT,    (DFUNC)wp_aes_cbc_hmac_einit        }, \
+    { OSSL_FUNC_CIPHER_DECRYPT_INIT,    (DFUNC)wp_aes_cbc_hmac_dinit        }, \
+    { OSSL_FUNC_CIPHER_UPDATE,          (DFUNC)wp_aes_cbc_hmac_update       }, \
+    { OSSL_FUNC_CIPHER_FINAL,           (DFUNC)wp_aes_cbc_hmac_final        }, \
+    { OSSL_FUNC_CIPHER_GET_PARAMS,                                             \
+                        (DFUNC)wp_aes_##kBits##_cbc_hmac_##sha##_get_params }, \
+    { OSSL_FUNC_CIPHER_GET_CTX_PARAMS,                                         \
+                                 (DFUNC)wp_aes_cbc_hmac_get_ctx_params      }, \
+    { OSSL_FUNC_CIPHER_SET_CTX_PARAMS,                                         \
+                                 (DFUNC)wp_aes_cbc_hmac_set_ctx_params      }, \
+    { OSSL_FUNC_CIPHER_GETTABLE_PARAMS,                                        \
+                                 (DFUNC)wp_aes_cbc_hmac_gettable_params     }, \
+    { OSSL_FUNC_CIPHER_GETTABLE_CTX_PARAMS,                                    \
+                                 (DFUNC)wp_aes_cbc_hmac_gettable_ctx_params }, \
+    { OSSL_FUNC_CIPHER_SETTABLE_CTX_PARAMS,                                    \
+                                 (DFUNC)wp_aes_cbc_hmac_settable_ctx_params }, \
+    { 0, NULL }                                                                \
+};
+
+/** Implements the functions calling base functions for a stitched cipher. */
+#define IMPLEMENT_AES_CBC_HMAC(kBits, sha, hashType, macSz)                    \
+IMPLEMENT_AES_CBC_HMAC_GET_PARAMS(kBits, sha)                                  \
+IMPLEMENT_AES_CBC_HMAC_NEWCTX(kBits, sha, hashType, macSz)                     \
+IMPLEMENT_AES_CBC_HMAC_DISPATCH(kBits, sha)
+
+#ifndef NO_SHA
+/** wp_aes256cbchmacsha1_functions */
+IMPLEMENT_AES_CBC_HMAC(256, sha1, WC_SHA, WC_SHA_DIGEST_SIZE)
+/** wp_aes128cbchmacsha1_functions */
+IMPLEMENT_AES_CBC_HMAC(128, sha1, WC_SHA, WC_SHA_DIGEST_SIZE)
+#endif
+#ifndef NO_SHA256
+/** wp_aes256cbchmacsha256_functions */
+IMPLEMENT_AES_CBC_HMAC(256, sha256, WC_SHA256, WC_SHA256_DIGEST_SIZE)
+/** wp_aes128cbchmacsha256_functions */
+IMPLEMENT_AES_CBC_HMAC(128, sha256, WC_SHA256, WC_SHA256_DIGEST_SIZE)
+#endif
+
+#endif /* HAVE_AES_CBC && !NO_HMAC */
@@ -364,7 +364,6 @@ static int wp_aes_stream_doit(wp_AesStreamCtx *ctx, unsigned char *out,
     if (ctx->mode == EVP_CIPH_CTR_MODE) {
         int rc = wc_AesCtrEncrypt(&ctx->aes, out, in, inLen);
         if (rc == 0) {
-            XMEMCPY(ctx->iv, ctx->aes.reg, ctx->ivLen);
             ok = 1;
         }
     }
@@ -482,6 +481,10 @@ static int wp_aes_stream_get_ctx_params(wp_AesStreamCtx* ctx,
     }
     if (ok) {
         p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_UPDATED_IV);
+        if ((p != NULL) && ctx->ivSet) {
+            /* Counter is only copied out of the wolfSSL object on demand. */
+            XMEMCPY(ctx->iv, ctx->aes.reg, ctx->ivLen);
+        }
         if ((p != NULL) &&
             (!OSSL_PARAM_set_octet_ptr(p, &ctx->iv, ctx->ivLen)) &&
             (!OSSL_PARAM_set_octet_string(p, &ctx->iv, ctx->ivLen))) {
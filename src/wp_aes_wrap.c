@@ -28,6 +28,13 @@
 
 #include <wolfprovider/alg_funcs.h>
 
+/** Number of keys of a batch to process interleaved. */
+#define WP_AES_WRAP_BATCH_CNT       16
+/** Size of a semiblock of the key wrap algorithm. */
+#define WP_AES_WRAP_SEMI_SZ         8
+/** Maximum batch item size in bytes. */
+#define WP_AES_WRAP_MAX_ITEM_SZ     4096
+
 /**
  * Data structure for AES ciphers that wrap.
  */
@@ -40,6 +47,13 @@ typedef struct wp_AesWrapCtx {
     size_t keyLen;
     size_t ivLen;
     unsigned char iv[AES_IV_SIZE];
+
+    /** Size of key in a batch. 0 when not batching. */
+    size_t batchItemSz;
+    /** Bitmap of results of last batch. */
+    unsigned char* batchRes;
+    /** Length of bitmap in bytes. */
+    size_t batchResLen;
 } wp_AesWrapCtx;
 
 
@@ -55,6 +69,7 @@ static int wp_aes_wrap_set_ctx_params(wp_AesWrapCtx *ctx,
  */
 static void wp_aes_wrap_freectx(wp_AesWrapCtx *ctx)
 {
+    OPENSSL_free(ctx->batchRes);
     wc_AesFree(&ctx->aes);
     OPENSSL_clear_free(ctx, sizeof(*ctx));
 }
@@ -76,6 +91,9 @@ static void *wp_aes_wrap_dupctx(wp_AesWrapCtx *src)
     if (dst != NULL) {
         /* TODO: copying Aes may not work if it has pointers in it. */
         XMEMCPY(dst, src, sizeof(*src));
+        /* Results belong to the batch performed with the source. */
+        dst->batchRes = NULL;
+        dst->batchResLen = 0;
     }
 
     return dst;
@@ -178,6 +196,8 @@ static const OSSL_PARAM* wp_aes_wrap_gettable_ctx_params(wp_AesWrapCtx* ctx,
         OSSL_PARAM_size_t(OSSL_CIPHER_PARAM_IVLEN, NULL),
         OSSL_PARAM_uint(OSSL_CIPHER_PARAM_PADDING, NULL),
         OSSL_PARAM_octet_string(OSSL_CIPHER_PARAM_IV, NULL, 0),
+        OSSL_PARAM_size_t(WP_CIPHER_PARAM_WRAP_BATCH_ITEM_SIZE, NULL),
+        OSSL_PARAM_octet_string(WP_CIPHER_PARAM_WRAP_BATCH_RESULT, NULL, 0),
         OSSL_PARAM_END
     };
     (void)ctx;
@@ -201,6 +221,7 @@ static const OSSL_PARAM* wp_aes_wrap_settable_ctx_params(wp_AesWrapCtx* ctx,
     static const OSSL_PARAM wp_aes_wrap_supported_settable_ctx_params[] = {
         OSSL_PARAM_uint(OSSL_CIPHER_PARAM_KEYLEN, NULL),
         OSSL_PARAM_uint(OSSL_CIPHER_PARAM_PADDING, NULL),
+        OSSL_PARAM_size_t(WP_CIPHER_PARAM_WRAP_BATCH_ITEM_SIZE, NULL),
         OSSL_PARAM_END
     };
     (void)ctx;
@@ -302,6 +323,273 @@ static int wp_aes_wrap_dinit(wp_AesWrapCtx *ctx, const unsigned char *key,
     return wp_aes_wrap_init(ctx, key, keyLen, iv, ivLen, params, 0);
 }
 
+/** Default initial value of RFC 3394. */
+static const unsigned char wp_aes_wrap_def_iv[WP_AES_WRAP_SEMI_SZ] = {
+    0xa6, 0xa6, 0xa6, 0xa6, 0xa6, 0xa6, 0xa6, 0xa6
+};
+
+/**
+ * Encrypt or decrypt blocks, one from each key of the batch, in one call.
+ *
+ * @param [in]      ctx     AES wrap context object.
+ * @param [in, out] blocks  Blocks to encrypt/decrypt in place.
+ * @param [in]      cnt     Number of blocks.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_aes_wrap_blocks(wp_AesWrapCtx *ctx, unsigned char* blocks,
+    int cnt)
+{
+    int ok = 1;
+    int rc = 0;
+#ifdef HAVE_AES_ECB
+    word32 sz = (word32)cnt * AES_BLOCK_SIZE;
+
+    if (ctx->wrap) {
+        rc = wc_AesEcbEncrypt(&ctx->aes, blocks, blocks, sz);
+    }
+    else {
+        rc = wc_AesEcbDecrypt(&ctx->aes, blocks, blocks, sz);
+    }
+#else
+    int i;
+
+    for (i = 0; (rc == 0) && (i < cnt); i++) {
+        unsigned char* b = blocks + i * AES_BLOCK_SIZE;
+
+        if (ctx->wrap) {
+            rc = wc_AesEncryptDirect(&ctx->aes, b, b);
+        }
+        else {
+            rc = wc_AesDecryptDirect(&ctx->aes, b, b);
+        }
+    }
+#endif
+    if (rc != 0) {
+        ok = 0;
+    }
+
+    return ok;
+}
+
+/**
+ * XOR the step number into the integrity check register.
+ *
+ * @param [in, out] a  Integrity check register.
+ * @param [in]      t  Step number.
+ */
+static void wp_aes_wrap_xor_t(unsigned char* a, word32 t)
+{
+    a[WP_AES_WRAP_SEMI_SZ - 1] ^= (unsigned char)(t      );
+    a[WP_AES_WRAP_SEMI_SZ - 2] ^= (unsigned char)(t >>  8);
+    a[WP_AES_WRAP_SEMI_SZ - 3] ^= (unsigned char)(t >> 16);
+    a[WP_AES_WRAP_SEMI_SZ - 4] ^= (unsigned char)(t >> 24);
+}
+
+/**
+ * Wrap keys of a batch with the rounds of RFC 3394 interleaved.
+ *
+ * Keys have already been placed after the integrity check semiblock of each
+ * output item.
+ *
+ * @param [in]      ctx   AES wrap context object.
+ * @param [in, out] out   Output items. Wrapped keys on success.
+ * @param [in]      cnt   Number of keys. At most WP_AES_WRAP_BATCH_CNT.
+ * @param [in]      iv    Initial value of integrity check register.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_aes_wrap_batch_wrap(wp_AesWrapCtx *ctx, unsigned char* out,
+    int cnt, const unsigned char* iv)
+{
+    int ok = 1;
+    unsigned char a[WP_AES_WRAP_BATCH_CNT][WP_AES_WRAP_SEMI_SZ];
+    unsigned char b[WP_AES_WRAP_BATCH_CNT * AES_BLOCK_SIZE];
+    size_t wrapSz = ctx->batchItemSz + WP_AES_WRAP_SEMI_SZ;
+    word32 n = (word32)(ctx->batchItemSz / WP_AES_WRAP_SEMI_SZ);
+    word32 i;
+    int j;
+    int k;
+
+    for (k = 0; k < cnt; k++) {
+        XMEMCPY(a[k], iv, WP_AES_WRAP_SEMI_SZ);
+    }
+    for (j = 0; ok && (j <= 5); j++) {
+        for (i = 1; ok && (i <= n); i++) {
+            for (k = 0; k < cnt; k++) {
+                unsigned char* r = out + k * wrapSz + i * WP_AES_WRAP_SEMI_SZ;
+
+                XMEMCPY(b + k * AES_BLOCK_SIZE, a[k], WP_AES_WRAP_SEMI_SZ);
+                XMEMCPY(b + k * AES_BLOCK_SIZE + WP_AES_WRAP_SEMI_SZ, r,
+                    WP_AES_WRAP_SEMI_SZ);
+            }
+            ok = wp_aes_wrap_blocks(ctx, b, cnt);
+            for (k = 0; ok && (k < cnt); k++) {
+                unsigned char* r = out + k * wrapSz + i * WP_AES_WRAP_SEMI_SZ;
+
+                XMEMCPY(a[k], b + k * AES_BLOCK_SIZE, WP_AES_WRAP_SEMI_SZ);
+                wp_aes_wrap_xor_t(a[k], n * j + i);
+                XMEMCPY(r, b + k * AES_BLOCK_SIZE + WP_AES_WRAP_SEMI_SZ,
+                    WP_AES_WRAP_SEMI_SZ);
+            }
+        }
+    }
+    for (k = 0; ok && (k < cnt); k++) {
+        XMEMCPY(out + k * wrapSz, a[k], WP_AES_WRAP_SEMI_SZ);
+    }
+
+    OPENSSL_cleanse(b, sizeof(b));
+    return ok;
+}
+
+/**
+ * Unwrap keys of a batch with the rounds of RFC 3394 interleaved.
+ *
+ * Wrapped keys, less their integrity check semiblock, have already been
+ * placed in the output items.
+ *
+ * @param [in]      ctx    AES wrap context object.
+ * @param [in, out] out    Output items. Unwrapped keys on success.
+ * @param [in]      a      Integrity check register of each item.
+ * @param [in]      cnt    Number of keys. At most WP_AES_WRAP_BATCH_CNT.
+ * @param [in]      iv     Expected initial value of integrity check register.
+ * @param [in]      idx    Index of first key in whole batch.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_aes_wrap_batch_unwrap(wp_AesWrapCtx *ctx, unsigned char* out,
+    unsigned char a[][WP_AES_WRAP_SEMI_SZ], int cnt, const unsigned char* iv,
+    size_t idx)
+{
+    int ok = 1;
+    unsigned char b[WP_AES_WRAP_BATCH_CNT * AES_BLOCK_SIZE];
+    size_t itemSz = ctx->batchItemSz;
+    word32 n = (word32)(itemSz / WP_AES_WRAP_SEMI_SZ);
+    word32 i;
+    int j;
+    int k;
+
+    for (j = 5; ok && (j >= 0); j--) {
+        for (i = n; ok && (i >= 1); i--) {
+            for (k = 0; k < cnt; k++) {
+                unsigned char* r = out + k * itemSz +
+                    (i - 1) * WP_AES_WRAP_SEMI_SZ;
+
+                wp_aes_wrap_xor_t(a[k], n * j + i);
+                XMEMCPY(b + k * AES_BLOCK_SIZE, a[k], WP_AES_WRAP_SEMI_SZ);
+                XMEMCPY(b + k * AES_BLOCK_SIZE + WP_AES_WRAP_SEMI_SZ, r,
+                    WP_AES_WRAP_SEMI_SZ);
+            }
+            ok = wp_aes_wrap_blocks(ctx, b, cnt);
+            for (k = 0; ok && (k < cnt); k++) {
+                unsigned char* r = out + k * itemSz +
+                    (i - 1) * WP_AES_WRAP_SEMI_SZ;
+
+                XMEMCPY(a[k], b + k * AES_BLOCK_SIZE, WP_AES_WRAP_SEMI_SZ);
+                XMEMCPY(r, b + k * AES_BLOCK_SIZE + WP_AES_WRAP_SEMI_SZ,
+                    WP_AES_WRAP_SEMI_SZ);
+            }
+        }
+    }
+    for (k = 0; ok && (k < cnt); k++) {
+        size_t bit = idx + k;
+
+        if (CRYPTO_memcmp(a[k], iv, WP_AES_WRAP_SEMI_SZ) == 0) {
+            ctx->batchRes[bit / 8] |= (unsigned char)(1 << (bit % 8));
+        }
+        else {
+            OPENSSL_cleanse(out + k * itemSz, itemSz);
+        }
+    }
+
+    OPENSSL_cleanse(b, sizeof(b));
+    return ok;
+}
+
+/**
+ * Wrap or unwrap a batch of keys under the one key of the context.
+ *
+ * Input is a sequence of keys of the batch item size to wrap, or wrapped keys
+ * of the item size plus 8 to unwrap. Output is the corresponding sequence of
+ * results. Keys are processed WP_AES_WRAP_BATCH_CNT at a time with each AES
+ * operation done for all of them in one call.
+ * A key that fails to unwrap only clears its bit in the result and has its
+ * output zeroized. Data that is badly sized fails the whole batch.
+ * Output may be the same buffer as input.
+ *
+ * @param [in]  ctx      AES wrap context object.
+ * @param [out] out      Buffer to hold wrapped/unwrapped keys.
+ * @param [out] outLen   Length of wrapped/unwrapped keys in bytes.
+ * @param [in]  outSize  Size of output buffer in bytes.
+ * @param [in]  in       Keys to wrap/unwrap.
+ * @param [in]  inLen    Length of keys in bytes.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_aes_wrap_batch(wp_AesWrapCtx *ctx, unsigned char *out,
+    size_t *outLen, size_t outSize, const unsigned char *in, size_t inLen)
+{
+    int ok = 1;
+    size_t itemSz = ctx->batchItemSz;
+    size_t wrapSz = itemSz + WP_AES_WRAP_SEMI_SZ;
+    size_t inSz = ctx->wrap ? itemSz : wrapSz;
+    size_t outSz = ctx->wrap ? wrapSz : itemSz;
+    size_t cnt = inLen / inSz;
+    const unsigned char* iv = ctx->ivSet ? ctx->iv : wp_aes_wrap_def_iv;
+    size_t i;
+    size_t k;
+
+    if (((inLen % inSz) != 0) || (outSize / outSz < cnt)) {
+        ok = 0;
+    }
+    if (ok) {
+        OPENSSL_free(ctx->batchRes);
+        ctx->batchResLen = (cnt + 7) / 8;
+        ctx->batchRes = OPENSSL_zalloc(ctx->batchResLen);
+        if (ctx->batchRes == NULL) {
+            ctx->batchResLen = 0;
+            ok = 0;
+        }
+    }
+    if (ok && ctx->wrap) {
+        /* Move keys into place from the end so in-place is not overwritten. */
+        for (k = cnt; k > 0; k--) {
+            XMEMMOVE(out + (k - 1) * wrapSz + WP_AES_WRAP_SEMI_SZ,
+                in + (k - 1) * itemSz, itemSz);
+        }
+        for (i = 0; ok && (i < cnt); i += WP_AES_WRAP_BATCH_CNT) {
+            int m = (int)((cnt - i < WP_AES_WRAP_BATCH_CNT) ? cnt - i :
+                WP_AES_WRAP_BATCH_CNT);
+
+            ok = wp_aes_wrap_batch_wrap(ctx, out + i * wrapSz, m, iv);
+        }
+        if (ok) {
+            XMEMSET(ctx->batchRes, 0xff, ctx->batchResLen);
+        }
+    }
+    else if (ok) {
+        unsigned char a[WP_AES_WRAP_BATCH_CNT][WP_AES_WRAP_SEMI_SZ];
+
+        for (i = 0; ok && (i < cnt); i += WP_AES_WRAP_BATCH_CNT) {
+            int m = (int)((cnt - i < WP_AES_WRAP_BATCH_CNT) ? cnt - i :
+                WP_AES_WRAP_BATCH_CNT);
+
+            /* Output of a key never overlaps the input of a later key. */
+            for (k = 0; k < (size_t)m; k++) {
+                XMEMCPY(a[k], in + (i + k) * wrapSz, WP_AES_WRAP_SEMI_SZ);
+                XMEMMOVE(out + (i + k) * itemSz,
+                    in + (i + k) * wrapSz + WP_AES_WRAP_SEMI_SZ, itemSz);
+            }
+            ok = wp_aes_wrap_batch_unwrap(ctx, out + i * itemSz, a, m, iv, i);
+        }
+    }
+    if (ok) {
+        *outLen = cnt * outSz;
+    }
+
+    return ok;
+}
+
 /**
  * One-shot wrap/unwrap.
  *
@@ -326,6 +614,9 @@ static int wp_aes_wrap_update(wp_AesWrapCtx *ctx, unsigned char *out,
     if (ok && (inLen == 0)) {
         *outLen = 0;
     }
+    else if (ok && (ctx->batchItemSz != 0)) {
+        ok = wp_aes_wrap_batch(ctx, out, outLen, outSize, in, inLen);
+    }
     else if (ok) {
         int rc;
         word32 outSz = outSize;
@@ -426,6 +717,20 @@ static int wp_aes_wrap_get_ctx_params(wp_AesWrapCtx* ctx, OSSL_PARAM params[])
             ok = 0;
         }
     }
+    if (ok) {
+        p = OSSL_PARAM_locate(params, WP_CIPHER_PARAM_WRAP_BATCH_ITEM_SIZE);
+        if ((p != NULL) && (!OSSL_PARAM_set_size_t(p, ctx->batchItemSz))) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        p = OSSL_PARAM_locate(params, WP_CIPHER_PARAM_WRAP_BATCH_RESULT);
+        if ((p != NULL) && ((ctx->batchRes == NULL) ||
+                (!OSSL_PARAM_set_octet_string(p, ctx->batchRes,
+                    ctx->batchResLen)))) {
+            ok = 0;
+        }
+    }
 
     return ok;
 }
@@ -462,6 +767,25 @@ static int wp_aes_wrap_set_ctx_params(wp_AesWrapCtx *ctx,
         if (ok && (keyLen != ctx->keyLen)) {
             ok = 0;
         }
+
+        if (ok) {
+            size_t itemSz = ctx->batchItemSz;
+
+            if (!wp_params_get_size_t(params,
+                    WP_CIPHER_PARAM_WRAP_BATCH_ITEM_SIZE, &itemSz)) {
+                ok = 0;
+            }
+            /* Keys are at least two semiblocks. */
+            if (ok && (itemSz != 0) &&
+                    ((itemSz < 2 * WP_AES_WRAP_SEMI_SZ) ||
+                     (itemSz > WP_AES_WRAP_MAX_ITEM_SZ) ||
+                     ((itemSz % WP_AES_WRAP_SEMI_SZ) != 0))) {
+                ok = 0;
+            }
+            if (ok) {
+                ctx->batchItemSz = itemSz;
+            }
+        }
     }
 
     return ok;
@@ -0,0 +1,652 @@
+/* wp_aes_xts.c
+ *
+ * Copyright (C) 2021 wolfSSL Inc.
+ *
+ * This file is part of wolfProvider.
+ *
+ * wolfProvider is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfProvider is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wolfProvider.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <openssl/err.h>
+#include <openssl/proverr.h>
+#include <openssl/core_dispatch.h>
+#include <openssl/core_names.h>
+#include <openssl/params.h>
+#include <openssl/evp.h>
+
+#include <wolfprovider/alg_funcs.h>
+
+#ifdef WOLFSSL_AES_XTS
+
+/** Maximum number of blocks in a data unit - IEEE Std 1619-2007. */
+#define WP_AES_XTS_MAX_BLOCKS       (1 << 20)
+
+/**
+ * Data structure for AES-XTS ciphers.
+ */
+typedef struct wp_AesXtsCtx {
+    /** wolfSSL AES-XTS object.  */
+    XtsAes xts;
+
+    /** Provider context - used for device id when setting key. */
+    WOLFPROV_CTX* provCtx;
+
+    /** Key - both halves. Kept to set key for other direction. */
+    unsigned char key[2 * AES_256_KEY_SIZE];
+    /** Length of key in bytes - both halves. */
+    size_t keyLen;
+    /**
+     * Size of data unit in bytes. 0 means each update is one data unit and
+     * the tweak is not changed.
+     */
+    size_t unitSz;
+
+    /** Operation being performed is encryption. */
+    unsigned int enc:1;
+    /** Key has been set. */
+    unsigned int keySet:1;
+    /** Key has been set into wolfSSL object for encryption. */
+    unsigned int keyEnc:1;
+    /** IV has been set. */
+    unsigned int ivSet:1;
+
+    /** Tweak for the next data unit. */
+    unsigned char iv[AES_BLOCK_SIZE];
+    /** Original tweak. */
+    unsigned char oiv[AES_BLOCK_SIZE];
+} wp_AesXtsCtx;
+
+
+/* Prototype for initialization to call. */
+static int wp_aes_xts_set_ctx_params(wp_AesXtsCtx *ctx,
+    const OSSL_PARAM params[]);
+
+
+/**
+ * Free the AES-XTS context object.
+ *
+ * @param [in, out] ctx  AES-XTS context object.
+ */
+static void wp_aes_xts_freectx(wp_AesXtsCtx *ctx)
+{
+    if (ctx->keySet) {
+        wc_AesXtsFree(&ctx->xts);
+    }
+    OPENSSL_clear_free(ctx, sizeof(*ctx));
+}
+
+/**
+ * Set the key into the wolfSSL AES-XTS object for a direction.
+ *
+ * @param [in, out] ctx  AES-XTS context object.
+ * @param [in]      enc  Set key for encryption.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_aes_xts_set_key(wp_AesXtsCtx *ctx, int enc)
+{
+    int ok = 1;
+    int rc;
+
+    if (ctx->keySet) {
+        wc_AesXtsFree(&ctx->xts);
+        ctx->keySet = 0;
+    }
+    rc = wc_AesXtsSetKey(&ctx->xts, ctx->key, (word32)ctx->keyLen,
+        enc ? AES_ENCRYPTION : AES_DECRYPTION, NULL, ctx->provCtx->devId);
+    if (rc != 0) {
+        ok = 0;
+    }
+    else {
+        ctx->keySet = 1;
+        ctx->keyEnc = enc;
+    }
+
+    return ok;
+}
+
+/**
+ * Duplicate the AES-XTS context object.
+ *
+ * wolfSSL AES-XTS object is not copied but has the key set again.
+ *
+ * @param [in] src  AES-XTS context object to copy.
+ * @return  NULL on failure.
+ * @return  AES-XTS context object.
+ */
+static void *wp_aes_xts_dupctx(wp_AesXtsCtx *src)
+{
+    wp_AesXtsCtx *dst = NULL;
+
+    if (wolfssl_prov_is_running()) {
+        dst = OPENSSL_malloc(sizeof(*dst));
+    }
+    if (dst != NULL) {
+        XMEMCPY(dst, src, sizeof(*src));
+        XMEMSET(&dst->xts, 0, sizeof(dst->xts));
+        dst->keySet = 0;
+        if (src->keySet && (!wp_aes_xts_set_key(dst, src->keyEnc))) {
+            wp_aes_xts_freectx(dst);
+            dst = NULL;
+        }
+    }
+
+    return dst;
+}
+
+/**
+ * Returns the parameters that can be retrieved.
+ *
+ * @param [in] provCtx  wolfProvider context object. Unused.
+ * @return  Array of parameters.
+ */
+static const OSSL_PARAM *wp_aes_xts_gettable_params(WOLFPROV_CTX *provCtx)
+{
+    /**
+     * Parameters able to be retrieved for a cipher.
+     */
+    static const OSSL_PARAM cipher_supported_gettable_params[] = {
+        OSSL_PARAM_uint(OSSL_CIPHER_PARAM_MODE, NULL),
+        OSSL_PARAM_size_t(OSSL_CIPHER_PARAM_KEYLEN, NULL),
+        OSSL_PARAM_size_t(OSSL_CIPHER_PARAM_IVLEN, NULL),
+        OSSL_PARAM_size_t(OSSL_CIPHER_PARAM_BLOCK_SIZE, NULL),
+        OSSL_PARAM_int(OSSL_CIPHER_PARAM_CUSTOM_IV, NULL),
+        OSSL_PARAM_int(OSSL_CIPHER_PARAM_HAS_RAND_KEY, NULL),
+        OSSL_PARAM_END
+    };
+    (void)provCtx;
+    return cipher_supported_gettable_params;
+}
+
+/**
+ * Get the values for the AES-XTS cipher for the parameters.
+ *
+ * @param [in, out] params  Array of parameters to retrieve.
+ * @param [in]      kBits   Number of bits in key - both halves.
+ * @return 1 on success.
+ * @return 0 on failure.
+ */
+static int wp_aes_xts_get_params(OSSL_PARAM params[], size_t kBits)
+{
+    int ok = 1;
+    OSSL_PARAM *p;
+
+    p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_MODE);
+    if ((p != NULL) && (!OSSL_PARAM_set_uint(p, EVP_CIPH_XTS_MODE))) {
+        ok = 0;
+    }
+    if (ok) {
+        p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_CUSTOM_IV);
+        if ((p != NULL) && (!OSSL_PARAM_set_int(p, 1))) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_HAS_RAND_KEY);
+        if ((p != NULL) && (!OSSL_PARAM_set_int(p, 0))) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_KEYLEN);
+        if ((p != NULL) && (!OSSL_PARAM_set_size_t(p, kBits / 8))) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_BLOCK_SIZE);
+        if ((p != NULL) && (!OSSL_PARAM_set_size_t(p, 1))) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_IVLEN);
+        if ((p != NULL) && (!OSSL_PARAM_set_size_t(p, AES_BLOCK_SIZE))) {
+            ok = 0;
+        }
+    }
+
+    return ok;
+}
+
+/**
+ * Returns the parameters of a cipher context that can be retrieved.
+ *
+ * @param [in] ctx      AES-XTS context object. Unused.
+ * @param [in] provCtx  wolfProvider context object. Unused.
+ * @return  Array of parameters.
+ */
+static const OSSL_PARAM* wp_aes_xts_gettable_ctx_params(wp_AesXtsCtx* ctx,
+    WOLFPROV_CTX* provCtx)
+{
+    /**
+     * Parameters able to be retrieved for a cipher context.
+     */
+    static const OSSL_PARAM wp_aes_xts_supported_gettable_ctx_params[] = {
+        OSSL_PARAM_size_t(OSSL_CIPHER_PARAM_KEYLEN, NULL),
+        OSSL_PARAM_size_t(OSSL_CIPHER_PARAM_IVLEN, NULL),
+        OSSL_PARAM_octet_string(OSSL_CIPHER_PARAM_IV, NULL, 0),
+        OSSL_PARAM_octet_string(OSSL_CIPHER_PARAM_UPDATED_IV, NULL, 0),
+        OSSL_PARAM_size_t(WP_CIPHER_PARAM_XTS_DATA_UNIT_SIZE, NULL),
+        OSSL_PARAM_END
+    };
+    (void)ctx;
+    (void)provCtx;
+    return wp_aes_xts_supported_gettable_ctx_params;
+}
+
+/**
+ * Returns the parameters of a cipher context that can be set.
+ *
+ * @param [in] ctx      AES-XTS context object. Unused.
+ * @param [in] provCtx  wolfProvider context object. Unused.
+ * @return  Array of parameters.
+ */
+static const OSSL_PARAM* wp_aes_xts_settable_ctx_params(wp_AesXtsCtx* ctx,
+    WOLFPROV_CTX *provCtx)
+{
+    /*
+     * Parameters able to be set into a cipher context.
+     */
+    static const OSSL_PARAM wp_aes_xts_supported_settable_ctx_params[] = {
+        OSSL_PARAM_size_t(WP_CIPHER_PARAM_XTS_DATA_UNIT_SIZE, NULL),
+        OSSL_PARAM_END
+    };
+    (void)ctx;
+    (void)provCtx;
+    return wp_aes_xts_supported_settable_ctx_params;
+}
+
+/**
+ * Initialization of an AES-XTS cipher.
+ *
+ * Internal. Handles both encrypt and decrypt.
+ *
+ * @param [in, out] ctx     AES-XTS context object.
+ * @param [in]      key     Private key data - both halves. May be NULL.
+ * @param [in]      keyLen  Length of private key in bytes.
+ * @param [in]      iv      Tweak data. May be NULL.
+ * @param [in]      ivLen   Length of tweak in bytes.
+ * @param [in]      params  Parameters to set against AES-XTS context object.
+ * @param [in]      enc     Initializing for encryption.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_aes_xts_init(wp_AesXtsCtx *ctx, const unsigned char *key,
+    size_t keyLen, const unsigned char *iv, size_t ivLen,
+    const OSSL_PARAM params[], int enc)
+{
+    int ok = 1;
+
+    if (!wolfssl_prov_is_running()) {
+        ok = 0;
+    }
+    if (ok && (key != NULL)) {
+        if (keyLen != ctx->keyLen) {
+            ok = 0;
+        }
+        /* Key halves must be different - IEEE Std 1619-2007. */
+        if (ok && (CRYPTO_memcmp(key, key + keyLen / 2, keyLen / 2) == 0)) {
+            ok = 0;
+        }
+        if (ok) {
+            XMEMCPY(ctx->key, key, keyLen);
+            ok = wp_aes_xts_set_key(ctx, enc);
+        }
+    }
+    else if (ok && ctx->keySet && (ctx->keyEnc != (unsigned int)enc)) {
+        /* Key schedule is for the other direction. */
+        ok = wp_aes_xts_set_key(ctx, enc);
+    }
+    if (ok) {
+        ctx->enc = enc;
+    }
+    if (ok && (iv != NULL)) {
+        if (ivLen != AES_BLOCK_SIZE) {
+            ok = 0;
+        }
+        else {
+            XMEMCPY(ctx->iv, iv, ivLen);
+            XMEMCPY(ctx->oiv, iv, ivLen);
+            ctx->ivSet = 1;
+        }
+    }
+    if (ok && (iv == NULL) && ctx->ivSet) {
+        XMEMCPY(ctx->iv, ctx->oiv, AES_BLOCK_SIZE);
+    }
+
+    if (ok) {
+        ok = wp_aes_xts_set_ctx_params(ctx, params);
+    }
+
+    return ok;
+}
+
+/**
+ * Initialization of an AES-XTS cipher for encryption.
+ *
+ * @param [in, out] ctx     AES-XTS context object.
+ * @param [in]      key     Private key data. May be NULL.
+ * @param [in]      keyLen  Length of private key in bytes.
+ * @param [in]      iv      Tweak data. May be NULL.
+ * @param [in]      ivLen   Length of tweak in bytes.
+ * @param [in]      params  Parameters to set against AES-XTS context object.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_aes_xts_einit(wp_AesXtsCtx *ctx, const unsigned char *key,
+    size_t keyLen, const unsigned char *iv, size_t ivLen,
+    const OSSL_PARAM params[])
+{
+    return wp_aes_xts_init(ctx, key, keyLen, iv, ivLen, params, 1);
+}
+
+/**
+ * Initialization of an AES-XTS cipher for decryption.
+ *
+ * @param [in, out] ctx     AES-XTS context object.
+ * @param [in]      key     Private key data. May be NULL.
+ * @param [in]      keyLen  Length of private key in bytes.
+ * @param [in]      iv      Tweak data. May be NULL.
+ * @param [in]      ivLen   Length of tweak in bytes.
+ * @param [in]      params  Parameters to set against AES-XTS context object.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_aes_xts_dinit(wp_AesXtsCtx *ctx, const unsigned char *key,
+    size_t keyLen, const unsigned char *iv, size_t ivLen,
+    const OSSL_PARAM params[])
+{
+    return wp_aes_xts_init(ctx, key, keyLen, iv, ivLen, params, 0);
+}
+
+/**
+ * Increment the tweak as a 128-bit little-endian number.
+ *
+ * Matches the sector number encoding of IEEE Std 1619-2007.
+ *
+ * @param [in, out] tweak  Tweak to increment.
+ */
+static void wp_aes_xts_inc_tweak(unsigned char *tweak)
+{
+    int i;
+
+    for (i = 0; i < AES_BLOCK_SIZE; i++) {
+        if (++tweak[i] != 0) {
+            break;
+        }
+    }
+}
+
+/**
+ * Encrypt/decrypt one data unit using AES-XTS with wolfSSL.
+ *
+ * @param [in]  ctx    AES-XTS context object.
+ * @param [out] out    Buffer to hold encrypted/decrypted result.
+ * @param [in]  in     Data to encrypt/decrypt.
+ * @param [in]  inLen  Length of data unit in bytes.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_aes_xts_doit(wp_AesXtsCtx *ctx, unsigned char *out,
+    const unsigned char *in, size_t inLen)
+{
+    int rc;
+
+    if (ctx->enc) {
+        rc = wc_AesXtsEncrypt(&ctx->xts, out, in, (word32)inLen, ctx->iv,
+            AES_BLOCK_SIZE);
+    }
+    else {
+        rc = wc_AesXtsDecrypt(&ctx->xts, out, in, (word32)inLen, ctx->iv,
+            AES_BLOCK_SIZE);
+    }
+
+    return rc == 0;
+}
+
+/**
+ * Encrypt/decrypt data with AES-XTS.
+ *
+ * When a data unit size is set, the input is a sequence of whole data units
+ * and the tweak is incremented after each one. Otherwise the input is a
+ * single data unit and the tweak is left unchanged.
+ *
+ * @param [in]  ctx      AES-XTS context object.
+ * @param [out] out      Buffer to hold encrypted/decrypted result.
+ * @param [out] outLen   Length of encrypted/decrypted data in bytes.
+ * @param [in]  outSize  Size of output buffer in bytes.
+ * @param [in]  in       Data to encrypt/decrypt.
+ * @param [in]  inLen    Length of data in bytes.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_aes_xts_update(wp_AesXtsCtx *ctx, unsigned char *out,
+    size_t *outLen, size_t outSize, const unsigned char *in, size_t inLen)
+{
+    int ok = 1;
+
+    if (!wolfssl_prov_is_running()) {
+        ok = 0;
+    }
+    if (ok && ((!ctx->keySet) || (!ctx->ivSet))) {
+        ok = 0;
+    }
+    if (ok && ((outSize < inLen) || (inLen < AES_BLOCK_SIZE))) {
+        ok = 0;
+    }
+    if (ok && (ctx->unitSz == 0)) {
+        if (inLen > (size_t)WP_AES_XTS_MAX_BLOCKS * AES_BLOCK_SIZE) {
+            ok = 0;
+        }
+        if (ok) {
+            ok = wp_aes_xts_doit(ctx, out, in, inLen);
+        }
+    }
+    else if (ok) {
+        size_t i;
+
+        if ((inLen % ctx->unitSz) != 0) {
+            ok = 0;
+        }
+        for (i = 0; ok && (i < inLen); i += ctx->unitSz) {
+            ok = wp_aes_xts_doit(ctx, out + i, in + i, ctx->unitSz);
+            wp_aes_xts_inc_tweak(ctx->iv);
+        }
+    }
+    if (ok) {
+        *outLen = inLen;
+    }
+
+    return ok;
+}
+
+/**
+ * Finalize AES-XTS encryption/decryption.
+ *
+ * @param [in]  ctx      AES-XTS context object.
+ * @param [out] out      Buffer to hold encrypted/decrypted data.
+ * @param [out] outLen   Length of data encrypted/decrypted in bytes.
+ * @param [in]  outSize  Size of buffer.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_aes_xts_final(wp_AesXtsCtx* ctx, unsigned char *out,
+    size_t *outLen, size_t outSize)
+{
+    /* Nothing to do as all the data has been processed in update. */
+    (void)ctx;
+    (void)out;
+    (void)outSize;
+    *outLen = 0;
+    return wolfssl_prov_is_running();
+}
+
+/**
+ * Put values from the AES-XTS context object into parameters objects.
+ *
+ * @param [in]      ctx     AES-XTS context object.
+ * @param [in, out] params  Array of parameters objects.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_aes_xts_get_ctx_params(wp_AesXtsCtx* ctx, OSSL_PARAM params[])
+{
+    int ok = 1;
+    OSSL_PARAM* p;
+
+    p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_IVLEN);
+    if ((p != NULL) && (!OSSL_PARAM_set_size_t(p, AES_BLOCK_SIZE))) {
+        ok = 0;
+    }
+    if (ok) {
+        p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_IV);
+        if ((p != NULL) &&
+            (!OSSL_PARAM_set_octet_ptr(p, &ctx->oiv, AES_BLOCK_SIZE)) &&
+            (!OSSL_PARAM_set_octet_string(p, &ctx->oiv, AES_BLOCK_SIZE))) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_UPDATED_IV);
+        if ((p != NULL) &&
+            (!OSSL_PARAM_set_octet_ptr(p, &ctx->iv, AES_BLOCK_SIZE)) &&
+            (!OSSL_PARAM_set_octet_string(p, &ctx->iv, AES_BLOCK_SIZE))) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_KEYLEN);
+        if ((p != NULL) && (!OSSL_PARAM_set_size_t(p, ctx->keyLen))) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        p = OSSL_PARAM_locate(params, WP_CIPHER_PARAM_XTS_DATA_UNIT_SIZE);
+        if ((p != NULL) && (!OSSL_PARAM_set_size_t(p, ctx->unitSz))) {
+            ok = 0;
+        }
+    }
+
+    return ok;
+}
+
+/**
+ * Sets the parameters to use into AES-XTS context object.
+ *
+ * @param [in, out] ctx     AES-XTS context object.
+ * @param [in]      params  Array of parameter objects.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_aes_xts_set_ctx_params(wp_AesXtsCtx *ctx,
+    const OSSL_PARAM params[])
+{
+    int ok = 1;
+
+    if (params != NULL) {
+        size_t unitSz = ctx->unitSz;
+
+        if (!wp_params_get_size_t(params, WP_CIPHER_PARAM_XTS_DATA_UNIT_SIZE,
+                &unitSz)) {
+            ok = 0;
+        }
+        if (ok && (unitSz != 0) && ((unitSz < AES_BLOCK_SIZE) ||
+                (unitSz > (size_t)WP_AES_XTS_MAX_BLOCKS * AES_BLOCK_SIZE))) {
+            ok = 0;
+        }
+        if (ok) {
+            ctx->unitSz = unitSz;
+        }
+    }
+
+    return ok;
+}
+
+
+/** Implements the get parameters API for an XTS cipher. */
+#define IMPLEMENT_AES_XTS_GET_PARAMS(kBits)                                    \
+/**                                                                            \
+ * Get the values from the AES-XTS context for the parameters.                 \
+ *                                                                             \
+ * @param [in, out] params  Array of parameters to retrieve.                   \
+ * @return 1 on success.                                                       \
+ * @return 0 on failure.                                                       \
+ */                                                                            \
+static int wp_aes_##kBits##_xts_get_params(OSSL_PARAM params[])                \
+{                                                                              \
+    return wp_aes_xts_get_params(params, 2 * kBits);                           \
+}
+
+/** Implements the new context API for an XTS cipher. */
+#define IMPLEMENT_AES_XTS_NEWCTX(kBits)                                        \
+/**                                                                            \
+ * Create a new AES-XTS context object.                                        \
+ *                                                                             \
+ * @param [in] provCtx  Provider context object.                               \
+ * @return  NULL on failure.                                                   \
+ * @return  AES-XTS context object on success.                                 \
+ */                                                                            \
+static wp_AesXtsCtx* wp_aes_xts_##kBits##_newctx(WOLFPROV_CTX *provCtx)        \
+{                                                                              \
+    wp_AesXtsCtx *ctx = NULL;                                                  \
+    if (wolfssl_prov_is_running()) {                                           \
+        ctx = OPENSSL_zalloc(sizeof(*ctx));                                    \
+    }                                                                          \
+    if (ctx != NULL) {                                                         \
+        ctx->provCtx = provCtx;                                                \
+        ctx->keyLen = (2 * kBits) / 8;                                         \
+    }                                                                          \
+    return ctx;                                                                \
+}
+
+/** Implements dispatch table for an XTS cipher. */
+#define IMPLEMENT_AES_XTS_DISPATCH(kBits)                                      \
+const OSSL_DISPATCH wp_aes##kBits##xts_functions[] = {                         \
+    { OSSL_FUNC_CIPHER_NEWCTX,          (DFUNC)wp_aes_xts_##kBits##_newctx  }, \
+    { OSSL_FUNC_CIPHER_FREECTX,         (DFUNC)wp_aes_xts_freectx           }, \
+    { OSSL_FUNC_CIPHER_DUPCTX,          (DFUNC)wp_aes_xts_dupctx            }, \
+    { OSSL_FUNC_CIPHER_ENCRYPT_INIT,    (DFUNC)wp_aes_xts_einit             }, \
+    { OSSL_FUNC_CIPHER_DECRYPT_INIT,    (DFUNC)wp_aes_xts_dinit             }, \
+    { OSSL_FUNC_CIPHER_UPDATE,          (DFUNC)wp_aes_xts_update            }, \
+    { OSSL_FUNC_CIPHER_FINAL,           (DFUNC)wp_aes_xts_final             }, \
+    { OSSL_FUNC_CIPHER_CIPHER,          (DFUNC)wp_aes_xts_update            }, \
+    { OSSL_FUNC_CIPHER_GET_PARAMS,                                             \
+                                  (DFUNC)wp_aes_##kBits##_xts_get_params    }, \
+    { OSSL_FUNC_CIPHER_GET_CTX_PARAMS,  (DFUNC)wp_aes_xts_get_ctx_params    }, \
+    { OSSL_FUNC_CIPHER_SET_CTX_PARAMS,  (DFUNC)wp_aes_xts_set_ctx_params    }, \
+    { OSSL_FUNC_CIPHER_GETTABLE_PARAMS, (DFUNC)wp_aes_xts_gettable_params   }, \
+    { OSSL_FUNC_CIPHER_GETTABLE_CTX_PARAMS,                                    \
+                                  (DFUNC)wp_aes_xts_gettable_ctx_params     }, \
+    { OSSL_FUNC_CIPHER_SETTABLE_CTX_PARAMS,                                    \
+                                  (DFUNC)wp_aes_xts_settable_ctx_params     }, \
+    { 0, NULL }                                                                \
+};
+
+/** Implements the functions calling base functions for an XTS cipher. */
+#define IMPLEMENT_AES_XTS(kBits)                                               \
+IMPLEMENT_AES_XTS_GET_PARAMS(kBits)                                            \
+IMPLEMENT_AES_XTS_NEWCTX(kBits)                                                \
+IMPLEMENT_AES_XTS_DISPATCH(kBits)
+
+/*
+ * AES XTS
+ */
+
+/** wp_aes256xts_functions */
+IMPLEMENT_AES_XTS(256)
+/** wp_aes128xts_functions */
+IMPLEMENT_AES_XTS(128)
+
+#endif /* WOLFSSL_AES_XTS */
@@ -0,0 +1,821 @@
+/* wp_chacha20_poly1305.c
+ *
+ * Copyright (C) 2021 wolfSSL Inc.
+ *
+ * This file is part of wolfProvider.
+ *
+ * wolfProvider is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfProvider is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wolfProvider.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <openssl/err.h>
+#include <openssl/proverr.h>
+#include <openssl/core_dispatch.h>
+#include <openssl/core_names.h>
+#include <openssl/params.h>
+#include <openssl/evp.h>
+
+#include <wolfprovider/alg_funcs.h>
+
+#if defined(HAVE_CHACHA) && defined(HAVE_POLY1305)
+
+/** Length of ChaCha20-Poly1305 key in bytes. */
+#define WP_CHACHA_POLY_KEY_LEN      CHACHA20_POLY1305_AEAD_KEYSIZE
+/** Length of ChaCha20-Poly1305 nonce in bytes. */
+#define WP_CHACHA_POLY_IV_LEN       CHACHA20_POLY1305_AEAD_IV_SIZE
+/** Length of ChaCha20-Poly1305 authentication tag in bytes. */
+#define WP_CHACHA_POLY_TAG_LEN      CHACHA20_POLY1305_AEAD_AUTHTAG_SIZE
+/** Length of TLS sequence number that is XORed into nonce - RFC 7905. */
+#define WP_CHACHA_POLY_TLS_SEQ_LEN  8
+
+/** Uninitialized value for a field of type size_t. */
+#define UNINITIALISED_SIZET      ((size_t)-1)
+
+/**
+ * ChaCha20-Poly1305 AEAD context.
+ */
+typedef struct wp_ChaChaPolyCtx {
+    /** wolfSSL ChaCha20-Poly1305 streaming object. */
+    ChaChaPoly_Aead aead;
+
+    /** Authentication tag length.  */
+    size_t tagLen;
+    /** TLS pad size - tag appended to record. */
+    size_t tlsAadPadSz;
+    /** Length of TLS record payload. UNINITIALISED_SIZET when not TLS. */
+    size_t tlsPayloadLen;
+
+    /** Initialized for encryption or decryption. */
+    unsigned int enc:1;
+    /** Key has been set. */
+    unsigned int keySet:1;
+    /** Nonce has been set. */
+    unsigned int ivSet:1;
+    /** wolfSSL object initialized with key and nonce for operation. */
+    unsigned int started:1;
+
+    /** Key - needed to restart for each message. */
+    unsigned char key[WP_CHACHA_POLY_KEY_LEN];
+    /** Nonce or fixed TLS nonce. */
+    unsigned char iv[WP_CHACHA_POLY_IV_LEN];
+    /** Nonce of TLS record - fixed nonce XORed with sequence number. */
+    unsigned char tlsIv[WP_CHACHA_POLY_IV_LEN];
+    /** TLS AAD with length corrected for tag. */
+    unsigned char tlsAad[EVP_AEAD_TLS1_AAD_LEN];
+    /** Calculated or expected authentication tag. */
+    unsigned char tag[WP_CHACHA_POLY_TAG_LEN];
+} wp_ChaChaPolyCtx;
+
+
+/* Prototype for initialization to call. */
+static int wp_chacha20_poly1305_set_ctx_params(wp_ChaChaPolyCtx* ctx,
+    const OSSL_PARAM params[]);
+
+
+/**
+ * Create a new ChaCha20-Poly1305 context object.
+ *
+ * @param [in] provCtx  Provider context object. Unused.
+ * @return  NULL on failure.
+ * @return  ChaCha20-Poly1305 context object on success.
+ */
+static wp_ChaChaPolyCtx* wp_chacha20_poly1305_newctx(WOLFPROV_CTX* provCtx)
+{
+    wp_ChaChaPolyCtx* ctx = NULL;
+
+    (void)provCtx;
+
+    if (wolfssl_prov_is_running()) {
+        ctx = OPENSSL_zalloc(sizeof(*ctx));
+    }
+    if (ctx != NULL) {
+        ctx->tagLen = WP_CHACHA_POLY_TAG_LEN;
+        ctx->tlsPayloadLen = UNINITIALISED_SIZET;
+    }
+
+    return ctx;
+}
+
+/**
+ * Dispose of a ChaCha20-Poly1305 context object.
+ *
+ * @param [in, out] ctx  ChaCha20-Poly1305 context object.
+ */
+static void wp_chacha20_poly1305_freectx(wp_ChaChaPolyCtx* ctx)
+{
+    OPENSSL_clear_free(ctx, sizeof(*ctx));
+}
+
+/**
+ * Duplicate the ChaCha20-Poly1305 context object.
+ *
+ * @param [in] src  ChaCha20-Poly1305 context object to copy.
+ * @return  NULL on failure.
+ * @return  ChaCha20-Poly1305 context object.
+ */
+static wp_ChaChaPolyCtx* wp_chacha20_poly1305_dupctx(wp_ChaChaPolyCtx* src)
+{
+    wp_ChaChaPolyCtx* dst = NULL;
+
+    if (wolfssl_prov_is_running()) {
+        dst = OPENSSL_malloc(sizeof(*dst));
+    }
+    if (dst != NULL) {
+        XMEMCPY(dst, src, sizeof(*src));
+    }
+
+    return dst;
+}
+
+/**
+ * Return an array of supported gettable parameters for the cipher.
+ *
+ * @param [in] provCtx  Provider context object. Unused.
+ * @return  Array of parameters with data type.
+ */
+static const OSSL_PARAM* wp_chacha20_poly1305_gettable_params(
+    WOLFPROV_CTX* provCtx)
+{
+    /**
+     * Supported gettable parameters for cipher.
+     */
+    static const OSSL_PARAM wp_chachapoly_supported_gettable_params[] = {
+        OSSL_PARAM_uint(OSSL_CIPHER_PARAM_MODE, NULL),
+        OSSL_PARAM_size_t(OSSL_CIPHER_PARAM_KEYLEN, NULL),
+        OSSL_PARAM_size_t(OSSL_CIPHER_PARAM_IVLEN, NULL),
+        OSSL_PARAM_size_t(OSSL_CIPHER_PARAM_BLOCK_SIZE, NULL),
+        OSSL_PARAM_int(OSSL_CIPHER_PARAM_AEAD, NULL),
+        OSSL_PARAM_int(OSSL_CIPHER_PARAM_CUSTOM_IV, NULL),
+        OSSL_PARAM_int(OSSL_CIPHER_PARAM_HAS_RAND_KEY, NULL),
+        OSSL_PARAM_END
+    };
+    (void)provCtx;
+    return wp_chachapoly_supported_gettable_params;
+}
+
+/**
+ * Get the ChaCha20-Poly1305 cipher parameters.
+ *
+ * @param [in, out] params  Array of parameters and values.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_chacha20_poly1305_get_params(OSSL_PARAM params[])
+{
+    int ok = 1;
+    OSSL_PARAM* p;
+
+    p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_MODE);
+    if ((p != NULL) && (!OSSL_PARAM_set_uint(p, 0))) {
+        ok = 0;
+    }
+    if (ok) {
+        p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_AEAD);
+        if ((p != NULL) && (!OSSL_PARAM_set_int(p, 1))) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_CUSTOM_IV);
+        if ((p != NULL) && (!OSSL_PARAM_set_int(p, 1))) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_HAS_RAND_KEY);
+        if ((p != NULL) && (!OSSL_PARAM_set_int(p, 0))) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_KEYLEN);
+        if ((p != NULL) &&
+                (!OSSL_PARAM_set_size_t(p, WP_CHACHA_POLY_KEY_LEN))) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_BLOCK_SIZE);
+        if ((p != NULL) && (!OSSL_PARAM_set_size_t(p, 1))) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_IVLEN);
+        if ((p != NULL) &&
+                (!OSSL_PARAM_set_size_t(p, WP_CHACHA_POLY_IV_LEN))) {
+            ok = 0;
+        }
+    }
+
+    return ok;
+}
+
+/**
+ * Return an array of supported gettable parameters for the context.
+ *
+ * @param [in] ctx      ChaCha20-Poly1305 context object. Unused.
+ * @param [in] provCtx  Provider context object. Unused.
+ * @return  Array of parameters with data type.
+ */
+static const OSSL_PARAM* wp_chacha20_poly1305_gettable_ctx_params(
+    wp_ChaChaPolyCtx* ctx, WOLFPROV_CTX* provCtx)
+{
+    /**
+     * Supported gettable parameters for context.
+     */
+    static const OSSL_PARAM wp_chachapoly_supported_gettable_ctx_params[] = {
+        OSSL_PARAM_size_t(OSSL_CIPHER_PARAM_KEYLEN, NULL),
+        OSSL_PARAM_size_t(OSSL_CIPHER_PARAM_IVLEN, NULL),
+        OSSL_PARAM_size_t(OSSL_CIPHER_PARAM_AEAD_TAGLEN, NULL),
+        OSSL_PARAM_octet_string(OSSL_CIPHER_PARAM_AEAD_TAG, NULL, 0),
+        OSSL_PARAM_size_t(OSSL_CIPHER_PARAM_AEAD_TLS1_AAD_PAD, NULL),
+        OSSL_PARAM_END
+    };
+    (void)ctx;
+    (void)provCtx;
+    return wp_chachapoly_supported_gettable_ctx_params;
+}
+
+/**
+ * Return an array of supported settable parameters for the context.
+ *
+ * @param [in] ctx      ChaCha20-Poly1305 context object. Unused.
+ * @param [in] provCtx  Provider context object. Unused.
+ * @return  Array of parameters with data type.
+ */
+static const OSSL_PARAM* wp_chacha20_poly1305_settable_ctx_params(
+    wp_ChaChaPolyCtx* ctx, WOLFPROV_CTX* provCtx)
+{
+    /**
+     * Supported settable parameters for context.
+     */
+    static const OSSL_PARAM wp_chachapoly_supported_settable_ctx_params[] = {
+        OSSL_PARAM_size_t(OSSL_CIPHER_PARAM_KEYLEN, NULL),
+        OSSL_PARAM_size_t(OSSL_CIPHER_PARAM_AEAD_IVLEN, NULL),
+        OSSL_PARAM_octet_string(OSSL_CIPHER_PARAM_AEAD_TAG, NULL, 0),
+        OSSL_PARAM_octet_string(OSSL_CIPHER_PARAM_AEAD_TLS1_AAD, NULL, 0),
+        OSSL_PARAM_octet_string(OSSL_CIPHER_PARAM_AEAD_TLS1_IV_FIXED, NULL, 0),
+        OSSL_PARAM_END
+    };
+    (void)ctx;
+    (void)provCtx;
+    return wp_chachapoly_supported_settable_ctx_params;
+}
+
+/**
+ * Get the ChaCha20-Poly1305 context parameters.
+ *
+ * @param [in]      ctx     ChaCha20-Poly1305 context object.
+ * @param [in, out] params  Array of parameters and values.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_chacha20_poly1305_get_ctx_params(wp_ChaChaPolyCtx* ctx,
+    OSSL_PARAM params[])
+{
+    int ok = 1;
+    OSSL_PARAM* p;
+
+    p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_IVLEN);
+    if ((p != NULL) && (!OSSL_PARAM_set_size_t(p, WP_CHACHA_POLY_IV_LEN))) {
+        ok = 0;
+    }
+    if (ok) {
+        p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_KEYLEN);
+        if ((p != NULL) &&
+                (!OSSL_PARAM_set_size_t(p, WP_CHACHA_POLY_KEY_LEN))) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_AEAD_TAGLEN);
+        if ((p != NULL) && (!OSSL_PARAM_set_size_t(p, ctx->tagLen))) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_AEAD_TLS1_AAD_PAD);
+        if ((p != NULL) && (!OSSL_PARAM_set_size_t(p, ctx->tlsAadPadSz))) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_AEAD_TAG);
+        if (p != NULL) {
+            size_t sz = p->data_size;
+
+            if ((!ctx->enc) || (p->data_type != OSSL_PARAM_OCTET_STRING) ||
+                    (sz == 0) || (sz > WP_CHACHA_POLY_TAG_LEN)) {
+                ok = 0;
+            }
+            if (ok && (!OSSL_PARAM_set_octet_string(p, ctx->tag, sz))) {
+                ok = 0;
+            }
+        }
+    }
+
+    return ok;
+}
+
+/**
+ * Initialize for use with TLS. Return extra padding (tag length).
+ *
+ * Record nonce is the fixed nonce XORed with the sequence number that is at
+ * the start of the AAD - RFC 7905.
+ *
+ * @param [in, out] ctx     ChaCha20-Poly1305 context object.
+ * @param [in]      aad     Additional authentication data.
+ * @param [in]      aadLen  Length of AAD in bytes.
+ * @return  Length of extra padding in bytes on success.
+ * @return  0 on failure.
+ */
+static size_t wp_chacha20_poly1305_tls_init(wp_ChaChaPolyCtx* ctx,
+    const unsigned char* aad, size_t aadLen)
+{
+    int ok = 1;
+    size_t len = 0;
+
+    if (aadLen != EVP_AEAD_TLS1_AAD_LEN) {
+        ok = 0;
+    }
+    if (ok) {
+        XMEMCPY(ctx->tlsAad, aad, aadLen);
+        len = ((size_t)aad[aadLen - 2] << 8) | aad[aadLen - 1];
+        /* If decrypting, correct for tag too. */
+        if (!ctx->enc) {
+            if (len < WP_CHACHA_POLY_TAG_LEN) {
+                ok = 0;
+            }
+            else {
+                len -= WP_CHACHA_POLY_TAG_LEN;
+                ctx->tlsAad[aadLen - 2] = (unsigned char)(len >> 8);
+                ctx->tlsAad[aadLen - 1] = (unsigned char)len;
+            }
+        }
+    }
+    if (ok) {
+        size_t i;
+        size_t off = WP_CHACHA_POLY_IV_LEN - WP_CHACHA_POLY_TLS_SEQ_LEN;
+
+        XMEMCPY(ctx->tlsIv, ctx->iv, WP_CHACHA_POLY_IV_LEN);
+        for (i = 0; i < WP_CHACHA_POLY_TLS_SEQ_LEN; i++) {
+            ctx->tlsIv[off + i] ^= aad[i];
+        }
+        ctx->tlsPayloadLen = len;
+    }
+
+    return ok ? WP_CHACHA_POLY_TAG_LEN : 0;
+}
+
+/**
+ * Set the ChaCha20-Poly1305 context parameters.
+ *
+ * @param [in, out] ctx     ChaCha20-Poly1305 context object.
+ * @param [in]      params  Array of parameters and values.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_chacha20_poly1305_set_ctx_params(wp_ChaChaPolyCtx* ctx,
+    const OSSL_PARAM params[])
+{
+    int ok = 1;
+    const OSSL_PARAM* p;
+    size_t sz;
+
+    if (params != NULL) {
+        p = OSSL_PARAM_locate_const(params, OSSL_CIPHER_PARAM_KEYLEN);
+        if (p != NULL) {
+            if ((!OSSL_PARAM_get_size_t(p, &sz)) ||
+                    (sz != WP_CHACHA_POLY_KEY_LEN)) {
+                ok = 0;
+            }
+        }
+    }
+    if (ok && (params != NULL)) {
+        p = OSSL_PARAM_locate_const(params, OSSL_CIPHER_PARAM_AEAD_IVLEN);
+        if (p != NULL) {
+            if ((!OSSL_PARAM_get_size_t(p, &sz)) ||
+                    (sz != WP_CHACHA_POLY_IV_LEN)) {
+                ok = 0;
+            }
+        }
+    }
+    if (ok && (params != NULL)) {
+        p = OSSL_PARAM_locate_const(params, OSSL_CIPHER_PARAM_AEAD_TAG);
+        if (p != NULL) {
+            if (p->data_type != OSSL_PARAM_OCTET_STRING) {
+                ok = 0;
+            }
+            else if (p->data != NULL) {
+                void* vp = ctx->tag;
+
+                if (ctx->enc || (!OSSL_PARAM_get_octet_string(p, &vp,
+                        WP_CHACHA_POLY_TAG_LEN, &sz))) {
+                    ok = 0;
+                }
+            }
+            else {
+                sz = p->data_size;
+            }
+            if (ok && ((sz == 0) || (sz > WP_CHACHA_POLY_TAG_LEN))) {
+                ok = 0;
+            }
+            if (ok) {
+                ctx->tagLen = sz;
+            }
+        }
+    }
+    if (ok && (params != NULL)) {
+        p = OSSL_PARAM_locate_const(params, OSSL_CIPHER_PARAM_AEAD_TLS1_AAD);
+        if (p != NULL) {
+            if (p->data_type != OSSL_PARAM_OCTET_STRING) {
+                ok = 0;
+            }
+            else {
+                sz = wp_chacha20_poly1305_tls_init(ctx, p->data,
+                    p->data_size);
+                if (sz == 0) {
+                    ok = 0;
+                }
+                ctx->tlsAadPadSz = sz;
+            }
+        }
+    }
+    if (ok && (params != NULL)) {
+        p = OSSL_PARAM_locate_const(params,
+            OSSL_CIPHER_PARAM_AEAD_TLS1_IV_FIXED);
+        if (p != NULL) {
+            if ((p->data_type != OSSL_PARAM_OCTET_STRING) ||
+                    (p->data_size != WP_CHACHA_POLY_IV_LEN)) {
+                ok = 0;
+            }
+            else {
+                XMEMCPY(ctx->iv, p->data, WP_CHACHA_POLY_IV_LEN);
+                ctx->ivSet = 1;
+                ctx->started = 0;
+            }
+        }
+    }
+
+    return ok;
+}
+
+/**
+ * Initialization of ChaCha20-Poly1305.
+ *
+ * Internal. Handles both encrypt and decrypt.
+ *
+ * @param [in, out] ctx     ChaCha20-Poly1305 context object.
+ * @param [in]      key     Private key data. May be NULL.
+ * @param [in]      keyLen  Length of private key in bytes.
+ * @param [in]      iv      Nonce data. May be NULL.
+ * @param [in]      ivLen   Length of nonce in bytes.
+ * @param [in]      params  Parameters to set against context.
+ * @param [in]      enc     Initializing for encryption.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_chacha20_poly1305_init(wp_ChaChaPolyCtx* ctx,
+    const unsigned char* key, size_t keyLen, const unsigned char* iv,
+    size_t ivLen, const OSSL_PARAM params[], int enc)
+{
+    int ok = 1;
+
+    if (!wolfssl_prov_is_running()) {
+        ok = 0;
+    }
+    if (ok) {
+        ctx->enc = enc;
+        ctx->started = 0;
+        ctx->tlsPayloadLen = UNINITIALISED_SIZET;
+    }
+    if (ok && (key != NULL)) {
+        if (keyLen != WP_CHACHA_POLY_KEY_LEN) {
+            ok = 0;
+        }
+        else {
+            XMEMCPY(ctx->key, key, keyLen);
+            ctx->keySet = 1;
+        }
+    }
+    if (ok && (iv != NULL)) {
+        if (ivLen != WP_CHACHA_POLY_IV_LEN) {
+            ok = 0;
+        }
+        else {
+            XMEMCPY(ctx->iv, iv, ivLen);
+            ctx->ivSet = 1;
+        }
+    }
+    if (ok) {
+        ok = wp_chacha20_poly1305_set_ctx_params(ctx, params);
+    }
+
+    return ok;
+}
+
+/**
+ * Initialization of ChaCha20-Poly1305 for encryption.
+ *
+ * @param [in, out] ctx     ChaCha20-Poly1305 context object.
+ * @param [in]      key     Private key data. May be NULL.
+ * @param [in]      keyLen  Length of private key in bytes.
+ * @param [in]      iv      Nonce data. May be NULL.
+ * @param [in]      ivLen   Length of nonce in bytes.
+ * @param [in]      params  Parameters to set against context.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_chacha20_poly1305_einit(wp_ChaChaPolyCtx* ctx,
+    const unsigned char* key, size_t keyLen, const unsigned char* iv,
+    size_t ivLen, const OSSL_PARAM params[])
+{
+    return wp_chacha20_poly1305_init(ctx, key, keyLen, iv, ivLen, params, 1);
+}
+
+/**
+ * Initialization of ChaCha20-Poly1305 for decryption.
+ *
+ * @param [in, out] ctx     ChaCha20-Poly1305 context object.
+ * @param [in]      key     Private key data. May be NULL.
+ * @param [in]      keyLen  Length of private key in bytes.
+ * @param [in]      iv      Nonce data. May be NULL.
+ * @param [in]      ivLen   Length of nonce in bytes.
+ * @param [in]      params  Parameters to set against context.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_chacha20_poly1305_dinit(wp_ChaChaPolyCtx* ctx,
+    const unsigned char* key, size_t keyLen, const unsigned char* iv,
+    size_t ivLen, const OSSL_PARAM params[])
+{
+    return wp_chacha20_poly1305_init(ctx, key, keyLen, iv, ivLen, params, 0);
+}
+
+/**
+ * Encrypt or decrypt a TLS 1.2 record with ChaCha20-Poly1305.
+ *
+ * One-shot with the record nonce and AAD calculated when AAD was set.
+ *
+ * @param [in, out] ctx     ChaCha20-Poly1305 context object.
+ * @param [out]     out     Buffer to hold encrypted/decrypted data.
+ * @param [out]     outLen  Length of data in output buffer.
+ * @param [in]      in      Data to be encrypted/decrypted.
+ * @param [in]      len     Length of record including tag in bytes.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_chacha20_poly1305_tls_cipher(wp_ChaChaPolyCtx* ctx,
+    unsigned char* out, size_t* outLen, const unsigned char* in, size_t len)
+{
+    int ok = 1;
+    size_t pLen = ctx->tlsPayloadLen;
+    size_t oLen = 0;
+    word64 mStart = wp_metrics_start();
+
+    if ((!ctx->keySet) || (!ctx->ivSet) || (out == NULL)) {
+        ok = 0;
+    }
+    if (ok && (len != pLen + WP_CHACHA_POLY_TAG_LEN)) {
+        ok = 0;
+    }
+    if (ok && ctx->enc) {
+        int rc = wc_ChaCha20Poly1305_Encrypt(ctx->key, ctx->tlsIv,
+            ctx->tlsAad, EVP_AEAD_TLS1_AAD_LEN, in, (word32)pLen, out,
+            out + pLen);
+        if (rc != 0) {
+            ok = 0;
+        }
+        else {
+            oLen = len;
+        }
+    }
+    else if (ok) {
+        int rc = wc_ChaCha20Poly1305_Decrypt(ctx->key, ctx->tlsIv,
+            ctx->tlsAad, EVP_AEAD_TLS1_AAD_LEN, in, (word32)pLen, in + pLen,
+            out);
+        if (rc != 0) {
+            OPENSSL_cleanse(out, pLen);
+            ok = 0;
+        }
+        else {
+            oLen = pLen;
+        }
+    }
+    if (ok) {
+        wp_metrics_record(WP_METRIC_CHACHA20_POLY1305_TLS, mStart, pLen);
+    }
+
+    ctx->tlsPayloadLen = UNINITIALISED_SIZET;
+    *outLen = oLen;
+    return ok;
+}
+
+/**
+ * Initialize the wolfSSL object with key and nonce when not yet done.
+ *
+ * @param [in, out] ctx  ChaCha20-Poly1305 context object.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_chacha20_poly1305_start(wp_ChaChaPolyCtx* ctx)
+{
+    int ok = 1;
+
+    if (!ctx->started) {
+        if ((!ctx->keySet) || (!ctx->ivSet)) {
+            ok = 0;
+        }
+        if (ok && (wc_ChaCha20Poly1305_Init(&ctx->aead, ctx->key, ctx->iv,
+                ctx->enc ? CHACHA20_POLY1305_AEAD_ENCRYPT :
+                           CHACHA20_POLY1305_AEAD_DECRYPT) != 0)) {
+            ok = 0;
+        }
+        if (ok) {
+            ctx->started = 1;
+        }
+    }
+
+    return ok;
+}
+
+/**
+ * Streaming update of ChaCha20-Poly1305.
+ *
+ * When out is NULL, the data is AAD.
+ *
+ * @param [in, out] ctx      ChaCha20-Poly1305 context object.
+ * @param [out]     out      Buffer to hold encrypted/decrypted data.
+ * @param [out]     outLen   Length of data in output buffer.
+ * @param [in]      outSize  Size of output buffer in bytes.
+ * @param [in]      in       Data to be encrypted/decrypted.
+ * @param [in]      inLen    Length of data to be encrypted/decrypted.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_chacha20_poly1305_update(wp_ChaChaPolyCtx* ctx,
+    unsigned char* out, size_t* outLen, size_t outSize,
+    const unsigned char* in, size_t inLen)
+{
+    int ok = 1;
+
+    if (!wolfssl_prov_is_running()) {
+        ok = 0;
+    }
+    if (ok && (ctx->tlsPayloadLen != UNINITIALISED_SIZET)) {
+        if (outSize < inLen) {
+            ok = 0;
+        }
+        if (ok) {
+            ok = wp_chacha20_poly1305_tls_cipher(ctx, out, outLen, in, inLen);
+        }
+    }
+    else if (ok) {
+        int rc = 0;
+
+        if ((out != NULL) && (outSize < inLen)) {
+            ok = 0;
+        }
+        if (ok) {
+            ok = wp_chacha20_poly1305_start(ctx);
+        }
+        if (ok && (inLen > 0)) {
+            if (out == NULL) {
+                rc = wc_ChaCha20Poly1305_UpdateAad(&ctx->aead, in,
+                    (word32)inLen);
+            }
+            else {
+                rc = wc_ChaCha20Poly1305_UpdateData(&ctx->aead, in, out,
+                    (word32)inLen);
+            }
+            if (rc != 0) {
+                ok = 0;
+            }
+        }
+        if (ok) {
+            *outLen = inLen;
+        }
+    }
+
+    return ok;
+}
+
+/**
+ * Streaming final of ChaCha20-Poly1305.
+ *
+ * Encryption calculates the tag. Decryption checks the tag.
+ *
+ * @param [in, out] ctx      ChaCha20-Poly1305 context object.
+ * @param [out]     out      Buffer to hold encrypted/decrypted data. Unused.
+ * @param [out]     outLen   Length of data in output buffer.
+ * @param [in]      outSize  Size of output buffer in bytes. Unused.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_chacha20_poly1305_final(wp_ChaChaPolyCtx* ctx,
+    unsigned char* out, size_t* outLen, size_t outSize)
+{
+    int ok = 1;
+    unsigned char tag[WP_CHACHA_POLY_TAG_LEN];
+
+    (void)out;
+    (void)outSize;
+
+    if (!wolfssl_prov_is_running()) {
+        ok = 0;
+    }
+    /* TLS records are completed in update. */
+    if (ok && (ctx->tlsPayloadLen == UNINITIALISED_SIZET)) {
+        ok = wp_chacha20_poly1305_start(ctx);
+        if (ok && (wc_ChaCha20Poly1305_Final(&ctx->aead, tag) != 0)) {
+            ok = 0;
+        }
+        if (ok && ctx->enc) {
+            XMEMCPY(ctx->tag, tag, sizeof(tag));
+        }
+        else if (ok && (CRYPTO_memcmp(tag, ctx->tag, ctx->tagLen) != 0)) {
+            ok = 0;
+        }
+        /* Nonce must be set again before next message. */
+        ctx->started = 0;
+        if (ctx->enc) {
+            ctx->ivSet = 0;
+        }
+        OPENSSL_cleanse(tag, sizeof(tag));
+    }
+
+    *outLen = 0;
+    return ok;
+}
+
+/**
+ * One-shot ChaCha20-Poly1305 operation.
+ *
+ * Data is processed when in is not NULL, otherwise the operation is
+ * finalized.
+ *
+ * @param [in, out] ctx      ChaCha20-Poly1305 context object.
+ * @param [out]     out      Buffer to hold encrypted/decrypted data.
+ * @param [out]     outLen   Length of data in output buffer.
+ * @param [in]      outSize  Size of output buffer in bytes.
+ * @param [in]      in       Data to be encrypted/decrypted.
+ * @param [in]      inLen    Length of data to be encrypted/decrypted.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_chacha20_poly1305_cipher(wp_ChaChaPolyCtx* ctx,
+    unsigned char* out, size_t* outLen, size_t outSize,
+    const unsigned char* in, size_t inLen)
+{
+    int ok;
+
+    if (in != NULL) {
+        ok = wp_chacha20_poly1305_update(ctx, out, outLen, outSize, in,
+            inLen);
+    }
+    else {
+        ok = wp_chacha20_poly1305_final(ctx, out, outLen, outSize);
+    }
+
+    return ok;
+}
+
+/** Dispatch table for ChaCha20-Poly1305. */
+const OSSL_DISPATCH wp_chacha20_poly1305_functions[] = {
+    { OSSL_FUNC_CIPHER_NEWCTX,  (DFUNC)wp_chacha20_poly1305_newctx         },
+    { OSSL_FUNC_CIPHER_FREECTX, (DFUNC)wp_chacha20_poly1305_freectx        },
+    { OSSL_FUNC_CIPHER_DUPCTX,  (DFUNC)wp_chacha20_poly1305_dupctx         },
+    { OSSL_FUNC_CIPHER_ENCRYPT_INIT,
+                                (DFUNC)wp_chacha20_poly1305_einit          },
+    { OSSL_FUNC_CIPHER_DECRYPT_INIT,
+                                (DFUNC)wp_chacha20_poly1305_dinit          },
+    { OSSL_FUNC_CIPHER_UPDATE,  (DFUNC)wp_chacha20_poly1305_update         },
+    { OSSL_FUNC_CIPHER_FINAL,   (DFUNC)wp_chacha20_poly1305_final          },
+    { OSSL_FUNC_CIPHER_CIPHER,  (DFUNC)wp_chacha20_poly1305_cipher         },
+    { OSSL_FUNC_CIPHER_GET_PARAMS,
+                                (DFUNC)wp_chacha20_poly1305_get_params     },
+    { OSSL_FUNC_CIPHER_GET_CTX_PARAMS,
+                                (DFUNC)wp_chacha20_poly1305_get_ctx_params },
+    { OSSL_FUNC_CIPHER_SET_CTX_PARAMS,
+                                (DFUNC)wp_chacha20_poly1305_set_ctx_params },
+    { OSSL_FUNC_CIPHER_GETTABLE_PARAMS,
+                                (DFUNC)wp_chacha20_poly1305_gettable_params },
+    { OSSL_FUNC_CIPHER_GETTABLE_CTX_PARAMS,
+                          (DFUNC)wp_chacha20_poly1305_gettable_ctx_params   },
+    { OSSL_FUNC_CIPHER_SETTABLE_CTX_PARAMS,
+                          (DFUNC)wp_chacha20_poly1305_settable_ctx_params   },
+    { 0, NULL }
+};
+
+#endif /* HAVE_CHACHA && HAVE_POLY1305 */
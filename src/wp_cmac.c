@@ -48,6 +48,9 @@ typedef struct wp_CmacCtx {
     unsigned char key[AES_256_KEY_SIZE];
     /** Length of private key in bytes. */
     size_t keyLen;
+
+    /** CMAC object has been initialized with key. */
+    unsigned int keySet:1;
 } wp_CmacCtx;
 
 
@@ -70,7 +73,7 @@ static wp_CmacCtx* wp_cmac_new(WOLFPROV_CTX* provCtx)
     (void)provCtx;
 
     if (wolfssl_prov_is_running()) {
-        macCtx = OPENSSL_zalloc(sizeof(*macCtx));
+        macCtx = wp_pool_zalloc(sizeof(*macCtx));
     }
 
     return macCtx;
@@ -88,7 +91,7 @@ static void wp_cmac_free(wp_CmacCtx* macCtx)
 {
     if (macCtx != NULL) {
         OPENSSL_cleanse(macCtx->key, macCtx->keyLen);
-        OPENSSL_free(macCtx);
+        wp_pool_clear_free(macCtx, sizeof(*macCtx));
     }
 }
 
@@ -118,6 +121,7 @@ static int wp_cmac_set_key(wp_CmacCtx* macCtx, const unsigned char* key,
         }
         macCtx->keyLen = keyLen;
         XMEMCPY(macCtx->key, key, keyLen);
+        macCtx->keySet = 0;
 
         if (restart) {
             int rc = wc_InitCmac_ex(&macCtx->cmac, macCtx->key,
@@ -126,6 +130,9 @@ static int wp_cmac_set_key(wp_CmacCtx* macCtx, const unsigned char* key,
             if (rc != 0) {
                 ok = 0;
             }
+            else {
+                macCtx->keySet = 1;
+            }
         }
     }
 
@@ -159,6 +166,10 @@ static wp_CmacCtx* wp_cmac_dup(wp_CmacCtx* src)
             dst = NULL;
         }
     }
+    if (dst != NULL) {
+        /* CMAC object copied with same key. */
+        dst->keySet = src->keySet;
+    }
 
     return dst;
 }
@@ -189,6 +200,15 @@ static int wp_cmac_init(wp_CmacCtx* macCtx, const unsigned char* key,
         if ((key != NULL) && (!wp_cmac_set_key(macCtx, key, keyLen, 1))) {
             ok = 0;
         }
+        else if ((key == NULL) && macCtx->keySet) {
+            /* Restart with the key already set. */
+            int rc = wc_InitCmac_ex(&macCtx->cmac, macCtx->key,
+                (word32)macCtx->keyLen, macCtx->type, NULL, NULL,
+                INVALID_DEVID);
+            if (rc != 0) {
+                ok = 0;
+            }
+        }
     }
 
     return ok;
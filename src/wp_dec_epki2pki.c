@@ -18,6 +18,8 @@
  * along with wolfProvider.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <time.h>
+
 #include <openssl/err.h>
 #include <openssl/proverr.h>
 #include <openssl/core_dispatch.h>
@@ -28,33 +30,716 @@
 #include <openssl/evp.h>
 
 #include <wolfprovider/alg_funcs.h>
+#include <wolfprovider/internal.h>
 
 #include <wolfssl/wolfcrypt/asn_public.h>
+#include <wolfssl/wolfcrypt/pwdbased.h>
+#include <wolfssl/wolfcrypt/aes.h>
+#include <wolfssl/wolfcrypt/sha256.h>
+#include <wolfssl/wolfcrypt/hmac.h>
+
+#if defined(HAVE_AES_CBC) && defined(HAVE_AES_DECRYPT) && \
+    !defined(NO_PWDBASED) && !defined(NO_HMAC) && !defined(NO_SHA256)
+    /* PBES2 with AES-CBC is decrypted by provider to cache derived keys. */
+    #define WP_HAVE_PBKDF2_CACHE
+#endif
+
+/* Context is the provider context - no other data required. */
+typedef WOLFPROV_CTX wp_Epki2Pki;
+
+#ifdef WP_HAVE_PBKDF2_CACHE
+
+/**
+ * Key derived with PBKDF2 from a password when decrypting.
+ */
+typedef struct wp_Pbkdf2Entry {
+    /** HMAC-SHA256, keyed with cache's secret, of password, salt,
+     * iterations, PRF and key length. */
+    unsigned char id[WC_SHA256_DIGEST_SIZE];
+    /** Derived key. */
+    unsigned char key[AES_256_KEY_SIZE];
+    /** Length of derived key in bytes. 0 when entry not used. */
+    word32 keyLen;
+    /** Time, in seconds, after which the entry is not used. */
+    time_t expires;
+    /** Use count when last used - least recently used entry is replaced. */
+    word64 lastUse;
+} wp_Pbkdf2Entry;
+
+/**
+ * Cache of keys derived with PBKDF2 when decrypting EncryptedPrivateKeyInfo.
+ */
+struct wp_Pbkdf2Cache {
+    /** Entries of cache. */
+    wp_Pbkdf2Entry* entries;
+    /** Number of entries. */
+    int size;
+    /** Number of seconds an entry is used for after being derived. */
+    int ttl;
+    /** Number of uses of the cache. */
+    word64 useCnt;
+    /** Number of keys found in the cache - PBKDF2 not performed. */
+    word64 hits;
+    /** Random key of HMAC that calculates identifiers. Identifiers can't be
+     * checked against guessed passwords without it. */
+    unsigned char secret[WC_SHA256_DIGEST_SIZE];
+#ifndef WP_SINGLE_THREADED
+    /** Mutex protecting entries. */
+    pthread_mutex_t mutex;
+#endif
+};
+
+/**
+ * PBES2 parameters and encrypted data of an EncryptedPrivateKeyInfo.
+ */
+typedef struct wp_Pbes2 {
+    /** Salt for PBKDF2. */
+    const unsigned char* salt;
+    /** Length of salt in bytes. */
+    word32 saltLen;
+    /** Iterations of PBKDF2. */
+    word32 iterations;
+    /** Hash algorithm of PRF of PBKDF2. */
+    enum wc_HashType hashType;
+    /** Length of AES key in bytes. */
+    word32 keyLen;
+    /** AES-CBC IV. */
+    const unsigned char* iv;
+    /** Index of encrypted data. */
+    word32 encIdx;
+    /** Length of encrypted data in bytes. */
+    word32 encLen;
+} wp_Pbes2;
+
+/** Encoding of OID for PBES2: 1.2.840.113549.1.5.13 */
+static const unsigned char wp_oid_pbes2[] = {
+    0x2a, 0x86, 0x48, 0x86, 0xf7, 0x0d, 0x01, 0x05, 0x0d
+};
+/** Encoding of OID for PBKDF2: 1.2.840.113549.1.5.12 */
+static const unsigned char wp_oid_pbkdf2[] = {
+    0x2a, 0x86, 0x48, 0x86, 0xf7, 0x0d, 0x01, 0x05, 0x0c
+};
+/** Encoding of OID for HMAC algorithms: 1.2.840.113549.2.x */
+static const unsigned char wp_oid_hmac[] = {
+    0x2a, 0x86, 0x48, 0x86, 0xf7, 0x0d, 0x02
+};
+/** Encoding of OID for AES algorithms: 2.16.840.1.101.3.4.1.x */
+static const unsigned char wp_oid_aes[] = {
+    0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x01
+};
+
+/**
+ * Get the seconds of a monotonic clock.
+ *
+ * @return  Number of seconds.
+ */
+static time_t wp_pbkdf2_cache_now(void)
+{
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
+        ts.tv_sec = 0;
+    }
+    return ts.tv_sec;
+}
+
+/**
+ * Create the cache of keys derived with PBKDF2 when decrypting.
+ *
+ * Cache is only created when size is not zero.
+ *
+ * @param [in, out] provCtx  Provider context.
+ * @param [in]      size     Number of derived keys to keep.
+ * @param [in]      ttl      Number of seconds to keep a derived key for.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+int wp_pbkdf2_cache_init(WOLFPROV_CTX* provCtx, int size, int ttl)
+{
+    int ok = 1;
+    wp_Pbkdf2Cache* cache = NULL;
+
+    if ((size > 0) && (ttl <= 0)) {
+        ok = 0;
+    }
+    if (ok && (size > 0)) {
+        cache = (wp_Pbkdf2Cache*)OPENSSL_zalloc(sizeof(*cache));
+        if (cache == NULL) {
+            ok = 0;
+        }
+    }
+    if (ok && (cache != NULL)) {
+        cache->entries = (wp_Pbkdf2Entry*)OPENSSL_zalloc(
+            sizeof(*cache->entries) * size);
+        if (cache->entries == NULL) {
+            ok = 0;
+        }
+    }
+    if (ok && (cache != NULL)) {
+        WC_RNG* rng = wp_provctx_get_rng(provCtx);
+
+        if ((rng == NULL) || (wc_RNG_GenerateBlock(rng, cache->secret,
+                sizeof(cache->secret)) != 0)) {
+            ok = 0;
+        }
+    }
+#ifndef WP_SINGLE_THREADED
+    if (ok && (cache != NULL) &&
+            (pthread_mutex_init(&cache->mutex, NULL) != 0)) {
+        ok = 0;
+    }
+#endif
+    if (ok && (cache != NULL)) {
+        cache->size = size;
+        cache->ttl = ttl;
+        provCtx->pbkdf2Cache = cache;
+    }
+    else if (cache != NULL) {
+        OPENSSL_free(cache->entries);
+        OPENSSL_clear_free(cache, sizeof(*cache));
+    }
+
+    return ok;
+}
+
+/**
+ * Dispose of the cache of keys derived with PBKDF2 when decrypting.
+ *
+ * Derived keys are zeroized.
+ *
+ * @param [in, out] provCtx  Provider context.
+ */
+void wp_pbkdf2_cache_free(WOLFPROV_CTX* provCtx)
+{
+    wp_Pbkdf2Cache* cache = provCtx->pbkdf2Cache;
+
+    if (cache != NULL) {
+    #ifndef WP_SINGLE_THREADED
+        pthread_mutex_destroy(&cache->mutex);
+    #endif
+        OPENSSL_clear_free(cache->entries,
+            sizeof(*cache->entries) * cache->size);
+        OPENSSL_clear_free(cache, sizeof(*cache));
+        provCtx->pbkdf2Cache = NULL;
+    }
+}
+
+/**
+ * Get the number of derived keys found in the cache.
+ *
+ * @param [in] provCtx  Provider context.
+ * @return  Number of keys found in cache. 0 when no cache.
+ */
+word64 wp_pbkdf2_cache_hits(WOLFPROV_CTX* provCtx)
+{
+    word64 hits = 0;
+    wp_Pbkdf2Cache* cache = provCtx->pbkdf2Cache;
 
-/* Dummy type for EPKI to PKI context. */
-typedef void wp_Epki2Pki;
+    if (cache != NULL) {
+    #ifndef WP_SINGLE_THREADED
+        pthread_mutex_lock(&cache->mutex);
+    #endif
+        hits = cache->hits;
+    #ifndef WP_SINGLE_THREADED
+        pthread_mutex_unlock(&cache->mutex);
+    #endif
+    }
 
-/* A fake static global context. */
-static unsigned char fakeCtx[1];
+    return hits;
+}
+
+/**
+ * Calculate the identifier of a derived key.
+ *
+ * Password is not kept - only an HMAC of all the inputs of PBKDF2 keyed with
+ * the cache's random secret. Without the secret, an identifier can't be used
+ * to test guesses of the password more cheaply than PBKDF2.
+ *
+ * @param [in]  cache        Cache of derived keys.
+ * @param [in]  pbes2        PBES2 parameters.
+ * @param [in]  password     Password.
+ * @param [in]  passwordLen  Length of password in bytes.
+ * @param [out] id           Buffer to hold identifier.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_pbkdf2_cache_id(const wp_Pbkdf2Cache* cache,
+    const wp_Pbes2* pbes2, const char* password, word32 passwordLen,
+    unsigned char* id)
+{
+    int ok = 1;
+    int rc;
+    Hmac hmac;
+    word32 vals[4];
+    unsigned char lens[sizeof(vals)];
+    size_t i;
+
+    vals[0] = passwordLen;
+    vals[1] = pbes2->iterations;
+    vals[2] = (word32)pbes2->hashType;
+    vals[3] = pbes2->keyLen;
+    /* Big-endian encode so that the identifier is independent of platform. */
+    for (i = 0; i < sizeof(lens); i++) {
+        lens[i] = (unsigned char)(vals[i / 4] >> (24 - 8 * (i % 4)));
+    }
+
+    rc = wc_HmacInit(&hmac, NULL, INVALID_DEVID);
+    if (rc != 0) {
+        ok = 0;
+    }
+    if (ok) {
+        rc = wc_HmacSetKey(&hmac, WC_SHA256, cache->secret,
+            sizeof(cache->secret));
+        if (rc == 0) {
+            rc = wc_HmacUpdate(&hmac, lens, sizeof(lens));
+        }
+        if (rc == 0) {
+            rc = wc_HmacUpdate(&hmac, (const byte*)password, passwordLen);
+        }
+        if (rc == 0) {
+            rc = wc_HmacUpdate(&hmac, pbes2->salt, pbes2->saltLen);
+        }
+        if (rc == 0) {
+            rc = wc_HmacFinal(&hmac, id);
+        }
+        if (rc != 0) {
+            ok = 0;
+        }
+        wc_HmacFree(&hmac);
+    }
+
+    return ok;
+}
+
+/**
+ * Find a derived key in the cache.
+ *
+ * Expired entries are zeroized as they are found.
+ *
+ * @param [in, out] cache  Cache of derived keys.
+ * @param [in]      id     Identifier of derived key.
+ * @param [out]     key    Buffer to hold derived key.
+ * @param [in]      len    Length of derived key in bytes.
+ * @return  1 when found.
+ * @return  0 when not found.
+ */
+static int wp_pbkdf2_cache_find(wp_Pbkdf2Cache* cache, const unsigned char* id,
+    unsigned char* key, word32 len)
+{
+    int found = 0;
+    int i;
+    time_t now = wp_pbkdf2_cache_now();
+
+#ifndef WP_SINGLE_THREADED
+    pthread_mutex_lock(&cache->mutex);
+#endif
+    for (i = 0; i < cache->size; i++) {
+        wp_Pbkdf2Entry* entry = &cache->entries[i];
+
+        if ((entry->keyLen != 0) && (entry->expires <= now)) {
+            OPENSSL_cleanse(entry, sizeof(*entry));
+        }
+        if ((!found) && (entry->keyLen == len) &&
+                (XMEMCMP(entry->id, id, sizeof(entry->id)) == 0)) {
+            XMEMCPY(key, entry->key, len);
+            entry->lastUse = ++cache->useCnt;
+            cache->hits++;
+            found = 1;
+        }
+    }
+#ifndef WP_SINGLE_THREADED
+    pthread_mutex_unlock(&cache->mutex);
+#endif
+
+    return found;
+}
+
+/**
+ * Put a derived key into the cache.
+ *
+ * Replaces an unused or expired entry or, when none, the least recently used
+ * entry.
+ *
+ * @param [in, out] cache  Cache of derived keys.
+ * @param [in]      id     Identifier of derived key.
+ * @param [in]      key    Derived key.
+ * @param [in]      len    Length of derived key in bytes.
+ */
+static void wp_pbkdf2_cache_add(wp_Pbkdf2Cache* cache, const unsigned char* id,
+    const unsigned char* key, word32 len)
+{
+    int i;
+    wp_Pbkdf2Entry* entry = NULL;
+    time_t now = wp_pbkdf2_cache_now();
+
+#ifndef WP_SINGLE_THREADED
+    pthread_mutex_lock(&cache->mutex);
+#endif
+    for (i = 0; i < cache->size; i++) {
+        wp_Pbkdf2Entry* cur = &cache->entries[i];
+
+        if ((cur->keyLen != 0) && (cur->expires <= now)) {
+            OPENSSL_cleanse(cur, sizeof(*cur));
+        }
+        if ((cur->keyLen == len) &&
+                (XMEMCMP(cur->id, id, sizeof(cur->id)) == 0)) {
+            /* Another thread derived the same key. */
+            entry = cur;
+            break;
+        }
+        if ((entry == NULL) || ((entry->keyLen != 0) &&
+                ((cur->keyLen == 0) || (cur->lastUse < entry->lastUse)))) {
+            entry = cur;
+        }
+    }
+    XMEMCPY(entry->id, id, sizeof(entry->id));
+    XMEMCPY(entry->key, key, len);
+    entry->keyLen = len;
+    entry->expires = now + cache->ttl;
+    entry->lastUse = ++cache->useCnt;
+#ifndef WP_SINGLE_THREADED
+    pthread_mutex_unlock(&cache->mutex);
+#endif
+}
+
+/**
+ * Get an OID item and check it starts with the prefix.
+ *
+ * @param [in]      data       DER encoding.
+ * @param [in]      len        Length, in bytes, of DER encoding.
+ * @param [in, out] idx        On in, index of item.
+ *                             On out, index after item.
+ * @param [in]      prefix     Expected encoding of OID.
+ * @param [in]      prefixLen  Length, in bytes, of expected encoding.
+ * @param [out]     last       Last byte of OID encoding when one byte longer
+ *                             than prefix. May be NULL.
+ * @return  1 when OID matches.
+ * @return  0 otherwise.
+ */
+static int wp_epki2pki_get_oid(const unsigned char* data, word32 len,
+    word32* idx, const unsigned char* prefix, word32 prefixLen,
+    unsigned char* last)
+{
+    int ok = 1;
+    word32 oidLen = 0;
+
+    if (!wp_der_get_item(data, len, idx, 0x06, &oidLen)) {
+        ok = 0;
+    }
+    if (ok && (oidLen != prefixLen + (last != NULL))) {
+        ok = 0;
+    }
+    if (ok && (XMEMCMP(data + *idx, prefix, prefixLen) != 0)) {
+        ok = 0;
+    }
+    if (ok) {
+        if (last != NULL) {
+            *last = data[*idx + prefixLen];
+        }
+        *idx += oidLen;
+    }
+
+    return ok;
+}
+
+/**
+ * Parse the EncryptedPrivateKeyInfo for PBES2 with PBKDF2 and AES-CBC.
+ *
+ * EncryptedPrivateKeyInfo ::= SEQUENCE {
+ *   SEQUENCE { pbes2,
+ *     SEQUENCE {
+ *       SEQUENCE { pbkdf2,
+ *         SEQUENCE { salt OCTET STRING, iterations INTEGER,
+ *                    keyLength INTEGER OPTIONAL,
+ *                    prf AlgorithmIdentifier DEFAULT hmacWithSHA1 } }
+ *       SEQUENCE { aes-cbc, iv OCTET STRING } } }
+ *   encryptedData OCTET STRING }
+ *
+ * @param [in]  data   DER encoding.
+ * @param [in]  len    Length, in bytes, of DER encoding.
+ * @param [out] pbes2  PBES2 parameters.
+ * @return  1 when PBES2 with PBKDF2 and AES-CBC.
+ * @return  0 otherwise.
+ */
+static int wp_epki2pki_parse(const unsigned char* data, word32 len,
+    wp_Pbes2* pbes2)
+{
+    int ok = 1;
+    word32 idx = 0;
+    word32 itemLen = 0;
+    word32 kdfEnd = 0;
+    word32 i;
+    unsigned char id = 0;
+
+    /* EncryptedPrivateKeyInfo, AlgorithmIdentifier, PBES2 OID, parameters,
+     * key derivation AlgorithmIdentifier, PBKDF2 OID and parameters. */
+    if ((!wp_der_get_item(data, len, &idx, 0x30, &itemLen)) ||
+            (!wp_der_get_item(data, len, &idx, 0x30, &itemLen)) ||
+            (!wp_epki2pki_get_oid(data, len, &idx, wp_oid_pbes2,
+                sizeof(wp_oid_pbes2), NULL)) ||
+            (!wp_der_get_item(data, len, &idx, 0x30, &itemLen)) ||
+            (!wp_der_get_item(data, len, &idx, 0x30, &itemLen)) ||
+            (!wp_epki2pki_get_oid(data, len, &idx, wp_oid_pbkdf2,
+                sizeof(wp_oid_pbkdf2), NULL)) ||
+            (!wp_der_get_item(data, len, &idx, 0x30, &itemLen))) {
+        ok = 0;
+    }
+    if (ok) {
+        kdfEnd = idx + itemLen;
+        if (!wp_der_get_item(data, len, &idx, 0x04, &pbes2->saltLen)) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        pbes2->salt = data + idx;
+        idx += pbes2->saltLen;
+        if (!wp_der_get_item(data, len, &idx, 0x02, &itemLen)) {
+            ok = 0;
+        }
+    }
+    /* Positive iteration count that fits in 31 bits. */
+    if (ok && ((itemLen == 0) || (itemLen > 4) || (data[idx] & 0x80))) {
+        ok = 0;
+    }
+    if (ok) {
+        pbes2->iterations = 0;
+        for (i = 0; i < itemLen; i++) {
+            pbes2->iterations = (pbes2->iterations << 8) | data[idx++];
+        }
+        if (pbes2->iterations == 0) {
+            ok = 0;
+        }
+    }
+    pbes2->keyLen = 0;
+    if (ok && (idx < kdfEnd) && (data[idx] == 0x02)) {
+        /* Key length must match cipher - checked below. */
+        if ((!wp_der_get_item(data, len, &idx, 0x02, &itemLen)) ||
+                (itemLen != 1)) {
+            ok = 0;
+        }
+        else {
+            pbes2->keyLen = data[idx++];
+        }
+    }
+    pbes2->hashType = WC_HASH_TYPE_SHA;
+    if (ok && (idx < kdfEnd)) {
+        if ((!wp_der_get_item(data, len, &idx, 0x30, &itemLen)) ||
+                (!wp_epki2pki_get_oid(data, len, &idx, wp_oid_hmac,
+                    sizeof(wp_oid_hmac), &id))) {
+            ok = 0;
+        }
+        else if (id == 0x07) {
+            pbes2->hashType = WC_HASH_TYPE_SHA;
+        }
+        else if (id == 0x09) {
+            pbes2->hashType = WC_HASH_TYPE_SHA256;
+        }
+        else if (id == 0x0a) {
+            pbes2->hashType = WC_HASH_TYPE_SHA384;
+        }
+        else if (id == 0x0b) {
+            pbes2->hashType = WC_HASH_TYPE_SHA512;
+        }
+        else {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        /* Skip optional NULL parameters of PRF. */
+        idx = kdfEnd;
+        /* Encryption scheme AlgorithmIdentifier, AES-CBC OID and IV. */
+        if ((!wp_der_get_item(data, len, &idx, 0x30, &itemLen)) ||
+                (!wp_epki2pki_get_oid(data, len, &idx, wp_oid_aes,
+                    sizeof(wp_oid_aes), &id))) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        word32 keyLen = 0;
+
+        if (id == 0x02) {
+            keyLen = AES_128_KEY_SIZE;
+        }
+        else if (id == 0x16) {
+            keyLen = AES_192_KEY_SIZE;
+        }
+        else if (id == 0x2a) {
+            keyLen = AES_256_KEY_SIZE;
+        }
+        if ((keyLen == 0) || ((pbes2->keyLen != 0) &&
+                (pbes2->keyLen != keyLen))) {
+            ok = 0;
+        }
+        pbes2->keyLen = keyLen;
+    }
+    if (ok && ((!wp_der_get_item(data, len, &idx, 0x04, &itemLen)) ||
+            (itemLen != AES_BLOCK_SIZE))) {
+        ok = 0;
+    }
+    if (ok) {
+        pbes2->iv = data + idx;
+        idx += itemLen;
+        if (!wp_der_get_item(data, len, &idx, 0x04, &pbes2->encLen)) {
+            ok = 0;
+        }
+    }
+    if (ok && ((pbes2->encLen == 0) ||
+            ((pbes2->encLen % AES_BLOCK_SIZE) != 0))) {
+        ok = 0;
+    }
+    if (ok) {
+        pbes2->encIdx = idx;
+    }
+
+    return ok;
+}
+
+/**
+ * Decrypt EncryptedPrivateKeyInfo with PBES2, using the cache of derived keys.
+ *
+ * PBKDF2 is only performed when the key is not in the cache. A derived key is
+ * only cached when the decrypted data has valid padding.
+ *
+ * @param [in]      cache        Cache of derived keys.
+ * @param [in]      pbes2        PBES2 parameters.
+ * @param [in, out] data         On in, EncryptedPrivateKeyInfo DER encoding.
+ *                               On out, PrivateKeyInfo DER encoding.
+ * @param [in]      password     Password.
+ * @param [in]      passwordLen  Length of password in bytes.
+ * @param [in]      devId        wolfCrypt device id.
+ * @param [out]     outLen       Length of PrivateKeyInfo in bytes.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_epki2pki_decrypt_cached(wp_Pbkdf2Cache* cache,
+    const wp_Pbes2* pbes2, unsigned char* data, const char* password,
+    word32 passwordLen, int devId, word32* outLen)
+{
+    int ok = 1;
+    int rc;
+    int found;
+    unsigned char id[WC_SHA256_DIGEST_SIZE];
+    unsigned char key[AES_256_KEY_SIZE];
+    unsigned char* enc = data + pbes2->encIdx;
+    word32 pad = 0;
+    word32 i;
+    Aes aes;
+
+    if (!wp_pbkdf2_cache_id(cache, pbes2, password, passwordLen, id)) {
+        ok = 0;
+    }
+    found = ok && wp_pbkdf2_cache_find(cache, id, key, pbes2->keyLen);
+    if (ok && (!found)) {
+        rc = wc_PBKDF2_ex(key, (const byte*)password, passwordLen, pbes2->salt,
+            pbes2->saltLen, pbes2->iterations, pbes2->keyLen, pbes2->hashType,
+            NULL, devId);
+        if (rc != 0) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        rc = wc_AesInit(&aes, NULL, devId);
+        if (rc != 0) {
+            ok = 0;
+        }
+        else {
+            rc = wc_AesSetKey(&aes, key, pbes2->keyLen, pbes2->iv,
+                AES_DECRYPTION);
+            if (rc == 0) {
+                rc = wc_AesCbcDecrypt(&aes, enc, enc, pbes2->encLen);
+            }
+            if (rc != 0) {
+                ok = 0;
+            }
+            wc_AesFree(&aes);
+        }
+    }
+    if (ok) {
+        /* Check PKCS#7 padding - fails when password is wrong. */
+        pad = enc[pbes2->encLen - 1];
+        if ((pad == 0) || (pad > AES_BLOCK_SIZE)) {
+            ok = 0;
+        }
+        for (i = 1; ok && (i < pad); i++) {
+            if (enc[pbes2->encLen - 1 - i] != pad) {
+                ok = 0;
+            }
+        }
+    }
+    if (ok && (!found)) {
+        wp_pbkdf2_cache_add(cache, id, key, pbes2->keyLen);
+    }
+    if (ok) {
+        *outLen = pbes2->encLen - pad;
+        XMEMMOVE(data, enc, *outLen);
+    }
+
+    OPENSSL_cleanse(key, sizeof(key));
+    return ok;
+}
+
+#else
+
+/**
+ * Create the cache of keys derived with PBKDF2 when decrypting.
+ *
+ * Not supported by wolfSSL build - EPKI always decrypted by wolfCrypt.
+ *
+ * @param [in, out] provCtx  Provider context. Unused.
+ * @param [in]      size     Number of derived keys to keep. Unused.
+ * @param [in]      ttl      Number of seconds to keep a derived key for.
+ *                           Unused.
+ * @return  1 always.
+ */
+int wp_pbkdf2_cache_init(WOLFPROV_CTX* provCtx, int size, int ttl)
+{
+    (void)provCtx;
+    (void)size;
+    (void)ttl;
+    return 1;
+}
+
+/**
+ * Dispose of the cache of keys derived with PBKDF2 when decrypting.
+ *
+ * @param [in, out] provCtx  Provider context. Unused.
+ */
+void wp_pbkdf2_cache_free(WOLFPROV_CTX* provCtx)
+{
+    (void)provCtx;
+}
+
+/**
+ * Get the number of derived keys found in the cache.
+ *
+ * @param [in] provCtx  Provider context. Unused.
+ * @return  0 always.
+ */
+word64 wp_pbkdf2_cache_hits(WOLFPROV_CTX* provCtx)
+{
+    (void)provCtx;
+    return 0;
+}
+
+#endif /* WP_HAVE_PBKDF2_CACHE */
 
 /**
  * Create a new EPKI to PKI context.
  *
- * No context data required so returning a global context.
+ * No context data required so returning the provider context.
  *
- * @param [in] provCtx  Provider context. UUnused.
+ * @param [in] provCtx  Provider context.
  * @return  Pointer to context.
  */
 static wp_Epki2Pki* wp_epki2pki_newctx(WOLFPROV_CTX* provCtx)
 {
-    (void)provCtx;
-    return fakeCtx;
+    return provCtx;
 }
 
 /**
  * Dispose of EPKI to PKI context.
  *
- * Nothing to do as it is a global context.
+ * Nothing to do as it is the provider context.
  *
  * @param [in] ctx  EPKI to PKI context. Unused.
  */
@@ -63,10 +748,55 @@ static void wp_epki2pki_freectx(wp_Epki2Pki* ctx)
     (void)ctx;
 }
 
+/**
+ * Decrypt the EPKI to PKI in place.
+ *
+ * When a cache of derived keys is configured and the EPKI uses PBES2 with
+ * PBKDF2 and AES-CBC, the cache is used. Otherwise wolfCrypt decrypts.
+ *
+ * @param [in]      ctx          EPKI to PKI context.
+ * @param [in, out] data         On in, EPKI DER encoding.
+ *                               On out, PKI DER encoding.
+ * @param [in]      len          Length of EPKI DER encoding in bytes.
+ * @param [in]      password     Password.
+ * @param [in]      passwordLen  Length of password in bytes.
+ * @param [out]     outLen       Length of PKI DER encoding in bytes.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_epki2pki_decrypt(wp_Epki2Pki* ctx, unsigned char* data,
+    word32 len, char* password, size_t passwordLen, word32* outLen)
+{
+    int ok = 1;
+    int rc;
+#ifdef WP_HAVE_PBKDF2_CACHE
+    wp_Pbes2 pbes2;
+
+    if ((ctx->pbkdf2Cache != NULL) && wp_epki2pki_parse(data, len, &pbes2)) {
+        ok = wp_epki2pki_decrypt_cached(ctx->pbkdf2Cache, &pbes2, data,
+            password, (word32)passwordLen, ctx->devId, outLen);
+    }
+    else
+#else
+    (void)ctx;
+#endif
+    {
+        rc = wc_DecryptPKCS8Key(data, len, password, (int)passwordLen);
+        if (rc <= 0) {
+            ok = 0;
+        }
+        else {
+            *outLen = (word32)rc;
+        }
+    }
+
+    return ok;
+}
+
 /**
  * Decode the EPKI to PKI.
  *
- * @param [in]      ctx        EPKI to PKI context. Unused.
+ * @param [in]      ctx        EPKI to PKI context.
  * @param [in, out] coreBio    BIO wrapped for the core.
  * @param [in]      selection  Which parts of to decode. Unused.
  * @param [in]      dataCb     Callback to pass the decoded data to.
@@ -82,13 +812,12 @@ static int wp_epki2pki_decode(wp_Epki2Pki* ctx, OSSL_CORE_BIO* coreBio,
 {
     int ok = 1;
     int done = 0;
-    int rc;
     unsigned char* data = NULL;
     word32 len = 0;
+    word32 pkiLen = 0;
     char password[1024];
     size_t passwordLen;
 
-    (void)ctx;
     (void)selection;
 
     /* Read the data from the BIO into buffer that is allocated on the fly. */
@@ -103,11 +832,9 @@ static int wp_epki2pki_decode(wp_Epki2Pki* ctx, OSSL_CORE_BIO* coreBio,
             pwCbArg))) {
         done = 1;
     }
-    if ((!done) && ok) {
-        rc = wc_DecryptPKCS8Key(data, len, password, passwordLen);
-        if (rc <= 0) {
-            ok = 0;
-        }
+    if ((!done) && ok && (!wp_epki2pki_decrypt(ctx, data, len, password,
+            passwordLen, &pkiLen))) {
+        ok = 0;
     }
     if ((!done) && ok) {
         OSSL_PARAM params[4];
@@ -115,7 +842,7 @@ static int wp_epki2pki_decode(wp_Epki2Pki* ctx, OSSL_CORE_BIO* coreBio,
 
         /* Set the data, structure, type of object and end of list marker. */
         params[0] = OSSL_PARAM_construct_octet_string(OSSL_OBJECT_PARAM_DATA,
-            data, rc);
+            data, pkiLen);
         params[1] = OSSL_PARAM_construct_utf8_string(
             OSSL_OBJECT_PARAM_DATA_STRUCTURE, (char*)"PrivateKeyInfo", 0);
         params[2] = OSSL_PARAM_construct_int(OSSL_OBJECT_PARAM_TYPE, &obj);
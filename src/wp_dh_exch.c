@@ -262,8 +262,17 @@ static int wp_dh_derive_secret(wp_DhCtx* ctx, unsigned char* secret,
     }
     if (ok) {
         /* Calculate secret. */
-        int rc = wc_DhAgree(wp_dh_get_key(ctx->key), secret, &len, priv, privSz,
-            pub, pubSz);
+        int rc;
+        wp_Arena* arena;
+
+        /* wolfCrypt temporaries from thread's arena when configured. */
+        arena = wp_arena_begin();
+        do {
+            rc = wc_DhAgree(wp_dh_get_key(ctx->key), secret, &len, priv,
+                privSz, pub, pubSz);
+        }
+        while (wp_async_pending(&rc, WP_ASYNC_DEV(wp_dh_get_key(ctx->key))));
+        wp_arena_end(arena);
         if (rc != 0) {
             ok = 0;
         }
@@ -303,6 +312,7 @@ static int wp_dh_derive(wp_DhCtx* ctx, unsigned char* secret,
     size_t outLen = 0;
     unsigned char* tmp = NULL;
     size_t maxLen = 0;
+    word64 mStart = wp_metrics_start();
 
     if (!wolfssl_prov_is_running()) {
         ok = 0;
@@ -357,6 +367,9 @@ static int wp_dh_derive(wp_DhCtx* ctx, unsigned char* secret,
     }
 
     OPENSSL_clear_free(tmp, maxLen);
+    if ((!done) && ok) {
+        wp_metrics_record(WP_METRIC_DH_DERIVE, mStart, *secLen);
+    }
 
     return ok;
 }
@@ -53,12 +53,8 @@ struct wp_Dh {
     /** Length of public key data in bytes. */
     size_t pubSz;
 
-#ifndef WP_SINGLE_THREADED
-    /** Mutex for reference count updating. */
-    wolfSSL_Mutex mutex;
-#endif
     /** Count of references to this object. */
-    int refCnt;
+    wp_RefCnt refCnt;
 
     /** Provider context - useful when duplicating. */
     WOLFPROV_CTX* provCtx;
@@ -67,6 +63,8 @@ struct wp_Dh {
     int id;
     /** Number of bits in prime. */
     int bits;
+    /** Number of bits in private key to generate. 0 to use wolfSSL's size. */
+    int privBits;
 };
 
 typedef struct wp_DhGenCtx {
@@ -101,6 +99,8 @@ typedef struct wp_DhGroupMap {
     int id;
     /** Number of bits in prime. */
     int bits;
+    /** Number of bits in private key - short exponent from RFC 7919. */
+    int privBits;
     /** Function to get group parameters from wolfSSL. */
     const DhParams*(*get)(void);
 } wp_DhGroupMap;
@@ -113,22 +113,25 @@ static int wp_dh_gen_set_params(wp_DhGenCtx* ctx, const OSSL_PARAM params[]);
  * DH group mapping.
  */
 
-/** Mapping of OpenSSL string to wolfSSL DH group information. */
+/** Mapping of OpenSSL string to wolfSSL DH group information.
+ * Private key lengths are the minimum exponent lengths of RFC 7919,
+ * Appendix A, as used by OpenSSL.
+ */
 static const wp_DhGroupMap wp_dh_group_map[] = {
 #ifdef HAVE_FFDHE_2048
-    { SN_ffdhe2048, WOLFSSL_FFDHE_2048, 2048, wc_Dh_ffdhe2048_Get },
+    { SN_ffdhe2048, WOLFSSL_FFDHE_2048, 2048, 225, wc_Dh_ffdhe2048_Get },
 #endif
 #ifdef HAVE_FFDHE_3072
-    { SN_ffdhe3072, WOLFSSL_FFDHE_3072, 3072, wc_Dh_ffdhe3072_Get },
+    { SN_ffdhe3072, WOLFSSL_FFDHE_3072, 3072, 275, wc_Dh_ffdhe3072_Get },
 #endif
 #ifdef HAVE_FFDHE_4096
-    { SN_ffdhe4096, WOLFSSL_FFDHE_4096, 4096, wc_Dh_ffdhe4096_Get },
+    { SN_ffdhe4096, WOLFSSL_FFDHE_4096, 4096, 325, wc_Dh_ffdhe4096_Get },
 #endif
 #ifdef HAVE_FFDHE_6144
-    { SN_ffdhe6144, WOLFSSL_FFDHE_6144, 6144, wc_Dh_ffdhe6144_Get },
+    { SN_ffdhe6144, WOLFSSL_FFDHE_6144, 6144, 375, wc_Dh_ffdhe6144_Get },
 #endif
 #ifdef HAVE_FFDHE_8192
-    { SN_ffdhe8192, WOLFSSL_FFDHE_8192, 8192, wc_Dh_ffdhe8192_Get },
+    { SN_ffdhe8192, WOLFSSL_FFDHE_8192, 8192, 400, wc_Dh_ffdhe8192_Get },
 #endif
 };
 
@@ -155,8 +158,9 @@ static int wp_dh_map_group_name(wp_Dh* dh, const char* name)
             const DhParams* params;
             int rc;
 
-            dh->id   = wp_dh_group_map[i].id;
-            dh->bits = wp_dh_group_map[i].bits;
+            dh->id       = wp_dh_group_map[i].id;
+            dh->bits     = wp_dh_group_map[i].bits;
+            dh->privBits = wp_dh_group_map[i].privBits;
             params = wp_dh_group_map[i].get();
             rc = mp_read_unsigned_bin(&dh->key.p, params->p, params->p_len);
             if (rc != 0) {
@@ -209,6 +213,57 @@ static const char* wp_dh_get_group_name(wp_Dh* dh)
     return name;
 }
 
+/**
+ * Compare a number to big-endian encoded number.
+ *
+ * @param [in] a     Multi-precision number.
+ * @param [in] b     Big-endian encoded number.
+ * @param [in] bLen  Length of encoded number in bytes.
+ * @return  1 when equal.
+ * @return  0 when not equal or on error.
+ */
+static int wp_dh_mp_eq_bin(const mp_int* a, const byte* b, word32 bLen)
+{
+    int eq = 0;
+    mp_int t;
+
+    if (mp_init(&t) == MP_OKAY) {
+        if (mp_read_unsigned_bin(&t, b, bLen) == MP_OKAY) {
+            eq = mp_cmp((mp_int*)a, &t) == MP_EQ;
+        }
+        mp_clear(&t);
+    }
+
+    return eq;
+}
+
+/**
+ * Identify explicit parameters that are those of a named group.
+ *
+ * Keys with a named group use a short exponent in key generation and skip
+ * explicit parameter validation.
+ *
+ * @param [in, out] dh  DH key object.
+ */
+static void wp_dh_match_group(wp_Dh* dh)
+{
+    size_t i;
+    int bits = mp_count_bits(&dh->key.p);
+
+    for (i = 0; (dh->id == 0) && (i < WP_DH_GROUP_MAP_SZ); i++) {
+        /* Only compare numbers when size matches. */
+        if (bits == wp_dh_group_map[i].bits) {
+            const DhParams* params = wp_dh_group_map[i].get();
+
+            if (wp_dh_mp_eq_bin(&dh->key.p, params->p, params->p_len) &&
+                    wp_dh_mp_eq_bin(&dh->key.g, params->g, params->g_len)) {
+                dh->id       = wp_dh_group_map[i].id;
+                dh->privBits = wp_dh_group_map[i].privBits;
+            }
+        }
+    }
+}
+
 
 /*
  * DH key object functions.
@@ -225,24 +280,7 @@ static const char* wp_dh_get_group_name(wp_Dh* dh)
  */
 int wp_dh_up_ref(wp_Dh* dh)
 {
-#ifndef WP_SINGLE_THREADED
-    int ok = 1;
-    int rc;
-
-    rc = wc_LockMutex(&dh->mutex);
-    if (rc < 0) {
-        ok = 0;
-    }
-    if (ok) {
-        dh->refCnt++;
-        wc_UnLockMutex(&dh->mutex);
-    }
-
-    return ok;
-#else
-    dh->refCnt++;
-    return 1;
-#endif
+    return wp_refcnt_up(&dh->refCnt);
 }
 
 /**
@@ -339,26 +377,21 @@ static wp_Dh* wp_dh_new(WOLFPROV_CTX *provCtx)
         int ok = 1;
         int rc;
 
-        rc = wc_InitDhKey_ex(&dh->key, NULL, INVALID_DEVID);
+        rc = wc_InitDhKey_ex(&dh->key, NULL, provCtx->devId);
         if (rc != 0) {
             ok = 0;
         }
-    #ifndef SINGLE_THREADED
-        if (ok) {
-            rc = wc_InitMutex(&dh->mutex);
-            if (rc != 0) {
-                wc_FreeDhKey(&dh->key);
-                ok = 0;
-            }
+        if (ok && (!wp_refcnt_init(&dh->refCnt))) {
+            wc_FreeDhKey(&dh->key);
+            ok = 0;
         }
-    #endif
         if (ok) {
-            dh->refCnt = 1;
             dh->provCtx = provCtx;
         }
 
         if (!ok) {
-            /* wolfSSL DH object freed when mutext initialization fails. */
+            /* wolfSSL DH object freed when reference count initialization
+             * fails. */
             OPENSSL_free(dh);
             dh = NULL;
         }
@@ -375,26 +408,13 @@ static wp_Dh* wp_dh_new(WOLFPROV_CTX *provCtx)
 void wp_dh_free(wp_Dh* dh)
 {
     if (dh != NULL) {
-        int cnt;
-    #ifndef WP_SINGLE_THREADED
-        int rc;
-
-        rc = wc_LockMutex(&dh->mutex);
-        cnt = --dh->refCnt;
-        if (rc == 0) {
-            wc_UnLockMutex(&dh->mutex);
-        }
-    #else
-        cnt = --dh->refCnt;
-    #endif
+        int cnt = wp_refcnt_down(&dh->refCnt);
 
         if (cnt == 0) {
             /* No more references to this object. */
             OPENSSL_free(dh->pub);
             OPENSSL_free(dh->priv);
-    #ifndef WP_SINGLE_THREADED
-            wc_FreeMutex(&dh->mutex);
-    #endif
+            wp_refcnt_free(&dh->refCnt);
             wc_FreeDhKey(&dh->key);
             OPENSSL_free(dh);
         }
@@ -825,6 +845,202 @@ static int wp_dh_validate_pub_key_quick(const wp_Dh* dh)
     return ok;
 }
 
+/** Number of explicit parameter validation results to remember. */
+#define WP_DH_PARAMS_CACHE_SIZE     16
+
+/**
+ * Result of validating explicit DH parameters.
+ */
+typedef struct wp_DhParamsResult {
+    /** SHA-256 hash of the parameters' lengths and values. */
+    byte hash[WC_SHA256_DIGEST_SIZE];
+    /** Entry holds a result. */
+    byte used;
+    /** Parameters are valid. */
+    byte valid;
+} wp_DhParamsResult;
+
+/**
+ * Results of explicit parameter validations for threads on one NUMA node.
+ */
+typedef struct wp_DhParamsShard {
+    /** Results of validations. */
+    wp_DhParamsResult cache[WP_DH_PARAMS_CACHE_SIZE];
+    /** Index of next cache entry to replace. */
+    int next;
+#ifndef WP_SINGLE_THREADED
+    /** Mutex protecting the cache of results. */
+    pthread_mutex_t mutex;
+#endif
+} wp_DhParamsShard;
+
+#ifndef WP_SINGLE_THREADED
+    /** Initial value of a shard of results. */
+    #define WP_DH_PARAMS_SHARD_INIT \
+        { { { { 0 }, 0, 0 } }, 0, PTHREAD_MUTEX_INITIALIZER }
+#else
+    /** Initial value of a shard of results. */
+    #define WP_DH_PARAMS_SHARD_INIT     { { { { 0 }, 0, 0 } }, 0 }
+#endif
+
+/** Results of explicit parameter validations. Shared by all keys and sharded
+ * by NUMA node so that lookups stay on the local node. */
+static wp_DhParamsShard wp_dh_params[WP_NUMA_MAX_NODES] = {
+    WP_DH_PARAMS_SHARD_INIT, WP_DH_PARAMS_SHARD_INIT,
+    WP_DH_PARAMS_SHARD_INIT, WP_DH_PARAMS_SHARD_INIT
+};
+
+/**
+ * Hash a length prefixed number.
+ *
+ * @param [in, out] sha  SHA-256 object.
+ * @param [in]      buf  Big-endian encoded number.
+ * @param [in]      sz   Length of number in bytes.
+ * @return  0 on success.
+ * @return  Other value on failure.
+ */
+static int wp_dh_params_hash_num(wc_Sha256* sha, const byte* buf, word32 sz)
+{
+    int rc;
+    byte len[4];
+
+    len[0] = (byte)(sz >> 24);
+    len[1] = (byte)(sz >> 16);
+    len[2] = (byte)(sz >>  8);
+    len[3] = (byte)(sz      );
+    rc = wc_Sha256Update(sha, len, sizeof(len));
+    if (rc == 0) {
+        rc = wc_Sha256Update(sha, buf, sz);
+    }
+
+    return rc;
+}
+
+/**
+ * Validate explicit DH parameters - p is a prime and g and q are valid.
+ *
+ * Checking primality is expensive and the same parameters are seen
+ * repeatedly, so results are remembered by hash of the parameters.
+ *
+ * @param [in] dh  DH key object.
+ * @return  1 when parameters are valid.
+ * @return  0 when parameters are invalid or on failure.
+ */
+static int wp_dh_validate_params(const wp_Dh* dh)
+{
+    int ok = 1;
+    int rc;
+    int i;
+    int found = 0;
+    word32 pSz = mp_unsigned_bin_size((mp_int*)&dh->key.p);
+    word32 gSz = mp_unsigned_bin_size((mp_int*)&dh->key.g);
+    word32 qSz = 0;
+    byte* buf;
+    byte* q = NULL;
+    byte hash[WC_SHA256_DIGEST_SIZE];
+    wc_Sha256 sha;
+    DhKey key;
+    WC_RNG* rng = NULL;
+    wp_DhParamsShard* shard = &wp_dh_params[wp_numa_node() %
+                                            WP_NUMA_MAX_NODES];
+
+#ifdef HAVE_FFDHE_Q
+    qSz = mp_unsigned_bin_size((mp_int*)&dh->key.q);
+#endif
+    buf = OPENSSL_malloc(pSz + gSz + qSz);
+    if (buf == NULL) {
+        ok = 0;
+    }
+    if (ok) {
+        rc = mp_to_unsigned_bin((mp_int*)&dh->key.p, buf);
+        if (rc == 0) {
+            rc = mp_to_unsigned_bin((mp_int*)&dh->key.g, buf + pSz);
+        }
+    #ifdef HAVE_FFDHE_Q
+        if ((rc == 0) && (qSz > 0)) {
+            q = buf + pSz + gSz;
+            rc = mp_to_unsigned_bin((mp_int*)&dh->key.q, q);
+        }
+    #endif
+        if (rc != 0) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        rc = wc_InitSha256(&sha);
+        if (rc == 0) {
+            rc = wp_dh_params_hash_num(&sha, buf, pSz);
+            if (rc == 0) {
+                rc = wp_dh_params_hash_num(&sha, buf + pSz, gSz);
+            }
+            if (rc == 0) {
+                rc = wp_dh_params_hash_num(&sha, buf + pSz + gSz, qSz);
+            }
+            if (rc == 0) {
+                rc = wc_Sha256Final(&sha, hash);
+            }
+            wc_Sha256Free(&sha);
+        }
+        if (rc != 0) {
+            ok = 0;
+        }
+    }
+
+    if (ok) {
+    #ifndef WP_SINGLE_THREADED
+        pthread_mutex_lock(&shard->mutex);
+    #endif
+        for (i = 0; i < WP_DH_PARAMS_CACHE_SIZE; i++) {
+            if (shard->cache[i].used && (XMEMCMP(shard->cache[i].hash, hash,
+                    sizeof(hash)) == 0)) {
+                ok = shard->cache[i].valid;
+                found = 1;
+                break;
+            }
+        }
+    #ifndef WP_SINGLE_THREADED
+        pthread_mutex_unlock(&shard->mutex);
+    #endif
+    }
+
+    if (ok && (!found)) {
+        rng = wp_provctx_get_rng(dh->provCtx);
+        if (rng == NULL) {
+            ok = 0;
+        }
+    }
+    if (ok && (!found)) {
+        /* Check parameters with a temporary key as the key is const. */
+        rc = wc_InitDhKey_ex(&key, NULL, dh->provCtx->devId);
+        if (rc != 0) {
+            ok = 0;
+        }
+        else {
+            rc = wc_DhSetCheckKey(&key, buf, pSz, buf + pSz, gSz, q, qSz, 0,
+                rng);
+            wc_FreeDhKey(&key);
+            /* Bad parameters are remembered too. */
+            ok = (rc == 0);
+            found = 1;
+
+        #ifndef WP_SINGLE_THREADED
+            pthread_mutex_lock(&shard->mutex);
+        #endif
+            i = shard->next;
+            shard->next = (i + 1) % WP_DH_PARAMS_CACHE_SIZE;
+            XMEMCPY(shard->cache[i].hash, hash, sizeof(hash));
+            shard->cache[i].valid = (byte)ok;
+            shard->cache[i].used = 1;
+        #ifndef WP_SINGLE_THREADED
+            pthread_mutex_unlock(&shard->mutex);
+        #endif
+        }
+    }
+
+    OPENSSL_free(buf);
+    return ok;
+}
+
 /**
  * Validate the DH key.
  *
@@ -841,9 +1057,12 @@ static int wp_dh_validate(const wp_Dh* dh, int selection, int checkType)
     int ok = 1;
     int rc;
 
+    /* Named group parameters are known to be good. Explicit parameters are
+     * only checked for primality on full check. */
     if (((selection & OSSL_KEYMGMT_SELECT_DOMAIN_PARAMETERS) != 0) &&
-        (dh->id == 0)) {
-        /* TODO: check explicit parameters. */
+        (dh->id == 0) && (checkType != OSSL_KEYMGMT_VALIDATE_QUICK_CHECK) &&
+        (!wp_dh_validate_params(dh))) {
+        ok = 0;
     }
     if (ok && ((selection & OSSL_KEYMGMT_SELECT_PUBLIC_KEY) != 0)) {
         if (checkType == OSSL_KEYMGMT_VALIDATE_QUICK_CHECK) {
@@ -914,6 +1133,7 @@ static int wp_dh_import_group(wp_Dh* dh, const OSSL_PARAM params[])
     #endif
         if (ok) {
             dh->bits = mp_count_bits(&dh->key.p);
+            wp_dh_match_group(dh);
         }
     }
 
@@ -1459,6 +1679,9 @@ static int wp_dh_gen_copy_parameters(wp_DhGenCtx *ctx, wp_Dh* dh)
         }
     #endif
         dh->bits = mp_count_bits(&dh->key.p);
+        /* Named group of template still applies. */
+        dh->id = ctx->dh->id;
+        dh->privBits = ctx->dh->privBits;
     }
     else if (ctx->name[0] != '\0') {
         if (!wp_dh_map_group_name(dh, ctx->name)) {
@@ -1493,7 +1716,7 @@ static int wp_dh_gen_keypair(wp_DhGenCtx *ctx, wp_Dh* dh)
      * prime 'q'. When not available, just use the size of the prime 'p'.
      */
 #ifdef HAVE_FFDHE_Q
-    if (!mp_is_zero(&dh->key->q)) {
+    if (!mp_iszero(&dh->key.q)) {
         sz = mp_unsigned_bin_size(&dh->key.q);
     }
     else
@@ -1527,7 +1750,27 @@ static int wp_dh_gen_keypair(wp_DhGenCtx *ctx, wp_Dh* dh)
             }
         }
     }
-    if (ok) {
+    if (ok && (dh->privBits > 0)) {
+        /* Short exponent for named group - the private key is a random
+         * number of exactly privBits bits. */
+        privSz = (dh->privBits + 7) / 8;
+        rc = wc_RNG_GenerateBlock(&ctx->rng, dh->priv, privSz);
+        if (rc != 0) {
+            ok = 0;
+        }
+        if (ok) {
+            dh->priv[0] &= 0xff >> (privSz * 8 - dh->privBits);
+            dh->priv[0] |= 0x80 >> (privSz * 8 - dh->privBits);
+
+            pubSz = dh->pubSz;
+            rc = wc_DhGeneratePublic(&dh->key, dh->priv, privSz, dh->pub,
+                &pubSz);
+            if (rc != 0) {
+                ok = 0;
+            }
+        }
+    }
+    else if (ok) {
         /* Use wolfSSL to generate key pair. */
         pubSz = dh->pubSz;
         privSz = dh->privSz;
@@ -1802,6 +2045,7 @@ static int wp_dh_decode_spki(wp_Dh* dh, unsigned char* data, word32 len)
     }
     if (ok) {
         dh->bits = mp_count_bits(&dh->key.p);
+        wp_dh_match_group(dh);
     }
 
     return ok;
@@ -1869,6 +2113,7 @@ static int wp_dh_decode_pki(wp_Dh* dh, unsigned char* data, word32 len)
     if (ok) {
         dh->pubSz = idx;
         dh->bits = mp_count_bits(&dh->key.p);
+        wp_dh_match_group(dh);
     }
 
     OPENSSL_free(base);
@@ -1896,6 +2141,7 @@ static int wp_dh_decode_params(wp_Dh* dh, unsigned char* data, word32 len)
     }
     if (ok) {
         dh->bits = mp_count_bits(&dh->key.p);
+        wp_dh_match_group(dh);
     }
 
     return ok;
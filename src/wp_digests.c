@@ -32,6 +32,19 @@
  */
 #define WP_DIGEST_FLAG_ALGID_ABSENT    0x0002
 
+/**
+ * Digest one message, with a new digest object, into the output buffer.
+ *
+ * @param [in]  in      Message to digest.
+ * @param [in]  inLen   Length of message in bytes.
+ * @param [out] out     Buffer to hold digest.
+ * @param [in]  outLen  Length of digest in bytes. Only used by XOFs.
+ * @return 1 on success.
+ * @return 0 on failure.
+ */
+typedef int (*WP_DIGEST_ONE_FN)(const unsigned char* in, size_t inLen,
+    unsigned char* out, size_t outLen);
+
 
 /** Implement a function for algorithm that gets the parameters. */
 #define IMPLEMENT_DIGEST_GET_PARAM(name, blkSize, dgstSize, flags)             \
@@ -61,7 +74,7 @@ static CTX* name##_newctx(WOLFPROV_CTX* provCtx)                               \
     CTX* ctx = NULL;                                                           \
     (void)provCtx;                                                             \
     if (wolfssl_prov_is_running()) {                                           \
-        ctx = OPENSSL_zalloc(sizeof(CTX));                                     \
+        ctx = wp_pool_zalloc(sizeof(CTX));                                     \
     }                                                                          \
     return ctx;                                                                \
 }
@@ -79,7 +92,7 @@ static CTX* name##_newctx(WOLFPROV_CTX* provCtx)                               \
 static void name##_freectx(CTX* ctx)                                           \
 {                                                                              \
     free(ctx);                                                                 \
-    OPENSSL_free(ctx);                                                         \
+    wp_pool_clear_free(ctx, sizeof(CTX));                                      \
 }
 
 /** Implement duplicating a digest object. */
@@ -95,13 +108,13 @@ static CTX* name##_dupctx(CTX* src)                                            \
 {                                                                              \
     CTX* dst = NULL;                                                           \
     if (wolfssl_prov_is_running()) {                                           \
-        dst = OPENSSL_malloc(sizeof(*src));                                    \
+        dst = wp_pool_zalloc(sizeof(*src));                                    \
     }                                                                          \
     if (dst != NULL) {                                                         \
         int rc;                                                                \
         rc = copy(src, dst);                                                   \
         if (rc != 0) {                                                         \
-            OPENSSL_free(dst);                                                 \
+            wp_pool_clear_free(dst, sizeof(*dst));                             \
             dst = NULL;                                                        \
         }                                                                      \
     }                                                                          \
@@ -148,10 +161,14 @@ static int name##_init(CTX* ctx, const OSSL_PARAM params[])                    \
 static int name##_update(void* ctx, const unsigned char* in, size_t inLen)     \
 {                                                                              \
     int ok = 1;                                                                \
+    word64 mStart = wp_metrics_start();                                        \
     int rc = upd(ctx, in, inLen);                                              \
     if (rc != 0) {                                                             \
         ok = 0;                                                                \
     }                                                                          \
+    else {                                                                     \
+        wp_metrics_record(WP_METRIC_DIGEST_UPDATE, mStart, inLen);             \
+    }                                                                          \
     return ok;                                                                 \
 }
 
@@ -189,6 +206,48 @@ static int name##_final(void* ctx, unsigned char* out, size_t* outLen,         \
     return ok;                                                                 \
 }
 
+/** Implement getting the context parameters - batch digest operation. */
+#define IMPLEMENT_DIGEST_GET_CTX_PARAMS(name, CTX, dgstSize, init, upd, fin,   \
+                                        free)                                  \
+/**                                                                            \
+ * Digest one message with a digest object on the stack.                       \
+ *                                                                             \
+ * @param [in]  in      Message to digest.                                     \
+ * @param [in]  inLen   Length of message in bytes.                            \
+ * @param [out] out     Buffer to hold digest.                                 \
+ * @param [in]  outLen  Length of digest in bytes. Unused.                     \
+ * @return 1 on success.                                                       \
+ * @return 0 on failure.                                                       \
+ */                                                                            \
+static int name##_digest_one(const unsigned char* in, size_t inLen,            \
+    unsigned char* out, size_t outLen)                                         \
+{                                                                              \
+    int rc;                                                                    \
+    CTX dgst;                                                                  \
+    (void)outLen;                                                              \
+    rc = init(&dgst, NULL, -1);                                                \
+    if (rc == 0) {                                                             \
+        rc = upd(&dgst, in, inLen);                                            \
+        if (rc == 0) {                                                         \
+            rc = fin(&dgst, out);                                              \
+        }                                                                      \
+        free(&dgst);                                                           \
+    }                                                                          \
+    return rc == 0;                                                            \
+}                                                                              \
+/**                                                                            \
+ * Get the context parameters. Digest operation state is not changed.          \
+ *                                                                             \
+ * @param [in]      ctx     Digest context object. Unused.                     \
+ * @param [in, out] params  Parameters to be looked-up.                        \
+ * @return 1 on success.                                                       \
+ * @return 0 on failure.                                                       \
+ */                                                                            \
+static int name##_get_ctx_params(CTX* ctx, OSSL_PARAM params[])                \
+{                                                                              \
+    (void)ctx;                                                                 \
+    return wp_digest_batch(params, dgstSize, name##_digest_one);               \
+}
 
 /**
  * Implement the digest functions for an algorithm.
@@ -203,6 +262,7 @@ IMPLEMENT_DIGEST_FINAL(name, CTX, dgstSize, fin)                               \
 IMPLEMENT_DIGEST_FREECTX(name, CTX, free)                                      \
 IMPLEMENT_DIGEST_DUPCTX(name, CTX, copy)                                       \
 IMPLEMENT_DIGEST_GET_PARAM(name, blkSize, dgstSize, flags)                     \
+IMPLEMENT_DIGEST_GET_CTX_PARAMS(name, CTX, dgstSize, init, upd, fin, free)     \
 /** Dispatch table for digest algorithms. */                                   \
 const OSSL_DISPATCH name##_functions[] = {                                     \
     { OSSL_FUNC_DIGEST_NEWCTX,          (DFUNC)name##_newctx                }, \
@@ -213,6 +273,9 @@ const OSSL_DISPATCH name##_functions[] = {                                     \
     { OSSL_FUNC_DIGEST_DUPCTX,          (DFUNC)name##_dupctx                }, \
     { OSSL_FUNC_DIGEST_GET_PARAMS,      (DFUNC)name##_get_params            }, \
     { OSSL_FUNC_DIGEST_GETTABLE_PARAMS, (DFUNC)wp_digest_gettable_params    }, \
+    { OSSL_FUNC_DIGEST_GET_CTX_PARAMS,  (DFUNC)name##_get_ctx_params        }, \
+    { OSSL_FUNC_DIGEST_GETTABLE_CTX_PARAMS,                                    \
+                                   (DFUNC)wp_digest_gettable_ctx_params     }, \
     { 0,                                NULL                                }  \
 };
 
@@ -282,6 +345,96 @@ static const OSSL_PARAM* wp_digest_gettable_params(void* provCtx)
     return wp_digest_supported_gettable_params;
 }
 
+/**
+ * Get the table of supported context parameters for digests.
+ *
+ * @param [in] ctx      Digest context object. Unused.
+ * @param [in] provCtx  Provider context. Unused.
+ * @return Table of supported context parameters.
+ */
+static const OSSL_PARAM* wp_digest_gettable_ctx_params(void* ctx,
+    void* provCtx)
+{
+    /** Table of supported context parameters. */
+    static const OSSL_PARAM wp_digest_supported_gettable_ctx_params[] = {
+        OSSL_PARAM_octet_string(WP_DIGEST_PARAM_BATCH_MSGS, NULL, 0),
+        OSSL_PARAM_octet_string(WP_DIGEST_PARAM_BATCH_DIGESTS, NULL, 0),
+        OSSL_PARAM_END
+    };
+
+    (void)ctx;
+    (void)provCtx;
+    return wp_digest_supported_gettable_ctx_params;
+}
+
+/**
+ * Digest a batch of independent messages.
+ *
+ * Messages are read from the WP_DIGEST_PARAM_BATCH_MSGS parameter and the
+ * digests written to the WP_DIGEST_PARAM_BATCH_DIGESTS parameter. Each message
+ * is digested with a new wolfSSL object on the stack, avoiding a digest
+ * context allocation and EVP round trip per message. When the digests
+ * parameter has no buffer, only the required size is returned.
+ *
+ * @param [in, out] params    Parameters to be looked-up.
+ * @param [in]      dgstSize  Size of digest, or XOF output, in bytes.
+ * @param [in]      one       Function to digest one message.
+ * @return 1 on success.
+ * @return 0 on failure.
+ */
+static int wp_digest_batch(OSSL_PARAM params[], size_t dgstSize,
+    WP_DIGEST_ONE_FN one)
+{
+    int ok = 1;
+    OSSL_PARAM* p;
+    const OSSL_PARAM* m = NULL;
+    const unsigned char* data = NULL;
+    size_t len = 0;
+    size_t idx = 0;
+    size_t cnt = 0;
+    const unsigned char* msg;
+    size_t msgLen;
+
+    p = OSSL_PARAM_locate(params, WP_DIGEST_PARAM_BATCH_DIGESTS);
+    if (p != NULL) {
+        m = OSSL_PARAM_locate_const(params, WP_DIGEST_PARAM_BATCH_MSGS);
+        if ((m == NULL) || (m->data_type != OSSL_PARAM_OCTET_STRING) ||
+                (p->data_type != OSSL_PARAM_OCTET_STRING)) {
+            ok = 0;
+        }
+    }
+    if ((p != NULL) && ok) {
+        data = (const unsigned char*)m->data;
+        len = m->data_size;
+        /* Validate format and count messages before digesting any. */
+        while (ok && (idx < len)) {
+            if (!wp_batch_get_field(data, len, &idx, &msg, &msgLen)) {
+                ok = 0;
+            }
+            else {
+                cnt++;
+            }
+        }
+    }
+    if ((p != NULL) && ok) {
+        p->return_size = cnt * dgstSize;
+        if ((p->data != NULL) && (p->data_size < cnt * dgstSize)) {
+            ok = 0;
+        }
+    }
+    if ((p != NULL) && ok && (p->data != NULL)) {
+        unsigned char* out = (unsigned char*)p->data;
+        size_t i;
+
+        for (i = 0, idx = 0; ok && (i < cnt); i++) {
+            (void)wp_batch_get_field(data, len, &idx, &msg, &msgLen);
+            ok = one(msg, msgLen, out + i * dgstSize, dgstSize);
+        }
+    }
+
+    return ok;
+}
+
 
 /*******************************************************************************
  * MD5
@@ -524,6 +677,8 @@ static int name##_init(CTX* ctx, const OSSL_PARAM params[])                    \
         if (rc != 0) {                                                         \
             ok = 0;                                                            \
         }                                                                      \
+        ctx->squeezing = 0;                                                    \
+        ctx->bufLen = 0;                                                       \
     }                                                                          \
     if (ok && (!wp_##alg##_set_ctx_params(ctx, params))) {                     \
         ok = 0;                                                                \
@@ -531,6 +686,38 @@ static int name##_init(CTX* ctx, const OSSL_PARAM params[])                    \
     return ok;                                                                 \
 }                                                                              \
 
+/** Implement updating an XOF object with data. */
+#define IMPLEMENT_XOF_UPDATE(name, CTX, upd)                                   \
+/**                                                                            \
+ * Update the XOF context object with data.                                    \
+ *                                                                             \
+ * No more data can be absorbed once output has been squeezed.                 \
+ *                                                                             \
+ * @param [in, out] ctx    XOF context object.                                 \
+ * @param [in]      in     Data to be digested.                                \
+ * @param [in]      inLen  Length of data in bytes.                            \
+ * @return 1 on success.                                                       \
+ * @return 0 on failure.                                                       \
+ */                                                                            \
+static int name##_update(CTX* ctx, const unsigned char* in, size_t inLen)      \
+{                                                                              \
+    int ok = 1;                                                                \
+    word64 mStart = wp_metrics_start();                                        \
+    if (ctx->squeezing) {                                                      \
+        ok = 0;                                                                \
+    }                                                                          \
+    if (ok) {                                                                  \
+        int rc = upd(&ctx->obj, in, (word32)inLen);                            \
+        if (rc != 0) {                                                         \
+            ok = 0;                                                            \
+        }                                                                      \
+        else {                                                                 \
+            wp_metrics_record(WP_METRIC_DIGEST_UPDATE, mStart, inLen);         \
+        }                                                                      \
+    }                                                                          \
+    return ok;                                                                 \
+}
+
 /** Implement finalizing an XOF object to produce output. */
 #define IMPLEMENT_XOF_FINAL(name, CTX, dgstSize, fin)                          \
 /**                                                                            \
@@ -550,7 +737,7 @@ static int name##_final(CTX* ctx, unsigned char* out, size_t* outLen,          \
     if (!wolfssl_prov_is_running()) {                                          \
         ok = 0;                                                                \
     }                                                                          \
-    if (ok && (outSize < ctx->outLen)) {                                       \
+    if (ok && ((outSize < ctx->outLen) || ctx->squeezing)) {                   \
         ok = 0;                                                                \
     }                                                                          \
     if (ok) {                                                                  \
@@ -565,6 +752,70 @@ static int name##_final(CTX* ctx, unsigned char* out, size_t* outLen,          \
     return ok;                                                                 \
 }
 
+/** Implement squeezing output from an XOF object. */
+#define IMPLEMENT_XOF_SQUEEZE(name, CTX, blkSize, absorb, squeeze)             \
+/**                                                                            \
+ * Squeeze more output from the XOF operation.                                 \
+ *                                                                             \
+ * First call pads the absorbed data. Each call continues the output stream    \
+ * from where the last left off - whole blocks are squeezed straight into the  \
+ * output and the rest of a partly used block kept for the next call.          \
+ *                                                                             \
+ * @param [in, out] ctx      XOF context object.                               \
+ * @param [out]     out      Output buffer.                                    \
+ * @param [out]     outLen   Length of output in bytes.                        \
+ * @param [in]      outSize  Number of bytes to squeeze.                       \
+ * @return 1 on success.                                                       \
+ * @return 0 on failure.                                                       \
+ */                                                                            \
+static int name##_squeeze(CTX* ctx, unsigned char* out, size_t* outLen,        \
+    size_t outSize)                                                            \
+{                                                                              \
+    int ok = 1;                                                                \
+    int rc = 0;                                                                \
+    size_t left = outSize;                                                     \
+    if (!wolfssl_prov_is_running()) {                                          \
+        ok = 0;                                                                \
+    }                                                                          \
+    if (ok && (!ctx->squeezing)) {                                             \
+        /* Absorbing no more data pads and leaves state ready to squeeze. */   \
+        rc = absorb(&ctx->obj, NULL, 0);                                       \
+        if (rc != 0) {                                                         \
+            ok = 0;                                                            \
+        }                                                                      \
+        else {                                                                 \
+            ctx->squeezing = 1;                                                \
+            ctx->bufLen = 0;                                                   \
+        }                                                                      \
+    }                                                                          \
+    while (ok && (left > 0)) {                                                 \
+        size_t len;                                                            \
+        if (ctx->bufLen > 0) {                                                 \
+            len = (left < ctx->bufLen) ? left : ctx->bufLen;                   \
+            XMEMCPY(out, ctx->buf + (blkSize) - ctx->bufLen, len);             \
+            ctx->bufLen -= len;                                                \
+        }                                                                      \
+        else if (left >= (blkSize)) {                                          \
+            len = left - (left % (blkSize));                                   \
+            rc = squeeze(&ctx->obj, out, (word32)(len / (blkSize)));           \
+        }                                                                      \
+        else {                                                                 \
+            len = 0;                                                           \
+            rc = squeeze(&ctx->obj, ctx->buf, 1);                              \
+            ctx->bufLen = (blkSize);                                           \
+        }                                                                      \
+        if (rc != 0) {                                                         \
+            ok = 0;                                                            \
+        }                                                                      \
+        out += len;                                                            \
+        left -= len;                                                           \
+    }                                                                          \
+    if (ok) {                                                                  \
+        *outLen = outSize;                                                     \
+    }                                                                          \
+    return ok;                                                                 \
+}
+
 /** Implement disposing of an XOF object. */
 #define IMPLEMENT_XOF_FREECTX(name, CTX, free)                                 \
 /**                                                                            \
@@ -578,7 +829,7 @@ static int name##_final(CTX* ctx, unsigned char* out, size_t* outLen,          \
 static void name##_freectx(CTX* ctx)                                           \
 {                                                                              \
     free(&ctx->obj);                                                           \
-    OPENSSL_free(ctx);                                                         \
+    wp_pool_clear_free(ctx, sizeof(CTX));                                      \
 }
 
 /** Implement duplicating an XOF object. */
@@ -594,17 +845,20 @@ static CTX* name##_dupctx(CTX* src)                                            \
 {                                                                              \
     CTX* dst = NULL;                                                           \
     if (wolfssl_prov_is_running()) {                                           \
-        dst = OPENSSL_malloc(sizeof(*src));                                    \
+        dst = wp_pool_zalloc(sizeof(*src));                                    \
     }                                                                          \
     if (dst != NULL) {                                                         \
         int rc;                                                                \
         rc = copy(&src->obj, &dst->obj);                                       \
         if (rc != 0) {                                                         \
-            OPENSSL_free(dst);                                                 \
+            wp_pool_clear_free(dst, sizeof(*dst));                             \
             dst = NULL;                                                        \
         }                                                                      \
         else {                                                                 \
             dst->outLen = src->outLen;                                         \
+            dst->squeezing = src->squeezing;                                   \
+            dst->bufLen = src->bufLen;                                         \
+            XMEMCPY(dst->buf, src->buf, sizeof(src->buf));                     \
         }                                                                      \
     }                                                                          \
     return dst;                                                                \
@@ -633,18 +887,74 @@ static int name##_set_ctx_params(CTX* ctx, const OSSL_PARAM params[])          \
     return ok;                                                                 \
 }
 
+/** Implement getting the context parameters - batch XOF operation. */
+#define IMPLEMENT_XOF_GET_CTX_PARAMS(name, CTX, WC_CTX, dgstSize, init, upd,   \
+                                     fin, free)                                \
+/**                                                                            \
+ * Produce output for one message with an XOF object on the stack.             \
+ *                                                                             \
+ * @param [in]  in      Message to digest.                                     \
+ * @param [in]  inLen   Length of message in bytes.                            \
+ * @param [out] out     Buffer to hold output.                                 \
+ * @param [in]  outLen  Length of output in bytes.                             \
+ * @return 1 on success.                                                       \
+ * @return 0 on failure.                                                       \
+ */                                                                            \
+static int name##_digest_one(const unsigned char* in, size_t inLen,            \
+    unsigned char* out, size_t outLen)                                         \
+{                                                                              \
+    int rc;                                                                    \
+    WC_CTX xof;                                                                \
+    rc = init(&xof, NULL, -1);                                                 \
+    if (rc == 0) {                                                             \
+        rc = upd(&xof, in, (word32)inLen);                                     \
+        if (rc == 0) {                                                         \
+            rc = fin(&xof, out, (word32)outLen);                               \
+        }                                                                      \
+        free(&xof);                                                            \
+    }                                                                          \
+    return rc == 0;                                                            \
+}                                                                              \
+/**                                                                            \
+ * Get the context parameters. XOF operation state is not changed.             \
+ *                                                                             \
+ * Output length of each message of a batch is the XOF length set, or the      \
+ * default digest size when not set.                                           \
+ *                                                                             \
+ * @param [in]      ctx     XOF context object.                                \
+ * @param [in, out] params  Parameters to be looked-up.                        \
+ * @return 1 on success.                                                       \
+ * @return 0 on failure.                                                       \
+ */                                                                            \
+static int name##_get_ctx_params(CTX* ctx, OSSL_PARAM params[])                \
+{                                                                              \
+    size_t len = (ctx->outLen > 0) ? ctx->outLen : (dgstSize);                 \
+    return wp_digest_batch(params, len, name##_digest_one);                    \
+}
+
+#ifdef OSSL_FUNC_DIGEST_SQUEEZE
+/** Dispatch table entry for squeezing from an XOF. */
+#define WP_XOF_SQUEEZE_FUNC(name)                                              \
+    { OSSL_FUNC_DIGEST_SQUEEZE,           (DFUNC)name##_squeeze             },
+#else
+/** Squeeze not supported by OpenSSL being built against. */
+#define WP_XOF_SQUEEZE_FUNC(name)
+#endif
 
 /**
  * Implement the XOF functions for an algorithm.
  * Also define the dispatch table for the functions.
  */
 #define IMPLEMENT_XOF(alg, name, WC_CTX, CTX, blkSize, dgstSize, flags,        \
-                      init, upd, fin, copy, free)                              \
+                      init, upd, fin, copy, free, absorb, squeeze)             \
 IMPLEMENT_XOF_INIT(alg, name, CTX, init)                                       \
-IMPLEMENT_DIGEST_UPDATE(name, WC_CTX, upd)                                     \
+IMPLEMENT_XOF_UPDATE(name, CTX, upd)                                           \
 IMPLEMENT_XOF_FINAL(name, CTX, dgstSize, fin)                                  \
+IMPLEMENT_XOF_SQUEEZE(name, CTX, blkSize, absorb, squeeze)                     \
 IMPLEMENT_XOF_FREECTX(name, CTX, free)                                         \
 IMPLEMENT_XOF_DUPCTX(name, CTX, copy)                                          \
+IMPLEMENT_XOF_GET_CTX_PARAMS(name, CTX, WC_CTX, dgstSize, init, upd, fin,      \
+                             free)                                             \
 IMPLEMENT_DIGEST_GET_PARAM(name, blkSize, dgstSize, flags)                     \
 /** Dispatch table for XOF algorithms. */                                      \
 const OSSL_DISPATCH name##_functions[] = {                                     \
@@ -652,10 +962,14 @@ const OSSL_DISPATCH name##_functions[] = {                                     \
     { OSSL_FUNC_DIGEST_INIT,              (DFUNC)name##_init                }, \
     { OSSL_FUNC_DIGEST_UPDATE,            (DFUNC)name##_update              }, \
     { OSSL_FUNC_DIGEST_FINAL,             (DFUNC)name##_final               }, \
+    WP_XOF_SQUEEZE_FUNC(name)                                                  \
     { OSSL_FUNC_DIGEST_FREECTX,           (DFUNC)name##_freectx             }, \
     { OSSL_FUNC_DIGEST_DUPCTX,            (DFUNC)name##_dupctx              }, \
     { OSSL_FUNC_DIGEST_GET_PARAMS,        (DFUNC)name##_get_params          }, \
     { OSSL_FUNC_DIGEST_GETTABLE_PARAMS,   (DFUNC)wp_digest_gettable_params  }, \
+    { OSSL_FUNC_DIGEST_GET_CTX_PARAMS,    (DFUNC)name##_get_ctx_params      }, \
+    { OSSL_FUNC_DIGEST_GETTABLE_CTX_PARAMS,                                    \
+                                      (DFUNC)wp_digest_gettable_ctx_params  }, \
     { OSSL_FUNC_DIGEST_SET_CTX_PARAMS,    (DFUNC)wp_##alg##_set_ctx_params  }, \
     { OSSL_FUNC_DIGEST_SETTABLE_CTX_PARAMS,                                    \
                                           (DFUNC)wp_xof_settable_ctx_params }, \
@@ -688,6 +1002,13 @@ static const OSSL_PARAM* wp_xof_settable_ctx_params(void* ctx,
 /** All SHAKE algorithms are eXtendable Output Functions. */
 #define WP_SHAKE_FLAGS  WP_DIGEST_FLAG_XOF
 
+/** SHAKE-128 block size (rate) in bytes: (1600 - 2 * 128) / 8. */
+#define WP_SHAKE128_BLOCK_SIZE      168
+/** SHAKE-128 default output size in bytes. */
+#define WP_SHAKE128_DIGEST_SIZE     16
+/** Largest block size of the SHAKE algorithms. */
+#define WP_SHAKE_MAX_BLOCK_SIZE     WP_SHAKE128_BLOCK_SIZE
+
 /**
  * SHAKE context object.
  * Need to keep the outpt length for finalization.
@@ -697,15 +1018,31 @@ typedef struct wp_ShakeCtx {
     wc_Shake obj;
     /** Output length when finalization is called. */
     size_t outLen;
+    /** Output has been squeezed - no more data can be absorbed. */
+    int squeezing;
+    /** Last block squeezed. Unused output is at the end. */
+    unsigned char buf[WP_SHAKE_MAX_BLOCK_SIZE];
+    /** Number of bytes of last block squeezed not yet output. */
+    size_t bufLen;
 } wp_ShakeCtx;
 
 
 IMPLEMENT_DIGEST_NEWCTX(wp_shake, wp_ShakeCtx)
 IMPLEMENT_XOF_SET_CTX_PARAMS(wp_shake, wp_ShakeCtx)
 
+#ifdef WOLFSSL_SHAKE128
+IMPLEMENT_XOF(shake, wp_shake_128, wc_Shake, wp_ShakeCtx,
+              WP_SHAKE128_BLOCK_SIZE, WP_SHAKE128_DIGEST_SIZE,
+              WP_SHAKE_FLAGS,
+              wc_InitShake128, wc_Shake128_Update, wc_Shake128_Final,
+              wc_Shake128_Copy, wc_Shake128_Free, wc_Shake128_Absorb,
+              wc_Shake128_SqueezeBlocks)
+#endif
+
 IMPLEMENT_XOF(shake, wp_shake_256, wc_Shake, wp_ShakeCtx,
               WC_SHA3_256_BLOCK_SIZE, WC_SHA3_256_DIGEST_SIZE,
               WP_SHAKE_FLAGS,
               wc_InitShake256, wc_Shake256_Update, wc_Shake256_Final,
-              wc_Shake256_Copy, wc_Shake256_Free)
+              wc_Shake256_Copy, wc_Shake256_Free, wc_Shake256_Absorb,
+              wc_Shake256_SqueezeBlocks)
 
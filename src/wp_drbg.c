@@ -20,6 +20,7 @@
 
 
 #include <string.h>
+#include <unistd.h>
 
 #include <openssl/core_dispatch.h>
 #include <openssl/core_names.h>
@@ -30,6 +31,15 @@
 #include <wolfprovider/alg_funcs.h>
 #include <wolfprovider/internal.h>
 
+#if defined(__x86_64__) && defined(__RDSEED__)
+    #include <immintrin.h>
+    /* Seed pool filled with RDSEED. */
+    #define WP_SEED_RDSEED
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_RNG)
+    #include <arm_acle.h>
+    /* Seed pool filled with RNDRRS. */
+    #define WP_SEED_RNDR
+#endif
 
 /* TODO: Add seed. No API avaialble. */
 
@@ -43,12 +53,25 @@
  */
 #define WP_DRBG_STRENGTH        256
 
+/** Length in bytes of entropy to reseed with for prediction resistance. */
+#define WP_DRBG_RESEED_LEN      (WP_DRBG_STRENGTH / 8)
+
 /**
  * DRBG context structure.
  */
 typedef struct wp_DrbgCtx {
     /** wolfSSL random number generator. HASH DRBG implementation. */
     WC_RNG* rng;
+    /** Buffer of DRBG output. NULL when not buffering. */
+    unsigned char* buf;
+    /** Size of output buffer in bytes. */
+    size_t bufSize;
+    /** Number of unused bytes at the end of the output buffer. */
+    size_t bufLen;
+    /** Id of process DRBG last generated in. Changes when forked. */
+    pid_t pid;
+    /** Use additional input and prediction resistance. */
+    int useAdIn;
 #ifndef WP_SINGLE_THREADED
     /** Mutex for multithreading access to this DRBG context. */
     wolfSSL_Mutex* mutex;
@@ -56,6 +79,315 @@ typedef struct wp_DrbgCtx {
 } wp_DrbgCtx;
 
 
+#ifdef WC_RNG_SEED_CB
+/** Size in bytes of seed pool. Refilled with one read of the entropy source. */
+#define WP_SEED_POOL_SIZE       4096
+/**
+ * Repetition count test cutoff: 1 + ceil(20 / H) with an assessed min-entropy
+ * of H = 1 bit per byte. See NIST SP 800-90B 4.4.1.
+ */
+#define WP_SEED_RCT_CUTOFF      21
+/** Adaptive proportion test window size in bytes. Non-binary source. */
+#define WP_SEED_APT_WINDOW      512
+/**
+ * Adaptive proportion test cutoff for H = 1 bit per byte.
+ * See NIST SP 800-90B 4.4.2 Table 2.
+ */
+#define WP_SEED_APT_CUTOFF      410
+#if defined(WP_SEED_RDSEED) || defined(WP_SEED_RNDR)
+/** Number of attempts at each hardware seed word before falling back. */
+#define WP_SEED_HW_RETRIES      64
+#endif
+
+/** Health tested entropy not yet handed out. Unused bytes are at the end. */
+static unsigned char wp_seed_pool[WP_SEED_POOL_SIZE];
+/** Number of unused bytes at the end of the seed pool. */
+static size_t wp_seed_pool_len = 0;
+/** Id of process that filled the seed pool. Changes when forked. */
+static pid_t wp_seed_pool_pid = 0;
+/** Number of provider contexts using the seed pool. */
+static int wp_seed_pool_users = 0;
+#ifndef WP_SINGLE_THREADED
+/** Protects seed pool, users count and registration of seed callback. */
+static pthread_mutex_t wp_seed_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+#if defined(WP_SEED_RDSEED) || defined(WP_SEED_RNDR)
+/**
+ * Fill buffer with seed from the CPU's hardware entropy source.
+ *
+ * @param [out] buf  Buffer to fill.
+ * @param [in]  len  Length of buffer in bytes. Multiple of 8.
+ * @return  1 on success.
+ * @return  0 when hardware source is not producing entropy.
+ */
+static int wp_seed_hw(unsigned char* buf, size_t len)
+{
+    int ok = 1;
+    size_t i;
+    int retry;
+#ifdef WP_SEED_RDSEED
+    unsigned long long v = 0;
+#else
+    uint64_t v = 0;
+#endif
+
+    for (i = 0; ok && (i < len); i += sizeof(v)) {
+        for (retry = 0; retry < WP_SEED_HW_RETRIES; retry++) {
+        #ifdef WP_SEED_RDSEED
+            if (_rdseed64_step(&v)) {
+                break;
+            }
+            _mm_pause();
+        #else
+            if (__rndrrs(&v) == 0) {
+                break;
+            }
+        #endif
+        }
+        if (retry == WP_SEED_HW_RETRIES) {
+            ok = 0;
+        }
+        else {
+            XMEMCPY(buf + i, &v, sizeof(v));
+        }
+    }
+
+    OPENSSL_cleanse(&v, sizeof(v));
+    return ok;
+}
+#endif
+
+/**
+ * Run continuous health tests over entropy read from the source.
+ *
+ * Repetition count test and adaptive proportion test of NIST SP 800-90B 4.4.
+ * Detects a source that has become stuck or heavily biased.
+ *
+ * @param [in] data  Entropy data.
+ * @param [in] len   Length of data in bytes.
+ * @return  1 when tests pass.
+ * @return  0 when a test fails.
+ */
+static int wp_seed_health_test(const unsigned char* data, size_t len)
+{
+    int ok = 1;
+    size_t i;
+    size_t run = 1;
+    size_t cnt = 0;
+    unsigned char first = 0;
+
+    for (i = 0; ok && (i < len); i++) {
+        /* Repetition count test. */
+        if ((i > 0) && (data[i] == data[i - 1])) {
+            if (++run >= WP_SEED_RCT_CUTOFF) {
+                ok = 0;
+            }
+        }
+        else {
+            run = 1;
+        }
+        /* Adaptive proportion test. */
+        if ((i % WP_SEED_APT_WINDOW) == 0) {
+            first = data[i];
+            cnt = 1;
+        }
+        else if ((data[i] == first) && (++cnt >= WP_SEED_APT_CUTOFF)) {
+            ok = 0;
+        }
+    }
+
+    return ok;
+}
+
+/**
+ * Refill the seed pool from the entropy source.
+ *
+ * Uses the CPU's hardware source when available, otherwise the OS. Pool is
+ * left empty when the health tests fail.
+ *
+ * Caller holds the seed pool lock.
+ *
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_seed_pool_fill(void)
+{
+    int ok = 1;
+
+#if defined(WP_SEED_RDSEED) || defined(WP_SEED_RNDR)
+    if (!wp_seed_hw(wp_seed_pool, sizeof(wp_seed_pool)))
+#endif
+    {
+        OS_Seed os;
+
+        XMEMSET(&os, 0, sizeof(os));
+        if (wc_GenerateSeed(&os, wp_seed_pool, sizeof(wp_seed_pool)) != 0) {
+            ok = 0;
+        }
+    }
+    if (ok && (!wp_seed_health_test(wp_seed_pool, sizeof(wp_seed_pool)))) {
+        ok = 0;
+    }
+    if (ok) {
+        wp_seed_pool_len = sizeof(wp_seed_pool);
+    }
+    else {
+        OPENSSL_cleanse(wp_seed_pool, sizeof(wp_seed_pool));
+        wp_seed_pool_len = 0;
+    }
+
+    return ok;
+}
+
+/**
+ * Take seed from the seed pool.
+ *
+ * Bytes are zeroized in the pool once taken. Pool is emptied in a forked child
+ * so that parent and child never share seed.
+ *
+ * Caller holds the seed pool lock.
+ *
+ * @param [out] seed  Buffer to hold seed.
+ * @param [in]  sz    Number of bytes of seed required.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_seed_pool_get(unsigned char* seed, size_t sz)
+{
+    int ok = 1;
+    pid_t pid = getpid();
+
+    if (wp_seed_pool_pid != pid) {
+        OPENSSL_cleanse(wp_seed_pool, sizeof(wp_seed_pool));
+        wp_seed_pool_len = 0;
+        wp_seed_pool_pid = pid;
+    }
+    while (ok && (sz > 0)) {
+        if ((wp_seed_pool_len == 0) && (!wp_seed_pool_fill())) {
+            ok = 0;
+        }
+        else {
+            size_t len = sz;
+            unsigned char* p;
+
+            if (len > wp_seed_pool_len) {
+                len = wp_seed_pool_len;
+            }
+            p = wp_seed_pool + sizeof(wp_seed_pool) - wp_seed_pool_len;
+            XMEMCPY(seed, p, len);
+            OPENSSL_cleanse(p, len);
+            wp_seed_pool_len -= len;
+            seed += len;
+            sz -= len;
+        }
+    }
+
+    return ok;
+}
+
+/**
+ * wolfCrypt seed callback - seeds every wolfCrypt DRBG instantiation.
+ *
+ * Served from the seed pool so that instantiating a DRBG, e.g. one per thread,
+ * doesn't read the OS entropy source each time.
+ *
+ * @param [in]  os    OS seed object. Used when seed pool not in use.
+ * @param [out] seed  Buffer to hold seed.
+ * @param [in]  sz    Number of bytes of seed required.
+ * @return  0 on success.
+ * @return  Negative on failure.
+ */
+static int wp_seed_pool_cb(OS_Seed* os, byte* seed, word32 sz)
+{
+    int ret = 0;
+
+#ifndef WP_SINGLE_THREADED
+    if (pthread_mutex_lock(&wp_seed_pool_mutex) != 0) {
+        ret = BAD_MUTEX_E;
+    }
+    else
+#endif
+    {
+        if (wp_seed_pool_users == 0) {
+            ret = wc_GenerateSeed(os, seed, sz);
+        }
+        else if (!wp_seed_pool_get(seed, sz)) {
+            ret = RNG_FAILURE_E;
+        }
+#ifndef WP_SINGLE_THREADED
+        pthread_mutex_unlock(&wp_seed_pool_mutex);
+#endif
+    }
+
+    return ret;
+}
+#endif /* WC_RNG_SEED_CB */
+
+/**
+ * Start using the seed pool for seeding wolfCrypt DRBGs.
+ *
+ * Called when configured for a provider context. Seed callback registered once
+ * for all provider contexts.
+ *
+ * @return  1 on success.
+ * @return  0 on failure or when wolfSSL not built with seed callback support.
+ */
+int wp_seed_pool_init(void)
+{
+    int ok = 1;
+
+#ifdef WC_RNG_SEED_CB
+#ifndef WP_SINGLE_THREADED
+    if (pthread_mutex_lock(&wp_seed_pool_mutex) != 0) {
+        ok = 0;
+    }
+    else
+#endif
+    {
+        if ((wp_seed_pool_users == 0) &&
+                (wc_SetSeed_Cb(wp_seed_pool_cb) != 0)) {
+            ok = 0;
+        }
+        if (ok) {
+            wp_seed_pool_users++;
+        }
+#ifndef WP_SINGLE_THREADED
+        pthread_mutex_unlock(&wp_seed_pool_mutex);
+#endif
+    }
+#else
+    /* Seed callback not compiled into wolfSSL. */
+    ok = 0;
+#endif
+
+    return ok;
+}
+
+/**
+ * Stop using the seed pool when no longer used by any provider context.
+ *
+ * Restores the OS as the wolfCrypt seed source and zeroizes the pool.
+ */
+void wp_seed_pool_cleanup(void)
+{
+#ifdef WC_RNG_SEED_CB
+#ifndef WP_SINGLE_THREADED
+    if (pthread_mutex_lock(&wp_seed_pool_mutex) == 0)
+#endif
+    {
+        if ((wp_seed_pool_users > 0) && (--wp_seed_pool_users == 0)) {
+            (void)wc_SetSeed_Cb(wc_GenerateSeed);
+            OPENSSL_cleanse(wp_seed_pool, sizeof(wp_seed_pool));
+            wp_seed_pool_len = 0;
+        }
+#ifndef WP_SINGLE_THREADED
+        pthread_mutex_unlock(&wp_seed_pool_mutex);
+#endif
+    }
+#endif
+}
+
 /**
  * Create a new DRBG context object.
  *
@@ -67,11 +399,22 @@ static wp_DrbgCtx* wp_drbg_new(WOLFPROV_CTX* provCtx)
 {
     wp_DrbgCtx* ctx = NULL;
 
-    (void)provCtx;
-
     if (wolfssl_prov_is_running()) {
         ctx = OPENSSL_zalloc(sizeof(*ctx));
     }
+    if ((ctx != NULL) && (provCtx->drbgBufSize > 0)) {
+        ctx->buf = OPENSSL_secure_malloc(provCtx->drbgBufSize);
+        if (ctx->buf == NULL) {
+            OPENSSL_free(ctx);
+            ctx = NULL;
+        }
+        else {
+            ctx->bufSize = provCtx->drbgBufSize;
+        }
+    }
+    if (ctx != NULL) {
+        ctx->useAdIn = provCtx->drbgUseAdIn;
+    }
 
     return ctx;
 }
@@ -91,6 +434,7 @@ static void wp_drbg_free(wp_DrbgCtx* ctx)
         }
     #endif
         (void)wc_rng_free(ctx->rng);
+        OPENSSL_secure_clear_free(ctx->buf, ctx->bufSize);
         OPENSSL_free(ctx);
     }
 }
@@ -125,6 +469,10 @@ static int wp_drbg_instantiate(wp_DrbgCtx* ctx, unsigned int strength,
             ok = 0;
         }
     }
+    if (ok) {
+        ctx->bufLen = 0;
+        ctx->pid = getpid();
+    }
 
     return ok;
 }
@@ -138,14 +486,144 @@ static int wp_drbg_uninstantiate(wp_DrbgCtx* ctx)
 {
     wc_rng_free(ctx->rng);
     ctx->rng = NULL;
+    if (ctx->buf != NULL) {
+        OPENSSL_cleanse(ctx->buf, ctx->bufSize);
+    }
+    ctx->bufLen = 0;
     return 1;
 }
 
+/**
+ * Discard the unused output in the buffer.
+ *
+ * Output generated before a reseed or fork must not be returned after.
+ *
+ * @param [in, out] ctx  DRBG context object.
+ */
+static void wp_drbg_discard_buf(wp_DrbgCtx* ctx)
+{
+    if (ctx->bufLen > 0) {
+        OPENSSL_cleanse(ctx->buf + ctx->bufSize - ctx->bufLen, ctx->bufLen);
+        ctx->bufLen = 0;
+    }
+}
+
+/**
+ * Reseed the DRBG with fresh entropy.
+ *
+ * Used for prediction resistance and when process has forked so that parent
+ * and child don't generate the same output.
+ *
+ * @param [in, out] ctx  DRBG context object.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_drbg_reseed_entropy(wp_DrbgCtx* ctx)
+{
+    int ok = 1;
+    int rc;
+    OS_Seed os;
+    unsigned char seed[WP_DRBG_RESEED_LEN];
+
+    XMEMSET(&os, 0, sizeof(os));
+#ifdef WC_RNG_SEED_CB
+    rc = wp_seed_pool_cb(&os, seed, sizeof(seed));
+#else
+    rc = wc_GenerateSeed(&os, seed, sizeof(seed));
+#endif
+    if (rc == 0) {
+        rc = wc_RNG_DRBG_Reseed(ctx->rng, seed, sizeof(seed));
+    }
+    if (rc != 0) {
+        ok = 0;
+    }
+    wp_drbg_discard_buf(ctx);
+
+    OPENSSL_cleanse(seed, sizeof(seed));
+    return ok;
+}
+
+/**
+ * Reseed the DRBG with fresh entropy when the process has forked.
+ *
+ * Forked DRBG state is the same in parent and child.
+ *
+ * @param [in, out] ctx  DRBG context object.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_drbg_check_fork(wp_DrbgCtx* ctx)
+{
+    int ok = 1;
+    pid_t pid = getpid();
+
+    if (ctx->pid != pid) {
+        ctx->pid = pid;
+        if (!wp_drbg_reseed_entropy(ctx)) {
+            ok = 0;
+        }
+    }
+
+    return ok;
+}
+
+/**
+ * Generate random data from the output buffer.
+ *
+ * Buffer is refilled with one DRBG generate when empty. Bytes are zeroized in
+ * the buffer once returned.
+ *
+ * @param [in, out] ctx     DRBG context object.
+ * @param [out]     out     Buffer to hold random data.
+ * @param [in]      outLen  Number of bytes to generate.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_drbg_generate_buffered(wp_DrbgCtx* ctx, unsigned char* out,
+    size_t outLen)
+{
+    int ok = 1;
+    int rc;
+
+    while (ok && (outLen > 0)) {
+        size_t len;
+        unsigned char* p;
+
+        if (ctx->bufLen == 0) {
+            rc = wc_RNG_GenerateBlock(ctx->rng, ctx->buf, (word32)ctx->bufSize);
+            if (rc != 0) {
+                OPENSSL_cleanse(ctx->buf, ctx->bufSize);
+                ok = 0;
+                break;
+            }
+            ctx->bufLen = ctx->bufSize;
+        }
+
+        len = outLen;
+        if (len > ctx->bufLen) {
+            len = ctx->bufLen;
+        }
+        p = ctx->buf + ctx->bufSize - ctx->bufLen;
+        XMEMCPY(out, p, len);
+        OPENSSL_cleanse(p, len);
+        ctx->bufLen -= len;
+        out += len;
+        outLen -= len;
+    }
+
+    return ok;
+}
+
 
 /**
  * Generate random data.
  *
+ * Requests smaller than the output buffer are served from it. Additional input
+ * and prediction resistance, when used, force an unbuffered generate.
+ *
  * @param [in, out] ctx         DRBG context object.
+ * @param [out]     out         Buffer to hold random data.
+ * @param [in]      outLen      Number of bytes to generate.
  * @param [in]      strength    Strength in bits required.
  * @param [in]      predResist  Prediction resistance required.
  * @param [in]      adIn        Additional input data to seed with.
@@ -159,29 +637,40 @@ static int wp_drbg_generate(wp_DrbgCtx* ctx, unsigned char* out,
 {
     int ok = 1;
     int rc;
-
-    (void)predResist;
+    int unbuffered = 0;
+    word64 mStart = wp_metrics_start();
 
     if (strength > WP_DRBG_STRENGTH) {
         ok = 0;
     }
-#if 0
-    if (ok && (adInLen > 0)) {
-        rc = wc_RNG_DRBG_Reseed(ctx->rng, adIn, adInLen);
-        if (rc != 0) {
+    if (ok && (!wp_drbg_check_fork(ctx))) {
+        ok = 0;
+    }
+    if (ok && ctx->useAdIn && (predResist || (adInLen > 0))) {
+        unbuffered = 1;
+        if (predResist && (!wp_drbg_reseed_entropy(ctx))) {
             ok = 0;
         }
+        if (ok && (adInLen > 0)) {
+            rc = wc_RNG_DRBG_Reseed(ctx->rng, adIn, (word32)adInLen);
+            if (rc != 0) {
+                ok = 0;
+            }
+            wp_drbg_discard_buf(ctx);
+        }
     }
-#else
-    (void)adIn;
-    (void)adInLen;
-#endif
-    if (ok) {
+    if (ok && (!unbuffered) && (outLen < ctx->bufSize)) {
+        ok = wp_drbg_generate_buffered(ctx, out, outLen);
+    }
+    else if (ok) {
         rc = wc_RNG_GenerateBlock(ctx->rng, out, (word32)outLen);
         if (rc != 0) {
             ok = 0;
         }
     }
+    if (ok) {
+        wp_metrics_record(WP_METRIC_RNG_GENERATE, mStart, outLen);
+    }
 
     return ok;
 }
@@ -205,29 +694,29 @@ static int wp_drbg_reseed(wp_DrbgCtx* ctx, int predResist,
     const unsigned char* adIn, size_t adInLen)
 {
     int ok = 1;
-
-#if 0
-    /* Calling Hash_DRBG_Instantiate would be better. */
     int rc;
-    rc = wc_RNG_DRBG_Reseed(ctx->rng, entropy, entropyLen);
-    if (rc != 0) {
-        ok = 0;
-    }
-    if (ok && (adInLen > 0)) {
-        rc = wc_RNG_DRBG_Reseed(ctx->rng, adIn, adInLen);
-        if (rc != 0) {
+
+    /* Output generated before a reseed is never returned after. */
+    wp_drbg_discard_buf(ctx);
+    /* Only reseeded when using additional input. */
+    if (ctx->useAdIn) {
+        /* Calling Hash_DRBG_Instantiate would be better. */
+        if (entropyLen > 0) {
+            rc = wc_RNG_DRBG_Reseed(ctx->rng, entropy, (word32)entropyLen);
+            if (rc != 0) {
+                ok = 0;
+            }
+        }
+        if (ok && predResist && (!wp_drbg_reseed_entropy(ctx))) {
             ok = 0;
         }
+        if (ok && (adInLen > 0)) {
+            rc = wc_RNG_DRBG_Reseed(ctx->rng, adIn, (word32)adInLen);
+            if (rc != 0) {
+                ok = 0;
+            }
+        }
     }
-#else
-    (void)ctx;
-    (void)entropy;
-    (void)entropyLen;
-    (void)adIn;
-    (void)adInLen;
-#endif
-
-    (void)predResist;
 
     return ok;
 }
@@ -318,6 +807,8 @@ static const OSSL_PARAM* wp_drbg_gettable_ctx_params(wp_DrbgCtx* ctx,
     static const OSSL_PARAM wp_supported_gettable_drbg_ctx_params[] = {
         OSSL_PARAM_size_t(OSSL_RAND_PARAM_MAX_REQUEST, NULL),
         OSSL_PARAM_size_t(OSSL_RAND_PARAM_STATE, NULL),
+        OSSL_PARAM_size_t(WP_DRBG_PARAM_BUFFER_SIZE, NULL),
+        OSSL_PARAM_int(WP_DRBG_PARAM_USE_ADIN, NULL),
         OSSL_PARAM_END
     };
     (void)ctx;
@@ -328,7 +819,7 @@ static const OSSL_PARAM* wp_drbg_gettable_ctx_params(wp_DrbgCtx* ctx,
 /**
  * Get the DRBG context parameters.
  *
- * @param [in]      ctx     DRBG context object. Unused.
+ * @param [in]      ctx     DRBG context object.
  * @param [in, out] params  Array of parameters and values.
  * @return  1 on success.
  * @return  0 on failure.
@@ -338,8 +829,6 @@ static int wp_drbg_get_ctx_params(wp_DrbgCtx* ctx, OSSL_PARAM params[])
     int ok = 1;
     OSSL_PARAM* p;
 
-    (void)ctx;
-
     p = OSSL_PARAM_locate(params, OSSL_RAND_PARAM_MAX_REQUEST);
     if ((p != NULL) && (!OSSL_PARAM_set_size_t(p, WP_DRBG_MAX_REQUESTS))) {
         ok = 0;
@@ -350,6 +839,18 @@ static int wp_drbg_get_ctx_params(wp_DrbgCtx* ctx, OSSL_PARAM params[])
             ok = 0;
         }
     }
+    if (ok) {
+        p = OSSL_PARAM_locate(params, WP_DRBG_PARAM_BUFFER_SIZE);
+        if ((p != NULL) && (!OSSL_PARAM_set_size_t(p, ctx->bufSize))) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        p = OSSL_PARAM_locate(params, WP_DRBG_PARAM_USE_ADIN);
+        if ((p != NULL) && (!OSSL_PARAM_set_int(p, ctx->useAdIn))) {
+            ok = 0;
+        }
+    }
 
     return ok;
 }
@@ -368,6 +869,8 @@ static const OSSL_PARAM* wp_drbg_settable_ctx_params(wp_DrbgCtx* ctx,
      * Supported settable parameters for DRBG context.
      */
     static const OSSL_PARAM wp_supported_settable_ctx_params[] = {
+        OSSL_PARAM_size_t(WP_DRBG_PARAM_BUFFER_SIZE, NULL),
+        OSSL_PARAM_int(WP_DRBG_PARAM_USE_ADIN, NULL),
         OSSL_PARAM_END
     };
     (void)ctx;
@@ -375,18 +878,69 @@ static const OSSL_PARAM* wp_drbg_settable_ctx_params(wp_DrbgCtx* ctx,
     return wp_supported_settable_ctx_params;
 }
 
+/**
+ * Set the size of the output buffer.
+ *
+ * Unused output in the previous buffer is zeroized and discarded.
+ *
+ * @param [in, out] ctx   DRBG context object.
+ * @param [in]      size  Size of buffer in bytes. 0 to not buffer.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_drbg_set_buf_size(wp_DrbgCtx* ctx, size_t size)
+{
+    int ok = 1;
+
+    if (size > WP_DRBG_MAX_BUF_SIZE) {
+        ok = 0;
+    }
+    if (ok && (size != ctx->bufSize)) {
+        OPENSSL_secure_clear_free(ctx->buf, ctx->bufSize);
+        ctx->buf = NULL;
+        ctx->bufSize = 0;
+        ctx->bufLen = 0;
+        if (size > 0) {
+            ctx->buf = OPENSSL_secure_malloc(size);
+            if (ctx->buf == NULL) {
+                ok = 0;
+            }
+            else {
+                ctx->bufSize = size;
+            }
+        }
+    }
+
+    return ok;
+}
+
 /**
  * Sets the parameters into the DRBG context object.
  *
- * @param [in] ctx     DRBG context object. Unused.
- * @param [in] params  Array of parameters and values. Unused.
+ * @param [in, out] ctx     DRBG context object.
+ * @param [in]      params  Array of parameters and values.
  * @return  1 on success.
+ * @return  0 on failure.
  */
 static int wp_drbg_set_ctx_params(wp_DrbgCtx* ctx, const OSSL_PARAM params[])
 {
-    (void)ctx;
-    (void)params;
-    return 1;
+    int ok = 1;
+    size_t size = ctx->bufSize;
+
+    if (params != NULL) {
+        if (!wp_params_get_size_t(params, WP_DRBG_PARAM_BUFFER_SIZE, &size)) {
+            ok = 0;
+        }
+        if (ok && (!wp_drbg_set_buf_size(ctx, size))) {
+            ok = 0;
+        }
+        if (ok && (!wp_params_get_int(params, WP_DRBG_PARAM_USE_ADIN,
+                &ctx->useAdIn))) {
+            ok = 0;
+        }
+    }
+
+    return ok;
 }
 
 /**
@@ -412,6 +966,8 @@ static int wp_drbg_verify_zeroization(wp_DrbgCtx* ctx)
  * @param [in]      predResist  Prediction resistance required.
  * @param [in]      adIn        Additional input to seed with.
  * @param [in]      adInLen     Additional input to seed with.
+ * @return  Length of seed in bytes on success.
+ * @return  0 on failure.
  */
 static size_t wp_drbg_get_seed(wp_DrbgCtx* ctx, unsigned char** pSeed,
     int entropy, size_t minLen, size_t maxLen, int prediction_resistance,
@@ -429,17 +985,17 @@ static size_t wp_drbg_get_seed(wp_DrbgCtx* ctx, unsigned char** pSeed,
     if (buffer == NULL) {
         ok = 0;
     }
-#if 0
-    if (ok && (adInLen > 0)) {
-        rc = wc_RNG_DRBG_Reseed(ctx->rng, adIn, adInLen);
+    /* Child DRBGs seeded after fork must not get the parent's seed. */
+    if (ok && (!wp_drbg_check_fork(ctx))) {
+        ok = 0;
+    }
+    if (ok && ctx->useAdIn && (adInLen > 0)) {
+        rc = wc_RNG_DRBG_Reseed(ctx->rng, adIn, (word32)adInLen);
         if (rc != 0) {
             ok = 0;
         }
+        wp_drbg_discard_buf(ctx);
     }
-#else
-    (void)adIn;
-    (void)adInLen;
-#endif
     if (ok) {
         rc = wc_RNG_GenerateBlock(ctx->rng, buffer, (word32)minLen);
         if (rc != 0) {
@@ -453,7 +1009,7 @@ static size_t wp_drbg_get_seed(wp_DrbgCtx* ctx, unsigned char** pSeed,
         OPENSSL_secure_free(buffer);
     }
 
-    return ok;
+    return ok ? minLen : 0;
 }
 
 /**
@@ -43,22 +43,21 @@
 /** Maximum size of the group name string. */
 #define WP_MAX_EC_GROUP_NAME_SZ    20
 
+/** Upper bound on the length of a PKCS#8 encoding of a private key: the
+ * scalar, the uncompressed public point, the curve OID and ASN.1 headers. */
+#define WP_ECC_PKI_MAX_LEN(size)   (3 * (size) + 96)
+
 
 /**
  * ECC key.
  */
 struct wp_Ecc {
-    /** wolfSSL ECC key object.  */
-    ecc_key key;
-    /** wolfSSL random number generator for key generation and signing. */
-    WC_RNG rng;
+    /** wolfSSL ECC key object. Follows this object unless compact. For a
+     * compact key, the expanded form and NULL when not expanded. */
+    ecc_key* key;
 
-#ifndef WP_SINGLE_THREADED
-    /** Mutex for reference count updating. */
-    wolfSSL_Mutex mutex;
-#endif
     /** Count of references to this object. */
-    int refCnt;
+    wp_RefCnt refCnt;
 
     /** Provider context - useful when duplicating. */
     WOLFPROV_CTX* provCtx;
@@ -75,6 +74,57 @@ struct wp_Ecc {
     unsigned int hasPub:1;
     /** Private key available. */
     unsigned int hasPriv:1;
+    /** Public key known to be a point on the curve other than infinity. */
+    unsigned int pubValid:1;
+    /** Key stored compactly: private scalar and public point follow this
+     * object as fixed size big-endian bytes. */
+    unsigned int compact:1;
+
+    /** SubjectPublicKeyInfo encoding of public key. NULL until encoded. */
+    wp_Der* spki;
+    /** Public point and private scalar serialized for export. NULL until
+     * exported. */
+    wp_Der* expData;
+
+    /** Number of users of expanded form. Not evicted while not zero. */
+    int inUse;
+    /** Previous compact key in expanded list - more recently used. */
+    struct wp_Ecc* prev;
+    /** Next compact key in expanded list - less recently used. */
+    struct wp_Ecc* next;
+};
+
+/**
+ * ECC key with its wolfSSL ECC key object in one allocation.
+ */
+typedef struct wp_EccFull {
+    /** ECC key. */
+    wp_Ecc ecc;
+    /** wolfSSL ECC key object referenced by ECC key. */
+    ecc_key key;
+} wp_EccFull;
+
+/**
+ * Cache of expanded forms of compact ECC keys.
+ *
+ * A stored private key only needs its scalar and public point - a few dozen
+ * bytes - while a wolfSSL ECC key object holds big numbers sized for the
+ * largest curve. Compact keys are expanded on use and the most recently used
+ * expanded forms are kept.
+ */
+struct wp_EccCache {
+    /** Most recently used compact key with an expanded form. */
+    wp_Ecc* head;
+    /** Least recently used compact key with an expanded form. */
+    wp_Ecc* tail;
+    /** Number of expanded forms. */
+    int cnt;
+    /** Number of expanded forms to keep when not in use. */
+    int size;
+#ifndef WP_SINGLE_THREADED
+    /** Mutex protecting list and expanded forms. */
+    pthread_mutex_t mutex;
+#endif
 };
 
 /**
@@ -212,46 +262,70 @@ static int wp_ecc_set_bits(wp_Ecc* ecc)
  */
 int wp_ecc_up_ref(wp_Ecc* ecc)
 {
-#ifndef WP_SINGLE_THREADED
-    int ok = 1;
-    int rc;
-
-    rc = wc_LockMutex(&ecc->mutex);
-    if (rc < 0) {
-        ok = 0;
-    }
-    if (ok) {
-        ecc->refCnt++;
-        wc_UnLockMutex(&ecc->mutex);
-    }
-
-    return ok;
-#else
-    ecc->refCnt++;
-    return 1;
-#endif
+    return wp_refcnt_up(&ecc->refCnt);
 }
 
 /**
  * Get the wolfSSL ECC object from the ECC key object.
  *
+ * The expanded form of a compact key is only available between calls to
+ * wp_ecc_acquire_key() and wp_ecc_release_key().
+ *
  * @param [in] ecc  ECC key object.
  * @return  Pointer to wolfSSL ECC key object.
  */
 ecc_key* wp_ecc_get_key(wp_Ecc* ecc)
 {
-    return &ecc->key;
+    return ecc->key;
 }
 
 /**
- * Get the wolfSSL RNG object from the ECC key object.
+ * Get the wolfSSL RNG object to use with the ECC key object.
+ *
+ * Keys don't own an RNG - the calling thread's provider RNG is borrowed for
+ * key generation, signing and blinding. Verify and derive-only peer keys
+ * never instantiate an RNG.
  *
  * @param [in] ecc  ECC key object.
  * @return  Pointer to wolfSSL RNG object.
+ * @return  NULL on failure.
  */
 WC_RNG* wp_ecc_get_rng(wp_Ecc* ecc)
 {
-    return &ecc->rng;
+    return wp_provctx_get_rng(ecc->provCtx);
+}
+
+/**
+ * Copy the private key of a wolfSSL ECC key into a new wolfSSL ECC key.
+ *
+ * Keys are shared between threads. An operation that sets an RNG or flags
+ * into the wolfSSL ECC key does so on its own copy.
+ *
+ * @param [in]  src    wolfSSL ECC key with private key.
+ * @param [out] dst    wolfSSL ECC key to initialize with private key.
+ * @param [in]  devId  Device identifier.
+ * @return  0 on success.
+ * @return  Other value on failure.
+ */
+int wp_ecc_copy_priv(ecc_key* src, ecc_key* dst, int devId)
+{
+    int rc;
+
+    rc = wc_ecc_init_ex(dst, NULL, devId);
+    if (rc == 0) {
+        rc = wc_ecc_set_curve(dst, 0, src->dp->id);
+        if (rc == 0) {
+            rc = mp_copy(&src->k, &dst->k);
+        }
+        if (rc == 0) {
+            dst->type = ECC_PRIVATEKEY_ONLY;
+        }
+        else {
+            wc_ecc_free(dst);
+        }
+    }
+
+    return rc;
 }
 
 /**
@@ -265,6 +339,286 @@ int wp_ecc_get_size(wp_Ecc* ecc)
     return (ecc->bits + 7) / 8;
 }
 
+/**
+ * Get the size of the data following a compact ECC key object.
+ *
+ * @param [in] ecc  ECC key object.
+ * @return  Size of private scalar and, when available, public point in bytes.
+ */
+static size_t wp_ecc_compact_size(const wp_Ecc* ecc)
+{
+    size_t size = (ecc->bits + 7) / 8;
+    size_t len = size;
+
+    if (ecc->hasPub) {
+        /* Uncompressed point: format byte | x-ordinate | y-ordinate */
+        len += 1 + 2 * size;
+    }
+
+    return len;
+}
+
+/**
+ * Remove a compact key from the list of expanded keys.
+ *
+ * Call with mutex locked.
+ *
+ * @param [in, out] cache  ECC expanded key cache.
+ * @param [in, out] ecc    ECC key object.
+ */
+static void wp_ecc_cache_unlink(wp_EccCache* cache, wp_Ecc* ecc)
+{
+    if (ecc->prev != NULL) {
+        ecc->prev->next = ecc->next;
+    }
+    else {
+        cache->head = ecc->next;
+    }
+    if (ecc->next != NULL) {
+        ecc->next->prev = ecc->prev;
+    }
+    else {
+        cache->tail = ecc->prev;
+    }
+    ecc->prev = NULL;
+    ecc->next = NULL;
+}
+
+/**
+ * Put a compact key at the front of the list of expanded keys.
+ *
+ * Call with mutex locked.
+ *
+ * @param [in, out] cache  ECC expanded key cache.
+ * @param [in, out] ecc    ECC key object.
+ */
+static void wp_ecc_cache_push(wp_EccCache* cache, wp_Ecc* ecc)
+{
+    ecc->prev = NULL;
+    ecc->next = cache->head;
+    if (cache->head != NULL) {
+        cache->head->prev = ecc;
+    }
+    else {
+        cache->tail = ecc;
+    }
+    cache->head = ecc;
+}
+
+/**
+ * Dispose of the expanded form of a compact key.
+ *
+ * Call with mutex locked.
+ *
+ * @param [in, out] cache  ECC expanded key cache.
+ * @param [in, out] ecc    ECC key object.
+ */
+static void wp_ecc_cache_drop(wp_EccCache* cache, wp_Ecc* ecc)
+{
+    wp_ecc_cache_unlink(cache, ecc);
+    wc_ecc_free(ecc->key);
+    OPENSSL_clear_free(ecc->key, sizeof(*ecc->key));
+    ecc->key = NULL;
+    cache->cnt--;
+}
+
+/**
+ * Expand a compact key into a wolfSSL ECC key object.
+ *
+ * Call with mutex locked.
+ *
+ * @param [in, out] cache  ECC expanded key cache.
+ * @param [in, out] ecc    ECC key object.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_ecc_expand(wp_EccCache* cache, wp_Ecc* ecc)
+{
+    int ok = 1;
+    int rc;
+    ecc_key* key;
+    word32 size = (ecc->bits + 7) / 8;
+    const unsigned char* data = (const unsigned char*)(ecc + 1);
+
+    key = (ecc_key*)OPENSSL_malloc(sizeof(*key));
+    if (key == NULL) {
+        ok = 0;
+    }
+    if (ok) {
+        rc = wc_ecc_init_ex(key, NULL, ecc->provCtx->devId);
+        if (rc != 0) {
+            OPENSSL_free(key);
+            ok = 0;
+        }
+    }
+    if (ok) {
+        /* Public point, when present, follows the private scalar. */
+        rc = wc_ecc_import_private_key_ex(data, size,
+            ecc->hasPub ? data + size : NULL, ecc->hasPub ? 1 + 2 * size : 0,
+            key, ecc->curveId);
+        if (rc != 0) {
+            wc_ecc_free(key);
+            OPENSSL_clear_free(key, sizeof(*key));
+            ok = 0;
+        }
+    }
+    if (ok) {
+        ecc->key = key;
+        wp_ecc_cache_push(cache, ecc);
+        cache->cnt++;
+    }
+
+    return ok;
+}
+
+/**
+ * Dispose of least recently used expanded forms until within cache size.
+ *
+ * Expanded forms in use are skipped.
+ * Call with mutex locked.
+ *
+ * @param [in, out] cache  ECC expanded key cache.
+ */
+static void wp_ecc_cache_evict(wp_EccCache* cache)
+{
+    wp_Ecc* ecc = cache->tail;
+
+    while ((cache->cnt > cache->size) && (ecc != NULL)) {
+        wp_Ecc* prev = ecc->prev;
+
+        if (ecc->inUse == 0) {
+            wp_ecc_cache_drop(cache, ecc);
+        }
+        ecc = prev;
+    }
+}
+
+/**
+ * Get the wolfSSL ECC object to operate with, expanding a compact key.
+ *
+ * The expanded form is not evicted until wp_ecc_release_key() is called.
+ * Keys that are not compact are returned as is.
+ *
+ * @param [in, out] ecc  ECC key object.
+ * @return  Pointer to wolfSSL ECC key object on success.
+ * @return  NULL when expanding fails.
+ */
+ecc_key* wp_ecc_acquire_key(wp_Ecc* ecc)
+{
+    ecc_key* key = NULL;
+
+    if (!ecc->compact) {
+        key = ecc->key;
+    }
+    else {
+        wp_EccCache* cache = ecc->provCtx->eccCache;
+
+    #ifndef WP_SINGLE_THREADED
+        pthread_mutex_lock(&cache->mutex);
+    #endif
+        if (ecc->key == NULL) {
+            (void)wp_ecc_expand(cache, ecc);
+        }
+        else if (cache->head != ecc) {
+            /* Now most recently used. */
+            wp_ecc_cache_unlink(cache, ecc);
+            wp_ecc_cache_push(cache, ecc);
+        }
+        if (ecc->key != NULL) {
+            ecc->inUse++;
+            key = ecc->key;
+        }
+    #ifndef WP_SINGLE_THREADED
+        pthread_mutex_unlock(&cache->mutex);
+    #endif
+    }
+
+    return key;
+}
+
+/**
+ * Finish using the wolfSSL ECC object got with wp_ecc_acquire_key().
+ *
+ * @param [in, out] ecc  ECC key object.
+ */
+void wp_ecc_release_key(wp_Ecc* ecc)
+{
+    if (ecc->compact) {
+        wp_EccCache* cache = ecc->provCtx->eccCache;
+
+    #ifndef WP_SINGLE_THREADED
+        pthread_mutex_lock(&cache->mutex);
+    #endif
+        ecc->inUse--;
+        wp_ecc_cache_evict(cache);
+    #ifndef WP_SINGLE_THREADED
+        pthread_mutex_unlock(&cache->mutex);
+    #endif
+    }
+}
+
+/**
+ * Create the cache of expanded forms of compact ECC keys.
+ *
+ * Cache is only created when size is not zero. Private keys decoded with the
+ * provider context are then stored compactly.
+ *
+ * @param [in, out] provCtx  Provider context.
+ * @param [in]      size     Number of expanded keys to keep.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+int wp_ecc_cache_init(WOLFPROV_CTX* provCtx, int size)
+{
+    int ok = 1;
+    wp_EccCache* cache = NULL;
+
+    if (size > 0) {
+        cache = (wp_EccCache*)OPENSSL_zalloc(sizeof(*cache));
+        if (cache == NULL) {
+            ok = 0;
+        }
+    }
+#ifndef WP_SINGLE_THREADED
+    if (ok && (cache != NULL) &&
+            (pthread_mutex_init(&cache->mutex, NULL) != 0)) {
+        ok = 0;
+    }
+#endif
+    if (ok && (cache != NULL)) {
+        cache->size = size;
+        provCtx->eccCache = cache;
+    }
+    else {
+        OPENSSL_free(cache);
+    }
+
+    return ok;
+}
+
+/**
+ * Dispose of the cache of expanded forms of compact ECC keys.
+ *
+ * Expanded forms still cached are disposed of - keys must no longer be in use.
+ *
+ * @param [in, out] provCtx  Provider context.
+ */
+void wp_ecc_cache_free(WOLFPROV_CTX* provCtx)
+{
+    wp_EccCache* cache = provCtx->eccCache;
+
+    if (cache != NULL) {
+        while (cache->head != NULL) {
+            wp_ecc_cache_drop(cache, cache->head);
+        }
+    #ifndef WP_SINGLE_THREADED
+        pthread_mutex_destroy(&cache->mutex);
+    #endif
+        OPENSSL_free(cache);
+        provCtx->eccCache = NULL;
+    }
+}
+
 /**
  * Create a new ECC key object.
  *
@@ -277,43 +631,25 @@ static wp_Ecc* wp_ecc_new(WOLFPROV_CTX *provCtx)
     wp_Ecc* ecc = NULL;
 
     if (wolfssl_prov_is_running()) {
-        ecc = (wp_Ecc*)OPENSSL_zalloc(sizeof(*ecc));
+        ecc = (wp_Ecc*)OPENSSL_zalloc(sizeof(wp_EccFull));
     }
     if (ecc != NULL) {
         int ok = 1;
         int rc;
 
-        rc = wc_ecc_init_ex(&ecc->key, NULL, INVALID_DEVID);
+        ecc->key = &((wp_EccFull*)ecc)->key;
+        rc = wc_ecc_init_ex(ecc->key, NULL, provCtx->devId);
         if (rc != 0) {
             ok = 0;
         }
 
-        if (ok) {
-            /* RNG's tied to lifecycle of key in wolfSSL. */
-            rc = wc_InitRng(&ecc->rng);
-            if (rc != 0) {
-                wc_ecc_free(&ecc->key);
-                ok = 0;
-            }
-        }
-
-    #ifndef SINGLE_THREADED
-        if (ok) {
-            rc = wc_InitMutex(&ecc->mutex);
-            if (rc != 0) {
-                wc_FreeRng(&ecc->rng);
-                wc_ecc_free(&ecc->key);
-                ok = 0;
-            }
+        if (ok && (!wp_refcnt_init(&ecc->refCnt))) {
+            wc_ecc_free(ecc->key);
+            ok = 0;
         }
-    #endif
 
         if (ok) {
-        #ifdef ECC_TIMING_RESISTANT
-            (void)wc_ecc_set_rng(&ecc->key, &ecc->rng);
-        #endif
             ecc->provCtx = provCtx;
-            ecc->refCnt = 1;
             ecc->includePublic = 1;
         }
 
@@ -334,26 +670,31 @@ static wp_Ecc* wp_ecc_new(WOLFPROV_CTX *provCtx)
 void wp_ecc_free(wp_Ecc* ecc)
 {
     if (ecc != NULL) {
-        int cnt;
-    #ifndef WP_SINGLE_THREADED
-        int rc;
-
-        rc = wc_LockMutex(&ecc->mutex);
-        cnt = --ecc->refCnt;
-        if (rc == 0) {
-            wc_UnLockMutex(&ecc->mutex);
-        }
-    #else
-        cnt = --ecc->refCnt;
-    #endif
+        int cnt = wp_refcnt_down(&ecc->refCnt);
 
         if (cnt == 0) {
-    #ifndef WP_SINGLE_THREADED
-            wc_FreeMutex(&ecc->mutex);
-    #endif
-            wc_FreeRng(&ecc->rng);
-            wc_ecc_free(&ecc->key);
-            OPENSSL_free(ecc);
+            wp_refcnt_free(&ecc->refCnt);
+            wp_der_free(&ecc->spki);
+            wp_der_free(&ecc->expData);
+            if (ecc->compact) {
+                wp_EccCache* cache = ecc->provCtx->eccCache;
+
+            #ifndef WP_SINGLE_THREADED
+                pthread_mutex_lock(&cache->mutex);
+            #endif
+                if (ecc->key != NULL) {
+                    wp_ecc_cache_drop(cache, ecc);
+                }
+            #ifndef WP_SINGLE_THREADED
+                pthread_mutex_unlock(&cache->mutex);
+            #endif
+                OPENSSL_clear_free(ecc,
+                    sizeof(*ecc) + wp_ecc_compact_size(ecc));
+            }
+            else {
+                wc_ecc_free(ecc->key);
+                OPENSSL_free(ecc);
+            }
         }
     }
 }
@@ -374,10 +715,15 @@ static wp_Ecc* wp_ecc_dup(const wp_Ecc *src, int selection)
     if (dst != NULL) {
         int ok = 1;
         int rc;
+        /* Compact key is expanded to copy from. */
+        ecc_key* srcKey = wp_ecc_acquire_key((wp_Ecc*)src);
 
+        if (srcKey == NULL) {
+            ok = 0;
+        }
         /* Copy curve if requested. */
-        if ((selection & OSSL_KEYMGMT_SELECT_DOMAIN_PARAMETERS) != 0) {
-            rc = wc_ecc_set_curve(&dst->key, (src->bits + 7) / 8, src->curveId);
+        if (ok && ((selection & OSSL_KEYMGMT_SELECT_DOMAIN_PARAMETERS) != 0)) {
+            rc = wc_ecc_set_curve(dst->key, (src->bits + 7) / 8, src->curveId);
             if (rc != 0) {
                 ok = 0;
             }
@@ -390,16 +736,19 @@ static wp_Ecc* wp_ecc_dup(const wp_Ecc *src, int selection)
         if (ok && src->hasPub &&
             ((selection & OSSL_KEYMGMT_SELECT_PUBLIC_KEY) != 0)) {
             dst->hasPub = 1;
-            rc = wc_ecc_copy_point(&src->key.pubkey, &dst->key.pubkey);
+            rc = wc_ecc_copy_point(&srcKey->pubkey, &dst->key->pubkey);
             if (rc != 0) {
                 ok = 0;
             }
+            if (ok) {
+                dst->pubValid = src->pubValid;
+            }
         }
         /* Copy private key if available and requested. */
         if (ok && src->hasPriv &&
             ((selection & OSSL_KEYMGMT_SELECT_PRIVATE_KEY) != 0)) {
             dst->hasPriv = 1;
-            rc = mp_copy(&src->key.k, &dst->key.k);
+            rc = mp_copy(&srcKey->k, &dst->key->k);
             if (rc != 0) {
                 ok = 0;
             }
@@ -409,6 +758,9 @@ static wp_Ecc* wp_ecc_dup(const wp_Ecc *src, int selection)
             dst->cofactor      = src->cofactor;
             dst->includePublic = src->includePublic;
         }
+        if (srcKey != NULL) {
+            wp_ecc_release_key((wp_Ecc*)src);
+        }
 
         if (!ok) {
             wp_ecc_free(dst);
@@ -460,9 +812,35 @@ static const OSSL_PARAM* wp_ecc_settable_params(WOLFPROV_CTX* provCtx)
     return wp_ecc_supported_settable_params;
 }
 
+/**
+ * Check the public point is not infinity and is on the curve.
+ *
+ * @param [in] ecc  ECC key object.
+ * @return  1 when point is valid.
+ * @return  0 otherwise.
+ */
+static int wp_ecc_check_pub_point(const wp_Ecc* ecc)
+{
+    int ok = 1;
+
+    if (wc_ecc_point_is_at_infinity(&ecc->key->pubkey)) {
+        ok = 0;
+    }
+    if (ok && (!wc_ecc_point_is_on_curve(&ecc->key->pubkey,
+            ecc->curveId))) {
+        ok = 0;
+    }
+
+    return ok;
+}
+
 /**
  * Set the encoded public key parameter into ECC key object.
  *
+ * Peer keys of ECDHE arrive this way. The point is checked once here, while
+ * the decoded (and, when compressed, decompressed) point is at hand, and the
+ * result remembered so that validating the peer doesn't check it again.
+ *
  * @param [in, out] ecc     ECC key object.
  * @param [in]      params  Array of parameters and values.
  * @param [in]      key     String to look for.
@@ -479,13 +857,26 @@ static int wp_ecc_set_params_enc_pub_key(wp_Ecc *ecc, const OSSL_PARAM params[],
     if (!wp_params_get_octet_string_ptr(params, key, &data, &len)) {
         ok = 0;
     }
+    /* Key data of a compact key is not changed. */
+    if (ok && (data != NULL) && ecc->compact) {
+        ok = 0;
+    }
     if (ok && (data != NULL)) {
-        int rc = wc_ecc_import_x963_ex(data, len, &ecc->key, ecc->curveId);
+        int rc = wc_ecc_import_x963_ex(data, len, ecc->key, ecc->curveId);
         if (rc != 0) {
             ok = 0;
         }
+    #ifndef WOLFSSL_VALIDATE_ECC_IMPORT
+        /* Import doesn't check point - an invalid point is never usable. */
+        if (ok && (!wp_ecc_check_pub_point(ecc))) {
+            ok = 0;
+        }
+    #endif
         if (ok) {
             ecc->hasPub = 1;
+            ecc->pubValid = 1;
+            wp_der_free(&ecc->spki);
+            wp_der_free(&ecc->expData);
         }
     }
 
@@ -551,6 +942,7 @@ static const OSSL_PARAM *wp_ecc_gettable_params(WOLFPROV_CTX* provCtx)
         OSSL_PARAM_octet_string(OSSL_PKEY_PARAM_ENCODED_PUBLIC_KEY, NULL, 0),
         OSSL_PARAM_octet_string(OSSL_PKEY_PARAM_PUB_KEY, NULL, 0),
         OSSL_PARAM_octet_string(OSSL_PKEY_PARAM_PRIV_KEY, NULL, 0),
+        OSSL_PARAM_size_t(WP_PKEY_PARAM_KEY_BYTES, NULL),
         OSSL_PARAM_END
     };
     (void)provCtx;
@@ -610,7 +1002,7 @@ static int wp_ecc_get_params_enc_pub_key(wp_Ecc* ecc, OSSL_PARAM params[],
             outLen = 1 + 2 * ((ecc->bits + 7) / 8);
         }
         else {
-            rc = wc_ecc_export_x963_ex(&ecc->key, p->data, &outLen, 0);
+            rc = wc_ecc_export_x963_ex(ecc->key, p->data, &outLen, 0);
             if (rc != 0) {
                ok = 0;
             }
@@ -633,11 +1025,25 @@ static int wp_ecc_get_params(wp_Ecc* ecc, OSSL_PARAM params[])
 {
     int ok = 1;
     OSSL_PARAM* p;
-
-    /* Maximum secret size. */
-    p = OSSL_PARAM_locate(params, OSSL_PKEY_PARAM_MAX_SIZE);
-    if ((p != NULL) && !OSSL_PARAM_set_int(p, wc_ecc_sig_size(&ecc->key))) {
-        ok = 0;
+    ecc_key* key = NULL;
+
+    /* Compact key only expanded when key data is requested. */
+    if ((OSSL_PARAM_locate(params, OSSL_PKEY_PARAM_ENCODED_PUBLIC_KEY) !=
+            NULL) ||
+        (OSSL_PARAM_locate(params, OSSL_PKEY_PARAM_PUB_KEY) != NULL) ||
+        (OSSL_PARAM_locate(params, OSSL_PKEY_PARAM_PRIV_KEY) != NULL)) {
+        key = wp_ecc_acquire_key(ecc);
+        if (key == NULL) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        /* Maximum secret size. */
+        p = OSSL_PARAM_locate(params, OSSL_PKEY_PARAM_MAX_SIZE);
+        if ((p != NULL) && !OSSL_PARAM_set_int(p,
+                wc_ecc_sig_size_calc((ecc->bits + 7) / 8))) {
+            ok = 0;
+        }
     }
     if (ok) {
         /* Curve bit size. */
@@ -678,20 +1084,20 @@ static int wp_ecc_get_params(wp_Ecc* ecc, OSSL_PARAM params[])
         }
     }
     /* Encoded public key. */
-    if (ok && (!wp_ecc_get_params_enc_pub_key(ecc, params,
+    if (ok && (key != NULL) && (!wp_ecc_get_params_enc_pub_key(ecc, params,
             OSSL_PKEY_PARAM_ENCODED_PUBLIC_KEY))) {
         ok = 0;
     }
     /* Public key. */
-    if (ok && (!wp_ecc_get_params_enc_pub_key(ecc, params,
+    if (ok && (key != NULL) && (!wp_ecc_get_params_enc_pub_key(ecc, params,
             OSSL_PKEY_PARAM_PUB_KEY))) {
         ok = 0;
     }
-    if (ok && (!wp_params_set_mp(params, OSSL_PKEY_PARAM_PRIV_KEY,
-            &ecc->key.k))) {
+    /* Private key. */
+    if (ok && (key != NULL) && (!wp_params_set_mp(params,
+            OSSL_PKEY_PARAM_PRIV_KEY, &key->k))) {
         ok = 0;
     }
-    /* Private key. */
     if (ok) {
         /* Compressed or uncompressed point format. */
         p = OSSL_PARAM_locate(params,
@@ -700,6 +1106,18 @@ static int wp_ecc_get_params(wp_Ecc* ecc, OSSL_PARAM params[])
             ok = 0;
         }
     }
+    if (ok) {
+        /* Memory kept by key object. */
+        p = OSSL_PARAM_locate(params, WP_PKEY_PARAM_KEY_BYTES);
+        if ((p != NULL) && (!OSSL_PARAM_set_size_t(p, ecc->compact ?
+                sizeof(*ecc) + wp_ecc_compact_size(ecc) :
+                sizeof(wp_EccFull)))) {
+            ok = 0;
+        }
+    }
+    if (key != NULL) {
+        wp_ecc_release_key(ecc);
+    }
 
     return ok;
 }
@@ -746,23 +1164,38 @@ static int wp_ecc_has(const wp_Ecc* ecc, int selection)
 static int wp_ecc_match(const wp_Ecc* ecc1, const wp_Ecc* ecc2, int selection)
 {
     int ok = 1;
+    ecc_key* key1 = NULL;
+    ecc_key* key2 = NULL;
 
     if (!wolfssl_prov_is_running()) {
         ok = 0;
     }
     if (ok && ((selection & OSSL_KEYMGMT_SELECT_DOMAIN_PARAMETERS) != 0) &&
-        (ecc1->key.dp->id != ecc2->key.dp->id)) {
+        (ecc1->curveId != ecc2->curveId)) {
         ok = 0;
     }
+    if (ok && ((selection & OSSL_KEYMGMT_SELECT_KEYPAIR) != 0)) {
+        /* Compact keys are expanded to compare key data. */
+        key1 = wp_ecc_acquire_key((wp_Ecc*)ecc1);
+        key2 = wp_ecc_acquire_key((wp_Ecc*)ecc2);
+        if ((key1 == NULL) || (key2 == NULL)) {
+            ok = 0;
+        }
+    }
     if (ok && ((selection & OSSL_KEYMGMT_SELECT_PRIVATE_KEY) != 0) &&
-        (mp_cmp((mp_int*)&ecc1->key.k, (mp_int*)&ecc2->key.k) != MP_EQ)) {
+        (mp_cmp(&key1->k, &key2->k) != MP_EQ)) {
         ok = 0;
     }
     if (ok && ((selection & OSSL_KEYMGMT_SELECT_PUBLIC_KEY) != 0) &&
-        (wc_ecc_cmp_point((ecc_point*)&ecc1->key.pubkey,
-                          (ecc_point*)&ecc2->key.pubkey) != MP_EQ)) {
+        (wc_ecc_cmp_point(&key1->pubkey, &key2->pubkey) != MP_EQ)) {
         ok = 0;
     }
+    if (key1 != NULL) {
+        wp_ecc_release_key((wp_Ecc*)ecc1);
+    }
+    if (key2 != NULL) {
+        wp_ecc_release_key((wp_Ecc*)ecc2);
+    }
 
     return ok;
 }
@@ -780,12 +1213,9 @@ static int wp_ecc_validate_public_key_quick(const wp_Ecc* ecc)
 {
     int ok = 1;
 
-    if (wc_ecc_point_is_at_infinity((ecc_point*)&ecc->key.pubkey)) {
-        ok = 0;
-    }
-    if (ok && (!wc_ecc_point_is_on_curve((ecc_point*)&ecc->key.pubkey,
-            ecc->curveId))) {
-        ok = 0;
+    /* Point checked when imported or generated. */
+    if (!ecc->pubValid) {
+        ok = wp_ecc_check_pub_point(ecc);
     }
 
     return ok;
@@ -806,25 +1236,34 @@ static int wp_ecc_validate(const wp_Ecc* ecc, int selection, int checktype)
 {
     int ok = 1;
     int pubDone = 0;
+    /* Compact key is expanded to check. */
+    ecc_key* key = wp_ecc_acquire_key((wp_Ecc*)ecc);
 
+    if (key == NULL) {
+        ok = 0;
+    }
     /* Only named curves supported. */
     if (((selection & OSSL_KEYMGMT_SELECT_DOMAIN_PARAMETERS) != 0) &&
         (ecc->curveId == 0)) {
         ok = 0;
     }
-    if (((selection & OSSL_KEYMGMT_SELECT_PUBLIC_KEY) != 0) &&
+    if (ok && ((selection & OSSL_KEYMGMT_SELECT_PUBLIC_KEY) != 0) &&
         (checktype == OSSL_KEYMGMT_VALIDATE_QUICK_CHECK)) {
         pubDone = 1;
         if (!wp_ecc_validate_public_key_quick(ecc)) {
             ok = 0;
         }
     }
-    if (((selection & OSSL_KEYMGMT_SELECT_PRIVATE_KEY) != 0) || !pubDone) {
-        int rc = wc_ecc_check_key((ecc_key*)&ecc->key);
+    if (ok && (((selection & OSSL_KEYMGMT_SELECT_PRIVATE_KEY) != 0) ||
+            !pubDone)) {
+        int rc = wc_ecc_check_key(key);
         if (rc != 0) {
             ok = 0;
         }
     }
+    if (key != NULL) {
+        wp_ecc_release_key((wp_Ecc*)ecc);
+    }
 
     return ok;
 }
@@ -884,11 +1323,11 @@ static int wp_ecc_import_keypair(wp_Ecc* ecc, const OSSL_PARAM params[],
         ok = 0;
     }
     if (ok && priv && (!wp_params_get_mp(params, OSSL_PKEY_PARAM_PRIV_KEY,
-            &ecc->key.k))) {
+            &ecc->key->k))) {
         ok = 0;
     }
-    if (ok && (!mp_iszero(&ecc->key.k))) {
-        ecc->key.type = ECC_PRIVATEKEY;
+    if (ok && (!mp_iszero(&ecc->key->k))) {
+        ecc->key->type = ECC_PRIVATEKEY;
         ecc->hasPriv = 1;
     }
 
@@ -950,6 +1389,11 @@ static int wp_ecc_import(wp_Ecc* ecc, int selection, const OSSL_PARAM params[])
     if (ok & ((selection & OSSL_KEYMGMT_SELECT_DOMAIN_PARAMETERS) == 0)) {
         ok = 0;
     }
+    if (ok) {
+        /* Key is changing - memoized encodings no longer match. */
+        wp_der_free(&ecc->spki);
+        wp_der_free(&ecc->expData);
+    }
     if (ok && (!wp_ecc_import_group(ecc, params))) {
         ok = 0;
     }
@@ -1146,7 +1590,7 @@ static size_t wp_ecc_export_keypair_alloc_size(wp_Ecc* ecc, int priv)
     /* Public key. */
     size_t len = WP_ECC_PUBLIC_KEY_SIZE(ecc);
     if (priv) {
-        len += mp_unsigned_bin_size(&ecc->key.k);
+        len += mp_unsigned_bin_size(&ecc->key->k);
     }
     return len;
 }
@@ -1173,7 +1617,7 @@ static int wp_ecc_export_keypair(wp_Ecc* ecc, OSSL_PARAM* params, int* pIdx,
     word32 outLen;
 
     outLen = WP_ECC_PUBLIC_KEY_SIZE(ecc);
-    rc = wc_ecc_export_x963_ex(&ecc->key, data + *idx, &outLen, 0);
+    rc = wc_ecc_export_x963_ex(ecc->key, data + *idx, &outLen, 0);
     if (rc != 0) {
         ok = 0;
     }
@@ -1182,7 +1626,7 @@ static int wp_ecc_export_keypair(wp_Ecc* ecc, OSSL_PARAM* params, int* pIdx,
             data + *idx, outLen);
         *idx += outLen;
         if (priv && (!wp_param_set_mp(&params[i++],
-                OSSL_PKEY_PARAM_PRIV_KEY, &ecc->key.k, data, idx))) {
+                OSSL_PKEY_PARAM_PRIV_KEY, &ecc->key->k, data, idx))) {
             ok = 0;
         }
     }
@@ -1200,17 +1644,72 @@ static int wp_ecc_export_keypair(wp_Ecc* ecc, OSSL_PARAM* params, int* pIdx,
  * @return  1 on success.
  * @return  0 on failure.
  */
-static int wp_ecc_export_other(wp_Ecc* ecc, OSSL_PARAM* params, int* pIdx)
+static int wp_ecc_export_other(wp_Ecc* ecc, OSSL_PARAM* params, int* pIdx)
+{
+    int ok = 1;
+    int i = *pIdx;
+
+    wp_param_set_int(&params[i++], OSSL_PKEY_PARAM_USE_COFACTOR_ECDH,
+        &ecc->cofactor);
+    wp_param_set_int(&params[i++], OSSL_PKEY_PARAM_EC_INCLUDE_PUBLIC,
+        &ecc->includePublic);
+
+    *pIdx = i;
+    return ok;
+}
+
+/**
+ * Get the ECC key pair serialized for export.
+ *
+ * Keys are exported on every copy between providers, so the public point and
+ * private scalar are serialized once and memoized on the key object. Public
+ * point is first and the private scalar, when present, fills the remainder.
+ *
+ * @param [in]  ecc    ECC key object.
+ * @param [out] data   DER object holding serialized key pair.
+ * @param [out] owned  1 when caller is to free DER object, otherwise 0.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_ecc_get_export_data(wp_Ecc* ecc, wp_Der** data, int* owned)
 {
     int ok = 1;
-    int i = *pIdx;
-
-    wp_param_set_int(&params[i++], OSSL_PKEY_PARAM_USE_COFACTOR_ECDH,
-        &ecc->cofactor);
-    wp_param_set_int(&params[i++], OSSL_PKEY_PARAM_EC_INCLUDE_PUBLIC,
-        &ecc->includePublic);
+    wp_Der* der;
+    OSSL_PARAM params[2];
+    int paramsSz = 0;
+    size_t len = 0;
+    ecc_key* key;
+
+    *owned = 0;
+    der = wp_der_get(&ecc->expData);
+    if (der == NULL) {
+        /* Compact key is expanded to serialize key data. */
+        key = wp_ecc_acquire_key(ecc);
+        if (key == NULL) {
+            ok = 0;
+        }
+        if (ok) {
+            der = wp_der_new(wp_ecc_export_keypair_alloc_size(ecc, 1));
+            if (der == NULL) {
+                ok = 0;
+            }
+            if (ok && (!wp_ecc_export_keypair(ecc, params, &paramsSz,
+                    WP_DER_DATA(der), &len, 1))) {
+                ok = 0;
+            }
+            wp_ecc_release_key(ecc);
+        }
+        if (ok) {
+            *owned = !wp_der_set(&ecc->expData, &der);
+        }
+        else if (der != NULL) {
+            OPENSSL_clear_free(der, sizeof(*der) + der->len);
+        }
+    }
+    if (ok) {
+        *data = der;
+    }
 
-    *pIdx = i;
     return ok;
 }
 
@@ -1218,6 +1717,7 @@ static int wp_ecc_export_other(wp_Ecc* ecc, OSSL_PARAM* params, int* pIdx)
  * Export the ECC key.
  *
  * Key data placed in parameters and then passed to callback.
+ * Parameters refer to the memoized serialized key pair - nothing allocated.
  *
  * @param [in] ecc        ECC key object.
  * @param [in] selection  Parts of key to export.
@@ -1232,8 +1732,8 @@ static int wp_ecc_export(wp_Ecc *ecc, int selection, OSSL_CALLBACK *paramCb,
     int ok = 1;
     OSSL_PARAM params[6];
     int paramsSz = 0;
-    unsigned char* data = NULL;
-    size_t len = 0;
+    wp_Der* data = NULL;
+    int owned = 0;
     int expParams = (selection & OSSL_KEYMGMT_SELECT_DOMAIN_PARAMETERS) != 0;
     int expKeyPair = (selection & OSSL_KEYMGMT_SELECT_KEYPAIR) != 0;
     int expPub = (selection & OSSL_KEYMGMT_SELECT_PUBLIC_KEY) != 0;
@@ -1257,13 +1757,23 @@ static int wp_ecc_export(wp_Ecc *ecc, int selection, OSSL_CALLBACK *paramCb,
         }
     }
     if (ok && expKeyPair) {
-        data = OPENSSL_malloc(wp_ecc_export_keypair_alloc_size(ecc, expPriv));
-        if (data == NULL) {
+        if (!wp_ecc_get_export_data(ecc, &data, &owned)) {
             ok = 0;
         }
-        if (ok && !wp_ecc_export_keypair(ecc, params, &paramsSz, data, &len,
-                expPriv)) {
-            ok = 0;
+        if (ok) {
+            size_t pubLen = WP_ECC_PUBLIC_KEY_SIZE(ecc);
+
+            wp_param_set_octet_string_ptr(&params[paramsSz++],
+                OSSL_PKEY_PARAM_PUB_KEY, WP_DER_DATA(data), pubLen);
+            if (expPriv) {
+                OSSL_PARAM* p = &params[paramsSz++];
+
+                /* Little-endian scalar as encoded by wp_param_set_mp(). */
+                p->key = OSSL_PKEY_PARAM_PRIV_KEY;
+                p->data_type = OSSL_PARAM_UNSIGNED_INTEGER;
+                p->data = WP_DER_DATA(data) + pubLen;
+                p->return_size = p->data_size = data->len - pubLen;
+            }
         }
     }
     if (ok && expOther && (!wp_ecc_export_other(ecc, params, &paramsSz))) {
@@ -1272,7 +1782,9 @@ static int wp_ecc_export(wp_Ecc *ecc, int selection, OSSL_CALLBACK *paramCb,
     if (ok) {
         ok = paramCb(params, cbArg);
     }
-    OPENSSL_clear_free(data, len);
+    if (owned) {
+        OPENSSL_clear_free(data, sizeof(*data) + data->len);
+    }
 
     return ok;
 }
@@ -1408,42 +1920,47 @@ static int wp_ecc_gen_set_params(wp_EccGenCtx* ctx, const OSSL_PARAM params[])
 }
 
 /**
- * Generate ECC key pair using wolfSSL.
+ * Create an ECC key object for the curve and optionally generate a key pair.
  *
- * @param [in, out] ctx    ECC generation context object.
- * @param [in]      cb     Progress callback. Unused.
- * @param [in]      cbArg  Argument to pass to callback. Unused.
+ * @param [in] provCtx  Provider context.
+ * @param [in] name     OpenSSL string name for elliptic curve.
+ * @param [in] keyPair  Whether to generate a key pair.
  * @return  NULL on failure.
  * @return  ECC key object on success.
  */
-static wp_Ecc* wp_ecc_gen(wp_EccGenCtx *ctx, OSSL_CALLBACK *cb, void *cbArg)
+static wp_Ecc* wp_ecc_gen_key(WOLFPROV_CTX* provCtx, const char* name,
+    int keyPair)
 {
-    wp_Ecc* ecc = NULL;
+    wp_Ecc* ecc;
 
-    (void)cb;
-    (void)cbArg;
-
-    if (ctx->curveName[0] != '\0') {
-        ecc = wp_ecc_new(ctx->provCtx);
-    }
+    ecc = wp_ecc_new(provCtx);
     if (ecc != NULL) {
         int ok = 1;
         int rc;
 
-        if (!wp_ecc_map_group_name(ecc, ctx->curveName)) {
+        if (!wp_ecc_map_group_name(ecc, name)) {
             ok = 0;
         }
-        if (ok && ((ctx->selection & OSSL_KEYMGMT_SELECT_KEYPAIR) != 0)) {
-            /* Generate key pair with wolfSSL. */
-            rc = wc_ecc_make_key_ex2(&ecc->rng, (ecc->bits + 7) / 8,
-                &ecc->key, ecc->curveId, WC_ECC_FLAG_NONE);
+        if (ok && keyPair) {
+            WC_RNG* rng = wp_ecc_get_rng(ecc);
+
+            if (rng == NULL) {
+                rc = -1;
+            }
+            else {
+                wp_provctx_ecc_fp_use(ecc->provCtx);
+                /* Generate key pair with wolfSSL. */
+                rc = wc_ecc_make_key_ex2(rng, (ecc->bits + 7) / 8, ecc->key,
+                    ecc->curveId, WC_ECC_FLAG_NONE);
+            }
             if (rc != 0) {
                 ok = 0;
             }
             else {
-                ecc->cofactor = ctx->cofactor;
                 ecc->hasPub = 1;
                 ecc->hasPriv = 1;
+                /* Generated public key is on the curve. */
+                ecc->pubValid = 1;
             }
         }
         if (!ok) {
@@ -1455,6 +1972,108 @@ static wp_Ecc* wp_ecc_gen(wp_EccGenCtx *ctx, OSSL_CALLBACK *cb, void *cbArg)
     return ecc;
 }
 
+/**
+ * Generate an ECC key pair for the key pool.
+ *
+ * @param [in] provCtx  Provider context.
+ * @param [in] arg      OpenSSL string name for elliptic curve.
+ * @return  NULL on failure.
+ * @return  ECC key object on success.
+ */
+static void* wp_ecc_pool_gen(WOLFPROV_CTX* provCtx, const void* arg)
+{
+    return wp_ecc_gen_key(provCtx, (const char*)arg, 1);
+}
+
+/**
+ * Dispose of an ECC key object from the key pool.
+ *
+ * @param [in, out] key  ECC key object.
+ */
+static void wp_ecc_pool_free(void* key)
+{
+    wp_ecc_free((wp_Ecc*)key);
+}
+
+/**
+ * Get the key pool slot and canonical name for a curve.
+ *
+ * @param [in]  name       OpenSSL string name for elliptic curve.
+ * @param [out] slotName   Name of curve in mapping table.
+ * @return  WP_KEY_POOL_* value for curve.
+ * @return  -1 when curve doesn't have keys pre-generated.
+ */
+static int wp_ecc_pool_slot(const char* name, const char** slotName)
+{
+    int id = -1;
+    size_t i;
+
+    for (i = 0; i < WP_ECC_GROUP_MAP_SZ; i++) {
+        if (strcasecmp(wp_ecc_group_map[i].name, name) == 0) {
+            break;
+        }
+    }
+    if (i < WP_ECC_GROUP_MAP_SZ) {
+        *slotName = wp_ecc_group_map[i].name;
+        switch (wp_ecc_group_map[i].curveId) {
+            case ECC_SECP256R1:
+                id = WP_KEY_POOL_P256;
+                break;
+            case ECC_SECP384R1:
+                id = WP_KEY_POOL_P384;
+                break;
+            case ECC_SECP521R1:
+                id = WP_KEY_POOL_P521;
+                break;
+            default:
+                break;
+        }
+    }
+
+    return id;
+}
+
+/**
+ * Generate ECC key pair using wolfSSL.
+ *
+ * Takes a pre-generated key pair from the key pool when available.
+ *
+ * @param [in, out] ctx    ECC generation context object.
+ * @param [in]      cb     Progress callback. Unused.
+ * @param [in]      cbArg  Argument to pass to callback. Unused.
+ * @return  NULL on failure.
+ * @return  ECC key object on success.
+ */
+static wp_Ecc* wp_ecc_gen(wp_EccGenCtx *ctx, OSSL_CALLBACK *cb, void *cbArg)
+{
+    wp_Ecc* ecc = NULL;
+    int keyPair = (ctx->selection & OSSL_KEYMGMT_SELECT_KEYPAIR) != 0;
+    word64 mStart = wp_metrics_start();
+
+    (void)cb;
+    (void)cbArg;
+
+    if ((ctx->curveName[0] != '\0') && keyPair &&
+            (ctx->provCtx->keyPool != NULL)) {
+        const char* slotName = NULL;
+        int id = wp_ecc_pool_slot(ctx->curveName, &slotName);
+
+        if (id >= 0) {
+            ecc = (wp_Ecc*)wp_key_pool_get(ctx->provCtx, id, wp_ecc_pool_gen,
+                wp_ecc_pool_free, slotName);
+        }
+    }
+    if ((ecc == NULL) && (ctx->curveName[0] != '\0')) {
+        ecc = wp_ecc_gen_key(ctx->provCtx, ctx->curveName, keyPair);
+    }
+    if (ecc != NULL) {
+        ecc->cofactor = ctx->cofactor;
+        wp_metrics_record(WP_METRIC_EC_KEYGEN, mStart, 0);
+    }
+
+    return ecc;
+}
+
 /**
  * Dispose of the ECC generation context object.
  *
@@ -1654,7 +2273,7 @@ static int wp_ecc_decode_params(wp_Ecc* ecc, unsigned char* data, word32 len)
     }
 
     if (ok) {
-        rc = wc_ecc_set_curve(&ecc->key, 0, ecc->curveId);
+        rc = wc_ecc_set_curve(ecc->key, 0, ecc->curveId);
         if (rc != 0) {
             ok = 0;
         }
@@ -1681,12 +2300,12 @@ static int wp_ecc_decode_spki(wp_Ecc* ecc, unsigned char* data, word32 len)
     int rc;
     word32 idx = 0;
 
-    rc = wc_EccPublicKeyDecode(data, &idx, &ecc->key, len);
+    rc = wc_EccPublicKeyDecode(data, &idx, ecc->key, len);
     if (rc != 0) {
         ok = 0;
     }
     if (ok) {
-        ecc->curveId = ecc->key.dp->id;
+        ecc->curveId = ecc->key->dp->id;
         ecc->hasPub = 1;
         /* Needs curveId set. */
         if (!wp_ecc_set_bits(ecc)) {
@@ -1712,14 +2331,14 @@ static int wp_ecc_decode_pki(wp_Ecc* ecc, unsigned char* data, word32 len)
     int rc;
     word32 idx = 0;
 
-    rc = wc_EccPrivateKeyDecode(data, &idx, &ecc->key, len);
+    rc = wc_EccPrivateKeyDecode(data, &idx, ecc->key, len);
     if (rc != 0) {
         ok = 0;
     }
     if (ok) {
-        ecc->curveId = ecc->key.dp->id;
+        ecc->curveId = ecc->key->dp->id;
         /* ECC_PRIVATEKEY_ONLY when no public key data. */
-        ecc->hasPub = ecc->key.type == ECC_PRIVATEKEY;
+        ecc->hasPub = ecc->key->type == ECC_PRIVATEKEY;
         ecc->hasPriv = 1;
         /* Needs curveId set. */
         if (!wp_ecc_set_bits(ecc)) {
@@ -1730,6 +2349,69 @@ static int wp_ecc_decode_pki(wp_Ecc* ecc, unsigned char* data, word32 len)
     return ok;
 }
 
+/**
+ * Replace a decoded ECC private key object with a compact one.
+ *
+ * The key object must not yet be shared. Left unchanged on failure.
+ *
+ * @param [in, out] pEcc  On in, decoded ECC key object.
+ *                        On out, compact ECC key object.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_ecc_compact(wp_Ecc** pEcc)
+{
+    int ok = 1;
+    int rc;
+    wp_Ecc* ecc = *pEcc;
+    wp_Ecc* cmp;
+    word32 size = (ecc->bits + 7) / 8;
+    size_t len = wp_ecc_compact_size(ecc);
+    unsigned char* data = NULL;
+
+    cmp = (wp_Ecc*)OPENSSL_zalloc(sizeof(*cmp) + len);
+    if (cmp == NULL) {
+        ok = 0;
+    }
+    if (ok) {
+        data = (unsigned char*)(cmp + 1);
+        /* Fixed size so that the public point is found when expanding. */
+        rc = mp_to_unsigned_bin_len(&ecc->key->k, data, size);
+        if (rc != 0) {
+            ok = 0;
+        }
+    }
+    if (ok && ecc->hasPub) {
+        word32 outLen = (word32)(len - size);
+
+        rc = wc_ecc_export_x963_ex(ecc->key, data + size, &outLen, 0);
+        if (rc != 0) {
+            ok = 0;
+        }
+    }
+    if (ok && (!wp_refcnt_init(&cmp->refCnt))) {
+        ok = 0;
+    }
+    if (ok) {
+        cmp->provCtx       = ecc->provCtx;
+        cmp->curveId       = ecc->curveId;
+        cmp->bits          = ecc->bits;
+        cmp->cofactor      = ecc->cofactor;
+        cmp->includePublic = ecc->includePublic;
+        cmp->hasPub        = ecc->hasPub;
+        cmp->hasPriv       = ecc->hasPriv;
+        cmp->pubValid      = ecc->pubValid;
+        cmp->compact       = 1;
+        wp_ecc_free(ecc);
+        *pEcc = cmp;
+    }
+    else if (cmp != NULL) {
+        OPENSSL_clear_free(cmp, sizeof(*cmp) + len);
+    }
+
+    return ok;
+}
+
 /**
  * Construct parameters from ECC key and pass off to callback.
  *
@@ -1829,6 +2511,11 @@ static int wp_ecc_decode(wp_EccEncDecCtx* ctx, OSSL_CORE_BIO *cBio,
 
     OPENSSL_clear_free(data, len);
 
+    /* Stored private keys are kept compact when configured. */
+    if (ok && decoded && ecc->hasPriv && (ctx->provCtx->eccCache != NULL)) {
+        /* Full key object is used when compacting fails. */
+        (void)wp_ecc_compact(&ecc);
+    }
     if (ok && decoded && (!wp_ecc_dec_send_params(ecc, dataCb, dataCbArg))) {
         ok = 0;
     }
@@ -1854,7 +2541,7 @@ static int wp_ecc_decode(wp_EccEncDecCtx* ctx, OSSL_CORE_BIO *cBio,
 static int wp_ecc_encode_params_size(const wp_Ecc *ecc, size_t* keyLen)
 {
     /* ASN.1 type, len and data. */
-    *keyLen = ecc->key.dp->oidSz + 2;
+    *keyLen = ecc->key->dp->oidSz + 2;
 
     return 1;
 }
@@ -1873,10 +2560,10 @@ static int wp_ecc_encode_params(const wp_Ecc *ecc, unsigned char* keyData,
     size_t* keyLen)
 {
     keyData[0] = 0x06;
-    keyData[1] = ecc->key.dp->oidSz;
-    XMEMCPY(keyData + 2, ecc->key.dp->oid, ecc->key.dp->oidSz);
+    keyData[1] = ecc->key->dp->oidSz;
+    XMEMCPY(keyData + 2, ecc->key->dp->oid, ecc->key->dp->oidSz);
 
-    *keyLen = ecc->key.dp->oidSz + 2;
+    *keyLen = ecc->key->dp->oidSz + 2;
 
     return 1;
 }
@@ -1894,7 +2581,7 @@ static int wp_ecc_encode_priv_size(const wp_Ecc *ecc, size_t* keyLen)
     int ok = 1;
     int rc;
 
-    rc = wc_EccKeyDerSize((ecc_key*)&ecc->key, 1);
+    rc = wc_EccKeyDerSize(ecc->key, 1);
     if (rc <= 0) {
         ok = 0;
     }
@@ -1922,7 +2609,7 @@ static int wp_ecc_encode_priv(const wp_Ecc *ecc, unsigned char* keyData,
     int rc;
     word32 len = *keyLen;
 
-    rc = wc_EccKeyToDer((ecc_key*)&ecc->key, keyData, len);
+    rc = wc_EccKeyToDer(ecc->key, keyData, len);
     if (rc <= 0) {
         ok = 0;
     }
@@ -1946,7 +2633,7 @@ static int wp_ecc_encode_spki_size(const wp_Ecc *ecc, size_t* keyLen)
     int ok = 1;
     int rc;
 
-    rc = wc_EccPublicKeyDerSize((ecc_key*)&ecc->key, 1);
+    rc = wc_EccPublicKeyDerSize(ecc->key, 1);
     if (rc < 0) {
         ok = 0;
     }
@@ -1974,7 +2661,7 @@ static int wp_ecc_encode_spki(const wp_Ecc *ecc, unsigned char* keyData,
     int rc;
     word32 len = *keyLen;
 
-    rc = wc_EccPublicKeyToDer((ecc_key*)&ecc->key, keyData, len, 1);
+    rc = wc_EccPublicKeyToDer(ecc->key, keyData, len, 1);
     if (rc <= 0) {
         ok = 0;
     }
@@ -1986,28 +2673,19 @@ static int wp_ecc_encode_spki(const wp_Ecc *ecc, unsigned char* keyData,
 }
 
 /**
- * Get the PKCS#8 encoding size for the key.
+ * Get the maximum PKCS#8 encoding size for the key.
+ *
+ * Calculated from the curve size rather than by encoding the key twice.
  *
  * @param [in]  ecc     ECC key object.
- * @param [out] keyLen  Length of encoding in bytes.
+ * @param [out] keyLen  Maximum length of encoding in bytes.
  * @return  1 on success.
  * @return  0 on failure.
  */
 static int wp_ecc_encode_pki_size(const wp_Ecc *ecc, size_t* keyLen)
 {
-    int ok = 1;
-    int rc;
-    word32 len;
-
-    rc = wc_EccKeyToPKCS8((ecc_key*)&ecc->key, NULL, &len);
-    if (rc != LENGTH_ONLY_E) {
-        ok = 0;
-    }
-    if (ok) {
-        *keyLen = len;
-    }
-
-    return ok;
+    *keyLen = WP_ECC_PKI_MAX_LEN((ecc->bits + 7) / 8);
+    return 1;
 }
 
 /**
@@ -2027,7 +2705,7 @@ static int wp_ecc_encode_pki(const wp_Ecc *ecc, unsigned char* keyData,
     int rc;
     word32 len = *keyLen;
 
-    rc = wc_EccKeyToPKCS8((ecc_key*)&ecc->key, keyData, &len);
+    rc = wc_EccKeyToPKCS8(ecc->key, keyData, &len);
     if (rc <= 0) {
         ok = 0;
     }
@@ -2039,28 +2717,17 @@ static int wp_ecc_encode_pki(const wp_Ecc *ecc, unsigned char* keyData,
 }
 
 /**
- * Get the Encrypted PKCS#8 encoding size for the key.
+ * Get the maximum Encrypted PKCS#8 encoding size for the key.
  *
  * @param [in]  ecc     ECC key object.
- * @param [out] keyLen  Length of encoding in bytes.
+ * @param [out] keyLen  Maximum length of encoding in bytes.
  * @return  1 on success.
  * @return  0 on failure.
  */
 static int wp_ecc_encode_epki_size(const wp_Ecc *ecc, size_t* keyLen)
 {
-    int ok = 1;
-    int rc;
-    word32 len;
-
-    rc = wc_EccKeyToPKCS8((ecc_key*)&ecc->key, NULL, &len);
-    if (rc != LENGTH_ONLY_E) {
-        ok = 0;
-    }
-    if (ok) {
-        *keyLen = ((len + 15) / 16) * 16;
-    }
-
-    return ok;
+    *keyLen = ((WP_ECC_PKI_MAX_LEN((ecc->bits + 7) / 8) + 15) / 16) * 16;
+    return 1;
 }
 
 /**
@@ -2086,10 +2753,14 @@ static int wp_ecc_encode_epki(const wp_EccEncDecCtx* ctx, const wp_Ecc *ecc,
     word32 len = *keyLen;
 
     /* Encode key. */
-    rc = wc_EccKeyToPKCS8((ecc_key*)&ecc->key, keyData, &len);
+    rc = wc_EccKeyToPKCS8(ecc->key, keyData, &len);
     if (rc <= 0) {
         ok = 0;
     }
+    if (ok) {
+        /* Buffer may be larger than needed - encrypt padded encoding only. */
+        *keyLen = ((len + 15) / 16) * 16;
+    }
     if (ok && (!wp_encrypt_key(ctx->provCtx, ctx->cipherName, keyData, keyLen,
             len, pwCb, pwCbArg, cipherInfo))) {
         ok = 0;
@@ -2098,6 +2769,61 @@ static int wp_ecc_encode_epki(const wp_EccEncDecCtx* ctx, const wp_Ecc *ecc,
     return ok;
 }
 
+/**
+ * Get the SubjectPublicKeyInfo encoding of the key.
+ *
+ * The same key is encoded repeatedly - certificate matching, key identifiers
+ * and public key hashing - so the encoding is memoized on the key object.
+ *
+ * @param [in]  ecc    ECC key object.
+ * @param [out] spki   DER object holding encoding.
+ * @param [out] owned  1 when caller is to free DER object, otherwise 0.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_ecc_get_spki(const wp_Ecc* ecc, wp_Der** spki, int* owned)
+{
+    int ok = 1;
+    wp_Der* der;
+    size_t len = 0;
+
+    *owned = 0;
+    der = wp_der_get(&ecc->spki);
+    if (der == NULL) {
+        /* Compact key is expanded to encode. */
+        if (wp_ecc_acquire_key((wp_Ecc*)ecc) == NULL) {
+            ok = 0;
+        }
+        if (ok) {
+            if (!wp_ecc_encode_spki_size(ecc, &len)) {
+                ok = 0;
+            }
+            if (ok) {
+                der = wp_der_new(len);
+                if (der == NULL) {
+                    ok = 0;
+                }
+            }
+            if (ok && (!wp_ecc_encode_spki(ecc, WP_DER_DATA(der),
+                    &der->len))) {
+                ok = 0;
+            }
+            wp_ecc_release_key((wp_Ecc*)ecc);
+        }
+        if (ok) {
+            *owned = !wp_der_set(&((wp_Ecc*)ecc)->spki, &der);
+        }
+        else {
+            OPENSSL_free(der);
+        }
+    }
+    if (ok) {
+        *spki = der;
+    }
+
+    return ok;
+}
+
 /**
  * Encode the ECC key.
  *
@@ -2119,7 +2845,7 @@ static int wp_ecc_encode(wp_EccEncDecCtx* ctx, OSSL_CORE_BIO *cBio,
     int rc;
     BIO* out = wp_corebio_get_bio(cBio);
     unsigned char* keyData = NULL;
-    size_t keyLen;
+    size_t keyLen = 0;
     unsigned char* derData = NULL;
     size_t derLen = 0;
     unsigned char* pemData = NULL;
@@ -2127,6 +2853,11 @@ static int wp_ecc_encode(wp_EccEncDecCtx* ctx, OSSL_CORE_BIO *cBio,
     int pemType = PKCS8_PRIVATEKEY_TYPE;
     int private = 0;
     byte* cipherInfo = NULL;
+    ecc_key* eccKey = NULL;
+    wp_Der* spki = NULL;
+    int spkiOwned = 0;
+    unsigned char* der = NULL;
+    size_t allocLen = 0;
 
     (void)params;
 
@@ -2134,84 +2865,92 @@ static int wp_ecc_encode(wp_EccEncDecCtx* ctx, OSSL_CORE_BIO *cBio,
         ok = 0;
     }
 
-    if (ok && (ctx->format == WP_ENC_FORMAT_TYPE_SPECIFIC)) {
-        if (selection == OSSL_KEYMGMT_SELECT_DOMAIN_PARAMETERS) {
-            if (!wp_ecc_encode_params_size(key, &derLen)) {
-                ok = 0;
-            }
-        }
-        else {
-            private = 1;
-            if (!wp_ecc_encode_priv_size(key, &derLen)) {
-                ok = 0;
-            }
-        }
-    }
-    else if (ok && (ctx->format == WP_ENC_FORMAT_SPKI)) {
-        if (!wp_ecc_encode_spki_size(key, &derLen)) {
+    if (ok && (ctx->format == WP_ENC_FORMAT_SPKI)) {
+        pemType = PUBLICKEY_TYPE;
+        if (!wp_ecc_get_spki(key, &spki, &spkiOwned)) {
             ok = 0;
         }
-    }
-    else if (ok && (ctx->format == WP_ENC_FORMAT_PKI)) {
-        private = 1;
-        if (!wp_ecc_encode_pki_size(key, &derLen)) {
-            ok = 0;
+        if (ok) {
+            der = WP_DER_DATA(spki);
+            derLen = spki->len;
         }
     }
-    else if (ok && (ctx->format == WP_ENC_FORMAT_EPKI)) {
-        private = 1;
-        if (!wp_ecc_encode_epki_size(key, &derLen)) {
+    else if (ok) {
+        /* Compact key is expanded to encode. */
+        eccKey = wp_ecc_acquire_key((wp_Ecc*)key);
+        if (eccKey == NULL) {
             ok = 0;
         }
-    }
 
-    if (ok) {
-        keyLen = derLen;
-        keyData = derData = OPENSSL_malloc(derLen);
-        if (derData == NULL) {
-            ok = 0;
+        if (ok && (ctx->format == WP_ENC_FORMAT_TYPE_SPECIFIC)) {
+            if (selection == OSSL_KEYMGMT_SELECT_DOMAIN_PARAMETERS) {
+                if (!wp_ecc_encode_params_size(key, &derLen)) {
+                    ok = 0;
+                }
+            }
+            else {
+                private = 1;
+                if (!wp_ecc_encode_priv_size(key, &derLen)) {
+                    ok = 0;
+                }
+            }
         }
-    }
-
-    if (ok && (ctx->format == WP_ENC_FORMAT_TYPE_SPECIFIC)) {
-        if (selection == OSSL_KEYMGMT_SELECT_DOMAIN_PARAMETERS) {
-            pemType = DH_PARAM_TYPE;
-            if (!wp_ecc_encode_params(key, derData, &derLen)) {
+        else if (ok && (ctx->format == WP_ENC_FORMAT_PKI)) {
+            private = 1;
+            if (!wp_ecc_encode_pki_size(key, &derLen)) {
                 ok = 0;
             }
         }
-        else {
+        else if (ok && (ctx->format == WP_ENC_FORMAT_EPKI)) {
             private = 1;
-            if (!wp_ecc_encode_priv(key, derData, &derLen)) {
+            if (!wp_ecc_encode_epki_size(key, &derLen)) {
                 ok = 0;
             }
         }
-    }
-    else if (ok && (ctx->format == WP_ENC_FORMAT_SPKI)) {
-        pemType = PUBLICKEY_TYPE;
-        if (!wp_ecc_encode_spki(key, derData, &derLen)) {
-            ok = 0;
+
+        if (ok) {
+            allocLen = derLen;
+            der = derData = OPENSSL_malloc(allocLen);
+            if (derData == NULL) {
+                ok = 0;
+            }
         }
-    }
-    else if (ok && (ctx->format == WP_ENC_FORMAT_PKI)) {
-        private = 1;
-        if (!wp_ecc_encode_pki(key, derData, &derLen)) {
-            ok = 0;
+
+        if (ok && (ctx->format == WP_ENC_FORMAT_TYPE_SPECIFIC)) {
+            if (selection == OSSL_KEYMGMT_SELECT_DOMAIN_PARAMETERS) {
+                pemType = DH_PARAM_TYPE;
+                if (!wp_ecc_encode_params(key, derData, &derLen)) {
+                    ok = 0;
+                }
+            }
+            else {
+                private = 1;
+                if (!wp_ecc_encode_priv(key, derData, &derLen)) {
+                    ok = 0;
+                }
+            }
         }
-    }
-    else if (ok && (ctx->format == WP_ENC_FORMAT_EPKI)) {
-        private = 1;
-        if (!wp_ecc_encode_epki(ctx, key, derData, &derLen, pwCb, pwCbArg,
-                (ctx->encoding == WP_FORMAT_PEM) ? &cipherInfo : NULL)) {
-            ok = 0;
+        else if (ok && (ctx->format == WP_ENC_FORMAT_PKI)) {
+            private = 1;
+            if (!wp_ecc_encode_pki(key, derData, &derLen)) {
+                ok = 0;
+            }
+        }
+        else if (ok && (ctx->format == WP_ENC_FORMAT_EPKI)) {
+            private = 1;
+            if (!wp_ecc_encode_epki(ctx, key, derData, &derLen, pwCb, pwCbArg,
+                    (ctx->encoding == WP_FORMAT_PEM) ? &cipherInfo : NULL)) {
+                ok = 0;
+            }
         }
     }
 
     if (ok && (ctx->encoding == WP_FORMAT_DER)) {
+        keyData = der;
         keyLen = derLen;
     }
     else if (ok && (ctx->encoding == WP_FORMAT_PEM)) {
-        rc = wc_DerToPemEx(derData, derLen, NULL, 0, cipherInfo, pemType);
+        rc = wc_DerToPemEx(der, derLen, NULL, 0, cipherInfo, pemType);
         if (rc <= 0) {
             ok = 0;
         }
@@ -2223,7 +2962,7 @@ static int wp_ecc_encode(wp_EccEncDecCtx* ctx, OSSL_CORE_BIO *cBio,
             }
         }
         if (ok) {
-            rc = wc_DerToPemEx(derData, derLen, pemData, pemLen, cipherInfo,
+            rc = wc_DerToPemEx(der, derLen, pemData, pemLen, cipherInfo,
                 pemType);
             if (rc <= 0) {
                 ok = 0;
@@ -2248,8 +2987,14 @@ static int wp_ecc_encode(wp_EccEncDecCtx* ctx, OSSL_CORE_BIO *cBio,
         }
     }
 
+    if (eccKey != NULL) {
+        wp_ecc_release_key((wp_Ecc*)key);
+    }
+    if (spkiOwned) {
+        OPENSSL_free(spki);
+    }
     if (private) {
-        OPENSSL_clear_free(derData, derLen);
+        OPENSSL_clear_free(derData, allocLen);
         OPENSSL_clear_free(pemData, pemLen);
     }
     else {
@@ -32,6 +32,8 @@
 #define WP_KDF_NONE       0
 /** X9.63 KDF applied to derived secret. */
 #define WP_KDF_X963       1
+/** HKDF-Extract applied to derived secret. */
+#define WP_KDF_HKDF_EXTRACT 2
 
 
 /**
@@ -59,6 +61,10 @@ typedef struct wp_EcdhCtx {
     unsigned char* ukm;
     /** Length of User Keying Material. */
     size_t ukmLen;
+    /** Salt for HKDF-Extract. */
+    unsigned char* salt;
+    /** Length of salt. */
+    size_t saltLen;
     /** Length of key to derive. */
     size_t keyLen;
 } wp_EcdhCtx;
@@ -99,6 +105,8 @@ static void wp_ecdh_free(wp_EcdhCtx* ctx)
     if (ctx != NULL) {
         wp_ecc_free(ctx->peer);
         wp_ecc_free(ctx->key);
+        OPENSSL_clear_free(ctx->salt, ctx->saltLen);
+        OPENSSL_free(ctx->ukm);
         OPENSSL_free(ctx);
     }
 }
@@ -142,13 +150,22 @@ static wp_EcdhCtx* wp_ecdh_dup(wp_EcdhCtx* src)
                 ok = 0;
             }
         }
+        /* Copy HKDF-Extract salt. */
+        if (ok && (src->salt != NULL) && (src->saltLen > 0)) {
+            dst->salt = OPENSSL_memdup(src->salt, src->saltLen);
+            if (dst->salt == NULL) {
+                ok = 0;
+            }
+        }
         if (ok) {
             /* Copy remaining fields across. */
             dst->cofactor = src->cofactor;
             dst->kdfType  = src->kdfType;
             dst->kdfMd    = src->kdfMd;
             dst->ukmLen   = src->ukmLen;
+            dst->saltLen  = src->saltLen;
             dst->keyLen   = src->keyLen;
+            XMEMCPY(dst->kdfMdName, src->kdfMdName, sizeof(dst->kdfMdName));
         }
         if (!ok) {
             /* Free allcoated memory and up referenced objects. */
@@ -230,6 +247,45 @@ static int wp_ecdh_kdf_derive(wp_EcdhCtx* ctx, unsigned char* key,
     return ok;
 }
 
+/**
+ * Derive key from secret with HKDF-Extract to produce output.
+ *
+ * Saves creating a separate HKDF object to extract from the secret.
+ *
+ * @param [in]  ctx      ECDH key exchange context object.
+ * @param [in]  key      Buffer to hold key derived from secret.
+ * @param [out] keyLen   Length of derived key in bytes.
+ * @param [in]  keySize  Length of buffer in bytes.
+ * @param [in]  secret   Secret data.
+ * @param [in]  secLen   Length of secret data in bytes.
+ * @return 1 on success.
+ * @return 0 on failure.
+ */
+static int wp_ecdh_hkdf_extract(wp_EcdhCtx* ctx, unsigned char* key,
+    size_t* keyLen, size_t keySize, unsigned char* secret, size_t secLen)
+{
+    int ok = 1;
+    int mdLen;
+
+    mdLen = wc_HashGetDigestSize(ctx->kdfMd);
+    if ((mdLen <= 0) || (keySize < (size_t)mdLen)) {
+        ok = 0;
+    }
+    if (ok) {
+        int rc;
+        rc = wc_HKDF_Extract(ctx->kdfMd, ctx->salt, (word32)ctx->saltLen,
+            secret, (word32)secLen, key);
+        if (rc != 0) {
+            ok = 0;
+        }
+        else {
+            *keyLen = mdLen;
+        }
+    }
+
+    return ok;
+}
+
 /**
  * Derive secret from ECC keys.
  *
@@ -246,21 +302,68 @@ static int wp_ecdh_derive_secret(wp_EcdhCtx* ctx, unsigned char* secret,
     int ok = 1;
     int rc;
     word32 len = *secLen;
+    ecc_key priv;
+    int privInit = 0;
+    /* Compact keys are expanded for the operation. */
+    ecc_key* key = wp_ecc_acquire_key(ctx->key);
+    ecc_key* peer = wp_ecc_acquire_key(ctx->peer);
 
+    if ((key == NULL) || (peer == NULL)) {
+        ok = 0;
+    }
+    if (ok) {
+        /* Key is shared - RNG and flags are set on a copy for this call. */
+        rc = wp_ecc_copy_priv(key, &priv, ctx->provCtx->devId);
+        if (rc != 0) {
+            ok = 0;
+        }
+        else {
+            privInit = 1;
+        }
+    }
 #ifdef HAVE_ECC_CDH
-    if (ctx->cofactor) {
-        wc_ecc_set_flags(wp_ecc_get_key(ctx->key), WC_ECC_FLAG_COFACTOR);
+    if (ok && ctx->cofactor) {
+        wc_ecc_set_flags(&priv, WC_ECC_FLAG_COFACTOR);
     }
 #endif
-    /* Calculate secret. */
-    rc = wc_ecc_shared_secret(wp_ecc_get_key(ctx->key),
-        wp_ecc_get_key(ctx->peer), secret, &len);
-    if (rc != 0) {
-        ok = 0;
+#ifdef ECC_TIMING_RESISTANT
+    if (ok) {
+        /* Blinding uses the calling thread's RNG. */
+        WC_RNG* rng = wp_ecc_get_rng(ctx->key);
+
+        if ((rng == NULL) || (wc_ecc_set_rng(&priv, rng) != 0)) {
+            ok = 0;
+        }
+    }
+#endif
+    if (ok) {
+        wp_Arena* arena;
+
+        wp_provctx_ecc_fp_use(ctx->provCtx);
+        /* Calculate secret - wolfCrypt temporaries from thread's arena when
+         * configured. */
+        arena = wp_arena_begin();
+        do {
+            rc = wc_ecc_shared_secret(&priv, peer, secret, &len);
+        }
+        while (wp_async_pending(&rc, WP_ASYNC_DEV(&priv)));
+        wp_arena_end(arena);
+        if (rc != 0) {
+            ok = 0;
+        }
+    }
+    if (privInit) {
+        wc_ecc_free(&priv);
     }
     if (ok) {
         *secLen = len;
     }
+    if (key != NULL) {
+        wp_ecc_release_key(ctx->key);
+    }
+    if (peer != NULL) {
+        wp_ecc_release_key(ctx->peer);
+    }
 
     return ok;
 }
@@ -282,9 +385,10 @@ static int wp_ecdh_derive(wp_EcdhCtx* ctx, unsigned char* secret,
 {
     int ok = 1;
     int done = 0;
-    unsigned char* out;
+    unsigned char* out = NULL;
     size_t outLen;
     unsigned char tmp[72];
+    word64 mStart = wp_metrics_start();
 
     if (!wolfssl_prov_is_running()) {
         ok = 0;
@@ -295,6 +399,15 @@ static int wp_ecdh_derive(wp_EcdhCtx* ctx, unsigned char* secret,
         if (ctx->kdfType == WP_KDF_NONE) {
             *secLen = wp_ecc_get_size(ctx->key);
         }
+        else if (ctx->kdfType == WP_KDF_HKDF_EXTRACT) {
+            int mdLen = wc_HashGetDigestSize(ctx->kdfMd);
+            if (mdLen <= 0) {
+                ok = 0;
+            }
+            else {
+                *secLen = (size_t)mdLen;
+            }
+        }
         else {
             *secLen = ctx->keyLen;;
         }
@@ -307,7 +420,8 @@ static int wp_ecdh_derive(wp_EcdhCtx* ctx, unsigned char* secret,
             out = secret;
             outLen = secSize;
         }
-        else if (ctx->kdfType == WP_KDF_X963) {
+        else if ((ctx->kdfType == WP_KDF_X963) ||
+                 (ctx->kdfType == WP_KDF_HKDF_EXTRACT)) {
             /* Output of ECDH key exchange goes into temporary buffer. */
             out = tmp;
             outLen = sizeof(tmp);
@@ -327,10 +441,20 @@ static int wp_ecdh_derive(wp_EcdhCtx* ctx, unsigned char* secret,
              /* Put output through KDF using wolfSSL. */
             ok = wp_ecdh_kdf_derive(ctx, secret, secLen, secSize, out, outLen);
         }
+        else if (ctx->kdfType == WP_KDF_HKDF_EXTRACT) {
+            ok = wp_ecdh_hkdf_extract(ctx, secret, secLen, secSize, out,
+                outLen);
+        }
         else {
             *secLen = outLen;
         }
     }
+    if ((!done) && (out == tmp)) {
+        OPENSSL_cleanse(tmp, sizeof(tmp));
+    }
+    if ((!done) && ok) {
+        wp_metrics_record(WP_METRIC_ECDH_DERIVE, mStart, *secLen);
+    }
 
     return ok;
 }
@@ -390,6 +514,9 @@ static int wp_ecdh_set_param_kdf(wp_EcdhCtx* ctx, const OSSL_PARAM params[])
             /* Only support the non ASN1 variant. */
             ctx->kdfType = WP_KDF_X963;
         }
+        else if (XSTRCMP(kdf, WP_EXCHANGE_KDF_NAME_HKDF_EXTRACT) == 0) {
+            ctx->kdfType = WP_KDF_HKDF_EXTRACT;
+        }
         else {
             ok = 0;
         }
@@ -470,6 +597,10 @@ static int wp_ecdh_set_ctx_params(wp_EcdhCtx* ctx, const OSSL_PARAM params[])
                 OSSL_EXCHANGE_PARAM_KDF_UKM, &ctx->ukm, &ctx->ukmLen, 0))) {
             ok = 0;
         }
+        if (ok && (!wp_params_get_octet_string(params,
+                WP_EXCHANGE_PARAM_KDF_SALT, &ctx->salt, &ctx->saltLen, 1))) {
+            ok = 0;
+        }
     }
 
     return ok;
@@ -495,6 +626,7 @@ static const OSSL_PARAM* wp_ecdh_settable_ctx_params(wp_EcdhCtx* ctx,
         OSSL_PARAM_utf8_string(OSSL_EXCHANGE_PARAM_KDF_DIGEST_PROPS, NULL, 0),
         OSSL_PARAM_size_t(OSSL_EXCHANGE_PARAM_KDF_OUTLEN, NULL),
         OSSL_PARAM_octet_string(OSSL_EXCHANGE_PARAM_KDF_UKM, NULL, 0),
+        OSSL_PARAM_octet_string(WP_EXCHANGE_PARAM_KDF_SALT, NULL, 0),
         OSSL_PARAM_END
     };
     (void)ctx;
@@ -521,6 +653,9 @@ static int wp_ecdh_get_params_kdf(wp_EcdhCtx* ctx, OSSL_PARAM params[])
          if (ctx->kdfType == WP_KDF_X963) {
              type = OSSL_KDF_NAME_X942KDF_ASN1;
          }
+         else if (ctx->kdfType == WP_KDF_HKDF_EXTRACT) {
+             type = WP_EXCHANGE_KDF_NAME_HKDF_EXTRACT;
+         }
          if (ok && (!OSSL_PARAM_set_utf8_string(p, type))) {
              ok = 0;
          }
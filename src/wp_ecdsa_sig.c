@@ -54,6 +54,11 @@ typedef struct wp_EcdsaSigCtx {
     char* propQuery;
     /** Name of hash algorithm. */
     char mdName[WP_MAX_MD_NAME_SIZE];
+
+    /** Bitmap of results of last batch verification. */
+    unsigned char* batchRes;
+    /** Length of batch verification results bitmap in bytes. */
+    size_t batchResLen;
 } wp_EcdsaSigCtx;
 
 
@@ -112,6 +117,7 @@ static void wp_ecdsa_freectx(wp_EcdsaSigCtx* ctx)
 {
     if (ctx != NULL) {
         wp_ecc_free(ctx->ecc);
+        OPENSSL_free(ctx->batchRes);
         OPENSSL_free(ctx->propQuery);
         OPENSSL_free(ctx);
     }
@@ -307,12 +313,17 @@ static int wp_ecdsa_sign(wp_EcdsaSigCtx *ctx, unsigned char *sig,
     size_t *sigLen, size_t sigSize, const unsigned char *tbs, size_t tbsLen)
 {
     int ok = 1;
+    word64 mStart = wp_metrics_start();
+    ecc_key* key = NULL;
 
     if (!wolfssl_prov_is_running()) {
         ok = 0;
     }
+    else if ((key = wp_ecc_acquire_key(ctx->ecc)) == NULL) {
+        ok = 0;
+    }
     else if (sig == NULL) {
-        *sigLen = wc_ecc_sig_size(wp_ecc_get_key(ctx->ecc));
+        *sigLen = wc_ecc_sig_size(key);
     }
     else {
         if ((ctx->hashType != WC_HASH_TYPE_NONE) &&
@@ -322,21 +333,34 @@ static int wp_ecdsa_sign(wp_EcdsaSigCtx *ctx, unsigned char *sig,
         else {
             int rc;
             word32 len;
+            WC_RNG* rng = wp_ecc_get_rng(ctx->ecc);
 
             if (sigSize == (size_t)-1) {
                 sigSize = *sigLen;
             }
             len = sigSize;
-            rc = wc_ecc_sign_hash(tbs, tbsLen, sig, &len,
-                wp_ecc_get_rng(ctx->ecc), wp_ecc_get_key(ctx->ecc));
+            if (rng == NULL) {
+                rc = -1;
+            }
+            else {
+                wp_provctx_ecc_fp_use(ctx->provCtx);
+                do {
+                    rc = wc_ecc_sign_hash(tbs, tbsLen, sig, &len, rng, key);
+                }
+                while (wp_async_pending(&rc, WP_ASYNC_DEV(key)));
+            }
             if (rc != 0) {
                 ok = 0;
             }
             else {
                 *sigLen = len;
+                wp_metrics_record(WP_METRIC_ECDSA_SIGN, mStart, tbsLen);
             }
         }
     }
+    if (key != NULL) {
+        wp_ecc_release_key(ctx->ecc);
+    }
 
     return ok;
 }
@@ -380,20 +404,34 @@ static int wp_ecdsa_verify(wp_EcdsaSigCtx *ctx, const unsigned char *sig,
     size_t sigLen, const unsigned char *tbs, size_t tbsLen)
 {
     int ok = 1;
+    word64 mStart = wp_metrics_start();
+    ecc_key* key = NULL;
 
     if (!wolfssl_prov_is_running()) {
         ok = 0;
     }
+    else if ((key = wp_ecc_acquire_key(ctx->ecc)) == NULL) {
+        ok = 0;
+    }
     else {
-        int res;
-        int rc = wc_ecc_verify_hash(sig, sigLen, tbs, tbsLen, &res,
-            wp_ecc_get_key(ctx->ecc));
+        int res = 0;
+        int rc;
+
+        wp_provctx_ecc_fp_use(ctx->provCtx);
+        do {
+            rc = wc_ecc_verify_hash(sig, sigLen, tbs, tbsLen, &res, key);
+        }
+        while (wp_async_pending(&rc, WP_ASYNC_DEV(key)));
         if (rc != 0) {
             ok = 0;
         }
         if (res == 0) {
             ok = 0;
         }
+        if (ok) {
+            wp_metrics_record(WP_METRIC_ECDSA_VERIFY, mStart, tbsLen);
+        }
+        wp_ecc_release_key(ctx->ecc);
     }
 
     return ok;
@@ -480,7 +518,8 @@ static int wp_ecdsa_setup_md(wp_EcdsaSigCtx *ctx, const char *mdName,
         }
 
         if (ok) {
-            rc = wc_HashInit_ex(&ctx->hash, ctx->hashType, NULL, INVALID_DEVID);
+            rc = wc_HashInit_ex(&ctx->hash, ctx->hashType, NULL,
+                ctx->provCtx->devId);
             if (rc != 0) {
                 ok = 0;
             }
@@ -708,6 +747,14 @@ static int wp_ecdsa_get_ctx_params(wp_EcdsaSigCtx *ctx, OSSL_PARAM *params)
             ok = 0;
         }
     }
+    if (ok) {
+        p = OSSL_PARAM_locate(params, WP_SIGNATURE_PARAM_BATCH_RESULT);
+        if ((p != NULL) && ((ctx->batchRes == NULL) ||
+                (!OSSL_PARAM_set_octet_string(p, ctx->batchRes,
+                    ctx->batchResLen)))) {
+            ok = 0;
+        }
+    }
 
     return ok;
 }
@@ -716,6 +763,7 @@ static int wp_ecdsa_get_ctx_params(wp_EcdsaSigCtx *ctx, OSSL_PARAM *params)
 static const OSSL_PARAM wp_supported_gettable_ctx_params[] = {
     OSSL_PARAM_octet_string(OSSL_SIGNATURE_PARAM_ALGORITHM_ID, NULL, 0),
     OSSL_PARAM_utf8_string(OSSL_SIGNATURE_PARAM_DIGEST, NULL, 0),
+    OSSL_PARAM_octet_string(WP_SIGNATURE_PARAM_BATCH_RESULT, NULL, 0),
     OSSL_PARAM_END
 };
 /**
@@ -768,6 +816,68 @@ static int wp_ecdsa_set_digest(wp_EcdsaSigCtx *ctx, const OSSL_PARAM *p,
     return ok;
 }
 
+/**
+ * Verify one signature of a batch with the ECDSA signature context's key.
+ *
+ * @param [in, out] ctx     ECDSA signature context object.
+ * @param [in]      sig     Signature data.
+ * @param [in]      sigLen  Length of signature in bytes.
+ * @param [in]      tbs     Digest of message that was signed.
+ * @param [in]      tbsLen  Length of digest in bytes.
+ * @return  1 when signature verified.
+ * @return  0 otherwise.
+ */
+static int wp_ecdsa_batch_verify_one(void* ctx, const unsigned char* sig,
+    size_t sigLen, const unsigned char* tbs, size_t tbsLen)
+{
+    return wp_ecdsa_verify((wp_EcdsaSigCtx*)ctx, sig, sigLen, tbs, tbsLen);
+}
+
+/**
+ * Verify a batch of signatures with the ECDSA signature context's key.
+ *
+ * Data to verify is the digest of the message.
+ *
+ * @param [in, out] ctx  ECDSA signature context object.
+ * @param [in]      p    Parameter object with batch verification data.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_ecdsa_batch_verify(wp_EcdsaSigCtx *ctx, const OSSL_PARAM *p)
+{
+    int ok = 1;
+
+    if ((ctx->op != EVP_PKEY_OP_VERIFY) || (ctx->ecc == NULL)) {
+        ok = 0;
+    }
+    if (ok && (p->data_type != OSSL_PARAM_OCTET_STRING)) {
+        ok = 0;
+    }
+    if (ok) {
+        ok = wp_batch_verify(ctx, wp_ecdsa_batch_verify_one,
+            (const unsigned char*)p->data, p->data_size, &ctx->batchRes,
+            &ctx->batchResLen);
+    }
+
+    return ok;
+}
+
+/** Index of digest in parameters set. */
+#define WP_ECDSA_PARAM_DIGEST           0
+/** Index of digest properties in parameters set. */
+#define WP_ECDSA_PARAM_PROPERTIES       1
+/** Index of batch to verify in parameters set. */
+#define WP_ECDSA_PARAM_BATCH_VERIFY     2
+/** Number of parameters that can be set. */
+#define WP_ECDSA_PARAM_CNT              3
+
+/** Keys of parameters that can be set, in order of index. */
+static const char* const wp_ecdsa_param_keys[WP_ECDSA_PARAM_CNT] = {
+    OSSL_SIGNATURE_PARAM_DIGEST,
+    OSSL_SIGNATURE_PARAM_PROPERTIES,
+    WP_SIGNATURE_PARAM_BATCH_VERIFY,
+};
+
 /**
  * Sets the parameters to use into ECDSA signature context object.
  *
@@ -779,15 +889,17 @@ static int wp_ecdsa_set_digest(wp_EcdsaSigCtx *ctx, const OSSL_PARAM *p,
 static int wp_ecdsa_set_ctx_params(wp_EcdsaSigCtx *ctx, const OSSL_PARAM params[])
 {
     int ok = 1;
-    const OSSL_PARAM *p;
-    const OSSL_PARAM *propsParam;
+    const OSSL_PARAM *p[WP_ECDSA_PARAM_CNT];
 
     if (params != NULL) {
-        p = OSSL_PARAM_locate_const(params, OSSL_SIGNATURE_PARAM_DIGEST);
-        if (p != NULL) {
-            propsParam = OSSL_PARAM_locate_const(params,
-                OSSL_SIGNATURE_PARAM_PROPERTIES);
-            ok = wp_ecdsa_set_digest(ctx, p, propsParam);
+        wp_params_index(params, wp_ecdsa_param_keys, WP_ECDSA_PARAM_CNT, p);
+
+        if (p[WP_ECDSA_PARAM_DIGEST] != NULL) {
+            ok = wp_ecdsa_set_digest(ctx, p[WP_ECDSA_PARAM_DIGEST],
+                p[WP_ECDSA_PARAM_PROPERTIES]);
+        }
+        if (ok && (p[WP_ECDSA_PARAM_BATCH_VERIFY] != NULL)) {
+            ok = wp_ecdsa_batch_verify(ctx, p[WP_ECDSA_PARAM_BATCH_VERIFY]);
         }
     }
 
@@ -798,6 +910,7 @@ static int wp_ecdsa_set_ctx_params(wp_EcdsaSigCtx *ctx, const OSSL_PARAM params[
 static const OSSL_PARAM wp_settable_ctx_params[] = {
     OSSL_PARAM_utf8_string(OSSL_SIGNATURE_PARAM_DIGEST, NULL, 0),
     OSSL_PARAM_utf8_string(OSSL_SIGNATURE_PARAM_PROPERTIES, NULL, 0),
+    OSSL_PARAM_octet_string(WP_SIGNATURE_PARAM_BATCH_VERIFY, NULL, 0),
     OSSL_PARAM_END
 };
 /**
@@ -29,6 +29,14 @@
 #include <wolfprovider/alg_funcs.h>
 
 
+/** No KDF applied to derived secret. */
+#define WP_KDF_NONE             0
+/** HKDF-Extract applied to derived secret. */
+#define WP_KDF_HKDF_EXTRACT     2
+
+/** Largest secret of the alternative curves. */
+#define WP_ECX_MAX_SECRET_SIZE  CURVE448_KEY_SIZE
+
 /** Common key agree function pointer. */
 typedef int (*WP_ECX_AGREE)(void* private_key, void* public_key, byte* out,
     word32* outlen);
@@ -44,8 +52,25 @@ typedef struct wp_EcxCtx {
     wp_Ecx* key;
     /** Reference to peer's public key. */
     wp_Ecx* peer;
+
+    /** KDF type to apply to calculated secret. */
+    int kdfType;
+    /** Digest to use with KDF. */
+    enum wc_HashType kdfMd;
+    /** Salt for HKDF-Extract. */
+    unsigned char* salt;
+    /** Length of salt. */
+    size_t saltLen;
 } wp_EcxCtx;
 
+/** Derive the raw secret into a buffer of at least the secret size. */
+typedef int (*WP_ECX_DERIVE_SECRET)(wp_EcxCtx* ctx, unsigned char* secret,
+    size_t* secLen, size_t secSize);
+
+
+/* Prototype for init to call. */
+static int wp_ecx_set_ctx_params(wp_EcxCtx* ctx, const OSSL_PARAM params[]);
+
 
 /**
  * Create a new base alt ECDH key exchange context object.
@@ -78,6 +103,7 @@ static void wp_ecx_freectx(wp_EcxCtx* ctx)
     if (ctx != NULL) {
         wp_ecx_free(ctx->peer);
         wp_ecx_free(ctx->key);
+        OPENSSL_clear_free(ctx->salt, ctx->saltLen);
         OPENSSL_free(ctx);
     }
 }
@@ -112,6 +138,17 @@ static wp_EcxCtx* wp_ecx_dupctx(wp_EcxCtx* src)
         else {
             dst->peer = src->peer;
         }
+        if (ok && (src->salt != NULL) && (src->saltLen > 0)) {
+            dst->salt = OPENSSL_memdup(src->salt, src->saltLen);
+            if (dst->salt == NULL) {
+                ok = 0;
+            }
+        }
+        if (ok) {
+            dst->kdfType = src->kdfType;
+            dst->kdfMd   = src->kdfMd;
+            dst->saltLen = src->saltLen;
+        }
         if (!ok) {
             wp_ecx_free(src->key);
             OPENSSL_free(dst);
@@ -134,9 +171,6 @@ static int wp_ecx_init(wp_EcxCtx* ctx, wp_Ecx* ecx, const OSSL_PARAM params[])
 {
     int ok = 1;
 
-    /* No settable parameters. */
-    (void)params;
-
     if (!wolfssl_prov_is_running()) {
         ok = 0;
     }
@@ -149,6 +183,7 @@ static int wp_ecx_init(wp_EcxCtx* ctx, wp_Ecx* ecx, const OSSL_PARAM params[])
     }
     if (ok) {
         ctx->key = ecx;
+        ok = wp_ecx_set_ctx_params(ctx, params);
     }
 
     return ok;
@@ -185,6 +220,155 @@ static int wp_ecx_set_peer(wp_EcxCtx* ctx, wp_Ecx* peer)
     return ok;
 }
 
+/**
+ * Derive a secret/key using the curve's derivation function.
+ *
+ * Can put the secret through HKDF-Extract without an intermediate KDF object.
+ *
+ * @param [in]  ctx      ECX key exchange context object.
+ * @param [out] secret   Buffer to hold secret/key.
+ * @param [out] secLen   Length of secret/key data in bytes.
+ * @param [in]  secSize  Size of buffer in bytes.
+ * @param [in]  keySize  Size of secret of curve in bytes.
+ * @param [in]  derive   Function to derive raw secret with.
+ * @return 1 on success.
+ * @return 0 on failure.
+ */
+static int wp_ecx_derive(wp_EcxCtx* ctx, unsigned char* secret,
+    size_t* secLen, size_t secSize, size_t keySize,
+    WP_ECX_DERIVE_SECRET derive)
+{
+    int ok = 1;
+    int mdLen = 0;
+    unsigned char tmp[WP_ECX_MAX_SECRET_SIZE];
+    size_t tmpLen = 0;
+    word64 mStart = wp_metrics_start();
+
+    if (!wolfssl_prov_is_running()) {
+        ok = 0;
+    }
+    if (ok && (ctx->kdfType == WP_KDF_HKDF_EXTRACT)) {
+        mdLen = wc_HashGetDigestSize(ctx->kdfMd);
+        if (mdLen <= 0) {
+            ok = 0;
+        }
+    }
+
+    /* No output buffer, return secret size only. */
+    if (ok && (secret == NULL)) {
+        *secLen = (mdLen > 0) ? (size_t)mdLen : keySize;
+    }
+    else if (ok && (ctx->kdfType == WP_KDF_NONE)) {
+        ok = derive(ctx, secret, secLen, secSize);
+    }
+    else if (ok) {
+        if (secSize < (size_t)mdLen) {
+            ok = 0;
+        }
+        if (ok) {
+            ok = derive(ctx, tmp, &tmpLen, sizeof(tmp));
+        }
+        if (ok) {
+            int rc;
+
+            rc = wc_HKDF_Extract(ctx->kdfMd, ctx->salt, (word32)ctx->saltLen,
+                tmp, (word32)tmpLen, secret);
+            if (rc != 0) {
+                ok = 0;
+            }
+            else {
+                *secLen = mdLen;
+            }
+        }
+        OPENSSL_cleanse(tmp, sizeof(tmp));
+    }
+    if (ok && (secret != NULL)) {
+        wp_metrics_record(WP_METRIC_ECX_DERIVE, mStart, *secLen);
+    }
+
+    return ok;
+}
+
+/**
+ * Set the KDF parameters into the alt ECDH key exchange context object.
+ *
+ * @param [in, out] ctx     Alt ECDH key exchange context object.
+ * @param [in]      params  Array of parameters and values.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_ecx_set_ctx_params(wp_EcxCtx* ctx, const OSSL_PARAM params[])
+{
+    int ok = 1;
+    const char* kdf = NULL;
+    const char* mdName = NULL;
+    const char* mdProps = NULL;
+
+    if (params != NULL) {
+        if (!wp_params_get_utf8_string_ptr(params,
+                OSSL_EXCHANGE_PARAM_KDF_TYPE, &kdf)) {
+            ok = 0;
+        }
+        if (ok && (kdf != NULL)) {
+            if (kdf[0] == '\0') {
+                ctx->kdfType = WP_KDF_NONE;
+            }
+            else if (XSTRCMP(kdf, WP_EXCHANGE_KDF_NAME_HKDF_EXTRACT) == 0) {
+                ctx->kdfType = WP_KDF_HKDF_EXTRACT;
+            }
+            else {
+                ok = 0;
+            }
+        }
+        if (ok && (!wp_params_get_utf8_string_ptr(params,
+                OSSL_EXCHANGE_PARAM_KDF_DIGEST, &mdName))) {
+            ok = 0;
+        }
+        if (ok && (!wp_params_get_utf8_string_ptr(params,
+                OSSL_EXCHANGE_PARAM_KDF_DIGEST_PROPS, &mdProps))) {
+            ok = 0;
+        }
+        if (ok && (mdName != NULL)) {
+            ctx->kdfMd = wp_name_to_wc_hash_type(ctx->provCtx->libCtx, mdName,
+                mdProps);
+            if (ctx->kdfMd == WC_HASH_TYPE_NONE) {
+                ok = 0;
+            }
+        }
+        if (ok && (!wp_params_get_octet_string(params,
+                WP_EXCHANGE_PARAM_KDF_SALT, &ctx->salt, &ctx->saltLen, 1))) {
+            ok = 0;
+        }
+    }
+
+    return ok;
+}
+
+/**
+ * Return an array of supported settable parameters for the alt ECDH context.
+ *
+ * @param [in] ctx      Alt ECDH key exchange context object. Unused.
+ * @param [in] provCtx  Provider context object. Unused.
+ * @return  Array of parameters with data type.
+ */
+static const OSSL_PARAM* wp_ecx_settable_ctx_params(wp_EcxCtx* ctx,
+    WOLFPROV_CTX* provCtx)
+{
+    /**
+     * Supported settable parameters for alt ECDH key exchange context.
+     */
+    static const OSSL_PARAM wp_ecx_supported_settable_ctx_params[] = {
+        OSSL_PARAM_utf8_string(OSSL_EXCHANGE_PARAM_KDF_TYPE, NULL, 0),
+        OSSL_PARAM_utf8_string(OSSL_EXCHANGE_PARAM_KDF_DIGEST, NULL, 0),
+        OSSL_PARAM_utf8_string(OSSL_EXCHANGE_PARAM_KDF_DIGEST_PROPS, NULL, 0),
+        OSSL_PARAM_octet_string(WP_EXCHANGE_PARAM_KDF_SALT, NULL, 0),
+        OSSL_PARAM_END
+    };
+    (void)ctx;
+    (void)provCtx;
+    return wp_ecx_supported_settable_ctx_params;
+}
+
 /*
  * X25519
  */
@@ -198,71 +382,77 @@ const unsigned char wp_curve25519_order[] = {
 };
 
 /**
- * Derive a secret/key using X25519.
- *
- * Can put the secret through a KDF.
+ * Derive the secret using X25519.
  *
  * @param [in]  ctx      ECX key exchange context object.
- * @param [out] secert   Buffer to hold secret/key.
- * @param [out] secLen   Length of secret/key data in bytes.
+ * @param [out] secret   Buffer to hold secret.
+ * @param [out] secLen   Length of secret data in bytes.
  * @param [in]  secSize  Size of buffer in bytes.
  * @return 1 on success.
  * @return 0 on failure.
  */
-static int wp_x25519_derive(wp_EcxCtx* ctx, unsigned char* secret,
+static int wp_x25519_derive_secret(wp_EcxCtx* ctx, unsigned char* secret,
     size_t* secLen, size_t secSize)
 {
     int ok = 1;
+    int rc;
+    word32 len = secSize;
+    int i;
 
-    if (!wolfssl_prov_is_running()) {
+    rc = wc_curve25519_shared_secret(wp_ecx_get_key(ctx->key),
+        wp_ecx_get_key(ctx->peer), secret, &len);
+    if (rc != 0) {
         ok = 0;
     }
-
-    /* No output buffer, return secret size only. */
-    if (ok && (secret == NULL)) {
-        *secLen = CURVE25519_KEYSIZE;
-    }
-    else if (ok) {
-        int rc;
-        word32 len = secSize;
-        int i;
-
-        rc = wc_curve25519_shared_secret(wp_ecx_get_key(ctx->key),
-            wp_ecx_get_key(ctx->peer), secret, &len);
-        if (rc != 0) {
-            ok = 0;
-        }
-        if (ok) {
-            for (i = 0; i < CURVE25519_KEYSIZE; i++) {
-                if (secret[i] != wp_curve25519_order[i]) {
-                    break;
-                }
-            }
-            if ((i < CURVE25519_KEYSIZE) &&
-                (secret[i] > wp_curve25519_order[i])) {
-                int16_t carry = 0;
-                for (i = CURVE25519_KEYSIZE - 1; i >= 0; i--) {
-                    carry += secret[i];
-                    carry -= wp_curve25519_order[i];
-                    secret[i] = (unsigned char)carry;
-                    carry >>= 8;
-                }
+    if (ok) {
+        for (i = 0; i < CURVE25519_KEYSIZE; i++) {
+            if (secret[i] != wp_curve25519_order[i]) {
+                break;
             }
         }
-        if (ok) {
-            *secLen = len;
-            /* Switch endian. */
-            for (i = 0; i < (int)len / 2; i++) {
-                byte t = secret[i];
-                secret[i] = secret[len - 1 - i];
-                secret[len - 1 - i] = t;
+        if ((i < CURVE25519_KEYSIZE) &&
+            (secret[i] > wp_curve25519_order[i])) {
+            int16_t carry = 0;
+            for (i = CURVE25519_KEYSIZE - 1; i >= 0; i--) {
+                carry += secret[i];
+                carry -= wp_curve25519_order[i];
+                secret[i] = (unsigned char)carry;
+                carry >>= 8;
             }
         }
     }
+    if (ok) {
+        *secLen = len;
+        /* Switch endian. */
+        for (i = 0; i < (int)len / 2; i++) {
+            byte t = secret[i];
+            secret[i] = secret[len - 1 - i];
+            secret[len - 1 - i] = t;
+        }
+    }
 
     return ok;
 }
 
+/**
+ * Derive a secret/key using X25519.
+ *
+ * Can put the secret through a KDF.
+ *
+ * @param [in]  ctx      ECX key exchange context object.
+ * @param [out] secert   Buffer to hold secret/key.
+ * @param [out] secLen   Length of secret/key data in bytes.
+ * @param [in]  secSize  Size of buffer in bytes.
+ * @return 1 on success.
+ * @return 0 on failure.
+ */
+static int wp_x25519_derive(wp_EcxCtx* ctx, unsigned char* secret,
+    size_t* secLen, size_t secSize)
+{
+    return wp_ecx_derive(ctx, secret, secLen, secSize, CURVE25519_KEYSIZE,
+        wp_x25519_derive_secret);
+}
+
 /** Dispatch table for X25519 key exchange. */
 const OSSL_DISPATCH wp_x25519_keyexch_functions[] = {
     { OSSL_FUNC_KEYEXCH_NEWCTX,    (DFUNC)wp_ecx_newctx    },
@@ -271,6 +461,10 @@ const OSSL_DISPATCH wp_x25519_keyexch_functions[] = {
     { OSSL_FUNC_KEYEXCH_INIT,      (DFUNC)wp_ecx_init      },
     { OSSL_FUNC_KEYEXCH_DERIVE,    (DFUNC)wp_x25519_derive },
     { OSSL_FUNC_KEYEXCH_SET_PEER,  (DFUNC)wp_ecx_set_peer  },
+    { OSSL_FUNC_KEYEXCH_SET_CTX_PARAMS,
+                                   (DFUNC)wp_ecx_set_ctx_params },
+    { OSSL_FUNC_KEYEXCH_SETTABLE_CTX_PARAMS,
+                                   (DFUNC)wp_ecx_settable_ctx_params },
     { 0, NULL }
 };
 
@@ -279,55 +473,61 @@ const OSSL_DISPATCH wp_x25519_keyexch_functions[] = {
  */
 
 /**
- * Derive a secret/key using X448.
- *
- * Can put the secret through a KDF.
+ * Derive the secret using X448.
  *
  * @param [in]  ctx      ECX key exchange context object.
- * @param [out] secert   Buffer to hold secret/key.
- * @param [out] secLen   Length of secret/key data in bytes.
+ * @param [out] secret   Buffer to hold secret.
+ * @param [out] secLen   Length of secret data in bytes.
  * @param [in]  secSize  Size of buffer in bytes.
  * @return 1 on success.
  * @return 0 on failure.
  */
-static int wp_x448_derive(wp_EcxCtx* ctx, unsigned char* secret,
+static int wp_x448_derive_secret(wp_EcxCtx* ctx, unsigned char* secret,
     size_t* secLen, size_t secSize)
 {
     int ok = 1;
+    int rc;
+    word32 len = secSize;
 
-    if (!wolfssl_prov_is_running()) {
+    rc = wc_curve448_shared_secret(wp_ecx_get_key(ctx->key),
+        wp_ecx_get_key(ctx->peer), secret, &len);
+    if (rc != 0) {
         ok = 0;
     }
-
-    /* No output buffer, return secret size only. */
-    if (ok && (secret == NULL)) {
-        *secLen = CURVE448_KEY_SIZE;
-    }
-    else if (ok) {
-        int rc;
-        word32 len = secSize;
-
-        rc = wc_curve448_shared_secret(wp_ecx_get_key(ctx->key),
-            wp_ecx_get_key(ctx->peer), secret, &len);
-        if (rc != 0) {
-            ok = 0;
-        }
-        if (ok) {
-            word32 i;
-
-            *secLen = len;
-            /* Switch endian. */
-            for (i = 0; i < len / 2; i++) {
-                byte t = secret[i];
-                secret[i] = secret[len - 1 - i];
-                secret[len - 1 - i] = t;
-            }
+    if (ok) {
+        word32 i;
+
+        *secLen = len;
+        /* Switch endian. */
+        for (i = 0; i < len / 2; i++) {
+            byte t = secret[i];
+            secret[i] = secret[len - 1 - i];
+            secret[len - 1 - i] = t;
         }
     }
 
     return ok;
 }
 
+/**
+ * Derive a secret/key using X448.
+ *
+ * Can put the secret through a KDF.
+ *
+ * @param [in]  ctx      ECX key exchange context object.
+ * @param [out] secert   Buffer to hold secret/key.
+ * @param [out] secLen   Length of secret/key data in bytes.
+ * @param [in]  secSize  Size of buffer in bytes.
+ * @return 1 on success.
+ * @return 0 on failure.
+ */
+static int wp_x448_derive(wp_EcxCtx* ctx, unsigned char* secret,
+    size_t* secLen, size_t secSize)
+{
+    return wp_ecx_derive(ctx, secret, secLen, secSize, CURVE448_KEY_SIZE,
+        wp_x448_derive_secret);
+}
+
 /** Dispatch table for X448 key exchange. */
 const OSSL_DISPATCH wp_x448_keyexch_functions[] = {
     { OSSL_FUNC_KEYEXCH_NEWCTX,    (DFUNC)wp_ecx_newctx   },
@@ -336,6 +536,10 @@ const OSSL_DISPATCH wp_x448_keyexch_functions[] = {
     { OSSL_FUNC_KEYEXCH_INIT,      (DFUNC)wp_ecx_init     },
     { OSSL_FUNC_KEYEXCH_DERIVE,    (DFUNC)wp_x448_derive  },
     { OSSL_FUNC_KEYEXCH_SET_PEER,  (DFUNC)wp_ecx_set_peer },
+    { OSSL_FUNC_KEYEXCH_SET_CTX_PARAMS,
+                                   (DFUNC)wp_ecx_set_ctx_params },
+    { OSSL_FUNC_KEYEXCH_SETTABLE_CTX_PARAMS,
+                                   (DFUNC)wp_ecx_settable_ctx_params },
     { 0, NULL }
 };
 
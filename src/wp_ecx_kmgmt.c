@@ -121,12 +121,8 @@ struct wp_Ecx {
     /** Data including method table that operates on a wolfSSL key. */
     const wp_EcxData* data;
 
-#ifndef WP_SINGLE_THREADED
-    /** Mutex for reference count updating. */
-    wolfSSL_Mutex mutex;
-#endif
     /** Count of references to this object. */
-    int refCnt;
+    wp_RefCnt refCnt;
 
     /** Provider context - for duplicating key. */
     WOLFPROV_CTX* provCtx;
@@ -143,8 +139,6 @@ struct wp_Ecx {
  * ECX key generation context.
  */
 typedef struct wp_EcxGenCtx {
-    /** wolfSSL random number generator. */
-    WC_RNG rng;
     /** Data including method table that operates on a wolfSSL key. */
     const wp_EcxData* data;
 
@@ -176,24 +170,7 @@ static int wp_ecx_gen_set_params(wp_EcxGenCtx* ctx, const OSSL_PARAM params[]);
  */
 int wp_ecx_up_ref(wp_Ecx* ecx)
 {
-#ifndef WP_SINGLE_THREADED
-    int ok = 1;
-    int rc;
-
-    rc = wc_LockMutex(&ecx->mutex);
-    if (rc < 0) {
-        ok = 0;
-    }
-    if (ok) {
-        ecx->refCnt++;
-        wc_UnLockMutex(&ecx->mutex);
-    }
-
-    return ok;
-#else
-    ecx->refCnt++;
-    return 1;
-#endif
+    return wp_refcnt_up(&ecx->refCnt);
 }
 
 /**
@@ -231,19 +208,13 @@ static wp_Ecx* wp_ecx_new(WOLFPROV_CTX* provCtx, const wp_EcxData* data)
             ok = 0;
         }
 
-    #ifndef SINGLE_THREADED
-        if (ok) {
-            rc = wc_InitMutex(&ecx->mutex);
-            if (rc != 0) {
-                (*data->freeKey)(&ecx->key);
-                ok = 0;
-            }
+        if (ok && (!wp_refcnt_init(&ecx->refCnt))) {
+            (*data->freeKey)(&ecx->key);
+            ok = 0;
         }
-    #endif
 
         if (ok) {
             ecx->provCtx = provCtx;
-            ecx->refCnt  = 1;
             ecx->data    = data;
         }
 
@@ -265,23 +236,10 @@ static wp_Ecx* wp_ecx_new(WOLFPROV_CTX* provCtx, const wp_EcxData* data)
 void wp_ecx_free(wp_Ecx* ecx)
 {
     if (ecx != NULL) {
-        int cnt;
-    #ifndef WP_SINGLE_THREADED
-        int rc;
-
-        rc = wc_LockMutex(&ecx->mutex);
-        cnt = --ecx->refCnt;
-        if (rc == 0) {
-            wc_UnLockMutex(&ecx->mutex);
-        }
-    #else
-        cnt = --ecx->refCnt;
-    #endif
+        int cnt = wp_refcnt_down(&ecx->refCnt);
 
         if (cnt == 0) {
-    #ifndef WP_SINGLE_THREADED
-            wc_FreeMutex(&ecx->mutex);
-    #endif
+            wp_refcnt_free(&ecx->refCnt);
             (*ecx->data->freeKey)((void*)&ecx->key);
             OPENSSL_free(ecx);
         }
@@ -1051,21 +1009,13 @@ static wp_EcxGenCtx* wp_ecx_gen_init(WOLFPROV_CTX* provCtx,
         ctx = OPENSSL_zalloc(sizeof(*ctx));
     }
     if (ctx != NULL) {
-        int rc;
         int ok = 1;
 
-        rc = wc_InitRng(&ctx->rng);
-        if (rc != 0) {
+        ctx->provCtx = provCtx;
+        ctx->name = name;
+        if (!wp_ecx_gen_set_params(ctx, params)) {
             ok = 0;
         }
-        if (ok) {
-            ctx->provCtx = provCtx;
-            ctx->name = name;
-            if (!wp_ecx_gen_set_params(ctx, params)) {
-                wc_FreeRng(&ctx->rng);
-                ok = 0;
-            }
-        }
         if (ok) {
             ctx->selection = selection;
             ctx->data      = data;
@@ -1130,26 +1080,29 @@ static int wp_ecx_gen_set_params(wp_EcxGenCtx* ctx, const OSSL_PARAM params[])
 }
 
 /**
- * Generate ECX key pair using wolfSSL.
+ * Create an ECX key object and optionally generate a key pair.
  *
- * @param [in, out] ctx    ECX generation context object.
- * @param [in]      cb     Progress callback. Unused.
- * @param [in]      cbArg  Argument to pass to callback. Unused.
+ * Uses the calling thread's provider random number generator.
+ *
+ * @param [in] provCtx  Provider context.
+ * @param [in] data     wolfSSL data for curve.
+ * @param [in] keyPair  Whether to generate a key pair.
  * @return  NULL on failure.
  * @return  ECX key object on success.
  */
-static wp_Ecx* wp_ecx_gen(wp_EcxGenCtx* ctx, OSSL_CALLBACK* osslcb, void* cbarg)
+static wp_Ecx* wp_ecx_gen_key(WOLFPROV_CTX* provCtx, const wp_EcxData* data,
+    int keyPair)
 {
     wp_Ecx* ecx;
-    int keyPair = (ctx->selection & OSSL_KEYMGMT_SELECT_KEYPAIR) != 0;
 
-    (void)osslcb;
-    (void)cbarg;
-
-    ecx = wp_ecx_new(ctx->provCtx, ctx->data);
+    ecx = wp_ecx_new(provCtx, data);
     if ((ecx != NULL) && keyPair) {
-        int rc = (*ctx->data->makeKey)(&ctx->rng, ctx->data->len,
-            (void*)&ecx->key);
+        WC_RNG* rng = wp_provctx_get_rng(provCtx);
+        int rc = -1;
+
+        if (rng != NULL) {
+            rc = (*data->makeKey)(rng, data->len, (void*)&ecx->key);
+        }
         if (rc != 0) {
             wp_ecx_free(ecx);
             ecx = NULL;
@@ -1163,6 +1116,71 @@ static wp_Ecx* wp_ecx_gen(wp_EcxGenCtx* ctx, OSSL_CALLBACK* osslcb, void* cbarg)
     return ecx;
 }
 
+/**
+ * Generate an ECX key pair for the key pool.
+ *
+ * @param [in] provCtx  Provider context.
+ * @param [in] arg      wolfSSL data for curve.
+ * @return  NULL on failure.
+ * @return  ECX key object on success.
+ */
+static void* wp_ecx_pool_gen(WOLFPROV_CTX* provCtx, const void* arg)
+{
+    return wp_ecx_gen_key(provCtx, (const wp_EcxData*)arg, 1);
+}
+
+/**
+ * Dispose of an ECX key object from the key pool.
+ *
+ * @param [in, out] key  ECX key object.
+ */
+static void wp_ecx_pool_free(void* key)
+{
+    wp_ecx_free((wp_Ecx*)key);
+}
+
+/**
+ * Generate ECX key pair using wolfSSL.
+ *
+ * Takes a pre-generated X25519/X448 key pair from the key pool when
+ * available.
+ *
+ * @param [in, out] ctx    ECX generation context object.
+ * @param [in]      cb     Progress callback. Unused.
+ * @param [in]      cbArg  Argument to pass to callback. Unused.
+ * @return  NULL on failure.
+ * @return  ECX key object on success.
+ */
+static wp_Ecx* wp_ecx_gen(wp_EcxGenCtx* ctx, OSSL_CALLBACK* osslcb, void* cbarg)
+{
+    wp_Ecx* ecx = NULL;
+    int keyPair = (ctx->selection & OSSL_KEYMGMT_SELECT_KEYPAIR) != 0;
+    int id = -1;
+    word64 mStart = wp_metrics_start();
+
+    (void)osslcb;
+    (void)cbarg;
+
+    if (ctx->data->keyType == WP_KEY_TYPE_X25519) {
+        id = WP_KEY_POOL_X25519;
+    }
+    else if (ctx->data->keyType == WP_KEY_TYPE_X448) {
+        id = WP_KEY_POOL_X448;
+    }
+    if (keyPair && (id >= 0)) {
+        ecx = (wp_Ecx*)wp_key_pool_get(ctx->provCtx, id, wp_ecx_pool_gen,
+            wp_ecx_pool_free, ctx->data);
+    }
+    if (ecx == NULL) {
+        ecx = wp_ecx_gen_key(ctx->provCtx, ctx->data, keyPair);
+    }
+    if (ecx != NULL) {
+        wp_metrics_record(WP_METRIC_ECX_KEYGEN, mStart, 0);
+    }
+
+    return ecx;
+}
+
 /**
  * Dispose of the ECX generation context object.
  *
@@ -1170,7 +1188,6 @@ static wp_Ecx* wp_ecx_gen(wp_EcxGenCtx* ctx, OSSL_CALLBACK* osslcb, void* cbarg)
  */
 static void wp_ecx_gen_cleanup(wp_EcxGenCtx* ctx)
 {
-    wc_FreeRng(&ctx->rng);
     OPENSSL_free(ctx);
 }
 
@@ -1411,9 +1428,37 @@ static int wp_ed25519_export_public(ed25519_key* key, const byte* out,
     return ret;
 }
 
+/**
+ * Derive and set the Ed25519 public key from the private key when not set.
+ *
+ * Done once when the key is loaded so that signing and exporting the public
+ * key don't perform a scalar multiplication or modify a shared key.
+ *
+ * @param [in, out] key  wolfSSL Ed25519 key object.
+ * @return  0 on success.
+ * @return  -ve on failure.
+ */
+static int wp_ed25519_set_public(ed25519_key* key)
+{
+    int ret = 0;
+
+    if (!key->pubKeySet) {
+        unsigned char pubKey[ED25519_PUB_KEY_SIZE];
+
+        ret = wc_ed25519_make_public(key, pubKey, sizeof(pubKey));
+        if (ret == 0) {
+            ret = wc_ed25519_import_public(pubKey, sizeof(pubKey), key);
+        }
+    }
+
+    return ret;
+}
+
 /**
  * Import the Ed25519 private key.
  *
+ * Public key is derived from the private key.
+ *
  * @param [in]      in      Buffer holdnig DER encoded Ed25519 private key.
  * @param [in]      inLen   Length of data in bytes.
  * @param [in, out] key     wolfSSL Ed25519 key object.
@@ -1424,8 +1469,16 @@ static int wp_ed25519_export_public(ed25519_key* key, const byte* out,
 static int wp_ed25519_import_private(const byte* in, word32 inLen,
     ed25519_key* key, int endian)
 {
+    int ret;
+
     (void)endian;
-    return wc_ed25519_import_private_only(in, inLen, key);
+
+    ret = wc_ed25519_import_private_only(in, inLen, key);
+    if (ret == 0) {
+        ret = wp_ed25519_set_public(key);
+    }
+
+    return ret;
 }
 
 /** Ed25519 data and wolfSSL functions. */
@@ -1537,9 +1590,37 @@ static int wp_ed448_export_public(ed448_key* key, const byte* out,
     return ret;
 }
 
+/**
+ * Derive and set the Ed448 public key from the private key when not set.
+ *
+ * Done once when the key is loaded so that signing and exporting the public
+ * key don't perform a scalar multiplication or modify a shared key.
+ *
+ * @param [in, out] key  wolfSSL Ed448 key object.
+ * @return  0 on success.
+ * @return  -ve on failure.
+ */
+static int wp_ed448_set_public(ed448_key* key)
+{
+    int ret = 0;
+
+    if (!key->pubKeySet) {
+        unsigned char pubKey[ED448_PUB_KEY_SIZE];
+
+        ret = wc_ed448_make_public(key, pubKey, sizeof(pubKey));
+        if (ret == 0) {
+            ret = wc_ed448_import_public(pubKey, sizeof(pubKey), key);
+        }
+    }
+
+    return ret;
+}
+
 /**
  * Import the Ed448 private key.
  *
+ * Public key is derived from the private key.
+ *
  * @param [in]      in      Buffer holdnig DER encoded Ed448 private key.
  * @param [in]      inLen   Length of data in bytes.
  * @param [in, out] key     wolfSSL Ed448 key object.
@@ -1550,8 +1631,16 @@ static int wp_ed448_export_public(ed448_key* key, const byte* out,
 static int wp_ed448_import_private(const byte* in, word32 inLen,
     ed448_key* key, int endian)
 {
+    int ret;
+
     (void)endian;
-    return wc_ed448_import_private_only(in, inLen, key);
+
+    ret = wc_ed448_import_private_only(in, inLen, key);
+    if (ret == 0) {
+        ret = wp_ed448_set_public(key);
+    }
+
+    return ret;
 }
 
 /** Ed448 data and wolfSSL functions. */
@@ -2508,6 +2597,32 @@ const OSSL_DISPATCH wp_ed25519_spki_pem_encoder_functions[] = {
  * Ed25519 PrivateKeyInfo
  */
 
+/**
+ * Decode the Ed25519 private key.
+ *
+ * Public key is derived when not in encoding.
+ *
+ * @param [in]      input     Buffer holding Ed25519 private key data.
+ * @param [in, out] inOutIdx  On in, index into buffer of data.
+ *                            On out, index into buffer after data.
+ * @param [in, out] key       Ed25519 key object.
+ * @param [in]      inSz      Length of buffer in bytes.
+ * @return  0 on success.
+ * @return  -ve on failure.
+ */
+static int wp_ed25519_priv_decode(const byte* input, word32* inOutIdx,
+    ed25519_key* key, word32 inSz)
+{
+    int ret;
+
+    ret = wc_Ed25519PrivateKeyDecode(input, inOutIdx, key, inSz);
+    if (ret == 0) {
+        ret = wp_ed25519_set_public(key);
+    }
+
+    return ret;
+}
+
 /**
  * Create a new ECX encoder/decoder context that handles decoding PKI for
  * Ed25519 keys.
@@ -2519,7 +2634,7 @@ const OSSL_DISPATCH wp_ed25519_spki_pem_encoder_functions[] = {
 static wp_EcxEncDecCtx* wp_ed25519_pki_dec_new(WOLFPROV_CTX* provCtx)
 {
     return wp_ecx_enc_dec_new(provCtx, WP_KEY_TYPE_ED25519, WP_ENC_FORMAT_PKI,
-        0, (WP_ECX_DECODE)wc_Ed25519PrivateKeyDecode, NULL);
+        0, (WP_ECX_DECODE)wp_ed25519_priv_decode, NULL);
 }
 
 /**
@@ -2978,6 +3093,32 @@ const OSSL_DISPATCH wp_ed448_spki_pem_encoder_functions[] = {
  * Ed448 PrivateKeyInfo
  */
 
+/**
+ * Decode the Ed448 private key.
+ *
+ * Public key is derived when not in encoding.
+ *
+ * @param [in]      input     Buffer holding Ed448 private key data.
+ * @param [in, out] inOutIdx  On in, index into buffer of data.
+ *                            On out, index into buffer after data.
+ * @param [in, out] key       Ed448 key object.
+ * @param [in]      inSz      Length of buffer in bytes.
+ * @return  0 on success.
+ * @return  -ve on failure.
+ */
+static int wp_ed448_priv_decode(const byte* input, word32* inOutIdx,
+    ed448_key* key, word32 inSz)
+{
+    int ret;
+
+    ret = wc_Ed448PrivateKeyDecode(input, inOutIdx, key, inSz);
+    if (ret == 0) {
+        ret = wp_ed448_set_public(key);
+    }
+
+    return ret;
+}
+
 /**
  * Create a new ECX encoder/decoder context that handles decoding PKI for
  * Ed448 keys.
@@ -2989,7 +3130,7 @@ const OSSL_DISPATCH wp_ed448_spki_pem_encoder_functions[] = {
 static wp_EcxEncDecCtx* wp_ed448_pki_dec_new(WOLFPROV_CTX* provCtx)
 {
     return wp_ecx_enc_dec_new(provCtx, WP_KEY_TYPE_ED448, WP_ENC_FORMAT_PKI,
-        0, (WP_ECX_DECODE)wc_Ed448PrivateKeyDecode, NULL);
+        0, (WP_ECX_DECODE)wp_ed448_priv_decode, NULL);
 }
 
 /**
@@ -54,6 +54,11 @@ typedef struct wp_EcxSigCtx {
     char* propQuery;
     /** Name of hash algorithm. */
     char mdName[WP_MAX_MD_NAME_SIZE];
+
+    /** Bitmap of results of last batch verification. */
+    unsigned char* batchRes;
+    /** Length of batch verification results bitmap in bytes. */
+    size_t batchResLen;
 } wp_EcxSigCtx;
 
 
@@ -108,6 +113,7 @@ static void wp_ecx_freectx(wp_EcxSigCtx* ctx)
 {
     if (ctx != NULL) {
         wp_ecx_free(ctx->ecx);
+        OPENSSL_free(ctx->batchRes);
         OPENSSL_free(ctx->propQuery);
         OPENSSL_free(ctx);
     }
@@ -354,6 +360,14 @@ static int wp_ecx_get_ctx_params(wp_EcxSigCtx *ctx, OSSL_PARAM *params)
             ok = wp_ecx_get_alg_id(ctx, p);
         }
     }
+    if (ok) {
+        p = OSSL_PARAM_locate(params, WP_SIGNATURE_PARAM_BATCH_RESULT);
+        if ((p != NULL) && ((ctx->batchRes == NULL) ||
+                (!OSSL_PARAM_set_octet_string(p, ctx->batchRes,
+                    ctx->batchResLen)))) {
+            ok = 0;
+        }
+    }
 
     return ok;
 }
@@ -361,6 +375,7 @@ static int wp_ecx_get_ctx_params(wp_EcxSigCtx *ctx, OSSL_PARAM *params)
 /** Parameters that we support getting from the ECX signature context. */
 static const OSSL_PARAM wp_supported_gettable_ctx_params[] = {
     OSSL_PARAM_octet_string(OSSL_SIGNATURE_PARAM_ALGORITHM_ID, NULL, 0),
+    OSSL_PARAM_octet_string(WP_SIGNATURE_PARAM_BATCH_RESULT, NULL, 0),
     OSSL_PARAM_END
 };
 /**
@@ -378,6 +393,62 @@ static const OSSL_PARAM *wp_ecx_gettable_ctx_params(wp_EcxSigCtx *ctx,
     return wp_supported_gettable_ctx_params;
 }
 
+/**
+ * Sets the parameters to use into ECX signature context object.
+ *
+ * Batch verification data is a list of messages and signatures.
+ *
+ * @param [in, out] ctx     ECX signature context object.
+ * @param [in]      params  Array of parameter objects.
+ * @param [in]      verify  Function to verify one signature with the key.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_ecx_set_ctx_params(wp_EcxSigCtx *ctx, const OSSL_PARAM params[],
+    WP_BATCH_VERIFY_FN verify)
+{
+    int ok = 1;
+    const OSSL_PARAM *p = NULL;
+
+    if (params != NULL) {
+        p = OSSL_PARAM_locate_const(params, WP_SIGNATURE_PARAM_BATCH_VERIFY);
+    }
+    if (p != NULL) {
+        if ((ctx->op != EVP_PKEY_OP_VERIFY) || (ctx->ecx == NULL)) {
+            ok = 0;
+        }
+        if (ok && (p->data_type != OSSL_PARAM_OCTET_STRING)) {
+            ok = 0;
+        }
+        if (ok) {
+            ok = wp_batch_verify(ctx, verify, (const unsigned char*)p->data,
+                p->data_size, &ctx->batchRes, &ctx->batchResLen);
+        }
+    }
+
+    return ok;
+}
+
+/** Parameters that we support setting into the ECX signature context. */
+static const OSSL_PARAM wp_settable_ctx_params[] = {
+    OSSL_PARAM_octet_string(WP_SIGNATURE_PARAM_BATCH_VERIFY, NULL, 0),
+    OSSL_PARAM_END
+};
+/**
+ * Returns an array of ECX signature context parameters that can be set.
+ *
+ * @param [in] ctx      ECX signature context object. Unused.
+ * @param [in] provCtx  wolfProvider context object. Unused.
+ * @return  Array of parameters.
+ */
+static const OSSL_PARAM *wp_ecx_settable_ctx_params(wp_EcxSigCtx *ctx,
+    WOLFPROV_CTX *provCtx)
+{
+    (void)ctx;
+    (void)provCtx;
+    return wp_settable_ctx_params;
+}
+
 /*
  * Ed25519
  */
@@ -487,7 +558,7 @@ static int wp_ed25519_digest_verify(wp_EcxSigCtx *ctx, unsigned char *sig,
         }
     }
     if (ok) {
-        int res;
+        int res = 0;
         int rc = wc_ed25519_verify_msg(sig, sigLen, tbs, tbsLen, &res,
             wp_ecx_get_key(ctx->ecx));
         if (rc != 0) {
@@ -501,6 +572,39 @@ static int wp_ed25519_digest_verify(wp_EcxSigCtx *ctx, unsigned char *sig,
     return ok;
 }
 
+/**
+ * Verify one Ed25519 signature of a batch.
+ *
+ * @param [in, out] ctx     ECX signature context object.
+ * @param [in]      sig     Signature data.
+ * @param [in]      sigLen  Length of signature in bytes.
+ * @param [in]      tbs     Message that was signed.
+ * @param [in]      tbsLen  Length of message in bytes.
+ * @return  1 when signature verified.
+ * @return  0 otherwise.
+ */
+static int wp_ed25519_batch_verify_one(void* ctx, const unsigned char* sig,
+    size_t sigLen, const unsigned char* tbs, size_t tbsLen)
+{
+    /* Signature is only read. */
+    return wp_ed25519_digest_verify((wp_EcxSigCtx*)ctx, (unsigned char*)sig,
+        sigLen, tbs, tbsLen);
+}
+
+/**
+ * Sets the parameters to use into Ed25519 signature context object.
+ *
+ * @param [in, out] ctx     ECX signature context object.
+ * @param [in]      params  Array of parameter objects.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_ed25519_set_ctx_params(wp_EcxSigCtx *ctx,
+    const OSSL_PARAM params[])
+{
+    return wp_ecx_set_ctx_params(ctx, params, wp_ed25519_batch_verify_one);
+}
+
 /** Dspatch table for Ed25519 signing and verification. */
 const OSSL_DISPATCH wp_ed25519_signature_functions[] = {
     { OSSL_FUNC_SIGNATURE_NEWCTX,           (DFUNC)wp_ecx_newctx              },
@@ -514,6 +618,9 @@ const OSSL_DISPATCH wp_ed25519_signature_functions[] = {
     { OSSL_FUNC_SIGNATURE_GET_CTX_PARAMS,   (DFUNC)wp_ecx_get_ctx_params      },
     { OSSL_FUNC_SIGNATURE_GETTABLE_CTX_PARAMS,
                                             (DFUNC)wp_ecx_gettable_ctx_params },
+    { OSSL_FUNC_SIGNATURE_SET_CTX_PARAMS,   (DFUNC)wp_ed25519_set_ctx_params  },
+    { OSSL_FUNC_SIGNATURE_SETTABLE_CTX_PARAMS,
+                                            (DFUNC)wp_ecx_settable_ctx_params },
     { 0, NULL }
 };
 
@@ -629,7 +736,7 @@ static int wp_ed448_digest_verify(wp_EcxSigCtx *ctx, unsigned char *sig,
         }
     }
     if (ok) {
-        int res;
+        int res = 0;
         int rc = wc_ed448_verify_msg(sig, sigLen, tbs, tbsLen, &res,
             wp_ecx_get_key(ctx->ecx), NULL, 0);
         if (rc != 0) {
@@ -643,6 +750,39 @@ static int wp_ed448_digest_verify(wp_EcxSigCtx *ctx, unsigned char *sig,
     return ok;
 }
 
+/**
+ * Verify one Ed448 signature of a batch.
+ *
+ * @param [in, out] ctx     ECX signature context object.
+ * @param [in]      sig     Signature data.
+ * @param [in]      sigLen  Length of signature in bytes.
+ * @param [in]      tbs     Message that was signed.
+ * @param [in]      tbsLen  Length of message in bytes.
+ * @return  1 when signature verified.
+ * @return  0 otherwise.
+ */
+static int wp_ed448_batch_verify_one(void* ctx, const unsigned char* sig,
+    size_t sigLen, const unsigned char* tbs, size_t tbsLen)
+{
+    /* Signature is only read. */
+    return wp_ed448_digest_verify((wp_EcxSigCtx*)ctx, (unsigned char*)sig,
+        sigLen, tbs, tbsLen);
+}
+
+/**
+ * Sets the parameters to use into Ed448 signature context object.
+ *
+ * @param [in, out] ctx     ECX signature context object.
+ * @param [in]      params  Array of parameter objects.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_ed448_set_ctx_params(wp_EcxSigCtx *ctx,
+    const OSSL_PARAM params[])
+{
+    return wp_ecx_set_ctx_params(ctx, params, wp_ed448_batch_verify_one);
+}
+
 /** Dspatch table for Ed448 signing and verification. */
 const OSSL_DISPATCH wp_ed448_signature_functions[] = {
     { OSSL_FUNC_SIGNATURE_NEWCTX,           (DFUNC)wp_ecx_newctx              },
@@ -656,6 +796,9 @@ const OSSL_DISPATCH wp_ed448_signature_functions[] = {
     { OSSL_FUNC_SIGNATURE_GET_CTX_PARAMS,   (DFUNC)wp_ecx_get_ctx_params      },
     { OSSL_FUNC_SIGNATURE_GETTABLE_CTX_PARAMS,
                                             (DFUNC)wp_ecx_gettable_ctx_params },
+    { OSSL_FUNC_SIGNATURE_SET_CTX_PARAMS,   (DFUNC)wp_ed448_set_ctx_params    },
+    { OSSL_FUNC_SIGNATURE_SETTABLE_CTX_PARAMS,
+                                            (DFUNC)wp_ecx_settable_ctx_params },
     { 0, NULL }
 };
 
@@ -18,6 +18,11 @@
  * along with wolfProvider.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <stdio.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
 #include <openssl/err.h>
 #include <openssl/proverr.h>
 #include <openssl/core_dispatch.h>
@@ -28,10 +33,25 @@
 #include <openssl/evp.h>
 #include <openssl/store.h>
 #include <openssl/decoder.h>
+#include <openssl/x509.h>
 
 #include <wolfprovider/alg_funcs.h>
 
-/* TODO: support directory access. */
+/*
+ * A file is read into memory on the first load. Each load then decodes the
+ * next PEM block, so that bundles of many certificates return one object per
+ * load, or the whole file when it has no PEM blocks.
+ *
+ * A directory returns the path of one entry as a name object per load.
+ * The caller loads the entries it wants, as OpenSSL's file store does.
+ */
+
+/** PEM header start. */
+#define WP_PEM_BEGIN        "-----BEGIN "
+/** PEM footer start. */
+#define WP_PEM_END          "-----END "
+/** PEM header/footer end. */
+#define WP_PEM_DASHES       "-----"
 
 /**
  * File system context.
@@ -41,6 +61,23 @@ typedef struct wp_FileCtx {
     char* uri;
     /** BIO wrapping access to a file. */
     BIO* bio;
+    /** Data of file. */
+    unsigned char* data;
+    /** Length of data in bytes. */
+    word32 len;
+    /** Index of next object in data. */
+    word32 idx;
+    /** File data has been read. */
+    int read;
+
+    /** Directory being listed. NULL when a file. */
+    DIR* dir;
+    /** Path of directory. */
+    char* dirPath;
+    /** Name of next directory entry to return. NULL when no more. */
+    char* dirEnt;
+    /** Hash of subject that directory entry names must start with. */
+    char subjHash[9];
 
     /** Provider context - used to get library context. */
     WOLFPROV_CTX* provCtx;
@@ -56,6 +93,9 @@ typedef struct wp_FileCtx {
 } wp_FileCtx;
 
 
+/* Prototype for free to call. */
+static int wp_dec_cache_put(wp_FileCtx* ctx);
+
 /**
  * Create a new file system context object.
  *
@@ -83,15 +123,94 @@ static wp_FileCtx* wp_filectx_new(WOLFPROV_CTX* provCtx)
 static void wp_filectx_free(wp_FileCtx* ctx)
 {
     if (ctx != NULL) {
+        /* Keep decoder context for another file when caching. */
+        if (!wp_dec_cache_put(ctx)) {
+            OSSL_DECODER_CTX_free(ctx->decCtx);
+        }
         OPENSSL_free(ctx->format);
         OPENSSL_free(ctx->propQuery);
-        OSSL_DECODER_CTX_free(ctx->decCtx);
+        if (ctx->dir != NULL) {
+            closedir(ctx->dir);
+        }
+        OPENSSL_free(ctx->dirEnt);
+        OPENSSL_free(ctx->dirPath);
+        OPENSSL_free(ctx->data);
         BIO_free(ctx->bio);
         OPENSSL_free(ctx->uri);
         OPENSSL_free(ctx);
     }
 }
 
+/**
+ * Get the path from a URI.
+ *
+ * Supports plain paths, 'file:<path>' and 'file://[localhost]/<path>'.
+ *
+ * @param [in] uri  Uniform resource identifier.
+ * @return  Path in URI.
+ * @return  NULL when URI not supported.
+ */
+static const char* wp_file_uri_path(const char* uri)
+{
+    const char* path = uri;
+
+    if (XSTRNCMP(path, "file:", 5) == 0) {
+        path += 5;
+        if (XSTRNCMP(path, "//", 2) == 0) {
+            path += 2;
+            if (XSTRNCMP(path, "localhost/", 10) == 0) {
+                path += 9;
+            }
+            /* Only local absolute paths supported. */
+            if (path[0] != '/') {
+                path = NULL;
+            }
+        }
+    }
+
+    return path;
+}
+
+/**
+ * Move to the next entry of the directory that is to be returned.
+ *
+ * Skips '.' and '..' and, when a subject is set, entries whose names are
+ * not of the form <hash>.<n> or <hash>.r<n>.
+ *
+ * @param [in, out] ctx  File system context object.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_file_dir_next(wp_FileCtx* ctx)
+{
+    int ok = 1;
+    struct dirent* ent;
+    const char* name = NULL;
+
+    OPENSSL_free(ctx->dirEnt);
+    ctx->dirEnt = NULL;
+
+    while ((name == NULL) && ((ent = readdir(ctx->dir)) != NULL)) {
+        name = ent->d_name;
+        if ((XSTRCMP(name, ".") == 0) || (XSTRCMP(name, "..") == 0)) {
+            name = NULL;
+        }
+        else if ((ctx->subjHash[0] != '\0') &&
+                 ((XSTRNCMP(name, ctx->subjHash, 8) != 0) ||
+                  (name[8] != '.'))) {
+            name = NULL;
+        }
+    }
+    if (name != NULL) {
+        ctx->dirEnt = OPENSSL_strdup(name);
+        if (ctx->dirEnt == NULL) {
+            ok = 0;
+        }
+    }
+
+    return ok;
+}
+
 /**
  * Create a file system context object from a URI.
  *
@@ -107,15 +226,37 @@ static wp_FileCtx* wp_file_open(WOLFPROV_CTX* provCtx, const char* uri)
     ctx = wp_filectx_new(provCtx);
     if (ctx != NULL) {
         int ok = 1;
+        const char* path;
+        struct stat st;
 
-        /* TODO: support URI form 'file:'. */
         ctx->uri = OPENSSL_strdup(uri);
         if (ctx->uri == NULL) {
             ok = 0;
         }
         if (ok) {
+            path = wp_file_uri_path(uri);
+            if (path == NULL) {
+                ok = 0;
+            }
+        }
+        if (ok && (stat(path, &st) == 0) && S_ISDIR(st.st_mode)) {
+            ctx->dirPath = OPENSSL_strdup(path);
+            if (ctx->dirPath == NULL) {
+                ok = 0;
+            }
+            if (ok) {
+                ctx->dir = opendir(path);
+                if (ctx->dir == NULL) {
+                    ok = 0;
+                }
+            }
+            if (ok) {
+                ok = wp_file_dir_next(ctx);
+            }
+        }
+        else if (ok) {
             /* Create a BIO to access file. */
-            ctx->bio = BIO_new_file(uri, "rb");
+            ctx->bio = BIO_new_file(path, "rb");
             if (ctx->bio == NULL) {
                 ok = 0;
             }
@@ -186,6 +327,18 @@ static int wp_file_set_ctx_params(wp_FileCtx* ctx, const OSSL_PARAM params[])
     int ok = 1;
     const OSSL_PARAM *p;
 
+    if ((ctx->decCtx != NULL) &&
+            ((OSSL_PARAM_locate_const(params, OSSL_STORE_PARAM_PROPERTIES) !=
+              NULL) ||
+             (OSSL_PARAM_locate_const(params, OSSL_STORE_PARAM_INPUT_TYPE) !=
+              NULL) ||
+             (OSSL_PARAM_locate_const(params, OSSL_STORE_PARAM_EXPECT) !=
+              NULL))) {
+        /* Decoder context made for old settings. */
+        OSSL_DECODER_CTX_free(ctx->decCtx);
+        ctx->decCtx = NULL;
+    }
+
     p = OSSL_PARAM_locate_const(params, OSSL_STORE_PARAM_PROPERTIES);
     if (p != NULL) {
         OPENSSL_free(ctx->propQuery);
@@ -209,10 +362,46 @@ static int wp_file_set_ctx_params(wp_FileCtx* ctx, const OSSL_PARAM params[])
     }
     if (ok) {
         p = OSSL_PARAM_locate_const(params, OSSL_STORE_PARAM_SUBJECT);
-        if (p != NULL) {
-            /* TODO: only when a directory. */
+        /* Subject only used to select directory entries. */
+        if ((p != NULL) && (ctx->dir == NULL)) {
             ok = 0;
         }
+        else if (p != NULL) {
+            const unsigned char* der = NULL;
+            size_t derLen = 0;
+            X509_NAME* name = NULL;
+            unsigned long hash = 0;
+            int hashOk = 0;
+
+            if (!OSSL_PARAM_get_octet_string_ptr(p, (const void**)&der,
+                    &derLen)) {
+                ok = 0;
+            }
+            if (ok) {
+                name = d2i_X509_NAME(NULL, &der, (long)derLen);
+                if (name == NULL) {
+                    ok = 0;
+                }
+            }
+            if (ok) {
+                hash = X509_NAME_hash_ex(name, ctx->provCtx->libCtx,
+                    ctx->propQuery, &hashOk);
+                if (!hashOk) {
+                    ok = 0;
+                }
+            }
+            X509_NAME_free(name);
+            if (ok) {
+                XSNPRINTF(ctx->subjHash, sizeof(ctx->subjHash), "%08lx",
+                    hash & 0xffffffffUL);
+                /* Current entry may not match subject. */
+                if ((ctx->dirEnt != NULL) &&
+                    ((XSTRNCMP(ctx->dirEnt, ctx->subjHash, 8) != 0) ||
+                     (ctx->dirEnt[8] != '.'))) {
+                    ok = wp_file_dir_next(ctx);
+                }
+            }
+        }
     }
 
     return ok;
@@ -226,6 +415,8 @@ typedef struct wp_FileLoadData {
     OSSL_CALLBACK* cb;
     /** Callback argument. */
     void* cbArg;
+    /** Number of objects passed to callback. */
+    int cnt;
 } wp_FileLoadData;
 
 /**
@@ -241,6 +432,7 @@ static int wp_file_load_construct(OSSL_DECODER_INSTANCE* decoder,
    const OSSL_PARAM* params, wp_FileLoadData* data)
 {
     (void)decoder;
+    data->cnt++;
     return data->cb(params, data->cbArg);
 }
 
@@ -349,6 +541,250 @@ static int wp_file_set_decoder(wp_FileCtx* ctx, OSSL_DECODER_CTX* decCtx)
     return ok;
 }
 
+/** Maximum number of idle decoder contexts to cache. */
+#define WP_DEC_CACHE_MAX_SIZE   64
+
+/**
+ * Idle decoder context and the settings it was made for.
+ */
+typedef struct wp_DecCacheEntry {
+    /** Decoder context. NULL when entry unused. */
+    OSSL_DECODER_CTX* decCtx;
+    /** Type of data expected. */
+    int type;
+    /** Format of file data. May be NULL. */
+    char* format;
+    /** Properties query. May be NULL. */
+    char* propQuery;
+} wp_DecCacheEntry;
+
+/**
+ * Cache of idle decoder contexts.
+ *
+ * Setting up a decoder context fetches every decoder and builds the chains
+ * through all providers. Contexts of closed files are kept to be reused by
+ * later opens with the same settings.
+ */
+struct wp_DecCache {
+    /** Cached entries. */
+    wp_DecCacheEntry* entry;
+    /** Number of entries. */
+    int size;
+    /** Next entry to replace when full. */
+    int next;
+#ifndef WP_SINGLE_THREADED
+    /** Mutex protecting entries. */
+    pthread_mutex_t mutex;
+#endif
+};
+
+/**
+ * Create the decoder context cache.
+ *
+ * Cache is only created when size is not zero.
+ *
+ * @param [in, out] provCtx  Provider context.
+ * @param [in]      size     Number of decoder contexts to keep.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+int wp_dec_cache_init(WOLFPROV_CTX* provCtx, int size)
+{
+    int ok = 1;
+    wp_DecCache* cache = NULL;
+
+    if (size > 0) {
+        if (size > WP_DEC_CACHE_MAX_SIZE) {
+            size = WP_DEC_CACHE_MAX_SIZE;
+        }
+        cache = (wp_DecCache*)OPENSSL_zalloc(sizeof(*cache));
+        if (cache == NULL) {
+            ok = 0;
+        }
+    }
+    if (ok && (cache != NULL)) {
+        cache->entry = (wp_DecCacheEntry*)OPENSSL_zalloc(
+            size * sizeof(*cache->entry));
+        if (cache->entry == NULL) {
+            ok = 0;
+        }
+    }
+#ifndef WP_SINGLE_THREADED
+    if (ok && (cache != NULL) &&
+            (pthread_mutex_init(&cache->mutex, NULL) != 0)) {
+        ok = 0;
+    }
+#endif
+    if (ok && (cache != NULL)) {
+        cache->size = size;
+        provCtx->decCache = cache;
+    }
+    else if (cache != NULL) {
+        OPENSSL_free(cache->entry);
+        OPENSSL_free(cache);
+    }
+
+    return ok;
+}
+
+/**
+ * Dispose of the items of a decoder context cache entry.
+ *
+ * @param [in, out] entry  Cache entry.
+ */
+static void wp_dec_cache_entry_clear(wp_DecCacheEntry* entry)
+{
+    OSSL_DECODER_CTX_free(entry->decCtx);
+    OPENSSL_free(entry->format);
+    OPENSSL_free(entry->propQuery);
+    XMEMSET(entry, 0, sizeof(*entry));
+}
+
+/**
+ * Dispose of the decoder context cache and the decoder contexts in it.
+ *
+ * @param [in, out] provCtx  Provider context.
+ */
+void wp_dec_cache_free(WOLFPROV_CTX* provCtx)
+{
+    wp_DecCache* cache = provCtx->decCache;
+
+    if (cache != NULL) {
+        int i;
+
+        for (i = 0; i < cache->size; i++) {
+            wp_dec_cache_entry_clear(&cache->entry[i]);
+        }
+    #ifndef WP_SINGLE_THREADED
+        pthread_mutex_destroy(&cache->mutex);
+    #endif
+        OPENSSL_free(cache->entry);
+        OPENSSL_free(cache);
+        provCtx->decCache = NULL;
+    }
+}
+
+/**
+ * Compare optional strings.
+ *
+ * @param [in] a  String. May be NULL.
+ * @param [in] b  String. May be NULL.
+ * @return  1 when both NULL or the same.
+ * @return  0 otherwise.
+ */
+static int wp_dec_cache_str_eq(const char* a, const char* b)
+{
+    return ((a == NULL) && (b == NULL)) ||
+           ((a != NULL) && (b != NULL) && (XSTRCMP(a, b) == 0));
+}
+
+/**
+ * Take a decoder context made for the file's settings out of the cache.
+ *
+ * @param [in] ctx  File system context object.
+ * @return  Decoder context on success.
+ * @return  NULL when no cache or not found.
+ */
+static OSSL_DECODER_CTX* wp_dec_cache_get(wp_FileCtx* ctx)
+{
+    OSSL_DECODER_CTX* decCtx = NULL;
+    wp_DecCache* cache = ctx->provCtx->decCache;
+
+    if (cache != NULL) {
+        int i;
+
+    #ifndef WP_SINGLE_THREADED
+        pthread_mutex_lock(&cache->mutex);
+    #endif
+        for (i = 0; i < cache->size; i++) {
+            wp_DecCacheEntry* entry = &cache->entry[i];
+
+            if ((entry->decCtx != NULL) && (entry->type == ctx->type) &&
+                    wp_dec_cache_str_eq(entry->format, ctx->format) &&
+                    wp_dec_cache_str_eq(entry->propQuery, ctx->propQuery)) {
+                decCtx = entry->decCtx;
+                entry->decCtx = NULL;
+                wp_dec_cache_entry_clear(entry);
+                break;
+            }
+        }
+    #ifndef WP_SINGLE_THREADED
+        pthread_mutex_unlock(&cache->mutex);
+    #endif
+    }
+
+    return decCtx;
+}
+
+/**
+ * Put the file's decoder context into the cache for reuse.
+ *
+ * @param [in, out] ctx  File system context object.
+ * @return  1 when decoder context now owned by cache.
+ * @return  0 when caller must dispose of decoder context.
+ */
+static int wp_dec_cache_put(wp_FileCtx* ctx)
+{
+    int ok = 1;
+    wp_DecCache* cache = ctx->provCtx->decCache;
+    wp_DecCacheEntry entry;
+
+    XMEMSET(&entry, 0, sizeof(entry));
+    if ((cache == NULL) || (ctx->decCtx == NULL)) {
+        ok = 0;
+    }
+    if (ok && (ctx->format != NULL)) {
+        entry.format = OPENSSL_strdup(ctx->format);
+        if (entry.format == NULL) {
+            ok = 0;
+        }
+    }
+    if (ok && (ctx->propQuery != NULL)) {
+        entry.propQuery = OPENSSL_strdup(ctx->propQuery);
+        if (entry.propQuery == NULL) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        int i;
+        wp_DecCacheEntry old;
+
+        /* Don't keep references to callbacks of the closed file. */
+        OSSL_DECODER_CTX_set_construct_data(ctx->decCtx, NULL);
+        OSSL_DECODER_CTX_set_passphrase_cb(ctx->decCtx, NULL, NULL);
+        entry.decCtx = ctx->decCtx;
+        entry.type = ctx->type;
+
+    #ifndef WP_SINGLE_THREADED
+        pthread_mutex_lock(&cache->mutex);
+    #endif
+        /* Use an empty entry or replace the oldest. */
+        for (i = 0; i < cache->size; i++) {
+            if (cache->entry[i].decCtx == NULL) {
+                break;
+            }
+        }
+        if (i == cache->size) {
+            i = cache->next;
+            cache->next = (i + 1) % cache->size;
+        }
+        old = cache->entry[i];
+        cache->entry[i] = entry;
+    #ifndef WP_SINGLE_THREADED
+        pthread_mutex_unlock(&cache->mutex);
+    #endif
+        /* Free replaced entry outside of lock. */
+        wp_dec_cache_entry_clear(&old);
+        ctx->decCtx = NULL;
+    }
+    else {
+        OPENSSL_free(entry.propQuery);
+        OPENSSL_free(entry.format);
+    }
+
+    return ok;
+}
+
 /**
  * Setup a decoder with the decoders supported.
  *
@@ -356,7 +792,7 @@ static int wp_file_set_decoder(wp_FileCtx* ctx, OSSL_DECODER_CTX* decCtx)
  * @return  Decoder context object on success.
  * @return  NULL on failure.
  */
-static OSSL_DECODER_CTX* wp_file_setup_decoders(wp_FileCtx* ctx)
+static OSSL_DECODER_CTX* wp_file_new_decoders(wp_FileCtx* ctx)
 {
     int ok = 1;
     OSSL_DECODER_CTX* decCtx;
@@ -395,6 +831,160 @@ static OSSL_DECODER_CTX* wp_file_setup_decoders(wp_FileCtx* ctx)
     return decCtx;
 }
 
+/**
+ * Get a decoder context for the file - from the cache when available.
+ *
+ * @param [in, out] ctx  File system context object.
+ * @return  Decoder context object on success.
+ * @return  NULL on failure.
+ */
+static OSSL_DECODER_CTX* wp_file_setup_decoders(wp_FileCtx* ctx)
+{
+    OSSL_DECODER_CTX* decCtx;
+
+    decCtx = wp_dec_cache_get(ctx);
+    if (decCtx == NULL) {
+        decCtx = wp_file_new_decoders(ctx);
+    }
+
+    return decCtx;
+}
+
+/**
+ * Find a string in data.
+ *
+ * @param [in] data  Data to search.
+ * @param [in] len   Length of data in bytes.
+ * @param [in] str   String to find.
+ * @return  Index of string in data.
+ * @return  len when not found.
+ */
+static word32 wp_file_find(const unsigned char* data, word32 len,
+    const char* str)
+{
+    word32 i = 0;
+    word32 found = len;
+    word32 sLen = (word32)XSTRLEN(str);
+    const unsigned char* p;
+
+    while ((found == len) && (i + sLen <= len)) {
+        /* Jump to next possible start of string. */
+        p = (const unsigned char*)memchr(data + i, str[0], len - i);
+        if (p == NULL) {
+            break;
+        }
+        i = (word32)(p - data);
+        if ((i + sLen <= len) && (XMEMCMP(p, str, sLen) == 0)) {
+            found = i;
+        }
+        i++;
+    }
+
+    return found;
+}
+
+/**
+ * Find the end of the PEM block at the start of the data.
+ *
+ * @param [in] data  Data starting with a PEM header.
+ * @param [in] len   Length of data in bytes.
+ * @return  Index after the PEM footer line.
+ * @return  len when no footer.
+ */
+static word32 wp_file_pem_end(const unsigned char* data, word32 len)
+{
+    word32 idx;
+
+    idx = wp_file_find(data, len, WP_PEM_END);
+    if (idx < len) {
+        idx += (word32)XSTRLEN(WP_PEM_END);
+        idx += wp_file_find(data + idx, len - idx, WP_PEM_DASHES);
+    }
+    if (idx < len) {
+        idx += (word32)XSTRLEN(WP_PEM_DASHES);
+        while ((idx < len) && ((data[idx] == '\r') || (data[idx] == '\n'))) {
+            idx++;
+        }
+    }
+
+    return idx;
+}
+
+/**
+ * Get the next object to decode out of the file's data.
+ *
+ * @param [in, out] ctx    File system context object.
+ * @param [out]     start  Index of object in data.
+ * @param [out]     end    Index after object in data.
+ * @return  1 when an object is available.
+ * @return  0 when no more objects.
+ */
+static int wp_file_next_object(wp_FileCtx* ctx, word32* start, word32* end)
+{
+    int ret = 0;
+    word32 idx;
+
+    idx = ctx->idx + wp_file_find(ctx->data + ctx->idx, ctx->len - ctx->idx,
+        WP_PEM_BEGIN);
+    if (idx < ctx->len) {
+        *start = idx;
+        *end = idx + wp_file_pem_end(ctx->data + idx, ctx->len - idx);
+        ret = 1;
+    }
+    else if (ctx->idx == 0) {
+        /* No PEM blocks - decode all data, e.g. DER. */
+        *start = 0;
+        *end = ctx->len;
+        ret = 1;
+    }
+
+    return ret;
+}
+
+/**
+ * Load the next entry of a directory.
+ *
+ * The path of the entry is passed to the callback as a name object.
+ *
+ * @param [in, out] ctx       File system context object.
+ * @param [in]      objCb     Object callback.
+ * @param [in]      objCbArg  Argument ot pass to object callback.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_file_load_dir_entry(wp_FileCtx* ctx, OSSL_CALLBACK* objCb,
+    void* objCbArg)
+{
+    int ok = 1;
+    char* path = NULL;
+    size_t pathLen;
+    int objType = OSSL_OBJECT_NAME;
+    OSSL_PARAM params[3];
+
+    if (ctx->dirEnt != NULL) {
+        pathLen = XSTRLEN(ctx->dirPath) + 1 + XSTRLEN(ctx->dirEnt) + 1;
+        path = OPENSSL_malloc(pathLen);
+        if (path == NULL) {
+            ok = 0;
+        }
+        if (ok) {
+            XSNPRINTF(path, pathLen, "%s/%s", ctx->dirPath, ctx->dirEnt);
+            ok = wp_file_dir_next(ctx);
+        }
+        if (ok) {
+            params[0] = OSSL_PARAM_construct_int(OSSL_OBJECT_PARAM_TYPE,
+                &objType);
+            params[1] = OSSL_PARAM_construct_utf8_string(
+                OSSL_OBJECT_PARAM_DATA, path, 0);
+            params[2] = OSSL_PARAM_construct_end();
+            ok = objCb(params, objCbArg);
+        }
+        OPENSSL_free(path);
+    }
+
+    return ok;
+}
+
 /**
  * Load the data from a file.
  *
@@ -410,23 +1000,63 @@ static int wp_file_load(wp_FileCtx* ctx, OSSL_CALLBACK* objCb, void* objCbArg,
     OSSL_PASSPHRASE_CALLBACK* pwCb, void* pwCbArg)
 {
     int ok = 1;
+    int failed = 0;
+    word32 start = 0;
+    word32 end = 0;
+    BIO* bio;
+    wp_FileLoadData data = { objCb, objCbArg, 0 };
 
-    if (ctx->decCtx == NULL) {
-        ctx->decCtx = wp_file_setup_decoders(ctx);
+    if (ctx->dir != NULL) {
+        ok = wp_file_load_dir_entry(ctx, objCb, objCbArg);
     }
-    if (ctx->decCtx == NULL) {
-        ok = 0;
+    else if (!ctx->read) {
+        ctx->read = 1;
+        if (!wp_read_bio(ctx->bio, &ctx->data, &ctx->len)) {
+            ok = 0;
+        }
     }
-
-    if (ok) {
-        wp_FileLoadData data = { objCb, objCbArg };
-
+    if (ok && (ctx->dir == NULL) && (ctx->data != NULL) &&
+            (ctx->decCtx == NULL)) {
+        ctx->decCtx = wp_file_setup_decoders(ctx);
+        if (ctx->decCtx == NULL) {
+            ok = 0;
+        }
+    }
+    if (ok && (ctx->dir == NULL) && (ctx->data != NULL)) {
         OSSL_DECODER_CTX_set_construct_data(ctx->decCtx, &data);
         OSSL_DECODER_CTX_set_passphrase_cb(ctx->decCtx, pwCb, pwCbArg);
+    }
 
-        if (!OSSL_DECODER_from_bio(ctx->decCtx, ctx->bio)) {
+    /* Decode objects until one is passed to the callback. Objects that are
+     * not understood, like PEM parameters before a key, are skipped. */
+    while (ok && (ctx->dir == NULL) && (ctx->data != NULL) &&
+           (data.cnt == 0) && wp_file_next_object(ctx, &start, &end)) {
+        ctx->idx = end;
+        bio = BIO_new_mem_buf(ctx->data + start, (int)(end - start));
+        if (bio == NULL) {
             ok = 0;
         }
+        if (ok) {
+            ERR_set_mark();
+            failed = !OSSL_DECODER_from_bio(ctx->decCtx, bio);
+            if (failed && (data.cnt == 0) &&
+                    wp_file_next_object(ctx, &start, &end)) {
+                /* Try next object instead. */
+                ERR_pop_to_mark();
+            }
+            else {
+                ERR_clear_last_mark();
+            }
+        }
+        BIO_free(bio);
+    }
+    if (failed && (data.cnt == 0)) {
+        ok = 0;
+    }
+    if ((ctx->dir == NULL) && (ctx->data != NULL) &&
+            (!wp_file_next_object(ctx, &start, &end))) {
+        /* No more objects - at end of file. */
+        ctx->idx = ctx->len;
     }
 
     return ok;
@@ -441,7 +1071,19 @@ static int wp_file_load(wp_FileCtx* ctx, OSSL_CALLBACK* objCb, void* objCbArg,
  */
 static int wp_file_eof(wp_FileCtx* ctx)
 {
-    return BIO_eof(ctx->bio);
+    int eof;
+
+    if (ctx->dir != NULL) {
+        eof = (ctx->dirEnt == NULL);
+    }
+    else if (ctx->read) {
+        eof = (ctx->idx >= ctx->len);
+    }
+    else {
+        eof = BIO_eof(ctx->bio);
+    }
+
+    return eof;
 }
 
 /**
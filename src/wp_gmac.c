@@ -51,6 +51,8 @@ typedef struct wp_GmacCtx {
     unsigned char key[AES_256_KEY_SIZE];
     /** Length of private key in bytes. */
     size_t keyLen;
+    /** wolfSSL GMAC object has AES schedule and GHASH table for key. */
+    int keyExpanded;
 } wp_GmacCtx;
 
 
@@ -73,7 +75,7 @@ static wp_GmacCtx* wp_gmac_new(WOLFPROV_CTX* provCtx)
     (void)provCtx;
 
     if (wolfssl_prov_is_running()) {
-        macCtx = OPENSSL_zalloc(sizeof(*macCtx));
+        macCtx = wp_pool_zalloc(sizeof(*macCtx));
     }
 
     return macCtx;
@@ -92,7 +94,7 @@ static void wp_gmac_free(wp_GmacCtx* macCtx)
     if (macCtx != NULL) {
         OPENSSL_cleanse(macCtx->key, macCtx->keyLen);
         OPENSSL_clear_free(macCtx->data, macCtx->dataLen);
-        OPENSSL_free(macCtx);
+        wp_pool_clear_free(macCtx, sizeof(*macCtx));
     }
 }
 
@@ -100,6 +102,8 @@ static void wp_gmac_free(wp_GmacCtx* macCtx)
  * Set and cache the key into GMAC context object.
  *
  * Allocates space for the key in the wolfSSL GMAC object.
+ * Setting the same key again, as done for each message, keeps the expanded
+ * AES key and GHASH table rather than building them again.
  *
  * @param [in, out] macCtx   GMAC context object.
  * @param [in]      key      Key data to set.
@@ -116,12 +120,17 @@ static int wp_gmac_set_key(wp_GmacCtx* macCtx, const unsigned char *key,
     if (keyLen > AES_256_KEY_SIZE) {
         ok = 0;
     }
-    if (ok) {
+    if (ok && restart && macCtx->keyExpanded && (keyLen == macCtx->keyLen) &&
+            (CRYPTO_memcmp(key, macCtx->key, keyLen) == 0)) {
+        /* Key schedule and GHASH table already built for this key. */
+    }
+    else if (ok) {
         if (macCtx->keyLen > 0) {
             OPENSSL_cleanse(macCtx->key, macCtx->keyLen);
         }
         macCtx->keyLen = keyLen;
         XMEMCPY(macCtx->key, key, keyLen);
+        macCtx->keyExpanded = 0;
 
         if (restart) {
             int rc = wc_GmacSetKey(&macCtx->gmac, macCtx->key,
@@ -129,6 +138,9 @@ static int wp_gmac_set_key(wp_GmacCtx* macCtx, const unsigned char *key,
             if (rc != 0) {
                 ok = 0;
             }
+            else {
+                macCtx->keyExpanded = 1;
+            }
         }
     }
 
@@ -139,7 +151,8 @@ static int wp_gmac_set_key(wp_GmacCtx* macCtx, const unsigned char *key,
  * Duplicates an GMAC context object.
  *
  * Creates a new object and copies fields.
- * New memory is allocated for key.
+ * New memory is allocated for key. The expanded AES key and GHASH table are
+ * copied with the wolfSSL GMAC object.
  *
  * @param [in] src  GMAC context object to copy.
  * @return  New object on success.
@@ -166,6 +179,9 @@ static wp_GmacCtx* wp_gmac_dup(wp_GmacCtx* src)
             wp_gmac_free(dst);
             dst = NULL;
         }
+        if (dst != NULL) {
+            dst->keyExpanded = src->keyExpanded;
+        }
     }
 
     return dst;
@@ -39,6 +39,40 @@
         OSSL_PARAM_octet_string(OSSL_KDF_PARAM_KEY, NULL, 0),           \
         OSSL_PARAM_octet_string(OSSL_KDF_PARAM_SALT, NULL, 0)
 
+/** Index of digest in parameters set. */
+#define WP_HKDF_PARAM_DIGEST    0
+/** Index of mode in parameters set. */
+#define WP_HKDF_PARAM_MODE      1
+/** Index of key in parameters set. */
+#define WP_HKDF_PARAM_KEY       2
+/** Index of salt in parameters set. */
+#define WP_HKDF_PARAM_SALT      3
+/** Index of first info in parameters set. */
+#define WP_HKDF_PARAM_INFO      4
+/** Index of TLS 1.3 prefix in parameters set. */
+#define WP_HKDF_PARAM_PREFIX    5
+/** Index of TLS 1.3 label in parameters set. */
+#define WP_HKDF_PARAM_LABEL     6
+/** Index of TLS 1.3 data in parameters set. */
+#define WP_HKDF_PARAM_DATA      7
+/** Index of TLS 1.3 labels to expand in one request in parameters set. */
+#define WP_HKDF_PARAM_LABELS    8
+/** Number of parameters that can be set. */
+#define WP_HKDF_PARAM_CNT       9
+
+/** Keys of parameters that can be set, in order of index. */
+static const char* const wp_hkdf_param_keys[WP_HKDF_PARAM_CNT] = {
+    OSSL_KDF_PARAM_DIGEST,
+    OSSL_KDF_PARAM_MODE,
+    OSSL_KDF_PARAM_KEY,
+    OSSL_KDF_PARAM_SALT,
+    OSSL_KDF_PARAM_INFO,
+    OSSL_KDF_PARAM_PREFIX,
+    OSSL_KDF_PARAM_LABEL,
+    OSSL_KDF_PARAM_DATA,
+    WP_KDF_PARAM_TLS13_EXPAND_LABELS,
+};
+
 /** Max size of the info data to HKDF. */
 #define WP_MAX_INFO_SIZE    1024
 
@@ -81,6 +115,17 @@ typedef struct wp_HkdfCtx {
     unsigned char* data;
     /** Size of data in bytes. */
     size_t dataLen;
+    /** Labels to expand in one TLS 1.3 HKDF request. */
+    unsigned char* labels;
+    /** Size of labels in bytes. 0 when expanding label only. */
+    size_t labelsLen;
+
+    /** Pseudorandom key extracted from key and salt. */
+    unsigned char prk[WC_MAX_DIGEST_SIZE];
+    /** HMAC object to calculate on. Keyed with pseudorandom key. */
+    Hmac hmac;
+    /** Pseudorandom key is set for the current key, salt and digest. */
+    int prkSet;
 } wp_HkdfCtx;
 
 
@@ -103,6 +148,11 @@ static wp_HkdfCtx* wp_kdf_hkdf_new(WOLFPROV_CTX* provCtx)
     if (wolfssl_prov_is_running()) {
         ctx = OPENSSL_zalloc(sizeof(*ctx));
     }
+    if ((ctx != NULL) &&
+            (wc_HmacInit(&ctx->hmac, NULL, provCtx->devId) != 0)) {
+        OPENSSL_free(ctx);
+        ctx = NULL;
+    }
     if (ctx != NULL) {
         ctx->provCtx = provCtx;
     }
@@ -123,10 +173,13 @@ static void wp_kdf_hkdf_clear(wp_HkdfCtx* ctx)
     if (ctx->data != NULL) {
         OPENSSL_clear_free(ctx->data, ctx->dataLen);
     }
+    OPENSSL_free(ctx->labels);
     OPENSSL_free(ctx->label);
     OPENSSL_free(ctx->prefix);
     OPENSSL_free(ctx->salt);
     OPENSSL_cleanse(ctx->info, ctx->infoSz);
+    OPENSSL_cleanse(ctx->prk, sizeof(ctx->prk));
+    wc_HmacFree(&ctx->hmac);
 }
 
 /**
@@ -157,7 +210,105 @@ static void wp_kdf_hkdf_reset(wp_HkdfCtx* ctx)
         wp_kdf_hkdf_clear(ctx);
         XMEMSET(ctx, 0, sizeof(*ctx));
         ctx->provCtx = provCtx;
+        /* Initialization only records heap and device id. */
+        (void)wc_HmacInit(&ctx->hmac, NULL, provCtx->devId);
+    }
+}
+
+/**
+ * Set the pseudorandom key unless already set.
+ *
+ * Pseudorandom key is the key when expanding only, otherwise it is extracted
+ * from the key and salt. Extraction is done once - expansions of other info or
+ * labels with the same key and salt use the same pseudorandom key.
+ *
+ * @param [in, out] ctx  HKDF context object.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_hkdf_set_prk(wp_HkdfCtx* ctx)
+{
+    int ok = 1;
+    int rc;
+
+    if ((!ctx->prkSet) &&
+            (ctx->mode == EVP_KDF_HKDF_MODE_EXTRACT_AND_EXPAND)) {
+        rc = wc_HKDF_Extract(ctx->mdType, ctx->salt, (word32)ctx->saltSz,
+            ctx->key, (word32)ctx->keySz, ctx->prk);
+        if (rc != 0) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        ctx->prkSet = 1;
+    }
+
+    return ok;
+}
+
+/**
+ * HKDF-Expand of the info in the context with the pseudorandom key.
+ *
+ * See RFC 5869, Section 2.3.
+ *
+ * @param [in, out] ctx     HKDF context object.
+ * @param [out]     out     Buffer to hold output key material.
+ * @param [in]      outLen  Length of output in bytes.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_hkdf_expand_keyed(wp_HkdfCtx* ctx, unsigned char* out,
+    size_t outLen)
+{
+    int ok = 1;
+    int rc;
+    unsigned char t[WC_MAX_DIGEST_SIZE];
+    size_t tLen = 0;
+    byte cnt = 1;
+    unsigned char* prk = ctx->key;
+    size_t prkLen = ctx->keySz;
+
+    if (ctx->mode == EVP_KDF_HKDF_MODE_EXTRACT_AND_EXPAND) {
+        prk = ctx->prk;
+        prkLen = ctx->mdLen;
+    }
+    if (outLen > 255 * ctx->mdLen) {
+        ok = 0;
     }
+    while (ok && (outLen > 0)) {
+        size_t len = ctx->mdLen;
+
+        /* T(i) = HMAC(PRK, T(i-1) | info | i) */
+        rc = wc_HmacSetKey(&ctx->hmac, ctx->mdType, prk, (word32)prkLen);
+        if (rc == 0) {
+            rc = wc_HmacUpdate(&ctx->hmac, t, (word32)tLen);
+        }
+        if (rc == 0) {
+            rc = wc_HmacUpdate(&ctx->hmac, ctx->info, (word32)ctx->infoSz);
+        }
+        if (rc == 0) {
+            rc = wc_HmacUpdate(&ctx->hmac, &cnt, 1);
+        }
+        if (rc == 0) {
+            rc = wc_HmacFinal(&ctx->hmac, t);
+        }
+        if (rc != 0) {
+            ok = 0;
+        }
+        else {
+            if (len > outLen) {
+                len = outLen;
+            }
+            XMEMCPY(out, t, len);
+            out += len;
+            outLen -= len;
+            tLen = ctx->mdLen;
+            cnt++;
+        }
+    }
+
+    OPENSSL_cleanse(t, sizeof(t));
+    return ok;
 }
 
 /**
@@ -206,19 +357,13 @@ static int wp_kdf_hkdf_derive(wp_HkdfCtx* ctx, unsigned char* key,
             break;
 
         case EVP_KDF_HKDF_MODE_EXPAND_ONLY:
-            rc = wc_HKDF_Expand(ctx->mdType, ctx->key, (word32)ctx->keySz,
-                ctx->info, (word32)ctx->infoSz, key, (word32)keyLen);
-            if (rc != 0) {
-                ok = 0;
-            }
-            break;
-
         case EVP_KDF_HKDF_MODE_EXTRACT_AND_EXPAND:
         default:
-            rc = wc_HKDF(ctx->mdType, ctx->key, (word32)ctx->keySz, ctx->salt,
-                (word32)ctx->saltSz, ctx->info, (word32)ctx->infoSz, key,
-                (word32)keyLen);
-            if (rc != 0) {
+            /* Pseudorandom key kept for next derivation. */
+            if (!wp_hkdf_set_prk(ctx)) {
+                ok = 0;
+            }
+            if (ok && (!wp_hkdf_expand_keyed(ctx, key, keyLen))) {
                 ok = 0;
             }
             break;
@@ -278,32 +423,39 @@ static int wp_hkdf_base_get_mode(const OSSL_PARAM params[], int* mode)
 /**
  * Set the base HKDF context parameters.
  *
+ * Each parameter found by indexing is passed on in place of the array.
+ *
  * @param [in, out] ctx     HKDF context object.
  * @param [in]      params  Aray of parameters.
+ * @param [in]      p       Parameters found in array by index.
  * @return  1 on success.
  * @return  0 on failure.
  */
 static int wp_hkdf_base_set_ctx_params(wp_HkdfCtx* ctx,
-    const OSSL_PARAM params[])
+    const OSSL_PARAM params[], const OSSL_PARAM** p)
 {
     int ok = 1;
 
-    if (params != NULL) {
-        if (!wp_params_get_digest(params, NULL, ctx->provCtx->libCtx,
-                &ctx->mdType, &ctx->mdLen)) {
-            ok = 0;
-        }
-        if (ok && (!wp_hkdf_base_get_mode(params, &ctx->mode))) {
-            ok = 0;
-        }
-        if (ok && (!wp_params_get_octet_string(params, OSSL_KDF_PARAM_KEY,
-                &ctx->key, &ctx->keySz, 1))) {
-            ok = 0;
-        }
-        if (ok && (!wp_params_get_octet_string(params, OSSL_KDF_PARAM_SALT,
-                &ctx->salt, &ctx->saltSz, 0))) {
-            ok = 0;
-        }
+    /* New key, salt, digest or mode needs pseudorandom key set again. */
+    if ((p[WP_HKDF_PARAM_DIGEST] != NULL) || (p[WP_HKDF_PARAM_MODE] != NULL) ||
+            (p[WP_HKDF_PARAM_KEY] != NULL) || (p[WP_HKDF_PARAM_SALT] != NULL)) {
+        ctx->prkSet = 0;
+    }
+    /* Properties may be anywhere in array. */
+    if ((p[WP_HKDF_PARAM_DIGEST] != NULL) && (!wp_params_get_digest(params,
+            NULL, ctx->provCtx->libCtx, &ctx->mdType, &ctx->mdLen))) {
+        ok = 0;
+    }
+    if (ok && (!wp_hkdf_base_get_mode(p[WP_HKDF_PARAM_MODE], &ctx->mode))) {
+        ok = 0;
+    }
+    if (ok && (!wp_params_get_octet_string(p[WP_HKDF_PARAM_KEY],
+            OSSL_KDF_PARAM_KEY, &ctx->key, &ctx->keySz, 1))) {
+        ok = 0;
+    }
+    if (ok && (!wp_params_get_octet_string(p[WP_HKDF_PARAM_SALT],
+            OSSL_KDF_PARAM_SALT, &ctx->salt, &ctx->saltSz, 0))) {
+        ok = 0;
     }
 
     return ok;
@@ -387,12 +539,16 @@ static int wp_kdf_hkdf_set_ctx_params(wp_HkdfCtx* ctx,
     const OSSL_PARAM params[])
 {
     int ok = 1;
+    const OSSL_PARAM* p[WP_HKDF_PARAM_CNT];
 
     if (params != NULL) {
-        if (!wp_hkdf_base_set_ctx_params(ctx, params)) {
+        wp_params_index(params, wp_hkdf_param_keys, WP_HKDF_PARAM_CNT, p);
+
+        if (!wp_hkdf_base_set_ctx_params(ctx, params, p)) {
             ok = 0;
         }
-        if (ok && (!wp_hkdf_base_set_info(ctx, params))) {
+        /* Info parameters are combined from the first one on. */
+        if (ok && (!wp_hkdf_base_set_info(ctx, p[WP_HKDF_PARAM_INFO]))) {
             ok = 0;
         }
     }
@@ -467,6 +623,54 @@ const OSSL_DISPATCH wp_kdf_hkdf_functions[] = {
 static int wp_kdf_tls1_3_set_ctx_params(wp_HkdfCtx* ctx,
     const OSSL_PARAM params[]);
 
+/**
+ * Construct TLS 1.3 HkdfLabel into the info field of the context.
+ *
+ * Prefix from the context is used.
+ *
+ * @param [in, out] ctx       HKDF context object.
+ * @param [in]      label     Label without prefix.
+ * @param [in]      labelLen  Length of label in bytes.
+ * @param [in]      data      Context data. May be NULL when dataLen is 0.
+ * @param [in]      dataLen   Length of data in bytes.
+ * @param [in]      keyLen    Length of output key in bytes.
+ * @return  1 on success.
+ * @return  0 when prefix and label or data too long.
+ */
+static int wp_tls13_hkdf_info(wp_HkdfCtx* ctx, const unsigned char* label,
+    size_t labelLen, const unsigned char* data, size_t dataLen, size_t keyLen)
+{
+    int ok = 1;
+    size_t idx = 0;
+
+    if ((ctx->prefixLen + labelLen > 255) || (dataLen > 255)) {
+        ok = 0;
+    }
+    if (ok) {
+        /* Construct info to expand from:
+         *  - output key length
+         *  - label
+         *  - prefix/protocol
+         *  - data
+         */
+        ctx->info[idx++] = (byte)(keyLen >> 8);
+        ctx->info[idx++] = (byte)keyLen;
+        ctx->info[idx++] = (byte)(ctx->prefixLen + labelLen);
+        XMEMCPY(ctx->info + idx, ctx->prefix, ctx->prefixLen);
+        idx += ctx->prefixLen;
+        XMEMCPY(ctx->info + idx, label, labelLen);
+        idx += labelLen;
+        ctx->info[idx++] = (byte)(dataLen);
+        if (dataLen > 0) {
+            XMEMCPY(ctx->info + idx, data, dataLen);
+            idx += dataLen;
+        }
+        ctx->infoSz = idx;
+    }
+
+    return ok;
+}
+
 /**
  * TLS 1.3 HKDF expansion.
  *
@@ -489,35 +693,83 @@ static int wp_tls13_hkdf_expand(wp_HkdfCtx* ctx, unsigned char* inKey,
     size_t inKeyLen, unsigned char* data, size_t dataLen, unsigned char* key,
     size_t keyLen)
 {
-    int ok = 1;
-    size_t idx = 0;
+    int ok;
     int rc;
 
-    /* Construct info to expand from:
-     *  - output key length
-     *  - label
-     *  - prefix/protocol
-     *  - data
-     */
-    ctx->info[idx++] = (byte)(keyLen >> 8);
-    ctx->info[idx++] = (byte)keyLen;
-    ctx->info[idx++] = (byte)(ctx->prefixLen + ctx->labelLen);
-    XMEMCPY(ctx->info + idx, ctx->prefix, ctx->prefixLen);
-    idx += ctx->prefixLen;
-    XMEMCPY(ctx->info + idx, ctx->label, ctx->labelLen);
-    idx += ctx->labelLen;
-    ctx->info[idx++] = (byte)(dataLen);
-    if (dataLen > 0) {
-        XMEMCPY(ctx->info + idx, data, dataLen);
-        idx += dataLen;
+    ok = wp_tls13_hkdf_info(ctx, ctx->label, ctx->labelLen, data, dataLen,
+        keyLen);
+    if (ok) {
+        rc = wc_HKDF_Expand(ctx->mdType, inKey, (word32)inKeyLen, ctx->info,
+            (word32)ctx->infoSz, key, keyLen);
+        if (rc != 0) {
+            ok = 0;
+        }
     }
-    ctx->infoSz = idx;
 
-    rc = wc_HKDF_Expand(ctx->mdType, inKey, (word32)inKeyLen, ctx->info,
-        (word32)ctx->infoSz, key, keyLen);
-    if (rc != 0) {
+    return ok;
+}
+
+/**
+ * TLS 1.3 HKDF-Expand-Label of one or more labels with the key.
+ *
+ * Each label is expanded with the key, e.g. the key, iv, hp and ku labels of
+ * a QUIC secret.
+ * When labels are set, output is the expansion of each in turn and its length
+ * must be the sum of the lengths of the labels' outputs.
+ *
+ * @param [in, out] ctx     HKDF context object.
+ * @param [out]     key     Buffer to hold output key
+ * @param [in]      keyLen  Size of buffer in bytes.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_tls13_hkdf_expand_labels(wp_HkdfCtx* ctx, unsigned char* key,
+    size_t keyLen)
+{
+    int ok = 1;
+    size_t idx = 0;
+
+    if ((ctx->key == NULL) || (!wp_hkdf_set_prk(ctx))) {
         ok = 0;
     }
+    if (ok && (ctx->labelsLen == 0)) {
+        ok = wp_tls13_hkdf_info(ctx, ctx->label, ctx->labelLen, ctx->data,
+                 ctx->dataLen, keyLen) &&
+             wp_hkdf_expand_keyed(ctx, key, keyLen);
+    }
+    else if (ok) {
+        /* Each item: 2 byte output length, 1 byte label length and label. */
+        while (ok && (idx < ctx->labelsLen)) {
+            size_t outLen;
+            size_t labelLen;
+
+            if (ctx->labelsLen - idx < 3) {
+                ok = 0;
+            }
+            if (ok) {
+                outLen = ((size_t)ctx->labels[idx] << 8) |
+                         ctx->labels[idx + 1];
+                labelLen = ctx->labels[idx + 2];
+                idx += 3;
+                if ((ctx->labelsLen - idx < labelLen) || (outLen > keyLen)) {
+                    ok = 0;
+                }
+            }
+            if (ok) {
+                ok = wp_tls13_hkdf_info(ctx, ctx->labels + idx, labelLen,
+                         ctx->data, ctx->dataLen, outLen) &&
+                     wp_hkdf_expand_keyed(ctx, key, outLen);
+            }
+            if (ok) {
+                idx += labelLen;
+                key += outLen;
+                keyLen -= outLen;
+            }
+        }
+        if (ok && (keyLen != 0)) {
+            ok = 0;
+        }
+    }
 
     return ok;
 }
@@ -610,8 +862,7 @@ static int wp_kdf_tls1_3_derive(wp_HkdfCtx* ctx, unsigned char* key,
             }
         }
         else if (ctx->mode == EVP_KDF_HKDF_MODE_EXPAND_ONLY) {
-            if (!wp_tls13_hkdf_expand(ctx, ctx->key, ctx->keySz, ctx->data,
-                    ctx->dataLen, key, keyLen)) {
+            if (!wp_tls13_hkdf_expand_labels(ctx, key, keyLen)) {
                 ok = 0;
             }
         }
@@ -632,24 +883,32 @@ static int wp_kdf_tls1_3_set_ctx_params(wp_HkdfCtx* ctx,
     const OSSL_PARAM params[])
 {
     int ok = 1;
+    const OSSL_PARAM* p[WP_HKDF_PARAM_CNT];
 
     if (params != NULL) {
-        if (!wp_hkdf_base_set_ctx_params(ctx, params)) {
+        wp_params_index(params, wp_hkdf_param_keys, WP_HKDF_PARAM_CNT, p);
+
+        if (!wp_hkdf_base_set_ctx_params(ctx, params, p)) {
             ok = 0;
         }
         if (ok && (ctx->mode == EVP_KDF_HKDF_MODE_EXTRACT_AND_EXPAND)) {
             ok = 0;
         }
-        if (ok && (!wp_params_get_octet_string(params, OSSL_KDF_PARAM_PREFIX,
-                &ctx->prefix, &ctx->prefixLen, 0))) {
+        if (ok && (!wp_params_get_octet_string(p[WP_HKDF_PARAM_PREFIX],
+                OSSL_KDF_PARAM_PREFIX, &ctx->prefix, &ctx->prefixLen, 0))) {
+            ok = 0;
+        }
+        if (ok && (!wp_params_get_octet_string(p[WP_HKDF_PARAM_LABEL],
+                OSSL_KDF_PARAM_LABEL, &ctx->label, &ctx->labelLen, 0))) {
             ok = 0;
         }
-        if (ok && (!wp_params_get_octet_string(params, OSSL_KDF_PARAM_LABEL,
-                &ctx->label, &ctx->labelLen, 0))) {
+        if (ok && (!wp_params_get_octet_string(p[WP_HKDF_PARAM_DATA],
+                OSSL_KDF_PARAM_DATA, &ctx->data, &ctx->dataLen, 0))) {
             ok = 0;
         }
-        if (ok && (!wp_params_get_octet_string(params, OSSL_KDF_PARAM_DATA,
-                &ctx->data, &ctx->dataLen, 0))) {
+        if (ok && (!wp_params_get_octet_string(p[WP_HKDF_PARAM_LABELS],
+                WP_KDF_PARAM_TLS13_EXPAND_LABELS, &ctx->labels,
+                &ctx->labelsLen, 0))) {
             ok = 0;
         }
     }
@@ -673,6 +932,7 @@ static const OSSL_PARAM* wp_kdf_tls1_3_settable_ctx_params(wp_HkdfCtx* ctx,
         OSSL_PARAM_octet_string(OSSL_KDF_PARAM_PREFIX, NULL, 0),
         OSSL_PARAM_octet_string(OSSL_KDF_PARAM_LABEL, NULL, 0),
         OSSL_PARAM_octet_string(OSSL_KDF_PARAM_DATA, NULL, 0),
+        OSSL_PARAM_octet_string(WP_KDF_PARAM_TLS13_EXPAND_LABELS, NULL, 0),
         OSSL_PARAM_END
     };
     (void)ctx;
@@ -696,3 +956,592 @@ const OSSL_DISPATCH wp_kdf_tls1_3_kdf_functions[] = {
 };
 
 
+
+
+/*
+ * TLS 1.3 key schedule
+ */
+
+/** Default prefix of TLS 1.3 HKDF labels. */
+#define WP_TLS13_KS_PREFIX          "tls13 "
+/** Default length of traffic IVs in bytes. */
+#define WP_TLS13_KS_IV_LEN          12
+/** Maximum length of prefix and label in TLS 1.3 HKDF labels. */
+#define WP_TLS13_KS_MAX_LABEL_LEN   255
+
+/**
+ * The TLS 1.3 key schedule context structure.
+ */
+typedef struct wp_Tls13KsCtx {
+    /** wolfSSL provider context. */
+    WOLFPROV_CTX* provCtx;
+
+    /** Digest to use with HKDF. */
+    enum wc_HashType mdType;
+    /** Size of digest in bytes. */
+    size_t mdLen;
+    /** (EC)DHE shared secret. */
+    unsigned char* key;
+    /** Size of (EC)DHE shared secret in bytes. */
+    size_t keySz;
+    /** Pre-shared key. */
+    unsigned char* psk;
+    /** Size of pre-shared key in bytes. */
+    size_t pskSz;
+    /** Prefix of labels. */
+    unsigned char* prefix;
+    /** Size of prefix in bytes. */
+    size_t prefixLen;
+    /** Transcript hash of ClientHello..ServerHello. */
+    unsigned char hsHash[WC_MAX_DIGEST_SIZE];
+    /** Size of handshake transcript hash in bytes. */
+    size_t hsHashLen;
+    /** Transcript hash of ClientHello..server Finished. */
+    unsigned char appHash[WC_MAX_DIGEST_SIZE];
+    /** Size of application transcript hash in bytes. 0 when not set. */
+    size_t appHashLen;
+    /** Length of traffic keys in bytes. 0 when not expanded. */
+    size_t trafficKeyLen;
+    /** Length of traffic IVs in bytes. */
+    size_t trafficIvLen;
+
+    /** HMAC object to calculate on. Keyed with secret for each label. */
+    Hmac hmac;
+} wp_Tls13KsCtx;
+
+
+/** Prototyped for the derive function.  */
+static int wp_kdf_tls13_ks_set_ctx_params(wp_Tls13KsCtx* ctx,
+    const OSSL_PARAM params[]);
+
+
+/**
+ * Create a new TLS 1.3 key schedule context object.
+ *
+ * @param [in] provCtx  wolfProvider context object.
+ * @return  NULL on failure.
+ * @return  TLS 1.3 key schedule context object.
+ */
+static wp_Tls13KsCtx* wp_kdf_tls13_ks_new(WOLFPROV_CTX* provCtx)
+{
+    wp_Tls13KsCtx* ctx = NULL;
+
+    if (wolfssl_prov_is_running()) {
+        ctx = OPENSSL_zalloc(sizeof(*ctx));
+    }
+    if ((ctx != NULL) &&
+            (wc_HmacInit(&ctx->hmac, NULL, provCtx->devId) != 0)) {
+        OPENSSL_free(ctx);
+        ctx = NULL;
+    }
+    if (ctx != NULL) {
+        ctx->provCtx = provCtx;
+        ctx->trafficIvLen = WP_TLS13_KS_IV_LEN;
+    }
+
+    return ctx;
+}
+
+/**
+ * Dispose of data in TLS 1.3 key schedule context object.
+ *
+ * @param [in, out] ctx  TLS 1.3 key schedule context object.
+ */
+static void wp_kdf_tls13_ks_clear(wp_Tls13KsCtx* ctx)
+{
+    OPENSSL_clear_free(ctx->key, ctx->keySz);
+    OPENSSL_clear_free(ctx->psk, ctx->pskSz);
+    OPENSSL_free(ctx->prefix);
+    ctx->key = NULL;
+    ctx->keySz = 0;
+    ctx->psk = NULL;
+    ctx->pskSz = 0;
+    ctx->prefix = NULL;
+    ctx->prefixLen = 0;
+    ctx->hsHashLen = 0;
+    ctx->appHashLen = 0;
+    ctx->trafficKeyLen = 0;
+    ctx->trafficIvLen = WP_TLS13_KS_IV_LEN;
+}
+
+/**
+ * Dispose of a TLS 1.3 key schedule context object.
+ *
+ * @param [in, out] ctx  TLS 1.3 key schedule context object.
+ */
+static void wp_kdf_tls13_ks_free(wp_Tls13KsCtx* ctx)
+{
+    if (ctx != NULL) {
+        wp_kdf_tls13_ks_clear(ctx);
+        wc_HmacFree(&ctx->hmac);
+        OPENSSL_clear_free(ctx, sizeof(*ctx));
+    }
+}
+
+/**
+ * Reset TLS 1.3 key schedule context object.
+ *
+ * Disposes of allocated data.
+ *
+ * @param [in, out] ctx  TLS 1.3 key schedule context object.
+ */
+static void wp_kdf_tls13_ks_reset(wp_Tls13KsCtx* ctx)
+{
+    if (ctx != NULL) {
+        wp_kdf_tls13_ks_clear(ctx);
+    }
+}
+
+/**
+ * Get the length of the output of the key schedule.
+ *
+ * Output is, for each of client and server, the handshake traffic secret,
+ * finished key and, when key length set, the handshake traffic key and IV.
+ * With application transcript hash this is followed by the master secret,
+ * for each of client and server the application traffic secret and, when key
+ * length set, the application traffic key and IV, and then the exporter
+ * master secret.
+ *
+ * @param [in] ctx  TLS 1.3 key schedule context object.
+ * @return  Length of output in bytes.
+ */
+static size_t wp_kdf_tls13_ks_size(wp_Tls13KsCtx* ctx)
+{
+    size_t keyIvLen = 0;
+    size_t sz;
+
+    if (ctx->trafficKeyLen > 0) {
+        keyIvLen = ctx->trafficKeyLen + ctx->trafficIvLen;
+    }
+    sz = 2 * (2 * ctx->mdLen + keyIvLen);
+    if (ctx->appHashLen > 0) {
+        sz += 2 * ctx->mdLen + 2 * (ctx->mdLen + keyIvLen);
+    }
+
+    return sz;
+}
+
+/**
+ * TLS 1.3 HKDF-Expand-Label of a secret.
+ *
+ * Output is no longer than the digest so only one HMAC block is needed.
+ *
+ * @param [in, out] ctx      TLS 1.3 key schedule context object.
+ * @param [in]      secret   Secret of digest length.
+ * @param [in]      label    Label without prefix.
+ * @param [in]      data     Context data. May be NULL when dataLen is 0.
+ * @param [in]      dataLen  Length of context data in bytes.
+ * @param [out]     out      Buffer to hold output.
+ * @param [in]      outLen   Length of output in bytes.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_tls13_ks_expand(wp_Tls13KsCtx* ctx, const unsigned char* secret,
+    const char* label, const unsigned char* data, size_t dataLen,
+    unsigned char* out, size_t outLen)
+{
+    int ok = 1;
+    int rc;
+    unsigned char info[4 + WP_TLS13_KS_MAX_LABEL_LEN + WC_MAX_DIGEST_SIZE + 1];
+    unsigned char t[WC_MAX_DIGEST_SIZE];
+    size_t labelLen = XSTRLEN(label);
+    size_t idx = 0;
+    const unsigned char* prefix = (const unsigned char*)WP_TLS13_KS_PREFIX;
+    size_t prefixLen = sizeof(WP_TLS13_KS_PREFIX) - 1;
+
+    if (ctx->prefix != NULL) {
+        prefix = ctx->prefix;
+        prefixLen = ctx->prefixLen;
+    }
+
+    /* Construct info: output length, prefix and label, data and counter. */
+    info[idx++] = (byte)(outLen >> 8);
+    info[idx++] = (byte)outLen;
+    info[idx++] = (byte)(prefixLen + labelLen);
+    XMEMCPY(info + idx, prefix, prefixLen);
+    idx += prefixLen;
+    XMEMCPY(info + idx, label, labelLen);
+    idx += labelLen;
+    info[idx++] = (byte)dataLen;
+    if (dataLen > 0) {
+        XMEMCPY(info + idx, data, dataLen);
+        idx += dataLen;
+    }
+    info[idx++] = 1;
+
+    rc = wc_HmacSetKey(&ctx->hmac, ctx->mdType, secret, (word32)ctx->mdLen);
+    if (rc == 0) {
+        rc = wc_HmacUpdate(&ctx->hmac, info, (word32)idx);
+    }
+    if (rc != 0) {
+        ok = 0;
+    }
+    if (ok) {
+        rc = wc_HmacFinal(&ctx->hmac, t);
+        if (rc != 0) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        XMEMCPY(out, t, outLen);
+    }
+
+    OPENSSL_cleanse(t, sizeof(t));
+    return ok;
+}
+
+/**
+ * Derive the keys from a traffic secret.
+ *
+ * Places finished key, when requested, and traffic key and IV, when key
+ * length set, after the traffic secret.
+ *
+ * @param [in, out] ctx       TLS 1.3 key schedule context object.
+ * @param [in, out] out       Traffic secret followed by space for keys.
+ * @param [in]      finished  Whether to derive the finished key.
+ * @return  Length of secret and keys in bytes on success.
+ * @return  0 on failure.
+ */
+static size_t wp_tls13_ks_traffic(wp_Tls13KsCtx* ctx, unsigned char* out,
+    int finished)
+{
+    int ok = 1;
+    size_t idx = ctx->mdLen;
+
+    if (finished) {
+        ok = wp_tls13_ks_expand(ctx, out, "finished", NULL, 0,
+            out + idx, ctx->mdLen);
+        idx += ctx->mdLen;
+    }
+    if (ok && (ctx->trafficKeyLen > 0)) {
+        ok = wp_tls13_ks_expand(ctx, out, "key", NULL, 0,
+            out + idx, ctx->trafficKeyLen);
+        idx += ctx->trafficKeyLen;
+        if (ok) {
+            ok = wp_tls13_ks_expand(ctx, out, "iv", NULL, 0,
+                out + idx, ctx->trafficIvLen);
+            idx += ctx->trafficIvLen;
+        }
+    }
+
+    if (!ok) {
+        idx = 0;
+    }
+    return idx;
+}
+
+/**
+ * Derive all TLS 1.3 handshake and application secrets in one call.
+ *
+ * Each label is expanded from its secret with one HMAC block.
+ *
+ * @param [in, out] ctx     TLS 1.3 key schedule context object.
+ * @param [out]     key     Buffer to hold derived secrets and keys.
+ * @param [in]      keyLen  Size of buffer in bytes. Must be output length.
+ * @param [in]      params  Array of parameters to set before deriving.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_kdf_tls13_ks_derive(wp_Tls13KsCtx* ctx, unsigned char* key,
+    size_t keyLen, const OSSL_PARAM params[])
+{
+    int ok = 1;
+    int rc;
+    unsigned char zeros[WC_MAX_DIGEST_SIZE];
+    unsigned char emptyHash[WC_MAX_DIGEST_SIZE];
+    unsigned char secret[WC_MAX_DIGEST_SIZE];
+    unsigned char derived[WC_MAX_DIGEST_SIZE];
+    const unsigned char* stage = secret;
+    size_t prefixLen = sizeof(WP_TLS13_KS_PREFIX) - 1;
+    size_t idx = 0;
+    size_t sz;
+
+    XMEMSET(zeros, 0, sizeof(zeros));
+
+    if (!wolfssl_prov_is_running()) {
+        ok = 0;
+    }
+    if (ok && (!wp_kdf_tls13_ks_set_ctx_params(ctx, params))) {
+        ok = 0;
+    }
+    if (ok && (ctx->prefix != NULL)) {
+        prefixLen = ctx->prefixLen;
+    }
+    /* Longest label is 'c hs traffic'. */
+    if (ok && ((ctx->mdLen == 0) || (ctx->hsHashLen != ctx->mdLen) ||
+            ((ctx->appHashLen != 0) && (ctx->appHashLen != ctx->mdLen)) ||
+            (ctx->trafficKeyLen > ctx->mdLen) ||
+            (ctx->trafficIvLen > ctx->mdLen) ||
+            (prefixLen + 12 > WP_TLS13_KS_MAX_LABEL_LEN))) {
+        ok = 0;
+    }
+    if (ok && (keyLen != wp_kdf_tls13_ks_size(ctx))) {
+        ok = 0;
+    }
+
+    if (ok) {
+        /* Digest of an empty string is the context of derived secrets. */
+        rc = wc_Hash(ctx->mdType, zeros, 0, emptyHash, (word32)ctx->mdLen);
+        if (rc != 0) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        /* Early secret. */
+        if (ctx->psk != NULL) {
+            rc = wc_HKDF_Extract(ctx->mdType, NULL, 0, ctx->psk,
+                (word32)ctx->pskSz, secret);
+        }
+        else {
+            rc = wc_HKDF_Extract(ctx->mdType, NULL, 0, zeros,
+                (word32)ctx->mdLen, secret);
+        }
+        if (rc != 0) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        ok = wp_tls13_ks_expand(ctx, stage, "derived", emptyHash,
+            ctx->mdLen, derived, ctx->mdLen);
+    }
+    if (ok) {
+        /* Handshake secret. */
+        if (ctx->key != NULL) {
+            rc = wc_HKDF_Extract(ctx->mdType, derived, (word32)ctx->mdLen,
+                ctx->key, (word32)ctx->keySz, secret);
+        }
+        else {
+            rc = wc_HKDF_Extract(ctx->mdType, derived, (word32)ctx->mdLen,
+                zeros, (word32)ctx->mdLen, secret);
+        }
+        if (rc != 0) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        ok = wp_tls13_ks_expand(ctx, stage, "c hs traffic", ctx->hsHash,
+            ctx->hsHashLen, key + idx, ctx->mdLen);
+    }
+    if (ok) {
+        sz = wp_tls13_ks_traffic(ctx, key + idx, 1);
+        ok = (sz != 0);
+        idx += sz;
+    }
+    if (ok) {
+        ok = wp_tls13_ks_expand(ctx, stage, "s hs traffic", ctx->hsHash,
+            ctx->hsHashLen, key + idx, ctx->mdLen);
+    }
+    if (ok) {
+        sz = wp_tls13_ks_traffic(ctx, key + idx, 1);
+        ok = (sz != 0);
+        idx += sz;
+    }
+
+    if (ok && (ctx->appHashLen > 0)) {
+        ok = wp_tls13_ks_expand(ctx, stage, "derived", emptyHash,
+            ctx->mdLen, derived, ctx->mdLen);
+        if (ok) {
+            /* Master secret. */
+            rc = wc_HKDF_Extract(ctx->mdType, derived, (word32)ctx->mdLen,
+                zeros, (word32)ctx->mdLen, key + idx);
+            if (rc != 0) {
+                ok = 0;
+            }
+        }
+        if (ok) {
+            stage = key + idx;
+            idx += ctx->mdLen;
+        }
+        if (ok) {
+            ok = wp_tls13_ks_expand(ctx, stage, "c ap traffic",
+                ctx->appHash, ctx->appHashLen, key + idx, ctx->mdLen);
+        }
+        if (ok) {
+            sz = wp_tls13_ks_traffic(ctx, key + idx, 0);
+            ok = (sz != 0);
+            idx += sz;
+        }
+        if (ok) {
+            ok = wp_tls13_ks_expand(ctx, stage, "s ap traffic",
+                ctx->appHash, ctx->appHashLen, key + idx, ctx->mdLen);
+        }
+        if (ok) {
+            sz = wp_tls13_ks_traffic(ctx, key + idx, 0);
+            ok = (sz != 0);
+            idx += sz;
+        }
+        if (ok) {
+            ok = wp_tls13_ks_expand(ctx, stage, "exp master",
+                ctx->appHash, ctx->appHashLen, key + idx, ctx->mdLen);
+        }
+    }
+
+    OPENSSL_cleanse(secret, sizeof(secret));
+    OPENSSL_cleanse(derived, sizeof(derived));
+    return ok;
+}
+
+/**
+ * Get a transcript hash from the parameters.
+ *
+ * @param [in]  params  Array of parameters.
+ * @param [in]  name    Name of parameter.
+ * @param [out] hash    Buffer to hold hash.
+ * @param [out] len     Length of hash in bytes.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_tls13_ks_get_hash(const OSSL_PARAM params[], const char* name,
+    unsigned char* hash, size_t* len)
+{
+    int ok = 1;
+    const OSSL_PARAM* p;
+
+    p = OSSL_PARAM_locate_const(params, name);
+    if ((p != NULL) && (!OSSL_PARAM_get_octet_string(p, (void**)&hash,
+            WC_MAX_DIGEST_SIZE, len))) {
+        ok = 0;
+    }
+
+    return ok;
+}
+
+/**
+ * Set parameters into TLS 1.3 key schedule context object.
+ *
+ * @param [in, out] ctx     TLS 1.3 key schedule context object.
+ * @param [in]      params  Array of parameters with values.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_kdf_tls13_ks_set_ctx_params(wp_Tls13KsCtx* ctx,
+    const OSSL_PARAM params[])
+{
+    int ok = 1;
+
+    if (params != NULL) {
+        if (!wp_params_get_digest(params, NULL, ctx->provCtx->libCtx,
+                &ctx->mdType, &ctx->mdLen)) {
+            ok = 0;
+        }
+        if (ok && (!wp_params_get_octet_string(params, OSSL_KDF_PARAM_KEY,
+                &ctx->key, &ctx->keySz, 1))) {
+            ok = 0;
+        }
+        if (ok && (!wp_params_get_octet_string(params,
+                WP_KDF_PARAM_TLS13_PSK, &ctx->psk, &ctx->pskSz, 1))) {
+            ok = 0;
+        }
+        if (ok && (!wp_params_get_octet_string(params, OSSL_KDF_PARAM_PREFIX,
+                &ctx->prefix, &ctx->prefixLen, 0))) {
+            ok = 0;
+        }
+        if (ok && (!wp_tls13_ks_get_hash(params, WP_KDF_PARAM_TLS13_HS_HASH,
+                ctx->hsHash, &ctx->hsHashLen))) {
+            ok = 0;
+        }
+        if (ok && (!wp_tls13_ks_get_hash(params, WP_KDF_PARAM_TLS13_APP_HASH,
+                ctx->appHash, &ctx->appHashLen))) {
+            ok = 0;
+        }
+        if (ok && (!wp_params_get_size_t(params, WP_KDF_PARAM_TLS13_KEY_LEN,
+                &ctx->trafficKeyLen))) {
+            ok = 0;
+        }
+        if (ok && (!wp_params_get_size_t(params, WP_KDF_PARAM_TLS13_IV_LEN,
+                &ctx->trafficIvLen))) {
+            ok = 0;
+        }
+    }
+
+    return ok;
+}
+
+/**
+ * Retrieve parameter values from the TLS 1.3 key schedule context object.
+ *
+ * @param [in]      ctx     TLS 1.3 key schedule context object.
+ * @param [in, out] params  Array of parameters.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_kdf_tls13_ks_get_ctx_params(wp_Tls13KsCtx* ctx,
+    OSSL_PARAM params[])
+{
+    int ok = 1;
+    OSSL_PARAM* p;
+
+    p = OSSL_PARAM_locate(params, OSSL_KDF_PARAM_SIZE);
+    if ((p != NULL) && (!OSSL_PARAM_set_size_t(p,
+            wp_kdf_tls13_ks_size(ctx)))) {
+        ok = 0;
+    }
+
+    return ok;
+}
+
+/**
+ * Returns the parameters to set against a TLS 1.3 key schedule context.
+ *
+ * @param [in] ctx      TLS 1.3 key schedule context object. Unused.
+ * @param [in] provCtx  wolfProvider context. Unused.
+ * @return  Array of parameters.
+ */
+static const OSSL_PARAM* wp_kdf_tls13_ks_settable_ctx_params(
+    wp_Tls13KsCtx* ctx, WOLFPROV_CTX* provCtx)
+{
+    /** Parameters to set against a TLS 1.3 key schedule context. */
+    static const OSSL_PARAM wp_kdf_tls13_ks_supported_settable_ctx_params[] = {
+        OSSL_PARAM_utf8_string(OSSL_KDF_PARAM_PROPERTIES, NULL, 0),
+        OSSL_PARAM_utf8_string(OSSL_KDF_PARAM_DIGEST, NULL, 0),
+        OSSL_PARAM_octet_string(OSSL_KDF_PARAM_KEY, NULL, 0),
+        OSSL_PARAM_octet_string(WP_KDF_PARAM_TLS13_PSK, NULL, 0),
+        OSSL_PARAM_octet_string(OSSL_KDF_PARAM_PREFIX, NULL, 0),
+        OSSL_PARAM_octet_string(WP_KDF_PARAM_TLS13_HS_HASH, NULL, 0),
+        OSSL_PARAM_octet_string(WP_KDF_PARAM_TLS13_APP_HASH, NULL, 0),
+        OSSL_PARAM_size_t(WP_KDF_PARAM_TLS13_KEY_LEN, NULL),
+        OSSL_PARAM_size_t(WP_KDF_PARAM_TLS13_IV_LEN, NULL),
+        OSSL_PARAM_END
+    };
+    (void)ctx;
+    (void)provCtx;
+    return wp_kdf_tls13_ks_supported_settable_ctx_params;
+}
+
+/**
+ * Return parameters that can be retrieved from the TLS 1.3 key schedule
+ * context.
+ *
+ * @param [in] ctx      TLS 1.3 key schedule context object. Unused.
+ * @param [in] provCtx  wolfProvider context. Unused.
+ * @return  Array of parameters.
+ */
+static const OSSL_PARAM* wp_kdf_tls13_ks_gettable_ctx_params(
+    wp_Tls13KsCtx* ctx, WOLFPROV_CTX* provCtx)
+{
+    /**
+     * Parameters that can be retrieved from the TLS 1.3 key schedule context.
+     */
+    static const OSSL_PARAM wp_kdf_tls13_ks_supported_gettable_ctx_params[] = {
+        OSSL_PARAM_size_t(OSSL_KDF_PARAM_SIZE, NULL),
+        OSSL_PARAM_END
+    };
+    (void)ctx;
+    (void)provCtx;
+    return wp_kdf_tls13_ks_supported_gettable_ctx_params;
+}
+
+/** Dispatch table for TLS 1.3 key schedule implemented using wolfSSL. */
+const OSSL_DISPATCH wp_kdf_tls13_ks_functions[] = {
+    { OSSL_FUNC_KDF_NEWCTX,         (DFUNC)wp_kdf_tls13_ks_new                },
+    { OSSL_FUNC_KDF_FREECTX,        (DFUNC)wp_kdf_tls13_ks_free               },
+    { OSSL_FUNC_KDF_RESET,          (DFUNC)wp_kdf_tls13_ks_reset              },
+    { OSSL_FUNC_KDF_DERIVE,         (DFUNC)wp_kdf_tls13_ks_derive             },
+    { OSSL_FUNC_KDF_SETTABLE_CTX_PARAMS,
+                                   (DFUNC)wp_kdf_tls13_ks_settable_ctx_params },
+    { OSSL_FUNC_KDF_SET_CTX_PARAMS, (DFUNC)wp_kdf_tls13_ks_set_ctx_params     },
+    { OSSL_FUNC_KDF_GETTABLE_CTX_PARAMS,
+                                   (DFUNC)wp_kdf_tls13_ks_gettable_ctx_params },
+    { OSSL_FUNC_KDF_GET_CTX_PARAMS, (DFUNC)wp_kdf_tls13_ks_get_ctx_params     },
+    { 0, NULL }
+};
@@ -69,12 +69,12 @@ static wp_HmacCtx* wp_hmac_new(WOLFPROV_CTX* provCtx)
     int rc;
 
     if (wolfssl_prov_is_running()) {
-        macCtx = OPENSSL_zalloc(sizeof(*macCtx));
+        macCtx = wp_pool_zalloc(sizeof(*macCtx));
     }
     if (macCtx != NULL) {
-        rc = wc_HmacInit(&macCtx->hmac, NULL, INVALID_DEVID);
+        rc = wc_HmacInit(&macCtx->hmac, NULL, provCtx->devId);
         if (rc != 0) {
-            OPENSSL_free(macCtx);
+            wp_pool_clear_free(macCtx, sizeof(*macCtx));
             macCtx = NULL;
         }
     }
@@ -98,10 +98,51 @@ static void wp_hmac_free(wp_HmacCtx* macCtx)
     if (macCtx != NULL) {
         wc_HmacFree(&macCtx->hmac);
         OPENSSL_secure_clear_free(macCtx->key, macCtx->keyLen);
-        OPENSSL_free(macCtx);
+        wp_pool_clear_free(macCtx, sizeof(*macCtx));
     }
 }
 
+/**
+ * Key the wolfSSL HMAC object with the cached key.
+ *
+ * @param [in, out] macCtx  HMAC context object.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_hmac_key_hmac(wp_HmacCtx* macCtx)
+{
+    int ok = 1;
+    int rc;
+
+    rc = wc_HmacSetKey(&macCtx->hmac, macCtx->type, macCtx->key,
+        (word32)macCtx->keyLen);
+    if (rc != 0) {
+        ok = 0;
+    }
+
+    return ok;
+}
+
+/**
+ * Restart the HMAC calculation with the key already set.
+ *
+ * Keys the HMAC object again with the cached key.
+ *
+ * @param [in, out] macCtx  HMAC context object.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_hmac_restart(wp_HmacCtx* macCtx)
+{
+    int ok = 1;
+
+    if (macCtx->key != NULL) {
+        ok = wp_hmac_key_hmac(macCtx);
+    }
+
+    return ok;
+}
+
 /**
  * Set and cache the key into HMAC context object.
  *
@@ -122,6 +163,8 @@ static int wp_hmac_set_key(wp_HmacCtx* macCtx, const unsigned char* key,
 
     if (macCtx->keyLen > 0) {
         OPENSSL_secure_clear_free(macCtx->key, macCtx->keyLen);
+        macCtx->key = NULL;
+        macCtx->keyLen = 0;
     }
 
     if (keyLen < blockSize) {
@@ -141,6 +184,7 @@ static int wp_hmac_set_key(wp_HmacCtx* macCtx, const unsigned char* key,
         macCtx->keyLen = keyLen;
         macCtx->key = OPENSSL_secure_malloc(keyLen);
         if (macCtx->key == NULL) {
+            macCtx->keyLen = 0;
             ok = 0;
         }
     }
@@ -148,11 +192,7 @@ static int wp_hmac_set_key(wp_HmacCtx* macCtx, const unsigned char* key,
     if (ok) {
         XMEMCPY(macCtx->key, key, keyLen);
         if (restart) {
-            int rc = wc_HmacSetKey(&macCtx->hmac, macCtx->type, macCtx->key,
-                (word32)macCtx->keyLen);
-            if (rc != 0) {
-                ok = 0;
-            }
+            ok = wp_hmac_key_hmac(macCtx);
         }
     }
 
@@ -214,8 +254,11 @@ static int wp_hmac_init(wp_HmacCtx* macCtx, const unsigned char* key,
     }
     if (ok) {
         macCtx->size = wc_HmacSizeByType(macCtx->type);
-        if ((key != NULL) && (!wp_hmac_set_key(macCtx, key, keyLen, 1))) {
-            ok = 0;
+        if (key != NULL) {
+            ok = wp_hmac_set_key(macCtx, key, keyLen, 1);
+        }
+        else {
+            ok = wp_hmac_restart(macCtx);
         }
     }
 
@@ -19,55 +19,2012 @@
  */
 
 
+#if defined(WP_HAVE_NUMA) && !defined(_GNU_SOURCE)
+    /* sched_getcpu() is a GNU extension. */
+    #define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <limits.h>
+#include <sys/stat.h>
+
 #include <openssl/evp.h>
+#ifdef WOLFSSL_ASYNC_CRYPT
+    #include <openssl/async.h>
+#endif
+
+#include <wolfprovider/internal.h>
+
+#include <wolfssl/wolfcrypt/rsa.h>
+#include <wolfssl/wolfcrypt/memory.h>
+
+#if defined(WP_HAVE_NUMA) && !defined(WP_SINGLE_THREADED)
+    #include <sched.h>
+    #include <numa.h>
+    /** Allocate per-thread objects on the thread's NUMA node. */
+    #define WP_NUMA
+#endif
+
+#ifdef WP_NUMA
+/** NUMA support of system: -1 not yet checked, 0 unavailable, 1 available. */
+static int wp_numa_avail = -1;
+
+/**
+ * Check whether the system supports NUMA.
+ *
+ * Result is the same on every call so checking concurrently is harmless.
+ *
+ * @return  1 when NUMA is available.
+ * @return  0 otherwise.
+ */
+static int wp_numa_available(void)
+{
+    if (wp_numa_avail == -1) {
+        wp_numa_avail = (numa_available() >= 0);
+    }
+    return wp_numa_avail;
+}
+#endif
+
+/**
+ * Get the NUMA node the calling thread is running on.
+ *
+ * @return  NUMA node number.
+ * @return  0 when NUMA not supported.
+ */
+int wp_numa_node(void)
+{
+    int node = 0;
+
+#ifdef WP_NUMA
+    if (wp_numa_available()) {
+        int cpu = sched_getcpu();
+
+        if (cpu >= 0) {
+            node = numa_node_of_cpu(cpu);
+        }
+        if (node < 0) {
+            node = 0;
+        }
+    }
+#endif
+
+    return node;
+}
+
+/**
+ * Allocate zeroed memory on the calling thread's NUMA node.
+ *
+ * For objects used mostly by the calling thread. Falls back to OpenSSL's
+ * allocator when NUMA is not supported.
+ *
+ * @param [in] size  Number of bytes to allocate.
+ * @return  Zeroed memory on success.
+ * @return  NULL on failure.
+ */
+void* wp_numa_zalloc(size_t size)
+{
+    void* ptr;
+
+#ifdef WP_NUMA
+    if (wp_numa_available()) {
+        ptr = numa_alloc_local(size);
+        if (ptr != NULL) {
+            XMEMSET(ptr, 0, size);
+        }
+    }
+    else
+#endif
+    {
+        ptr = OPENSSL_zalloc(size);
+    }
+
+    return ptr;
+}
+
+/**
+ * Clear and free memory allocated with wp_numa_zalloc().
+ *
+ * @param [in] ptr   Memory to free. May be NULL.
+ * @param [in] size  Number of bytes allocated.
+ */
+void wp_numa_clear_free(void* ptr, size_t size)
+{
+#ifdef WP_NUMA
+    if (wp_numa_available()) {
+        if (ptr != NULL) {
+            OPENSSL_cleanse(ptr, size);
+            numa_free(ptr, size);
+        }
+    }
+    else
+#endif
+    {
+        OPENSSL_clear_free(ptr, size);
+    }
+}
+
+#ifdef WP_SINGLE_THREADED
+/**
+ * Initialize the random number generator of the provider context.
+ *
+ * Random number generator is instantiated on first use so that loading the
+ * provider doesn't gather entropy when no random is needed.
+ *
+ * @param [in, out] provCtx  Provider context.
+ * @return  1 always.
+ */
+int wp_provctx_rng_init(WOLFPROV_CTX* provCtx)
+{
+    provCtx->rngInit = 0;
+    return 1;
+}
+
+/**
+ * Dispose of the random number generator of the provider context.
+ *
+ * @param [in, out] provCtx  Provider context.
+ */
+void wp_provctx_rng_free(WOLFPROV_CTX* provCtx)
+{
+    if (provCtx->rngInit) {
+        wc_FreeRng(&provCtx->rng);
+        provCtx->rngInit = 0;
+    }
+}
+
+/**
+ * Get the wolfSSL random number generator from the provider context.
+ *
+ * Instantiated on first use.
+ *
+ * @param [in] provCtx  Provider context.
+ * @return  wolfSSL random number generator object on success.
+ * @return  NULL on failure.
+ */
+WC_RNG* wp_provctx_get_rng(WOLFPROV_CTX* provCtx)
+{
+    WC_RNG* rng = NULL;
+
+    if ((!provCtx->rngInit) && (wc_InitRng(&provCtx->rng) == 0)) {
+        provCtx->rngInit = 1;
+        provCtx->rngInstCnt++;
+    }
+    if (provCtx->rngInit) {
+        rng = &provCtx->rng;
+    }
+
+    return rng;
+}
+#else
+/**
+ * Dispose of a thread's random number generator.
+ *
+ * Called when the thread exits. Removes RNG from provider context's list.
+ * When the list can't be locked, the RNG is left in the list to be disposed of
+ * with the provider context.
+ *
+ * @param [in] arg  Thread random number generator object.
+ */
+static void wp_thread_rng_free(void* arg)
+{
+    wp_ThreadRng* tRng = (wp_ThreadRng*)arg;
+    WOLFPROV_CTX* provCtx = tRng->provCtx;
+
+    if (wc_LockMutex(&provCtx->rng_mutex) == 0) {
+        if (tRng->prev != NULL) {
+            tRng->prev->next = tRng->next;
+        }
+        else {
+            provCtx->rngList = tRng->next;
+        }
+        if (tRng->next != NULL) {
+            tRng->next->prev = tRng->prev;
+        }
+        provCtx->rngRemoteCnt += tRng->remoteCnt;
+        wc_UnLockMutex(&provCtx->rng_mutex);
+
+        wc_FreeRng(&tRng->rng);
+        wp_numa_clear_free(tRng, sizeof(*tRng));
+    }
+}
+
+/**
+ * Initialize the per-thread random number generators of the provider context.
+ *
+ * Random number generators are instantiated on first use in each thread.
+ *
+ * @param [in, out] provCtx  Provider context.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+int wp_provctx_rng_init(WOLFPROV_CTX* provCtx)
+{
+    int ok = 1;
+
+    if (wc_InitMutex(&provCtx->rng_mutex) != 0) {
+        ok = 0;
+    }
+    if (ok && (pthread_key_create(&provCtx->rngKey, wp_thread_rng_free) != 0)) {
+        wc_FreeMutex(&provCtx->rng_mutex);
+        ok = 0;
+    }
+    if (ok) {
+        provCtx->rngList = NULL;
+    }
+
+    return ok;
+}
+
+/**
+ * Dispose of all per-thread random number generators of the provider context.
+ *
+ * @param [in, out] provCtx  Provider context.
+ */
+void wp_provctx_rng_free(WOLFPROV_CTX* provCtx)
+{
+    wp_ThreadRng* tRng;
+    wp_ThreadRng* next;
+
+    /* No more destructor calls once key deleted. */
+    pthread_key_delete(provCtx->rngKey);
+    for (tRng = provCtx->rngList; tRng != NULL; tRng = next) {
+        next = tRng->next;
+        wc_FreeRng(&tRng->rng);
+        wp_numa_clear_free(tRng, sizeof(*tRng));
+    }
+    provCtx->rngList = NULL;
+    wc_FreeMutex(&provCtx->rng_mutex);
+}
+
+/**
+ * Create and instantiate a random number generator for the calling thread.
+ *
+ * @param [in, out] provCtx  Provider context.
+ * @return  Thread random number generator object on success.
+ * @return  NULL on failure.
+ */
+static wp_ThreadRng* wp_provctx_thread_rng_new(WOLFPROV_CTX* provCtx)
+{
+    wp_ThreadRng* tRng;
+
+    tRng = (wp_ThreadRng*)wp_numa_zalloc(sizeof(*tRng));
+    if ((tRng != NULL) && (wc_InitRng(&tRng->rng) != 0)) {
+        wp_numa_clear_free(tRng, sizeof(*tRng));
+        tRng = NULL;
+    }
+    if ((tRng != NULL) && (wc_LockMutex(&provCtx->rng_mutex) != 0)) {
+        wc_FreeRng(&tRng->rng);
+        wp_numa_clear_free(tRng, sizeof(*tRng));
+        tRng = NULL;
+    }
+    if (tRng != NULL) {
+        tRng->node = wp_numa_node();
+        tRng->provCtx = provCtx;
+        tRng->next = provCtx->rngList;
+        if (provCtx->rngList != NULL) {
+            provCtx->rngList->prev = tRng;
+        }
+        provCtx->rngList = tRng;
+        provCtx->rngInstCnt++;
+        wc_UnLockMutex(&provCtx->rng_mutex);
+
+        if (pthread_setspecific(provCtx->rngKey, tRng) != 0) {
+            wp_thread_rng_free(tRng);
+            tRng = NULL;
+        }
+    }
+
+    return tRng;
+}
+
+/**
+ * Re-instantiate thread random number generator with fresh entropy.
+ *
+ * @param [in, out] tRng  Thread random number generator object.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_provctx_thread_rng_reseed(wp_ThreadRng* tRng)
+{
+    int ok = 1;
+    WOLFPROV_CTX* provCtx = tRng->provCtx;
+
+    wc_FreeRng(&tRng->rng);
+    if (wc_InitRng(&tRng->rng) != 0) {
+        ok = 0;
+    }
+    if (ok) {
+        tRng->useCnt = 0;
+        if (wc_LockMutex(&provCtx->rng_mutex) == 0) {
+            provCtx->rngReseedCnt++;
+            wc_UnLockMutex(&provCtx->rng_mutex);
+        }
+    }
+
+    return ok;
+}
+
+/**
+ * Get the calling thread's wolfSSL random number generator from the provider
+ * context.
+ *
+ * Instantiated on first use and re-instantiated after
+ * WP_PROV_RNG_RESEED_INTERVAL uses. Only the calling thread uses the object so
+ * no locking is required.
+ *
+ * @param [in] provCtx  Provider context.
+ * @return  wolfSSL random number generator object on success.
+ * @return  NULL on failure.
+ */
+WC_RNG* wp_provctx_get_rng(WOLFPROV_CTX* provCtx)
+{
+    WC_RNG* rng = NULL;
+    wp_ThreadRng* tRng;
+
+    tRng = (wp_ThreadRng*)pthread_getspecific(provCtx->rngKey);
+    if (tRng == NULL) {
+        tRng = wp_provctx_thread_rng_new(provCtx);
+    }
+    else if ((++tRng->useCnt >= WP_PROV_RNG_RESEED_INTERVAL) &&
+             (!wp_provctx_thread_rng_reseed(tRng))) {
+        /* Failed RNG must not be used again - start afresh next time. */
+        pthread_setspecific(provCtx->rngKey, NULL);
+        wp_thread_rng_free(tRng);
+        tRng = NULL;
+    }
+    if (tRng != NULL) {
+    #ifdef WP_NUMA
+        if (wp_numa_node() != tRng->node) {
+            tRng->remoteCnt++;
+        }
+    #endif
+        rng = &tRng->rng;
+    }
+
+    return rng;
+}
+#endif
+
+/**
+ * Get the random number generator statistics of the provider context.
+ *
+ * @param [in]  provCtx    Provider context.
+ * @param [out] instCnt    Number of random number generator instantiations.
+ * @param [out] reseedCnt  Number of random number generator reseeds.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+int wp_provctx_rng_stats(WOLFPROV_CTX* provCtx, word32* instCnt,
+    word32* reseedCnt)
+{
+    int ok = 1;
+
+#ifndef WP_SINGLE_THREADED
+    if (wc_LockMutex(&provCtx->rng_mutex) != 0) {
+        ok = 0;
+    }
+#endif
+    if (ok) {
+        *instCnt = provCtx->rngInstCnt;
+        *reseedCnt = provCtx->rngReseedCnt;
+#ifndef WP_SINGLE_THREADED
+        wc_UnLockMutex(&provCtx->rng_mutex);
+#endif
+    }
+
+    return ok;
+}
+
+/**
+ * Get the number of RNG uses from a different NUMA node to the RNG's memory.
+ *
+ * Counts of running threads are read without their cooperation so the total
+ * is approximate.
+ *
+ * @param [in]  provCtx    Provider context.
+ * @param [out] remoteCnt  Number of remote node uses.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+int wp_provctx_rng_remote(WOLFPROV_CTX* provCtx, word64* remoteCnt)
+{
+    int ok = 1;
+
+#ifndef WP_SINGLE_THREADED
+    if (wc_LockMutex(&provCtx->rng_mutex) != 0) {
+        ok = 0;
+    }
+    if (ok) {
+        wp_ThreadRng* tRng;
+
+        *remoteCnt = provCtx->rngRemoteCnt;
+        for (tRng = provCtx->rngList; tRng != NULL; tRng = tRng->next) {
+            *remoteCnt += tRng->remoteCnt;
+        }
+        wc_UnLockMutex(&provCtx->rng_mutex);
+    }
+#else
+    *remoteCnt = provCtx->rngRemoteCnt;
+#endif
+
+    return ok;
+}
+
+#ifdef WOLFSSL_ASYNC_CRYPT
+/**
+ * Wait on a wolfCrypt operation that is pending on async hardware.
+ *
+ * When called from an OpenSSL ASYNC job, the job is paused first so that the
+ * application's event loop can do other work while the device is busy.
+ * Call the wolfCrypt operation again while this returns 1.
+ *
+ * @param [in, out] rc   Return code of wolfCrypt operation. Updated when the
+ *                       wait fails.
+ * @param [in]      dev  Async device of wolfCrypt key object.
+ * @return  1 when operation is to be called again.
+ * @return  0 when operation is complete or failed.
+ */
+int wp_async_pending(int* rc, WC_ASYNC_DEV* dev)
+{
+    int again = 0;
+
+    if (*rc == WC_PENDING_E) {
+        if (ASYNC_get_current_job() != NULL) {
+            ASYNC_pause_job();
+        }
+        *rc = wc_AsyncWait(*rc, dev, WC_ASYNC_FLAG_CALL_AGAIN);
+        again = (*rc >= 0);
+    }
+
+    return again;
+}
+#endif
+
+
+#if defined(FP_ECC) && !defined(WP_SINGLE_THREADED)
+/**
+ * Dispose of the calling thread's ECC fixed point cache.
+ *
+ * Called when the thread exits.
+ *
+ * @param [in] arg  Unused.
+ */
+static void wp_thread_ecc_fp_free(void* arg)
+{
+    (void)arg;
+    wc_ecc_fp_free();
+}
+#endif
+
+/**
+ * Initialize tracking of ECC fixed point caches.
+ *
+ * wolfCrypt builds tables of precomputed multiples for the generator and for
+ * frequently used public keys when FP_ECC is defined. The tables are per
+ * thread, bounded by FP_ENTRIES and FP_LUT, and shared by all keys and
+ * contexts with the same point.
+ *
+ * @param [in, out] provCtx  Provider context.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+int wp_provctx_ecc_fp_init(WOLFPROV_CTX* provCtx)
+{
+    int ok = 1;
+
+#if defined(FP_ECC) && !defined(WP_SINGLE_THREADED)
+    if (pthread_key_create(&provCtx->eccFpKey, wp_thread_ecc_fp_free) != 0) {
+        ok = 0;
+    }
+#else
+    (void)provCtx;
+#endif
+
+    return ok;
+}
+
+/**
+ * Dispose of the ECC fixed point cache of the calling thread.
+ *
+ * Caches of other threads are disposed of when they exit.
+ *
+ * @param [in, out] provCtx  Provider context.
+ */
+void wp_provctx_ecc_fp_free(WOLFPROV_CTX* provCtx)
+{
+#ifdef FP_ECC
+#ifndef WP_SINGLE_THREADED
+    pthread_key_delete(provCtx->eccFpKey);
+#endif
+    wc_ecc_fp_free();
+#endif
+    (void)provCtx;
+}
+
+/**
+ * Record that the calling thread is about to use the ECC fixed point cache.
+ *
+ * Ensures the thread's cache is disposed of when the thread exits.
+ *
+ * @param [in] provCtx  Provider context.
+ */
+void wp_provctx_ecc_fp_use(WOLFPROV_CTX* provCtx)
+{
+#if defined(FP_ECC) && !defined(WP_SINGLE_THREADED)
+    if (pthread_getspecific(provCtx->eccFpKey) == NULL) {
+        (void)pthread_setspecific(provCtx->eccFpKey, provCtx);
+    }
+#else
+    (void)provCtx;
+#endif
+}
+
+/**
+ * Initialize a reference count to one.
+ *
+ * @param [out] ref  Reference count object.
+ * @return  1 on success.
+ * @return  0 when mutex initialization fails.
+ */
+int wp_refcnt_init(wp_RefCnt* ref)
+{
+    int ok = 1;
+
+#if !defined(WP_SINGLE_THREADED) && !defined(WP_ATOMIC_REFCNT)
+    if (wc_InitMutex(&ref->mutex) != 0) {
+        ok = 0;
+    }
+#endif
+    ref->cnt = 1;
+
+    return ok;
+}
+
+/**
+ * Dispose of the resources of a reference count.
+ *
+ * @param [in, out] ref  Reference count object.
+ */
+void wp_refcnt_free(wp_RefCnt* ref)
+{
+#if !defined(WP_SINGLE_THREADED) && !defined(WP_ATOMIC_REFCNT)
+    wc_FreeMutex(&ref->mutex);
+#else
+    (void)ref;
+#endif
+}
+
+/**
+ * Increment a reference count.
+ *
+ * @param [in, out] ref  Reference count object.
+ * @return  1 on success.
+ * @return  0 when multi-threaded and locking fails.
+ */
+int wp_refcnt_up(wp_RefCnt* ref)
+{
+    int ok = 1;
+
+#if defined(WP_ATOMIC_REFCNT)
+    /* Holder of a reference is not ordering any memory accesses. */
+    (void)__atomic_add_fetch(&ref->cnt, 1, __ATOMIC_RELAXED);
+#elif !defined(WP_SINGLE_THREADED)
+    if (wc_LockMutex(&ref->mutex) < 0) {
+        ok = 0;
+    }
+    if (ok) {
+        ref->cnt++;
+        wc_UnLockMutex(&ref->mutex);
+    }
+#else
+    ref->cnt++;
+#endif
+
+    return ok;
+}
+
+/**
+ * Decrement a reference count.
+ *
+ * @param [in, out] ref  Reference count object.
+ * @return  Number of references remaining. Object to be freed when 0.
+ */
+int wp_refcnt_down(wp_RefCnt* ref)
+{
+    int cnt;
+
+#if defined(WP_ATOMIC_REFCNT)
+    /* Release this thread's writes and acquire others' before freeing. */
+    cnt = __atomic_sub_fetch(&ref->cnt, 1, __ATOMIC_ACQ_REL);
+#elif !defined(WP_SINGLE_THREADED)
+    int rc;
+
+    rc = wc_LockMutex(&ref->mutex);
+    cnt = --ref->cnt;
+    if (rc == 0) {
+        wc_UnLockMutex(&ref->mutex);
+    }
+#else
+    cnt = --ref->cnt;
+#endif
+
+    return cnt;
+}
+
+/**
+ * Allocate a DER object able to hold an encoding.
+ *
+ * @param [in] len  Maximum length of encoding in bytes.
+ * @return  DER object with length set to len on success.
+ * @return  NULL on failure.
+ */
+wp_Der* wp_der_new(size_t len)
+{
+    wp_Der* der;
+
+    der = (wp_Der*)OPENSSL_malloc(sizeof(*der) + len);
+    if (der != NULL) {
+        der->len = len;
+    }
+
+    return der;
+}
+
+/**
+ * Get the DER encoding memoized on a key object.
+ *
+ * @param [in] cache  Memoized DER object field of key object.
+ * @return  DER object when memoized.
+ * @return  NULL when not memoized or memoizing not supported.
+ */
+wp_Der* wp_der_get(wp_Der* const* cache)
+{
+#if defined(WP_ATOMIC_REFCNT)
+    /* Acquire the encoding written by the thread that stored it. */
+    return __atomic_load_n(cache, __ATOMIC_ACQUIRE);
+#elif defined(WP_SINGLE_THREADED)
+    return *cache;
+#else
+    (void)cache;
+    return NULL;
+#endif
+}
+
+/**
+ * Memoize a DER encoding on a key object.
+ *
+ * Key objects are shared between threads that encode concurrently. When
+ * another thread stored an encoding first, the passed in DER object is freed
+ * and the stored one returned instead.
+ *
+ * @param [in, out] cache  Memoized DER object field of key object.
+ * @param [in, out] der    On in, DER object to store.
+ *                         On out, DER object stored when 1 returned.
+ * @return  1 when stored - key object owns DER object.
+ * @return  0 when memoizing not supported - caller owns DER object.
+ */
+int wp_der_set(wp_Der** cache, wp_Der** der)
+{
+    int stored = 1;
+
+#if defined(WP_ATOMIC_REFCNT)
+    wp_Der* cur = NULL;
+
+    if (!__atomic_compare_exchange_n(cache, &cur, *der, 0, __ATOMIC_ACQ_REL,
+            __ATOMIC_ACQUIRE)) {
+        /* Same key, same encoding - use the one stored first. */
+        OPENSSL_clear_free(*der, sizeof(**der) + (*der)->len);
+        *der = cur;
+    }
+#elif defined(WP_SINGLE_THREADED)
+    *cache = *der;
+#else
+    (void)cache;
+    (void)der;
+    stored = 0;
+#endif
+
+    return stored;
+}
+
+/**
+ * Dispose of a memoized DER encoding.
+ *
+ * Called when the key object is changed or freed - the key is not shared.
+ * Encoding may hold private key data so is cleared.
+ *
+ * @param [in, out] cache  Memoized DER object field of key object.
+ */
+void wp_der_free(wp_Der** cache)
+{
+    if (*cache != NULL) {
+        OPENSSL_clear_free(*cache, sizeof(**cache) + (*cache)->len);
+        *cache = NULL;
+    }
+}
+
+/**
+ * Get the header of a DER item and check its tag.
+ *
+ * Only definite lengths of up to four bytes are supported.
+ *
+ * @param [in]      data     DER encoding.
+ * @param [in]      len      Length, in bytes, of DER encoding.
+ * @param [in, out] idx      On in, index of item.
+ *                           On out, index of item's data.
+ * @param [in]      tag      Expected tag of item.
+ * @param [out]     itemLen  Length, in bytes, of item's data.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+int wp_der_get_item(const unsigned char* data, word32 len,
+    word32* idx, unsigned char tag, word32* itemLen)
+{
+    int ok = 1;
+    word32 i = *idx;
+    word32 l = 0;
+    word32 cnt = 0;
+
+    if ((i + 2 > len) || (data[i++] != tag)) {
+        ok = 0;
+    }
+    if (ok) {
+        l = data[i++];
+        if (l & 0x80) {
+            cnt = l & 0x7f;
+            if ((cnt == 0) || (cnt > 4) || (i + cnt > len)) {
+                ok = 0;
+            }
+            for (l = 0; ok && (cnt > 0); cnt--) {
+                l = (l << 8) | data[i++];
+            }
+        }
+    }
+    if (ok && (l > len - i)) {
+        ok = 0;
+    }
+    if (ok) {
+        *idx = i;
+        *itemLen = l;
+    }
+
+    return ok;
+}
+
+/** Smallest size class of pooled allocations. */
+#define WP_POOL_MIN_SZ          256
+/** Number of size classes. Classes double in size from WP_POOL_MIN_SZ. */
+#define WP_POOL_CLASSES         5
+/** Largest size of an allocation that is pooled. */
+#define WP_POOL_MAX_SZ          (WP_POOL_MIN_SZ << (WP_POOL_CLASSES - 1))
+#ifndef WP_POOL_MAX_FREE
+/** Maximum number of free blocks kept for each size class in a thread. */
+#define WP_POOL_MAX_FREE        16
+#endif
+
+/**
+ * Free block in a pool. Overlays the start of the freed memory.
+ */
+typedef struct wp_PoolBlk {
+    /** Next free block of the same size class. */
+    struct wp_PoolBlk* next;
+} wp_PoolBlk;
+
+#ifndef WP_MD_CACHE_SIZE
+/** Number of digest name lookups cached for each thread. */
+#define WP_MD_CACHE_SIZE        8
+#endif
+/** Maximum length of digest name or property query, with NUL, cached. */
+#define WP_MD_CACHE_NAME_SZ     32
+
+/**
+ * Cached result of looking up a digest by name.
+ */
+typedef struct wp_MdCacheEntry {
+    /** Library context digest was looked up in. */
+    OSSL_LIB_CTX* libCtx;
+    /** Name of digest. Empty string when entry unused. */
+    char name[WP_MD_CACHE_NAME_SZ];
+    /** Property query. Empty string when NULL. */
+    char propQ[WP_MD_CACHE_NAME_SZ];
+    /** OpenSSL NID of digest. */
+    int nid;
+    /** wolfCrypt hash type of digest. */
+    enum wc_HashType hashType;
+} wp_MdCacheEntry;
+
+/**
+ * Caches for a thread: free blocks of contexts and digest name lookups.
+ */
+typedef struct wp_ThreadCache {
+    /** List of free blocks for each size class. */
+    wp_PoolBlk* free[WP_POOL_CLASSES];
+    /** Number of free blocks in each list. */
+    int cnt[WP_POOL_CLASSES];
+    /** Number of allocations satisfied from a free list. */
+    word32 hits;
+    /** Number of allocations that went to the allocator. */
+    word32 misses;
+    /** Digest name lookups. */
+    wp_MdCacheEntry md[WP_MD_CACHE_SIZE];
+    /** Index of next digest name lookup entry to replace. */
+    int mdNext;
+#ifndef WP_SINGLE_THREADED
+    /** Previous cache in list of all threads' caches. */
+    struct wp_ThreadCache* prev;
+    /** Next cache in list of all threads' caches. */
+    struct wp_ThreadCache* next;
+#endif
+} wp_ThreadCache;
+
+/** Number of provider contexts using the pool. */
+static int wp_pool_users = 0;
+/** Hits of the caches of threads that have exited. */
+static word32 wp_pool_hits = 0;
+/** Misses of the caches of threads that have exited. */
+static word32 wp_pool_misses = 0;
+#ifdef WP_SINGLE_THREADED
+/** Only cache when single threaded. */
+static wp_ThreadCache wp_pool_cache;
+#else
+/** Key to the calling thread's cache. */
+static pthread_key_t wp_pool_key;
+/** Protects list of caches, users count and exited thread statistics. */
+static pthread_mutex_t wp_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+/** List of all threads' caches. */
+static wp_ThreadCache* wp_pool_list = NULL;
+#endif
+
+/**
+ * Get the size class of an allocation.
+ *
+ * @param [in]  size  Size of allocation in bytes.
+ * @param [out] cls   Index of size class.
+ * @return  1 when the size is pooled.
+ * @return  0 otherwise.
+ */
+static int wp_pool_class(size_t size, int* cls)
+{
+    int ok = (size <= WP_POOL_MAX_SZ);
+
+    if (ok) {
+        size_t clsSz = WP_POOL_MIN_SZ;
+
+        *cls = 0;
+        while (clsSz < size) {
+            clsSz <<= 1;
+            (*cls)++;
+        }
+    }
+
+    return ok;
+}
+
+/**
+ * Dispose of the free blocks in a cache.
+ *
+ * @param [in, out] cache  Thread's cache of free blocks.
+ */
+static void wp_pool_cache_empty(wp_ThreadCache* cache)
+{
+    int i;
+
+    for (i = 0; i < WP_POOL_CLASSES; i++) {
+        wp_PoolBlk* blk = cache->free[i];
+
+        while (blk != NULL) {
+            wp_PoolBlk* next = blk->next;
+            OPENSSL_free(blk);
+            blk = next;
+        }
+        cache->free[i] = NULL;
+        cache->cnt[i] = 0;
+    }
+}
+
+#ifndef WP_SINGLE_THREADED
+/**
+ * Dispose of a thread's caches.
+ *
+ * Called when the thread exits. Removes the cache from the list and keeps its
+ * statistics. When the list can't be locked, the cache is left in the list to
+ * be disposed of when the last user stops using the pool.
+ *
+ * @param [in] arg  Thread's cache of free blocks.
+ */
+static void wp_thread_pool_free(void* arg)
+{
+    wp_ThreadCache* cache = (wp_ThreadCache*)arg;
+
+    if (pthread_mutex_lock(&wp_pool_mutex) == 0) {
+        if (cache->prev != NULL) {
+            cache->prev->next = cache->next;
+        }
+        else {
+            wp_pool_list = cache->next;
+        }
+        if (cache->next != NULL) {
+            cache->next->prev = cache->prev;
+        }
+        wp_pool_hits += cache->hits;
+        wp_pool_misses += cache->misses;
+        pthread_mutex_unlock(&wp_pool_mutex);
+
+        wp_pool_cache_empty(cache);
+        wp_numa_clear_free(cache, sizeof(*cache));
+    }
+}
+#endif
+
+/**
+ * Get the calling thread's caches.
+ *
+ * Creates the cache on first use in the thread.
+ *
+ * @return  Thread's cache on success.
+ * @return  NULL when the pool is not in use or on failure.
+ */
+static wp_ThreadCache* wp_thread_cache_get(void)
+{
+    wp_ThreadCache* cache = NULL;
+
+    if (wp_pool_users > 0) {
+#ifdef WP_SINGLE_THREADED
+        cache = &wp_pool_cache;
+#else
+        cache = (wp_ThreadCache*)pthread_getspecific(wp_pool_key);
+        if (cache == NULL) {
+            cache = (wp_ThreadCache*)wp_numa_zalloc(sizeof(*cache));
+            if ((cache != NULL) && (pthread_mutex_lock(&wp_pool_mutex) != 0)) {
+                wp_numa_clear_free(cache, sizeof(*cache));
+                cache = NULL;
+            }
+            if (cache != NULL) {
+                if (pthread_setspecific(wp_pool_key, cache) != 0) {
+                    pthread_mutex_unlock(&wp_pool_mutex);
+                    wp_numa_clear_free(cache, sizeof(*cache));
+                    cache = NULL;
+                }
+                else {
+                    cache->next = wp_pool_list;
+                    if (wp_pool_list != NULL) {
+                        wp_pool_list->prev = cache;
+                    }
+                    wp_pool_list = cache;
+                    pthread_mutex_unlock(&wp_pool_mutex);
+                }
+            }
+        }
+#endif
+    }
+
+    return cache;
+}
+
+/**
+ * Initialize the pool of context allocations.
+ *
+ * Digest and MAC contexts are created and disposed of for every operation.
+ * Freed contexts are kept on per-thread lists of blocks by size class so that
+ * the next context of a similar size does not go to the allocator.
+ *
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+int wp_pool_init(void)
+{
+    int ok = 1;
+
+#ifndef WP_SINGLE_THREADED
+    if (pthread_mutex_lock(&wp_pool_mutex) != 0) {
+        ok = 0;
+    }
+    if (ok && (wp_pool_users == 0) &&
+            (pthread_key_create(&wp_pool_key, wp_thread_pool_free) != 0)) {
+        ok = 0;
+        pthread_mutex_unlock(&wp_pool_mutex);
+    }
+#endif
+    if (ok) {
+        if (wp_pool_users == 0) {
+            wp_pool_hits = 0;
+            wp_pool_misses = 0;
+        }
+        wp_pool_users++;
+#ifndef WP_SINGLE_THREADED
+        pthread_mutex_unlock(&wp_pool_mutex);
+#endif
+    }
+
+    return ok;
+}
+
+/**
+ * Stop using the pool of context allocations.
+ *
+ * Disposes of all free blocks when the last user stops.
+ */
+void wp_pool_cleanup(void)
+{
+#ifdef WP_SINGLE_THREADED
+    if ((wp_pool_users > 0) && (--wp_pool_users == 0)) {
+        wp_pool_cache_empty(&wp_pool_cache);
+        wp_pool_hits += wp_pool_cache.hits;
+        wp_pool_misses += wp_pool_cache.misses;
+        XMEMSET(&wp_pool_cache, 0, sizeof(wp_pool_cache));
+    }
+#else
+    if (pthread_mutex_lock(&wp_pool_mutex) == 0) {
+        if ((wp_pool_users > 0) && (--wp_pool_users == 0)) {
+            pthread_key_delete(wp_pool_key);
+            while (wp_pool_list != NULL) {
+                wp_ThreadCache* cache = wp_pool_list;
+
+                wp_pool_list = cache->next;
+                wp_pool_hits += cache->hits;
+                wp_pool_misses += cache->misses;
+                wp_pool_cache_empty(cache);
+                wp_numa_clear_free(cache, sizeof(*cache));
+            }
+        }
+        pthread_mutex_unlock(&wp_pool_mutex);
+    }
+#endif
+}
+
+/**
+ * Allocate zeroized memory for a context.
+ *
+ * Takes a block from the calling thread's free list when available.
+ * Memory must be disposed of with wp_pool_clear_free() with the same size.
+ *
+ * @param [in] size  Size of allocation in bytes.
+ * @return  Zeroized memory on success.
+ * @return  NULL on failure.
+ */
+void* wp_pool_zalloc(size_t size)
+{
+    void* ptr = NULL;
+    wp_ThreadCache* cache = NULL;
+    size_t allocSz = size;
+    int cls = 0;
+
+    if (wp_pool_class(size, &cls)) {
+        /* Allocate whole class so block can be reused for any size in it -
+         * even when no cache now as it may be freed into one. */
+        allocSz = (size_t)WP_POOL_MIN_SZ << cls;
+        cache = wp_thread_cache_get();
+    }
+    if (cache == NULL) {
+        ptr = OPENSSL_zalloc(allocSz);
+    }
+    else if (cache->free[cls] != NULL) {
+        wp_PoolBlk* blk = cache->free[cls];
+
+        cache->free[cls] = blk->next;
+        cache->cnt[cls]--;
+        cache->hits++;
+        /* Rest of block was zeroized when freed. */
+        blk->next = NULL;
+        ptr = blk;
+    }
+    else {
+        ptr = OPENSSL_zalloc(allocSz);
+        cache->misses++;
+    }
+
+    return ptr;
+}
+
+/**
+ * Zeroize and dispose of memory allocated with wp_pool_zalloc().
+ *
+ * Keeps the block on the calling thread's free list when there is room.
+ *
+ * @param [in] ptr   Memory to dispose of. May be NULL.
+ * @param [in] size  Size of allocation in bytes.
+ */
+void wp_pool_clear_free(void* ptr, size_t size)
+{
+    wp_ThreadCache* cache = NULL;
+    int cls = 0;
+
+    if ((ptr != NULL) && wp_pool_class(size, &cls)) {
+        cache = wp_thread_cache_get();
+    }
+    if ((cache == NULL) || (cache->cnt[cls] >= WP_POOL_MAX_FREE)) {
+        OPENSSL_clear_free(ptr, size);
+    }
+    else {
+        wp_PoolBlk* blk = (wp_PoolBlk*)ptr;
+
+        OPENSSL_cleanse(ptr, size);
+        blk->next = cache->free[cls];
+        cache->free[cls] = blk;
+        cache->cnt[cls]++;
+    }
+}
+
+/**
+ * Get the statistics of the pool of context allocations.
+ *
+ * @param [out] hits    Number of allocations satisfied from a free list.
+ * @param [out] misses  Number of allocations that went to the allocator.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+int wp_pool_stats(word32* hits, word32* misses)
+{
+    int ok = 1;
+
+#ifndef WP_SINGLE_THREADED
+    if (pthread_mutex_lock(&wp_pool_mutex) != 0) {
+        ok = 0;
+    }
+#endif
+    if (ok) {
+#ifdef WP_SINGLE_THREADED
+        *hits = wp_pool_hits + wp_pool_cache.hits;
+        *misses = wp_pool_misses + wp_pool_cache.misses;
+#else
+        wp_ThreadCache* cache;
+
+        *hits = wp_pool_hits;
+        *misses = wp_pool_misses;
+        for (cache = wp_pool_list; cache != NULL; cache = cache->next) {
+            *hits += cache->hits;
+            *misses += cache->misses;
+        }
+        pthread_mutex_unlock(&wp_pool_mutex);
+#endif
+    }
+
+    return ok;
+}
+
+#if defined(USE_WOLFSSL_MEMORY) && !defined(WOLFSSL_STATIC_MEMORY) && \
+    !defined(WOLFSSL_DEBUG_MEMORY) && !defined(XMALLOC_USER) && \
+    !defined(XMALLOC_OVERRIDE) && \
+    (defined(WP_SINGLE_THREADED) || defined(WP_ATOMIC_REFCNT))
+    /* wolfCrypt allocations go through callbacks that can be replaced. */
+    #define WP_HAVE_ARENA
+#endif
+
+#ifdef WP_HAVE_ARENA
+
+/** Maximum number of blocks kept in a thread's arena. */
+#define WP_ARENA_BLOCKS         64
+/** Sizes of blocks are a multiple of this. */
+#define WP_ARENA_ROUND          64
+/** Smallest size in bytes of a thread's arena. */
+#define WP_ARENA_MIN_SZ         1024
+/** Largest size in bytes of a thread's arena. */
+#define WP_ARENA_MAX_SZ         (16 * 1024 * 1024)
+
+/** Arena's thread is not in a public key operation. */
+#define WP_ARENA_IDLE           0
+/** Arena's thread is in a public key operation. */
+#define WP_ARENA_BUSY           1
+/** Arenas cleaned up while thread in operation - thread disposes of arena. */
+#define WP_ARENA_ORPHAN         2
+/** Arena's blocks have been disposed of. */
+#define WP_ARENA_DEAD           3
+
+/**
+ * Block of memory kept in an arena.
+ *
+ * Blocks are allocated with the previous allocator so that any block can be
+ * freed with it, even after the arena callbacks are removed.
+ */
+typedef struct wp_ArenaBlock {
+    /** Memory of block. */
+    void* ptr;
+    /** Size of block in bytes. */
+    size_t size;
+    /** Block handed out and not freed. */
+    byte used;
+    /** Block handed out in this operation - zeroized at end. */
+    byte dirty;
+} wp_ArenaBlock;
+
+/**
+ * Thread's arena that wolfCrypt temporaries are allocated from during a
+ * public key operation.
+ */
+struct wp_Arena {
+    /** Blocks kept for reuse and blocks handed out in this operation. */
+    wp_ArenaBlock block[WP_ARENA_BLOCKS];
+    /** Number of blocks. */
+    int cnt;
+    /** Number of bytes in blocks. */
+    size_t bytes;
+    /** Depth of nested operations. */
+    int depth;
+    /** Blocks handed out in this operation. Only used by owning thread. */
+    int active;
+    /** State of arena. WP_ARENA_* value. */
+    int state;
+    /** Number of allocations from arena not yet added to totals. */
+    word64 allocs;
+    /** Number of allocations that did not fit not yet added to totals. */
+    word64 fallbacks;
+    /** Number of blocks not freed by end of operation not yet added. */
+    word64 escapes;
+#ifndef WP_SINGLE_THREADED
+    /** References held - by owning thread and list of arenas. */
+    int refs;
+    /** Arena is in list of arenas. */
+    int linked;
+    /** Previous arena in list of all threads' arenas. */
+    struct wp_Arena* prev;
+    /** Next arena in list of all threads' arenas. */
+    struct wp_Arena* next;
+#endif
+};
+
+/** Number of provider contexts using arenas. */
+static int wp_arena_users = 0;
+/** Size in bytes of blocks kept by each thread's arena. */
+static size_t wp_arena_size = 0;
+/** Allocation callback in place before arenas were installed. */
+static wolfSSL_Malloc_cb wp_arena_prev_malloc = NULL;
+/** Free callback in place before arenas were installed. */
+static wolfSSL_Free_cb wp_arena_prev_free = NULL;
+/** Reallocation callback in place before arenas were installed. */
+static wolfSSL_Realloc_cb wp_arena_prev_realloc = NULL;
+/** Total number of allocations from arenas. */
+static word64 wp_arena_allocs = 0;
+/** Total number of allocations during operations that did not fit. */
+static word64 wp_arena_fallbacks = 0;
+/** Total number of blocks not freed by the end of an operation. */
+static word64 wp_arena_escapes = 0;
+#ifdef WP_SINGLE_THREADED
+/** Only arena when single threaded. */
+static wp_Arena wp_arena_single;
+#else
+/** Key to the calling thread's arena. */
+static pthread_key_t wp_arena_key;
+/** Protects list of arenas, references and totals. */
+static pthread_mutex_t wp_arena_mutex = PTHREAD_MUTEX_INITIALIZER;
+/** List of all threads' arenas. */
+static wp_Arena* wp_arena_list = NULL;
+#endif
+
+/**
+ * Lock arena globals.
+ */
+static void wp_arena_lock(void)
+{
+#ifndef WP_SINGLE_THREADED
+    pthread_mutex_lock(&wp_arena_mutex);
+#endif
+}
+
+/**
+ * Unlock arena globals.
+ */
+static void wp_arena_unlock(void)
+{
+#ifndef WP_SINGLE_THREADED
+    pthread_mutex_unlock(&wp_arena_mutex);
+#endif
+}
+
+/**
+ * Change the state of an arena when in the expected state.
+ *
+ * @param [in, out] arena  Arena.
+ * @param [in]      from   Expected state.
+ * @param [in]      to     New state.
+ * @return  1 when state changed.
+ * @return  0 otherwise.
+ */
+static int wp_arena_set_state(wp_Arena* arena, int from, int to)
+{
+#ifdef WP_SINGLE_THREADED
+    int ok = (arena->state == from);
+
+    if (ok) {
+        arena->state = to;
+    }
+    return ok;
+#else
+    return __atomic_compare_exchange_n(&arena->state, &from, to, 0,
+        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#endif
+}
+
+/**
+ * Allocate memory with the allocator in place before arenas were installed.
+ *
+ * @param [in] size  Size of allocation in bytes.
+ * @return  Memory on success.
+ * @return  NULL on failure.
+ */
+static void* wp_arena_sys_malloc(size_t size)
+{
+    return (wp_arena_prev_malloc != NULL) ? wp_arena_prev_malloc(size) :
+        malloc(size);
+}
+
+/**
+ * Free memory with the allocator in place before arenas were installed.
+ *
+ * @param [in] ptr  Memory to free.
+ */
+static void wp_arena_sys_free(void* ptr)
+{
+    if (wp_arena_prev_free != NULL) {
+        wp_arena_prev_free(ptr);
+    }
+    else {
+        free(ptr);
+    }
+}
+
+/**
+ * Get the calling thread's arena.
+ *
+ * @return  Thread's arena when it has one.
+ * @return  NULL otherwise.
+ */
+static wp_Arena* wp_arena_get(void)
+{
+#ifdef WP_SINGLE_THREADED
+    return &wp_arena_single;
+#else
+    return (wp_Arena*)pthread_getspecific(wp_arena_key);
+#endif
+}
+
+/**
+ * Find a block handed out by the arena.
+ *
+ * @param [in] arena  Thread's arena.
+ * @param [in] ptr    Memory allocated by wolfCrypt.
+ * @return  Index of block when found.
+ * @return  -1 otherwise.
+ */
+static int wp_arena_find(const wp_Arena* arena, const void* ptr)
+{
+    int i;
+
+    for (i = arena->cnt - 1; i >= 0; i--) {
+        if (arena->block[i].used && (arena->block[i].ptr == ptr)) {
+            break;
+        }
+    }
+
+    return i;
+}
+
+/**
+ * Add the arena's counts to the totals.
+ *
+ * @param [in, out] arena  Arena.
+ */
+static void wp_arena_add_stats(wp_Arena* arena)
+{
+    if ((arena->allocs != 0) || (arena->fallbacks != 0) ||
+            (arena->escapes != 0)) {
+        wp_arena_lock();
+        wp_arena_allocs += arena->allocs;
+        wp_arena_fallbacks += arena->fallbacks;
+        wp_arena_escapes += arena->escapes;
+        wp_arena_unlock();
+        arena->allocs = 0;
+        arena->fallbacks = 0;
+        arena->escapes = 0;
+    }
+}
+
+/**
+ * Dispose of the blocks kept by an arena.
+ *
+ * Blocks still handed out are left to be freed with the previous allocator.
+ *
+ * @param [in, out] arena  Arena.
+ */
+static void wp_arena_release(wp_Arena* arena)
+{
+    int i;
+
+    for (i = 0; i < arena->cnt; i++) {
+        if (!arena->block[i].used) {
+            OPENSSL_cleanse(arena->block[i].ptr, arena->block[i].size);
+            wp_arena_sys_free(arena->block[i].ptr);
+        }
+    }
+    arena->cnt = 0;
+    arena->bytes = 0;
+}
+
+/**
+ * Take a block from the thread's arena.
+ *
+ * A kept block that is not too large is reused. Otherwise a new block is
+ * allocated when the arena has room.
+ *
+ * @param [in, out] arena  Thread's arena.
+ * @param [in]      size   Size of allocation in bytes.
+ * @return  Memory on success.
+ * @return  NULL when arena has no block to use.
+ */
+static void* wp_arena_take(wp_Arena* arena, size_t size)
+{
+    void* ptr = NULL;
+    int i;
+    int best = -1;
+    size_t need = (size + WP_ARENA_ROUND - 1) & ~((size_t)WP_ARENA_ROUND - 1);
+
+    if ((size > 0) && (need >= size)) {
+        for (i = 0; i < arena->cnt; i++) {
+            wp_ArenaBlock* b = &arena->block[i];
+
+            if ((!b->used) && (b->size >= need) && (b->size / 2 <= need) &&
+                    ((best < 0) || (b->size < arena->block[best].size))) {
+                best = i;
+            }
+        }
+        if ((best < 0) && (arena->cnt < WP_ARENA_BLOCKS) &&
+                (need <= wp_arena_size - arena->bytes)) {
+            ptr = wp_arena_sys_malloc(need);
+            if (ptr != NULL) {
+                best = arena->cnt++;
+                arena->block[best].ptr = ptr;
+                arena->block[best].size = need;
+                arena->bytes += need;
+            }
+        }
+    }
+    if (best >= 0) {
+        ptr = arena->block[best].ptr;
+        arena->block[best].used = 1;
+        arena->block[best].dirty = 1;
+        arena->allocs++;
+    }
+    else {
+        arena->fallbacks++;
+    }
+
+    return ptr;
+}
+
+/**
+ * Zeroize the blocks used in the operation and forget blocks not freed.
+ *
+ * Blocks not freed are owned by whatever wolfCrypt stored them in and are
+ * freed later with the previous allocator.
+ *
+ * @param [in, out] arena  Thread's arena.
+ */
+static void wp_arena_reset(wp_Arena* arena)
+{
+    int i;
+
+    for (i = arena->cnt - 1; i >= 0; i--) {
+        wp_ArenaBlock* b = &arena->block[i];
+
+        if (b->used) {
+            arena->bytes -= b->size;
+            arena->escapes++;
+            *b = arena->block[--arena->cnt];
+        }
+        else if (b->dirty) {
+            OPENSSL_cleanse(b->ptr, b->size);
+            b->dirty = 0;
+        }
+    }
+}
+
+/**
+ * Allocate memory for wolfCrypt.
+ *
+ * Allocated from the calling thread's arena during a public key operation.
+ * Otherwise, or when the arena has no room, the previous allocator is used.
+ *
+ * @param [in] size  Size of allocation in bytes.
+ * @return  Memory on success.
+ * @return  NULL on failure.
+ */
+static void* wp_arena_malloc(size_t size)
+{
+    void* ptr = NULL;
+    wp_Arena* arena = wp_arena_get();
+
+    if ((arena != NULL) && arena->active) {
+        ptr = wp_arena_take(arena, size);
+    }
+    if (ptr == NULL) {
+        ptr = wp_arena_sys_malloc(size);
+    }
+
+    return ptr;
+}
+
+/**
+ * Free memory allocated for wolfCrypt.
+ *
+ * Blocks of the thread's arena are kept for reuse.
+ *
+ * @param [in] ptr  Memory to free. May be NULL.
+ */
+static void wp_arena_free(void* ptr)
+{
+    if (ptr != NULL) {
+        wp_Arena* arena = wp_arena_get();
+        int i = -1;
+
+        if ((arena != NULL) && arena->active) {
+            i = wp_arena_find(arena, ptr);
+        }
+        if (i >= 0) {
+            arena->block[i].used = 0;
+        }
+        else {
+            wp_arena_sys_free(ptr);
+        }
+    }
+}
+
+/**
+ * Reallocate memory allocated for wolfCrypt.
+ *
+ * A block of the thread's arena is moved to a new allocation.
+ *
+ * @param [in] ptr   Memory to reallocate. May be NULL.
+ * @param [in] size  New size of allocation in bytes.
+ * @return  Memory on success.
+ * @return  NULL on failure.
+ */
+static void* wp_arena_realloc(void* ptr, size_t size)
+{
+    void* newPtr;
+    wp_Arena* arena = wp_arena_get();
+    int i = -1;
+
+    if ((ptr != NULL) && (arena != NULL) && arena->active) {
+        i = wp_arena_find(arena, ptr);
+    }
+    if (i >= 0) {
+        size_t oldSize = arena->block[i].size;
+
+        newPtr = wp_arena_malloc(size);
+        if (newPtr != NULL) {
+            XMEMCPY(newPtr, ptr, (oldSize < size) ? oldSize : size);
+            /* New blocks are appended - index still valid. */
+            arena->block[i].used = 0;
+        }
+    }
+    else if (wp_arena_prev_realloc != NULL) {
+        newPtr = wp_arena_prev_realloc(ptr, size);
+    }
+    else {
+        newPtr = realloc(ptr, size);
+    }
+
+    return newPtr;
+}
 
-#include <wolfprovider/internal.h>
+#ifndef WP_SINGLE_THREADED
+/**
+ * Drop a reference to an arena, freeing it when none are left.
+ *
+ * Call with arena globals locked.
+ *
+ * @param [in, out] arena  Arena.
+ */
+static void wp_arena_put_locked(wp_Arena* arena)
+{
+    if (--arena->refs == 0) {
+        wp_numa_clear_free(arena, sizeof(*arena));
+    }
+}
 
-#include <wolfssl/wolfcrypt/rsa.h>
+/**
+ * Remove an arena from the list of all threads' arenas.
+ *
+ * Call with arena globals locked.
+ *
+ * @param [in, out] arena  Arena.
+ */
+static void wp_arena_unlink_locked(wp_Arena* arena)
+{
+    if (arena->linked) {
+        if (arena->prev != NULL) {
+            arena->prev->next = arena->next;
+        }
+        else {
+            wp_arena_list = arena->next;
+        }
+        if (arena->next != NULL) {
+            arena->next->prev = arena->prev;
+        }
+        arena->linked = 0;
+        wp_arena_put_locked(arena);
+    }
+}
 
 /**
- * Get the wolfSSL random number generator from the provider context.
+ * Dispose of a thread's arena.
  *
- * @param [in] provCtx  Provider context.
- * @return  wolfSSL random number generator object.
+ * Called when the thread exits.
+ *
+ * @param [in] arg  Thread's arena.
  */
-WC_RNG *wp_provctx_get_rng(WOLFPROV_CTX* provCtx)
+static void wp_thread_arena_free(void* arg)
 {
-    return &provCtx->rng;
+    wp_Arena* arena = (wp_Arena*)arg;
+
+    wp_arena_add_stats(arena);
+    wp_arena_lock();
+    /* Blocks already disposed of when cleaned up. */
+    if (wp_arena_set_state(arena, WP_ARENA_IDLE, WP_ARENA_DEAD)) {
+        wp_arena_release(arena);
+    }
+    wp_arena_unlink_locked(arena);
+    wp_arena_put_locked(arena);
+    wp_arena_unlock();
 }
+#endif
 
-#ifndef WP_SINGLE_THREADED
 /**
- * Lock the random number generator in the provider context.
+ * Install arenas for wolfCrypt temporaries of public key operations.
  *
- * @param [in, out] provCtx  Provider context.
+ * RSA, DH and ECC operations allocate and free many temporary numbers. With
+ * arenas, allocations during an operation take blocks kept by the calling
+ * thread's arena, and the blocks are zeroized when the operation finishes.
+ * The wolfSSL allocator callbacks are replaced for the whole process -
+ * allocations outside of operations go to the previous allocator.
+ *
+ * @param [in] size  Size in bytes of blocks kept by each thread's arena. 0 to
+ *                   not use arenas.
  * @return  1 on success.
  * @return  0 on failure.
  */
-int wp_provctx_lock_rng(WOLFPROV_CTX* provCtx)
+int wp_arena_init(int size)
 {
     int ok = 1;
-    int rc;
 
-    rc = wc_LockMutex(&provCtx->rng_mutex);
-    if (rc != 0) {
+    if ((size < 0) || ((size > 0) && (size < WP_ARENA_MIN_SZ)) ||
+            (size > WP_ARENA_MAX_SZ)) {
         ok = 0;
     }
+    if (ok && (size > 0)) {
+        wp_arena_lock();
+        if (wp_arena_users == 0) {
+        #ifndef WP_SINGLE_THREADED
+            if (pthread_key_create(&wp_arena_key, wp_thread_arena_free) != 0) {
+                ok = 0;
+            }
+        #endif
+            if (ok && ((wolfSSL_GetAllocators(&wp_arena_prev_malloc,
+                    &wp_arena_prev_free, &wp_arena_prev_realloc) != 0) ||
+                    (wolfSSL_SetAllocators(wp_arena_malloc, wp_arena_free,
+                        wp_arena_realloc) != 0))) {
+            #ifndef WP_SINGLE_THREADED
+                pthread_key_delete(wp_arena_key);
+            #endif
+                ok = 0;
+            }
+            if (ok) {
+                /* First provider context to configure arenas sets size. */
+                wp_arena_size = (size_t)size;
+            }
+        }
+        if (ok) {
+        #ifdef WP_ATOMIC_REFCNT
+            __atomic_add_fetch(&wp_arena_users, 1, __ATOMIC_RELEASE);
+        #else
+            wp_arena_users++;
+        #endif
+        }
+        wp_arena_unlock();
+    }
 
     return ok;
 }
 
 /**
- * Unlock the random number generator in the provider context.
+ * Stop using arenas for wolfCrypt temporaries.
  *
- * @param [in, out] provCtx  Provider context.
+ * When the last user stops, the previous allocator callbacks are restored and
+ * the blocks kept by arenas disposed of. Blocks handed out are freed later
+ * with the previous allocator. A thread in an operation disposes of its own
+ * arena when the operation finishes. The arenas of other threads that are
+ * still running are freed when those threads exit - they are not freed here.
  */
-void wp_provctx_unlock_rng(WOLFPROV_CTX* provCtx)
+void wp_arena_cleanup(void)
 {
-    wc_UnLockMutex(&provCtx->rng_mutex);
+    wp_arena_lock();
+    if (wp_arena_users == 1) {
+    #ifndef WP_SINGLE_THREADED
+        wp_Arena* own = wp_arena_get();
+    #endif
+
+    #ifdef WP_ATOMIC_REFCNT
+        __atomic_store_n(&wp_arena_users, 0, __ATOMIC_RELEASE);
+    #else
+        wp_arena_users = 0;
+    #endif
+        /* No more allocations come to arenas. */
+        wolfSSL_SetAllocators(wp_arena_prev_malloc, wp_arena_prev_free,
+            wp_arena_prev_realloc);
+    #ifdef WP_SINGLE_THREADED
+        if (wp_arena_single.state == WP_ARENA_IDLE) {
+            wp_arena_release(&wp_arena_single);
+        }
+        else {
+            /* Disposed of when operation finishes. */
+            wp_arena_single.state = WP_ARENA_ORPHAN;
+        }
+    #else
+        while (wp_arena_list != NULL) {
+            wp_Arena* arena = wp_arena_list;
+
+            if (wp_arena_set_state(arena, WP_ARENA_IDLE, WP_ARENA_DEAD)) {
+                /* Thread not in operation - blocks can be disposed of. */
+                wp_arena_release(arena);
+            }
+            else {
+                /* Thread disposes of arena when operation finishes. */
+                (void)wp_arena_set_state(arena, WP_ARENA_BUSY,
+                    WP_ARENA_ORPHAN);
+            }
+            if ((arena == own) && (arena->state == WP_ARENA_DEAD)) {
+                /* Key deleted - thread's reference won't be dropped. */
+                wp_arena_put_locked(arena);
+            }
+            wp_arena_unlink_locked(arena);
+        }
+        /* Thread exits no longer call into provider. */
+        pthread_key_delete(wp_arena_key);
+    #endif
+    }
+    else if (wp_arena_users > 0) {
+    #ifdef WP_ATOMIC_REFCNT
+        __atomic_sub_fetch(&wp_arena_users, 1, __ATOMIC_RELEASE);
+    #else
+        wp_arena_users--;
+    #endif
+    }
+    wp_arena_unlock();
 }
+
+/**
+ * Start a public key operation - wolfCrypt allocations use the arena.
+ *
+ * Operations may be nested. Must be matched with wp_arena_end().
+ *
+ * @return  Thread's arena to pass to wp_arena_end().
+ * @return  NULL when arenas not used.
+ */
+wp_Arena* wp_arena_begin(void)
+{
+    wp_Arena* arena = NULL;
+
+#ifdef WP_ATOMIC_REFCNT
+    if (__atomic_load_n(&wp_arena_users, __ATOMIC_ACQUIRE) > 0)
+#else
+    if (wp_arena_users > 0)
 #endif
+    {
+        arena = wp_arena_get();
+    #ifndef WP_SINGLE_THREADED
+        if (arena == NULL) {
+            arena = (wp_Arena*)wp_numa_zalloc(sizeof(*arena));
+            if ((arena != NULL) &&
+                    (pthread_setspecific(wp_arena_key, arena) != 0)) {
+                wp_numa_clear_free(arena, sizeof(*arena));
+                arena = NULL;
+            }
+            if (arena != NULL) {
+                /* Referenced by thread and list. */
+                arena->refs = 2;
+                wp_arena_lock();
+                arena->linked = 1;
+                arena->next = wp_arena_list;
+                if (wp_arena_list != NULL) {
+                    wp_arena_list->prev = arena;
+                }
+                wp_arena_list = arena;
+                wp_arena_unlock();
+            }
+        }
+    #endif
+    }
+    if (arena != NULL) {
+        if ((arena->depth == 0) &&
+                wp_arena_set_state(arena, WP_ARENA_IDLE, WP_ARENA_BUSY)) {
+            arena->active = 1;
+        }
+        arena->depth++;
+    }
+
+    return arena;
+}
+
+/**
+ * Finish a public key operation.
+ *
+ * When the outermost operation finishes, blocks freed are zeroized and kept
+ * for the next operation. Blocks not freed are left to the previous
+ * allocator.
+ *
+ * @param [in, out] arena  Arena returned by wp_arena_begin(). May be NULL.
+ */
+void wp_arena_end(wp_Arena* arena)
+{
+    if ((arena != NULL) && (--arena->depth == 0) && arena->active) {
+        arena->active = 0;
+        wp_arena_reset(arena);
+        wp_arena_add_stats(arena);
+        if (!wp_arena_set_state(arena, WP_ARENA_BUSY, WP_ARENA_IDLE)) {
+            /* Cleaned up during operation - dispose of own arena. */
+            wp_arena_release(arena);
+        #ifdef WP_SINGLE_THREADED
+            arena->state = WP_ARENA_IDLE;
+        #else
+            arena->state = WP_ARENA_DEAD;
+            wp_arena_lock();
+            /* Key deleted - drop thread's reference here. */
+            wp_arena_put_locked(arena);
+            wp_arena_unlock();
+        #endif
+        }
+    }
+}
+
+/**
+ * Get the statistics of the arenas.
+ *
+ * @param [out] allocs     Number of allocations from arenas.
+ * @param [out] fallbacks  Number of allocations during operations that did
+ *                         not fit in the arena.
+ * @param [out] escapes    Number of allocations not freed by the end of an
+ *                         operation.
+ */
+void wp_arena_stats(word64* allocs, word64* fallbacks, word64* escapes)
+{
+    wp_arena_lock();
+    *allocs = wp_arena_allocs;
+    *fallbacks = wp_arena_fallbacks;
+    *escapes = wp_arena_escapes;
+    wp_arena_unlock();
+}
+
+#else
+
+/**
+ * Install arenas for wolfCrypt temporaries of public key operations.
+ *
+ * wolfSSL not built with replaceable allocator callbacks.
+ *
+ * @param [in] size  Size in bytes of blocks kept by each thread's arena. 0 to
+ *                   not use arenas.
+ * @return  1 when size is 0.
+ * @return  0 otherwise.
+ */
+int wp_arena_init(int size)
+{
+    return (size == 0);
+}
+
+/**
+ * Stop using arenas for wolfCrypt temporaries.
+ */
+void wp_arena_cleanup(void)
+{
+}
+
+/**
+ * Start a public key operation.
+ *
+ * @return  NULL always.
+ */
+wp_Arena* wp_arena_begin(void)
+{
+    return NULL;
+}
+
+/**
+ * Finish a public key operation.
+ *
+ * @param [in] arena  Arena returned by wp_arena_begin(). Unused.
+ */
+void wp_arena_end(wp_Arena* arena)
+{
+    (void)arena;
+}
+
+/**
+ * Get the statistics of the arenas. Always 0.
+ *
+ * @param [out] allocs     Number of allocations from arenas.
+ * @param [out] fallbacks  Number of allocations during operations that did
+ *                         not fit in the arena.
+ * @param [out] escapes    Number of allocations not freed by the end of an
+ *                         operation.
+ */
+void wp_arena_stats(word64* allocs, word64* fallbacks, word64* escapes)
+{
+    *allocs = 0;
+    *fallbacks = 0;
+    *escapes = 0;
+}
+
+#endif /* WP_HAVE_ARENA */
+
+
+/**
+ * Look up a digest by name.
+ *
+ * Fetching a digest from the library context is expensive and is done for
+ * every signature, KDF and MAC that is set up. Results are cached per thread
+ * so no locking is needed. Names and property queries too long to cache are
+ * always fetched.
+ *
+ * @param [in]  libCtx    Library context to lookup string.
+ * @param [in]  name      String name of digest.
+ * @param [in]  propQ     Property query of digest to lookup.
+ * @param [out] nid       OpenSSL NID of digest.
+ * @param [out] hashType  wolfCrypt hash type of digest.
+ * @return  1 on success.
+ * @return  0 when the digest is not available.
+ */
+static int wp_md_lookup(OSSL_LIB_CTX* libCtx, const char* name,
+    const char* propQ, int* nid, enum wc_HashType* hashType)
+{
+    int ok = 1;
+    wp_ThreadCache* cache = NULL;
+    wp_MdCacheEntry* entry = NULL;
+    int i;
+
+    if (propQ == NULL) {
+        propQ = "";
+    }
+    if ((name != NULL) && (XSTRLEN(name) < WP_MD_CACHE_NAME_SZ) &&
+            (XSTRLEN(propQ) < WP_MD_CACHE_NAME_SZ)) {
+        cache = wp_thread_cache_get();
+    }
+    for (i = 0; (cache != NULL) && (i < WP_MD_CACHE_SIZE); i++) {
+        if ((cache->md[i].name[0] != '\0') &&
+                (cache->md[i].libCtx == libCtx) &&
+                (XSTRNCMP(cache->md[i].name, name, WP_MD_CACHE_NAME_SZ) == 0) &&
+                (XSTRNCMP(cache->md[i].propQ, propQ,
+                    WP_MD_CACHE_NAME_SZ) == 0)) {
+            entry = &cache->md[i];
+            break;
+        }
+    }
+
+    if (entry != NULL) {
+        *nid = entry->nid;
+        *hashType = entry->hashType;
+    }
+    else {
+        EVP_MD* md = EVP_MD_fetch(libCtx, name, propQ);
+        if (md == NULL) {
+            ok = 0;
+        }
+        else {
+            *nid = EVP_MD_type(md);
+            *hashType = wp_nid_to_wc_hash_type(*nid);
+            EVP_MD_free(md);
+        }
+        if (ok && (cache != NULL) && (name[0] != '\0')) {
+            entry = &cache->md[cache->mdNext];
+            cache->mdNext = (cache->mdNext + 1) % WP_MD_CACHE_SIZE;
+            entry->libCtx = libCtx;
+            XSTRNCPY(entry->name, name, WP_MD_CACHE_NAME_SZ);
+            XSTRNCPY(entry->propQ, propQ, WP_MD_CACHE_NAME_SZ);
+            entry->nid = *nid;
+            entry->hashType = *hashType;
+        }
+    }
 
+    return ok;
+}
 
 /**
  * Convert the string name of an object to an OpenSSL Numeric ID (NID).
@@ -80,11 +2037,12 @@ void wp_provctx_unlock_rng(WOLFPROV_CTX* provCtx)
  */
 int wp_name_to_nid(OSSL_LIB_CTX* libCtx, const char* name, const char* propQ)
 {
-    int nid;
+    int nid = NID_undef;
+    enum wc_HashType hashType;
 
-    EVP_MD* md = EVP_MD_fetch(libCtx, name, propQ);
-    nid = EVP_MD_type(md);
-    EVP_MD_free(md);
+    if (!wp_md_lookup(libCtx, name, propQ, &nid, &hashType)) {
+        nid = NID_undef;
+    }
 
     return nid;
 }
@@ -102,11 +2060,10 @@ enum wc_HashType wp_name_to_wc_hash_type(OSSL_LIB_CTX* libCtx, const char* name,
     const char* propQ)
 {
     enum wc_HashType ret = WC_HASH_TYPE_NONE;
+    int nid;
 
-    EVP_MD* md = EVP_MD_fetch(libCtx, name, propQ);
-    if (md != NULL) {
-        ret = wp_nid_to_wc_hash_type(EVP_MD_type(md));
-        EVP_MD_free(md);
+    if (!wp_md_lookup(libCtx, name, propQ, &nid, &ret)) {
+        ret = WC_HASH_TYPE_NONE;
     }
 
     return ret;
@@ -182,13 +2139,7 @@ enum wc_HashType wp_nid_to_wc_hash_type(int nid)
 int wp_name_to_wc_mgf(OSSL_LIB_CTX* libCtx, const char* name,
     const char* propQ)
 {
-    int ret;
-
-    EVP_MD* md = EVP_MD_fetch(libCtx, name, propQ);
-    ret = wp_mgf1_from_hash(EVP_MD_type(md));
-    EVP_MD_free(md);
-
-    return ret;
+    return wp_mgf1_from_hash(wp_name_to_nid(libCtx, name, propQ));
 }
 
 /**
@@ -352,16 +2303,15 @@ int wp_encrypt_key(WOLFPROV_CTX* provCtx, const char* cipherName,
         /* Calculate random IV. */
         WC_RNG* rng = wp_provctx_get_rng(provCtx);
 
-    #ifndef WP_SINGLE_THREADED
-        wp_provctx_lock_rng(provCtx);
-    #endif
-        rc = wc_RNG_GenerateBlock(rng, info->iv, info->ivSz);
-    #ifndef WP_SINGLE_THREADED
-        wp_provctx_unlock_rng(provCtx);
-    #endif
-        if (rc < 0) {
+        if (rng == NULL) {
             ok = 0;
         }
+        else {
+            rc = wc_RNG_GenerateBlock(rng, info->iv, info->ivSz);
+            if (rc < 0) {
+                ok = 0;
+            }
+        }
     }
     if (ok) {
         /* Pad with zeros. */
@@ -414,46 +2364,142 @@ struct ossl_core_bio_st {
     BIO *bio;
 };
 
+/** Size of buffer to start reading into when BIO doesn't know its size. */
+#define WP_READ_BIO_INIT_SIZE       4096
+/** Maximum amount of data to read out of a BIO. */
+#define WP_READ_BIO_MAX_SIZE        0x7fffffff
+
 /**
- * Read data out of the core BIO.
+ * Get the amount of data that a BIO has left to read.
  *
- * @param [in] coreBIO  Core BIO.
- * @param [out] data    New buffer holding data read.
- * @param [out] len     Length of data read.
+ * Memory BIOs know how much data is pending. For file BIOs the remainder of
+ * the file is used.
+ *
+ * @param [in] bio  BIO to read from.
+ * @return  Number of bytes expected to be read.
+ * @return  0 when not known.
+ */
+static size_t wp_bio_size_hint(BIO* bio)
+{
+    size_t hint = BIO_ctrl_pending(bio);
+
+    if ((hint == 0) && (BIO_method_type(bio) == BIO_TYPE_FILE)) {
+        FILE* fp = NULL;
+        struct stat st;
+        long pos;
+
+        if ((BIO_get_fp(bio, &fp) == 1) && (fp != NULL) &&
+                (fstat(fileno(fp), &st) == 0) && S_ISREG(st.st_mode)) {
+            pos = ftell(fp);
+            if ((pos >= 0) && (st.st_size > pos)) {
+                hint = (size_t)(st.st_size - pos);
+            }
+        }
+    }
+
+    return hint;
+}
+
+/**
+ * Read all remaining data out of a BIO.
+ *
+ * Reads directly into a buffer sized from the BIO when possible and grows it
+ * geometrically otherwise, so large inputs are not repeatedly copied.
+ *
+ * @param [in]  bio   BIO to read from.
+ * @param [out] data  New buffer holding data read.
+ * @param [out] len   Length of data read.
  * @return  1 on success.
  * @return  0 on failure.
  */
-int wp_read_der_bio(OSSL_CORE_BIO *coreBio, unsigned char** data, word32* len)
+int wp_read_bio(BIO* bio, unsigned char** data, word32* len)
 {
     int ok = 1;
-    long readLen;
-    unsigned char buf[128]; /* Read 128 bytes at a time. */
+    int readLen;
+    size_t size = 0;
+    size_t hint;
+    size_t readSz;
     unsigned char* p;
 
-    do {
-        readLen = BIO_read(coreBio->bio, buf, sizeof(buf));
-        if (readLen < -1) {
+    if (*len >= WP_READ_BIO_MAX_SIZE) {
+        ok = 0;
+    }
+    if (ok) {
+        hint = wp_bio_size_hint(bio);
+        /* Extra byte must not take size past maximum. */
+        if ((hint == 0) || (hint >= (size_t)WP_READ_BIO_MAX_SIZE - *len)) {
+            hint = WP_READ_BIO_INIT_SIZE;
+        }
+        /* One extra byte so that reaching the end doesn't require growing. */
+        size = *len + hint + 1;
+        p = OPENSSL_realloc(*data, size);
+        if (p == NULL) {
             ok = 0;
         }
-        if (ok && (readLen > 0)) {
-            /* Reallocate for new data. */
-            p = OPENSSL_realloc(*data, *len + readLen);
-            if (p == NULL) {
+        else {
+            *data = p;
+        }
+    }
+
+    while (ok) {
+        if (*len == size) {
+            /* Buffer full - double size. */
+            if (size > WP_READ_BIO_MAX_SIZE / 2) {
                 ok = 0;
             }
+            else {
+                p = OPENSSL_realloc(*data, size * 2);
+                if (p == NULL) {
+                    ok = 0;
+                }
+                else {
+                    *data = p;
+                    size *= 2;
+                }
+            }
         }
-        if (ok && (readLen > 0)) {
-            *data = p;
-            /* Copy in new data. */
-            XMEMCPY(*data + *len, buf, readLen);
-            *len += readLen;
+        if (ok) {
+            readSz = size - *len;
+            /* BIO_read takes an int length. */
+            if (readSz > INT_MAX) {
+                readSz = INT_MAX;
+            }
+            readLen = BIO_read(bio, *data + *len, (int)readSz);
+            if (readLen < -1) {
+                ok = 0;
+            }
+            else if (readLen <= 0) {
+                /* No more data. */
+                break;
+            }
+            else {
+                *len += readLen;
+            }
         }
     }
-    while (ok && (readLen > 0));
+    if (ok && (*len == 0)) {
+        /* No data read - callers expect no buffer. */
+        OPENSSL_free(*data);
+        *data = NULL;
+    }
 
     return ok;
 }
 
+/**
+ * Read data out of the core BIO.
+ *
+ * @param [in] coreBIO  Core BIO.
+ * @param [out] data    New buffer holding data read.
+ * @param [out] len     Length of data read.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+int wp_read_der_bio(OSSL_CORE_BIO *coreBio, unsigned char** data, word32* len)
+{
+    return wp_read_bio(coreBio->bio, data, len);
+}
+
 /**
  * Get the underlying BIO from the core BIO.
  *
@@ -467,6 +2513,114 @@ BIO* wp_corebio_get_bio(OSSL_CORE_BIO *coreBio)
 }
 
 
+/** Size of the length prefix of each field of batch data. */
+#define WP_BATCH_LEN_SZ     4
+
+/**
+ * Get the next length prefixed field of batch data.
+ *
+ * Each field is a 4 byte big-endian length followed by that many bytes.
+ *
+ * @param [in]      data    Batch data.
+ * @param [in]      len     Length of batch data in bytes.
+ * @param [in, out] idx     Index into data. Updated to after field.
+ * @param [out]     field   Start of field's data.
+ * @param [out]     fLen    Length of field's data in bytes.
+ * @return  1 on success.
+ * @return  0 when data is truncated.
+ */
+int wp_batch_get_field(const unsigned char* data, size_t len, size_t* idx,
+    const unsigned char** field, size_t* fLen)
+{
+    int ok = 1;
+    size_t l = 0;
+
+    if (len - *idx < WP_BATCH_LEN_SZ) {
+        ok = 0;
+    }
+    if (ok) {
+        l = ((size_t)data[*idx + 0] << 24) | ((size_t)data[*idx + 1] << 16) |
+            ((size_t)data[*idx + 2] <<  8) | ((size_t)data[*idx + 3] <<  0);
+        *idx += WP_BATCH_LEN_SZ;
+        if (len - *idx < l) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        *field = data + *idx;
+        *fLen = l;
+        *idx += l;
+    }
+
+    return ok;
+}
+
+/**
+ * Verify a batch of signatures against the one key of a signature context.
+ *
+ * Format of data is described with WP_SIGNATURE_PARAM_BATCH_VERIFY.
+ * A signature that fails to verify only clears its bit in the result. Data
+ * that is badly formatted fails the whole batch.
+ *
+ * @param [in]      ctx     Signature context object.
+ * @param [in]      verify  Function to verify one item.
+ * @param [in]      data    Batch verification data.
+ * @param [in]      len     Length of batch verification data in bytes.
+ * @param [in, out] res     Bitmap of results. Previous bitmap freed.
+ * @param [in, out] resLen  Length of bitmap in bytes.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+int wp_batch_verify(void* ctx, WP_BATCH_VERIFY_FN verify,
+    const unsigned char* data, size_t len, unsigned char** res,
+    size_t* resLen)
+{
+    int ok = 1;
+    size_t idx = 0;
+    size_t cnt = 0;
+    size_t i;
+    const unsigned char* tbs = NULL;
+    size_t tbsLen = 0;
+    const unsigned char* sig = NULL;
+    size_t sigLen = 0;
+    unsigned char* bits = NULL;
+    size_t bitsLen = 0;
+
+    /* Validate format and count items before verifying any. */
+    while (ok && (idx < len)) {
+        if ((!wp_batch_get_field(data, len, &idx, &tbs, &tbsLen)) ||
+                (!wp_batch_get_field(data, len, &idx, &sig, &sigLen))) {
+            ok = 0;
+        }
+        else {
+            cnt++;
+        }
+    }
+    if (ok) {
+        bitsLen = (cnt + 7) / 8;
+        /* Always allocate so that result is distinct from no batch. */
+        bits = (unsigned char*)OPENSSL_zalloc(bitsLen + 1);
+        if (bits == NULL) {
+            ok = 0;
+        }
+    }
+    for (i = 0, idx = 0; ok && (i < cnt); i++) {
+        (void)wp_batch_get_field(data, len, &idx, &tbs, &tbsLen);
+        (void)wp_batch_get_field(data, len, &idx, &sig, &sigLen);
+        if (verify(ctx, sig, sigLen, tbs, tbsLen) == 1) {
+            bits[i / 8] |= (unsigned char)(1 << (i % 8));
+        }
+    }
+    if (ok) {
+        OPENSSL_free(*res);
+        *res = bits;
+        *resLen = bitsLen;
+    }
+
+    return ok;
+}
+
+
 /**
  * Constant time, set mask when first value is equal to second.
  *
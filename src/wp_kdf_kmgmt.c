@@ -35,12 +35,8 @@
  * Dummy key object. For support of using KDFs with EVP_PKEY_derive().
  */
 struct wp_Kdf {
-#ifndef WP_SINGLE_THREADED
-    /** Mutex for reference count updating. */
-    wolfSSL_Mutex mutex;
-#endif
     /** Count of references to this object. */
-    int refCnt;
+    wp_RefCnt refCnt;
 };
 
 /**
@@ -54,24 +50,7 @@ struct wp_Kdf {
  */
 int wp_kdf_up_ref(wp_Kdf* kdf)
 {
-#ifndef WP_SINGLE_THREADED
-    int ok = 1;
-    int rc;
-
-    rc = wc_LockMutex(&kdf->mutex);
-    if (rc < 0) {
-        ok = 0;
-    }
-    if (ok) {
-        kdf->refCnt++;
-        wc_UnLockMutex(&kdf->mutex);
-    }
-
-    return ok;
-#else
-    kdf->refCnt++;
-    return 1;
-#endif
+    return wp_refcnt_up(&kdf->refCnt);
 }
 
 /**
@@ -90,18 +69,9 @@ static wp_Kdf* wp_kdf_new(WOLFPROV_CTX *provCtx)
     if (wolfssl_prov_is_running()) {
         kdf = (wp_Kdf*)OPENSSL_zalloc(sizeof(*kdf));
     }
-    if (kdf != NULL) {
-    #ifndef SINGLE_THREADED
-        int rc = wc_InitMutex(&kdf->mutex);
-        if (rc != 0) {
-            OPENSSL_free(kdf);
-            kdf = NULL;
-        }
-        else
-    #endif
-        {
-            kdf->refCnt = 1;
-        }
+    if ((kdf != NULL) && (!wp_refcnt_init(&kdf->refCnt))) {
+        OPENSSL_free(kdf);
+        kdf = NULL;
     }
 
     return kdf;
@@ -115,23 +85,10 @@ static wp_Kdf* wp_kdf_new(WOLFPROV_CTX *provCtx)
 void wp_kdf_free(wp_Kdf* kdf)
 {
     if (kdf != NULL) {
-        int cnt;
-    #ifndef WP_SINGLE_THREADED
-        int rc;
-
-        rc = wc_LockMutex(&kdf->mutex);
-        cnt = --kdf->refCnt;
-        if (rc == 0) {
-            wc_UnLockMutex(&kdf->mutex);
-        }
-    #else
-        cnt = --kdf->refCnt;
-    #endif
+        int cnt = wp_refcnt_down(&kdf->refCnt);
 
         if (cnt == 0) {
-    #ifndef WP_SINGLE_THREADED
-            wc_FreeMutex(&kdf->mutex);
-    #endif
+            wp_refcnt_free(&kdf->refCnt);
             OPENSSL_free(kdf);
         }
     }
@@ -0,0 +1,461 @@
+/* wp_key_pool.c
+ *
+ * Copyright (C) 2021 wolfSSL Inc.
+ *
+ * This file is part of wolfProvider.
+ *
+ * wolfProvider is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfProvider is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wolfProvider.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <unistd.h>
+
+#include <openssl/evp.h>
+
+#include <wolfprovider/internal.h>
+
+/*
+ * Pool of pre-generated ephemeral key pairs.
+ *
+ * Key generation for ECDHE, X25519/X448 and the ML-KEM hybrids is on the
+ * critical path of every TLS handshake. When configured, background threads generate key pairs
+ * ahead of time for each curve that has been used and key generation takes
+ * one from the pool. RSA key pairs of common sizes, which take far longer to
+ * generate, have their own depth so they can be pooled independently.
+ *
+ * A slot of the pool becomes active the first time a key is requested for it
+ * so that no keys are generated for curves that are never used. Threads are
+ * started on the first request so that loading the provider stays cheap.
+ *
+ * A forked child must not hand out the keys its parent and siblings also
+ * have. On the first use in a new process, the keys inherited are disposed
+ * of and the threads, which don't exist in the child, are started again.
+ */
+
+#ifndef WP_SINGLE_THREADED
+
+/** Maximum number of keys to keep for each curve. */
+#define WP_KEY_POOL_MAX_DEPTH       1024
+/** Maximum number of threads to generate keys on. */
+#define WP_KEY_POOL_MAX_THREADS     8
+
+/**
+ * Keys of one curve.
+ */
+typedef struct wp_KeyPoolSlot {
+    /** Function to generate a key with. NULL when slot not active. */
+    WP_KEY_POOL_GEN_FN gen;
+    /** Function to dispose of a key with. */
+    WP_KEY_POOL_FREE_FN freeKey;
+    /** Argument to pass to generation function. */
+    const void* arg;
+    /** Keys that have been generated. */
+    void** keys;
+    /** Number of keys available. */
+    int cnt;
+    /** Maximum number of keys to keep. 0 when slot not pooled. */
+    int depth;
+} wp_KeyPoolSlot;
+
+/**
+ * Key pool object.
+ */
+struct wp_KeyPool {
+    /** Provider context to generate keys with. */
+    WOLFPROV_CTX* provCtx;
+    /** Key slots - one per curve or RSA key size. */
+    wp_KeyPoolSlot slot[WP_KEY_POOL_CNT];
+    /** Threads generating keys. */
+    pthread_t thread[WP_KEY_POOL_MAX_THREADS];
+    /** Number of threads to start on first request. */
+    int threadMax;
+    /** Number of threads started. */
+    int threadCnt;
+    /** Threads have been started. */
+    int started;
+    /** Threads are to stop. */
+    int stop;
+    /** Process that filled the pool. 0 while being flushed after fork. */
+    pid_t pid;
+    /** Mutex protecting slots. */
+    pthread_mutex_t mutex;
+    /** Condition signalled when a key is taken or on stop. */
+    pthread_cond_t cond;
+};
+
+/**
+ * Find an active slot that is not full.
+ *
+ * Call with mutex locked.
+ *
+ * @param [in] pool  Key pool object.
+ * @return  Slot to fill on success.
+ * @return  NULL when no slot needs filling.
+ */
+static wp_KeyPoolSlot* wp_key_pool_find_empty(wp_KeyPool* pool)
+{
+    wp_KeyPoolSlot* slot = NULL;
+    int i;
+
+    for (i = 0; i < WP_KEY_POOL_CNT; i++) {
+        if ((pool->slot[i].gen != NULL) &&
+                (pool->slot[i].cnt < pool->slot[i].depth)) {
+            slot = &pool->slot[i];
+            break;
+        }
+    }
+
+    return slot;
+}
+
+/**
+ * Generate keys into the active slots until the pool is stopped.
+ *
+ * @param [in] arg  Key pool object.
+ * @return  NULL always.
+ */
+static void* wp_key_pool_thread(void* arg)
+{
+    wp_KeyPool* pool = (wp_KeyPool*)arg;
+    wp_KeyPoolSlot* slot;
+    WP_KEY_POOL_GEN_FN gen;
+    const void* genArg;
+    void* key;
+
+    pthread_mutex_lock(&pool->mutex);
+    while (!pool->stop) {
+        slot = wp_key_pool_find_empty(pool);
+        if (slot == NULL) {
+            pthread_cond_wait(&pool->cond, &pool->mutex);
+            continue;
+        }
+
+        /* Generate without holding lock. */
+        gen = slot->gen;
+        genArg = slot->arg;
+        pthread_mutex_unlock(&pool->mutex);
+        key = gen(pool->provCtx, genArg);
+        pthread_mutex_lock(&pool->mutex);
+
+        if (key == NULL) {
+            /* Stop filling slot rather than retrying failures. */
+            slot->gen = NULL;
+        }
+        else if ((!pool->stop) && (slot->cnt < slot->depth)) {
+            slot->keys[slot->cnt++] = key;
+        }
+        else {
+            slot->freeKey(key);
+        }
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+    return NULL;
+}
+
+/**
+ * Dispose of the keys inherited from the parent process after fork.
+ *
+ * Threads aren't duplicated by fork() and the mutex may have been held by one
+ * of them, so the synchronization objects are created again. Threads are
+ * started on the next request.
+ *
+ * @param [in, out] pool  Key pool object.
+ */
+static void wp_key_pool_flush(wp_KeyPool* pool)
+{
+    int i;
+    int j;
+
+    (void)pthread_mutex_init(&pool->mutex, NULL);
+    (void)pthread_cond_init(&pool->cond, NULL);
+    for (i = 0; i < WP_KEY_POOL_CNT; i++) {
+        for (j = 0; j < pool->slot[i].cnt; j++) {
+            pool->slot[i].freeKey(pool->slot[i].keys[j]);
+            pool->slot[i].keys[j] = NULL;
+        }
+        pool->slot[i].cnt = 0;
+    }
+    pool->threadCnt = 0;
+    pool->started = 0;
+}
+
+/**
+ * Check the key pool belongs to this process, flushing it after fork.
+ *
+ * When another thread of the child is flushing the pool, the pool is not
+ * used for this call.
+ *
+ * @param [in, out] pool  Key pool object.
+ * @return  1 when pool can be used.
+ * @return  0 otherwise.
+ */
+static int wp_key_pool_check_pid(wp_KeyPool* pool)
+{
+    int ok = 1;
+    pid_t pid = getpid();
+#ifdef WP_ATOMIC_REFCNT
+    pid_t poolPid = __atomic_load_n(&pool->pid, __ATOMIC_ACQUIRE);
+
+    if (poolPid != pid) {
+        /* Only one thread flushes - others use no pool until done. */
+        ok = (poolPid != 0) && __atomic_compare_exchange_n(&pool->pid,
+            &poolPid, 0, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+        if (ok) {
+            wp_key_pool_flush(pool);
+            __atomic_store_n(&pool->pid, pid, __ATOMIC_RELEASE);
+        }
+    }
+#else
+    if (pool->pid != pid) {
+        wp_key_pool_flush(pool);
+        pool->pid = pid;
+    }
+#endif
+
+    return ok;
+}
+
+/**
+ * Start the threads that fill the key pool.
+ *
+ * Call with mutex locked.
+ *
+ * @param [in, out] pool  Key pool object.
+ */
+static void wp_key_pool_start(wp_KeyPool* pool)
+{
+    int i;
+
+    pool->started = 1;
+    for (i = 0; i < pool->threadMax; i++) {
+        if (pthread_create(&pool->thread[i], NULL, wp_key_pool_thread,
+                pool) != 0) {
+            break;
+        }
+        pool->threadCnt++;
+    }
+}
+
+/**
+ * Create the key pool.
+ *
+ * Key pool is only created when a depth and number of threads are not zero.
+ * Threads that fill it are started when the first key is requested.
+ *
+ * @param [in, out] provCtx   Provider context.
+ * @param [in]      depth     Maximum number of keys to keep for each curve.
+ * @param [in]      rsaDepth  Maximum number of keys to keep for each RSA key
+ *                            size.
+ * @param [in]      threads   Number of threads to generate keys on.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+int wp_key_pool_init(WOLFPROV_CTX* provCtx, int depth, int rsaDepth,
+    int threads)
+{
+    int ok = 1;
+    int i;
+    wp_KeyPool* pool = NULL;
+
+    if (depth < 0) {
+        depth = 0;
+    }
+    if (rsaDepth < 0) {
+        rsaDepth = 0;
+    }
+    if (((depth > 0) || (rsaDepth > 0)) && (threads > 0)) {
+        if (depth > WP_KEY_POOL_MAX_DEPTH) {
+            depth = WP_KEY_POOL_MAX_DEPTH;
+        }
+        if (rsaDepth > WP_KEY_POOL_MAX_DEPTH) {
+            rsaDepth = WP_KEY_POOL_MAX_DEPTH;
+        }
+        if (threads > WP_KEY_POOL_MAX_THREADS) {
+            threads = WP_KEY_POOL_MAX_THREADS;
+        }
+
+        pool = (wp_KeyPool*)OPENSSL_zalloc(sizeof(*pool));
+        if (pool == NULL) {
+            ok = 0;
+        }
+    }
+    for (i = 0; ok && (pool != NULL) && (i < WP_KEY_POOL_CNT); i++) {
+        pool->slot[i].depth = (i >= WP_KEY_POOL_RSA_FIRST) ? rsaDepth : depth;
+        if (pool->slot[i].depth > 0) {
+            pool->slot[i].keys = (void**)OPENSSL_zalloc(
+                pool->slot[i].depth * sizeof(void*));
+            if (pool->slot[i].keys == NULL) {
+                ok = 0;
+            }
+        }
+    }
+    if (ok && (pool != NULL)) {
+        pool->provCtx = provCtx;
+        if (pthread_mutex_init(&pool->mutex, NULL) != 0) {
+            ok = 0;
+        }
+        else if (pthread_cond_init(&pool->cond, NULL) != 0) {
+            pthread_mutex_destroy(&pool->mutex);
+            ok = 0;
+        }
+    }
+    if (ok && (pool != NULL)) {
+        pool->threadMax = threads;
+        pool->pid = getpid();
+        provCtx->keyPool = pool;
+    }
+    else if (pool != NULL) {
+        for (i = 0; i < WP_KEY_POOL_CNT; i++) {
+            OPENSSL_free(pool->slot[i].keys);
+        }
+        OPENSSL_free(pool);
+    }
+
+    return ok;
+}
+
+/**
+ * Stop the threads and dispose of the key pool and the keys in it.
+ *
+ * @param [in, out] provCtx  Provider context.
+ */
+void wp_key_pool_free(WOLFPROV_CTX* provCtx)
+{
+    wp_KeyPool* pool = provCtx->keyPool;
+
+    if (pool != NULL) {
+        int i;
+        int j;
+
+        /* Child doesn't have the parent's threads to stop. */
+        (void)wp_key_pool_check_pid(pool);
+        pthread_mutex_lock(&pool->mutex);
+        pool->stop = 1;
+        pthread_cond_broadcast(&pool->cond);
+        pthread_mutex_unlock(&pool->mutex);
+        for (i = 0; i < pool->threadCnt; i++) {
+            pthread_join(pool->thread[i], NULL);
+        }
+
+        for (i = 0; i < WP_KEY_POOL_CNT; i++) {
+            for (j = 0; j < pool->slot[i].cnt; j++) {
+                pool->slot[i].freeKey(pool->slot[i].keys[j]);
+            }
+            OPENSSL_free(pool->slot[i].keys);
+        }
+        pthread_cond_destroy(&pool->cond);
+        pthread_mutex_destroy(&pool->mutex);
+        OPENSSL_free(pool);
+        provCtx->keyPool = NULL;
+    }
+}
+
+/**
+ * Take a pre-generated key from the pool.
+ *
+ * First request for a slot activates it so that threads start filling it.
+ * Keys generated in a parent process are never returned after fork.
+ *
+ * @param [in] provCtx  Provider context.
+ * @param [in] id       Slot of pool. WP_KEY_POOL_* value.
+ * @param [in] gen      Function to generate a key for slot.
+ * @param [in] freeKey  Function to dispose of a key of slot.
+ * @param [in] arg      Argument to pass to generation function.
+ * @return  Key on success.
+ * @return  NULL when no pool configured or no key available.
+ */
+void* wp_key_pool_get(WOLFPROV_CTX* provCtx, int id, WP_KEY_POOL_GEN_FN gen,
+    WP_KEY_POOL_FREE_FN freeKey, const void* arg)
+{
+    void* key = NULL;
+    wp_KeyPool* pool = provCtx->keyPool;
+
+    if ((pool != NULL) && (id >= 0) && (id < WP_KEY_POOL_CNT) &&
+            (pool->slot[id].depth > 0) && wp_key_pool_check_pid(pool)) {
+        wp_KeyPoolSlot* slot = &pool->slot[id];
+
+        pthread_mutex_lock(&pool->mutex);
+        if (!pool->started) {
+            wp_key_pool_start(pool);
+        }
+        if ((slot->gen == NULL) && (slot->cnt == 0)) {
+            slot->gen     = gen;
+            slot->freeKey = freeKey;
+            slot->arg     = arg;
+        }
+        if (slot->cnt > 0) {
+            key = slot->keys[--slot->cnt];
+        }
+        /* Wake a thread to replace the key or fill a new slot. */
+        pthread_cond_signal(&pool->cond);
+        pthread_mutex_unlock(&pool->mutex);
+    }
+
+    return key;
+}
+
+#else
+
+/**
+ * Key pool not supported when single threaded.
+ *
+ * @param [in, out] provCtx   Provider context.
+ * @param [in]      depth     Maximum number of keys to keep for each curve.
+ * @param [in]      rsaDepth  Maximum number of keys to keep for each RSA key
+ *                            size.
+ * @param [in]      threads   Number of threads to generate keys on.
+ * @return  1 always.
+ */
+int wp_key_pool_init(WOLFPROV_CTX* provCtx, int depth, int rsaDepth,
+    int threads)
+{
+    (void)provCtx;
+    (void)depth;
+    (void)rsaDepth;
+    (void)threads;
+    return 1;
+}
+
+/**
+ * Key pool not supported when single threaded.
+ *
+ * @param [in, out] provCtx  Provider context.
+ */
+void wp_key_pool_free(WOLFPROV_CTX* provCtx)
+{
+    (void)provCtx;
+}
+
+/**
+ * Key pool not supported when single threaded.
+ *
+ * @param [in] provCtx  Provider context.
+ * @param [in] id       Slot of pool. WP_KEY_POOL_* value.
+ * @param [in] gen      Function to generate a key for slot.
+ * @param [in] freeKey  Function to dispose of a key of slot.
+ * @param [in] arg      Argument to pass to generation function.
+ * @return  NULL always.
+ */
+void* wp_key_pool_get(WOLFPROV_CTX* provCtx, int id, WP_KEY_POOL_GEN_FN gen,
+    WP_KEY_POOL_FREE_FN freeKey, const void* arg)
+{
+    (void)provCtx;
+    (void)id;
+    (void)gen;
+    (void)freeKey;
+    (void)arg;
+    return NULL;
+}
+
+#endif /* !WP_SINGLE_THREADED */
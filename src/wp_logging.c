@@ -18,6 +18,8 @@
  * along with wolfProvider.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <openssl/crypto.h>
+
 #include <wolfprovider/internal.h>
 #include <wolfprovider/wp_logging.h>
 #include <wolfssl/wolfcrypt/error-crypt.h>
@@ -45,9 +47,62 @@ static int loggingEnabled = 1;
  * verbose by default. */
 static int providerLogLevel = WP_LOG_LEVEL_ALL;
 
+/* Levels checked at call sites - logging level when enabled, 0 otherwise. */
+int wolfProv_LogLevelMask = WP_LOG_LEVEL_ALL;
+
 /* Components which will be logged when debug enabled. Bitmask of components
  * in wolfProv_LogComponents. Default components include all. */
-static int providerLogComponents = WP_LOG_COMPONENTS_ALL;
+int wolfProv_LogComponentMask = WP_LOG_COMPONENTS_ALL;
+
+#if !defined(WP_SINGLE_THREADED) && defined(WP_ATOMIC_REFCNT)
+    /* Asynchronous log sink available. */
+    #define WP_LOG_ASYNC
+#endif
+
+#ifdef WP_LOG_ASYNC
+#include <time.h>
+
+/* Maximum number of messages in the asynchronous log ring. */
+#define WP_LOG_ASYNC_MAX_SLOTS      (1 << 16)
+/* Time, in nanoseconds, writer sleeps when ring is empty. */
+#define WP_LOG_ASYNC_IDLE_NS        1000000
+
+/* Message in the asynchronous log ring. */
+typedef struct wp_LogSlot {
+    /* Sequence number - indicates whether slot is free or filled. */
+    size_t seq;
+    /* Log level of message. */
+    int level;
+    /* Component of message. */
+    int component;
+    /* Formatted message. */
+    char msg[WOLFPROV_MAX_LOG_WIDTH];
+} wp_LogSlot;
+
+/* Ring of messages waiting to be written. NULL when logging synchronously.
+ * Many threads put messages in and only the writer thread takes them out.
+ */
+static wp_LogSlot* logRing = NULL;
+/* Number of threads putting a message into the ring. Ring is only disposed of
+ * once it is no longer published and this is zero. */
+static int logRingProducers = 0;
+/* Mask of index into ring. Number of slots is a power of two. */
+static size_t logRingMask = 0;
+/* Position the next message is put into. */
+static size_t logRingTail = 0;
+/* Position the writer takes the next message from. */
+static size_t logRingHead = 0;
+/* Number of messages dropped as ring was full. */
+static unsigned long logDropped = 0;
+/* Writer is to stop. */
+static int logWriterStop = 0;
+/* Thread writing messages. */
+static pthread_t logWriter;
+/* Number of provider contexts - writer stopped when last disposed of. */
+static int logUsers = 0;
+
+static void* wolfprovider_log_writer(void* arg);
+#endif
 
 #endif /* WOLFPROV_DEBUG */
 
@@ -83,6 +138,7 @@ int wolfProv_Debugging_ON(void)
 {
 #ifdef WOLFPROV_DEBUG
     loggingEnabled = 1;
+    wolfProv_LogLevelMask = providerLogLevel;
     return 0;
 #else
     return NOT_COMPILED_IN;
@@ -96,6 +152,7 @@ void wolfProv_Debugging_OFF(void)
 {
 #ifdef WOLFPROV_DEBUG
     loggingEnabled = 0;
+    wolfProv_LogLevelMask = 0;
 #endif
 }
 
@@ -111,6 +168,9 @@ int wolfProv_SetLogLevel(int levelMask)
 {
 #ifdef WOLFPROV_DEBUG
     providerLogLevel = levelMask;
+    if (loggingEnabled) {
+        wolfProv_LogLevelMask = levelMask;
+    }
     return 0;
 #else
     (void)levelMask;
@@ -129,7 +189,7 @@ int wolfProv_SetLogLevel(int levelMask)
 int wolfProv_SetLogComponents(int componentMask)
 {
 #ifdef WOLFPROV_DEBUG
-    providerLogComponents = componentMask;
+    wolfProv_LogComponentMask = componentMask;
     return 0;
 #else
     (void)componentMask;
@@ -137,27 +197,163 @@ int wolfProv_SetLogComponents(int componentMask)
 #endif
 }
 
+#ifdef WP_LOG_ASYNC
+/**
+ * Stop the asynchronous log writer and dispose of the ring.
+ *
+ * The ring is unpublished first and then disposed of only when no thread is
+ * still putting a message into it. Messages already in the ring are written
+ * out first.
+ */
+static void wolfprovider_log_async_stop(void)
+{
+    wp_LogSlot* ring = __atomic_exchange_n(&logRing, NULL, __ATOMIC_SEQ_CST);
+
+    if (ring != NULL) {
+        /* Wait for threads that saw the ring before it was unpublished. */
+        while (__atomic_load_n(&logRingProducers, __ATOMIC_SEQ_CST) != 0) {
+            struct timespec ts = { 0, WP_LOG_ASYNC_IDLE_NS };
+            nanosleep(&ts, NULL);
+        }
+        __atomic_store_n(&logWriterStop, 1, __ATOMIC_RELEASE);
+        pthread_join(logWriter, NULL);
+        OPENSSL_free(ring);
+    }
+}
+#endif
+
+/**
+ * Record that a provider context is using logging.
+ */
+void wp_log_init(void)
+{
+#ifdef WP_LOG_ASYNC
+    __atomic_add_fetch(&logUsers, 1, __ATOMIC_RELAXED);
+#endif
+}
+
+/**
+ * Record that a provider context has stopped using logging.
+ *
+ * When the last provider context is disposed of, the asynchronous log writer
+ * is stopped and joined, with messages in the ring written out first. No
+ * thread is left running provider code when the provider is unloaded.
+ * Logging is synchronous until wolfProv_SetLogAsync() is called again.
+ */
+void wp_log_cleanup(void)
+{
+#ifdef WP_LOG_ASYNC
+    if (__atomic_sub_fetch(&logUsers, 1, __ATOMIC_ACQ_REL) == 0) {
+        wolfprovider_log_async_stop();
+    }
+#endif
+}
+
+/**
+ * Set wolfProv to log asynchronously.
+ * Messages are formatted on the calling thread and put into a ring that a
+ * background thread writes out. The logging callback is called on the
+ * background thread. Messages are dropped when the ring is full.
+ * Other threads may be logging. Call from only one thread at a time.
+ *
+ * @param slots [IN] Number of messages the ring holds. Rounded up to a power
+ *                   of two. 0 logs synchronously again (default).
+ * @return 0 on success, NOT_COMPILED_IN if debugging or threading has not
+ *         been enabled, MEMORY_E on failure to start logging asynchronously.
+ */
+int wolfProv_SetLogAsync(int slots)
+{
+#ifdef WP_LOG_ASYNC
+    int ret = 0;
+    size_t cnt = 1;
+    size_t i;
+    wp_LogSlot* ring = NULL;
+
+    wolfprovider_log_async_stop();
+
+    if (slots > 0) {
+        while ((cnt < (size_t)slots) && (cnt < WP_LOG_ASYNC_MAX_SLOTS)) {
+            cnt <<= 1;
+        }
+        ring = (wp_LogSlot*)OPENSSL_malloc(cnt * sizeof(wp_LogSlot));
+        if (ring == NULL) {
+            ret = MEMORY_E;
+        }
+    }
+    if ((ret == 0) && (ring != NULL)) {
+        for (i = 0; i < cnt; i++) {
+            ring[i].seq = i;
+        }
+        logRingMask = cnt - 1;
+        logRingTail = 0;
+        logRingHead = 0;
+        logWriterStop = 0;
+        if (pthread_create(&logWriter, NULL, wolfprovider_log_writer,
+                ring) != 0) {
+            OPENSSL_free(ring);
+            ret = MEMORY_E;
+        }
+        else {
+            /* Publish ring once ready to be used. */
+            __atomic_store_n(&logRing, ring, __ATOMIC_SEQ_CST);
+        }
+    }
+
+    return ret;
+#else
+    (void)slots;
+    return NOT_COMPILED_IN;
+#endif
+}
+
+/**
+ * Get the number of messages dropped as the asynchronous log ring was full.
+ *
+ * @param cnt [OUT] Number of messages dropped.
+ * @return 0 on success, NOT_COMPILED_IN if debugging or threading has not
+ *         been enabled.
+ */
+int wolfProv_GetLogDropped(unsigned long* cnt)
+{
+#ifdef WP_LOG_ASYNC
+    *cnt = __atomic_load_n(&logDropped, __ATOMIC_RELAXED);
+    return 0;
+#else
+    (void)cnt;
+    return NOT_COMPILED_IN;
+#endif
+}
+
 #ifdef WOLFPROV_DEBUG
 
 /**
- * Logging function used by wolfProv.
- * Calls either default log mechanism or application-registered logging
- * callback.
+ * Check whether a message of the level and component is to be logged.
+ *
+ * Checked before formatting so that filtered messages cost little.
+ *
+ * @param logLevel  [IN] Log level.
+ * @param component [IN] Component type, from wolfProv_LogComponents enum.
+ * @return 1 when message is to be logged, 0 otherwise.
+ */
+static int wolfprovider_log_on(const int logLevel, const int component)
+{
+    return /* Match our current logging level */
+           ((wolfProv_LogLevelMask & logLevel) == logLevel) &&
+           /* Match enabled list of components */
+           ((wolfProv_LogComponentMask & component) == component);
+}
+
+/**
+ * Write message out with default log mechanism or application-registered
+ * logging callback.
  *
  * @param logLevel   [IN] Log level.
+ * @param component  [IN] Component type, from wolfProv_LogComponents enum.
  * @param logMessage [IN] Log message.
  */
-static void wolfprovider_log(const int logLevel, const int component,
-                           const char *const logMessage)
+static void wolfprovider_log_write(const int logLevel, const int component,
+                                   const char *const logMessage)
 {
-    /* Don't log messages that do not match our current logging level */
-    if ((providerLogLevel & logLevel) != logLevel)
-        return;
-
-    /* Don't log messages from components that do not match enabled list */
-    if ((providerLogComponents & component) != component)
-        return;
-
     if (log_function) {
         log_function(logLevel, component, logMessage);
     }
@@ -172,6 +368,143 @@ static void wolfprovider_log(const int logLevel, const int component,
     }
 }
 
+#ifdef WP_LOG_ASYNC
+/**
+ * Put a message into the asynchronous log ring.
+ *
+ * Lock-free - slots are claimed by moving the tail position with a compare
+ * and swap. Message is dropped when ring is full.
+ *
+ * @param ring       [IN] Ring of messages.
+ * @param logLevel   [IN] Log level.
+ * @param component  [IN] Component type, from wolfProv_LogComponents enum.
+ * @param logMessage [IN] Log message.
+ */
+static void wolfprovider_log_async(wp_LogSlot* ring, const int logLevel,
+    const int component, const char *const logMessage)
+{
+    wp_LogSlot* slot = NULL;
+    size_t pos = __atomic_load_n(&logRingTail, __ATOMIC_RELAXED);
+
+    for (;;) {
+        size_t seq;
+
+        slot = &ring[pos & logRingMask];
+        seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        if (seq == pos) {
+            if (__atomic_compare_exchange_n(&logRingTail, &pos, pos + 1, 0,
+                    __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        }
+        else if ((long)(seq - pos) < 0) {
+            /* Writer hasn't emptied slot - ring full. */
+            __atomic_add_fetch(&logDropped, 1, __ATOMIC_RELAXED);
+            slot = NULL;
+            break;
+        }
+        else {
+            pos = __atomic_load_n(&logRingTail, __ATOMIC_RELAXED);
+        }
+    }
+
+    if (slot != NULL) {
+        slot->level = logLevel;
+        slot->component = component;
+        XSTRNCPY(slot->msg, logMessage, sizeof(slot->msg) - 1);
+        slot->msg[sizeof(slot->msg) - 1] = '\0';
+        __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+    }
+}
+
+/**
+ * Write out all messages in the asynchronous log ring.
+ *
+ * Only called by one thread at a time.
+ *
+ * @param ring [IN] Ring of messages.
+ * @return 1 when a message was written, 0 when ring was empty.
+ */
+static int wolfprovider_log_drain(wp_LogSlot* ring)
+{
+    int written = 0;
+
+    for (;;) {
+        wp_LogSlot* slot = &ring[logRingHead & logRingMask];
+
+        if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) !=
+                logRingHead + 1) {
+            break;
+        }
+        wolfprovider_log_write(slot->level, slot->component, slot->msg);
+        /* Slot free for use when tail wraps around to it. */
+        __atomic_store_n(&slot->seq, logRingHead + logRingMask + 1,
+            __ATOMIC_RELEASE);
+        logRingHead++;
+        written = 1;
+    }
+
+    return written;
+}
+
+/**
+ * Background thread writing messages from the asynchronous log ring.
+ *
+ * @param arg [IN] Ring of messages.
+ * @return NULL always.
+ */
+static void* wolfprovider_log_writer(void* arg)
+{
+    wp_LogSlot* ring = (wp_LogSlot*)arg;
+
+    while (!__atomic_load_n(&logWriterStop, __ATOMIC_ACQUIRE)) {
+        if (!wolfprovider_log_drain(ring)) {
+            struct timespec ts = { 0, WP_LOG_ASYNC_IDLE_NS };
+            nanosleep(&ts, NULL);
+        }
+    }
+    /* Write out what was logged before stopping. */
+    (void)wolfprovider_log_drain(ring);
+
+    return NULL;
+}
+#endif /* WP_LOG_ASYNC */
+
+/**
+ * Logging function used by wolfProv.
+ * Puts message into the asynchronous log ring when enabled. Otherwise calls
+ * either default log mechanism or application-registered logging callback.
+ *
+ * @param logLevel   [IN] Log level.
+ * @param component  [IN] Component type, from wolfProv_LogComponents enum.
+ * @param logMessage [IN] Log message.
+ */
+static void wolfprovider_log(const int logLevel, const int component,
+                           const char *const logMessage)
+{
+#ifdef WP_LOG_ASYNC
+    wp_LogSlot* ring;
+#endif
+
+    if (!wolfprovider_log_on(logLevel, component))
+        return;
+
+#ifdef WP_LOG_ASYNC
+    /* Counted as producer before looking at ring so that ring isn't disposed
+     * of while in use. */
+    __atomic_add_fetch(&logRingProducers, 1, __ATOMIC_SEQ_CST);
+    ring = __atomic_load_n(&logRing, __ATOMIC_SEQ_CST);
+    if (ring != NULL) {
+        wolfprovider_log_async(ring, logLevel, component, logMessage);
+    }
+    __atomic_sub_fetch(&logRingProducers, 1, __ATOMIC_RELEASE);
+    if (ring == NULL)
+#endif
+    {
+        wolfprovider_log_write(logLevel, component, logMessage);
+    }
+}
+
 /**
  * Internal log function for printing varg messages to a specific
  * log level. Used by WOLFPROV_MSG and WOLFPROV_MSG_VERBOSE.
@@ -187,7 +520,7 @@ static void wolfprovider_msg_internal(int component, int logLevel,
 {
     char msgStr[WOLFPROV_MAX_LOG_WIDTH];
 
-    if (loggingEnabled) {
+    if (wolfprovider_log_on(logLevel, component)) {
         XVSNPRINTF(msgStr, sizeof(msgStr), fmt, vlist);
         wolfprovider_log(logLevel, component, msgStr);
     }
@@ -201,7 +534,7 @@ static void wolfprovider_msg_internal(int component, int logLevel,
  * @param vargs [IN] Variable arguments, used with format string, fmt.
  */
 WP_PRINTF_FUNC(2, 3)
-void WOLFPROV_MSG(int component, const char* fmt, ...)
+void (WOLFPROV_MSG)(int component, const char* fmt, ...)
 {
     va_list vlist;
     va_start(vlist, fmt);
@@ -217,7 +550,7 @@ void WOLFPROV_MSG(int component, const char* fmt, ...)
  * @param vargs [IN] Variable arguments, used with format string, fmt.
  */
 WP_PRINTF_FUNC(2, 3)
-void WOLFPROV_MSG_VERBOSE(int component, const char* fmt, ...)
+void (WOLFPROV_MSG_VERBOSE)(int component, const char* fmt, ...)
 {
     va_list vlist;
     va_start(vlist, fmt);
@@ -231,9 +564,9 @@ void WOLFPROV_MSG_VERBOSE(int component, const char* fmt, ...)
  * @param component [IN] Component type, from wolfProv_LogComponents enum.
  * @param msg  [IN] Log message.
  */
-void WOLFPROV_ENTER(int component, const char* msg)
+void (WOLFPROV_ENTER)(int component, const char* msg)
 {
-    if (loggingEnabled) {
+    if (wolfprovider_log_on(WP_LOG_ENTER, component)) {
         char buffer[WOLFPROV_MAX_LOG_WIDTH];
         XSNPRINTF(buffer, sizeof(buffer), "wolfProv Entering %s", msg);
         wolfprovider_log(WP_LOG_ENTER, component, buffer);
@@ -247,9 +580,9 @@ void WOLFPROV_ENTER(int component, const char* msg)
  * @param msg  [IN] Log message.
  * @param ret  [IN] Value that function will be returning.
  */
-void WOLFPROV_LEAVE(int component, const char* msg, int ret)
+void (WOLFPROV_LEAVE)(int component, const char* msg, int ret)
 {
-    if (loggingEnabled) {
+    if (wolfprovider_log_on(WP_LOG_LEAVE, component)) {
         char buffer[WOLFPROV_MAX_LOG_WIDTH];
         XSNPRINTF(buffer, sizeof(buffer), "wolfProv Leaving %s, return %d",
                   msg, ret);
@@ -265,9 +598,10 @@ void WOLFPROV_LEAVE(int component, const char* msg, int ret)
  * @param file   [IN] Source file where error is called.
  * @param line   [IN] Line in source file where error is called.
  */
-void WOLFPROV_ERROR_LINE(int component, int error, const char* file, int line)
+void (WOLFPROV_ERROR_LINE)(int component, int error, const char* file,
+                           int line)
 {
-    if (loggingEnabled) {
+    if (wolfprovider_log_on(WP_LOG_ERROR, component)) {
         char buffer[WOLFPROV_MAX_LOG_WIDTH];
         XSNPRINTF(buffer, sizeof(buffer),
                   "%s:%d - wolfProv error occurred, error = %d", file, line,
@@ -284,10 +618,10 @@ void WOLFPROV_ERROR_LINE(int component, int error, const char* file, int line)
  * @param file [IN] Source file where error is called.
  * @param line [IN] Line in source file where error is called.
  */
-void WOLFPROV_ERROR_MSG_LINE(int component, const char* msg,
+void (WOLFPROV_ERROR_MSG_LINE)(int component, const char* msg,
                                const char* file, int line)
 {
-    if (loggingEnabled) {
+    if (wolfprovider_log_on(WP_LOG_ERROR, component)) {
         char buffer[WOLFPROV_MAX_LOG_WIDTH];
         XSNPRINTF(buffer, sizeof(buffer), "%s:%d - wolfProv Error %s",
                   file, line, msg);
@@ -305,10 +639,10 @@ void WOLFPROV_ERROR_MSG_LINE(int component, const char* msg,
  * @param file      [IN] Source file where error is called.
  * @param line      [IN] Line in source file where error is called.
  */
-void WOLFPROV_ERROR_FUNC_LINE(int component, const char* funcName, int ret,
+void (WOLFPROV_ERROR_FUNC_LINE)(int component, const char* funcName, int ret,
                                 const char* file, int line)
 {
-    if (loggingEnabled) {
+    if (wolfprovider_log_on(WP_LOG_ERROR, component)) {
         char buffer[WOLFPROV_MAX_LOG_WIDTH];
         XSNPRINTF(buffer, sizeof(buffer),
                   "%s:%d - Error calling %s: ret = %d", file, line, funcName,
@@ -327,11 +661,11 @@ void WOLFPROV_ERROR_FUNC_LINE(int component, const char* funcName, int ret,
  * @param file      [IN] Source file where error is called.
  * @param line      [IN] Line in source file where error is called.
  */
-void WOLFPROV_ERROR_FUNC_NULL_LINE(int component, const char* funcName,
+void (WOLFPROV_ERROR_FUNC_NULL_LINE)(int component, const char* funcName,
                                      const void *ret, const char* file,
                                      int line)
 {
-    if (loggingEnabled) {
+    if (wolfprovider_log_on(WP_LOG_ERROR, component)) {
         char buffer[WOLFPROV_MAX_LOG_WIDTH];
         XSNPRINTF(buffer, sizeof(buffer),
                   "%s:%d - Error calling %s: ret = %p", file, line, funcName,
@@ -353,14 +687,14 @@ void WOLFPROV_ERROR_FUNC_NULL_LINE(int component, const char* funcName,
  * @param buffer  [IN] Buffer to print.
  * @param length  [IN] Length of buffer, octets.
  */
-void WOLFPROV_BUFFER(int component, const unsigned char* buffer,
+void (WOLFPROV_BUFFER)(int component, const unsigned char* buffer,
                        unsigned int length)
 {
     int i, buflen = (int)length, bufidx;
     char line[(WOLFPROV_LINE_LEN * 4) + 3]; /* \t00..0F | chars...chars\0 */
 
 
-    if (!loggingEnabled) {
+    if (!wolfprovider_log_on(WP_LOG_VERBOSE, component)) {
         return;
     }
 
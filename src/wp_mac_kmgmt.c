@@ -25,10 +25,21 @@
 #include <openssl/core_object.h>
 #include <openssl/core_names.h>
 #include <openssl/params.h>
+#include <openssl/evp.h>
 
 #include <wolfprovider/alg_funcs.h>
 
 
+/**
+ * MAC context keyed with a MAC key. Copied when signing to not set key again.
+ */
+typedef struct wp_MacTmpl {
+    /** MAC context keyed and not updated. */
+    EVP_MAC_CTX* macCtx;
+    /** HMAC: Name of digest. CMAC: Name of cipher. */
+    char alg[WP_MAC_ALG_NAME_SIZE];
+} wp_MacTmpl;
+
 /**
  * MAC key object. Used for HMAC and CMAC.
  */
@@ -37,12 +48,8 @@ struct wp_Mac {
     unsigned char* key;
     /** Length of key. */
     size_t keyLen;
-#ifndef WP_SINGLE_THREADED
-    /** Mutex for reference count updating. */
-    wolfSSL_Mutex mutex;
-#endif
     /** Count of references to this object. */
-    int refCnt;
+    wp_RefCnt refCnt;
 
     /** Provider context - used to create a new key.  */
     WOLFPROV_CTX* provCtx;
@@ -53,6 +60,8 @@ struct wp_Mac {
     char cipher[WP_MAX_CIPH_NAME_SIZE];
     /** Properties for cipher/digest. */
     char* properties;
+    /** MAC context keyed with this key. NULL until first signing. */
+    wp_MacTmpl* tmpl;
 };
 
 
@@ -89,24 +98,7 @@ static int wp_mac_gen_set_params(wp_MacGenCtx* ctx, const OSSL_PARAM params[]);
  */
 int wp_mac_up_ref(wp_Mac* mac)
 {
-#ifndef WP_SINGLE_THREADED
-    int ok = 1;
-    int rc;
-
-    rc = wc_LockMutex(&mac->mutex);
-    if (rc < 0) {
-        ok = 0;
-    }
-    if (ok) {
-        mac->refCnt++;
-        wc_UnLockMutex(&mac->mutex);
-    }
-
-    return ok;
-#else
-    mac->refCnt++;
-    return 1;
-#endif
+    return wp_refcnt_up(&mac->refCnt);
 }
 
 /**
@@ -164,6 +156,94 @@ char* wp_mac_get_properties(wp_Mac* mac)
     return mac->properties;
 }
 
+/**
+ * Dispose of MAC template.
+ *
+ * @param [in, out] tmpl  MAC template. May be NULL.
+ */
+static void wp_mac_tmpl_free(wp_MacTmpl* tmpl)
+{
+    if (tmpl != NULL) {
+        EVP_MAC_CTX_free(tmpl->macCtx);
+        OPENSSL_free(tmpl);
+    }
+}
+
+/**
+ * Get the MAC context keyed with this key for the digest/cipher.
+ *
+ * The MAC context must not be changed - duplicate to use.
+ *
+ * @param [in] mac  MAC key object.
+ * @param [in] alg  HMAC: Name of digest. CMAC: Name of cipher.
+ * @return  Keyed MAC context when available.
+ * @return  NULL when none keyed for the digest/cipher.
+ */
+EVP_MAC_CTX* wp_mac_get_template(wp_Mac* mac, const char* alg)
+{
+    EVP_MAC_CTX* macCtx = NULL;
+    wp_MacTmpl* tmpl;
+
+#if defined(WP_ATOMIC_REFCNT)
+    /* Acquire the template written by the thread that stored it. */
+    tmpl = __atomic_load_n(&mac->tmpl, __ATOMIC_ACQUIRE);
+#elif defined(WP_SINGLE_THREADED)
+    tmpl = mac->tmpl;
+#else
+    tmpl = NULL;
+#endif
+    if ((tmpl != NULL) && (XSTRCMP(tmpl->alg, alg) == 0)) {
+        macCtx = tmpl->macCtx;
+    }
+
+    return macCtx;
+}
+
+/**
+ * Keep a copy of a MAC context just keyed with this key.
+ *
+ * Only the first template is kept - other threads may be copying it.
+ *
+ * @param [in, out] mac     MAC key object.
+ * @param [in]      macCtx  MAC context keyed with this key and not updated.
+ * @param [in]      alg     HMAC: Name of digest. CMAC: Name of cipher.
+ */
+void wp_mac_set_template(wp_Mac* mac, EVP_MAC_CTX* macCtx, const char* alg)
+{
+#if defined(WP_ATOMIC_REFCNT) || defined(WP_SINGLE_THREADED)
+    wp_MacTmpl* tmpl = NULL;
+
+    if ((mac->tmpl == NULL) && (XSTRLEN(alg) < sizeof(tmpl->alg))) {
+        tmpl = (wp_MacTmpl*)OPENSSL_zalloc(sizeof(*tmpl));
+    }
+    if (tmpl != NULL) {
+        XSTRNCPY(tmpl->alg, alg, sizeof(tmpl->alg));
+        tmpl->macCtx = EVP_MAC_CTX_dup(macCtx);
+        if (tmpl->macCtx == NULL) {
+            wp_mac_tmpl_free(tmpl);
+            tmpl = NULL;
+        }
+    }
+    if (tmpl != NULL) {
+    #if defined(WP_ATOMIC_REFCNT)
+        wp_MacTmpl* cur = NULL;
+
+        if (!__atomic_compare_exchange_n(&mac->tmpl, &cur, tmpl, 0,
+                __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            /* Another thread stored a template first. */
+            wp_mac_tmpl_free(tmpl);
+        }
+    #else
+        mac->tmpl = tmpl;
+    #endif
+    }
+#else
+    (void)mac;
+    (void)macCtx;
+    (void)alg;
+#endif
+}
+
 /**
  * Create a new MAC key object.
  *
@@ -180,18 +260,13 @@ static wp_Mac* wp_mac_new(WOLFPROV_CTX *provCtx, int type)
         mac = (wp_Mac*)OPENSSL_zalloc(sizeof(*mac));
     }
     if (mac != NULL) {
-    #ifndef SINGLE_THREADED
-        int rc = wc_InitMutex(&mac->mutex);
-        if (rc != 0) {
+        if (!wp_refcnt_init(&mac->refCnt)) {
             OPENSSL_free(mac);
             mac = NULL;
         }
-        else
-    #endif
-        {
+        else {
             mac->provCtx = provCtx;
             mac->type = type;
-            mac->refCnt = 1;
         }
     }
 
@@ -206,23 +281,11 @@ static wp_Mac* wp_mac_new(WOLFPROV_CTX *provCtx, int type)
 void wp_mac_free(wp_Mac* mac)
 {
     if (mac != NULL) {
-        int cnt;
-    #ifndef WP_SINGLE_THREADED
-        int rc;
-
-        rc = wc_LockMutex(&mac->mutex);
-        cnt = --mac->refCnt;
-        if (rc == 0) {
-            wc_UnLockMutex(&mac->mutex);
-        }
-    #else
-        cnt = --mac->refCnt;
-    #endif
+        int cnt = wp_refcnt_down(&mac->refCnt);
 
         if (cnt == 0) {
-    #ifndef WP_SINGLE_THREADED
-            wc_FreeMutex(&mac->mutex);
-    #endif
+            wp_refcnt_free(&mac->refCnt);
+            wp_mac_tmpl_free(mac->tmpl);
             OPENSSL_free(mac->properties);
             OPENSSL_clear_free(mac->key, mac->keyLen);
             OPENSSL_free(mac);
@@ -355,6 +418,11 @@ static int wp_mac_import(wp_Mac *mac, int selection, const OSSL_PARAM params[])
     if (ok && ((selection & OSSL_KEYMGMT_SELECT_PRIVATE_KEY) == 0)) {
         ok = 0;
     }
+    if (ok) {
+        /* Key is changing - keyed MAC context no longer matches. */
+        wp_mac_tmpl_free(mac->tmpl);
+        mac->tmpl = NULL;
+    }
     if (ok && (!wp_params_get_octet_string(params, OSSL_PKEY_PARAM_PRIV_KEY,
             &mac->key, &mac->keyLen, 1))) {
         ok = 0;
@@ -39,7 +39,7 @@ typedef struct wp_MacSigCtx {
     /* Library context object. */
     OSSL_LIB_CTX *libCtx;
 
-    /* MAC key. */
+    /* MAC key. Reference held. */
     wp_Mac* mac;
     /* wolfProvider MAC object. */
     EVP_MAC_CTX* macCtx;
@@ -47,6 +47,10 @@ typedef struct wp_MacSigCtx {
     char name[WP_MAX_MAC_NAME_SIZE];
     /* MAC type */
     int type;
+    /* HMAC: Name of digest. CMAC: Name of cipher. MAC context keyed for. */
+    char alg[WP_MAC_ALG_NAME_SIZE];
+    /* MAC context was initialized with only the key's settings. */
+    unsigned int keyed:1;
 
     /* Property query string. */
     char* propQuery;
@@ -124,12 +128,39 @@ static wp_MacSigCtx* wp_mac_ctx_new(WOLFPROV_CTX* provCtx,
 static void wp_mac_ctx_free(wp_MacSigCtx* ctx)
 {
     if (ctx != NULL) {
+        wp_mac_free(ctx->mac);
         EVP_MAC_CTX_free(ctx->macCtx);
         OPENSSL_free(ctx->propQuery);
         OPENSSL_free(ctx);
     }
 }
 
+/**
+ * Set the MAC key object, holding a reference to it.
+ *
+ * The reference keeps the key, and so its address, valid while the MAC
+ * context keyed for it may be restarted.
+ *
+ * @param [in, out] ctx  MAC signature context object.
+ * @param [in]      mac  MAC key object.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_mac_ctx_set_mac(wp_MacSigCtx* ctx, wp_Mac* mac)
+{
+    int ok = 1;
+
+    if (ctx->mac != mac) {
+        ok = wp_mac_up_ref(mac);
+        if (ok) {
+            wp_mac_free(ctx->mac);
+            ctx->mac = mac;
+        }
+    }
+
+    return ok;
+}
+
 
 /**
  * Duplicate the MAC signature context object.
@@ -157,8 +188,12 @@ static wp_MacSigCtx* wp_mac_ctx_dup(wp_MacSigCtx* srcCtx)
                 ok = 0;
             }
         }
+        if (ok && (srcCtx->mac != NULL)) {
+            ok = wp_mac_ctx_set_mac(dstCtx, srcCtx->mac);
+        }
         if (ok) {
-            dstCtx->mac = srcCtx->mac;
+            XMEMCPY(dstCtx->alg, srcCtx->alg, sizeof(dstCtx->alg));
+            dstCtx->keyed = srcCtx->keyed;
         }
 
         if (!ok) {
@@ -170,9 +205,53 @@ static wp_MacSigCtx* wp_mac_ctx_dup(wp_MacSigCtx* srcCtx)
     return dstCtx;
 }
 
+/**
+ * Initialize MAC context from the keyed state of the key's MAC context.
+ *
+ * When initialized for the same key and digest/cipher, the MAC context is
+ * restarted - no allocation. Otherwise the MAC context keyed with the key is
+ * copied - the key is not set again.
+ *
+ * @param [in, out] ctx  MAC signature context object.
+ * @param [in]      mac  MAC key object.
+ * @param [in]      alg  HMAC: Name of digest. CMAC: Name of cipher.
+ * @return  1 when MAC context initialized.
+ * @return  0 when MAC context to be initialized with key.
+ */
+static int wp_mac_digest_sign_init_keyed(wp_MacSigCtx *ctx, wp_Mac* mac,
+    const char* alg)
+{
+    int done = 0;
+    EVP_MAC_CTX* tmpl;
+
+    if (ctx->keyed && (ctx->mac == mac) && (XSTRCMP(ctx->alg, alg) == 0)) {
+        /* No key restarts with the key already set. Reference to key held so
+         * the same address is the same key. */
+        done = EVP_MAC_init(ctx->macCtx, NULL, 0, NULL);
+    }
+    if (!done) {
+        tmpl = wp_mac_get_template(mac, alg);
+        if ((tmpl != NULL) && (EVP_MAC_CTX_get0_mac(tmpl) ==
+                EVP_MAC_CTX_get0_mac(ctx->macCtx))) {
+            EVP_MAC_CTX* macCtx = EVP_MAC_CTX_dup(tmpl);
+
+            if (macCtx != NULL) {
+                EVP_MAC_CTX_free(ctx->macCtx);
+                ctx->macCtx = macCtx;
+                done = 1;
+            }
+        }
+    }
+
+    return done;
+}
+
 /**
  * Initialize MAC signature context object for signing/verifying digested data.
  *
+ * Without parameters, the MAC context is restarted or copied from one keyed
+ * with the key. Otherwise the MAC context is set with the key.
+ *
  * @param [in, out] ctx     MAC signature context object.
  * @param [in]      mdName  Name of digest algorithm to use on data.
  * @param [in]      mac     MAC key object.
@@ -184,27 +263,43 @@ static int wp_mac_digest_sign_init(wp_MacSigCtx *ctx, const char *mdName,
     wp_Mac *mac, const OSSL_PARAM params[])
 {
     int ok = 1;
-    unsigned char* priv;
-    size_t privLen;
+    int done = 0;
+    unsigned char* priv = NULL;
+    size_t privLen = 0;
     const char* cipherName;
-    const char* properties;
+    const char* properties = NULL;
+    const char* alg = NULL;
     OSSL_PARAM lParams[4];
     int lParamSz = 0;
 
     if (!wolfssl_prov_is_running()) {
         ok = 0;
     }
-    if (ok) {
-        ctx->mac = mac;
+    if (ok && ((params == NULL) || (params[0].key == NULL))) {
+        /* Only the key's settings - keyed MAC context can be reused. */
+        alg = (ctx->type == WP_MAC_TYPE_HMAC) ? mdName :
+            wp_mac_get_ciphername(mac);
+        if ((alg != NULL) && (XSTRLEN(alg) >= sizeof(ctx->alg))) {
+            alg = NULL;
+        }
+    }
+    if (ok && (alg != NULL)) {
+        done = wp_mac_digest_sign_init_keyed(ctx, mac, alg);
+    }
+    if (ok && (!done)) {
+        ctx->keyed = 0;
 
-        if (!wp_mac_get_private_key(ctx->mac, &priv, &privLen)) {
+        if (!wp_mac_ctx_set_mac(ctx, mac)) {
+            ok = 0;
+        }
+        else if (!wp_mac_get_private_key(ctx->mac, &priv, &privLen)) {
             ok = 0;
         }
     }
-    if (ok) {
+    if (ok && (!done)) {
         EVP_MAC_CTX_set_params(ctx->macCtx, params);
     }
-    if (ok && (ctx->type == WP_MAC_TYPE_CMAC)) {
+    if (ok && (!done) && (ctx->type == WP_MAC_TYPE_CMAC)) {
         cipherName = wp_mac_get_ciphername(ctx->mac);
         if (!wp_params_get_utf8_string_ptr(params, OSSL_ALG_PARAM_CIPHER,
                 &cipherName)) {
@@ -215,7 +310,7 @@ static int wp_mac_digest_sign_init(wp_MacSigCtx *ctx, const char *mdName,
                 OSSL_MAC_PARAM_CIPHER, (char*)cipherName, 0);
         }
     }
-    if (ok && (ctx->type == WP_MAC_TYPE_HMAC)) {
+    if (ok && (!done) && (ctx->type == WP_MAC_TYPE_HMAC)) {
         if (!wp_params_get_utf8_string_ptr(params, OSSL_ALG_PARAM_DIGEST,
                 &mdName)) {
             ok = 0;
@@ -225,23 +320,34 @@ static int wp_mac_digest_sign_init(wp_MacSigCtx *ctx, const char *mdName,
                 OSSL_MAC_PARAM_DIGEST, (char*)mdName, 0);
         }
     }
-    if (ok) {
+    if (ok && (!done)) {
         properties = wp_mac_get_properties(ctx->mac);
         if (!wp_params_get_utf8_string_ptr(params, OSSL_ALG_PARAM_PROPERTIES,
                 &properties)) {
             ok = 0;
         }
     }
-    if (ok && (properties != NULL)) {
+    if (ok && (!done) && (properties != NULL)) {
         lParams[lParamSz++] =  OSSL_PARAM_construct_utf8_string(
              OSSL_MAC_PARAM_PROPERTIES, (char*)properties, 0);
     }
-    if (ok) {
+    if (ok && (!done)) {
         lParams[lParamSz++] = OSSL_PARAM_construct_end();
         if (!EVP_MAC_init(ctx->macCtx, priv, privLen, lParams)) {
             ok = 0;
         }
     }
+    if (ok && (!done) && (alg != NULL)) {
+        /* Keep keyed MAC context on key for other signing operations. */
+        wp_mac_set_template(mac, ctx->macCtx, alg);
+    }
+    if (ok && (alg != NULL)) {
+        ok = wp_mac_ctx_set_mac(ctx, mac);
+    }
+    if (ok && (alg != NULL)) {
+        XSTRNCPY(ctx->alg, alg, sizeof(ctx->alg));
+        ctx->keyed = 1;
+    }
 
     return ok;
 }
@@ -0,0 +1,429 @@
+/* wp_metrics.c
+ *
+ * Copyright (C) 2021 wolfSSL Inc.
+ *
+ * This file is part of wolfProvider.
+ *
+ * wolfProvider is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfProvider is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wolfProvider.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <time.h>
+
+#include <openssl/params.h>
+
+#include <wolfprovider/internal.h>
+
+/*
+ * Operation metrics.
+ *
+ * When enabled in the provider's configuration, the number of calls, the
+ * number of bytes processed and a histogram of latencies are recorded for
+ * each operation. Each thread records into its own shard so that no locks or
+ * atomic operations are on the path of an operation. Shards are merged when
+ * the metrics are read.
+ *
+ * Histogram bucket 0 counts latencies below 64ns. Bucket i counts latencies
+ * of at least 64ns * 2^(i-1) and below 64ns * 2^i. The last bucket counts
+ * everything longer.
+ */
+
+/** Latencies, in nanoseconds, below this value go in the first bucket. */
+#define WP_METRIC_HIST_BASE     64
+/** Maximum length of a line of the metrics report. */
+#define WP_METRIC_LINE_MAX      \
+    (64 + 2 * 21 + WP_METRIC_HIST_CNT * 21)
+
+/** Names of operations in metrics report. Same order as WP_METRIC_* ids. */
+static const char* wp_metric_names[WP_METRIC_CNT] = {
+    "digest-update",
+    "aes-gcm-tls",
+    "chacha20-poly1305-tls",
+    "rsa-sign",
+    "rsa-verify",
+    "ecdsa-sign",
+    "ecdsa-verify",
+    "ecdh-derive",
+    "ecx-derive",
+    "dh-derive",
+    "rsa-keygen",
+    "ec-keygen",
+    "ecx-keygen",
+    "rng-generate",
+    "mlkem-keygen",
+    "mlkem-encap",
+    "mlkem-decap",
+};
+
+/**
+ * Metrics recorded by one thread.
+ */
+typedef struct wp_MetricShard {
+    /** Number of calls of operation. */
+    word64 calls[WP_METRIC_CNT];
+    /** Number of bytes processed by operation. */
+    word64 bytes[WP_METRIC_CNT];
+    /** Histogram of latencies of operation. */
+    word64 hist[WP_METRIC_CNT][WP_METRIC_HIST_CNT];
+#ifndef WP_SINGLE_THREADED
+    /** Previous shard in list. */
+    struct wp_MetricShard* prev;
+    /** Next shard in list. */
+    struct wp_MetricShard* next;
+#endif
+} wp_MetricShard;
+
+/** Number of provider contexts using metrics. */
+static int wp_metrics_users = 0;
+/** Metrics are being recorded. */
+static int wp_metrics_on = 0;
+#ifdef WP_SINGLE_THREADED
+/** Only shard when single threaded. */
+static wp_MetricShard wp_metrics_shard;
+#else
+/** Metrics of threads that have exited. */
+static wp_MetricShard wp_metrics_exited;
+/** Key to the calling thread's shard. */
+static pthread_key_t wp_metrics_key;
+/** Protects list of shards, users count and exited thread metrics. */
+static pthread_mutex_t wp_metrics_mutex = PTHREAD_MUTEX_INITIALIZER;
+/** List of all threads' shards. */
+static wp_MetricShard* wp_metrics_list = NULL;
+#endif
+
+/**
+ * Add the metrics of one shard into another.
+ *
+ * @param [in, out] dst  Shard to add into.
+ * @param [in]      src  Shard to add.
+ */
+static void wp_metrics_add(wp_MetricShard* dst, const wp_MetricShard* src)
+{
+    int i;
+    int j;
+
+    for (i = 0; i < WP_METRIC_CNT; i++) {
+        dst->calls[i] += src->calls[i];
+        dst->bytes[i] += src->bytes[i];
+        for (j = 0; j < WP_METRIC_HIST_CNT; j++) {
+            dst->hist[i][j] += src->hist[i][j];
+        }
+    }
+}
+
+#ifndef WP_SINGLE_THREADED
+/**
+ * Dispose of a thread's shard.
+ *
+ * Called when the thread exits. Removes the shard from the list and keeps its
+ * metrics.
+ *
+ * @param [in] arg  Thread's shard.
+ */
+static void wp_thread_metrics_free(void* arg)
+{
+    wp_MetricShard* shard = (wp_MetricShard*)arg;
+
+    if (pthread_mutex_lock(&wp_metrics_mutex) == 0) {
+        if (shard->prev != NULL) {
+            shard->prev->next = shard->next;
+        }
+        else {
+            wp_metrics_list = shard->next;
+        }
+        if (shard->next != NULL) {
+            shard->next->prev = shard->prev;
+        }
+        wp_metrics_add(&wp_metrics_exited, shard);
+        pthread_mutex_unlock(&wp_metrics_mutex);
+    }
+    wp_numa_clear_free(shard, sizeof(*shard));
+}
+#endif
+
+/**
+ * Get the calling thread's shard.
+ *
+ * Creates the shard on first use in the thread.
+ *
+ * @return  Thread's shard on success.
+ * @return  NULL on failure.
+ */
+static wp_MetricShard* wp_thread_metrics_get(void)
+{
+    wp_MetricShard* shard;
+
+#ifdef WP_SINGLE_THREADED
+    shard = &wp_metrics_shard;
+#else
+    shard = (wp_MetricShard*)pthread_getspecific(wp_metrics_key);
+    if (shard == NULL) {
+        shard = (wp_MetricShard*)wp_numa_zalloc(sizeof(*shard));
+        if ((shard != NULL) && (pthread_mutex_lock(&wp_metrics_mutex) != 0)) {
+            wp_numa_clear_free(shard, sizeof(*shard));
+            shard = NULL;
+        }
+        if (shard != NULL) {
+            if ((!wp_metrics_on) ||
+                    (pthread_setspecific(wp_metrics_key, shard) != 0)) {
+                pthread_mutex_unlock(&wp_metrics_mutex);
+                wp_numa_clear_free(shard, sizeof(*shard));
+                shard = NULL;
+            }
+            else {
+                shard->next = wp_metrics_list;
+                if (wp_metrics_list != NULL) {
+                    wp_metrics_list->prev = shard;
+                }
+                wp_metrics_list = shard;
+                pthread_mutex_unlock(&wp_metrics_mutex);
+            }
+        }
+    }
+#endif
+
+    return shard;
+}
+
+/**
+ * Start using metrics.
+ *
+ * Metrics are not recorded until enabled.
+ *
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+int wp_metrics_init(void)
+{
+    int ok = 1;
+
+#ifndef WP_SINGLE_THREADED
+    if (pthread_mutex_lock(&wp_metrics_mutex) != 0) {
+        ok = 0;
+    }
+    if (ok && (wp_metrics_users == 0) &&
+            (pthread_key_create(&wp_metrics_key, wp_thread_metrics_free) !=
+             0)) {
+        ok = 0;
+        pthread_mutex_unlock(&wp_metrics_mutex);
+    }
+#endif
+    if (ok) {
+        wp_metrics_users++;
+#ifndef WP_SINGLE_THREADED
+        pthread_mutex_unlock(&wp_metrics_mutex);
+#endif
+    }
+
+    return ok;
+}
+
+/**
+ * Start recording metrics.
+ */
+void wp_metrics_enable(void)
+{
+#ifndef WP_SINGLE_THREADED
+    if (pthread_mutex_lock(&wp_metrics_mutex) == 0) {
+        wp_metrics_on = (wp_metrics_users > 0);
+        pthread_mutex_unlock(&wp_metrics_mutex);
+    }
+#else
+    wp_metrics_on = (wp_metrics_users > 0);
+#endif
+}
+
+/**
+ * Stop using metrics.
+ *
+ * Disposes of all metrics when the last user stops.
+ */
+void wp_metrics_cleanup(void)
+{
+#ifdef WP_SINGLE_THREADED
+    if ((wp_metrics_users > 0) && (--wp_metrics_users == 0)) {
+        wp_metrics_on = 0;
+        XMEMSET(&wp_metrics_shard, 0, sizeof(wp_metrics_shard));
+    }
+#else
+    if (pthread_mutex_lock(&wp_metrics_mutex) == 0) {
+        if ((wp_metrics_users > 0) && (--wp_metrics_users == 0)) {
+            wp_metrics_on = 0;
+            pthread_key_delete(wp_metrics_key);
+            while (wp_metrics_list != NULL) {
+                wp_MetricShard* shard = wp_metrics_list;
+
+                wp_metrics_list = shard->next;
+                wp_numa_clear_free(shard, sizeof(*shard));
+            }
+            XMEMSET(&wp_metrics_exited, 0, sizeof(wp_metrics_exited));
+        }
+        pthread_mutex_unlock(&wp_metrics_mutex);
+    }
+#endif
+}
+
+/**
+ * Get the current time in nanoseconds.
+ *
+ * @return  Monotonic time in nanoseconds.
+ * @return  0 when metrics are not being recorded.
+ */
+word64 wp_metrics_start(void)
+{
+    word64 now = 0;
+
+    if (wp_metrics_on) {
+        struct timespec ts;
+
+        if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0) {
+            now = (word64)ts.tv_sec * 1000000000 + (word64)ts.tv_nsec;
+        }
+    }
+
+    return now;
+}
+
+/**
+ * Record a call of an operation.
+ *
+ * @param [in] id     Operation. WP_METRIC_* value.
+ * @param [in] start  Time operation started from wp_metrics_start().
+ *                    0 indicates not to record.
+ * @param [in] bytes  Number of bytes processed by operation.
+ */
+void wp_metrics_record(int id, word64 start, size_t bytes)
+{
+    if ((start != 0) && wp_metrics_on && (id >= 0) && (id < WP_METRIC_CNT)) {
+        wp_MetricShard* shard = wp_thread_metrics_get();
+        word64 lat = wp_metrics_start();
+        int bucket = 0;
+
+        if (lat > start) {
+            lat = (lat - start) / WP_METRIC_HIST_BASE;
+        }
+        else {
+            lat = 0;
+        }
+        while ((lat != 0) && (bucket < WP_METRIC_HIST_CNT - 1)) {
+            lat >>= 1;
+            bucket++;
+        }
+
+        if (shard != NULL) {
+            shard->calls[id]++;
+            shard->bytes[id] += bytes;
+            shard->hist[id][bucket]++;
+        }
+    }
+}
+
+/**
+ * Merge the metrics of all threads.
+ *
+ * Counts being recorded while merging may not be included.
+ *
+ * @param [out] total  Merged metrics.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_metrics_merge(wp_MetricShard* total)
+{
+    int ok = 1;
+
+    XMEMSET(total, 0, sizeof(*total));
+#ifdef WP_SINGLE_THREADED
+    wp_metrics_add(total, &wp_metrics_shard);
+#else
+    if (pthread_mutex_lock(&wp_metrics_mutex) != 0) {
+        ok = 0;
+    }
+    if (ok) {
+        wp_MetricShard* shard;
+
+        wp_metrics_add(total, &wp_metrics_exited);
+        for (shard = wp_metrics_list; shard != NULL; shard = shard->next) {
+            wp_metrics_add(total, shard);
+        }
+        pthread_mutex_unlock(&wp_metrics_mutex);
+    }
+#endif
+
+    return ok;
+}
+
+/**
+ * Put the metrics report into the parameter.
+ *
+ * One line per operation:
+ *   <name> calls=<n> bytes=<n> hist=<n>,<n>,...
+ *
+ * @param [in, out] p  Parameter to set.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+int wp_metrics_get_param(OSSL_PARAM* p)
+{
+    int ok = 1;
+    wp_MetricShard* total = NULL;
+    char* report = NULL;
+    size_t len = 0;
+    size_t max = (size_t)WP_METRIC_CNT * WP_METRIC_LINE_MAX + 1;
+    int i;
+    int j;
+    int n;
+
+    total = (wp_MetricShard*)OPENSSL_malloc(sizeof(*total));
+    if (total == NULL) {
+        ok = 0;
+    }
+    if (ok) {
+        report = (char*)OPENSSL_malloc(max);
+        if (report == NULL) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        ok = wp_metrics_merge(total);
+    }
+    for (i = 0; ok && (i < WP_METRIC_CNT); i++) {
+        n = XSNPRINTF(report + len, max - len, "%s calls=%llu bytes=%llu hist=",
+            wp_metric_names[i], (unsigned long long)total->calls[i],
+            (unsigned long long)total->bytes[i]);
+        if ((n < 0) || ((size_t)n >= max - len)) {
+            ok = 0;
+        }
+        else {
+            len += n;
+        }
+        for (j = 0; ok && (j < WP_METRIC_HIST_CNT); j++) {
+            n = XSNPRINTF(report + len, max - len, "%llu%c",
+                (unsigned long long)total->hist[i][j],
+                (j == WP_METRIC_HIST_CNT - 1) ? '\n' : ',');
+            if ((n < 0) || ((size_t)n >= max - len)) {
+                ok = 0;
+            }
+            else {
+                len += n;
+            }
+        }
+    }
+    if (ok && (!OSSL_PARAM_set_utf8_string(p, report))) {
+        ok = 0;
+    }
+
+    OPENSSL_free(report);
+    OPENSSL_free(total);
+    return ok;
+}
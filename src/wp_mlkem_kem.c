@@ -0,0 +1,327 @@
+/* wp_mlkem_kem.c
+ *
+ * Copyright (C) 2021 wolfSSL Inc.
+ *
+ * This file is part of wolfProvider.
+ *
+ * wolfProvider is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfProvider is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wolfProvider.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <openssl/core_dispatch.h>
+#include <openssl/core_names.h>
+#include <openssl/params.h>
+#include <openssl/evp.h>
+
+#include <wolfprovider/alg_funcs.h>
+
+#if defined(WOLFSSL_HAVE_MLKEM) || defined(WOLFSSL_HAVE_KYBER)
+
+/**
+ * ML-KEM KEM context.
+ *
+ * Works with ML-KEM-768 and the hybrid key types - the key does both halves.
+ */
+typedef struct wp_MlKemCtx {
+    /** Provider context - useful when duplicating. */
+    WOLFPROV_CTX* provCtx;
+    /** ML-KEM key object. */
+    wp_MlKem* key;
+    /** Operation being performed. EVP_PKEY_OP_ENCAPSULATE/DECAPSULATE. */
+    int op;
+} wp_MlKemCtx;
+
+
+/**
+ * Create a new ML-KEM KEM context object.
+ *
+ * @param [in] provCtx  Provider context.
+ * @return  NULL on failure.
+ * @return  ML-KEM KEM context object on success.
+ */
+static wp_MlKemCtx* wp_mlkem_ctx_new(WOLFPROV_CTX* provCtx)
+{
+    wp_MlKemCtx* ctx = NULL;
+
+    if (wolfssl_prov_is_running()) {
+        ctx = (wp_MlKemCtx*)OPENSSL_zalloc(sizeof(*ctx));
+    }
+    if (ctx != NULL) {
+        ctx->provCtx = provCtx;
+    }
+
+    return ctx;
+}
+
+/**
+ * Dispose of an ML-KEM KEM context object.
+ *
+ * @param [in, out] ctx  ML-KEM KEM context object.
+ */
+static void wp_mlkem_ctx_free(wp_MlKemCtx* ctx)
+{
+    if (ctx != NULL) {
+        wp_mlkem_free(ctx->key);
+        OPENSSL_free(ctx);
+    }
+}
+
+/**
+ * Duplicate an ML-KEM KEM context object.
+ *
+ * @param [in] srcCtx  ML-KEM KEM context object to copy.
+ * @return  NULL on failure.
+ * @return  ML-KEM KEM context object on success.
+ */
+static wp_MlKemCtx* wp_mlkem_ctx_dup(wp_MlKemCtx* srcCtx)
+{
+    wp_MlKemCtx* dstCtx = NULL;
+
+    if (wolfssl_prov_is_running()) {
+        int ok = 1;
+
+        dstCtx = wp_mlkem_ctx_new(srcCtx->provCtx);
+        if (dstCtx == NULL) {
+            ok = 0;
+        }
+        if (ok && (srcCtx->key != NULL) && (!wp_mlkem_up_ref(srcCtx->key))) {
+            ok = 0;
+        }
+        if (ok) {
+            dstCtx->key = srcCtx->key;
+            dstCtx->op  = srcCtx->op;
+        }
+
+        if (!ok) {
+            wp_mlkem_ctx_free(dstCtx);
+            dstCtx = NULL;
+        }
+    }
+
+    return dstCtx;
+}
+
+/**
+ * Initialize ML-KEM KEM context object for an operation.
+ *
+ * @param [in, out] ctx     ML-KEM KEM context object.
+ * @param [in]      key     ML-KEM key object. May be NULL.
+ * @param [in]      params  Parameters to initialize with.
+ * @param [in]      op      Operation being performed.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_mlkem_init(wp_MlKemCtx* ctx, wp_MlKem* key,
+    const OSSL_PARAM params[], int op)
+{
+    int ok = 1;
+
+    (void)params;
+
+    if (!wolfssl_prov_is_running()) {
+        ok = 0;
+    }
+    if (ok && (key != NULL) && (key != ctx->key)) {
+        if (!wp_mlkem_up_ref(key)) {
+            ok = 0;
+        }
+        if (ok) {
+            wp_mlkem_free(ctx->key);
+            ctx->key = key;
+        }
+    }
+    if (ok && (ctx->key == NULL)) {
+        ok = 0;
+    }
+    if (ok) {
+        ctx->op = op;
+    }
+
+    return ok;
+}
+
+/**
+ * Initialize ML-KEM KEM context object for encapsulation.
+ *
+ * @param [in, out] ctx     ML-KEM KEM context object.
+ * @param [in]      key     ML-KEM key object holding peer's public key.
+ * @param [in]      params  Parameters to initialize with.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_mlkem_encapsulate_init(wp_MlKemCtx* ctx, wp_MlKem* key,
+    const OSSL_PARAM params[])
+{
+    return wp_mlkem_init(ctx, key, params, EVP_PKEY_OP_ENCAPSULATE);
+}
+
+/**
+ * Encapsulate a new shared secret against the peer's public key.
+ *
+ * When out is NULL, the sizes of the ciphertext and secret are returned.
+ *
+ * @param [in]      ctx        ML-KEM KEM context object.
+ * @param [out]     out        Buffer to hold ciphertext. May be NULL.
+ * @param [in, out] outLen     On in, size of out in bytes.
+ *                             On out, length of ciphertext in bytes.
+ * @param [out]     secret     Buffer to hold shared secret. May be NULL.
+ * @param [in, out] secretLen  On in, size of secret in bytes.
+ *                             On out, length of shared secret in bytes.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_mlkem_encapsulate(wp_MlKemCtx* ctx, unsigned char* out,
+    size_t* outLen, unsigned char* secret, size_t* secretLen)
+{
+    int ok = 1;
+    size_t ctLen;
+    size_t ssLen;
+
+    if ((!wolfssl_prov_is_running()) || (ctx->op != EVP_PKEY_OP_ENCAPSULATE)
+            || (!wp_mlkem_has_pub(ctx->key))) {
+        ok = 0;
+    }
+    if (ok) {
+        ctLen = wp_mlkem_get_ct_len(ctx->key);
+        ssLen = wp_mlkem_get_ss_len(ctx->key);
+        if (out == NULL) {
+            if ((outLen == NULL) && (secretLen == NULL)) {
+                ok = 0;
+            }
+        }
+        else if ((secret == NULL) || (outLen == NULL) || (*outLen < ctLen) ||
+                 ((secretLen != NULL) && (*secretLen < ssLen))) {
+            ok = 0;
+        }
+        else if (!wp_mlkem_encap(ctx->key, out, secret)) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        if (outLen != NULL) {
+            *outLen = ctLen;
+        }
+        if (secretLen != NULL) {
+            *secretLen = ssLen;
+        }
+    }
+
+    return ok;
+}
+
+/**
+ * Initialize ML-KEM KEM context object for decapsulation.
+ *
+ * @param [in, out] ctx     ML-KEM KEM context object.
+ * @param [in]      key     ML-KEM key object holding private key.
+ * @param [in]      params  Parameters to initialize with.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_mlkem_decapsulate_init(wp_MlKemCtx* ctx, wp_MlKem* key,
+    const OSSL_PARAM params[])
+{
+    return wp_mlkem_init(ctx, key, params, EVP_PKEY_OP_DECAPSULATE);
+}
+
+/**
+ * Decapsulate the shared secret from the peer's ciphertext.
+ *
+ * When out is NULL, the size of the secret is returned.
+ *
+ * @param [in]      ctx     ML-KEM KEM context object.
+ * @param [out]     out     Buffer to hold shared secret. May be NULL.
+ * @param [in, out] outLen  On in, size of out in bytes.
+ *                          On out, length of shared secret in bytes.
+ * @param [in]      in      Ciphertext.
+ * @param [in]      inLen   Length of ciphertext in bytes.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_mlkem_decapsulate(wp_MlKemCtx* ctx, unsigned char* out,
+    size_t* outLen, const unsigned char* in, size_t inLen)
+{
+    int ok = 1;
+    size_t ssLen;
+
+    if ((!wolfssl_prov_is_running()) || (ctx->op != EVP_PKEY_OP_DECAPSULATE)
+            || (!wp_mlkem_has_priv(ctx->key)) || (outLen == NULL)) {
+        ok = 0;
+    }
+    if (ok) {
+        ssLen = wp_mlkem_get_ss_len(ctx->key);
+        if ((out != NULL) && ((*outLen < ssLen) ||
+                (!wp_mlkem_decap(ctx->key, in, inLen, out)))) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        *outLen = ssLen;
+    }
+
+    return ok;
+}
+
+/**
+ * Return an array of supported settable parameters for the KEM context.
+ *
+ * @param [in] ctx      ML-KEM KEM context object. Unused.
+ * @param [in] provCtx  Provider context object. Unused.
+ * @return  Array of parameters with data type.
+ */
+static const OSSL_PARAM* wp_mlkem_settable_ctx_params(wp_MlKemCtx* ctx,
+    WOLFPROV_CTX* provCtx)
+{
+    /**
+     * Supported settable parameters for ML-KEM KEM context.
+     */
+    static const OSSL_PARAM wp_mlkem_supported_settable_ctx_params[] = {
+        OSSL_PARAM_END
+    };
+    (void)ctx;
+    (void)provCtx;
+    return wp_mlkem_supported_settable_ctx_params;
+}
+
+/**
+ * Set the KEM context parameters.
+ *
+ * No parameters supported.
+ *
+ * @param [in, out] ctx     ML-KEM KEM context object. Unused.
+ * @param [in]      params  Array of parameters and values. Unused.
+ * @return  1 always.
+ */
+static int wp_mlkem_set_ctx_params(wp_MlKemCtx* ctx, const OSSL_PARAM params[])
+{
+    (void)ctx;
+    (void)params;
+    return 1;
+}
+
+/** Dispatch table for ML-KEM and hybrid KEMs. */
+const OSSL_DISPATCH wp_mlkem_kem_functions[] = {
+    { OSSL_FUNC_KEM_NEWCTX,              (DFUNC)wp_mlkem_ctx_new             },
+    { OSSL_FUNC_KEM_FREECTX,             (DFUNC)wp_mlkem_ctx_free            },
+    { OSSL_FUNC_KEM_DUPCTX,              (DFUNC)wp_mlkem_ctx_dup             },
+    { OSSL_FUNC_KEM_ENCAPSULATE_INIT,    (DFUNC)wp_mlkem_encapsulate_init    },
+    { OSSL_FUNC_KEM_ENCAPSULATE,         (DFUNC)wp_mlkem_encapsulate         },
+    { OSSL_FUNC_KEM_DECAPSULATE_INIT,    (DFUNC)wp_mlkem_decapsulate_init    },
+    { OSSL_FUNC_KEM_DECAPSULATE,         (DFUNC)wp_mlkem_decapsulate         },
+    { OSSL_FUNC_KEM_SET_CTX_PARAMS,      (DFUNC)wp_mlkem_set_ctx_params      },
+    { OSSL_FUNC_KEM_SETTABLE_CTX_PARAMS, (DFUNC)wp_mlkem_settable_ctx_params },
+    { 0, NULL }
+};
+
+#endif /* WOLFSSL_HAVE_MLKEM || WOLFSSL_HAVE_KYBER */
@@ -0,0 +1,1787 @@
+/* wp_mlkem_kmgmt.c
+ *
+ * Copyright (C) 2021 wolfSSL Inc.
+ *
+ * This file is part of wolfProvider.
+ *
+ * wolfProvider is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfProvider is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wolfProvider.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <openssl/err.h>
+#include <openssl/proverr.h>
+#include <openssl/core_dispatch.h>
+#include <openssl/core_names.h>
+#include <openssl/params.h>
+#include <openssl/evp.h>
+
+#include <wolfprovider/alg_funcs.h>
+
+#if defined(WOLFSSL_HAVE_MLKEM) || defined(WOLFSSL_HAVE_KYBER)
+
+/*
+ * ML-KEM-768 and the hybrid TLS groups X25519MLKEM768 and SecP256r1MLKEM768.
+ *
+ * A hybrid key holds both the ML-KEM key and the classical key so that key
+ * generation, encapsulation and decapsulation of both halves happen in one
+ * provider call. The random for both halves is drawn from the RNG at once
+ * and the encoded halves are concatenated in place in the caller's buffers.
+ *
+ * Encodings are as in draft-ietf-tls-ecdhe-mlkem: X25519MLKEM768 has the
+ * ML-KEM part first while SecP256r1MLKEM768 has the ECDH part first.
+ */
+
+/** Supported selections (key parts) in this key manager for ML-KEM. */
+#define WP_MLKEM_POSSIBLE_SELECTIONS                                           \
+    (OSSL_KEYMGMT_SELECT_KEYPAIR | OSSL_KEYMGMT_SELECT_ALL_PARAMETERS)
+
+/** ML-KEM-768 only. */
+#define WP_KEY_TYPE_MLKEM768            1
+/** X25519 and ML-KEM-768 hybrid. */
+#define WP_KEY_TYPE_X25519MLKEM768      2
+/** NIST P-256 and ML-KEM-768 hybrid. */
+#define WP_KEY_TYPE_P256MLKEM768        3
+
+/** No classical key. */
+#define WP_MLKEM_ECDH_NONE              0
+/** Classical key is X25519. */
+#define WP_MLKEM_ECDH_X25519            1
+/** Classical key is NIST P-256. */
+#define WP_MLKEM_ECDH_P256              2
+
+/** Length of an encoded ML-KEM-768 public key in bytes. */
+#define WP_MLKEM768_PUB_LEN             1184
+/** Length of an encoded ML-KEM-768 private key in bytes. */
+#define WP_MLKEM768_PRIV_LEN            2400
+/** Length of an ML-KEM-768 ciphertext in bytes. */
+#define WP_MLKEM768_CT_LEN              1088
+/** Length of an ML-KEM shared secret in bytes. */
+#define WP_MLKEM_SS_LEN                 32
+/** Length of random for ML-KEM key generation in bytes - d || z. */
+#define WP_MLKEM_GEN_RAND_LEN           64
+/** Length of random for ML-KEM encapsulation in bytes - m. */
+#define WP_MLKEM_ENC_RAND_LEN           32
+
+/** Length of an uncompressed NIST P-256 point in bytes. */
+#define WP_P256_PUB_LEN                 65
+/** Length of a NIST P-256 private key and shared secret in bytes. */
+#define WP_P256_LEN                     32
+
+/** Maximum length of an encoded public key in bytes. */
+#define WP_MLKEM_MAX_PUB_LEN            (WP_MLKEM768_PUB_LEN + WP_P256_PUB_LEN)
+/** Maximum length of an encoded private key in bytes. */
+#define WP_MLKEM_MAX_PRIV_LEN           (WP_MLKEM768_PRIV_LEN + WP_P256_LEN)
+/** Maximum length of random drawn for one operation in bytes. */
+#define WP_MLKEM_MAX_RAND_LEN                                                  \
+    (WP_MLKEM_GEN_RAND_LEN + CURVE25519_KEYSIZE)
+
+
+/**
+ * ML-KEM and hybrid key data.
+ */
+typedef struct wp_MlKemData {
+    /** Type of key. */
+    int keyType;
+    /** Name of key type - also name of group. */
+    const char* name;
+    /** Classical key of hybrid. WP_MLKEM_ECDH_* value. */
+    int ecdh;
+    /** Length of encoded classical public key in bytes. */
+    size_t ecdhPubLen;
+    /** Length of classical private key and shared secret in bytes. */
+    size_t ecdhLen;
+    /** ML-KEM part comes before classical part in encodings. */
+    int mlkemFirst;
+    /** Number of bits of security. */
+    int secBits;
+    /** Slot of key pool. WP_KEY_POOL_* value. */
+    int poolId;
+} wp_MlKemData;
+
+/**
+ * ML-KEM or hybrid key.
+ */
+struct wp_MlKem {
+    /** wolfSSL ML-KEM key. */
+    KyberKey mlkem;
+    /** wolfSSL classical key - see data field for type. */
+    union {
+        /** Curve25519 key object for ECDH. */
+        curve25519_key x25519;
+        /** ECC key object for ECDH. */
+        ecc_key ecc;
+    } ecdh;
+    /** Data describing the key type. */
+    const wp_MlKemData* data;
+
+    /** Count of references to this object. */
+    wp_RefCnt refCnt;
+
+    /** Provider context - for random number generation. */
+    WOLFPROV_CTX* provCtx;
+
+    /** Public key available. */
+    unsigned int hasPub:1;
+    /** Private key available. */
+    unsigned int hasPriv:1;
+};
+
+/**
+ * ML-KEM key generation context.
+ */
+typedef struct wp_MlKemGenCtx {
+    /** Data describing the key type. */
+    const wp_MlKemData* data;
+
+    /** Provider context - used when creating an ML-KEM key. */
+    WOLFPROV_CTX* provCtx;
+    /** The parts of an ML-KEM key to generate. */
+    int selection;
+} wp_MlKemGenCtx;
+
+
+/* Prototype for ML-KEM generation initialization. */
+static int wp_mlkem_gen_set_params(wp_MlKemGenCtx* ctx,
+    const OSSL_PARAM params[]);
+
+/*
+ * Layout of encodings
+ */
+
+/**
+ * Get the offsets of the ML-KEM and classical parts of an encoding.
+ *
+ * @param [in]  data       Data describing the key type.
+ * @param [in]  mlkemLen   Length of ML-KEM part in bytes.
+ * @param [in]  ecdhLen    Length of classical part in bytes.
+ * @param [out] mlkemOff   Offset of ML-KEM part.
+ * @param [out] ecdhOff    Offset of classical part.
+ */
+static void wp_mlkem_layout(const wp_MlKemData* data, size_t mlkemLen,
+    size_t ecdhLen, size_t* mlkemOff, size_t* ecdhOff)
+{
+    if (data->mlkemFirst) {
+        *mlkemOff = 0;
+        *ecdhOff  = mlkemLen;
+    }
+    else {
+        *ecdhOff  = 0;
+        *mlkemOff = ecdhLen;
+    }
+}
+
+/**
+ * Get the length of the encoded public key.
+ *
+ * @param [in] data  Data describing the key type.
+ * @return  Length of encoded public key in bytes.
+ */
+static size_t wp_mlkem_pub_len(const wp_MlKemData* data)
+{
+    return WP_MLKEM768_PUB_LEN + data->ecdhPubLen;
+}
+
+/**
+ * Get the length of the encoded private key.
+ *
+ * @param [in] data  Data describing the key type.
+ * @return  Length of encoded private key in bytes.
+ */
+static size_t wp_mlkem_priv_len(const wp_MlKemData* data)
+{
+    return WP_MLKEM768_PRIV_LEN + data->ecdhLen;
+}
+
+/*
+ * Classical half
+ */
+
+/**
+ * Initialize the classical key of a hybrid.
+ *
+ * @param [in, out] mlkem  ML-KEM key object.
+ * @return  0 on success.
+ * @return  Other value on failure.
+ */
+static int wp_mlkem_ecdh_init(wp_MlKem* mlkem)
+{
+    int rc = 0;
+
+    if (mlkem->data->ecdh == WP_MLKEM_ECDH_X25519) {
+        rc = wc_curve25519_init(&mlkem->ecdh.x25519);
+    }
+    else if (mlkem->data->ecdh == WP_MLKEM_ECDH_P256) {
+        rc = wc_ecc_init_ex(&mlkem->ecdh.ecc, NULL, INVALID_DEVID);
+    }
+
+    return rc;
+}
+
+/**
+ * Dispose of the classical key of a hybrid.
+ *
+ * @param [in, out] mlkem  ML-KEM key object.
+ */
+static void wp_mlkem_ecdh_free(wp_MlKem* mlkem)
+{
+    if (mlkem->data->ecdh == WP_MLKEM_ECDH_X25519) {
+        wc_curve25519_free(&mlkem->ecdh.x25519);
+    }
+    else if (mlkem->data->ecdh == WP_MLKEM_ECDH_P256) {
+        wc_ecc_free(&mlkem->ecdh.ecc);
+    }
+}
+
+/**
+ * Make an X25519 key from random bytes.
+ *
+ * @param [in, out] key   wolfSSL X25519 key object.
+ * @param [in]      rand  Random bytes. CURVE25519_KEYSIZE bytes.
+ * @return  0 on success.
+ * @return  Other value on failure.
+ */
+static int wp_mlkem_x25519_make_key(curve25519_key* key, const byte* rand)
+{
+    int rc;
+    byte priv[CURVE25519_KEYSIZE];
+    byte pub[CURVE25519_KEYSIZE];
+
+    XMEMCPY(priv, rand, CURVE25519_KEYSIZE);
+    /* Clamp as per RFC 7748. */
+    priv[0] &= 248;
+    priv[CURVE25519_KEYSIZE - 1] &= 127;
+    priv[CURVE25519_KEYSIZE - 1] |= 64;
+
+    rc = wc_curve25519_make_pub(CURVE25519_KEYSIZE, pub, CURVE25519_KEYSIZE,
+        priv);
+    if (rc == 0) {
+        rc = wc_curve25519_import_private_raw_ex(priv, CURVE25519_KEYSIZE, pub,
+            CURVE25519_KEYSIZE, key, EC25519_LITTLE_ENDIAN);
+    }
+    OPENSSL_cleanse(priv, sizeof(priv));
+
+    return rc;
+}
+
+/**
+ * Import an X25519 public key.
+ *
+ * OpenSSL masks off the top bit of the public key.
+ *
+ * @param [in, out] key  wolfSSL X25519 key object.
+ * @param [in]      in   Encoded public key. CURVE25519_KEYSIZE bytes.
+ * @return  0 on success.
+ * @return  Other value on failure.
+ */
+static int wp_mlkem_x25519_import_pub(curve25519_key* key, const byte* in)
+{
+    byte pub[CURVE25519_KEYSIZE];
+
+    XMEMCPY(pub, in, CURVE25519_KEYSIZE);
+    pub[CURVE25519_KEYSIZE - 1] &= 0x7f;
+    return wc_curve25519_import_public_ex(pub, CURVE25519_KEYSIZE, key,
+        EC25519_LITTLE_ENDIAN);
+}
+
+/**
+ * Import a NIST P-256 public key and check it is on the curve.
+ *
+ * @param [in, out] key  wolfSSL ECC key object.
+ * @param [in]      in   Uncompressed point. WP_P256_PUB_LEN bytes.
+ * @return  0 on success.
+ * @return  Other value on failure.
+ */
+static int wp_mlkem_p256_import_pub(ecc_key* key, const byte* in)
+{
+    int rc;
+
+    rc = wc_ecc_import_x963_ex(in, WP_P256_PUB_LEN, key, ECC_SECP256R1);
+    if (rc == 0) {
+        rc = wc_ecc_check_key(key);
+    }
+
+    return rc;
+}
+
+/**
+ * Export an uncompressed NIST P-256 public key.
+ *
+ * @param [in]  key  wolfSSL ECC key object.
+ * @param [out] out  Buffer to hold point. WP_P256_PUB_LEN bytes.
+ * @return  0 on success.
+ * @return  Other value on failure.
+ */
+static int wp_mlkem_p256_export_pub(ecc_key* key, byte* out)
+{
+    word32 len = WP_P256_PUB_LEN;
+
+    return wc_ecc_export_x963_ex(key, out, &len, 0);
+}
+
+/**
+ * Calculate the NIST P-256 shared secret.
+ *
+ * The private key may be shared between threads so the RNG is set on a copy.
+ *
+ * @param [in]  priv     wolfSSL ECC key object with private key.
+ * @param [in]  pub      wolfSSL ECC key object with public key.
+ * @param [in]  rng      Random number generator for blinding.
+ * @param [out] secret   Buffer to hold secret. WP_P256_LEN bytes.
+ * @return  0 on success.
+ * @return  Other value on failure.
+ */
+static int wp_mlkem_p256_secret(ecc_key* priv, ecc_key* pub, WC_RNG* rng,
+    byte* secret)
+{
+    int rc;
+    word32 len = WP_P256_LEN;
+    ecc_key key;
+
+    rc = wp_ecc_copy_priv(priv, &key, INVALID_DEVID);
+    if (rc == 0) {
+    #ifdef ECC_TIMING_RESISTANT
+        rc = wc_ecc_set_rng(&key, rng);
+    #else
+        (void)rng;
+    #endif
+        if (rc == 0) {
+            rc = wc_ecc_shared_secret(&key, pub, secret, &len);
+        }
+        wc_ecc_free(&key);
+    }
+
+    return rc;
+}
+
+/**
+ * Encode the classical public key of a hybrid.
+ *
+ * @param [in]  mlkem  ML-KEM key object.
+ * @param [out] out    Buffer to hold encoding. data->ecdhPubLen bytes.
+ * @return  0 on success.
+ * @return  Other value on failure.
+ */
+static int wp_mlkem_ecdh_export_pub(wp_MlKem* mlkem, byte* out)
+{
+    int rc = 0;
+
+    if (mlkem->data->ecdh == WP_MLKEM_ECDH_X25519) {
+        word32 len = CURVE25519_KEYSIZE;
+
+        rc = wc_curve25519_export_public_ex(&mlkem->ecdh.x25519, out, &len,
+            EC25519_LITTLE_ENDIAN);
+    }
+    else if (mlkem->data->ecdh == WP_MLKEM_ECDH_P256) {
+        rc = wp_mlkem_p256_export_pub(&mlkem->ecdh.ecc, out);
+    }
+
+    return rc;
+}
+
+/**
+ * Decode the classical public key of a hybrid.
+ *
+ * @param [in, out] mlkem  ML-KEM key object.
+ * @param [in]      in     Encoding. data->ecdhPubLen bytes.
+ * @return  0 on success.
+ * @return  Other value on failure.
+ */
+static int wp_mlkem_ecdh_import_pub(wp_MlKem* mlkem, const byte* in)
+{
+    int rc = 0;
+
+    if (mlkem->data->ecdh == WP_MLKEM_ECDH_X25519) {
+        rc = wp_mlkem_x25519_import_pub(&mlkem->ecdh.x25519, in);
+    }
+    else if (mlkem->data->ecdh == WP_MLKEM_ECDH_P256) {
+        rc = wp_mlkem_p256_import_pub(&mlkem->ecdh.ecc, in);
+    }
+
+    return rc;
+}
+
+/**
+ * Encode the classical private key of a hybrid.
+ *
+ * @param [in]  mlkem  ML-KEM key object.
+ * @param [out] out    Buffer to hold encoding. data->ecdhLen bytes.
+ * @return  0 on success.
+ * @return  Other value on failure.
+ */
+static int wp_mlkem_ecdh_export_priv(wp_MlKem* mlkem, byte* out)
+{
+    int rc = 0;
+    word32 len = (word32)mlkem->data->ecdhLen;
+
+    if (mlkem->data->ecdh == WP_MLKEM_ECDH_X25519) {
+        rc = wc_curve25519_export_private_raw_ex(&mlkem->ecdh.x25519, out,
+            &len, EC25519_LITTLE_ENDIAN);
+    }
+    else if (mlkem->data->ecdh == WP_MLKEM_ECDH_P256) {
+        rc = wc_ecc_export_private_only(&mlkem->ecdh.ecc, out, &len);
+    }
+
+    return rc;
+}
+
+/**
+ * Decode the classical private key of a hybrid and calculate public key.
+ *
+ * @param [in, out] mlkem  ML-KEM key object.
+ * @param [in]      in     Encoding. data->ecdhLen bytes.
+ * @return  0 on success.
+ * @return  Other value on failure.
+ */
+static int wp_mlkem_ecdh_import_priv(wp_MlKem* mlkem, const byte* in)
+{
+    int rc = 0;
+
+    if (mlkem->data->ecdh == WP_MLKEM_ECDH_X25519) {
+        rc = wp_mlkem_x25519_make_key(&mlkem->ecdh.x25519, in);
+    }
+    else if (mlkem->data->ecdh == WP_MLKEM_ECDH_P256) {
+        rc = wc_ecc_import_private_key_ex(in, WP_P256_LEN, NULL, 0,
+            &mlkem->ecdh.ecc, ECC_SECP256R1);
+        if (rc == 0) {
+            rc = wc_ecc_make_pub(&mlkem->ecdh.ecc, NULL);
+        }
+    }
+
+    return rc;
+}
+
+/*
+ * ML-KEM key
+ */
+
+/**
+ * Increment reference count for key.
+ *
+ * Used in key generation and KEM operations.
+ *
+ * @param [in, out] mlkem  ML-KEM key object.
+ * @return  1 on success.
+ * @return  0 when multi-threaded and locking fails.
+ */
+int wp_mlkem_up_ref(wp_MlKem* mlkem)
+{
+    return wp_refcnt_up(&mlkem->refCnt);
+}
+
+/**
+ * Create a new ML-KEM key object. Base function.
+ *
+ * @param [in] provCtx  Provider context.
+ * @param [in] data     Data describing the key type.
+ * @return  New ML-KEM key object on success.
+ * @return  NULL on failure.
+ */
+static wp_MlKem* wp_mlkem_new(WOLFPROV_CTX* provCtx, const wp_MlKemData* data)
+{
+    wp_MlKem* mlkem = NULL;
+
+    if (wolfssl_prov_is_running()) {
+        mlkem = (wp_MlKem*)OPENSSL_zalloc(sizeof(*mlkem));
+    }
+    if (mlkem != NULL) {
+        int ok = 1;
+        int rc;
+
+        mlkem->data = data;
+        rc = wc_KyberKey_Init(WC_ML_KEM_768, &mlkem->mlkem, NULL,
+            INVALID_DEVID);
+        if (rc != 0) {
+            ok = 0;
+        }
+        if (ok) {
+            rc = wp_mlkem_ecdh_init(mlkem);
+            if (rc != 0) {
+                wc_KyberKey_Free(&mlkem->mlkem);
+                ok = 0;
+            }
+        }
+        if (ok && (!wp_refcnt_init(&mlkem->refCnt))) {
+            wp_mlkem_ecdh_free(mlkem);
+            wc_KyberKey_Free(&mlkem->mlkem);
+            ok = 0;
+        }
+
+        if (ok) {
+            mlkem->provCtx = provCtx;
+        }
+
+        if (!ok) {
+            OPENSSL_free(mlkem);
+            mlkem = NULL;
+        }
+    }
+
+    return mlkem;
+}
+
+/**
+ * Dispose of ML-KEM key object.
+ *
+ * @param [in, out] mlkem  ML-KEM key object.
+ */
+void wp_mlkem_free(wp_MlKem* mlkem)
+{
+    if (mlkem != NULL) {
+        int cnt = wp_refcnt_down(&mlkem->refCnt);
+
+        if (cnt == 0) {
+            wp_refcnt_free(&mlkem->refCnt);
+            wp_mlkem_ecdh_free(mlkem);
+            wc_KyberKey_Free(&mlkem->mlkem);
+            OPENSSL_clear_free(mlkem, sizeof(*mlkem));
+        }
+    }
+}
+
+/**
+ * Encode the public key of an ML-KEM key object.
+ *
+ * Hybrid keys have both parts encoded into the buffer.
+ *
+ * @param [in]  mlkem  ML-KEM key object.
+ * @param [out] out    Buffer to hold encoding. wp_mlkem_pub_len() bytes.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_mlkem_export_pub(wp_MlKem* mlkem, unsigned char* out)
+{
+    int ok = 1;
+    int rc;
+    size_t mOff;
+    size_t eOff;
+
+    wp_mlkem_layout(mlkem->data, WP_MLKEM768_PUB_LEN, mlkem->data->ecdhPubLen,
+        &mOff, &eOff);
+    rc = wc_KyberKey_EncodePublicKey(&mlkem->mlkem, out + mOff,
+        WP_MLKEM768_PUB_LEN);
+    if (rc != 0) {
+        ok = 0;
+    }
+    if (ok && (wp_mlkem_ecdh_export_pub(mlkem, out + eOff) != 0)) {
+        ok = 0;
+    }
+
+    return ok;
+}
+
+/**
+ * Decode the public key into an ML-KEM key object.
+ *
+ * @param [in, out] mlkem  ML-KEM key object.
+ * @param [in]      in     Encoded public key.
+ * @param [in]      len    Length of encoding in bytes.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_mlkem_import_pub(wp_MlKem* mlkem, const unsigned char* in,
+    size_t len)
+{
+    int ok = 1;
+    int rc;
+    size_t mOff;
+    size_t eOff;
+
+    if (len != wp_mlkem_pub_len(mlkem->data)) {
+        ok = 0;
+    }
+    if (ok) {
+        wp_mlkem_layout(mlkem->data, WP_MLKEM768_PUB_LEN,
+            mlkem->data->ecdhPubLen, &mOff, &eOff);
+        rc = wc_KyberKey_DecodePublicKey(&mlkem->mlkem, in + mOff,
+            WP_MLKEM768_PUB_LEN);
+        if (rc != 0) {
+            ok = 0;
+        }
+    }
+    if (ok && (wp_mlkem_ecdh_import_pub(mlkem, in + eOff) != 0)) {
+        ok = 0;
+    }
+    if (ok) {
+        mlkem->hasPub = 1;
+    }
+
+    return ok;
+}
+
+/**
+ * Encode the private key of an ML-KEM key object.
+ *
+ * @param [in]  mlkem  ML-KEM key object.
+ * @param [out] out    Buffer to hold encoding. wp_mlkem_priv_len() bytes.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_mlkem_export_priv(wp_MlKem* mlkem, unsigned char* out)
+{
+    int ok = 1;
+    int rc;
+    size_t mOff;
+    size_t eOff;
+
+    wp_mlkem_layout(mlkem->data, WP_MLKEM768_PRIV_LEN, mlkem->data->ecdhLen,
+        &mOff, &eOff);
+    rc = wc_KyberKey_EncodePrivateKey(&mlkem->mlkem, out + mOff,
+        WP_MLKEM768_PRIV_LEN);
+    if (rc != 0) {
+        ok = 0;
+    }
+    if (ok && (wp_mlkem_ecdh_export_priv(mlkem, out + eOff) != 0)) {
+        ok = 0;
+    }
+
+    return ok;
+}
+
+/**
+ * Decode the private key into an ML-KEM key object.
+ *
+ * The encoded ML-KEM private key contains the public key and the classical
+ * public key is calculated so the public key is available afterwards.
+ *
+ * @param [in, out] mlkem  ML-KEM key object.
+ * @param [in]      in     Encoded private key.
+ * @param [in]      len    Length of encoding in bytes.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_mlkem_import_priv(wp_MlKem* mlkem, const unsigned char* in,
+    size_t len)
+{
+    int ok = 1;
+    int rc;
+    size_t mOff;
+    size_t eOff;
+
+    if (len != wp_mlkem_priv_len(mlkem->data)) {
+        ok = 0;
+    }
+    if (ok) {
+        wp_mlkem_layout(mlkem->data, WP_MLKEM768_PRIV_LEN,
+            mlkem->data->ecdhLen, &mOff, &eOff);
+        rc = wc_KyberKey_DecodePrivateKey(&mlkem->mlkem, in + mOff,
+            WP_MLKEM768_PRIV_LEN);
+        if (rc != 0) {
+            ok = 0;
+        }
+    }
+    if (ok && (wp_mlkem_ecdh_import_priv(mlkem, in + eOff) != 0)) {
+        ok = 0;
+    }
+    if (ok) {
+        mlkem->hasPub = 1;
+        mlkem->hasPriv = 1;
+    }
+
+    return ok;
+}
+
+/**
+ * Duplicate specific parts of an ML-KEM key object.
+ *
+ * @param [in] src        Source ML-KEM key object.
+ * @param [in] selection  Parts of key to include.
+ * @return  NULL on failure.
+ * @return  New ML-KEM key object on success.
+ */
+static wp_MlKem* wp_mlkem_dup(wp_MlKem* src, int selection)
+{
+    wp_MlKem* dst;
+
+    dst = wp_mlkem_new(src->provCtx, src->data);
+    if (dst != NULL) {
+        int ok = 1;
+        unsigned char buf[WP_MLKEM_MAX_PRIV_LEN];
+
+        if (src->hasPriv &&
+                ((selection & OSSL_KEYMGMT_SELECT_PRIVATE_KEY) != 0)) {
+            size_t len = wp_mlkem_priv_len(src->data);
+
+            ok = wp_mlkem_export_priv(src, buf) &&
+                 wp_mlkem_import_priv(dst, buf, len);
+            OPENSSL_cleanse(buf, len);
+        }
+        else if (src->hasPub &&
+                ((selection & OSSL_KEYMGMT_SELECT_PUBLIC_KEY) != 0)) {
+            ok = wp_mlkem_export_pub(src, buf) &&
+                 wp_mlkem_import_pub(dst, buf, wp_mlkem_pub_len(src->data));
+        }
+
+        if (!ok) {
+            wp_mlkem_free(dst);
+            dst = NULL;
+        }
+    }
+
+    return dst;
+}
+
+/**
+ * Load the ML-KEM key.
+ *
+ * Return the ML-KEM key object taken out of the reference.
+ *
+ * @param [in, out] pMlKem  Pointer to an ML-KEM key object.
+ * @parma [in]      size    Size of data structure that is the ML-KEM key
+ *                          object. Unused.
+ * @return  NULL when no ML-KEM key object at reference.
+ * @return  ML-KEM key object from reference on success.
+ */
+static const wp_MlKem* wp_mlkem_load(const wp_MlKem** pMlKem, size_t size)
+{
+    const wp_MlKem* mlkem = *pMlKem;
+    (void)size;
+    *pMlKem = NULL;
+    return mlkem;
+}
+
+/**
+ * Return an array of supported settable parameters for the ML-KEM key.
+ *
+ * @param [in] provCtx  Provider context object. Unused.
+ * @return  Array of parameters with data type.
+ */
+static const OSSL_PARAM* wp_mlkem_settable_params(WOLFPROV_CTX* provCtx)
+{
+    /**
+     * Supported settable parameters for ML-KEM key.
+     */
+    static const OSSL_PARAM wp_mlkem_supported_settable_params[] = {
+        OSSL_PARAM_octet_string(OSSL_PKEY_PARAM_ENCODED_PUBLIC_KEY, NULL, 0),
+        OSSL_PARAM_END
+    };
+    (void)provCtx;
+    return wp_mlkem_supported_settable_params;
+}
+
+/**
+ * Set the ML-KEM key parameters.
+ *
+ * Server sets the peer's key share as the encoded public key.
+ *
+ * @param [in, out] mlkem   ML-KEM key object.
+ * @param [in]      params  Array of parameters and values.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_mlkem_set_params(wp_MlKem* mlkem, const OSSL_PARAM params[])
+{
+    int ok = 1;
+    unsigned char* data = NULL;
+    size_t len;
+
+    if (!wp_params_get_octet_string_ptr(params,
+            OSSL_PKEY_PARAM_ENCODED_PUBLIC_KEY, &data, &len)) {
+        ok = 0;
+    }
+    if (ok && (data != NULL) && (!wp_mlkem_import_pub(mlkem, data, len))) {
+        ok = 0;
+    }
+
+    return ok;
+}
+
+/**
+ * Return an array of supported gettable parameters for the ML-KEM key object.
+ *
+ * @param [in] provCtx  Provider context object. Unused.
+ * @return  Array of parameters with data type.
+ */
+static const OSSL_PARAM* wp_mlkem_gettable_params(WOLFPROV_CTX* provCtx)
+{
+    /**
+     * Supported gettable parameters for ML-KEM key object.
+     */
+    static const OSSL_PARAM wp_mlkem_supported_gettable_params[] = {
+        OSSL_PARAM_int(OSSL_PKEY_PARAM_BITS, NULL),
+        OSSL_PARAM_int(OSSL_PKEY_PARAM_SECURITY_BITS, NULL),
+        OSSL_PARAM_int(OSSL_PKEY_PARAM_MAX_SIZE, NULL),
+        OSSL_PARAM_octet_string(OSSL_PKEY_PARAM_ENCODED_PUBLIC_KEY, NULL, 0),
+        OSSL_PARAM_octet_string(OSSL_PKEY_PARAM_PUB_KEY, NULL, 0),
+        OSSL_PARAM_octet_string(OSSL_PKEY_PARAM_PRIV_KEY, NULL, 0),
+        OSSL_PARAM_END
+    };
+    (void)provCtx;
+    return wp_mlkem_supported_gettable_params;
+}
+
+/**
+ * Get an encoded key into a parameter.
+ *
+ * @param [in]      mlkem   ML-KEM key object.
+ * @param [in, out] params  Array of parameters and values.
+ * @param [in]      key     Name of parameter.
+ * @param [in]      priv    Whether to encode the private key.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_mlkem_get_params_key(wp_MlKem* mlkem, OSSL_PARAM params[],
+    const char* key, int priv)
+{
+    int ok = 1;
+    OSSL_PARAM* p;
+
+    p = OSSL_PARAM_locate(params, key);
+    if (p != NULL) {
+        size_t len = priv ? wp_mlkem_priv_len(mlkem->data) :
+                            wp_mlkem_pub_len(mlkem->data);
+
+        if (p->data_type != OSSL_PARAM_OCTET_STRING) {
+            ok = 0;
+        }
+        else if (p->data != NULL) {
+            if ((priv && (!mlkem->hasPriv)) || ((!priv) && (!mlkem->hasPub))) {
+                ok = 0;
+            }
+            else if (p->data_size < len) {
+                ok = 0;
+            }
+            else if (priv) {
+                ok = wp_mlkem_export_priv(mlkem, p->data);
+            }
+            else {
+                ok = wp_mlkem_export_pub(mlkem, p->data);
+            }
+        }
+        p->return_size = len;
+    }
+
+    return ok;
+}
+
+/**
+ * Get the ML-KEM key parameters.
+ *
+ * @param [in]      mlkem   ML-KEM key object.
+ * @param [in, out] params  Array of parameters and values.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_mlkem_get_params(wp_MlKem* mlkem, OSSL_PARAM params[])
+{
+    int ok = 1;
+    OSSL_PARAM* p;
+
+    p = OSSL_PARAM_locate(params, OSSL_PKEY_PARAM_MAX_SIZE);
+    if ((p != NULL) && (!OSSL_PARAM_set_int(p,
+            (int)(WP_MLKEM768_CT_LEN + mlkem->data->ecdhPubLen)))) {
+        ok = 0;
+    }
+    if (ok) {
+        p = OSSL_PARAM_locate(params, OSSL_PKEY_PARAM_BITS);
+        if ((p != NULL) && (!OSSL_PARAM_set_int(p,
+                (int)(8 * wp_mlkem_pub_len(mlkem->data))))) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        p = OSSL_PARAM_locate(params, OSSL_PKEY_PARAM_SECURITY_BITS);
+        if ((p != NULL) && (!OSSL_PARAM_set_int(p, mlkem->data->secBits))) {
+            ok = 0;
+        }
+    }
+    if (ok && (!wp_mlkem_get_params_key(mlkem, params,
+            OSSL_PKEY_PARAM_ENCODED_PUBLIC_KEY, 0))) {
+        ok = 0;
+    }
+    if (ok && (!wp_mlkem_get_params_key(mlkem, params,
+            OSSL_PKEY_PARAM_PUB_KEY, 0))) {
+        ok = 0;
+    }
+    if (ok && (!wp_mlkem_get_params_key(mlkem, params,
+            OSSL_PKEY_PARAM_PRIV_KEY, 1))) {
+        ok = 0;
+    }
+
+    return ok;
+}
+
+/**
+ * Check ML-KEM key object has the components required.
+ *
+ * @param [in] mlkem      ML-KEM key object.
+ * @param [in] selection  Parts of key required.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_mlkem_has(const wp_MlKem* mlkem, int selection)
+{
+    int ok = 1;
+
+    if (!wolfssl_prov_is_running()) {
+       ok = 0;
+    }
+    if (mlkem == NULL) {
+       ok = 0;
+    }
+    if (ok && ((selection & WP_MLKEM_POSSIBLE_SELECTIONS) != 0)) {
+        if ((selection & OSSL_KEYMGMT_SELECT_PUBLIC_KEY) != 0)
+            ok &= mlkem->hasPub;
+        if ((selection & OSSL_KEYMGMT_SELECT_PRIVATE_KEY) != 0)
+            ok &= mlkem->hasPriv;
+    }
+
+    return ok;
+}
+
+/**
+ * Check that two ML-KEM key objects match for the components specified.
+ *
+ * The encoded public key is compared for both public and private selections
+ * as the private key determines the public key.
+ *
+ * @parma [in] mlkem1     First ML-KEM key object.
+ * @parma [in] mlkem2     Second ML-KEM key object.
+ * @param [in] selection  Parts of key to match.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_mlkem_match(wp_MlKem* mlkem1, wp_MlKem* mlkem2, int selection)
+{
+    int ok = 1;
+
+    if (!wolfssl_prov_is_running()) {
+        ok = 0;
+    }
+    if (ok && (mlkem1->data->keyType != mlkem2->data->keyType)) {
+        ok = 0;
+    }
+    if (ok && ((selection & OSSL_KEYMGMT_SELECT_KEYPAIR) != 0)) {
+        unsigned char key1[WP_MLKEM_MAX_PUB_LEN];
+        unsigned char key2[WP_MLKEM_MAX_PUB_LEN];
+
+        ok = mlkem1->hasPub && mlkem2->hasPub &&
+             wp_mlkem_export_pub(mlkem1, key1) &&
+             wp_mlkem_export_pub(mlkem2, key2) &&
+             (XMEMCMP(key1, key2, wp_mlkem_pub_len(mlkem1->data)) == 0);
+    }
+
+    return ok;
+}
+
+/**
+ * Validate the ML-KEM key.
+ *
+ * Public keys are checked when decoded.
+ *
+ * @param [in] mlkem      ML-KEM key object.
+ * @param [in] selection  Parts of key to validate.
+ * @param [in] checkType  How thorough to check key. Unused.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_mlkem_validate(const wp_MlKem* mlkem, int selection,
+    int checkType)
+{
+    (void)checkType;
+    return wp_mlkem_has(mlkem, selection);
+}
+
+/**
+ * Import the key into ML-KEM key object from parameters.
+ *
+ * @param [in, out] mlkem      ML-KEM key object.
+ * @param [in]      selection  Parts of key to import.
+ * @param [in]      params     Array of parameters and values.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_mlkem_import(wp_MlKem* mlkem, int selection,
+    const OSSL_PARAM params[])
+{
+    int ok = 1;
+    unsigned char* privData = NULL;
+    unsigned char* pubData = NULL;
+    size_t len;
+
+    if ((!wolfssl_prov_is_running()) || (mlkem == NULL)) {
+        ok = 0;
+    }
+    if (ok && ((selection & WP_MLKEM_POSSIBLE_SELECTIONS) == 0)) {
+        ok = 0;
+    }
+    if (ok && ((selection & OSSL_KEYMGMT_SELECT_PRIVATE_KEY) != 0)) {
+        if (!wp_params_get_octet_string_ptr(params, OSSL_PKEY_PARAM_PRIV_KEY,
+                &privData, &len)) {
+            ok = 0;
+        }
+        if (ok && (privData != NULL) &&
+                (!wp_mlkem_import_priv(mlkem, privData, len))) {
+            ok = 0;
+        }
+    }
+    if (ok && (privData == NULL) &&
+            ((selection & OSSL_KEYMGMT_SELECT_PUBLIC_KEY) != 0)) {
+        if (!wp_params_get_octet_string_ptr(params, OSSL_PKEY_PARAM_PUB_KEY,
+                &pubData, &len)) {
+            ok = 0;
+        }
+        if (ok && (pubData != NULL) &&
+                (!wp_mlkem_import_pub(mlkem, pubData, len))) {
+            ok = 0;
+        }
+    }
+    if (ok && (privData == NULL) && (pubData == NULL)) {
+        ok = 0;
+    }
+
+    return ok;
+}
+
+/**
+ * Table of key parameters for difference selections.
+ */
+static const OSSL_PARAM wp_mlkem_key_params[] = {
+    /* 0 */
+    OSSL_PARAM_END,
+
+    /* 1 */
+    OSSL_PARAM_octet_string(OSSL_PKEY_PARAM_PUB_KEY, NULL, 0),
+    OSSL_PARAM_END,
+
+    /* 3 */
+    OSSL_PARAM_octet_string(OSSL_PKEY_PARAM_PRIV_KEY, NULL, 0),
+    OSSL_PARAM_octet_string(OSSL_PKEY_PARAM_PUB_KEY, NULL, 0),
+    OSSL_PARAM_END,
+};
+
+/**
+ * Get the key parameters for a selection.
+ *
+ * @param [in] selection  Parts of key to import/export.
+ * @return  Terminated array of parameters.
+ */
+static const OSSL_PARAM* wp_mlkem_key_types(int selection)
+{
+    int idx = 0;
+
+    if ((selection & OSSL_KEYMGMT_SELECT_PRIVATE_KEY) != 0) {
+        idx = 3;
+    }
+    else if ((selection & OSSL_KEYMGMT_SELECT_PUBLIC_KEY) != 0) {
+        idx = 1;
+    }
+
+    return &wp_mlkem_key_params[idx];
+}
+
+/**
+ * Export the ML-KEM key.
+ *
+ * Key data placed in parameters and then passed to callback.
+ *
+ * @param [in] mlkem      ML-KEM key object.
+ * @param [in] selection  Parts of key to export.
+ * @param [in] paramCb    Function to pass constructed parameters to.
+ * @param [in] cbArg      Argument to pass to callback.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_mlkem_export(wp_MlKem* mlkem, int selection,
+    OSSL_CALLBACK* paramCb, void* cbArg)
+{
+    int ok = 1;
+    OSSL_PARAM params[3];
+    int i = 0;
+    unsigned char* data = NULL;
+    size_t pubLen = wp_mlkem_pub_len(mlkem->data);
+    size_t privLen = 0;
+    int expPriv = mlkem->hasPriv &&
+        ((selection & OSSL_KEYMGMT_SELECT_PRIVATE_KEY) != 0);
+
+    XMEMSET(params, 0, sizeof(params));
+    if (!mlkem->hasPub) {
+        ok = 0;
+    }
+    if (ok) {
+        if (expPriv) {
+            privLen = wp_mlkem_priv_len(mlkem->data);
+        }
+        data = OPENSSL_malloc(pubLen + privLen);
+        if (data == NULL) {
+            ok = 0;
+        }
+    }
+    if (ok && (!wp_mlkem_export_pub(mlkem, data))) {
+        ok = 0;
+    }
+    if (ok) {
+        wp_param_set_octet_string_ptr(&params[i++], OSSL_PKEY_PARAM_PUB_KEY,
+            data, pubLen);
+    }
+    if (ok && expPriv) {
+        if (!wp_mlkem_export_priv(mlkem, data + pubLen)) {
+            ok = 0;
+        }
+        if (ok) {
+            wp_param_set_octet_string_ptr(&params[i++],
+                OSSL_PKEY_PARAM_PRIV_KEY, data + pubLen, privLen);
+        }
+    }
+    if (ok) {
+        ok = paramCb(params, cbArg);
+    }
+    OPENSSL_clear_free(data, pubLen + privLen);
+
+    return ok;
+}
+
+/*
+ * ML-KEM encapsulation and decapsulation
+ */
+
+/**
+ * Get the length of the ciphertext of the key type in bytes.
+ *
+ * @param [in] mlkem  ML-KEM key object.
+ * @return  Length of ciphertext in bytes.
+ */
+size_t wp_mlkem_get_ct_len(const wp_MlKem* mlkem)
+{
+    return WP_MLKEM768_CT_LEN + mlkem->data->ecdhPubLen;
+}
+
+/**
+ * Get the length of the shared secret of the key type in bytes.
+ *
+ * @param [in] mlkem  ML-KEM key object.
+ * @return  Length of shared secret in bytes.
+ */
+size_t wp_mlkem_get_ss_len(const wp_MlKem* mlkem)
+{
+    return WP_MLKEM_SS_LEN + mlkem->data->ecdhLen;
+}
+
+/**
+ * Check the ML-KEM key object has a public key.
+ *
+ * @param [in] mlkem  ML-KEM key object.
+ * @return  1 when public key available.
+ * @return  0 otherwise.
+ */
+int wp_mlkem_has_pub(const wp_MlKem* mlkem)
+{
+    return mlkem->hasPub;
+}
+
+/**
+ * Check the ML-KEM key object has a private key.
+ *
+ * @param [in] mlkem  ML-KEM key object.
+ * @return  1 when private key available.
+ * @return  0 otherwise.
+ */
+int wp_mlkem_has_priv(const wp_MlKem* mlkem)
+{
+    return mlkem->hasPriv;
+}
+
+/**
+ * Encapsulate against the classical public key of a hybrid.
+ *
+ * X25519 ephemeral key is made from the random drawn with the ML-KEM random.
+ *
+ * @param [in]  mlkem   ML-KEM key object holding peer's public key.
+ * @param [in]  rng     Random number generator.
+ * @param [in]  rand    Random bytes for X25519 ephemeral private key.
+ * @param [out] ct      Buffer to hold ephemeral public key.
+ * @param [out] ss      Buffer to hold classical shared secret.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_mlkem_ecdh_encap(wp_MlKem* mlkem, WC_RNG* rng, const byte* rand,
+    unsigned char* ct, unsigned char* ss)
+{
+    int ok = 1;
+    int rc;
+
+    if (mlkem->data->ecdh == WP_MLKEM_ECDH_X25519) {
+        curve25519_key eph;
+        word32 len = CURVE25519_KEYSIZE;
+
+        rc = wc_curve25519_init(&eph);
+        if (rc != 0) {
+            ok = 0;
+        }
+        else {
+            rc = wp_mlkem_x25519_make_key(&eph, rand);
+            if (rc == 0) {
+                rc = wc_curve25519_export_public_ex(&eph, ct, &len,
+                    EC25519_LITTLE_ENDIAN);
+            }
+            if (rc == 0) {
+                len = CURVE25519_KEYSIZE;
+                rc = wc_curve25519_shared_secret_ex(&eph, &mlkem->ecdh.x25519,
+                    ss, &len, EC25519_LITTLE_ENDIAN);
+            }
+            if (rc != 0) {
+                ok = 0;
+            }
+            wc_curve25519_free(&eph);
+        }
+    }
+    else if (mlkem->data->ecdh == WP_MLKEM_ECDH_P256) {
+        ecc_key eph;
+
+        rc = wc_ecc_init_ex(&eph, NULL, INVALID_DEVID);
+        if (rc != 0) {
+            ok = 0;
+        }
+        else {
+            wp_provctx_ecc_fp_use(mlkem->provCtx);
+            rc = wc_ecc_make_key_ex(rng, WP_P256_LEN, &eph, ECC_SECP256R1);
+            if (rc == 0) {
+                rc = wp_mlkem_p256_export_pub(&eph, ct);
+            }
+            if (rc == 0) {
+                rc = wp_mlkem_p256_secret(&eph, &mlkem->ecdh.ecc, rng, ss);
+            }
+            if (rc != 0) {
+                ok = 0;
+            }
+            wc_ecc_free(&eph);
+        }
+    }
+
+    return ok;
+}
+
+/**
+ * Encapsulate a shared secret against the public key.
+ *
+ * For hybrids, both halves are calculated with one draw of random and the
+ * ciphertexts and secrets are written directly into place.
+ *
+ * @param [in]  mlkem  ML-KEM key object holding peer's public key.
+ * @param [out] ct     Buffer to hold ciphertext. wp_mlkem_get_ct_len() bytes.
+ * @param [out] ss     Buffer to hold shared secret. wp_mlkem_get_ss_len()
+ *                     bytes.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+int wp_mlkem_encap(wp_MlKem* mlkem, unsigned char* ct, unsigned char* ss)
+{
+    int ok = 1;
+    int rc;
+    WC_RNG* rng = wp_provctx_get_rng(mlkem->provCtx);
+    byte rand[WP_MLKEM_MAX_RAND_LEN];
+    size_t randLen = WP_MLKEM_ENC_RAND_LEN;
+    size_t ctOff;
+    size_t ctEOff;
+    size_t ssOff;
+    size_t ssEOff;
+    word64 mStart = wp_metrics_start();
+
+    if ((!mlkem->hasPub) || (rng == NULL)) {
+        ok = 0;
+    }
+    if (ok) {
+        if (mlkem->data->ecdh == WP_MLKEM_ECDH_X25519) {
+            randLen += CURVE25519_KEYSIZE;
+        }
+        rc = wc_RNG_GenerateBlock(rng, rand, (word32)randLen);
+        if (rc != 0) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        wp_mlkem_layout(mlkem->data, WP_MLKEM768_CT_LEN,
+            mlkem->data->ecdhPubLen, &ctOff, &ctEOff);
+        wp_mlkem_layout(mlkem->data, WP_MLKEM_SS_LEN, mlkem->data->ecdhLen,
+            &ssOff, &ssEOff);
+        rc = wc_KyberKey_EncapsulateWithRandom(&mlkem->mlkem, ct + ctOff,
+            ss + ssOff, rand, WP_MLKEM_ENC_RAND_LEN);
+        if (rc != 0) {
+            ok = 0;
+        }
+    }
+    if (ok && (!wp_mlkem_ecdh_encap(mlkem, rng, rand + WP_MLKEM_ENC_RAND_LEN,
+            ct + ctEOff, ss + ssEOff))) {
+        ok = 0;
+    }
+    OPENSSL_cleanse(rand, sizeof(rand));
+    if (!ok) {
+        OPENSSL_cleanse(ss, wp_mlkem_get_ss_len(mlkem));
+    }
+    else {
+        wp_metrics_record(WP_METRIC_MLKEM_ENCAP, mStart, 0);
+    }
+
+    return ok;
+}
+
+/**
+ * Decapsulate the classical part of a hybrid ciphertext.
+ *
+ * @param [in]  mlkem  ML-KEM key object holding private key.
+ * @param [in]  ct     Peer's ephemeral public key.
+ * @param [out] ss     Buffer to hold classical shared secret.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_mlkem_ecdh_decap(wp_MlKem* mlkem, const unsigned char* ct,
+    unsigned char* ss)
+{
+    int ok = 1;
+    int rc;
+
+    if (mlkem->data->ecdh == WP_MLKEM_ECDH_X25519) {
+        curve25519_key peer;
+        word32 len = CURVE25519_KEYSIZE;
+
+        rc = wc_curve25519_init(&peer);
+        if (rc != 0) {
+            ok = 0;
+        }
+        else {
+            rc = wp_mlkem_x25519_import_pub(&peer, ct);
+            if (rc == 0) {
+                rc = wc_curve25519_shared_secret_ex(&mlkem->ecdh.x25519, &peer,
+                    ss, &len, EC25519_LITTLE_ENDIAN);
+            }
+            if (rc != 0) {
+                ok = 0;
+            }
+            wc_curve25519_free(&peer);
+        }
+    }
+    else if (mlkem->data->ecdh == WP_MLKEM_ECDH_P256) {
+        ecc_key peer;
+
+        rc = wc_ecc_init_ex(&peer, NULL, INVALID_DEVID);
+        if (rc != 0) {
+            ok = 0;
+        }
+        else {
+            WC_RNG* rng = wp_provctx_get_rng(mlkem->provCtx);
+
+            rc = wp_mlkem_p256_import_pub(&peer, ct);
+            if ((rc == 0) && (rng == NULL)) {
+                rc = -1;
+            }
+            if (rc == 0) {
+                rc = wp_mlkem_p256_secret(&mlkem->ecdh.ecc, &peer, rng, ss);
+            }
+            if (rc != 0) {
+                ok = 0;
+            }
+            wc_ecc_free(&peer);
+        }
+    }
+
+    return ok;
+}
+
+/**
+ * Decapsulate the shared secret from the ciphertext.
+ *
+ * @param [in]  mlkem  ML-KEM key object holding private key.
+ * @param [in]  ct     Ciphertext.
+ * @param [in]  ctLen  Length of ciphertext in bytes.
+ * @param [out] ss     Buffer to hold shared secret. wp_mlkem_get_ss_len()
+ *                     bytes.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+int wp_mlkem_decap(wp_MlKem* mlkem, const unsigned char* ct, size_t ctLen,
+    unsigned char* ss)
+{
+    int ok = 1;
+    int rc;
+    size_t ctOff;
+    size_t ctEOff;
+    size_t ssOff;
+    size_t ssEOff;
+    word64 mStart = wp_metrics_start();
+
+    if ((!mlkem->hasPriv) || (ctLen != wp_mlkem_get_ct_len(mlkem))) {
+        ok = 0;
+    }
+    if (ok) {
+        wp_mlkem_layout(mlkem->data, WP_MLKEM768_CT_LEN,
+            mlkem->data->ecdhPubLen, &ctOff, &ctEOff);
+        wp_mlkem_layout(mlkem->data, WP_MLKEM_SS_LEN, mlkem->data->ecdhLen,
+            &ssOff, &ssEOff);
+        rc = wc_KyberKey_Decapsulate(&mlkem->mlkem, ss + ssOff, ct + ctOff,
+            WP_MLKEM768_CT_LEN);
+        if (rc != 0) {
+            ok = 0;
+        }
+    }
+    if (ok && (!wp_mlkem_ecdh_decap(mlkem, ct + ctEOff, ss + ssEOff))) {
+        ok = 0;
+    }
+    if (!ok) {
+        OPENSSL_cleanse(ss, wp_mlkem_get_ss_len(mlkem));
+    }
+    else {
+        wp_metrics_record(WP_METRIC_MLKEM_DECAP, mStart, 0);
+    }
+
+    return ok;
+}
+
+/*
+ * ML-KEM generation
+ */
+
+/**
+ * Create ML-KEM generation context object. Base function.
+ *
+ * @param [in] provCtx    Provider context.
+ * @param [in] selection  Parts of the key to generate.
+ * @param [in] params     Parameters to set for generation.
+ * @param [in] data       Data describing the key type.
+ * @return  New ML-KEM generation context object on success.
+ * @return  NULL on failure.
+ */
+static wp_MlKemGenCtx* wp_mlkem_gen_init(WOLFPROV_CTX* provCtx,
+    int selection, const OSSL_PARAM params[], const wp_MlKemData* data)
+{
+    wp_MlKemGenCtx* ctx = NULL;
+
+    if (wolfssl_prov_is_running() &&
+        ((selection & WP_MLKEM_POSSIBLE_SELECTIONS) != 0)) {
+        ctx = OPENSSL_zalloc(sizeof(*ctx));
+    }
+    if (ctx != NULL) {
+        int ok = 1;
+
+        ctx->provCtx = provCtx;
+        ctx->data    = data;
+        if (!wp_mlkem_gen_set_params(ctx, params)) {
+            ok = 0;
+        }
+        if (ok) {
+            ctx->selection = selection;
+        }
+
+        if (!ok) {
+            OPENSSL_free(ctx);
+            ctx = NULL;
+        }
+    }
+
+    return ctx;
+}
+
+/**
+ * Return an array of supported settable parameters for the ML-KEM gen
+ * context.
+ *
+ * @param [in] ctx      ML-KEM generation context object. Unused.
+ * @param [in] provCtx  Provider context object. Unused.
+ * @return  Array of parameters with data type.
+ */
+static const OSSL_PARAM* wp_mlkem_gen_settable_params(wp_MlKemGenCtx* ctx,
+    WOLFPROV_CTX* provCtx)
+{
+    /**
+     * Supported settable parameters for ML-KEM generation context.
+     */
+    static OSSL_PARAM wp_mlkem_gen_settable[] = {
+        OSSL_PARAM_utf8_string(OSSL_PKEY_PARAM_GROUP_NAME, NULL, 0),
+        OSSL_PARAM_END
+    };
+    (void)ctx;
+    (void)provCtx;
+    return wp_mlkem_gen_settable;
+}
+
+/**
+ * Sets the parameters into the ML-KEM generation context object.
+ *
+ * TLS sets the group name which must be the name of the key type.
+ *
+ * @param [in, out] ctx     ML-KEM generation context object.
+ * @param [in]      params  Array of parameters and values.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_mlkem_gen_set_params(wp_MlKemGenCtx* ctx,
+    const OSSL_PARAM params[])
+{
+    int ok = 1;
+    const char* name = NULL;
+
+    if (!wp_params_get_utf8_string_ptr(params, OSSL_PKEY_PARAM_GROUP_NAME,
+            &name)) {
+        ok = 0;
+    }
+    if (ok && (name != NULL) && (strcasecmp(name, ctx->data->name) != 0)) {
+        ok = 0;
+    }
+
+    return ok;
+}
+
+/**
+ * Create an ML-KEM key object and optionally generate a key pair.
+ *
+ * For hybrids, the random for both halves is drawn in one call.
+ *
+ * @param [in] provCtx  Provider context.
+ * @param [in] data     Data describing the key type.
+ * @param [in] keyPair  Whether to generate a key pair.
+ * @return  NULL on failure.
+ * @return  ML-KEM key object on success.
+ */
+static wp_MlKem* wp_mlkem_gen_key(WOLFPROV_CTX* provCtx,
+    const wp_MlKemData* data, int keyPair)
+{
+    wp_MlKem* mlkem;
+
+    mlkem = wp_mlkem_new(provCtx, data);
+    if ((mlkem != NULL) && keyPair) {
+        int ok = 1;
+        int rc;
+        WC_RNG* rng = wp_provctx_get_rng(provCtx);
+        byte rand[WP_MLKEM_MAX_RAND_LEN];
+        size_t randLen = WP_MLKEM_GEN_RAND_LEN;
+
+        if (data->ecdh == WP_MLKEM_ECDH_X25519) {
+            randLen += CURVE25519_KEYSIZE;
+        }
+        if (rng == NULL) {
+            ok = 0;
+        }
+        if (ok) {
+            rc = wc_RNG_GenerateBlock(rng, rand, (word32)randLen);
+            if (rc != 0) {
+                ok = 0;
+            }
+        }
+        if (ok) {
+            rc = wc_KyberKey_MakeKeyWithRandom(&mlkem->mlkem, rand,
+                WP_MLKEM_GEN_RAND_LEN);
+            if (rc != 0) {
+                ok = 0;
+            }
+        }
+        if (ok && (data->ecdh == WP_MLKEM_ECDH_X25519)) {
+            rc = wp_mlkem_x25519_make_key(&mlkem->ecdh.x25519,
+                rand + WP_MLKEM_GEN_RAND_LEN);
+            if (rc != 0) {
+                ok = 0;
+            }
+        }
+        else if (ok && (data->ecdh == WP_MLKEM_ECDH_P256)) {
+            wp_provctx_ecc_fp_use(provCtx);
+            rc = wc_ecc_make_key_ex(rng, WP_P256_LEN, &mlkem->ecdh.ecc,
+                ECC_SECP256R1);
+            if (rc != 0) {
+                ok = 0;
+            }
+        }
+        OPENSSL_cleanse(rand, sizeof(rand));
+
+        if (ok) {
+            mlkem->hasPub = 1;
+            mlkem->hasPriv = 1;
+        }
+        else {
+            wp_mlkem_free(mlkem);
+            mlkem = NULL;
+        }
+    }
+
+    return mlkem;
+}
+
+/**
+ * Generate an ML-KEM key pair for the key pool.
+ *
+ * @param [in] provCtx  Provider context.
+ * @param [in] arg      Data describing the key type.
+ * @return  NULL on failure.
+ * @return  ML-KEM key object on success.
+ */
+static void* wp_mlkem_pool_gen(WOLFPROV_CTX* provCtx, const void* arg)
+{
+    return wp_mlkem_gen_key(provCtx, (const wp_MlKemData*)arg, 1);
+}
+
+/**
+ * Dispose of an ML-KEM key object from the key pool.
+ *
+ * @param [in, out] key  ML-KEM key object.
+ */
+static void wp_mlkem_pool_free(void* key)
+{
+    wp_mlkem_free((wp_MlKem*)key);
+}
+
+/**
+ * Generate ML-KEM key pair using wolfSSL.
+ *
+ * Takes a pre-generated key pair from the key pool when available.
+ *
+ * @param [in, out] ctx    ML-KEM generation context object.
+ * @param [in]      cb     Progress callback. Unused.
+ * @param [in]      cbArg  Argument to pass to callback. Unused.
+ * @return  NULL on failure.
+ * @return  ML-KEM key object on success.
+ */
+static wp_MlKem* wp_mlkem_gen(wp_MlKemGenCtx* ctx, OSSL_CALLBACK* osslcb,
+    void* cbarg)
+{
+    wp_MlKem* mlkem = NULL;
+    int keyPair = (ctx->selection & OSSL_KEYMGMT_SELECT_KEYPAIR) != 0;
+    word64 mStart = wp_metrics_start();
+
+    (void)osslcb;
+    (void)cbarg;
+
+    if (keyPair) {
+        mlkem = (wp_MlKem*)wp_key_pool_get(ctx->provCtx, ctx->data->poolId,
+            wp_mlkem_pool_gen, wp_mlkem_pool_free, ctx->data);
+    }
+    if (mlkem == NULL) {
+        mlkem = wp_mlkem_gen_key(ctx->provCtx, ctx->data, keyPair);
+    }
+    if ((mlkem != NULL) && keyPair) {
+        wp_metrics_record(WP_METRIC_MLKEM_KEYGEN, mStart, 0);
+    }
+
+    return mlkem;
+}
+
+/**
+ * Dispose of the ML-KEM generation context object.
+ *
+ * @param [in, out] ctx  ML-KEM generation context object.
+ */
+static void wp_mlkem_gen_cleanup(wp_MlKemGenCtx* ctx)
+{
+    OPENSSL_free(ctx);
+}
+
+/*
+ * Dispatch tables
+ */
+
+/** Declares an ML-KEM key management dispatch table. */
+#define IMPLEMENT_MLKEM_KEYMGMT_DISPATCH(alg)                                  \
+const OSSL_DISPATCH wp_##alg##_keymgmt_functions[] = {                         \
+    { OSSL_FUNC_KEYMGMT_NEW,         (DFUNC)wp_##alg##_new                  }, \
+    { OSSL_FUNC_KEYMGMT_FREE,        (DFUNC)wp_mlkem_free                   }, \
+    { OSSL_FUNC_KEYMGMT_DUP,         (DFUNC)wp_mlkem_dup                    }, \
+    { OSSL_FUNC_KEYMGMT_GEN_INIT,    (DFUNC)wp_##alg##_gen_init             }, \
+    { OSSL_FUNC_KEYMGMT_GEN_SET_PARAMS,                                        \
+                                     (DFUNC)wp_mlkem_gen_set_params         }, \
+    { OSSL_FUNC_KEYMGMT_GEN_SETTABLE_PARAMS,                                   \
+                                     (DFUNC)wp_mlkem_gen_settable_params    }, \
+    { OSSL_FUNC_KEYMGMT_GEN,         (DFUNC)wp_mlkem_gen                    }, \
+    { OSSL_FUNC_KEYMGMT_GEN_CLEANUP, (DFUNC)wp_mlkem_gen_cleanup            }, \
+    { OSSL_FUNC_KEYMGMT_LOAD,        (DFUNC)wp_mlkem_load                   }, \
+    { OSSL_FUNC_KEYMGMT_GET_PARAMS,  (DFUNC)wp_mlkem_get_params             }, \
+    { OSSL_FUNC_KEYMGMT_GETTABLE_PARAMS,                                       \
+                                     (DFUNC)wp_mlkem_gettable_params        }, \
+    { OSSL_FUNC_KEYMGMT_SET_PARAMS,  (DFUNC)wp_mlkem_set_params             }, \
+    { OSSL_FUNC_KEYMGMT_SETTABLE_PARAMS,                                       \
+                                     (DFUNC)wp_mlkem_settable_params        }, \
+    { OSSL_FUNC_KEYMGMT_HAS,         (DFUNC)wp_mlkem_has                    }, \
+    { OSSL_FUNC_KEYMGMT_MATCH,       (DFUNC)wp_mlkem_match                  }, \
+    { OSSL_FUNC_KEYMGMT_VALIDATE,    (DFUNC)wp_mlkem_validate               }, \
+    { OSSL_FUNC_KEYMGMT_IMPORT,      (DFUNC)wp_mlkem_import                 }, \
+    { OSSL_FUNC_KEYMGMT_IMPORT_TYPES,                                          \
+                                     (DFUNC)wp_mlkem_key_types              }, \
+    { OSSL_FUNC_KEYMGMT_EXPORT,      (DFUNC)wp_mlkem_export                 }, \
+    { OSSL_FUNC_KEYMGMT_EXPORT_TYPES,                                          \
+                                     (DFUNC)wp_mlkem_key_types              }, \
+    { OSSL_FUNC_KEYMGMT_QUERY_OPERATION_NAME,                                  \
+                                     (DFUNC)wp_##alg##_query_operation_name }, \
+    { 0, NULL }                                                                \
+};
+
+/** Declares the functions of an ML-KEM key type. */
+#define IMPLEMENT_MLKEM_KEY_TYPE(alg, data)                                    \
+static wp_MlKem* wp_##alg##_new(WOLFPROV_CTX* provCtx)                         \
+{                                                                              \
+    return wp_mlkem_new(provCtx, &data);                                       \
+}                                                                              \
+static wp_MlKemGenCtx* wp_##alg##_gen_init(WOLFPROV_CTX* provCtx,              \
+    int selection, const OSSL_PARAM params[])                                  \
+{                                                                              \
+    return wp_mlkem_gen_init(provCtx, selection, params, &data);               \
+}                                                                              \
+static const char* wp_##alg##_query_operation_name(int op)                     \
+{                                                                              \
+    (void)op;                                                                  \
+    return data.name;                                                          \
+}                                                                              \
+IMPLEMENT_MLKEM_KEYMGMT_DISPATCH(alg)
+
+/*
+ * ML-KEM-768
+ */
+
+/** ML-KEM-768 key data. */
+static const wp_MlKemData mlkem768Data = {
+    WP_KEY_TYPE_MLKEM768,
+    "ML-KEM-768",
+    WP_MLKEM_ECDH_NONE,
+    0,
+    0,
+    1,
+    192,
+    WP_KEY_POOL_MLKEM768,
+};
+
+/** Dispatch table for ML-KEM-768 key management. */
+IMPLEMENT_MLKEM_KEY_TYPE(mlkem768, mlkem768Data)
+
+/*
+ * X25519MLKEM768
+ */
+
+/** X25519MLKEM768 key data - ML-KEM part first. */
+static const wp_MlKemData x25519mlkem768Data = {
+    WP_KEY_TYPE_X25519MLKEM768,
+    "X25519MLKEM768",
+    WP_MLKEM_ECDH_X25519,
+    CURVE25519_KEYSIZE,
+    CURVE25519_KEYSIZE,
+    1,
+    192,
+    WP_KEY_POOL_X25519MLKEM768,
+};
+
+/** Dispatch table for X25519MLKEM768 key management. */
+IMPLEMENT_MLKEM_KEY_TYPE(x25519mlkem768, x25519mlkem768Data)
+
+/*
+ * SecP256r1MLKEM768
+ */
+
+/** SecP256r1MLKEM768 key data - ECDH part first. */
+static const wp_MlKemData p256mlkem768Data = {
+    WP_KEY_TYPE_P256MLKEM768,
+    "SecP256r1MLKEM768",
+    WP_MLKEM_ECDH_P256,
+    WP_P256_PUB_LEN,
+    WP_P256_LEN,
+    0,
+    192,
+    WP_KEY_POOL_P256MLKEM768,
+};
+
+/** Dispatch table for SecP256r1MLKEM768 key management. */
+IMPLEMENT_MLKEM_KEY_TYPE(p256mlkem768, p256mlkem768Data)
+
+#endif /* WOLFSSL_HAVE_MLKEM || WOLFSSL_HAVE_KYBER */
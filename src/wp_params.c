@@ -25,6 +25,65 @@
 #include "wolfprovider/wp_params.h"
 
 
+#if defined(__GNUC__) || defined(__clang__)
+    /** Reverse the bytes of a 64-bit word. */
+    #define WP_BSWAP64(a)       __builtin_bswap64(a)
+#else
+    /** Reverse the bytes of a 64-bit word. */
+    #define WP_BSWAP64(a)                                                      \
+        ((((a) & 0x00000000000000ffULL) << 56) |                               \
+         (((a) & 0x000000000000ff00ULL) << 40) |                               \
+         (((a) & 0x0000000000ff0000ULL) << 24) |                               \
+         (((a) & 0x00000000ff000000ULL) <<  8) |                               \
+         (((a) & 0x000000ff00000000ULL) >>  8) |                               \
+         (((a) & 0x0000ff0000000000ULL) >> 24) |                               \
+         (((a) & 0x00ff000000000000ULL) >> 40) |                               \
+         (((a) & 0xff00000000000000ULL) >> 56))
+#endif
+
+/**
+ * Reverse the order of bytes - converts between big and little endian.
+ *
+ * Eight bytes are taken from each end at a time. Both ends are read before
+ * being written so the output may be the same buffer as the input.
+ *
+ * @param [out] out  Buffer to hold reversed bytes.
+ * @param [in]  in   Bytes to reverse.
+ * @param [in]  len  Number of bytes.
+ */
+void wp_bytes_reverse(unsigned char* out, const unsigned char* in, size_t len)
+{
+    size_t i = 0;
+    size_t j = len;
+
+    while (j - i >= 2 * sizeof(word64)) {
+        word64 a;
+        word64 b;
+
+        XMEMCPY(&a, in + i, sizeof(a));
+        XMEMCPY(&b, in + j - sizeof(b), sizeof(b));
+        a = WP_BSWAP64(a);
+        b = WP_BSWAP64(b);
+        XMEMCPY(out + i, &b, sizeof(b));
+        XMEMCPY(out + j - sizeof(a), &a, sizeof(a));
+        i += sizeof(word64);
+        j -= sizeof(word64);
+    }
+    while (j - i >= 2) {
+        unsigned char a = in[i];
+        unsigned char b = in[j - 1];
+
+        out[i] = b;
+        out[j - 1] = a;
+        i++;
+        j--;
+    }
+    if (j - i == 1) {
+        /* Middle byte stays in place. */
+        out[i] = in[i];
+    }
+}
+
 /**
  * Read little-endian array of bytes representing a large number.
  *
@@ -39,13 +98,10 @@ int wp_mp_read_unsigned_bin_le(mp_int* mp, const unsigned char* data,
 {
     int ok = 1;
     unsigned char rdata[1024];
-    size_t i;
     int rc;
 
     /* Make big-endian. */
-    for (i = 0; i < len; i++) {
-        rdata[i] = data[len - 1 - i];
-    }
+    wp_bytes_reverse(rdata, data, len);
 
     /* Read big-endian data in. */
     rc = mp_read_unsigned_bin(mp, rdata, len);
@@ -69,7 +125,6 @@ int wp_mp_to_unsigned_bin_le(mp_int* mp, unsigned char* data, size_t len)
 {
     int ok = 1;
     int rc;
-    size_t i;
 
     rc = mp_to_unsigned_bin(mp, data);
     if (rc != 0) {
@@ -77,12 +132,10 @@ int wp_mp_to_unsigned_bin_le(mp_int* mp, unsigned char* data, size_t len)
     }
 #ifdef LITTLE_ENDIAN_ORDER
     if (ok) {
-        for (i = 0; i < len / 2; i++) {
-            unsigned char t = data[i];
-            data[i] = data[len - 1 - i];
-            data[len - 1 - i] = t;
-        }
+        wp_bytes_reverse(data, data, len);
     }
+#else
+    (void)len;
 #endif
 
     return ok;
@@ -164,6 +217,28 @@ int wp_param_set_mp(OSSL_PARAM* p, const char* key, mp_int* mp,
 
     return ok;
 }
+/**
+ * Set a multi-precision number already encoded in an array into parameters.
+ *
+ * The array holds the number encoded by wp_param_set_mp() and the parameter
+ * refers to it - the number is not converted again.
+ *
+ * @param [in, out] p     Parameter element.
+ * @param [in]      key   Key for parameter.
+ * @param [in]      mp    Multi-precision integer.
+ * @param [in]      data  Array holding encoding.
+ * @param [in, out] idx   On in, index into array of encoding.
+ *                        On out, index after encoding.
+ */
+void wp_param_set_mp_ptr(OSSL_PARAM* p, const char* key, mp_int* mp,
+    unsigned char* data, size_t* idx)
+{
+    p->key = key;
+    p->data_type = OSSL_PARAM_UNSIGNED_INTEGER;
+    p->return_size = p->data_size = mp_unsigned_bin_size(mp);
+    p->data = data + *idx;
+    *idx += p->data_size;
+}
 /**
  * Set a multi-precision buffer into parameters as an unsigned integer encoding.
  *
@@ -178,8 +253,6 @@ int wp_param_set_mp(OSSL_PARAM* p, const char* key, mp_int* mp,
 void wp_param_set_mp_buf(OSSL_PARAM* p, const char* key, unsigned char* num,
     size_t nLen, unsigned char* data, size_t* idx)
 {
-    size_t i;
-
     p->key = key;
     p->data_type = OSSL_PARAM_UNSIGNED_INTEGER;
     p->data_size = nLen;
@@ -187,12 +260,47 @@ void wp_param_set_mp_buf(OSSL_PARAM* p, const char* key, unsigned char* num,
     *idx += p->data_size;
     data = p->data;
 #ifdef LITTLE_ENDIAN_ORDER
-    for (i = 0; i < nLen; i++) {
-        data[i] = num[nLen - 1 - i];
-    }
+    wp_bytes_reverse(data, num, nLen);
+#else
+    XMEMCPY(data, num, nLen);
 #endif
 }
 
+/**
+ * Find the parameters with the given keys in one pass over the array.
+ *
+ * OSSL_PARAM_locate_const() compares every key in the array on each call.
+ * Setters that look for many keys instead index the array once.
+ * A parameter is only string compared when its first character matches.
+ * The first parameter with a key is found, as with OSSL_PARAM_locate_const().
+ *
+ * The found parameter can be passed in place of the array to the
+ * wp_params_get_*() functions as its key matches immediately.
+ *
+ * @param [in]  params  Array of parameters. May be NULL.
+ * @param [in]  keys    Array of keys to look for.
+ * @param [in]  cnt     Number of keys.
+ * @param [out] found   Parameter for each key or NULL when not in array.
+ */
+void wp_params_index(const OSSL_PARAM* params, const char* const* keys,
+    size_t cnt, const OSSL_PARAM** found)
+{
+    size_t i;
+
+    for (i = 0; i < cnt; i++) {
+        found[i] = NULL;
+    }
+    for (; (params != NULL) && (params->key != NULL); params++) {
+        for (i = 0; i < cnt; i++) {
+            if ((found[i] == NULL) && (keys[i][0] == params->key[0]) &&
+                    (XSTRCMP(keys[i], params->key) == 0)) {
+                found[i] = params;
+                break;
+            }
+        }
+    }
+}
+
 /**
  * Get a digest name from the parameters.
  *
@@ -341,15 +449,9 @@ int wp_params_get_bn_be(const OSSL_PARAM* params, const char* key,
         }
     }
     if ((p != NULL) && ok) {
+        *len = p->data_size;
 #ifdef LITTLE_ENDIAN_ORDER
-        size_t i;
-        unsigned char* a = *data;
-        unsigned char* b = (unsigned char*)p->data;
-        size_t l = *len = p->data_size;
-
-        for (i = 0; i < l; i++) {
-            a[i] = b[l - 1 - i];
-        }
+        wp_bytes_reverse(*data, (unsigned char*)p->data, p->data_size);
 #else
         XMEMCPY(*data, p->data, p->data_size);
 #endif
@@ -611,12 +713,7 @@ int wp_params_set_octet_string_be(OSSL_PARAM params[], const char* key,
     }
     if ((p != NULL) && ok) {
 #ifdef LITTLE_ENDIAN_ORDER
-        size_t i;
-        unsigned char* pData = (unsigned char*)p->data;
-
-        for (i = 0; i < len; i++) {
-            pData[i] = data[len - 1 - i];
-        }
+        wp_bytes_reverse((unsigned char*)p->data, data, len);
 #else
         XMEMCPY(p->data, data, len);
 #endif
@@ -38,6 +38,10 @@
     OSSL_PARAM_octet_string(OSSL_KDF_PARAM_SALT, NULL, 0),       \
     OSSL_PARAM_uint64(OSSL_KDF_PARAM_ITER, NULL)
 
+#ifndef WP_PBKDF2_MAX_THREADS
+/** Maximum number of threads to compute PBKDF2 output blocks on. */
+#define WP_PBKDF2_MAX_THREADS    8
+#endif
 
 /**
  * The PBKDF2 context structure.
@@ -66,6 +70,8 @@ typedef struct wp_Pbkdf2Ctx {
     int pkcs5;
     /** PKCS12 key usage byte used in derivation. */
     int keyUse;
+    /** Number of threads to compute PBKDF2 output blocks on. */
+    unsigned int threads;
 } wp_Pbkdf2Ctx;
 
 /**
@@ -225,6 +231,402 @@ static const OSSL_PARAM* wp_kdf_pbkdf2_gettable_ctx_params(wp_Pbkdf2Ctx* ctx,
 static int wp_kdf_pbkdf2_set_ctx_params(wp_Pbkdf2Ctx* ctx,
     const OSSL_PARAM params[]);
 
+#ifndef WP_SINGLE_THREADED
+/**
+ * Job of computing a share of the PBKDF2 output blocks.
+ */
+typedef struct wp_Pbkdf2Job {
+    /** PBKDF2 context object. Read only. */
+    wp_Pbkdf2Ctx* ctx;
+    /** Buffer to hold derived key. */
+    unsigned char* key;
+    /** Size of derived key in bytes. */
+    size_t keyLen;
+    /** Index of first block to compute. */
+    size_t first;
+    /** Number of blocks between blocks to compute. */
+    size_t step;
+    /** Result of job: 1 on success and 0 on failure. */
+    int ok;
+} wp_Pbkdf2Job;
+
+/**
+ * HMAC keyed with the password as the hash states after each pad.
+ */
+typedef struct wp_Pbkdf2Hmac {
+    /** Hash state after password XORed with inner pad. */
+    wc_HashAlg inner;
+    /** Hash state after password XORed with outer pad. */
+    wc_HashAlg outer;
+    /** Hash object to calculate on. Copy of inner or outer hash state. */
+    wc_HashAlg hash;
+} wp_Pbkdf2Hmac;
+
+/**
+ * Copies the underlying hash algorithm object.
+ *
+ * @param [in]  src       Hash object to copy.
+ * @param [out] dst       Hash object to copy into.
+ * @param [in]  hashType  Type of hash algorithm.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_hash_copy(wc_HashAlg* src, wc_HashAlg* dst,
+    enum wc_HashType hashType)
+{
+    int ok = 1;
+    int rc = 0;
+
+    switch (hashType) {
+    case WC_HASH_TYPE_MD5:
+        rc = wc_Md5Copy(&src->md5, &dst->md5);
+        break;
+    case WC_HASH_TYPE_SHA:
+        rc = wc_ShaCopy(&src->sha, &dst->sha);
+        break;
+    case WC_HASH_TYPE_SHA224:
+        rc = wc_Sha224Copy(&src->sha224, &dst->sha224);
+        break;
+    case WC_HASH_TYPE_SHA256:
+        rc = wc_Sha256Copy(&src->sha256, &dst->sha256);
+        break;
+    case WC_HASH_TYPE_SHA384:
+        rc = wc_Sha384Copy(&src->sha384, &dst->sha384);
+        break;
+    case WC_HASH_TYPE_SHA512:
+        rc = wc_Sha512Copy(&src->sha512, &dst->sha512);
+        break;
+    case WC_HASH_TYPE_SHA512_224:
+        rc = wc_Sha512_224Copy(&src->sha512, &dst->sha512);
+        break;
+    case WC_HASH_TYPE_SHA512_256:
+        rc = wc_Sha512_256Copy(&src->sha512, &dst->sha512);
+        break;
+    case WC_HASH_TYPE_SHA3_224:
+        rc = wc_Sha3_224_Copy(&src->sha3, &dst->sha3);
+        break;
+    case WC_HASH_TYPE_SHA3_256:
+        rc = wc_Sha3_256_Copy(&src->sha3, &dst->sha3);
+        break;
+    case WC_HASH_TYPE_SHA3_384:
+        rc = wc_Sha3_384_Copy(&src->sha3, &dst->sha3);
+        break;
+    case WC_HASH_TYPE_SHA3_512:
+        rc = wc_Sha3_512_Copy(&src->sha3, &dst->sha3);
+        break;
+    case WC_HASH_TYPE_NONE:
+    case WC_HASH_TYPE_MD2:
+    case WC_HASH_TYPE_MD4:
+    case WC_HASH_TYPE_MD5_SHA:
+    case WC_HASH_TYPE_BLAKE2B:
+    case WC_HASH_TYPE_BLAKE2S:
+    case WC_HASH_TYPE_SHAKE128:
+    case WC_HASH_TYPE_SHAKE256:
+    default:
+        ok = 0;
+        break;
+    }
+    if (rc != 0) {
+        ok = 0;
+    }
+
+    return ok;
+}
+
+/**
+ * Key the HMAC with the password.
+ *
+ * Hashes the padded password XORed with the inner and outer pads into the
+ * inner and outer hash states. See RFC 2104.
+ *
+ * @param [in]  ctx   PBKDF2 context object.
+ * @param [out] hmac  HMAC to key.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_pbkdf2_hmac_init(wp_Pbkdf2Ctx* ctx, wp_Pbkdf2Hmac* hmac)
+{
+    int ok = 1;
+    int rc;
+    unsigned char pad[WC_MAX_BLOCK_SIZE];
+    int blockSz = wc_HashGetBlockSize(ctx->mdType);
+    int innerInit = 0;
+    int i;
+
+    if ((blockSz <= 0) || (blockSz > WC_MAX_BLOCK_SIZE)) {
+        ok = 0;
+    }
+    if (ok) {
+        XMEMSET(pad, 0, sizeof(pad));
+        if (ctx->passwordSz > (size_t)blockSz) {
+            /* Password longer than a block is replaced with its digest. */
+            rc = wc_Hash(ctx->mdType, ctx->password, (word32)ctx->passwordSz,
+                pad, (word32)ctx->mdLen);
+            if (rc != 0) {
+                ok = 0;
+            }
+        }
+        else {
+            XMEMCPY(pad, ctx->password, ctx->passwordSz);
+        }
+    }
+    if (ok) {
+        rc = wc_HashInit_ex(&hmac->inner, ctx->mdType, NULL,
+            ctx->provCtx->devId);
+        if (rc != 0) {
+            ok = 0;
+        }
+        else {
+            innerInit = 1;
+        }
+    }
+    if (ok) {
+        for (i = 0; i < blockSz; i++) {
+            pad[i] ^= 0x36;
+        }
+        rc = wc_HashUpdate(&hmac->inner, ctx->mdType, pad, (word32)blockSz);
+        if (rc != 0) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        rc = wc_HashInit_ex(&hmac->outer, ctx->mdType, NULL,
+            ctx->provCtx->devId);
+        if (rc != 0) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        for (i = 0; i < blockSz; i++) {
+            pad[i] ^= 0x36 ^ 0x5c;
+        }
+        rc = wc_HashUpdate(&hmac->outer, ctx->mdType, pad, (word32)blockSz);
+        if (rc != 0) {
+            wc_HashFree(&hmac->outer, ctx->mdType);
+            ok = 0;
+        }
+    }
+    if ((!ok) && innerInit) {
+        wc_HashFree(&hmac->inner, ctx->mdType);
+    }
+
+    OPENSSL_cleanse(pad, sizeof(pad));
+    return ok;
+}
+
+/**
+ * Dispose of the hash states of a keyed HMAC.
+ *
+ * @param [in]      ctx   PBKDF2 context object.
+ * @param [in, out] hmac  HMAC keyed with wp_pbkdf2_hmac_init().
+ */
+static void wp_pbkdf2_hmac_free(wp_Pbkdf2Ctx* ctx, wp_Pbkdf2Hmac* hmac)
+{
+    wc_HashFree(&hmac->outer, ctx->mdType);
+    wc_HashFree(&hmac->inner, ctx->mdType);
+    OPENSSL_cleanse(hmac, sizeof(*hmac));
+}
+
+/**
+ * Calculate HMAC over two pieces of data with the keyed HMAC.
+ *
+ * Hashes start from copies of the inner and outer hash states.
+ *
+ * @param [in]      ctx    PBKDF2 context object.
+ * @param [in, out] hmac   HMAC keyed with password.
+ * @param [in]      d1     First data.
+ * @param [in]      d1Len  Length of first data in bytes.
+ * @param [in]      d2     Second data. May be NULL when d2Len is 0.
+ * @param [in]      d2Len  Length of second data in bytes.
+ * @param [out]     out    Buffer to hold HMAC output. May be d1.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_pbkdf2_hmac(wp_Pbkdf2Ctx* ctx, wp_Pbkdf2Hmac* hmac,
+    const unsigned char* d1, size_t d1Len, const unsigned char* d2,
+    size_t d2Len, unsigned char* out)
+{
+    int ok;
+    int rc;
+    unsigned char inner[WC_MAX_DIGEST_SIZE];
+
+    ok = wp_hash_copy(&hmac->inner, &hmac->hash, ctx->mdType);
+    if (ok) {
+        rc = wc_HashUpdate(&hmac->hash, ctx->mdType, d1, (word32)d1Len);
+        if ((rc == 0) && (d2Len > 0)) {
+            rc = wc_HashUpdate(&hmac->hash, ctx->mdType, d2, (word32)d2Len);
+        }
+        if (rc == 0) {
+            rc = wc_HashFinal(&hmac->hash, ctx->mdType, inner);
+        }
+        wc_HashFree(&hmac->hash, ctx->mdType);
+        if (rc != 0) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        ok = wp_hash_copy(&hmac->outer, &hmac->hash, ctx->mdType);
+    }
+    if (ok) {
+        rc = wc_HashUpdate(&hmac->hash, ctx->mdType, inner,
+            (word32)ctx->mdLen);
+        if (rc == 0) {
+            rc = wc_HashFinal(&hmac->hash, ctx->mdType, out);
+        }
+        wc_HashFree(&hmac->hash, ctx->mdType);
+        if (rc != 0) {
+            ok = 0;
+        }
+    }
+
+    OPENSSL_cleanse(inner, sizeof(inner));
+    return ok;
+}
+
+/**
+ * Compute one PBKDF2 output block.
+ *
+ * Each iteration starts from copies of the hash states of the HMAC keyed with
+ * the password.
+ *
+ * @param [in]      ctx     PBKDF2 context object.
+ * @param [in, out] hmac    HMAC keyed with password.
+ * @param [in]      blk     Index of block, starting at 0.
+ * @param [out]     out     Buffer to hold block.
+ * @param [in]      outLen  Number of bytes of block to output.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_pbkdf2_block(wp_Pbkdf2Ctx* ctx, wp_Pbkdf2Hmac* hmac,
+    size_t blk, unsigned char* out, size_t outLen)
+{
+    int ok;
+    unsigned char u[WC_MAX_DIGEST_SIZE];
+    unsigned char t[WC_MAX_DIGEST_SIZE];
+    unsigned char cnt[4];
+    uint64_t i;
+    size_t j;
+
+    cnt[0] = (unsigned char)((blk + 1) >> 24);
+    cnt[1] = (unsigned char)((blk + 1) >> 16);
+    cnt[2] = (unsigned char)((blk + 1) >>  8);
+    cnt[3] = (unsigned char)((blk + 1)      );
+
+    /* U_1 = HMAC(P, S || INT(i)) */
+    ok = wp_pbkdf2_hmac(ctx, hmac, ctx->salt, ctx->saltSz, cnt, sizeof(cnt),
+        u);
+    if (ok) {
+        XMEMCPY(t, u, ctx->mdLen);
+    }
+    /* U_j = HMAC(P, U_j-1), T = U_1 ^ ... ^ U_c */
+    for (i = 1; ok && (i < ctx->iterations); i++) {
+        ok = wp_pbkdf2_hmac(ctx, hmac, u, ctx->mdLen, NULL, 0, u);
+        for (j = 0; ok && (j < ctx->mdLen); j++) {
+            t[j] ^= u[j];
+        }
+    }
+    if (ok) {
+        XMEMCPY(out, t, outLen);
+    }
+
+    OPENSSL_cleanse(u, sizeof(u));
+    OPENSSL_cleanse(t, sizeof(t));
+    return ok;
+}
+
+/**
+ * Compute the share of PBKDF2 output blocks of a job.
+ *
+ * Keys its own HMAC so that no wolfSSL object is shared between threads.
+ *
+ * @param [in, out] arg  PBKDF2 job.
+ * @return  NULL.
+ */
+static void* wp_pbkdf2_job_run(void* arg)
+{
+    wp_Pbkdf2Job* job = (wp_Pbkdf2Job*)arg;
+    wp_Pbkdf2Ctx* ctx = job->ctx;
+    wp_Pbkdf2Hmac hmac;
+    size_t blk;
+    size_t blocks = (job->keyLen + ctx->mdLen - 1) / ctx->mdLen;
+
+    job->ok = wp_pbkdf2_hmac_init(ctx, &hmac);
+    if (job->ok) {
+        for (blk = job->first; job->ok && (blk < blocks); blk += job->step) {
+            size_t off = blk * ctx->mdLen;
+            size_t len = job->keyLen - off;
+
+            if (len > ctx->mdLen) {
+                len = ctx->mdLen;
+            }
+            job->ok = wp_pbkdf2_block(ctx, &hmac, blk, job->key + off, len);
+        }
+        wp_pbkdf2_hmac_free(ctx, &hmac);
+    }
+
+    return NULL;
+}
+
+/**
+ * Derive a key using PBKDF2 with output blocks computed on multiple threads.
+ *
+ * Each output block of PBKDF2 is an independent chain of iterations.
+ * Blocks are shared out round-robin between the calling thread and up to
+ * WP_PBKDF2_MAX_THREADS - 1 other threads.
+ *
+ * @param [in]  ctx     PBKDF2 context object.
+ * @param [out] key     Buffer to hold derived key.
+ * @param [in]  keyLen  Size of buffer in bytes.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_pbkdf2_parallel(wp_Pbkdf2Ctx* ctx, unsigned char* key,
+    size_t keyLen)
+{
+    int ok = 1;
+    wp_Pbkdf2Job job[WP_PBKDF2_MAX_THREADS];
+    pthread_t thread[WP_PBKDF2_MAX_THREADS];
+    int started[WP_PBKDF2_MAX_THREADS];
+    size_t blocks = (keyLen + ctx->mdLen - 1) / ctx->mdLen;
+    size_t num = ctx->threads;
+    size_t i;
+
+    if (num > WP_PBKDF2_MAX_THREADS) {
+        num = WP_PBKDF2_MAX_THREADS;
+    }
+    if (num > blocks) {
+        num = blocks;
+    }
+
+    for (i = 0; i < num; i++) {
+        job[i].ctx = ctx;
+        job[i].key = key;
+        job[i].keyLen = keyLen;
+        job[i].first = i;
+        job[i].step = num;
+        job[i].ok = 0;
+        started[i] = (i > 0) &&
+            (pthread_create(&thread[i], NULL, wp_pbkdf2_job_run, &job[i]) == 0);
+    }
+    /* Calling thread computes first share and any that failed to start. */
+    for (i = 0; i < num; i++) {
+        if (!started[i]) {
+            (void)wp_pbkdf2_job_run(&job[i]);
+        }
+    }
+    for (i = 0; i < num; i++) {
+        if (started[i]) {
+            pthread_join(thread[i], NULL);
+        }
+        if (!job[i].ok) {
+            ok = 0;
+        }
+    }
+
+    return ok;
+}
+#endif
+
 /**
  * Derive a key using PBKDF2.
  *
@@ -239,6 +641,7 @@ static int wp_kdf_pbkdf2_derive(wp_Pbkdf2Ctx* ctx, unsigned char* key,
     size_t keyLen, const OSSL_PARAM params[])
 {
     int ok = 1;
+    int done = 0;
 
     if (!wolfssl_prov_is_running()) {
         ok = 0;
@@ -253,12 +656,19 @@ static int wp_kdf_pbkdf2_derive(wp_Pbkdf2Ctx* ctx, unsigned char* key,
         ok = 0;
     }
 
-    if (ok) {
+#ifndef WP_SINGLE_THREADED
+    if (ok && (ctx->threads > 1) && (ctx->mdLen > 0) &&
+            (keyLen > ctx->mdLen) && (ctx->iterations > 0)) {
+        ok = wp_pbkdf2_parallel(ctx, key, keyLen);
+        done = 1;
+    }
+#endif
+    if (ok && (!done)) {
         int rc;
 
         rc = wc_PBKDF2_ex(key, ctx->password, ctx->passwordSz, ctx->salt,
             ctx->saltSz, ctx->iterations, keyLen, ctx->mdType, NULL,
-            INVALID_DEVID);
+            ctx->provCtx->devId);
         if (rc != 0) {
             ok = 0;
         }
@@ -284,6 +694,10 @@ static int wp_kdf_pbkdf2_set_ctx_params(wp_Pbkdf2Ctx* ctx,
     if (ok && !wp_params_get_int(params, OSSL_KDF_PARAM_PKCS5, &ctx->pkcs5)) {
         ok = 0;
     }
+    if (ok && !wp_params_get_uint(params, WP_KDF_PARAM_THREADS, &ctx->threads,
+            NULL)) {
+        ok = 0;
+    }
 
     return ok;
 }
@@ -302,6 +716,7 @@ static const OSSL_PARAM* wp_kdf_pbkdf2_settable_ctx_params(wp_Pbkdf2Ctx* ctx,
     static const OSSL_PARAM wp_pbkdf2_supported_settable_ctx_params[] = {
         WP_PBKDF2_BASE_SETTABLES,
         OSSL_PARAM_int(OSSL_KDF_PARAM_PKCS5, NULL),
+        OSSL_PARAM_uint(WP_KDF_PARAM_THREADS, NULL),
         OSSL_PARAM_END
     };
     (void)ctx;
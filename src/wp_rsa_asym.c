@@ -61,8 +61,6 @@ typedef struct wp_RsaAsymCtx {
 
     /** wolfProvider RSA object. */
     wp_Rsa* rsa;
-    /** wolfSSL random number generator for signing. */
-    WC_RNG rng;
 
     /** Operation being performed as an EVP define. */
     int op;
@@ -110,13 +108,6 @@ static wp_RsaAsymCtx* wp_rsaa_ctx_new(WOLFPROV_CTX* provCtx)
     if (wolfssl_prov_is_running()) {
         ctx = OPENSSL_zalloc(sizeof(*ctx));
     }
-    if (ctx != NULL) {
-        int rc = wc_InitRng(&ctx->rng);
-        if (rc != 0) {
-            OPENSSL_free(ctx);
-            ctx = NULL;
-        }
-    }
     if (ctx != NULL) {
         ctx->provCtx = provCtx;
         ctx->libCtx = provCtx->libCtx;
@@ -133,7 +124,6 @@ static wp_RsaAsymCtx* wp_rsaa_ctx_new(WOLFPROV_CTX* provCtx)
 static void wp_rsaa_ctx_free(wp_RsaAsymCtx* ctx)
 {
     if (ctx != NULL) {
-        wc_FreeRng(&ctx->rng);
         wp_rsa_free(ctx->rsa);
         OPENSSL_free(ctx->label);
         OPENSSL_free(ctx);
@@ -289,14 +279,18 @@ static int wp_rsaa_encrypt(wp_RsaAsymCtx *ctx, unsigned char *out,
     }
     else {
         int rc = 0;
+        WC_RNG* rng = wp_provctx_get_rng(ctx->provCtx);
 
         if (outSize == (size_t)-1) {
             outSize = *outLen;
         }
-        if ((ctx->padMode == RSA_PKCS1_PADDING) ||
+        if (rng == NULL) {
+            ok = 0;
+        }
+        else if ((ctx->padMode == RSA_PKCS1_PADDING) ||
             (ctx->padMode == RSA_PKCS1_WITH_TLS_PADDING)) {
             rc = wc_RsaPublicEncrypt(in, (word32)inLen, out, (word32)outSize,
-                wp_rsa_get_key(ctx->rsa), &ctx->rng);
+                wp_rsa_get_key(ctx->rsa), rng);
             if (rc < 0) {
                 ok = 0;
             }
@@ -307,7 +301,7 @@ static int wp_rsaa_encrypt(wp_RsaAsymCtx *ctx, unsigned char *out,
                 ctx->mgf = WC_MGF1SHA1;
             }
             rc = wc_RsaPublicEncrypt_ex(in, (word32)inLen, out, (word32)outSize,
-                wp_rsa_get_key(ctx->rsa), &ctx->rng, WC_RSA_OAEP_PAD,
+                wp_rsa_get_key(ctx->rsa), rng, WC_RSA_OAEP_PAD,
                 ctx->oaepHashType, ctx->mgf, ctx->label, ctx->labelLen);
             if (rc < 0) {
                 ok = 0;
@@ -381,14 +375,18 @@ static int wp_rsaa_decrypt(wp_RsaAsymCtx *ctx, unsigned char *out,
     }
     else {
         int rc = 0;
+#ifdef WC_RSA_BLINDING
+        WC_RNG* rng = wp_provctx_get_rng(ctx->provCtx);
+#endif
 
         if (outSize == (size_t)-1) {
             outSize = *outLen;
         }
 #ifdef WC_RSA_BLINDING
-        /* TODO: not thread safe */
-        rc = wc_RsaSetRNG(wp_rsa_get_key(ctx->rsa), &ctx->rng);
-        if (rc != 0) {
+        /* Calling thread's RNG - set before every private key operation.
+         * TODO: not thread safe */
+        if ((rng == NULL) || (wc_RsaSetRNG(wp_rsa_get_key(ctx->rsa),
+                rng) != 0)) {
             ok = 0;
         }
         if (!ok) {
@@ -30,6 +30,17 @@
 
 #include <wolfprovider/alg_funcs.h>
 
+#ifdef WOLF_CRYPTO_CB
+    /* Private key operations with keys of more than two primes are performed
+     * by a crypto callback registered by the provider. */
+    #define WP_RSA_MULTI_PRIME
+    #if defined(WOLFSSL_KEY_GEN) && !defined(HAVE_FIPS)
+        /* Generate keys of more than two primes. */
+        #define WP_RSA_MULTI_PRIME_GEN
+    #endif
+    #include <wolfssl/wolfcrypt/cryptocb.h>
+#endif
+
 
 /** Supported selections (key parts) in this key manager for RSA. */
 #define WP_RSA_POSSIBLE_SELECTIONS                                             \
@@ -44,7 +55,22 @@ OSSL_PARAM_BN(OSSL_PKEY_PARAM_RSA_FACTOR1, NULL, 0),                           \
 OSSL_PARAM_BN(OSSL_PKEY_PARAM_RSA_FACTOR2, NULL, 0),                           \
 OSSL_PARAM_BN(OSSL_PKEY_PARAM_RSA_EXPONENT1, NULL, 0),                         \
 OSSL_PARAM_BN(OSSL_PKEY_PARAM_RSA_EXPONENT2, NULL, 0),                         \
-OSSL_PARAM_BN(OSSL_PKEY_PARAM_RSA_COEFFICIENT1, NULL, 0)
+OSSL_PARAM_BN(OSSL_PKEY_PARAM_RSA_COEFFICIENT1, NULL, 0)                       \
+WP_RSA_MP_NUM_PARAMS
+
+#ifdef WP_RSA_MULTI_PRIME
+/** RSA number related parameters of the extra primes of a multi-prime key. */
+#define WP_RSA_MP_NUM_PARAMS                                                   \
+,                                                                              \
+OSSL_PARAM_BN(OSSL_PKEY_PARAM_RSA_FACTOR3, NULL, 0),                           \
+OSSL_PARAM_BN(OSSL_PKEY_PARAM_RSA_FACTOR4, NULL, 0),                           \
+OSSL_PARAM_BN(OSSL_PKEY_PARAM_RSA_EXPONENT3, NULL, 0),                         \
+OSSL_PARAM_BN(OSSL_PKEY_PARAM_RSA_EXPONENT4, NULL, 0),                         \
+OSSL_PARAM_BN(OSSL_PKEY_PARAM_RSA_COEFFICIENT2, NULL, 0),                      \
+OSSL_PARAM_BN(OSSL_PKEY_PARAM_RSA_COEFFICIENT3, NULL, 0)
+#else
+#define WP_RSA_MP_NUM_PARAMS
+#endif
 
 /** RSA PSS specific parameters. */
 #define WP_RSA_PSS_PARAMS                                                      \
@@ -58,6 +84,17 @@ OSSL_PARAM_BN(OSSL_PKEY_PARAM_RSA_COEFFICIENT1, NULL, 0)
 #define WP_RSA_PARAM_NUMS_CNT       8
 /** Count of public RSA numbers that are in parameters. */
 #define WP_RSA_PARAM_PUB_NUMS_CNT   2
+/** Index of first CRT number in parameters. CRT numbers are optional. */
+#define WP_RSA_PARAM_CRT_IDX        5
+
+/** Maximum number of primes in an RSA key. */
+#define WP_RSA_MAX_PRIMES           4
+/** Maximum number of primes in an RSA key beyond p and q. */
+#define WP_RSA_MAX_EXTRA_PRIMES     (WP_RSA_MAX_PRIMES - 2)
+/** wolfCrypt device id of the multi-prime RSA crypto callback. */
+#define WP_RSA_MP_DEVID             0x77704d50
+/** Maximum number of attempts at generating primes of a multi-prime key. */
+#define WP_RSA_MP_GEN_TRIES         100
 
 /** Default RSA PSS digest. */
 #define WP_RSA_PSS_DIGEST_DEF       WC_HASH_TYPE_SHA
@@ -83,6 +120,38 @@ static const char* wp_rsa_param_key[WP_RSA_PARAM_NUMS_CNT] = {
     OSSL_PKEY_PARAM_RSA_COEFFICIENT1
 };
 
+#ifdef WP_RSA_MULTI_PRIME
+/** Table of parameter keys for the extra primes. */
+static const char* wp_rsa_mp_factor_key[WP_RSA_MAX_EXTRA_PRIMES] = {
+    OSSL_PKEY_PARAM_RSA_FACTOR3, OSSL_PKEY_PARAM_RSA_FACTOR4
+};
+/** Table of parameter keys for the CRT exponents of the extra primes. */
+static const char* wp_rsa_mp_exp_key[WP_RSA_MAX_EXTRA_PRIMES] = {
+    OSSL_PKEY_PARAM_RSA_EXPONENT3, OSSL_PKEY_PARAM_RSA_EXPONENT4
+};
+/** Table of parameter keys for the CRT coefficients of the extra primes. */
+static const char* wp_rsa_mp_coeff_key[WP_RSA_MAX_EXTRA_PRIMES] = {
+    OSSL_PKEY_PARAM_RSA_COEFFICIENT2, OSSL_PKEY_PARAM_RSA_COEFFICIENT3
+};
+
+/**
+ * Primes beyond p and q of a multi-prime RSA key (RFC 8017, 3.2).
+ */
+typedef struct wp_RsaMp {
+    /** Number of extra primes. */
+    int cnt;
+    /** Extra primes: r_3, r_4. */
+    mp_int r[WP_RSA_MAX_EXTRA_PRIMES];
+    /** CRT exponents: d mod (r_i - 1). */
+    mp_int d[WP_RSA_MAX_EXTRA_PRIMES];
+    /** CRT coefficients: (r_1 * ... * r_(i-1))^-1 mod r_i. */
+    mp_int t[WP_RSA_MAX_EXTRA_PRIMES];
+    /** Products of the primes before each extra prime: r_1 * ... * r_(i-1).
+     */
+    mp_int pp[WP_RSA_MAX_EXTRA_PRIMES];
+} wp_RsaMp;
+#endif
+
 /**
  * RSA PSS parameters.
  */
@@ -105,15 +174,12 @@ typedef struct wp_RsaPssParams {
  * RSA key.
  */
 struct wp_Rsa {
-    /** wolfSSL RSA key object. */
+    /** wolfSSL RSA key object. First field so that the multi-prime crypto
+     * callback can find the RSA key object. */
     RsaKey key;
 
-#ifndef WP_SINGLE_THREADED
-    /** Mutex for reference count updating. */
-    wolfSSL_Mutex mutex;
-#endif
     /** Count of references to this object. */
-    int refCnt;
+    wp_RefCnt refCnt;
 
     /** Provider context - useful when duplicating. */
     WOLFPROV_CTX* provCtx;
@@ -126,9 +192,17 @@ struct wp_Rsa {
     unsigned int hasPub:1;
     /** Private key available. */
     unsigned int hasPriv:1;
+    /** SubjectPublicKeyInfo encoding of public key. NULL until encoded. */
+    wp_Der* spki;
+    /** Numbers of key serialized for export. NULL until exported. */
+    wp_Der* expData;
 
     /** Extra PSS parametes. */
     wp_RsaPssParams pssParams;
+#ifdef WP_RSA_MULTI_PRIME
+    /** Extra primes of a multi-prime key. NULL when key has two primes. */
+    wp_RsaMp* mp;
+#endif
 };
 
 /**
@@ -147,6 +221,8 @@ typedef struct wp_RsaGenCtx {
     size_t bits;
     /** Public exponent to generate key with. */
     size_t e;
+    /** Number of primes to generate key with. */
+    size_t primes;
 
     /** Extra PSS parameters to set. */
     wp_RsaPssParams pssParams;
@@ -170,24 +246,7 @@ static int wp_rsa_gen_set_params(wp_RsaGenCtx* ctx, const OSSL_PARAM params[]);
  */
 int wp_rsa_up_ref(wp_Rsa* rsa)
 {
-#ifndef WP_SINGLE_THREADED
-    int ok = 1;
-    int rc;
-
-    rc = wc_LockMutex(&rsa->mutex);
-    if (rc < 0) {
-        ok = 0;
-    }
-    if (ok) {
-        rsa->refCnt++;
-        wc_UnLockMutex(&rsa->mutex);
-    }
-
-    return ok;
-#else
-    rsa->refCnt++;
-    return 1;
-#endif
+    return wp_refcnt_up(&rsa->refCnt);
 }
 
 /**
@@ -294,25 +353,19 @@ static wp_Rsa* wp_rsa_base_new(WOLFPROV_CTX *provCtx, int type)
         int ok = 1;
         int rc;
 
-        rc = wc_InitRsaKey(&rsa->key, NULL);
+        rc = wc_InitRsaKey_ex(&rsa->key, NULL, provCtx->devId);
         if (rc != 0) {
             ok = 0;
         }
 
-    #ifndef SINGLE_THREADED
-        if (ok) {
-            rc = wc_InitMutex(&rsa->mutex);
-            if (rc != 0) {
-                wc_FreeRsaKey(&rsa->key);
-                ok = 0;
-            }
+        if (ok && (!wp_refcnt_init(&rsa->refCnt))) {
+            wc_FreeRsaKey(&rsa->key);
+            ok = 0;
         }
-    #endif
 
         if (ok) {
             rsa->provCtx = provCtx;
             rsa->type = type;
-            rsa->refCnt = 1;
         }
 
         if (!ok) {
@@ -324,6 +377,433 @@ static wp_Rsa* wp_rsa_base_new(WOLFPROV_CTX *provCtx, int type)
     return rsa;
 }
 
+#ifdef WP_RSA_MULTI_PRIME
+/*
+ * Multi-prime RSA
+ */
+
+/**
+ * Dispose of the extra primes of a multi-prime RSA key.
+ *
+ * @param [in, out] mp  Extra primes object. May be NULL.
+ */
+static void wp_rsa_mp_free(wp_RsaMp* mp)
+{
+    if (mp != NULL) {
+        int i;
+
+        for (i = 0; i < WP_RSA_MAX_EXTRA_PRIMES; i++) {
+            mp_forcezero(&mp->r[i]);
+            mp_forcezero(&mp->d[i]);
+            mp_forcezero(&mp->t[i]);
+            mp_forcezero(&mp->pp[i]);
+        }
+        OPENSSL_free(mp);
+    }
+}
+
+/**
+ * Create a new extra primes object.
+ *
+ * @param [in] cnt  Number of primes beyond p and q.
+ * @return  NULL on failure.
+ * @return  New extra primes object on success.
+ */
+static wp_RsaMp* wp_rsa_mp_new(int cnt)
+{
+    wp_RsaMp* mp;
+
+    mp = (wp_RsaMp*)OPENSSL_zalloc(sizeof(*mp));
+    if (mp != NULL) {
+        int ok = 1;
+        int i;
+
+        for (i = 0; ok && (i < WP_RSA_MAX_EXTRA_PRIMES); i++) {
+            if (mp_init_multi(&mp->r[i], &mp->d[i], &mp->t[i], &mp->pp[i],
+                    NULL, NULL) != MP_OKAY) {
+                ok = 0;
+            }
+        }
+        if (ok) {
+            mp->cnt = cnt;
+        }
+        else {
+            wp_rsa_mp_free(mp);
+            mp = NULL;
+        }
+    }
+
+    return mp;
+}
+
+/**
+ * Calculate the CRT numbers of the extra primes from d and the primes.
+ *
+ * Sets the device id of the wolfSSL key so that private key operations are
+ * performed by the multi-prime crypto callback.
+ *
+ * @param [in, out] rsa  RSA key object with extra primes.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_rsa_mp_setup(wp_Rsa* rsa)
+{
+    int ok = 1;
+    int rc;
+    int i;
+    wp_RsaMp* mp = rsa->mp;
+    mp_int t;
+
+    rc = mp_init(&t);
+    if (rc != MP_OKAY) {
+        ok = 0;
+    }
+    else {
+        for (i = 0; (rc == MP_OKAY) && (i < mp->cnt); i++) {
+            /* pp_i = r_1 * ... * r_(i-1) */
+            if (i == 0) {
+                rc = mp_mul(&rsa->key.p, &rsa->key.q, &mp->pp[i]);
+            }
+            else {
+                rc = mp_mul(&mp->pp[i - 1], &mp->r[i - 1], &mp->pp[i]);
+            }
+            /* t_i = pp_i^-1 mod r_i */
+            if (rc == MP_OKAY) {
+                rc = mp_mod(&mp->pp[i], &mp->r[i], &t);
+            }
+            if (rc == MP_OKAY) {
+                rc = mp_invmod(&t, &mp->r[i], &mp->t[i]);
+            }
+            /* d_i = d mod (r_i - 1) */
+            if (rc == MP_OKAY) {
+                rc = mp_sub_d(&mp->r[i], 1, &t);
+            }
+            if (rc == MP_OKAY) {
+                rc = mp_mod(&rsa->key.d, &t, &mp->d[i]);
+            }
+        }
+        if (rc != MP_OKAY) {
+            ok = 0;
+        }
+        mp_forcezero(&t);
+    }
+    if (ok) {
+        rsa->key.devId = WP_RSA_MP_DEVID;
+    }
+
+    return ok;
+}
+
+/**
+ * Duplicate the extra primes of a multi-prime RSA key.
+ *
+ * @param [in, out] dst  RSA key object to copy into.
+ * @param [in]      src  RSA key object with extra primes.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_rsa_mp_dup(wp_Rsa* dst, const wp_Rsa* src)
+{
+    int ok = 1;
+    int i;
+
+    dst->mp = wp_rsa_mp_new(src->mp->cnt);
+    if (dst->mp == NULL) {
+        ok = 0;
+    }
+    for (i = 0; ok && (i < src->mp->cnt); i++) {
+        if ((mp_copy(&src->mp->r[i], &dst->mp->r[i]) != MP_OKAY) ||
+            (mp_copy(&src->mp->d[i], &dst->mp->d[i]) != MP_OKAY) ||
+            (mp_copy(&src->mp->t[i], &dst->mp->t[i]) != MP_OKAY) ||
+            (mp_copy(&src->mp->pp[i], &dst->mp->pp[i]) != MP_OKAY)) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        dst->key.devId = WP_RSA_MP_DEVID;
+    }
+
+    return ok;
+}
+
+/**
+ * Perform the RSA private key operation with a multi-prime key.
+ *
+ * Uses CRT across all primes as in RFC 8017, 5.1.2. The input is blinded and
+ * the result is checked with the public key before being returned.
+ *
+ * @param [in]  rsa     RSA key object with extra primes.
+ * @param [in]  in      Number to exponentiate as big-endian bytes.
+ * @param [in]  inLen   Length of input in bytes.
+ * @param [out] out     Buffer to hold result. Must be key size in length.
+ * @param [in]  outLen  Length of result in bytes: size of key.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_rsa_mp_private(wp_Rsa* rsa, const byte* in, word32 inLen,
+    byte* out, word32 outLen)
+{
+    int ok = 1;
+    int rc;
+    int i;
+    RsaKey* key = &rsa->key;
+    wp_RsaMp* mp = rsa->mp;
+    WC_RNG* rng;
+    byte rnd[RSA_MAX_SIZE / 8];
+    mp_int c;
+    mp_int b;
+    mp_int m;
+    mp_int r;
+    mp_int h;
+    mp_int t;
+    mp_int mi;
+
+    rc = mp_init_multi(&c, &b, &m, &r, &h, &t);
+    if (rc == MP_OKAY) {
+        rc = mp_init(&mi);
+    }
+    if (rc == MP_OKAY) {
+        rc = mp_read_unsigned_bin(&c, in, inLen);
+    }
+    if ((rc == MP_OKAY) && (mp_cmp(&c, &key->n) != MP_LT)) {
+        rc = MP_VAL;
+    }
+
+    /* Blind: b = c * r^e mod n, r = r^-1 mod n */
+    if ((rc == MP_OKAY) && (outLen > sizeof(rnd))) {
+        rc = MP_VAL;
+    }
+    if (rc == MP_OKAY) {
+        rng = wp_provctx_get_rng(rsa->provCtx);
+        if ((rng == NULL) || (wc_RNG_GenerateBlock(rng, rnd, outLen) != 0)) {
+            rc = MP_VAL;
+        }
+    }
+    if (rc == MP_OKAY) {
+        rc = mp_read_unsigned_bin(&h, rnd, outLen);
+    }
+    if (rc == MP_OKAY) {
+        rc = mp_mod(&h, &key->n, &r);
+    }
+    if ((rc == MP_OKAY) && mp_iszero(&r)) {
+        rc = MP_VAL;
+    }
+    if (rc == MP_OKAY) {
+        rc = mp_exptmod(&r, &key->e, &key->n, &h);
+    }
+    if (rc == MP_OKAY) {
+        rc = mp_mulmod(&c, &h, &key->n, &b);
+    }
+    if (rc == MP_OKAY) {
+        rc = mp_invmod(&r, &key->n, &h);
+    }
+    if (rc == MP_OKAY) {
+        rc = mp_copy(&h, &r);
+    }
+
+    /* m_1 = b^dP mod p, m_2 = b^dQ mod q */
+    if (rc == MP_OKAY) {
+        rc = mp_mod(&b, &key->p, &h);
+    }
+    if (rc == MP_OKAY) {
+        rc = mp_exptmod(&h, &key->dP, &key->p, &m);
+    }
+    if (rc == MP_OKAY) {
+        rc = mp_mod(&b, &key->q, &h);
+    }
+    if (rc == MP_OKAY) {
+        rc = mp_exptmod(&h, &key->dQ, &key->q, &mi);
+    }
+    /* m = m_2 + q * ((m_1 - m_2) * u mod p) */
+    if (rc == MP_OKAY) {
+        rc = mp_mod(&mi, &key->p, &h);
+    }
+    if (rc == MP_OKAY) {
+        rc = mp_submod(&m, &h, &key->p, &t);
+    }
+    if (rc == MP_OKAY) {
+        rc = mp_mulmod(&t, &key->u, &key->p, &h);
+    }
+    if (rc == MP_OKAY) {
+        rc = mp_mul(&key->q, &h, &t);
+    }
+    if (rc == MP_OKAY) {
+        rc = mp_add(&t, &mi, &m);
+    }
+    /* Garner's recombination of each extra prime:
+     *   m = m + pp_i * ((b^d_i mod r_i - m) * t_i mod r_i) */
+    for (i = 0; (rc == MP_OKAY) && (i < mp->cnt); i++) {
+        rc = mp_mod(&b, &mp->r[i], &h);
+        if (rc == MP_OKAY) {
+            rc = mp_exptmod(&h, &mp->d[i], &mp->r[i], &mi);
+        }
+        if (rc == MP_OKAY) {
+            rc = mp_mod(&m, &mp->r[i], &h);
+        }
+        if (rc == MP_OKAY) {
+            rc = mp_submod(&mi, &h, &mp->r[i], &t);
+        }
+        if (rc == MP_OKAY) {
+            rc = mp_mulmod(&t, &mp->t[i], &mp->r[i], &h);
+        }
+        if (rc == MP_OKAY) {
+            rc = mp_mul(&mp->pp[i], &h, &t);
+        }
+        if (rc == MP_OKAY) {
+            rc = mp_add(&m, &t, &m);
+        }
+    }
+
+    /* Unblind and check result with public key: t = m * r^-1, t^e == c */
+    if (rc == MP_OKAY) {
+        rc = mp_mulmod(&m, &r, &key->n, &t);
+    }
+    if (rc == MP_OKAY) {
+        rc = mp_exptmod(&t, &key->e, &key->n, &h);
+    }
+    if ((rc == MP_OKAY) && (mp_cmp(&h, &c) != MP_EQ)) {
+        rc = MP_VAL;
+    }
+    if (rc == MP_OKAY) {
+        rc = mp_to_unsigned_bin_len(&t, out, (int)outLen);
+    }
+    if (rc != MP_OKAY) {
+        ok = 0;
+    }
+
+    OPENSSL_cleanse(rnd, sizeof(rnd));
+    mp_forcezero(&mi);
+    mp_forcezero(&t);
+    mp_forcezero(&h);
+    mp_forcezero(&r);
+    mp_forcezero(&m);
+    mp_forcezero(&b);
+    mp_forcezero(&c);
+    return ok;
+}
+
+/**
+ * wolfCrypt crypto callback performing private key operations of multi-prime
+ * RSA keys.
+ *
+ * All other operations, including padding, are left to wolfCrypt.
+ *
+ * @param [in]      devId  Device id. Unused.
+ * @param [in, out] info   Information about operation to perform.
+ * @param [in]      ctx    Callback context. Unused.
+ * @return  0 on success.
+ * @return  CRYPTOCB_UNAVAILABLE when operation not performed by callback.
+ * @return  Other negative value on failure.
+ */
+static int wp_rsa_mp_crypto_cb(int devId, wc_CryptoInfo* info, void* ctx)
+{
+    int ret = CRYPTOCB_UNAVAILABLE;
+
+    (void)devId;
+    (void)ctx;
+
+    if ((info->algo_type == WC_ALGO_TYPE_PK) &&
+        (info->pk.type == WC_PK_TYPE_RSA) &&
+        ((info->pk.rsa.type == RSA_PRIVATE_ENCRYPT) ||
+         (info->pk.rsa.type == RSA_PRIVATE_DECRYPT))) {
+        /* wolfSSL RSA key is the first field of the RSA key object. */
+        wp_Rsa* rsa = (wp_Rsa*)info->pk.rsa.key;
+        word32 keyLen = (word32)mp_unsigned_bin_size(&rsa->key.n);
+
+        if (rsa->mp == NULL) {
+            /* Two prime key - let wolfCrypt perform operation. */
+        }
+        else if (*info->pk.rsa.outLen < keyLen) {
+            ret = RSA_BUFFER_E;
+        }
+        else if (!wp_rsa_mp_private(rsa, info->pk.rsa.in, info->pk.rsa.inLen,
+                info->pk.rsa.out, keyLen)) {
+            ret = MP_EXPTMOD_E;
+        }
+        else {
+            *info->pk.rsa.outLen = keyLen;
+            ret = 0;
+        }
+    }
+
+    return ret;
+}
+
+/** Number of provider contexts using the multi-prime crypto callback. */
+static int wp_rsa_mp_users = 0;
+#ifndef WP_SINGLE_THREADED
+/** Protects users count and registration of the crypto callback. */
+static pthread_mutex_t wp_rsa_mp_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+#endif /* WP_RSA_MULTI_PRIME */
+
+/**
+ * Register the multi-prime RSA crypto callback with wolfCrypt.
+ *
+ * Called when a provider context is created. Registered once for all provider
+ * contexts.
+ *
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+int wp_rsa_mp_init(void)
+{
+    int ok = 1;
+
+#ifdef WP_RSA_MULTI_PRIME
+#ifndef WP_SINGLE_THREADED
+    if (pthread_mutex_lock(&wp_rsa_mp_mutex) != 0) {
+        ok = 0;
+    }
+    else
+#endif
+    {
+        if (wp_rsa_mp_users == 0) {
+            /* Device table is initialized by wolfCrypt. */
+            if (wolfCrypt_Init() != 0) {
+                ok = 0;
+            }
+            else if (wc_CryptoCb_RegisterDevice(WP_RSA_MP_DEVID,
+                    wp_rsa_mp_crypto_cb, NULL) != 0) {
+                wolfCrypt_Cleanup();
+                ok = 0;
+            }
+        }
+        if (ok) {
+            wp_rsa_mp_users++;
+        }
+#ifndef WP_SINGLE_THREADED
+        pthread_mutex_unlock(&wp_rsa_mp_mutex);
+#endif
+    }
+#endif
+
+    return ok;
+}
+
+/**
+ * Unregister the multi-prime RSA crypto callback when no longer used.
+ *
+ * Called when a provider context is disposed of.
+ */
+void wp_rsa_mp_cleanup(void)
+{
+#ifdef WP_RSA_MULTI_PRIME
+#ifndef WP_SINGLE_THREADED
+    if (pthread_mutex_lock(&wp_rsa_mp_mutex) == 0)
+#endif
+    {
+        if ((wp_rsa_mp_users > 0) && (--wp_rsa_mp_users == 0)) {
+            wc_CryptoCb_UnRegisterDevice(WP_RSA_MP_DEVID);
+            wolfCrypt_Cleanup();
+        }
+#ifndef WP_SINGLE_THREADED
+        pthread_mutex_unlock(&wp_rsa_mp_mutex);
+#endif
+    }
+#endif
+}
+
 /**
  * Dispose of RSA key object.
  *
@@ -332,23 +812,15 @@ static wp_Rsa* wp_rsa_base_new(WOLFPROV_CTX *provCtx, int type)
 void wp_rsa_free(wp_Rsa* rsa)
 {
     if (rsa != NULL) {
-        int cnt;
-    #ifndef WP_SINGLE_THREADED
-        int rc;
-
-        rc = wc_LockMutex(&rsa->mutex);
-        cnt = --rsa->refCnt;
-        if (rc == 0) {
-            wc_UnLockMutex(&rsa->mutex);
-        }
-    #else
-        cnt = --rsa->refCnt;
-    #endif
+        int cnt = wp_refcnt_down(&rsa->refCnt);
 
         if (cnt == 0) {
-    #ifndef WP_SINGLE_THREADED
-            wc_FreeMutex(&rsa->mutex);
-    #endif
+            wp_refcnt_free(&rsa->refCnt);
+            wp_der_free(&rsa->spki);
+            wp_der_free(&rsa->expData);
+#ifdef WP_RSA_MULTI_PRIME
+            wp_rsa_mp_free(rsa->mp);
+#endif
             wc_FreeRsaKey(&rsa->key);
             OPENSSL_free(rsa);
         }
@@ -395,6 +867,11 @@ static wp_Rsa* wp_rsa_dup(const wp_Rsa *src, int selection)
                 break;
             }
         }
+#ifdef WP_RSA_MULTI_PRIME
+        if (ok && copyPriv && (src->mp != NULL) && (!wp_rsa_mp_dup(dst, src))) {
+            ok = 0;
+        }
+#endif
         if (ok) {
             dst->bits      = src->bits;
             dst->hasPub    = 1;
@@ -679,6 +1156,33 @@ static int wp_rsa_get_security_bits(wp_Rsa* rsa)
     return bits;
 }
 
+#ifdef WP_RSA_MULTI_PRIME
+/**
+ * Get the key data of the extra primes into the parameters.
+ *
+ * @param [in]      rsa     RSA key object with extra primes.
+ * @param [in, out] params  Array of parameters and values.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_rsa_mp_get_params(wp_Rsa* rsa, OSSL_PARAM params[])
+{
+    int ok = 1;
+    int i;
+    wp_RsaMp* mp = rsa->mp;
+
+    for (i = 0; ok && (i < mp->cnt); i++) {
+        if ((!wp_params_set_mp(params, wp_rsa_mp_factor_key[i], &mp->r[i])) ||
+            (!wp_params_set_mp(params, wp_rsa_mp_exp_key[i], &mp->d[i])) ||
+            (!wp_params_set_mp(params, wp_rsa_mp_coeff_key[i], &mp->t[i]))) {
+            ok = 0;
+        }
+    }
+
+    return ok;
+}
+#endif
+
 /**
  * Get the key data into the parameters.
  *
@@ -705,6 +1209,11 @@ static int wp_rsa_get_params_key_data(wp_Rsa* rsa,  OSSL_PARAM params[])
             p->return_size = oLen;
         }
     }
+#ifdef WP_RSA_MULTI_PRIME
+    if (ok && (rsa->mp != NULL) && (!wp_rsa_mp_get_params(rsa, params))) {
+        ok = 0;
+    }
+#endif
 
     return ok;
 }
@@ -782,6 +1291,20 @@ static int wp_rsa_get_params(wp_Rsa* rsa, OSSL_PARAM params[])
         (!wp_rsa_get_params_pss(&rsa->pssParams, params))) {
         ok = 0;
     }
+    if (ok) {
+        size_t bytes = sizeof(*rsa);
+
+    #ifdef WP_RSA_MULTI_PRIME
+        if (rsa->mp != NULL) {
+            bytes += sizeof(*rsa->mp);
+        }
+    #endif
+        /* Memory kept by key object. */
+        p = OSSL_PARAM_locate(params, WP_PKEY_PARAM_KEY_BYTES);
+        if ((p != NULL) && (!OSSL_PARAM_set_size_t(p, bytes))) {
+            ok = 0;
+        }
+    }
 
     return ok;
 }
@@ -841,6 +1364,67 @@ static int wp_rsa_match(const wp_Rsa* rsa1, const wp_Rsa* rsa2, int selection)
     return ok;
 }
 
+#ifdef WP_RSA_MULTI_PRIME
+/**
+ * Check the key pair of a multi-prime RSA key.
+ *
+ * n must be the product of all the primes and e * d must be 1 modulo r_i - 1
+ * for each prime r_i.
+ *
+ * @param [in] rsa  RSA key object with extra primes.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_rsa_mp_check(const wp_Rsa* rsa)
+{
+    int ok = 1;
+    int rc;
+    int i;
+    RsaKey* key = (RsaKey*)&rsa->key;
+    wp_RsaMp* mp = rsa->mp;
+    mp_int* prime[WP_RSA_MAX_PRIMES];
+    int cnt = mp->cnt + 2;
+    mp_int n;
+    mp_int t;
+
+    prime[0] = &key->p;
+    prime[1] = &key->q;
+    for (i = 0; i < mp->cnt; i++) {
+        prime[i + 2] = &mp->r[i];
+    }
+
+    rc = mp_init_multi(&n, &t, NULL, NULL, NULL, NULL);
+    if (rc != MP_OKAY) {
+        ok = 0;
+    }
+    else {
+        rc = mp_copy(prime[0], &n);
+        for (i = 1; (rc == MP_OKAY) && (i < cnt); i++) {
+            rc = mp_mul(&n, prime[i], &n);
+        }
+        if ((rc == MP_OKAY) && (mp_cmp(&n, &key->n) != MP_EQ)) {
+            rc = MP_VAL;
+        }
+        for (i = 0; (rc == MP_OKAY) && (i < cnt); i++) {
+            rc = mp_sub_d(prime[i], 1, &t);
+            if (rc == MP_OKAY) {
+                rc = mp_mulmod(&key->e, &key->d, &t, &n);
+            }
+            if ((rc == MP_OKAY) && (!mp_isone(&n))) {
+                rc = MP_VAL;
+            }
+        }
+        if (rc != MP_OKAY) {
+            ok = 0;
+        }
+        mp_forcezero(&t);
+        mp_forcezero(&n);
+    }
+
+    return ok;
+}
+#endif
+
 /**
  * Validate the RSA key.
  *
@@ -861,6 +1445,13 @@ static int wp_rsa_validate(const wp_Rsa* rsa, int selection, int checkType)
 
     (void)checkType;
 
+#ifdef WP_RSA_MULTI_PRIME
+    if (checkPub && checkPriv && (rsa->mp != NULL)) {
+        /* wolfCrypt only checks keys with two primes. */
+        ok = wp_rsa_mp_check(rsa);
+    }
+    else
+#endif
     if (checkPub && checkPriv) {
         rc = wc_CheckRsaKey((RsaKey*)&rsa->key);
         if (rc != 0) {
@@ -883,6 +1474,109 @@ static int wp_rsa_validate(const wp_Rsa* rsa, int selection, int checkType)
     return ok;
 }
 
+/**
+ * Calculate the CRT numbers of the private key from d, p and q.
+ *
+ * Done once when the key is imported so that all private key operations
+ * with the key use the faster CRT implementation.
+ *
+ * @param [in, out] key  wolfSSL RSA key object.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_rsa_calc_crt(RsaKey* key)
+{
+    int ok = 1;
+    int rc;
+    mp_int t;
+
+    rc = mp_init(&t);
+    if (rc != MP_OKAY) {
+        ok = 0;
+    }
+    else {
+        /* dP = d mod (p - 1) */
+        rc = mp_sub_d(&key->p, 1, &t);
+        if (rc == MP_OKAY) {
+            rc = mp_mod(&key->d, &t, &key->dP);
+        }
+        /* dQ = d mod (q - 1) */
+        if (rc == MP_OKAY) {
+            rc = mp_sub_d(&key->q, 1, &t);
+        }
+        if (rc == MP_OKAY) {
+            rc = mp_mod(&key->d, &t, &key->dQ);
+        }
+        /* u = q^-1 mod p */
+        if (rc == MP_OKAY) {
+            rc = mp_invmod(&key->q, &key->p, &key->u);
+        }
+        if (rc != MP_OKAY) {
+            ok = 0;
+        }
+        mp_forcezero(&t);
+    }
+
+    return ok;
+}
+
+#ifdef WP_RSA_MULTI_PRIME
+/**
+ * Import the extra primes of a multi-prime key from parameters.
+ *
+ * The CRT exponents and coefficients of the extra primes are always
+ * calculated from d and the primes.
+ *
+ * @param [in, out] rsa     RSA key object.
+ * @param [in]      params  Array of parameters and values.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_rsa_mp_import(wp_Rsa* rsa, const OSSL_PARAM params[])
+{
+    int ok = 1;
+    int i;
+    int cnt = 0;
+    const OSSL_PARAM* p[WP_RSA_MAX_EXTRA_PRIMES];
+
+    for (i = 0; i < WP_RSA_MAX_EXTRA_PRIMES; i++) {
+        p[i] = OSSL_PARAM_locate_const(params, wp_rsa_mp_factor_key[i]);
+        if (p[i] != NULL) {
+            /* Primes must be consecutive. */
+            if (cnt != i) {
+                ok = 0;
+            }
+            cnt = i + 1;
+        }
+    }
+    /* More primes than supported. */
+    if (OSSL_PARAM_locate_const(params, OSSL_PKEY_PARAM_RSA_FACTOR5) != NULL) {
+        ok = 0;
+    }
+    if (ok) {
+        wp_rsa_mp_free(rsa->mp);
+        rsa->mp = NULL;
+    }
+    if (ok && (cnt > 0)) {
+        rsa->mp = wp_rsa_mp_new(cnt);
+        if (rsa->mp == NULL) {
+            ok = 0;
+        }
+        for (i = 0; ok && (i < cnt); i++) {
+            if (!wp_mp_read_unsigned_bin_le(&rsa->mp->r[i], p[i]->data,
+                    p[i]->data_size)) {
+                ok = 0;
+            }
+        }
+        if (ok && (!wp_rsa_mp_setup(rsa))) {
+            ok = 0;
+        }
+    }
+
+    return ok;
+}
+#endif
+
 /**
  * Import the key data into RSA key object from parameters.
  *
@@ -898,6 +1592,7 @@ static int wp_rsa_import_key_data(wp_Rsa *rsa, const OSSL_PARAM params[],
     int ok = 1;
     int i;
     int cnt;
+    int calcCrt = 0;
 
     if (priv) {
         cnt = WP_RSA_PARAM_NUMS_CNT;
@@ -909,16 +1604,28 @@ static int wp_rsa_import_key_data(wp_Rsa *rsa, const OSSL_PARAM params[],
     for (i = 0; ok && (i < cnt); i++) {
         const OSSL_PARAM* p = OSSL_PARAM_locate_const(params,
             wp_rsa_param_key[i]);
-        if (p == NULL) {
+        if ((p == NULL) && (i >= WP_RSA_PARAM_CRT_IDX)) {
+            /* Missing CRT numbers are calculated from the private key. */
+            calcCrt = 1;
+        }
+        else if (p == NULL) {
             ok = 0;
         }
-        if (ok) {
+        else {
             mp_int* mp = (mp_int*)(((byte*)&rsa->key) + wp_rsa_offset[i]);
             if (!wp_mp_read_unsigned_bin_le(mp, p->data, p->data_size)) {
                 ok = 0;
             }
         }
     }
+    if (ok && calcCrt && (!wp_rsa_calc_crt(&rsa->key))) {
+        ok = 0;
+    }
+#ifdef WP_RSA_MULTI_PRIME
+    if (ok && priv && (!wp_rsa_mp_import(rsa, params))) {
+        ok = 0;
+    }
+#endif
 
     return ok;
 }
@@ -945,6 +1652,11 @@ static int wp_rsa_import(wp_Rsa *rsa, int selection, const OSSL_PARAM params[])
     if (ok && ((selection & WP_RSA_POSSIBLE_SELECTIONS) == 0)) {
         ok = 0;
     }
+    if (ok) {
+        /* Key is changing - memoized encodings no longer match. */
+        wp_der_free(&rsa->spki);
+        wp_der_free(&rsa->expData);
+    }
     if (ok && (importPriv || importPub) && (!wp_rsa_import_key_data(rsa, params,
             importPriv))) {
         ok = 0;
@@ -1024,6 +1736,75 @@ static int wp_rsa_pss_params_export(wp_RsaPssParams* pss, OSSL_PARAM* params,
     return 1;
 }
 
+#ifdef WP_RSA_MULTI_PRIME
+/**
+ * Get the size of allocated data needed for the extra primes.
+ *
+ * @param [in] rsa  RSA key object with extra primes.
+ * @return  Size of buffer to hold allocated extra primes data.
+ */
+static size_t wp_rsa_mp_export_alloc_size(wp_Rsa* rsa)
+{
+    int i;
+    size_t len = 0;
+    wp_RsaMp* mp = rsa->mp;
+
+    for (i = 0; i < mp->cnt; i++) {
+        len += mp_unsigned_bin_size(&mp->r[i]);
+        len += mp_unsigned_bin_size(&mp->d[i]);
+        len += mp_unsigned_bin_size(&mp->t[i]);
+    }
+
+    return len;
+}
+
+/**
+ * Put the extra primes data into the parameters.
+ *
+ * Assumes data buffer is big enough.
+ *
+ * @param [in]      rsa     RSA key object with extra primes.
+ * @param [in, out] params  Array of parameters and values.
+ * @param [in, out] pIdx    Current index into parameters aray.
+ * @param [in, out] data    Data buffer to place extra primes data into.
+ * @param [in, out] idx     Pointer to current index into data.
+ * @param [in]      enc     Whether to encode numbers into data. Otherwise
+ *                          data already holds encoded numbers.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_rsa_mp_export(wp_Rsa* rsa, OSSL_PARAM* params, int* pIdx,
+    unsigned char* data, size_t* idx, int enc)
+{
+    int ok = 1;
+    int i = *pIdx;
+    int j;
+    wp_RsaMp* mp = rsa->mp;
+
+    for (j = 0; ok && (j < mp->cnt); j++) {
+        if (!enc) {
+            wp_param_set_mp_ptr(&params[i++], wp_rsa_mp_factor_key[j],
+                &mp->r[j], data, idx);
+            wp_param_set_mp_ptr(&params[i++], wp_rsa_mp_exp_key[j],
+                &mp->d[j], data, idx);
+            wp_param_set_mp_ptr(&params[i++], wp_rsa_mp_coeff_key[j],
+                &mp->t[j], data, idx);
+        }
+        else if ((!wp_param_set_mp(&params[i++], wp_rsa_mp_factor_key[j],
+                &mp->r[j], data, idx)) ||
+            (!wp_param_set_mp(&params[i++], wp_rsa_mp_exp_key[j], &mp->d[j],
+                data, idx)) ||
+            (!wp_param_set_mp(&params[i++], wp_rsa_mp_coeff_key[j],
+                &mp->t[j], data, idx))) {
+            ok = 0;
+        }
+    }
+
+    *pIdx = i;
+    return ok;
+}
+#endif
+
 /**
  * Get the size of allocated data needed for key pair.
  *
@@ -1052,6 +1833,11 @@ static size_t wp_rsa_export_keypair_alloc_size(wp_Rsa* rsa, int priv)
              len += mp_unsigned_bin_size(mp);
          }
     }
+#ifdef WP_RSA_MULTI_PRIME
+    if (priv && (rsa->mp != NULL)) {
+        len += wp_rsa_mp_export_alloc_size(rsa);
+    }
+#endif
 
     return len;
 }
@@ -1066,11 +1852,14 @@ static size_t wp_rsa_export_keypair_alloc_size(wp_Rsa* rsa, int priv)
  * @param [in, out] pIdx    Current index into parameters aray.
  * @param [in, out] data    Data buffer to place group data into.
  * @param [in, out] idx     Pointer to current index into data.
+ * @param [in]      priv    Whether to export private key numbers.
+ * @param [in]      enc     Whether to encode numbers into data. Otherwise
+ *                          data already holds encoded numbers.
  * @return  1 on success.
  * @return  0 on failure.
  */
 static int wp_rsa_export_keypair(wp_Rsa* rsa, OSSL_PARAM* params, int* pIdx,
-    unsigned char* data, size_t* idx, int priv)
+    unsigned char* data, size_t* idx, int priv, int enc)
 {
     int ok = 1;
     int i = *pIdx;
@@ -1086,13 +1875,72 @@ static int wp_rsa_export_keypair(wp_Rsa* rsa, OSSL_PARAM* params, int* pIdx,
 
     for (j = 0; ok && (j < cnt); j++) {
          mp_int* mp = (mp_int*)(((byte*)&rsa->key) + wp_rsa_offset[j]);
-         if (!mp_iszero(mp) && (!wp_param_set_mp(&params[i++],
-                 wp_rsa_param_key[j], mp, data, idx))) {
+         if (mp_iszero(mp)) {
+             continue;
+         }
+         if (!enc) {
+             wp_param_set_mp_ptr(&params[i++], wp_rsa_param_key[j], mp, data,
+                 idx);
+         }
+         else if (!wp_param_set_mp(&params[i++], wp_rsa_param_key[j], mp,
+                 data, idx)) {
              ok = 0;
         }
     }
+#ifdef WP_RSA_MULTI_PRIME
+    if (ok && priv && (rsa->mp != NULL) &&
+        (!wp_rsa_mp_export(rsa, params, &i, data, idx, enc))) {
+        ok = 0;
+    }
+#endif
+
+    *pIdx = i;
+    return ok;
+}
+
+/**
+ * Get the numbers of the RSA key serialized for export.
+ *
+ * Keys are exported on every copy between providers, so the numbers are
+ * serialized once and memoized on the key object. All numbers present are
+ * serialized with the public numbers first.
+ *
+ * @param [in]  rsa    RSA key object.
+ * @param [out] data   DER object holding serialized numbers.
+ * @param [out] owned  1 when caller is to free DER object, otherwise 0.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_rsa_get_export_data(wp_Rsa* rsa, wp_Der** data, int* owned)
+{
+    int ok = 1;
+    wp_Der* der;
+    OSSL_PARAM params[WP_RSA_PARAM_NUMS_CNT + 3 * WP_RSA_MAX_EXTRA_PRIMES];
+    int paramSz = 0;
+    size_t len = 0;
+
+    *owned = 0;
+    der = wp_der_get(&rsa->expData);
+    if (der == NULL) {
+        der = wp_der_new(wp_rsa_export_keypair_alloc_size(rsa, 1));
+        if (der == NULL) {
+            ok = 0;
+        }
+        if (ok && (!wp_rsa_export_keypair(rsa, params, &paramSz,
+                WP_DER_DATA(der), &len, 1, 1))) {
+            ok = 0;
+        }
+        if (ok) {
+            *owned = !wp_der_set(&rsa->expData, &der);
+        }
+        else if (der != NULL) {
+            OPENSSL_clear_free(der, sizeof(*der) + der->len);
+        }
+    }
+    if (ok) {
+        *data = der;
+    }
 
-    *pIdx = i;
     return ok;
 }
 
@@ -1100,6 +1948,7 @@ static int wp_rsa_export_keypair(wp_Rsa* rsa, OSSL_PARAM* params, int* pIdx,
  * Export the RSA key.
  *
  * Key data placed in parameters and then passed to callback.
+ * Parameters refer to the memoized serialized numbers - nothing allocated.
  *
  * @param [in] rsa        RSA key object.
  * @param [in] selection  Parts of key to export.
@@ -1112,9 +1961,10 @@ static int wp_rsa_export(wp_Rsa* rsa, int selection, OSSL_CALLBACK* paramCb,
     void* cbArg)
 {
     int ok = 1;
-    OSSL_PARAM params[13];
+    OSSL_PARAM params[13 + 3 * WP_RSA_MAX_EXTRA_PRIMES];
     int paramSz = 0;
-    unsigned char* data = NULL;
+    wp_Der* data = NULL;
+    int owned = 0;
     size_t len = 0;
     int expPriv = (selection & OSSL_KEYMGMT_SELECT_PRIVATE_KEY) != 0;
 
@@ -1126,19 +1976,20 @@ static int wp_rsa_export(wp_Rsa* rsa, int selection, OSSL_CALLBACK* paramCb,
     }
     if (ok) {
         XMEMSET(params, 0, sizeof(params));
-        data = OPENSSL_malloc(wp_rsa_export_keypair_alloc_size(rsa, expPriv));
-        if (data == NULL) {
-            ok = 0;
-        }
     }
     if (ok && ((selection & OSSL_KEYMGMT_SELECT_OTHER_PARAMETERS) != 0) &&
         (rsa->type == RSA_FLAG_TYPE_RSASSAPSS) &&
         (!wp_rsa_pss_params_export(&rsa->pssParams, params, &paramSz))) {
         ok = 0;
     }
-    if (ok && ((selection & OSSL_KEYMGMT_SELECT_KEYPAIR) != 0) &&
-        (!wp_rsa_export_keypair(rsa, params, &paramSz, data, &len, expPriv))) {
-        ok = 0;
+    if (ok && ((selection & OSSL_KEYMGMT_SELECT_KEYPAIR) != 0)) {
+        if (!wp_rsa_get_export_data(rsa, &data, &owned)) {
+            ok = 0;
+        }
+        if (ok && (!wp_rsa_export_keypair(rsa, params, &paramSz,
+                WP_DER_DATA(data), &len, expPriv, 0))) {
+            ok = 0;
+        }
     }
 
     if (ok && (!paramCb(params, cbArg))) {
@@ -1146,7 +1997,9 @@ static int wp_rsa_export(wp_Rsa* rsa, int selection, OSSL_CALLBACK* paramCb,
     }
 
     (void)paramSz;
-    OPENSSL_clear_free(data, len);
+    if (owned) {
+        OPENSSL_clear_free(data, sizeof(*data) + data->len);
+    }
 
     return ok;
 }
@@ -1188,7 +2041,7 @@ static wp_RsaGenCtx* wp_rsa_base_gen_init(WOLFPROV_CTX* provCtx,
         int ok = 1;
         int rc;
 
-        rc = wc_InitRng_ex(&ctx->rng, NULL, INVALID_DEVID);
+        rc = wc_InitRng_ex(&ctx->rng, NULL, provCtx->devId);
         if (rc != 0) {
             ok = 0;
         }
@@ -1198,6 +2051,7 @@ static wp_RsaGenCtx* wp_rsa_base_gen_init(WOLFPROV_CTX* provCtx,
             /* Set defaults. */
             ctx->bits    = 2048;
             ctx->e       = WC_RSA_EXPONENT;
+            ctx->primes  = 2;
 
             if (!wp_rsa_gen_set_params(ctx, params)) {
                 wc_FreeRng(&ctx->rng);
@@ -1214,9 +2068,304 @@ static wp_RsaGenCtx* wp_rsa_base_gen_init(WOLFPROV_CTX* provCtx,
     return ctx;
 }
 
+#ifdef WP_RSA_MULTI_PRIME_GEN
+/**
+ * Get the maximum number of primes of a key of the size, as in OpenSSL.
+ *
+ * @param [in] bits  Size of key in bits.
+ * @return  Maximum number of primes.
+ */
+static size_t wp_rsa_mp_max_primes(size_t bits)
+{
+    size_t primes = 2;
+
+    if (bits >= 4096) {
+        primes = 4;
+    }
+    else if (bits >= 1024) {
+        primes = 3;
+    }
+
+    return primes;
+}
+
+/**
+ * Generate a prime for a multi-prime RSA key.
+ *
+ * The prime minus one is co-prime with e and the prime is different from the
+ * primes already generated.
+ *
+ * @param [out] r      Prime generated.
+ * @param [in]  len    Length of prime in bytes. Top two bits are set.
+ * @param [in]  prime  Primes already generated.
+ * @param [in]  cnt    Number of primes already generated.
+ * @param [in]  e      Public exponent.
+ * @param [in]  rng    Random number generator.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_rsa_mp_gen_prime(mp_int* r, int len, mp_int** prime, int cnt,
+    mp_int* e, WC_RNG* rng)
+{
+    int ok = 1;
+    int rc;
+    int i;
+    int good = 0;
+    int tries;
+    mp_int t;
+    mp_int g;
+
+    rc = mp_init_multi(&t, &g, NULL, NULL, NULL, NULL);
+    for (tries = 0; (rc == MP_OKAY) && (!good) &&
+            (tries < WP_RSA_MP_GEN_TRIES); tries++) {
+        rc = mp_rand_prime(r, len, rng, NULL);
+        /* gcd(e, r - 1) == 1 */
+        if (rc == MP_OKAY) {
+            rc = mp_sub_d(r, 1, &t);
+        }
+        if (rc == MP_OKAY) {
+            rc = mp_gcd(e, &t, &g);
+        }
+        if (rc == MP_OKAY) {
+            good = mp_isone(&g);
+        }
+        for (i = 0; good && (i < cnt); i++) {
+            if (mp_cmp(r, prime[i]) == MP_EQ) {
+                good = 0;
+            }
+        }
+    }
+    if ((rc != MP_OKAY) || (!good)) {
+        ok = 0;
+    }
+
+    mp_forcezero(&t);
+    mp_forcezero(&g);
+    return ok;
+}
+
+/**
+ * Generate a multi-prime RSA key (RFC 8017, 3).
+ *
+ * Primes are a whole number of bytes and the key size must be a multiple of 8.
+ * d is the inverse of e modulo the product of r_i - 1.
+ *
+ * @param [in, out] rsa     RSA key object.
+ * @param [in]      bits    Size of key in bits.
+ * @param [in]      primes  Number of primes.
+ * @param [in]      e       Public exponent.
+ * @param [in]      rng     Random number generator.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_rsa_mp_make_key(wp_Rsa* rsa, size_t bits, size_t primes,
+    size_t e, WC_RNG* rng)
+{
+    int ok = 1;
+    int rc;
+    int i;
+    int cnt = (int)primes;
+    int bytes = (int)(bits / 8);
+    int done = 0;
+    int tries;
+    RsaKey* key = &rsa->key;
+    mp_int* prime[WP_RSA_MAX_PRIMES];
+    mp_int t;
+    mp_int phi;
+
+    if (((bits % 8) != 0) || (primes > wp_rsa_mp_max_primes(bits))) {
+        ok = 0;
+    }
+    if (ok) {
+        rsa->mp = wp_rsa_mp_new(cnt - 2);
+        if (rsa->mp == NULL) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        prime[0] = &key->p;
+        prime[1] = &key->q;
+        for (i = 0; i < cnt - 2; i++) {
+            prime[i + 2] = &rsa->mp->r[i];
+        }
+
+        rc = mp_init_multi(&t, &phi, NULL, NULL, NULL, NULL);
+        if (rc == MP_OKAY) {
+            rc = mp_set_int(&key->e, (unsigned long)e);
+        }
+        for (tries = 0; (rc == MP_OKAY) && (!done) &&
+                (tries < WP_RSA_MP_GEN_TRIES); tries++) {
+            for (i = 0; (rc == MP_OKAY) && (i < cnt); i++) {
+                if (!wp_rsa_mp_gen_prime(prime[i],
+                        (bytes / cnt) + (i < (bytes % cnt)), prime, i,
+                        &key->e, rng)) {
+                    rc = MP_VAL;
+                }
+            }
+            /* n = r_1 * ... * r_u - must be exactly the size of the key. */
+            if (rc == MP_OKAY) {
+                rc = mp_copy(prime[0], &key->n);
+            }
+            for (i = 1; (rc == MP_OKAY) && (i < cnt); i++) {
+                rc = mp_mul(&key->n, prime[i], &key->n);
+            }
+            if (rc == MP_OKAY) {
+                done = (mp_count_bits(&key->n) == (int)bits);
+            }
+        }
+        if ((rc == MP_OKAY) && (!done)) {
+            rc = MP_VAL;
+        }
+        /* phi = (r_1 - 1) * ... * (r_u - 1) */
+        if (rc == MP_OKAY) {
+            rc = mp_sub_d(prime[0], 1, &phi);
+        }
+        for (i = 1; (rc == MP_OKAY) && (i < cnt); i++) {
+            rc = mp_sub_d(prime[i], 1, &t);
+            if (rc == MP_OKAY) {
+                rc = mp_mul(&phi, &t, &phi);
+            }
+        }
+        /* d = e^-1 mod phi */
+        if (rc == MP_OKAY) {
+            rc = mp_invmod(&key->e, &phi, &key->d);
+        }
+        if (rc != MP_OKAY) {
+            ok = 0;
+        }
+        mp_forcezero(&phi);
+        mp_forcezero(&t);
+    }
+    if (ok && (!wp_rsa_calc_crt(key))) {
+        ok = 0;
+    }
+    if (ok && (!wp_rsa_mp_setup(rsa))) {
+        ok = 0;
+    }
+    if (ok) {
+        key->type = RSA_PRIVATE;
+    }
+
+    return ok;
+}
+
+/**
+ * Generate a multi-prime RSA key pair.
+ *
+ * Multi-prime keys are not pre-generated in the key pool.
+ *
+ * @param [in, out] ctx  RSA generation context object.
+ * @return  NULL on failure.
+ * @return  RSA key object on success.
+ */
+static wp_Rsa* wp_rsa_mp_gen(wp_RsaGenCtx* ctx)
+{
+    wp_Rsa* rsa;
+
+    rsa = wp_rsa_base_new(ctx->provCtx, ctx->type);
+    if (rsa != NULL) {
+        if (!wp_rsa_mp_make_key(rsa, ctx->bits, ctx->primes, ctx->e,
+                &ctx->rng)) {
+            wp_rsa_free(rsa);
+            rsa = NULL;
+        }
+        else {
+            rsa->bits    = ctx->bits;
+            rsa->hasPub  = 1;
+            rsa->hasPriv = 1;
+        }
+    }
+
+    return rsa;
+}
+#endif
+
+/** Sizes of RSA keys in bits pre-generated in key pool, in slot order. */
+static const size_t wp_rsa_pool_bits[] = { 2048, 3072, 4096 };
+/** Number of sizes of RSA keys pre-generated in key pool. */
+#define WP_RSA_POOL_BITS_CNT \
+    (sizeof(wp_rsa_pool_bits) / sizeof(*wp_rsa_pool_bits))
+
+/**
+ * Generate an RSA key pair for the key pool.
+ *
+ * Uses the calling thread's provider random number generator.
+ *
+ * @param [in] provCtx  Provider context.
+ * @param [in] arg      Size of key in bits.
+ * @return  NULL on failure.
+ * @return  RSA key object on success.
+ */
+static void* wp_rsa_pool_gen(WOLFPROV_CTX* provCtx, const void* arg)
+{
+    size_t bits = *(const size_t*)arg;
+    wp_Rsa* rsa;
+
+    rsa = wp_rsa_base_new(provCtx, RSA_FLAG_TYPE_RSA);
+    if (rsa != NULL) {
+        WC_RNG* rng = wp_provctx_get_rng(provCtx);
+        int rc = -1;
+
+        if (rng != NULL) {
+            rc = wc_MakeRsaKey(&rsa->key, (int)bits, WC_RSA_EXPONENT, rng);
+        }
+        if (rc != 0) {
+            wp_rsa_free(rsa);
+            rsa = NULL;
+        }
+        else {
+            rsa->bits    = bits;
+            rsa->hasPub  = 1;
+            rsa->hasPriv = 1;
+        }
+    }
+
+    return rsa;
+}
+
+/**
+ * Dispose of an RSA key object from the key pool.
+ *
+ * @param [in, out] key  RSA key object.
+ */
+static void wp_rsa_pool_free(void* key)
+{
+    wp_rsa_free((wp_Rsa*)key);
+}
+
+/**
+ * Take a pre-generated RSA key pair from the key pool.
+ *
+ * Only keys of the pooled sizes with public exponent 65537 are pooled.
+ *
+ * @param [in] ctx  RSA generation context object.
+ * @return  RSA key object on success.
+ * @return  NULL when key not pooled or none available.
+ */
+static wp_Rsa* wp_rsa_pool_get(wp_RsaGenCtx* ctx)
+{
+    wp_Rsa* rsa = NULL;
+    size_t i;
+
+    if ((ctx->provCtx->keyPool != NULL) && (ctx->e == WC_RSA_EXPONENT)) {
+        for (i = 0; i < WP_RSA_POOL_BITS_CNT; i++) {
+            if (wp_rsa_pool_bits[i] == ctx->bits) {
+                rsa = (wp_Rsa*)wp_key_pool_get(ctx->provCtx,
+                    WP_KEY_POOL_RSA_FIRST + (int)i, wp_rsa_pool_gen,
+                    wp_rsa_pool_free, &wp_rsa_pool_bits[i]);
+                break;
+            }
+        }
+    }
+
+    return rsa;
+}
+
 /**
  * Generate RSA key pair using wolfSSL.
  *
+ * Takes a pre-generated key pair from the key pool when available.
+ *
  * @param [in, out] ctx    RSA generation context object.
  * @param [in]      cb     Progress callback. Unused.
  * @param [in]      cbArg  Argument to pass to callback. Unused.
@@ -1226,26 +2375,42 @@ static wp_RsaGenCtx* wp_rsa_base_gen_init(WOLFPROV_CTX* provCtx,
 static wp_Rsa* wp_rsa_gen(wp_RsaGenCtx *ctx, OSSL_CALLBACK *cb, void *cbArg)
 {
     wp_Rsa* rsa = NULL;
+    word64 mStart = wp_metrics_start();
 
     (void)cb;
     (void)cbArg;
 
     if (wolfssl_prov_is_running()) {
-        rsa = wp_rsa_base_new(ctx->provCtx, ctx->type);
-        if (rsa != NULL) {
-            int rc = wc_MakeRsaKey(&rsa->key, ctx->bits, ctx->e, &ctx->rng);
-            if (rc != 0) {
-                wp_rsa_free(rsa);
-                rsa = NULL;
-            }
-            else {
-                rsa->type      = ctx->type;
-                rsa->bits      = ctx->bits;
-                rsa->hasPub    = 1;
-                rsa->hasPriv   = 1;
-                rsa->pssParams = ctx->pssParams;
+#ifdef WP_RSA_MULTI_PRIME_GEN
+        if (ctx->primes > 2) {
+            rsa = wp_rsa_mp_gen(ctx);
+        }
+        else
+#endif
+        {
+            rsa = wp_rsa_pool_get(ctx);
+            if (rsa == NULL) {
+                rsa = wp_rsa_base_new(ctx->provCtx, ctx->type);
+                if (rsa != NULL) {
+                    int rc = wc_MakeRsaKey(&rsa->key, ctx->bits, ctx->e,
+                        &ctx->rng);
+                    if (rc != 0) {
+                        wp_rsa_free(rsa);
+                        rsa = NULL;
+                    }
+                    else {
+                        rsa->bits    = ctx->bits;
+                        rsa->hasPub  = 1;
+                        rsa->hasPriv = 1;
+                    }
+                }
             }
         }
+        if (rsa != NULL) {
+            rsa->type      = ctx->type;
+            rsa->pssParams = ctx->pssParams;
+            wp_metrics_record(WP_METRIC_RSA_KEYGEN, mStart, 0);
+        }
     }
 
     return rsa;
@@ -1291,14 +2456,19 @@ static int wp_rsa_gen_set_params(wp_RsaGenCtx* ctx, const OSSL_PARAM params[])
         if (ok) {
             p = OSSL_PARAM_locate_const(params, OSSL_PKEY_PARAM_RSA_PRIMES);
             if (p != NULL) {
-                size_t primes;
-
-                if (!OSSL_PARAM_get_size_t(p, &primes)) {
+                if (!OSSL_PARAM_get_size_t(p, &ctx->primes)) {
+                    ok = 0;
+                }
+#ifdef WP_RSA_MULTI_PRIME_GEN
+                else if ((ctx->primes < 2) ||
+                         (ctx->primes > WP_RSA_MAX_PRIMES)) {
                     ok = 0;
                 }
-                else if (primes != 2) {
+#else
+                else if (ctx->primes != 2) {
                     ok = 0;
                 }
+#endif
             }
         }
         if (ok) {
@@ -1347,6 +2517,7 @@ static const OSSL_PARAM *wp_rsa_gettable_params(WOLFPROV_CTX* provctx)
         OSSL_PARAM_int(OSSL_PKEY_PARAM_SECURITY_BITS, NULL),
         OSSL_PARAM_int(OSSL_PKEY_PARAM_MAX_SIZE, NULL),
         OSSL_PARAM_utf8_string(OSSL_PKEY_PARAM_DEFAULT_DIGEST, NULL, 0),
+        OSSL_PARAM_size_t(WP_PKEY_PARAM_KEY_BYTES, NULL),
         WP_RSA_NUM_PARAMS,
         OSSL_PARAM_END
     };
@@ -1479,6 +2650,7 @@ static const OSSL_PARAM *wp_rsapss_gettable_params(WOLFPROV_CTX* provctx)
         OSSL_PARAM_int(OSSL_PKEY_PARAM_SECURITY_BITS, NULL),
         OSSL_PARAM_int(OSSL_PKEY_PARAM_MAX_SIZE, NULL),
         OSSL_PARAM_utf8_string(OSSL_PKEY_PARAM_DEFAULT_DIGEST, NULL, 0),
+        OSSL_PARAM_size_t(WP_PKEY_PARAM_KEY_BYTES, NULL),
         WP_RSA_NUM_PARAMS,
         /* TODO: OpenSSL doesn't include these. */
         WP_RSA_PSS_PARAMS,
@@ -1747,6 +2919,68 @@ static int wp_rsa_decode_pki(wp_Rsa* rsa, unsigned char* data, word32 len)
     return ok;
 }
 
+/**
+ * Decode only the public key from a PrivateKeyInfo or RSAPrivateKey DER
+ * encoding.
+ *
+ * The private components are not parsed into numbers. Used when the caller
+ * selected only the public parts of the key.
+ *
+ * @param [in, out] rsa   RSA key object.
+ * @param [in]      data  DER encoding.
+ * @param [in]      len   Length, in bytes, of DER encoding.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_rsa_decode_pki_pub(wp_Rsa* rsa, unsigned char* data, word32 len)
+{
+    int ok = 1;
+    int rc;
+    word32 idx = 0;
+    word32 itemLen = 0;
+    const unsigned char* n = NULL;
+    word32 nLen = 0;
+
+    /* Skip PKCS#8 wrapping when present. */
+    if (wc_GetPkcs8TraditionalOffset(data, &idx, len) < 0) {
+        idx = 0;
+    }
+    /* RSAPrivateKey: SEQUENCE { version, n, e, d, ... } */
+    if (!wp_der_get_item(data, len, &idx, 0x30, &itemLen)) {
+        ok = 0;
+    }
+    if (ok && !wp_der_get_item(data, len, &idx, 0x02, &itemLen)) {
+        ok = 0;
+    }
+    if (ok) {
+        idx += itemLen;
+        if (!wp_der_get_item(data, len, &idx, 0x02, &nLen)) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        n = data + idx;
+        idx += nLen;
+        if (!wp_der_get_item(data, len, &idx, 0x02, &itemLen)) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        rc = wc_RsaPublicKeyDecodeRaw(n, nLen, data + idx, itemLen,
+            &rsa->key);
+        if (rc != 0) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        wp_rsa_find_oid(rsa, data, len);
+        rsa->bits = wc_RsaEncryptSize(&rsa->key) * 8;
+        rsa->hasPub = 1;
+    }
+
+    return ok;
+}
+
 /**
  * Construct parameters from RSA key and pass off to callback.
  *
@@ -1804,6 +3038,9 @@ static int wp_rsa_decode(wp_RsaEncDecCtx* ctx, OSSL_CORE_BIO *cBio,
     unsigned char* data = NULL;
     word32 len = 0;
     wp_Rsa* rsa = NULL;
+    /* Private components not needed when only public parts selected. */
+    int pubOnly = ((selection & OSSL_KEYMGMT_SELECT_PRIVATE_KEY) == 0) &&
+                  ((selection & OSSL_KEYMGMT_SELECT_PUBLIC_KEY) != 0);
 
     (void)pwCb;
     (void)pwCbArg;
@@ -1823,6 +3060,9 @@ static int wp_rsa_decode(wp_RsaEncDecCtx* ctx, OSSL_CORE_BIO *cBio,
             decoded = 0;
         }
     }
+    else if (ok && pubOnly && wp_rsa_decode_pki_pub(rsa, data, len)) {
+        /* Private key encoding but only public key wanted. */
+    }
     else if (ok && (ctx->format == WP_ENC_FORMAT_PKI)) {
         if (!wp_rsa_decode_pki(rsa, data, len)) {
             ok = 0;
@@ -1921,10 +3161,18 @@ static int wp_rsa_encode_pki_size(const wp_Rsa *rsa, size_t* keyLen)
     int ret;
     word32 len;
 
-    ret = wc_RsaKeyToDer((RsaKey*)&rsa->key, NULL, 0);
-    if (ret <= 0) {
+#ifdef WP_RSA_MULTI_PRIME
+    /* wolfCrypt only encodes keys with two primes. */
+    if (rsa->mp != NULL) {
         ok = 0;
     }
+#endif
+    if (ok) {
+        ret = wc_RsaKeyToDer((RsaKey*)&rsa->key, NULL, 0);
+        if (ret <= 0) {
+            ok = 0;
+        }
+    }
     if (ok) {
         ret = wc_CreatePKCS8Key(NULL, &len, NULL, ret, RSAk, NULL, 0);
         if (ret != LENGTH_ONLY_E) {
@@ -2043,6 +3291,53 @@ static int wp_rsa_encode_epki(const wp_RsaEncDecCtx* ctx, const wp_Rsa *rsa,
     return ok;
 }
 
+/**
+ * Get the SubjectPublicKeyInfo encoding of the key.
+ *
+ * The same key is encoded repeatedly - certificate matching, key identifiers
+ * and public key hashing - so the encoding is memoized on the key object.
+ *
+ * @param [in]  rsa    RSA key object.
+ * @param [out] spki   DER object holding encoding.
+ * @param [out] owned  1 when caller is to free DER object, otherwise 0.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_rsa_get_spki(const wp_Rsa* rsa, wp_Der** spki, int* owned)
+{
+    int ok = 1;
+    wp_Der* der;
+    size_t len = 0;
+
+    *owned = 0;
+    der = wp_der_get(&rsa->spki);
+    if (der == NULL) {
+        if (!wp_rsa_encode_spki_size(rsa, &len)) {
+            ok = 0;
+        }
+        if (ok) {
+            der = wp_der_new(len);
+            if (der == NULL) {
+                ok = 0;
+            }
+        }
+        if (ok && (!wp_rsa_encode_spki(rsa, WP_DER_DATA(der), &der->len))) {
+            ok = 0;
+        }
+        if (ok) {
+            *owned = !wp_der_set(&((wp_Rsa*)rsa)->spki, &der);
+        }
+        else {
+            OPENSSL_free(der);
+        }
+    }
+    if (ok) {
+        *spki = der;
+    }
+
+    return ok;
+}
+
 /**
  * Encode the RSA key.
  *
@@ -2064,7 +3359,7 @@ static int wp_rsa_encode(wp_RsaEncDecCtx* ctx, OSSL_CORE_BIO *cBio,
     int rc;
     BIO* out = wp_corebio_get_bio(cBio);
     unsigned char* keyData = NULL;
-    size_t keyLen;
+    size_t keyLen = 0;
     unsigned char* derData = NULL;
     size_t derLen = 0;
     unsigned char* pemData = NULL;
@@ -2072,6 +3367,10 @@ static int wp_rsa_encode(wp_RsaEncDecCtx* ctx, OSSL_CORE_BIO *cBio,
     int pemType = PKCS8_PRIVATEKEY_TYPE;
     int private = 0;
     byte* cipherInfo = NULL;
+    wp_Der* spki = NULL;
+    int spkiOwned = 0;
+    unsigned char* der = NULL;
+    size_t allocLen = 0;
 
     (void)params;
     (void)selection;
@@ -2081,9 +3380,14 @@ static int wp_rsa_encode(wp_RsaEncDecCtx* ctx, OSSL_CORE_BIO *cBio,
     }
 
     if (ok && (ctx->format == WP_ENC_FORMAT_SPKI)) {
-        if (!wp_rsa_encode_spki_size(key, &derLen)) {
+        pemType = PUBLICKEY_TYPE;
+        if (!wp_rsa_get_spki(key, &spki, &spkiOwned)) {
             ok = 0;
         }
+        if (ok) {
+            der = WP_DER_DATA(spki);
+            derLen = spki->len;
+        }
     }
     else if (ok && (ctx->format == WP_ENC_FORMAT_PKI)) {
         private = 1;
@@ -2098,20 +3402,14 @@ static int wp_rsa_encode(wp_RsaEncDecCtx* ctx, OSSL_CORE_BIO *cBio,
         }
     }
 
-    if (ok) {
-        keyLen = derLen;
-        keyData = derData = OPENSSL_malloc(derLen);
+    if (ok && (spki == NULL)) {
+        allocLen = derLen;
+        der = derData = OPENSSL_malloc(allocLen);
         if (derData == NULL) {
             ok = 0;
         }
     }
-    if (ok && (ctx->format == WP_ENC_FORMAT_SPKI)) {
-        pemType = PUBLICKEY_TYPE;
-        if (!wp_rsa_encode_spki(key, derData, &derLen)) {
-            ok = 0;
-        }
-    }
-    else if (ok && (ctx->format == WP_ENC_FORMAT_PKI)) {
+    if (ok && (ctx->format == WP_ENC_FORMAT_PKI)) {
         private = 1;
         if (!wp_rsa_encode_pki(key, derData, &derLen)) {
             ok = 0;
@@ -2126,10 +3424,11 @@ static int wp_rsa_encode(wp_RsaEncDecCtx* ctx, OSSL_CORE_BIO *cBio,
     }
 
     if (ok && (ctx->encoding == WP_FORMAT_DER)) {
+        keyData = der;
         keyLen = derLen;
     }
     else if (ok && (ctx->encoding == WP_FORMAT_PEM)) {
-        rc = wc_DerToPemEx(derData, derLen, NULL, 0, cipherInfo, pemType);
+        rc = wc_DerToPemEx(der, derLen, NULL, 0, cipherInfo, pemType);
         if (rc <= 0) {
             ok = 0;
         }
@@ -2141,7 +3440,7 @@ static int wp_rsa_encode(wp_RsaEncDecCtx* ctx, OSSL_CORE_BIO *cBio,
             }
         }
         if (ok) {
-            rc = wc_DerToPemEx(derData, derLen, pemData, pemLen, NULL, pemType);
+            rc = wc_DerToPemEx(der, derLen, pemData, pemLen, NULL, pemType);
             if (rc <= 0) {
                 ok = 0;
             }
@@ -2158,8 +3457,11 @@ static int wp_rsa_encode(wp_RsaEncDecCtx* ctx, OSSL_CORE_BIO *cBio,
         }
     }
 
+    if (spkiOwned) {
+        OPENSSL_free(spki);
+    }
     if (private) {
-        OPENSSL_clear_free(derData, derLen);
+        OPENSSL_clear_free(derData, allocLen);
         OPENSSL_clear_free(pemData, pemLen);
     }
     else {
@@ -62,8 +62,6 @@ typedef struct wp_RsaSigCtx {
 
     /** wolfProvider RSA object. */
     wp_Rsa* rsa;
-    /** wolfSSL random number generator for signing. */
-    WC_RNG rng;
 
     /** Operation being performed as an EVP define. */
     int op;
@@ -144,7 +142,8 @@ static int wp_rsa_setup_md(wp_RsaSigCtx *ctx, const char *mdName,
         }
 
         if (ok) {
-            rc = wc_HashInit_ex(&ctx->hash, ctx->hashType, NULL, INVALID_DEVID);
+            rc = wc_HashInit_ex(&ctx->hash, ctx->hashType, NULL,
+                ctx->provCtx->devId);
             if (rc != 0) {
                 ok = 0;
             }
@@ -221,7 +220,6 @@ static wp_RsaSigCtx* wp_rsa_ctx_new(WOLFPROV_CTX* provCtx,
     if (ctx != NULL) {
         int ok = 1;
         char* p = NULL;
-        int rc;
 
         if (propQuery != NULL) {
             p = OPENSSL_strdup(propQuery);
@@ -229,12 +227,6 @@ static wp_RsaSigCtx* wp_rsa_ctx_new(WOLFPROV_CTX* provCtx,
                 ok = 0;
             }
         }
-        if (ok) {
-            rc = wc_InitRng(&ctx->rng);
-            if (rc != 0) {
-                ok = 0;
-            }
-        }
         if (ok) {
             ctx->propQuery = p;
             ctx->provCtx = provCtx;
@@ -259,7 +251,6 @@ static wp_RsaSigCtx* wp_rsa_ctx_new(WOLFPROV_CTX* provCtx,
 static void wp_rsa_ctx_free(wp_RsaSigCtx* ctx)
 {
     if (ctx != NULL) {
-        wc_FreeRng(&ctx->rng);
         wp_rsa_free(ctx->rsa);
         OPENSSL_free(ctx->propQuery);
         OPENSSL_free(ctx);
@@ -567,6 +558,7 @@ static int wp_rsa_sign_pkcs1(wp_RsaSigCtx *ctx, unsigned char *sig,
     int rc;
     unsigned char *encodedDigest = NULL;
     int encodedDigestLen = 0;
+    WC_RNG* rng = NULL;
 
     if (ctx->hashType != WC_HASH_TYPE_NONE) {
         if (tbsLen != (size_t)wc_HashGetDigestSize(ctx->hashType)) {
@@ -591,8 +583,17 @@ static int wp_rsa_sign_pkcs1(wp_RsaSigCtx *ctx, unsigned char *sig,
         }
     }
     if (ok) {
-        rc = wc_RsaSSL_Sign(tbs, tbsLen, sig, sigSize, wp_rsa_get_key(ctx->rsa),
-            &ctx->rng);
+        rng = wp_provctx_get_rng(ctx->provCtx);
+        if (rng == NULL) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        do {
+            rc = wc_RsaSSL_Sign(tbs, tbsLen, sig, sigSize,
+                wp_rsa_get_key(ctx->rsa), rng);
+        }
+        while (wp_async_pending(&rc, WP_ASYNC_DEV(wp_rsa_get_key(ctx->rsa))));
         if (rc <= 0) {
             ok = 0;
         }
@@ -628,15 +629,25 @@ static int wp_rsa_sign_pss(wp_RsaSigCtx *ctx, unsigned char *sig,
     int rc;
     int saltLen = wp_pss_salt_len_to_wc(ctx->saltLen, ctx->hashType,
         wp_rsa_get_key(ctx->rsa), EVP_PKEY_OP_SIGN);
+    WC_RNG* rng = wp_provctx_get_rng(ctx->provCtx);
 
-    rc = wc_RsaPSS_Sign_ex(tbs, (word32)tbsLen, sig, (word32)sigSize,
-        ctx->hashType, ctx->mgf, saltLen, wp_rsa_get_key(ctx->rsa),
-        &ctx->rng);
-    if (rc < 0) {
+    if (rng == NULL) {
         ok = 0;
     }
-    else {
-        *sigLen = rc;
+    if (ok) {
+        do {
+            rc = wc_RsaPSS_Sign_ex(tbs, (word32)tbsLen, sig, (word32)sigSize,
+                ctx->hashType, ctx->mgf, saltLen, wp_rsa_get_key(ctx->rsa),
+                rng);
+        }
+        while (wp_async_pending(&rc,
+            WP_ASYNC_DEV(wp_rsa_get_key(ctx->rsa))));
+        if (rc < 0) {
+            ok = 0;
+        }
+        else {
+            *sigLen = rc;
+        }
     }
 
     return ok;
@@ -664,8 +675,13 @@ static int wp_rsa_sign_no_pad(wp_RsaSigCtx *ctx, unsigned char *sig,
     }
     if (ok) {
         word32 len = sigSize;
-        int rc = wc_RsaDirect((byte*)tbs, (word32)tbsLen, sig, &len,
-            wp_rsa_get_key(ctx->rsa), RSA_PRIVATE_ENCRYPT, &ctx->rng);
+        WC_RNG* rng = wp_provctx_get_rng(ctx->provCtx);
+        int rc = -1;
+
+        if (rng != NULL) {
+            rc = wc_RsaDirect((byte*)tbs, (word32)tbsLen, sig, &len,
+                wp_rsa_get_key(ctx->rsa), RSA_PRIVATE_ENCRYPT, rng);
+        }
         if (rc < 0) {
             ok = 0;
         }
@@ -696,6 +712,7 @@ static int wp_rsa_sign(wp_RsaSigCtx *ctx, unsigned char *sig, size_t *sigLen,
     size_t sigSize, const unsigned char *tbs, size_t tbsLen)
 {
     int ok = 1;
+    word64 mStart = wp_metrics_start();
 
     if (!wolfssl_prov_is_running()) {
         ok = 0;
@@ -707,9 +724,13 @@ static int wp_rsa_sign(wp_RsaSigCtx *ctx, unsigned char *sig, size_t *sigLen,
         *sigLen = wc_RsaEncryptSize(wp_rsa_get_key(ctx->rsa));
     }
     else {
+        wp_Arena* arena;
+
         if (sigSize == (size_t)-1) {
             sigSize = *sigLen;
         }
+        /* wolfCrypt temporaries from thread's arena when configured. */
+        arena = wp_arena_begin();
         if (ctx->padMode == RSA_PKCS1_PADDING) {
             ok = wp_rsa_sign_pkcs1(ctx, sig, sigLen, sigSize, tbs, tbsLen);
         }
@@ -722,6 +743,10 @@ static int wp_rsa_sign(wp_RsaSigCtx *ctx, unsigned char *sig, size_t *sigLen,
         else {
             ok = 0;
         }
+        wp_arena_end(arena);
+        if (ok) {
+            wp_metrics_record(WP_METRIC_RSA_SIGN, mStart, tbsLen);
+        }
     }
 
     return ok;
@@ -772,8 +797,11 @@ static int wp_rsa_verify_pkcs1(wp_RsaSigCtx *ctx, const unsigned char *sig,
     unsigned char *encodedDigest = NULL;
     int encodedDigestLen = 0;
 
-    rc = wc_RsaSSL_Verify(sig, (word32)sigLen, decryptedSig, (word32)sigLen,
-        wp_rsa_get_key(ctx->rsa));
+    do {
+        rc = wc_RsaSSL_Verify(sig, (word32)sigLen, decryptedSig,
+            (word32)sigLen, wp_rsa_get_key(ctx->rsa));
+    }
+    while (wp_async_pending(&rc, WP_ASYNC_DEV(wp_rsa_get_key(ctx->rsa))));
     if (rc < 0) {
         ok = 0;
     }
@@ -832,9 +860,13 @@ static int wp_rsa_verify_pss(wp_RsaSigCtx *ctx, const unsigned char *sig,
         saltLen = wp_pss_salt_len_to_wc(ctx->saltLen, ctx->hashType,
             wp_rsa_get_key(ctx->rsa), EVP_PKEY_OP_VERIFY);
 
-        rc = wc_RsaPSS_Verify_ex((byte*)sig, (word32)sigLen, decryptedSig,
-            (word32)sigLen, ctx->hashType, ctx->mgf, saltLen,
-            wp_rsa_get_key(ctx->rsa));
+        do {
+            rc = wc_RsaPSS_Verify_ex((byte*)sig, (word32)sigLen, decryptedSig,
+                (word32)sigLen, ctx->hashType, ctx->mgf, saltLen,
+                wp_rsa_get_key(ctx->rsa));
+        }
+        while (wp_async_pending(&rc,
+            WP_ASYNC_DEV(wp_rsa_get_key(ctx->rsa))));
         if (rc < 0) {
             ok = 0;
         }
@@ -870,8 +902,9 @@ static int wp_rsa_verify_no_pad(wp_RsaSigCtx *ctx, const unsigned char *sig,
     int rc;
     word32 len = sigLen;
 
+    /* Public key operation - no random required. */
     rc = wc_RsaDirect((byte*)sig, (word32)sigLen, decryptedSig, &len,
-        wp_rsa_get_key(ctx->rsa), RSA_PUBLIC_DECRYPT, &ctx->rng);
+        wp_rsa_get_key(ctx->rsa), RSA_PUBLIC_DECRYPT, NULL);
     if (rc < 0) {
         ok = 0;
     }
@@ -898,6 +931,7 @@ static int wp_rsa_verify(wp_RsaSigCtx *ctx, const unsigned char *sig,
     size_t sigLen, const unsigned char *tbs, size_t tbsLen)
 {
     int ok = 1;
+    word64 mStart = wp_metrics_start();
 
     if (!wolfssl_prov_is_running()) {
         ok = 0;
@@ -912,6 +946,10 @@ static int wp_rsa_verify(wp_RsaSigCtx *ctx, const unsigned char *sig,
             ok = 0;
         }
         if (ok) {
+            wp_Arena* arena;
+
+            /* wolfCrypt temporaries from thread's arena when configured. */
+            arena = wp_arena_begin();
             if (ctx->padMode == RSA_PKCS1_PADDING) {
                 ok = wp_rsa_verify_pkcs1(ctx, sig, sigLen, tbs, tbsLen,
                     decryptedSig);
@@ -927,8 +965,12 @@ static int wp_rsa_verify(wp_RsaSigCtx *ctx, const unsigned char *sig,
             else {
                 ok = 0;
             }
+            wp_arena_end(arena);
         }
         OPENSSL_free(decryptedSig);
+        if (ok) {
+            wp_metrics_record(WP_METRIC_RSA_VERIFY, mStart, tbsLen);
+        }
     }
 
     return ok;
@@ -1513,6 +1555,31 @@ static int wp_rsa_set_mgf1_digest(wp_RsaSigCtx *ctx, const OSSL_PARAM *p,
     return ok;
 }
 
+/** Index of digest in parameters set. */
+#define WP_RSA_PARAM_DIGEST             0
+/** Index of digest properties in parameters set. */
+#define WP_RSA_PARAM_PROPERTIES         1
+/** Index of padding mode in parameters set. */
+#define WP_RSA_PARAM_PAD_MODE           2
+/** Index of PSS salt length in parameters set. */
+#define WP_RSA_PARAM_PSS_SALTLEN        3
+/** Index of MGF1 digest in parameters set. */
+#define WP_RSA_PARAM_MGF1_DIGEST        4
+/** Index of MGF1 digest properties in parameters set. */
+#define WP_RSA_PARAM_MGF1_PROPERTIES    5
+/** Number of parameters that can be set. */
+#define WP_RSA_PARAM_CNT                6
+
+/** Keys of parameters that can be set, in order of index. */
+static const char* const wp_rsa_param_keys[WP_RSA_PARAM_CNT] = {
+    OSSL_SIGNATURE_PARAM_DIGEST,
+    OSSL_SIGNATURE_PARAM_PROPERTIES,
+    OSSL_SIGNATURE_PARAM_PAD_MODE,
+    OSSL_SIGNATURE_PARAM_PSS_SALTLEN,
+    OSSL_SIGNATURE_PARAM_MGF1_DIGEST,
+    OSSL_SIGNATURE_PARAM_MGF1_PROPERTIES,
+};
+
 /**
  * Sets the parameters to use into RSA signature context object.
  *
@@ -1524,50 +1591,37 @@ static int wp_rsa_set_mgf1_digest(wp_RsaSigCtx *ctx, const OSSL_PARAM *p,
 static int wp_rsa_set_ctx_params(wp_RsaSigCtx *ctx, const OSSL_PARAM params[])
 {
     int ok = 1;
-    const OSSL_PARAM *p;
-    const OSSL_PARAM *propsParam;
+    const OSSL_PARAM *p[WP_RSA_PARAM_CNT];
 
     if (params != NULL) {
-        p = OSSL_PARAM_locate_const(params, OSSL_SIGNATURE_PARAM_DIGEST);
-        if (p != NULL) {
-            propsParam = OSSL_PARAM_locate_const(params,
-                OSSL_SIGNATURE_PARAM_PROPERTIES);
-            ok = wp_rsa_set_digest(ctx, p, propsParam);
+        wp_params_index(params, wp_rsa_param_keys, WP_RSA_PARAM_CNT, p);
+
+        if (p[WP_RSA_PARAM_DIGEST] != NULL) {
+            ok = wp_rsa_set_digest(ctx, p[WP_RSA_PARAM_DIGEST],
+                p[WP_RSA_PARAM_PROPERTIES]);
         }
 
-        if (ok) {
-            p = OSSL_PARAM_locate_const(params, OSSL_SIGNATURE_PARAM_PAD_MODE);
-            if (p != NULL) {
-                ok = wp_rsa_set_pad_mode(ctx, p);
-            }
+        if (ok && (p[WP_RSA_PARAM_PAD_MODE] != NULL)) {
+            ok = wp_rsa_set_pad_mode(ctx, p[WP_RSA_PARAM_PAD_MODE]);
         }
 
-        if (ok) {
-            p = OSSL_PARAM_locate_const(params,
-                OSSL_SIGNATURE_PARAM_PSS_SALTLEN);
-            if (p != NULL) {
-                if (ctx->padMode != RSA_PKCS1_PSS_PADDING) {
-                    ok = 0;
-                }
-                else {
-                    ok = wp_rsa_set_salt_len(ctx, p);
-                }
+        if (ok && (p[WP_RSA_PARAM_PSS_SALTLEN] != NULL)) {
+            if (ctx->padMode != RSA_PKCS1_PSS_PADDING) {
+                ok = 0;
+            }
+            else {
+                ok = wp_rsa_set_salt_len(ctx, p[WP_RSA_PARAM_PSS_SALTLEN]);
             }
         }
 
-        if (ok) {
-            p = OSSL_PARAM_locate_const(params,
-                OSSL_SIGNATURE_PARAM_MGF1_DIGEST);
-            if (p != NULL) {
-                if (ctx->padMode != RSA_PKCS1_PSS_PADDING) {
-                    ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_MGF1_MD);
-                    ok = 0;
-                }
-                else {
-                    propsParam = OSSL_PARAM_locate_const(params,
-                        OSSL_SIGNATURE_PARAM_MGF1_PROPERTIES);
-                    ok = wp_rsa_set_mgf1_digest(ctx, p,propsParam);
-                }
+        if (ok && (p[WP_RSA_PARAM_MGF1_DIGEST] != NULL)) {
+            if (ctx->padMode != RSA_PKCS1_PSS_PADDING) {
+                ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_MGF1_MD);
+                ok = 0;
+            }
+            else {
+                ok = wp_rsa_set_mgf1_digest(ctx, p[WP_RSA_PARAM_MGF1_DIGEST],
+                    p[WP_RSA_PARAM_MGF1_PROPERTIES]);
             }
         }
     }
@@ -32,6 +32,8 @@
 
 /** Maximum supported seed size. */
 #define WP_MAX_SEED_SIZE        256
+/** Length of TLS master secret in bytes. */
+#define WP_TLS1_MASTER_SECRET_LEN   48
 
 /**
  * TLS v1.* PRF context structure.
@@ -51,6 +53,17 @@ typedef struct wp_Tls1Prf_Ctx {
     unsigned char seed[WP_MAX_SEED_SIZE];
     /** Size of label and seed in bytes. */
     size_t seedSz;
+    /** Label and seed for key block when derived with master secret. */
+    unsigned char kbSeed[WP_MAX_SEED_SIZE];
+    /** Size of key block label and seed in bytes. 0 when not combined. */
+    size_t kbSeedSz;
+
+    /** HMAC object to calculate on. Keyed with secret for each operation. */
+    Hmac hmac;
+    /** wolfSSL HMAC type of digest. */
+    int macType;
+    /** Length of HMAC output in bytes. */
+    size_t macLen;
 } wp_Tls1Prf_Ctx;
 
 /* Prototyped for the derive function. */
@@ -71,6 +84,11 @@ static wp_Tls1Prf_Ctx* wp_kdf_tls1_prf_new(WOLFPROV_CTX* provCtx)
     if (wolfssl_prov_is_running()) {
         ctx = OPENSSL_zalloc(sizeof(*ctx));
     }
+    if ((ctx != NULL) &&
+            (wc_HmacInit(&ctx->hmac, NULL, provCtx->devId) != 0)) {
+        OPENSSL_free(ctx);
+        ctx = NULL;
+    }
     if (ctx != NULL) {
         ctx->provCtx = provCtx;
     }
@@ -89,8 +107,9 @@ static void wp_kdf_tls1_prf_clear(wp_Tls1Prf_Ctx* ctx)
     if (ctx->secret != NULL) {
         OPENSSL_clear_free(ctx->secret, ctx->secretSz);
     }
-    /* Clear seed - sensitive data. */
+    /* Clear seeds - sensitive data. */
     OPENSSL_cleanse(ctx->seed, ctx->seedSz);
+    OPENSSL_cleanse(ctx->kbSeed, ctx->kbSeedSz);
 }
 
 /**
@@ -102,6 +121,7 @@ static void wp_kdf_tls1_prf_free(wp_Tls1Prf_Ctx* ctx)
 {
     if (ctx != NULL) {
         wp_kdf_tls1_prf_clear(ctx);
+        wc_HmacFree(&ctx->hmac);
         OPENSSL_free(ctx);
     }
 }
@@ -109,19 +129,191 @@ static void wp_kdf_tls1_prf_free(wp_Tls1Prf_Ctx* ctx)
 /**
  * Reset TLS1 PRF context object.
  *
- * Disposes of allocated data.
+ * Disposes of allocated data. HMAC object is kept for reuse.
  *
  * @param [in, out] ctx  TLS1 PRF context object.
  */
 static void wp_kdf_tls1_prf_reset(wp_Tls1Prf_Ctx* ctx)
 {
     if (ctx != NULL) {
-        WOLFPROV_CTX* provCtx = ctx->provCtx;
-
         wp_kdf_tls1_prf_clear(ctx);
-        XMEMSET(ctx, 0, sizeof(*ctx));
-        ctx->provCtx = provCtx;
+        ctx->mdType = WC_HASH_TYPE_NONE;
+        ctx->secret = NULL;
+        ctx->secretSz = 0;
+        ctx->seedSz = 0;
+        ctx->kbSeedSz = 0;
+    }
+}
+
+/**
+ * Set the HMAC type and output length for the digest.
+ *
+ * @param [in, out] ctx  TLS1 PRF context object.
+ */
+static void wp_kdf_tls1_prf_set_mac(wp_Tls1Prf_Ctx* ctx)
+{
+    ctx->macType = (ctx->mdType == WC_HASH_TYPE_SHA256) ? WC_SHA256 :
+                                                          WC_SHA384;
+    ctx->macLen = (size_t)wc_HmacSizeByType(ctx->macType);
+}
+
+/**
+ * Calculate HMAC with the secret over two pieces of data.
+ *
+ * @param [in, out] ctx     TLS1 PRF context object.
+ * @param [in]      d1      First data. May be NULL when d1Len is 0.
+ * @param [in]      d1Len   Length of first data in bytes.
+ * @param [in]      d2      Second data. May be NULL when d2Len is 0.
+ * @param [in]      d2Len   Length of second data in bytes.
+ * @param [out]     out     Buffer to hold HMAC output. May be d1.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_kdf_tls1_prf_hmac(wp_Tls1Prf_Ctx* ctx, const unsigned char* d1,
+    size_t d1Len, const unsigned char* d2, size_t d2Len, unsigned char* out)
+{
+    int ok = 1;
+    int rc;
+
+    rc = wc_HmacSetKey(&ctx->hmac, ctx->macType, ctx->secret,
+        (word32)ctx->secretSz);
+    if (rc == 0) {
+        rc = wc_HmacUpdate(&ctx->hmac, d1, (word32)d1Len);
+    }
+    if (rc == 0) {
+        rc = wc_HmacUpdate(&ctx->hmac, d2, (word32)d2Len);
+    }
+    if (rc == 0) {
+        rc = wc_HmacFinal(&ctx->hmac, out);
     }
+    if (rc != 0) {
+        ok = 0;
+    }
+
+    return ok;
+}
+
+/**
+ * TLS 1.2 P_hash of the secret.
+ *
+ * See RFC 5246, Section 5.
+ *
+ * @param [in, out] ctx     TLS1 PRF context object.
+ * @param [in]      seed    Label and seed.
+ * @param [in]      seedSz  Length of label and seed in bytes.
+ * @param [out]     out     Buffer to hold output.
+ * @param [in]      outLen  Length of output in bytes.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_kdf_tls1_prf_p_hash(wp_Tls1Prf_Ctx* ctx,
+    const unsigned char* seed, size_t seedSz, unsigned char* out,
+    size_t outLen)
+{
+    int ok;
+    unsigned char a[WC_MAX_DIGEST_SIZE];
+    unsigned char t[WC_MAX_DIGEST_SIZE];
+
+    /* A(1) = HMAC(secret, seed) */
+    ok = wp_kdf_tls1_prf_hmac(ctx, seed, seedSz, NULL, 0, a);
+    while (ok && (outLen > 0)) {
+        size_t len = ctx->macLen;
+
+        /* HMAC(secret, A(i) + seed) */
+        ok = wp_kdf_tls1_prf_hmac(ctx, a, ctx->macLen, seed, seedSz, t);
+        if (ok) {
+            if (len > outLen) {
+                len = outLen;
+            }
+            XMEMCPY(out, t, len);
+            out += len;
+            outLen -= len;
+        }
+        if (ok && (outLen > 0)) {
+            /* A(i+1) = HMAC(secret, A(i)) */
+            ok = wp_kdf_tls1_prf_hmac(ctx, a, ctx->macLen, NULL, 0, a);
+        }
+    }
+
+    OPENSSL_cleanse(a, sizeof(a));
+    OPENSSL_cleanse(t, sizeof(t));
+    return ok;
+}
+
+/**
+ * Calculate PRF of the secret with the label and seed.
+ *
+ * @param [in, out] ctx     TLS1 PRF context object.
+ * @param [in]      seed    Label and seed.
+ * @param [in]      seedSz  Length of label and seed in bytes.
+ * @param [out]     key     Buffer to hold derived key.
+ * @param [in]      keyLen  Length of key to derive in bytes.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_kdf_tls1_prf_calc(wp_Tls1Prf_Ctx* ctx,
+    const unsigned char* seed, size_t seedSz, unsigned char* key,
+    size_t keyLen)
+{
+    int ok = 1;
+
+    if (ctx->mdType == WC_HASH_TYPE_MD5_SHA) {
+        int rc = wc_PRF_TLSv1(key, (word32)keyLen, ctx->secret,
+            (word32)(ctx->secretSz), (byte*)"", 0, seed, (word32)seedSz, NULL,
+            ctx->provCtx->devId);
+        if (rc != 0) {
+            ok = 0;
+        }
+    }
+    else {
+        wp_kdf_tls1_prf_set_mac(ctx);
+        ok = wp_kdf_tls1_prf_p_hash(ctx, seed, seedSz, key, keyLen);
+    }
+
+    return ok;
+}
+
+/**
+ * Derive master secret and key block in one request.
+ *
+ * Output is the master secret followed by the key block. The master secret
+ * becomes the secret and both seeds are consumed so that the Finished
+ * messages can be derived next with only a seed set.
+ *
+ * @param [in, out] ctx     TLS1 PRF context object.
+ * @param [out]     key     Buffer to hold master secret and key block.
+ * @param [in]      keyLen  Length of master secret and key block in bytes.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wp_kdf_tls1_prf_derive_key_block(wp_Tls1Prf_Ctx* ctx,
+    unsigned char* key, size_t keyLen)
+{
+    int ok;
+    unsigned char* ms = NULL;
+
+    ok = wp_kdf_tls1_prf_calc(ctx, ctx->seed, ctx->seedSz, key,
+        WP_TLS1_MASTER_SECRET_LEN);
+    if (ok) {
+        ms = OPENSSL_memdup(key, WP_TLS1_MASTER_SECRET_LEN);
+        if (ms == NULL) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        OPENSSL_clear_free(ctx->secret, ctx->secretSz);
+        ctx->secret = ms;
+        ctx->secretSz = WP_TLS1_MASTER_SECRET_LEN;
+        ok = wp_kdf_tls1_prf_calc(ctx, ctx->kbSeed, ctx->kbSeedSz,
+            key + WP_TLS1_MASTER_SECRET_LEN,
+            keyLen - WP_TLS1_MASTER_SECRET_LEN);
+    }
+
+    OPENSSL_cleanse(ctx->seed, ctx->seedSz);
+    ctx->seedSz = 0;
+    OPENSSL_cleanse(ctx->kbSeed, ctx->kbSeedSz);
+    ctx->kbSeedSz = 0;
+    return ok;
 }
 
 /**
@@ -157,28 +349,15 @@ static int wp_kdf_tls1_prf_derive(wp_Tls1Prf_Ctx* ctx, unsigned char* key,
     if (ok && (keyLen == 0)) {
         ok = 0;
     }
+    if (ok && (ctx->kbSeedSz > 0) && (keyLen <= WP_TLS1_MASTER_SECRET_LEN)) {
+        ok = 0;
+    }
 
-    if (ok) {
-        int rc;
-        if (ctx->mdType == WC_HASH_TYPE_MD5_SHA) {
-            rc = wc_PRF_TLSv1(key, (word32)keyLen, ctx->secret,
-                (word32)(ctx->secretSz), (byte*)"", 0, ctx->seed,
-                (word32)(ctx->seedSz), NULL, INVALID_DEVID);
-            if (rc != 0) {
-                ok = 0;
-            }
-        }
-        else {
-            rc = wc_PRF_TLS(key, (word32)keyLen, ctx->secret,
-                (word32)(ctx->secretSz), (byte*)"", 0, ctx->seed,
-                (word32)(ctx->seedSz), 1,
-                ((ctx->mdType == WC_HASH_TYPE_SHA256) ? sha256_mac :
-                                                        sha384_mac), NULL,
-                INVALID_DEVID);
-            if (rc != 0) {
-                ok = 0;
-            }
-        }
+    if (ok && (ctx->kbSeedSz > 0)) {
+        ok = wp_kdf_tls1_prf_derive_key_block(ctx, key, keyLen);
+    }
+    else if (ok) {
+        ok = wp_kdf_tls1_prf_calc(ctx, ctx->seed, ctx->seedSz, key, keyLen);
     }
 
     return ok;
@@ -232,6 +411,7 @@ static int wp_kdf_tls1_prf_set_ctx_params(wp_Tls1Prf_Ctx* ctx,
     const OSSL_PARAM params[])
 {
     int ok = 1;
+    const OSSL_PARAM* p;
 
     if (params != NULL) {
         if (!wp_params_get_digest(params, NULL, ctx->provCtx->libCtx,
@@ -245,6 +425,17 @@ static int wp_kdf_tls1_prf_set_ctx_params(wp_Tls1Prf_Ctx* ctx,
         if (ok && (!wp_kdf_tls1_prf_get_seed(ctx, params))) {
             ok = 0;
         }
+        p = OSSL_PARAM_locate_const(params, WP_KDF_PARAM_TLS1_KEY_BLOCK_SEED);
+        if (ok && (p != NULL)) {
+            void* q = ctx->kbSeed;
+
+            OPENSSL_cleanse(ctx->kbSeed, ctx->kbSeedSz);
+            ctx->kbSeedSz = 0;
+            if (!OSSL_PARAM_get_octet_string(p, &q, sizeof(ctx->kbSeed),
+                    &ctx->kbSeedSz)) {
+                ok = 0;
+            }
+        }
     }
 
     return ok;
@@ -267,6 +458,7 @@ static const OSSL_PARAM* wp_kdf_tls1_prf_settable_ctx_params(
         OSSL_PARAM_utf8_string(OSSL_KDF_PARAM_DIGEST, NULL, 0),
         OSSL_PARAM_octet_string(OSSL_KDF_PARAM_SECRET, NULL, 0),
         OSSL_PARAM_octet_string(OSSL_KDF_PARAM_SEED, NULL, 0),
+        OSSL_PARAM_octet_string(WP_KDF_PARAM_TLS1_KEY_BLOCK_SEED, NULL, 0),
         OSSL_PARAM_END
     };
     (void)ctx;
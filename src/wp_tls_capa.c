@@ -40,12 +40,24 @@ typedef struct wp_tls_group_consts {
     int maxTls;            /** Maximum TLS version (or 0 for all). */
     int minDtls;           /** Minimum DTLS version, -1 not supported. */
     int maxDtls;           /** Maximum DTLS version (or 0 for all). */
+    unsigned int isKem;    /** Group is a KEM rather than key exchange. */
 } wp_tls_group_consts;
 
 #define WP_ALG_NAME_ECC     "EC"    , 3
 #define WP_ALG_NAME_X25519  "X25519", 7
 #define WP_ALG_NAME_X448    "X448"  , 5
 #define WP_ALG_NAME_DH      "DH"    , 3
+#define WP_ALG_NAME_MLKEM768            "ML-KEM-768"       , 11
+#define WP_ALG_NAME_X25519MLKEM768      "X25519MLKEM768"   , 15
+#define WP_ALG_NAME_SECP256R1MLKEM768   "SecP256r1MLKEM768", 18
+
+/* TLS group ids of ML-KEM and hybrids - draft-ietf-tls-mlkem and
+ * draft-ietf-tls-ecdhe-mlkem. */
+#define WP_TLS_GROUP_MLKEM768           0x0201
+#define WP_TLS_GROUP_SECP256R1MLKEM768  0x11eb
+#define WP_TLS_GROUP_X25519MLKEM768     0x11ec
+
+#define WP_GROUP_KEM        1
 
 #define WP_TLS_12_DOWN      TLS1_VERSION  , TLS1_2_VERSION
 #define WP_TLS_10_UP        TLS1_VERSION  , 0
@@ -87,6 +99,12 @@ static const wp_tls_group_consts wp_group_const_list[35] = {
       WP_TLS_13_UP  , WP_DTLS_NONE    },
     { WOLFSSL_FFDHE_8192         , WP_ALG_NAME_DH    , 192,
       WP_TLS_13_UP  , WP_DTLS_NONE    },
+    { WP_TLS_GROUP_MLKEM768      , WP_ALG_NAME_MLKEM768         , 192,
+      WP_TLS_13_UP  , WP_DTLS_NONE    , WP_GROUP_KEM },
+    { WP_TLS_GROUP_X25519MLKEM768, WP_ALG_NAME_X25519MLKEM768   , 192,
+      WP_TLS_13_UP  , WP_DTLS_NONE    , WP_GROUP_KEM },
+    { WP_TLS_GROUP_SECP256R1MLKEM768, WP_ALG_NAME_SECP256R1MLKEM768, 192,
+      WP_TLS_13_UP  , WP_DTLS_NONE    , WP_GROUP_KEM },
 };
 
 /** Parameters for a group. Index references constant list. */
@@ -111,11 +129,13 @@ static const wp_tls_group_consts wp_group_const_list[35] = {
             (int *)&wp_group_const_list[idx].minDtls),                         \
         OSSL_PARAM_int(OSSL_CAPABILITY_TLS_GROUP_MAX_DTLS,                     \
             (int *)&wp_group_const_list[idx].maxDtls),                         \
+        OSSL_PARAM_uint(OSSL_CAPABILITY_TLS_GROUP_IS_KEM,                      \
+            (unsigned int *)&wp_group_const_list[idx].isKem),                  \
         OSSL_PARAM_END                                                         \
     }
 
 /** List of parameters for TLS groups. */
-static const OSSL_PARAM wp_param_group_list[][10] = {
+static const OSSL_PARAM wp_param_group_list[][11] = {
     WP_TLS_GROUP_ENTRY("secp192r1"      , "prime192v1"     , 0 ),
     WP_TLS_GROUP_ENTRY("P-192"          , "prime192v1"     , 0 ),
     WP_TLS_GROUP_ENTRY("secp224r1"      , "secp224r1"      , 1 ),
@@ -138,6 +158,11 @@ static const OSSL_PARAM wp_param_group_list[][10] = {
     WP_TLS_GROUP_ENTRY("ffdhe4096"      , "ffdhe4096"      , 12),
     WP_TLS_GROUP_ENTRY("ffdhe6144"      , "ffdhe6144"      , 13),
     WP_TLS_GROUP_ENTRY("ffdhe8192"      , "ffdhe8192"      , 14),
+#if defined(WOLFSSL_HAVE_MLKEM) || defined(WOLFSSL_HAVE_KYBER)
+    WP_TLS_GROUP_ENTRY("MLKEM768"       , "ML-KEM-768"     , 15),
+    WP_TLS_GROUP_ENTRY("X25519MLKEM768" , "X25519MLKEM768" , 16),
+    WP_TLS_GROUP_ENTRY("SecP256r1MLKEM768", "SecP256r1MLKEM768", 17),
+#endif
 };
 
 /** Count of supported TLS groups. */
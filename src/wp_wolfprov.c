@@ -20,10 +20,14 @@
 
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <time.h>
 #include <openssl/opensslconf.h>
 #include <openssl/core.h>
 #include <openssl/core_dispatch.h>
 #include <openssl/core_names.h>
+#include <openssl/crypto.h>
 #include <openssl/params.h>
 #include <openssl/prov_ssl.h>
 
@@ -43,6 +47,27 @@ static const OSSL_PARAM wolfssl_param_types[] = {
     OSSL_PARAM_DEFN(OSSL_PROV_PARAM_VERSION, OSSL_PARAM_UTF8_PTR, NULL, 0),
     OSSL_PARAM_DEFN(OSSL_PROV_PARAM_BUILDINFO, OSSL_PARAM_UTF8_PTR, NULL, 0),
     OSSL_PARAM_DEFN(OSSL_PROV_PARAM_STATUS, OSSL_PARAM_INTEGER, NULL, 0),
+    OSSL_PARAM_DEFN(WP_PROV_PARAM_RNG_INST_CNT, OSSL_PARAM_UNSIGNED_INTEGER,
+        NULL, 0),
+    OSSL_PARAM_DEFN(WP_PROV_PARAM_RNG_RESEED_CNT, OSSL_PARAM_UNSIGNED_INTEGER,
+        NULL, 0),
+    OSSL_PARAM_DEFN(WP_PROV_PARAM_POOL_HITS, OSSL_PARAM_UNSIGNED_INTEGER,
+        NULL, 0),
+    OSSL_PARAM_DEFN(WP_PROV_PARAM_POOL_MISSES, OSSL_PARAM_UNSIGNED_INTEGER,
+        NULL, 0),
+    OSSL_PARAM_DEFN(WP_PROV_PARAM_ARENA_ALLOCS, OSSL_PARAM_UNSIGNED_INTEGER,
+        NULL, 0),
+    OSSL_PARAM_DEFN(WP_PROV_PARAM_ARENA_FALLBACKS,
+        OSSL_PARAM_UNSIGNED_INTEGER, NULL, 0),
+    OSSL_PARAM_DEFN(WP_PROV_PARAM_ARENA_ESCAPES, OSSL_PARAM_UNSIGNED_INTEGER,
+        NULL, 0),
+    OSSL_PARAM_DEFN(WP_PROV_PARAM_PBKDF2_CACHE_HITS,
+        OSSL_PARAM_UNSIGNED_INTEGER, NULL, 0),
+    OSSL_PARAM_DEFN(WP_PROV_PARAM_INIT_TIME, OSSL_PARAM_UNSIGNED_INTEGER,
+        NULL, 0),
+    OSSL_PARAM_DEFN(WP_PROV_PARAM_NUMA_REMOTE, OSSL_PARAM_UNSIGNED_INTEGER,
+        NULL, 0),
+    OSSL_PARAM_DEFN(WP_PROV_PARAM_METRICS, OSSL_PARAM_UTF8_STRING, NULL, 0),
     OSSL_PARAM_END
 };
 
@@ -75,7 +100,7 @@ int wolfssl_prov_is_running(void)
 
 WC_RNG* wolfssl_prov_get_rng(WOLFPROV_CTX* provCtx)
 {
-    return &provCtx->rng;
+    return wp_provctx_get_rng(provCtx);
 }
 
 /*
@@ -89,17 +114,42 @@ static WOLFPROV_CTX* wolfssl_prov_ctx_new(void)
     WOLFPROV_CTX* ctx;
 
     ctx = (WOLFPROV_CTX*)OPENSSL_zalloc(sizeof(WOLFPROV_CTX));
-    if ((ctx != NULL) && (wc_InitRng(&ctx->rng) != 0)) {
+    if (ctx != NULL) {
+        ctx->devId = INVALID_DEVID;
+    }
+    if ((ctx != NULL) && (!wp_provctx_rng_init(ctx))) {
         OPENSSL_free(ctx);
         ctx = NULL;
     }
-#ifndef WP_SINGLE_THREADED
-    if ((ctx != NULL) && (wc_InitMutex(&ctx->rng_mutex) != 0)) {
-        wc_FreeRng(&ctx->rng);
+    if ((ctx != NULL) && (!wp_provctx_ecc_fp_init(ctx))) {
+        wp_provctx_rng_free(ctx);
         OPENSSL_free(ctx);
         ctx = NULL;
     }
-#endif
+    if ((ctx != NULL) && (!wp_pool_init())) {
+        wp_provctx_ecc_fp_free(ctx);
+        wp_provctx_rng_free(ctx);
+        OPENSSL_free(ctx);
+        ctx = NULL;
+    }
+    if ((ctx != NULL) && (!wp_metrics_init())) {
+        wp_pool_cleanup();
+        wp_provctx_ecc_fp_free(ctx);
+        wp_provctx_rng_free(ctx);
+        OPENSSL_free(ctx);
+        ctx = NULL;
+    }
+    if ((ctx != NULL) && (!wp_rsa_mp_init())) {
+        wp_metrics_cleanup();
+        wp_pool_cleanup();
+        wp_provctx_ecc_fp_free(ctx);
+        wp_provctx_rng_free(ctx);
+        OPENSSL_free(ctx);
+        ctx = NULL;
+    }
+    if (ctx != NULL) {
+        wp_log_init();
+    }
 
     return ctx;
 }
@@ -111,10 +161,35 @@ static WOLFPROV_CTX* wolfssl_prov_ctx_new(void)
  */
 static void wolfssl_prov_ctx_free(WOLFPROV_CTX* ctx)
 {
-#ifndef WP_SINGLE_THREADED
-    wc_FreeMutex(&ctx->rng_mutex);
+    int i;
+
+    for (i = 0; i <= OSSL_OP__HIGHEST; i++) {
+        OPENSSL_free(ctx->algs[i]);
+    }
+    /* Keys in pool use the provider context - dispose of first. */
+    wp_key_pool_free(ctx);
+    wp_dec_cache_free(ctx);
+    wp_ecc_cache_free(ctx);
+    wp_pbkdf2_cache_free(ctx);
+    if (ctx->seedPool) {
+        wp_seed_pool_cleanup();
+    }
+    wp_rsa_mp_cleanup();
+    wp_metrics_cleanup();
+    wp_pool_cleanup();
+    wp_provctx_ecc_fp_free(ctx);
+    wp_provctx_rng_free(ctx);
+    if (ctx->arena) {
+        /* After all wolfCrypt objects of the context are disposed of. */
+        wp_arena_cleanup();
+    }
+#ifdef WOLFSSL_ASYNC_CRYPT
+    if (ctx->asyncDevOpen) {
+        wolfAsync_DevClose(&ctx->devId);
+    }
 #endif
-    wc_FreeRng(&ctx->rng);
+    /* Last as disposing of objects may log. */
+    wp_log_cleanup();
     OPENSSL_free(ctx);
 }
 
@@ -146,6 +221,199 @@ static void wolfssl_prov_ctx_set0_handle(WOLFPROV_CTX* ctx,
     }
 }
 
+/*
+ * Get a string value from the provider's configuration.
+ *
+ * @param [in] handle  Handle to the core.
+ * @param [in] key     Name of configuration value.
+ * @return  String value owned by the core on success.
+ * @return  NULL when not configured.
+ */
+static const char* wolfssl_prov_conf_get_str(const OSSL_CORE_HANDLE* handle,
+    const char* key)
+{
+    char* str = NULL;
+    OSSL_PARAM params[2];
+
+    params[0] = OSSL_PARAM_construct_utf8_ptr(key, &str, 0);
+    params[1] = OSSL_PARAM_construct_end();
+    if ((c_get_params == NULL) || (!c_get_params(handle, params))) {
+        str = NULL;
+    }
+
+    return str;
+}
+
+/*
+ * Get an integer value from the provider's configuration.
+ *
+ * @param [in]  handle  Handle to the core.
+ * @param [in]  key     Name of configuration value.
+ * @param [out] val     Integer value. Unchanged when not configured.
+ * @return  1 on success.
+ * @return  0 when value is not a number.
+ */
+static int wolfssl_prov_conf_get_int(const OSSL_CORE_HANDLE* handle,
+    const char* key, int* val)
+{
+    int ok = 1;
+    const char* str = wolfssl_prov_conf_get_str(handle, key);
+
+    if (str != NULL) {
+        char* end = NULL;
+        long n = strtol(str, &end, 10);
+
+        if ((end == str) || (*end != '\0') || (n < 0) || (n > INT_MAX)) {
+            ok = 0;
+        }
+        else {
+            *val = (int)n;
+        }
+    }
+
+    return ok;
+}
+
+/*
+ * Apply the provider's configuration from the OpenSSL configuration file.
+ *
+ * @param [in, out] ctx     wolfSSL provider context object.
+ * @param [in]      handle  Handle to the core.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wolfssl_prov_conf(WOLFPROV_CTX* ctx, const OSSL_CORE_HANDLE* handle)
+{
+    int ok = 1;
+    int depth = 0;
+    int rsaDepth = 0;
+    int threads = 1;
+    int decCacheSize = 0;
+    int metrics = 0;
+    int devId = INVALID_DEVID;
+    int asyncDev = 0;
+    int drbgBufSize = 0;
+    int drbgUseAdIn = 0;
+    int seedPool = 0;
+    int arenaSize = 0;
+    int compactKeys = 0;
+    int pbkdf2CacheSize = 0;
+    int pbkdf2CacheTtl = 300;
+
+    if (!wolfssl_prov_conf_get_int(handle, WP_PROV_CONF_KEYGEN_POOL_DEPTH,
+            &depth)) {
+        ok = 0;
+    }
+    if (ok && (!wolfssl_prov_conf_get_int(handle,
+            WP_PROV_CONF_KEYGEN_POOL_RSA_DEPTH, &rsaDepth))) {
+        ok = 0;
+    }
+    if (ok && (!wolfssl_prov_conf_get_int(handle,
+            WP_PROV_CONF_KEYGEN_POOL_THREADS, &threads))) {
+        ok = 0;
+    }
+    if (ok && (!wp_key_pool_init(ctx, depth, rsaDepth, threads))) {
+        ok = 0;
+    }
+    if (ok && (!wolfssl_prov_conf_get_int(handle,
+            WP_PROV_CONF_DECODER_CACHE_SIZE, &decCacheSize))) {
+        ok = 0;
+    }
+    if (ok && (!wp_dec_cache_init(ctx, decCacheSize))) {
+        ok = 0;
+    }
+    if (ok && (!wolfssl_prov_conf_get_int(handle, WP_PROV_CONF_COMPACT_KEYS,
+            &compactKeys))) {
+        ok = 0;
+    }
+    if (ok && (!wp_ecc_cache_init(ctx, compactKeys))) {
+        ok = 0;
+    }
+    if (ok && (!wolfssl_prov_conf_get_int(handle,
+            WP_PROV_CONF_PBKDF2_CACHE_SIZE, &pbkdf2CacheSize))) {
+        ok = 0;
+    }
+    if (ok && (!wolfssl_prov_conf_get_int(handle,
+            WP_PROV_CONF_PBKDF2_CACHE_TTL, &pbkdf2CacheTtl))) {
+        ok = 0;
+    }
+    if (ok && (!wp_pbkdf2_cache_init(ctx, pbkdf2CacheSize, pbkdf2CacheTtl))) {
+        ok = 0;
+    }
+    if (ok && (!wolfssl_prov_conf_get_int(handle, WP_PROV_CONF_METRICS,
+            &metrics))) {
+        ok = 0;
+    }
+    if (ok && (metrics != 0)) {
+        wp_metrics_enable();
+    }
+    if (ok && (!wolfssl_prov_conf_get_int(handle, WP_PROV_CONF_DEVICE_ID,
+            &devId))) {
+        ok = 0;
+    }
+    if (ok) {
+        ctx->devId = devId;
+    }
+    if (ok && (!wolfssl_prov_conf_get_int(handle,
+            WP_PROV_CONF_DRBG_BUFFER_SIZE, &drbgBufSize))) {
+        ok = 0;
+    }
+    if (ok && ((drbgBufSize < 0) || (drbgBufSize > WP_DRBG_MAX_BUF_SIZE))) {
+        ok = 0;
+    }
+    if (ok && (!wolfssl_prov_conf_get_int(handle, WP_PROV_CONF_DRBG_USE_ADIN,
+            &drbgUseAdIn))) {
+        ok = 0;
+    }
+    if (ok) {
+        ctx->drbgBufSize = (size_t)drbgBufSize;
+        ctx->drbgUseAdIn = (drbgUseAdIn != 0);
+    }
+    if (ok && (!wolfssl_prov_conf_get_int(handle, WP_PROV_CONF_SEED_POOL,
+            &seedPool))) {
+        ok = 0;
+    }
+    if (ok && (seedPool != 0)) {
+        if (!wp_seed_pool_init()) {
+            ok = 0;
+        }
+        else {
+            ctx->seedPool = 1;
+        }
+    }
+    if (ok && (!wolfssl_prov_conf_get_int(handle,
+            WP_PROV_CONF_BIGNUM_ARENA_SIZE, &arenaSize))) {
+        ok = 0;
+    }
+    if (ok && (arenaSize != 0)) {
+        if (!wp_arena_init(arenaSize)) {
+            ok = 0;
+        }
+        else {
+            ctx->arena = 1;
+        }
+    }
+    if (ok && (!wolfssl_prov_conf_get_int(handle, WP_PROV_CONF_ASYNC_DEVICE,
+            &asyncDev))) {
+        ok = 0;
+    }
+    if (ok && (asyncDev != 0)) {
+#ifdef WOLFSSL_ASYNC_CRYPT
+        if (wolfAsync_DevOpen(&ctx->devId) != 0) {
+            ok = 0;
+        }
+        else {
+            ctx->asyncDevOpen = 1;
+        }
+#else
+        /* Async crypto not compiled into wolfSSL. */
+        ok = 0;
+#endif
+    }
+
+    return ok;
+}
+
 /*
  * Gets the parameters of the provider.
  *
@@ -159,8 +427,6 @@ static int wolfprov_get_params(void* provCtx, OSSL_PARAM params[])
     int ok = 1;
     OSSL_PARAM* p;
 
-    (void)provCtx;
-
     /* Look for provider name as a parameter to return. */
     p = OSSL_PARAM_locate(params, OSSL_PROV_PARAM_NAME);
     /* Set the string if name requested. */
@@ -194,6 +460,110 @@ static int wolfprov_get_params(void* provCtx, OSSL_PARAM params[])
             ok = 0;
         }
     }
+    if (ok && (provCtx != NULL)) {
+        word32 instCnt = 0;
+        word32 reseedCnt = 0;
+
+        if (!wp_provctx_rng_stats((WOLFPROV_CTX*)provCtx, &instCnt,
+                &reseedCnt)) {
+            ok = 0;
+        }
+        if (ok) {
+            /* Look for RNG instantiation count as a parameter to return. */
+            p = OSSL_PARAM_locate(params, WP_PROV_PARAM_RNG_INST_CNT);
+            if ((p != NULL) && (!OSSL_PARAM_set_uint32(p, instCnt))) {
+                ok = 0;
+            }
+        }
+        if (ok) {
+            /* Look for RNG reseed count as a parameter to return. */
+            p = OSSL_PARAM_locate(params, WP_PROV_PARAM_RNG_RESEED_CNT);
+            if ((p != NULL) && (!OSSL_PARAM_set_uint32(p, reseedCnt))) {
+                ok = 0;
+            }
+        }
+    }
+    if (ok) {
+        word32 hits = 0;
+        word32 misses = 0;
+
+        if (!wp_pool_stats(&hits, &misses)) {
+            ok = 0;
+        }
+        if (ok) {
+            /* Look for context pool hits as a parameter to return. */
+            p = OSSL_PARAM_locate(params, WP_PROV_PARAM_POOL_HITS);
+            if ((p != NULL) && (!OSSL_PARAM_set_uint32(p, hits))) {
+                ok = 0;
+            }
+        }
+        if (ok) {
+            /* Look for context pool misses as a parameter to return. */
+            p = OSSL_PARAM_locate(params, WP_PROV_PARAM_POOL_MISSES);
+            if ((p != NULL) && (!OSSL_PARAM_set_uint32(p, misses))) {
+                ok = 0;
+            }
+        }
+    }
+    if (ok) {
+        word64 allocs = 0;
+        word64 fallbacks = 0;
+        word64 escapes = 0;
+
+        wp_arena_stats(&allocs, &fallbacks, &escapes);
+        /* Look for arena allocation count as a parameter to return. */
+        p = OSSL_PARAM_locate(params, WP_PROV_PARAM_ARENA_ALLOCS);
+        if ((p != NULL) && (!OSSL_PARAM_set_uint64(p, allocs))) {
+            ok = 0;
+        }
+        if (ok) {
+            /* Look for arena fallback count as a parameter to return. */
+            p = OSSL_PARAM_locate(params, WP_PROV_PARAM_ARENA_FALLBACKS);
+            if ((p != NULL) && (!OSSL_PARAM_set_uint64(p, fallbacks))) {
+                ok = 0;
+            }
+        }
+        if (ok) {
+            /* Look for arena escape count as a parameter to return. */
+            p = OSSL_PARAM_locate(params, WP_PROV_PARAM_ARENA_ESCAPES);
+            if ((p != NULL) && (!OSSL_PARAM_set_uint64(p, escapes))) {
+                ok = 0;
+            }
+        }
+    }
+    if (ok && (provCtx != NULL)) {
+        word64 remoteCnt = 0;
+
+        /* Look for NUMA remote access count as a parameter to return. */
+        p = OSSL_PARAM_locate(params, WP_PROV_PARAM_NUMA_REMOTE);
+        if ((p != NULL) && ((!wp_provctx_rng_remote(provCtx, &remoteCnt)) ||
+                (!OSSL_PARAM_set_uint64(p, remoteCnt)))) {
+            ok = 0;
+        }
+    }
+    if (ok && (provCtx != NULL)) {
+        /* Look for PBKDF2 cache hit count as a parameter to return. */
+        p = OSSL_PARAM_locate(params, WP_PROV_PARAM_PBKDF2_CACHE_HITS);
+        if ((p != NULL) && (!OSSL_PARAM_set_uint64(p,
+                wp_pbkdf2_cache_hits((WOLFPROV_CTX*)provCtx)))) {
+            ok = 0;
+        }
+    }
+    if (ok && (provCtx != NULL)) {
+        /* Look for initialization time as a parameter to return. */
+        p = OSSL_PARAM_locate(params, WP_PROV_PARAM_INIT_TIME);
+        if ((p != NULL) && (!OSSL_PARAM_set_uint64(p,
+                ((WOLFPROV_CTX*)provCtx)->initTime))) {
+            ok = 0;
+        }
+    }
+    if (ok) {
+        /* Look for metrics report as a parameter to return. */
+        p = OSSL_PARAM_locate(params, WP_PROV_PARAM_METRICS);
+        if ((p != NULL) && (!wp_metrics_get_param(p))) {
+            ok = 0;
+        }
+    }
     return ok;
 }
 
@@ -244,6 +614,10 @@ static const OSSL_ALGORITHM wolfprov_digests[] = {
       "" },
 
     /* SHAKE */
+#ifdef WOLFSSL_SHAKE128
+    { WP_NAMES_SHAKE_128, WOLFPROV_PROPERTIES, wp_shake_128_functions,
+      "" },
+#endif
     { WP_NAMES_SHAKE_256, WOLFPROV_PROPERTIES, wp_shake_256_functions,
       "" },
 
@@ -276,6 +650,22 @@ static const OSSL_ALGORITHM wolfprov_ciphers[] = {
     { WP_NAMES_AES_128_CBC, WOLFPROV_PROPERTIES, wp_aes128cbc_functions,
       "" },
 
+#if defined(HAVE_AES_CBC) && !defined(NO_HMAC)
+    /* AES-CBC-HMAC - stitched TLS ciphers */
+#ifndef NO_SHA
+    { WP_NAMES_AES_256_CBC_HMAC_SHA1, WOLFPROV_PROPERTIES,
+      wp_aes256cbchmacsha1_functions, "" },
+    { WP_NAMES_AES_128_CBC_HMAC_SHA1, WOLFPROV_PROPERTIES,
+      wp_aes128cbchmacsha1_functions, "" },
+#endif
+#ifndef NO_SHA256
+    { WP_NAMES_AES_256_CBC_HMAC_SHA256, WOLFPROV_PROPERTIES,
+      wp_aes256cbchmacsha256_functions, "" },
+    { WP_NAMES_AES_128_CBC_HMAC_SHA256, WOLFPROV_PROPERTIES,
+      wp_aes128cbchmacsha256_functions, "" },
+#endif
+#endif
+
     /* AES-ECB */
     { WP_NAMES_AES_256_ECB, WOLFPROV_PROPERTIES, wp_aes256ecb_functions,
       "" },
@@ -292,6 +682,20 @@ static const OSSL_ALGORITHM wolfprov_ciphers[] = {
     { WP_NAMES_AES_128_CTR, WOLFPROV_PROPERTIES, wp_aes128ctr_functions,
       "" },
 
+#ifdef WOLFSSL_AES_XTS
+    /* AES-XTS */
+    { WP_NAMES_AES_256_XTS, WOLFPROV_PROPERTIES, wp_aes256xts_functions,
+      "" },
+    { WP_NAMES_AES_128_XTS, WOLFPROV_PROPERTIES, wp_aes128xts_functions,
+      "" },
+#endif
+
+#if defined(HAVE_CHACHA) && defined(HAVE_POLY1305)
+    /* ChaCha20-Poly1305 */
+    { WP_NAMES_CHACHA20_POLY1305, WOLFPROV_PROPERTIES,
+      wp_chacha20_poly1305_functions, "" },
+#endif
+
     /* AES Kwy Wrap - unpadded */
     { WP_NAMES_AES_256_WRAP, WOLFPROV_PROPERTIES, wp_aes256wrap_functions,
       "" },
@@ -325,6 +729,8 @@ static const OSSL_ALGORITHM wolfprov_kdfs[] = {
       "" },
     { WP_NAMES_TLS1_3_KDF, WOLFPROV_PROPERTIES, wp_kdf_tls1_3_kdf_functions,
       "" },
+    { WP_NAMES_TLS13_KEY_SCHEDULE, WOLFPROV_PROPERTIES,
+      wp_kdf_tls13_ks_functions, "" },
     { WP_NAMES_TLS1_PRF, WOLFPROV_PROPERTIES, wp_kdf_tls1_prf_functions,
       "" },
 
@@ -362,6 +768,15 @@ static const OSSL_ALGORITHM wolfprov_keymgmt[] = {
     { WP_NAMES_ED448, WOLFPROV_PROPERTIES, wp_ed448_keymgmt_functions,
       "X448" },
 
+#if defined(WOLFSSL_HAVE_MLKEM) || defined(WOLFSSL_HAVE_KYBER)
+    { WP_NAMES_MLKEM_768, WOLFPROV_PROPERTIES, wp_mlkem768_keymgmt_functions,
+      "ML-KEM-768" },
+    { WP_NAMES_X25519MLKEM768, WOLFPROV_PROPERTIES,
+      wp_x25519mlkem768_keymgmt_functions, "X25519MLKEM768" },
+    { WP_NAMES_SECP256R1MLKEM768, WOLFPROV_PROPERTIES,
+      wp_p256mlkem768_keymgmt_functions, "SecP256r1MLKEM768" },
+#endif
+
     { WP_NAMES_DH, WOLFPROV_PROPERTIES, wp_dh_keymgmt_functions,
       "DH" },
     { WP_NAMES_DHX, WOLFPROV_PROPERTIES, wp_dh_keymgmt_functions,
@@ -432,6 +847,15 @@ static const OSSL_ALGORITHM wolfprov_asym_cipher[] = {
 /* List of asymmetric key encryption mechanicm algorithm implementations
  * available in wolfSSL provider. */
 static const OSSL_ALGORITHM wolfprov_asym_kem[] = {
+#if defined(WOLFSSL_HAVE_MLKEM) || defined(WOLFSSL_HAVE_KYBER)
+    { WP_NAMES_MLKEM_768, WOLFPROV_PROPERTIES, wp_mlkem_kem_functions,
+      "" },
+    { WP_NAMES_X25519MLKEM768, WOLFPROV_PROPERTIES, wp_mlkem_kem_functions,
+      "" },
+    { WP_NAMES_SECP256R1MLKEM768, WOLFPROV_PROPERTIES, wp_mlkem_kem_functions,
+      "" },
+#endif
+
     { NULL, NULL, NULL, NULL }
 };
 
@@ -761,24 +1185,17 @@ static const OSSL_ALGORITHM wolfprov_store[] = {
 };
 
 /*
- * Returns the list of implementations available in wolfSSL provider for an
- * operation.
+ * Returns the full list of implementations available in wolfSSL provider for
+ * an operation.
  *
- * @param [in]  provCtx   Provider context.
- * @param [in]  id        Id of operation.
- * @param [out] no_cache  Set to 0 as all pointers are cacheable.
+ * @param [in] id  Id of operation.
  * @return  NULL on unupported operation.
  * @return  Otherwise a list of implementations for an operation.
  */
-static const OSSL_ALGORITHM* wolfprov_query(void* provCtx, int id,
-        int* no_cache)
+static const OSSL_ALGORITHM* wolfprov_query_all(int id)
 {
     const OSSL_ALGORITHM* alg;
 
-    (void)provCtx;
-
-    *no_cache = 0;
-
     switch (id) {
         case OSSL_OP_DIGEST:
             alg = wolfprov_digests;
@@ -827,6 +1244,123 @@ static const OSSL_ALGORITHM* wolfprov_query(void* provCtx, int id,
     return alg;
 }
 
+/*
+ * Check whether an implementation has one of the names in a list.
+ *
+ * @param [in] names  Colon separated names of implementation.
+ * @param [in] list   Comma separated names to look for.
+ * @return  1 when a name is in the list.
+ * @return  0 otherwise.
+ */
+static int wolfprov_alg_in_list(const char* names, const char* list)
+{
+    int found = 0;
+    const char* name = names;
+
+    while ((!found) && (*name != '\0')) {
+        const char* entry = list;
+        size_t nameLen = strcspn(name, ":");
+
+        while ((!found) && (*entry != '\0')) {
+            size_t entryLen;
+
+            entry += strspn(entry, ", ");
+            entryLen = strcspn(entry, ", ");
+            if ((entryLen == nameLen) && (nameLen > 0) &&
+                    (OPENSSL_strncasecmp(name, entry, nameLen) == 0)) {
+                found = 1;
+            }
+            entry += entryLen;
+        }
+        name += nameLen;
+        if (*name == ':') {
+            name++;
+        }
+    }
+
+    return found;
+}
+
+/*
+ * Build the tables of implementations not disabled by configuration.
+ *
+ * Only operations that have an implementation disabled get a table of their
+ * own. Pruning the tables means OpenSSL never creates method objects for
+ * algorithms that are not wanted from this provider.
+ *
+ * @param [in, out] ctx     wolfSSL provider context object.
+ * @param [in]      handle  Handle to the core.
+ * @return  1 on success.
+ * @return  0 on failure.
+ */
+static int wolfprov_algs_prune(WOLFPROV_CTX* ctx,
+    const OSSL_CORE_HANDLE* handle)
+{
+    int ok = 1;
+    int id;
+    const char* list;
+
+    list = wolfssl_prov_conf_get_str(handle, WP_PROV_CONF_DISABLE_ALGS);
+    for (id = 0; ok && (list != NULL) && (id <= OSSL_OP__HIGHEST); id++) {
+        const OSSL_ALGORITHM* all = wolfprov_query_all(id);
+        size_t cnt = 0;
+        size_t keep = 0;
+        size_t i;
+
+        for (i = 0; (all != NULL) && (all[i].algorithm_names != NULL); i++) {
+            cnt++;
+            if (!wolfprov_alg_in_list(all[i].algorithm_names, list)) {
+                keep++;
+            }
+        }
+        if (keep != cnt) {
+            /* Terminating entry is all NULLs. */
+            ctx->algs[id] = (OSSL_ALGORITHM*)OPENSSL_zalloc(
+                (keep + 1) * sizeof(OSSL_ALGORITHM));
+            if (ctx->algs[id] == NULL) {
+                ok = 0;
+            }
+            for (i = 0, keep = 0; ok && (i < cnt); i++) {
+                if (!wolfprov_alg_in_list(all[i].algorithm_names, list)) {
+                    ctx->algs[id][keep++] = all[i];
+                }
+            }
+        }
+    }
+
+    return ok;
+}
+
+/*
+ * Returns the list of implementations available in wolfSSL provider for an
+ * operation.
+ *
+ * Implementations disabled by configuration are not in the list.
+ *
+ * @param [in]  provCtx   Provider context.
+ * @param [in]  id        Id of operation.
+ * @param [out] no_cache  Set to 0 as all pointers are cacheable.
+ * @return  NULL on unupported operation.
+ * @return  Otherwise a list of implementations for an operation.
+ */
+static const OSSL_ALGORITHM* wolfprov_query(void* provCtx, int id,
+        int* no_cache)
+{
+    const OSSL_ALGORITHM* alg;
+
+    *no_cache = 0;
+
+    if ((id >= 0) && (id <= OSSL_OP__HIGHEST) &&
+            (((WOLFPROV_CTX*)provCtx)->algs[id] != NULL)) {
+        alg = ((WOLFPROV_CTX*)provCtx)->algs[id];
+    }
+    else {
+        alg = wolfprov_query_all(id);
+    }
+
+    return alg;
+}
+
 /*
  * Teardown the provider context.
  *
@@ -863,6 +1397,10 @@ int wolfssl_provider_init(const OSSL_CORE_HANDLE* handle,
 {
     int ok = 1;
     OSSL_FUNC_core_get_libctx_fn* c_get_libctx = NULL;
+    struct timespec start;
+    struct timespec end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
 
     for (; in->function_id != 0; in++) {
         switch (in->function_id) {
@@ -899,8 +1437,21 @@ int wolfssl_provider_init(const OSSL_CORE_HANDLE* handle,
         /* Cache the handle in provider context. */
         wolfssl_prov_ctx_set0_handle(*provCtx, handle);
 
+        if ((!wolfssl_prov_conf(*provCtx, handle)) ||
+                (!wolfprov_algs_prune(*provCtx, handle))) {
+            wolfssl_prov_ctx_free(*provCtx);
+            *provCtx = NULL;
+            ok = 0;
+        }
+    }
+    if (ok) {
         /* Return out dispatch table. */
         *out = wolfprov_dispatch_table;
+
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        ((WOLFPROV_CTX*)*provCtx)->initTime =
+            (word64)(end.tv_sec - start.tv_sec) * 1000000000 +
+            (word64)end.tv_nsec - (word64)start.tv_nsec;
     }
 
     return ok;
@@ -20,6 +20,8 @@
 
 #include "unit.h"
 
+#include <wolfprovider/wp_params.h>
+
 #ifndef EVP_CCM_TLS_FIXED_IV_LEN
 #define EVP_CCM_TLS_FIXED_IV_LEN        EVP_GCM_TLS_FIXED_IV_LEN
 #endif
@@ -665,6 +667,349 @@ int test_aes128_gcm_tls(void *data)
                             EVP_GCM_TLS_FIXED_IV_LEN, 0);
 }
 
+/******************************************************************************/
+
+/* Encrypt two TLS records with one context - explicit IVs must differ. */
+int test_aes128_gcm_tls_records(void *data)
+{
+    int err;
+    EVP_CIPHER_CTX *ctx = NULL;
+    EVP_CIPHER* ocipher;
+    EVP_CIPHER* wcipher;
+    unsigned char aad[EVP_AEAD_TLS1_AAD_LEN] = {0,};
+    unsigned char key[16];
+    unsigned char iv[EVP_GCM_TLS_FIXED_IV_LEN];
+    unsigned char msg[24];
+    unsigned char buf[2][48];
+    int outLen;
+    int i;
+
+    (void)data;
+
+    ocipher = EVP_CIPHER_fetch(osslLibCtx, "AES-128-GCM", "");
+    wcipher = EVP_CIPHER_fetch(wpLibCtx, "AES-128-GCM", "");
+
+    aad[8]  = 23; /* Content type */
+    aad[9]  = 3;  /* Protocol major version */
+    aad[10] = 3;  /* Protocol minor version */
+
+    err = RAND_bytes(key, sizeof(key)) != 1;
+    if (err == 0) {
+        err = RAND_bytes(iv, sizeof(iv)) != 1;
+    }
+    if (err == 0) {
+        err = RAND_bytes(msg, sizeof(msg)) != 1;
+    }
+    if (err == 0) {
+        err = (ctx = EVP_CIPHER_CTX_new()) == NULL;
+    }
+    if (err == 0) {
+        err = EVP_EncryptInit(ctx, wcipher, key, NULL) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_IV_FIXED,
+                                  sizeof(iv), iv) != 1;
+    }
+    for (i = 0; (err == 0) && (i < 2); i++) {
+        PRINT_MSG("Encrypt record with wolfprovider - TLS");
+        memset(buf[i], 0, sizeof(buf[i]));
+        memcpy(buf[i] + EVP_GCM_TLS_EXPLICIT_IV_LEN, msg, sizeof(msg));
+        aad[7] = (unsigned char)i; /* Sequence number */
+        aad[12] = sizeof(buf[i]) - EVP_GCM_TLS_TAG_LEN;
+        err = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_TLS1_AAD,
+                                  EVP_AEAD_TLS1_AAD_LEN, aad) !=
+              EVP_GCM_TLS_TAG_LEN;
+        if (err == 0) {
+            err = EVP_CipherUpdate(ctx, buf[i], &outLen, buf[i],
+                                   sizeof(buf[i])) != 1;
+        }
+        if (err == 0) {
+            err = outLen != (int)sizeof(buf[i]);
+        }
+        if (err == 0) {
+            PRINT_BUFFER("Explicit IV", buf[i], EVP_GCM_TLS_EXPLICIT_IV_LEN);
+        }
+    }
+    if (err == 0) {
+        PRINT_MSG("Check explicit IVs differ");
+        err = memcmp(buf[0], buf[1], EVP_GCM_TLS_EXPLICIT_IV_LEN) == 0;
+    }
+    for (i = 0; (err == 0) && (i < 2); i++) {
+        PRINT_MSG("Decrypt record with OpenSSL - TLS");
+        aad[7] = (unsigned char)i;
+        aad[12] = sizeof(buf[i]);
+        err = test_aes_tag_tls_dec(ocipher, key, iv, sizeof(iv), aad, buf[i],
+                                   sizeof(buf[i]), 0);
+        if (err == 0) {
+            err = memcmp(buf[i] + EVP_GCM_TLS_EXPLICIT_IV_LEN, msg,
+                         sizeof(msg)) != 0;
+        }
+    }
+
+    EVP_CIPHER_CTX_free(ctx);
+    EVP_CIPHER_free(wcipher);
+    EVP_CIPHER_free(ocipher);
+
+    return err;
+}
+
+/******************************************************************************/
+
+/* Encrypt message with AAD and get the tag. */
+static int test_aes_gcm_dup_enc(EVP_CIPHER_CTX *ctx, unsigned char *aad,
+    int aadLen, unsigned char *msg, int len, unsigned char *enc,
+    unsigned char *tag)
+{
+    int err;
+    int outLen;
+
+    err = EVP_EncryptUpdate(ctx, NULL, &outLen, aad, aadLen) != 1;
+    if (err == 0) {
+        err = EVP_EncryptUpdate(ctx, enc, &outLen, msg, len) != 1;
+    }
+    if (err == 0) {
+        err = outLen != len;
+    }
+    if (err == 0) {
+        err = EVP_EncryptFinal_ex(ctx, enc + outLen, &outLen) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG, 16, tag) != 1;
+    }
+
+    return err;
+}
+
+/* Copy of a keyed context encrypts the same as OpenSSL and is independent of
+ * the original. */
+int test_aes128_gcm_dup(void *data)
+{
+    int err;
+    EVP_CIPHER_CTX *ctx = NULL;
+    EVP_CIPHER_CTX *dup = NULL;
+    EVP_CIPHER* ocipher;
+    EVP_CIPHER* wcipher;
+    unsigned char key[16];
+    unsigned char iv[12];
+    unsigned char aad[13];
+    unsigned char msg[40];
+    unsigned char enc[2][40];
+    unsigned char tag[2][16];
+
+    (void)data;
+
+    ocipher = EVP_CIPHER_fetch(osslLibCtx, "AES-128-GCM", "");
+    wcipher = EVP_CIPHER_fetch(wpLibCtx, "AES-128-GCM", "");
+
+    err = RAND_bytes(key, sizeof(key)) != 1;
+    if (err == 0) {
+        err = RAND_bytes(iv, sizeof(iv)) != 1;
+    }
+    if (err == 0) {
+        err = RAND_bytes(aad, sizeof(aad)) != 1;
+    }
+    if (err == 0) {
+        err = RAND_bytes(msg, sizeof(msg)) != 1;
+    }
+    if (err == 0) {
+        PRINT_MSG("Encrypt with OpenSSL");
+        err = (ctx = EVP_CIPHER_CTX_new()) == NULL;
+    }
+    if (err == 0) {
+        err = EVP_EncryptInit(ctx, ocipher, key, iv) != 1;
+    }
+    if (err == 0) {
+        err = test_aes_gcm_dup_enc(ctx, aad, sizeof(aad), msg, sizeof(msg),
+                                   enc[0], tag[0]);
+    }
+    EVP_CIPHER_CTX_free(ctx);
+    ctx = NULL;
+    if (err == 0) {
+        PRINT_MSG("Copy keyed context with wolfprovider");
+        err = (ctx = EVP_CIPHER_CTX_new()) == NULL;
+    }
+    if (err == 0) {
+        err = (dup = EVP_CIPHER_CTX_new()) == NULL;
+    }
+    if (err == 0) {
+        err = EVP_EncryptInit(ctx, wcipher, key, iv) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CIPHER_CTX_copy(dup, ctx) != 1;
+    }
+    if (err == 0) {
+        PRINT_MSG("Encrypt with original and copy");
+        err = test_aes_gcm_dup_enc(ctx, aad, sizeof(aad), msg, sizeof(msg),
+                                   enc[1], tag[1]);
+    }
+    if (err == 0) {
+        err = (memcmp(enc[0], enc[1], sizeof(msg)) != 0) ||
+              (memcmp(tag[0], tag[1], sizeof(tag[0])) != 0);
+    }
+    /* Copy must not depend on original. */
+    EVP_CIPHER_CTX_free(ctx);
+    ctx = NULL;
+    if (err == 0) {
+        memset(enc[1], 0, sizeof(enc[1]));
+        memset(tag[1], 0, sizeof(tag[1]));
+        err = test_aes_gcm_dup_enc(dup, aad, sizeof(aad), msg, sizeof(msg),
+                                   enc[1], tag[1]);
+    }
+    if (err == 0) {
+        err = (memcmp(enc[0], enc[1], sizeof(msg)) != 0) ||
+              (memcmp(tag[0], tag[1], sizeof(tag[0])) != 0);
+    }
+
+    EVP_CIPHER_CTX_free(dup);
+    EVP_CIPHER_CTX_free(ctx);
+    EVP_CIPHER_free(wcipher);
+    EVP_CIPHER_free(ocipher);
+
+    return err;
+}
+
+/******************************************************************************/
+
+/* Encrypt or decrypt message with many updates of varying size. */
+static int test_aes_gcm_stream_crypt(const EVP_CIPHER *cipher, int enc,
+    unsigned char *key, unsigned char *iv, int ivLen, unsigned char *aad,
+    int aadLen, unsigned char *in, int len, unsigned char *out,
+    unsigned char *tag)
+{
+    int err;
+    EVP_CIPHER_CTX *ctx;
+    int outLen;
+    int i;
+    int sz;
+    static const int chunk[] = { 1, 15, 17, 16, 100, 3, 64 };
+
+    err = (ctx = EVP_CIPHER_CTX_new()) == NULL;
+    if (err == 0) {
+        err = EVP_CipherInit(ctx, cipher, NULL, NULL, enc) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_IVLEN, ivLen,
+                                  NULL) != 1;
+    }
+    if ((err == 0) && (!enc)) {
+        err = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_TAG, 16, tag) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CipherInit(ctx, NULL, key, iv, enc) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CipherUpdate(ctx, NULL, &outLen, aad, 5) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CipherUpdate(ctx, NULL, &outLen, aad + 5, aadLen - 5) != 1;
+    }
+    for (i = 0; (err == 0) && (len > 0); i++) {
+        sz = chunk[i % (sizeof(chunk) / sizeof(*chunk))];
+        if (sz > len) {
+            sz = len;
+        }
+        err = EVP_CipherUpdate(ctx, out, &outLen, in, sz) != 1;
+        if ((err == 0) && (outLen != sz)) {
+            err = 1;
+        }
+        in += sz;
+        out += sz;
+        len -= sz;
+    }
+    if (err == 0) {
+        err = EVP_CipherFinal_ex(ctx, out, &outLen) != 1;
+    }
+    if ((err == 0) && enc) {
+        err = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG, 16, tag) != 1;
+    }
+
+    EVP_CIPHER_CTX_free(ctx);
+
+    return err;
+}
+
+/* Streaming GCM with many updates compared against OpenSSL. */
+static int test_aes_gcm_stream(const char *cipher, int keyLen, int ivLen)
+{
+    int err;
+    unsigned char key[32];
+    unsigned char iv[16];
+    unsigned char aad[20];
+    unsigned char msg[1000];
+    unsigned char oEnc[sizeof(msg)];
+    unsigned char wEnc[sizeof(msg)];
+    unsigned char dec[sizeof(msg)];
+    unsigned char oTag[16];
+    unsigned char wTag[16];
+    EVP_CIPHER* ocipher;
+    EVP_CIPHER* wcipher;
+
+    ocipher = EVP_CIPHER_fetch(osslLibCtx, cipher, "");
+    wcipher = EVP_CIPHER_fetch(wpLibCtx, cipher, "");
+
+    err = RAND_bytes(key, keyLen) != 1;
+    if (err == 0) {
+        err = RAND_bytes(iv, ivLen) != 1;
+    }
+    if (err == 0) {
+        err = RAND_bytes(aad, sizeof(aad)) != 1;
+    }
+    if (err == 0) {
+        err = RAND_bytes(msg, sizeof(msg)) != 1;
+    }
+    if (err == 0) {
+        PRINT_MSG("Stream encrypt with OpenSSL");
+        err = test_aes_gcm_stream_crypt(ocipher, 1, key, iv, ivLen, aad,
+                                        sizeof(aad), msg, sizeof(msg), oEnc,
+                                        oTag);
+    }
+    if (err == 0) {
+        PRINT_MSG("Stream encrypt with wolfprovider");
+        err = test_aes_gcm_stream_crypt(wcipher, 1, key, iv, ivLen, aad,
+                                        sizeof(aad), msg, sizeof(msg), wEnc,
+                                        wTag);
+    }
+    if (err == 0) {
+        err = (memcmp(oEnc, wEnc, sizeof(oEnc)) != 0) ||
+              (memcmp(oTag, wTag, sizeof(oTag)) != 0);
+    }
+    if (err == 0) {
+        PRINT_MSG("Stream decrypt with wolfprovider");
+        err = test_aes_gcm_stream_crypt(wcipher, 0, key, iv, ivLen, aad,
+                                        sizeof(aad), wEnc, sizeof(wEnc), dec,
+                                        wTag);
+    }
+    if (err == 0) {
+        err = memcmp(msg, dec, sizeof(msg)) != 0;
+    }
+    if (err == 0) {
+        PRINT_MSG("Stream decrypt with wolfprovider - bad tag");
+        wTag[0] ^= 0x01;
+        err = test_aes_gcm_stream_crypt(wcipher, 0, key, iv, ivLen, aad,
+                                        sizeof(aad), wEnc, sizeof(wEnc), dec,
+                                        wTag) != 1;
+    }
+
+    EVP_CIPHER_free(wcipher);
+    EVP_CIPHER_free(ocipher);
+
+    return err;
+}
+
+int test_aes128_gcm_stream(void *data)
+{
+    int err;
+
+    (void)data;
+
+    err = test_aes_gcm_stream("AES-128-GCM", 16, 12);
+    if (err == 0) {
+        err = test_aes_gcm_stream("AES-256-GCM", 32, 16);
+    }
+
+    return err;
+}
+
 #endif /* WP_HAVE_AESGCM */
 
 /******************************************************************************/
@@ -714,5 +1059,165 @@ int test_aes128_ccm_tls(void *data)
                             EVP_CCM_TLS_FIXED_IV_LEN, 1);
 }
 
+/******************************************************************************/
+
+/* Number of records in TLS batch test. */
+#define TEST_CCM_TLS_BATCH_CNT  3
+
+static int test_aes_ccm_tls_batch_crypt(const EVP_CIPHER *cipher, int enc,
+                                        unsigned char *key, unsigned char *iv,
+                                        unsigned char *aad, unsigned char *buf,
+                                        int len, unsigned char *res)
+{
+    int err;
+    EVP_CIPHER_CTX *ctx;
+    OSSL_PARAM params[2];
+    int outLen;
+
+    err = (ctx = EVP_CIPHER_CTX_new()) == NULL;
+    if (err == 0) {
+        err = EVP_CipherInit(ctx, cipher, NULL, NULL, enc) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_IVLEN, 12, NULL) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_TAG, 16, NULL) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_IV_FIXED,
+                                  EVP_CCM_TLS_FIXED_IV_LEN, iv) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CipherInit(ctx, NULL, key, NULL, enc) != 1;
+    }
+    if (err == 0) {
+        params[0] = OSSL_PARAM_construct_octet_string(
+            WP_CIPHER_PARAM_CCM_TLS_BATCH_AAD, aad,
+            TEST_CCM_TLS_BATCH_CNT * EVP_AEAD_TLS1_AAD_LEN);
+        params[1] = OSSL_PARAM_construct_end();
+        err = EVP_CIPHER_CTX_set_params(ctx, params) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CipherUpdate(ctx, buf, &outLen, buf, len) != 1;
+    }
+    if (err == 0) {
+        err = outLen != len;
+    }
+    if (err == 0) {
+        params[0] = OSSL_PARAM_construct_octet_string(
+            WP_CIPHER_PARAM_CCM_TLS_BATCH_RESULT, res, 1);
+        params[1] = OSSL_PARAM_construct_end();
+        err = EVP_CIPHER_CTX_get_params(ctx, params) != 1;
+    }
+
+    EVP_CIPHER_CTX_free(ctx);
+
+    return err;
+}
+
+int test_aes128_ccm_tls_batch(void *data)
+{
+    int err = 0;
+    static const int dataLen[TEST_CCM_TLS_BATCH_CNT] = { 24, 1, 100 };
+    unsigned char aad[TEST_CCM_TLS_BATCH_CNT][EVP_AEAD_TLS1_AAD_LEN];
+    unsigned char key[16];
+    unsigned char iv[EVP_CCM_TLS_FIXED_IV_LEN];
+    unsigned char msg[200];
+    unsigned char enc[200];
+    unsigned char buf[200];
+    unsigned char res = 0;
+    EVP_CIPHER* ocipher;
+    EVP_CIPHER* wcipher;
+    int off[TEST_CCM_TLS_BATCH_CNT];
+    int recLen;
+    int len = 0;
+    int i;
+
+    (void)data;
+
+    ocipher = EVP_CIPHER_fetch(osslLibCtx, "AES-128-CCM", "");
+    wcipher = EVP_CIPHER_fetch(wpLibCtx, "AES-128-CCM", "");
+
+    memset(aad, 0, sizeof(aad));
+    memset(msg, 0, sizeof(msg));
+    for (i = 0; i < TEST_CCM_TLS_BATCH_CNT; i++) {
+        off[i] = len;
+        len += EVP_CCM_TLS_EXPLICIT_IV_LEN + dataLen[i] + EVP_CCM_TLS_TAG_LEN;
+        aad[i][7]  = i; /* Sequence number */
+        aad[i][8]  = 23; /* Content type */
+        aad[i][9]  = 3;  /* Protocol major version */
+        aad[i][10] = 3;  /* Protocol minor version */
+    }
+
+    if (RAND_bytes(key, sizeof(key)) == 0) {
+        err = 1;
+    }
+    if ((err == 0) && (RAND_bytes(iv, sizeof(iv)) == 0)) {
+        err = 1;
+    }
+    for (i = 0; (err == 0) && (i < TEST_CCM_TLS_BATCH_CNT); i++) {
+        if (RAND_bytes(msg + off[i] + EVP_CCM_TLS_EXPLICIT_IV_LEN,
+                       dataLen[i]) == 0) {
+            err = 1;
+        }
+    }
+
+    PRINT_MSG("Encrypt records with OpenSSL - TLS");
+    memcpy(enc, msg, len);
+    for (i = 0; (err == 0) && (i < TEST_CCM_TLS_BATCH_CNT); i++) {
+        recLen = EVP_CCM_TLS_EXPLICIT_IV_LEN + dataLen[i] +
+                 EVP_CCM_TLS_TAG_LEN;
+        aad[i][12] = recLen - EVP_CCM_TLS_TAG_LEN;
+        err = test_aes_tag_tls_enc(ocipher, key, iv, sizeof(iv), aad[i],
+                                   enc + off[i], recLen, 1);
+    }
+    if (err == 0) {
+        PRINT_MSG("Encrypt batch with wolfprovider - TLS");
+        memcpy(buf, msg, len);
+        err = test_aes_ccm_tls_batch_crypt(wcipher, 1, key, iv, &aad[0][0],
+                                           buf, len, &res);
+    }
+    if ((err == 0) && ((res != 0x07) || (memcmp(buf, enc, len) != 0))) {
+        PRINT_ERR_MSG("Batch encryption doesn't match OpenSSL");
+        err = 1;
+    }
+
+    for (i = 0; i < TEST_CCM_TLS_BATCH_CNT; i++) {
+        aad[i][12] = EVP_CCM_TLS_EXPLICIT_IV_LEN + dataLen[i] +
+                     EVP_CCM_TLS_TAG_LEN;
+    }
+    if (err == 0) {
+        PRINT_MSG("Decrypt batch with wolfprovider - TLS");
+        memcpy(buf, enc, len);
+        err = test_aes_ccm_tls_batch_crypt(wcipher, 0, key, iv, &aad[0][0],
+                                           buf, len, &res);
+    }
+    for (i = 0; (err == 0) && (i < TEST_CCM_TLS_BATCH_CNT); i++) {
+        if ((res != 0x07) || (memcmp(buf + off[i] + EVP_CCM_TLS_EXPLICIT_IV_LEN,
+                msg + off[i] + EVP_CCM_TLS_EXPLICIT_IV_LEN, dataLen[i]) != 0)) {
+            PRINT_ERR_MSG("Batch decryption failed");
+            err = 1;
+        }
+    }
+
+    if (err == 0) {
+        PRINT_MSG("Decrypt batch with corrupted record - TLS");
+        memcpy(buf, enc, len);
+        buf[off[2] - 1] ^= 0x01;
+        err = test_aes_ccm_tls_batch_crypt(wcipher, 0, key, iv, &aad[0][0],
+                                           buf, len, &res);
+    }
+    if ((err == 0) && (res != 0x05)) {
+        PRINT_ERR_MSG("Corrupted record not detected");
+        err = 1;
+    }
+
+    EVP_CIPHER_free(wcipher);
+    EVP_CIPHER_free(ocipher);
+
+    return err;
+}
+
 #endif /* WP_HAVE_AESCCM */
 
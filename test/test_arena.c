@@ -0,0 +1,234 @@
+/* test_arena.c
+ *
+ * Copyright (C) 2021 wolfSSL Inc.
+ *
+ * This file is part of wolfProvider.
+ *
+ * wolfProvider is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfProvider is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wolfProvider.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "unit.h"
+
+#include <pthread.h>
+
+#include <wolfssl/wolfcrypt/memory.h>
+
+#include <wolfprovider/wp_params.h>
+
+#ifdef WP_HAVE_ARENA
+
+/* Number of derivations done by each thread. */
+#define TEST_ARENA_CNT          10
+/* Number of threads deriving in parallel. */
+#define TEST_ARENA_THREADS      4
+
+/* Derive an ECDH secret both ways cnt times and check the secrets match. */
+static int test_arena_ecdh(OSSL_LIB_CTX* libCtx, int cnt)
+{
+    int err = 0;
+    EVP_PKEY* key[2] = { NULL, NULL };
+    EVP_PKEY_CTX* ctx = NULL;
+    unsigned char secret[2][32];
+    size_t secretLen[2];
+    int i;
+    int j;
+
+    for (i = 0; (err == 0) && (i < 2); i++) {
+        err = (key[i] = EVP_PKEY_Q_keygen(libCtx, NULL, "EC", "P-256")) ==
+              NULL;
+    }
+    for (i = 0; (err == 0) && (i < cnt); i++) {
+        for (j = 0; (err == 0) && (j < 2); j++) {
+            secretLen[j] = sizeof(secret[j]);
+            err = (ctx = EVP_PKEY_CTX_new_from_pkey(libCtx, key[j], NULL)) ==
+                  NULL;
+            if (err == 0) {
+                err = EVP_PKEY_derive_init(ctx) != 1;
+            }
+            if (err == 0) {
+                err = EVP_PKEY_derive_set_peer(ctx, key[1 - j]) != 1;
+            }
+            if (err == 0) {
+                err = EVP_PKEY_derive(ctx, secret[j], &secretLen[j]) != 1;
+            }
+            EVP_PKEY_CTX_free(ctx);
+            ctx = NULL;
+        }
+        if (err == 0) {
+            err = (secretLen[0] != secretLen[1]) ||
+                  (memcmp(secret[0], secret[1], secretLen[0]) != 0);
+        }
+    }
+
+    EVP_PKEY_free(key[1]);
+    EVP_PKEY_free(key[0]);
+
+    return err;
+}
+
+/* Data for a thread deriving secrets. */
+typedef struct TEST_ARENA_THREAD {
+    OSSL_LIB_CTX* libCtx;
+    pthread_t thread;
+    int err;
+} TEST_ARENA_THREAD;
+
+/* Thread that derives secrets and exits, disposing of its arena. */
+static void* test_arena_thread(void* arg)
+{
+    TEST_ARENA_THREAD* t = (TEST_ARENA_THREAD*)arg;
+
+    t->err = test_arena_ecdh(t->libCtx, TEST_ARENA_CNT);
+
+    return NULL;
+}
+
+/* Sign and verify with an RSA key cnt times. */
+static int test_arena_rsa(OSSL_LIB_CTX* libCtx, int cnt)
+{
+    int err;
+    EVP_PKEY* pkey = NULL;
+    EVP_MD_CTX* mdCtx = NULL;
+    unsigned char msg[32];
+    unsigned char sig[256];
+    size_t sigLen;
+    int i;
+
+    err = RAND_bytes(msg, sizeof(msg)) != 1;
+    if (err == 0) {
+        err = (pkey = EVP_PKEY_Q_keygen(libCtx, NULL, "RSA", (size_t)2048)) ==
+              NULL;
+    }
+    if (err == 0) {
+        err = (mdCtx = EVP_MD_CTX_new()) == NULL;
+    }
+    for (i = 0; (err == 0) && (i < cnt); i++) {
+        sigLen = sizeof(sig);
+        err = EVP_DigestSignInit_ex(mdCtx, NULL, "SHA256", libCtx, NULL, pkey,
+                                    NULL) != 1;
+        if (err == 0) {
+            err = EVP_DigestSign(mdCtx, sig, &sigLen, msg, sizeof(msg)) != 1;
+        }
+        if (err == 0) {
+            err = EVP_DigestVerifyInit_ex(mdCtx, NULL, "SHA256", libCtx, NULL,
+                                          pkey, NULL) != 1;
+        }
+        if (err == 0) {
+            err = EVP_DigestVerify(mdCtx, sig, sigLen, msg, sizeof(msg)) != 1;
+        }
+    }
+
+    EVP_MD_CTX_free(mdCtx);
+    EVP_PKEY_free(pkey);
+
+    return err;
+}
+
+/* Keep the first provider of the library context. */
+static int test_arena_get_prov(OSSL_PROVIDER* prov, void* arg)
+{
+    *(OSSL_PROVIDER**)arg = prov;
+    return 0;
+}
+
+/* Public key operations with arenas configured - in this thread and in
+ * threads that exit. Unloading restores the wolfSSL allocator callbacks. */
+int test_arena(void *data)
+{
+    int err;
+    OSSL_LIB_CTX* libCtx = NULL;
+    OSSL_PROVIDER* prov = NULL;
+    wolfSSL_Malloc_cb mallocCb = NULL;
+    wolfSSL_Free_cb freeCb = NULL;
+    wolfSSL_Realloc_cb reallocCb = NULL;
+    wolfSSL_Malloc_cb curMallocCb = NULL;
+    wolfSSL_Free_cb curFreeCb = NULL;
+    wolfSSL_Realloc_cb curReallocCb = NULL;
+    TEST_ARENA_THREAD t[TEST_ARENA_THREADS];
+    uint64_t allocs = 0;
+    OSSL_PARAM params[2];
+    int i;
+
+    (void)data;
+
+    err = wolfSSL_GetAllocators(&mallocCb, &freeCb, &reallocCb) != 0;
+    if (err == 0) {
+        PRINT_MSG("Arena size too small fails to load");
+        libCtx = test_conf_libctx("bignum-arena-size = 100");
+        err = libCtx != NULL;
+        OSSL_LIB_CTX_free(libCtx);
+    }
+    if (err == 0) {
+        PRINT_MSG("Load provider with arenas");
+        err = (libCtx = test_conf_libctx("bignum-arena-size = 65536")) ==
+              NULL;
+    }
+    if (err == 0) {
+        PRINT_MSG("RSA sign/verify and ECDH in this thread");
+        err = test_arena_rsa(libCtx, TEST_ARENA_CNT);
+    }
+    if (err == 0) {
+        err = test_arena_ecdh(libCtx, TEST_ARENA_CNT);
+    }
+    if (err == 0) {
+        PRINT_MSG("ECDH in threads that exit");
+        for (i = 0; i < TEST_ARENA_THREADS; i++) {
+            t[i].libCtx = libCtx;
+            t[i].err = 1;
+            if (pthread_create(&t[i].thread, NULL, test_arena_thread,
+                    &t[i]) != 0) {
+                break;
+            }
+        }
+        err = i != TEST_ARENA_THREADS;
+        while (i-- > 0) {
+            pthread_join(t[i].thread, NULL);
+            err |= t[i].err;
+        }
+    }
+    if (err == 0) {
+        PRINT_MSG("Check allocations came from arenas");
+        OSSL_PROVIDER_do_all(libCtx, test_arena_get_prov, &prov);
+        err = prov == NULL;
+    }
+    if (err == 0) {
+        params[0] = OSSL_PARAM_construct_uint64(WP_PROV_PARAM_ARENA_ALLOCS,
+                                                &allocs);
+        params[1] = OSSL_PARAM_construct_end();
+        err = OSSL_PROVIDER_get_params(prov, params) != 1;
+    }
+    if (err == 0) {
+        err = allocs == 0;
+    }
+
+    OSSL_LIB_CTX_free(libCtx);
+
+    if (err == 0) {
+        PRINT_MSG("Check allocator restored when unloaded");
+        err = wolfSSL_GetAllocators(&curMallocCb, &curFreeCb,
+                                    &curReallocCb) != 0;
+    }
+    if (err == 0) {
+        err = (curMallocCb != mallocCb) || (curFreeCb != freeCb) ||
+              (curReallocCb != reallocCb);
+    }
+    if (err == 0) {
+        PRINT_MSG("RSA sign/verify after unload");
+        err = test_arena_rsa(wpLibCtx, 1);
+    }
+
+    return err;
+}
+
+#endif /* WP_HAVE_ARENA */
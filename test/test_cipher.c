@@ -20,6 +20,9 @@
 
 #include "unit.h"
 
+#include <wolfprovider/wp_params.h>
+#include <openssl/hmac.h>
+
 #if defined(WP_HAVE_DES3CBC) || defined(WP_HAVE_AESCBC) || \
     defined(WP_HAVE_AESECB)
 
@@ -532,3 +535,745 @@ int test_aes256_ctr_stream(void *data)
 
 #endif /* WP_HAVE_AESCTR */
 
+
+/******************************************************************************/
+
+#ifdef WP_HAVE_AESXTS
+
+static int test_xts_crypt(EVP_CIPHER *cipher, unsigned char *key,
+    unsigned char *iv, size_t unitSz, unsigned char *in, int len,
+    unsigned char *out, int enc)
+{
+    int err;
+    EVP_CIPHER_CTX *ctx;
+    OSSL_PARAM params[2];
+    int outLen = 0;
+    int fLen = 0;
+
+    params[0] = OSSL_PARAM_construct_size_t(WP_CIPHER_PARAM_XTS_DATA_UNIT_SIZE,
+        &unitSz);
+    params[1] = OSSL_PARAM_construct_end();
+
+    err = (ctx = EVP_CIPHER_CTX_new()) == NULL;
+    if (err == 0) {
+        err = EVP_CipherInit_ex2(ctx, cipher, key, iv, enc,
+            (unitSz > 0) ? params : NULL) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CipherUpdate(ctx, out, &outLen, in, len) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CipherFinal_ex(ctx, out + outLen, &fLen) != 1;
+    }
+    if ((err == 0) && (outLen + fLen != len)) {
+        err = 1;
+    }
+
+    EVP_CIPHER_CTX_free(ctx);
+
+    return err;
+}
+
+static int test_xts_enc_dec(const char *cipher, int keyLen, int len)
+{
+    int err = 0;
+    unsigned char key[64];
+    unsigned char iv[16];
+    unsigned char msg[520];
+    unsigned char enc[sizeof(msg)];
+    unsigned char encExp[sizeof(msg)];
+    unsigned char dec[sizeof(msg)];
+    EVP_CIPHER *ocipher;
+    EVP_CIPHER *wcipher;
+
+    ocipher = EVP_CIPHER_fetch(osslLibCtx, cipher, "");
+    wcipher = EVP_CIPHER_fetch(wpLibCtx, cipher, "");
+
+    if ((RAND_bytes(key, keyLen) != 1) || (RAND_bytes(iv, sizeof(iv)) != 1) ||
+            (RAND_bytes(msg, len) != 1)) {
+        err = 1;
+    }
+
+    if (err == 0) {
+        PRINT_MSG("Encrypt with OpenSSL");
+        err = test_xts_crypt(ocipher, key, iv, 0, msg, len, encExp, 1);
+    }
+    if (err == 0) {
+        PRINT_MSG("Encrypt with wolfprovider");
+        err = test_xts_crypt(wcipher, key, iv, 0, msg, len, enc, 1);
+    }
+    if ((err == 0) && (memcmp(enc, encExp, len) != 0)) {
+        PRINT_BUFFER("Encrypted", enc, len);
+        PRINT_BUFFER("Expected", encExp, len);
+        err = 1;
+    }
+    if (err == 0) {
+        PRINT_MSG("Decrypt with wolfprovider");
+        err = test_xts_crypt(wcipher, key, iv, 0, enc, len, dec, 0);
+    }
+    if ((err == 0) && (memcmp(dec, msg, len) != 0)) {
+        err = 1;
+    }
+
+    EVP_CIPHER_free(wcipher);
+    EVP_CIPHER_free(ocipher);
+
+    return err;
+}
+
+int test_aes128_xts(void *data)
+{
+    int err;
+
+    (void)data;
+
+    err = test_xts_enc_dec("AES-128-XTS", 32, 16);
+    if (err == 0)
+        err = test_xts_enc_dec("AES-128-XTS", 32, 512);
+    if (err == 0)
+        err = test_xts_enc_dec("AES-128-XTS", 32, 517);
+
+    return err;
+}
+
+/******************************************************************************/
+
+int test_aes256_xts(void *data)
+{
+    int err;
+
+    (void)data;
+
+    err = test_xts_enc_dec("AES-256-XTS", 64, 32);
+    if (err == 0)
+        err = test_xts_enc_dec("AES-256-XTS", 64, 512);
+    if (err == 0)
+        err = test_xts_enc_dec("AES-256-XTS", 64, 519);
+
+    return err;
+}
+
+/******************************************************************************/
+
+int test_aes256_xts_data_units(void *data)
+{
+    int err = 0;
+    unsigned char key[64];
+    unsigned char iv[16];
+    unsigned char msg[4 * 512];
+    unsigned char enc[sizeof(msg)];
+    unsigned char encExp[sizeof(msg)];
+    unsigned char dec[sizeof(msg)];
+    EVP_CIPHER *ocipher;
+    EVP_CIPHER *wcipher;
+    int i;
+
+    (void)data;
+
+    ocipher = EVP_CIPHER_fetch(osslLibCtx, "AES-256-XTS", "");
+    wcipher = EVP_CIPHER_fetch(wpLibCtx, "AES-256-XTS", "");
+
+    if ((RAND_bytes(key, sizeof(key)) != 1) ||
+            (RAND_bytes(msg, sizeof(msg)) != 1)) {
+        err = 1;
+    }
+
+    /* Sector 0x1ff - tweak carries into the second byte. */
+    memset(iv, 0, sizeof(iv));
+    iv[0] = 0xfe;
+    iv[1] = 0x01;
+
+    PRINT_MSG("Encrypt each data unit with OpenSSL");
+    for (i = 0; (err == 0) && (i < 4); i++) {
+        err = test_xts_crypt(ocipher, key, iv, 0, msg + i * 512, 512,
+            encExp + i * 512, 1);
+        if (++iv[0] == 0) {
+            iv[1]++;
+        }
+    }
+
+    iv[0] = 0xfe;
+    iv[1] = 0x01;
+    if (err == 0) {
+        PRINT_MSG("Encrypt all data units with wolfprovider");
+        err = test_xts_crypt(wcipher, key, iv, 512, msg, sizeof(msg), enc, 1);
+    }
+    if ((err == 0) && (memcmp(enc, encExp, sizeof(enc)) != 0)) {
+        err = 1;
+    }
+    if (err == 0) {
+        PRINT_MSG("Decrypt all data units with wolfprovider");
+        err = test_xts_crypt(wcipher, key, iv, 512, enc, sizeof(enc), dec, 0);
+    }
+    if ((err == 0) && (memcmp(dec, msg, sizeof(msg)) != 0)) {
+        err = 1;
+    }
+    if (err == 0) {
+        PRINT_MSG("Partial data unit fails");
+        err = test_xts_crypt(wcipher, key, iv, 512, msg, 600, enc, 1) == 0;
+    }
+
+    EVP_CIPHER_free(wcipher);
+    EVP_CIPHER_free(ocipher);
+
+    return err;
+}
+
+/******************************************************************************/
+
+/* Re-initialize for the other direction without a key and in a copy. */
+int test_aes128_xts_reinit(void *data)
+{
+    int err = 0;
+    unsigned char key[32];
+    unsigned char iv[16];
+    unsigned char msg[64];
+    unsigned char enc[sizeof(msg)];
+    unsigned char dec[sizeof(msg)];
+    EVP_CIPHER *cipher;
+    EVP_CIPHER_CTX *ctx = NULL;
+    EVP_CIPHER_CTX *dup = NULL;
+    int outLen;
+
+    (void)data;
+
+    cipher = EVP_CIPHER_fetch(wpLibCtx, "AES-128-XTS", "");
+
+    if ((RAND_bytes(key, sizeof(key)) != 1) ||
+            (RAND_bytes(iv, sizeof(iv)) != 1) ||
+            (RAND_bytes(msg, sizeof(msg)) != 1)) {
+        err = 1;
+    }
+    if (err == 0) {
+        err = (ctx = EVP_CIPHER_CTX_new()) == NULL;
+    }
+    if (err == 0) {
+        err = (dup = EVP_CIPHER_CTX_new()) == NULL;
+    }
+    if (err == 0) {
+        PRINT_MSG("Encrypt with key");
+        err = EVP_CipherInit_ex2(ctx, cipher, key, iv, 1, NULL) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CipherUpdate(ctx, enc, &outLen, msg, sizeof(msg)) != 1;
+    }
+    if (err == 0) {
+        PRINT_MSG("Decrypt in copy without key");
+        err = EVP_CIPHER_CTX_copy(dup, ctx) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CipherInit_ex2(dup, NULL, NULL, iv, 0, NULL) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CipherUpdate(dup, dec, &outLen, enc, sizeof(enc)) != 1;
+    }
+    if ((err == 0) && (memcmp(dec, msg, sizeof(msg)) != 0)) {
+        err = 1;
+    }
+    if (err == 0) {
+        PRINT_MSG("Decrypt without key");
+        err = EVP_CipherInit_ex2(ctx, NULL, NULL, iv, 0, NULL) != 1;
+    }
+    if (err == 0) {
+        memset(dec, 0, sizeof(dec));
+        err = EVP_CipherUpdate(ctx, dec, &outLen, enc, sizeof(enc)) != 1;
+    }
+    if ((err == 0) && (memcmp(dec, msg, sizeof(msg)) != 0)) {
+        err = 1;
+    }
+
+    EVP_CIPHER_CTX_free(dup);
+    EVP_CIPHER_CTX_free(ctx);
+    EVP_CIPHER_free(cipher);
+
+    return err;
+}
+
+#endif /* WP_HAVE_AESXTS */
+
+/******************************************************************************/
+
+#ifdef WP_HAVE_CHACHA20_POLY1305
+
+static int test_chacha20_poly1305_crypt(EVP_CIPHER *cipher, unsigned char *key,
+    unsigned char *iv, unsigned char *aad, int aadLen, unsigned char *in,
+    int len, unsigned char *out, unsigned char *tag, int enc)
+{
+    int err;
+    EVP_CIPHER_CTX *ctx;
+    int outLen = 0;
+    int fLen = 0;
+
+    err = (ctx = EVP_CIPHER_CTX_new()) == NULL;
+    if (err == 0) {
+        err = EVP_CipherInit_ex2(ctx, cipher, key, iv, enc, NULL) != 1;
+    }
+    if ((err == 0) && (!enc)) {
+        err = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_TAG, 16, tag) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CipherUpdate(ctx, NULL, &outLen, aad, aadLen) != 1;
+    }
+    /* Uneven split of data across updates. */
+    if (err == 0) {
+        err = EVP_CipherUpdate(ctx, out, &outLen, in, len / 3) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CipherUpdate(ctx, out + outLen, &fLen, in + outLen,
+            len - outLen) != 1;
+        outLen += fLen;
+    }
+    if (err == 0) {
+        err = EVP_CipherFinal_ex(ctx, out + outLen, &fLen) != 1;
+    }
+    if ((err == 0) && enc) {
+        err = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG, 16, tag) != 1;
+    }
+    if ((err == 0) && (outLen + fLen != len)) {
+        err = 1;
+    }
+
+    EVP_CIPHER_CTX_free(ctx);
+
+    return err;
+}
+
+int test_chacha20_poly1305(void *data)
+{
+    int err = 0;
+    unsigned char key[32];
+    unsigned char iv[12];
+    unsigned char aad[21];
+    unsigned char msg[131];
+    unsigned char enc[sizeof(msg)];
+    unsigned char encExp[sizeof(msg)];
+    unsigned char dec[sizeof(msg)];
+    unsigned char tag[16];
+    unsigned char tagExp[16];
+    EVP_CIPHER *ocipher;
+    EVP_CIPHER *wcipher;
+
+    (void)data;
+
+    ocipher = EVP_CIPHER_fetch(osslLibCtx, "ChaCha20-Poly1305", "");
+    wcipher = EVP_CIPHER_fetch(wpLibCtx, "ChaCha20-Poly1305", "");
+
+    if ((RAND_bytes(key, sizeof(key)) != 1) ||
+            (RAND_bytes(iv, sizeof(iv)) != 1) ||
+            (RAND_bytes(aad, sizeof(aad)) != 1) ||
+            (RAND_bytes(msg, sizeof(msg)) != 1)) {
+        err = 1;
+    }
+
+    if (err == 0) {
+        PRINT_MSG("Encrypt with OpenSSL");
+        err = test_chacha20_poly1305_crypt(ocipher, key, iv, aad, sizeof(aad),
+            msg, sizeof(msg), encExp, tagExp, 1);
+    }
+    if (err == 0) {
+        PRINT_MSG("Encrypt with wolfprovider");
+        err = test_chacha20_poly1305_crypt(wcipher, key, iv, aad, sizeof(aad),
+            msg, sizeof(msg), enc, tag, 1);
+    }
+    if ((err == 0) && ((memcmp(enc, encExp, sizeof(enc)) != 0) ||
+            (memcmp(tag, tagExp, sizeof(tag)) != 0))) {
+        PRINT_BUFFER("Encrypted", enc, sizeof(enc));
+        PRINT_BUFFER("Expected", encExp, sizeof(encExp));
+        err = 1;
+    }
+    if (err == 0) {
+        PRINT_MSG("Decrypt with wolfprovider");
+        err = test_chacha20_poly1305_crypt(wcipher, key, iv, aad, sizeof(aad),
+            enc, sizeof(enc), dec, tag, 0);
+    }
+    if ((err == 0) && (memcmp(dec, msg, sizeof(msg)) != 0)) {
+        err = 1;
+    }
+    if (err == 0) {
+        PRINT_MSG("Decrypt with bad tag fails");
+        tag[0] ^= 0x01;
+        err = test_chacha20_poly1305_crypt(wcipher, key, iv, aad, sizeof(aad),
+            enc, sizeof(enc), dec, tag, 0) == 0;
+    }
+
+    EVP_CIPHER_free(wcipher);
+    EVP_CIPHER_free(ocipher);
+
+    return err;
+}
+
+/******************************************************************************/
+
+static int test_chacha20_poly1305_tls_record(EVP_CIPHER *cipher,
+    unsigned char *key, unsigned char *fixedIv, unsigned char *aad,
+    unsigned char *buf, int len, int *outLen, int enc)
+{
+    int err;
+    EVP_CIPHER_CTX *ctx;
+    OSSL_PARAM params[2];
+
+    err = (ctx = EVP_CIPHER_CTX_new()) == NULL;
+    if (err == 0) {
+        err = EVP_CipherInit_ex2(ctx, cipher, key, NULL, enc, NULL) != 1;
+    }
+    if (err == 0) {
+        params[0] = OSSL_PARAM_construct_octet_string(
+            OSSL_CIPHER_PARAM_AEAD_TLS1_IV_FIXED, fixedIv, 12);
+        params[1] = OSSL_PARAM_construct_end();
+        err = EVP_CIPHER_CTX_set_params(ctx, params) != 1;
+    }
+    if (err == 0) {
+        params[0] = OSSL_PARAM_construct_octet_string(
+            OSSL_CIPHER_PARAM_AEAD_TLS1_AAD, aad, EVP_AEAD_TLS1_AAD_LEN);
+        params[1] = OSSL_PARAM_construct_end();
+        err = EVP_CIPHER_CTX_set_params(ctx, params) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CipherUpdate(ctx, buf, outLen, buf, len) != 1;
+    }
+
+    EVP_CIPHER_CTX_free(ctx);
+
+    return err;
+}
+
+int test_chacha20_poly1305_tls(void *data)
+{
+    int err = 0;
+    unsigned char key[32];
+    unsigned char fixedIv[12];
+    unsigned char aad[EVP_AEAD_TLS1_AAD_LEN];
+    unsigned char msg[73];
+    unsigned char buf[sizeof(msg) + 16];
+    unsigned char bufExp[sizeof(msg) + 16];
+    int outLen = 0;
+    EVP_CIPHER *ocipher;
+    EVP_CIPHER *wcipher;
+
+    (void)data;
+
+    ocipher = EVP_CIPHER_fetch(osslLibCtx, "ChaCha20-Poly1305", "");
+    wcipher = EVP_CIPHER_fetch(wpLibCtx, "ChaCha20-Poly1305", "");
+
+    if ((RAND_bytes(key, sizeof(key)) != 1) ||
+            (RAND_bytes(fixedIv, sizeof(fixedIv)) != 1) ||
+            (RAND_bytes(msg, sizeof(msg)) != 1)) {
+        err = 1;
+    }
+    /* Sequence number, record type, version and plaintext length. */
+    memset(aad, 0, sizeof(aad));
+    aad[7] = 0x05;
+    aad[8] = 0x17;
+    aad[9] = 0x03;
+    aad[10] = 0x03;
+    aad[11] = 0;
+    aad[12] = sizeof(msg);
+
+    if (err == 0) {
+        PRINT_MSG("Encrypt TLS record with OpenSSL");
+        memcpy(bufExp, msg, sizeof(msg));
+        err = test_chacha20_poly1305_tls_record(ocipher, key, fixedIv, aad,
+            bufExp, sizeof(bufExp), &outLen, 1);
+    }
+    if (err == 0) {
+        PRINT_MSG("Encrypt TLS record with wolfprovider");
+        memcpy(buf, msg, sizeof(msg));
+        err = test_chacha20_poly1305_tls_record(wcipher, key, fixedIv, aad,
+            buf, sizeof(buf), &outLen, 1);
+    }
+    if ((err == 0) && ((outLen != (int)sizeof(buf)) ||
+            (memcmp(buf, bufExp, sizeof(buf)) != 0))) {
+        err = 1;
+    }
+    if (err == 0) {
+        PRINT_MSG("Decrypt TLS record with wolfprovider");
+        aad[12] = sizeof(buf);
+        err = test_chacha20_poly1305_tls_record(wcipher, key, fixedIv, aad,
+            buf, sizeof(buf), &outLen, 0);
+    }
+    if ((err == 0) && ((outLen != (int)sizeof(msg)) ||
+            (memcmp(buf, msg, sizeof(msg)) != 0))) {
+        err = 1;
+    }
+    if (err == 0) {
+        PRINT_MSG("Decrypt TLS record with bad tag fails");
+        memcpy(buf, bufExp, sizeof(buf));
+        buf[sizeof(buf) - 1] ^= 0x80;
+        err = test_chacha20_poly1305_tls_record(wcipher, key, fixedIv, aad,
+            buf, sizeof(buf), &outLen, 0) == 0;
+    }
+
+    EVP_CIPHER_free(wcipher);
+    EVP_CIPHER_free(ocipher);
+
+    return err;
+}
+
+#endif /* WP_HAVE_CHACHA20_POLY1305 */
+
+/******************************************************************************/
+
+static int test_wrap_crypt(EVP_CIPHER *cipher, unsigned char *key,
+    size_t itemSz, unsigned char *in, int len, unsigned char *out, int *outLen,
+    int enc, unsigned char *res, size_t resSz)
+{
+    int err;
+    EVP_CIPHER_CTX *ctx;
+    OSSL_PARAM params[2];
+
+    params[0] = OSSL_PARAM_construct_size_t(
+        WP_CIPHER_PARAM_WRAP_BATCH_ITEM_SIZE, &itemSz);
+    params[1] = OSSL_PARAM_construct_end();
+
+    err = (ctx = EVP_CIPHER_CTX_new()) == NULL;
+    if (err == 0) {
+        EVP_CIPHER_CTX_set_flags(ctx, EVP_CIPHER_CTX_FLAG_WRAP_ALLOW);
+        err = EVP_CipherInit_ex2(ctx, cipher, key, NULL, enc,
+            (itemSz > 0) ? params : NULL) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CipherUpdate(ctx, out, outLen, in, len) != 1;
+    }
+    if ((err == 0) && (res != NULL)) {
+        params[0] = OSSL_PARAM_construct_octet_string(
+            WP_CIPHER_PARAM_WRAP_BATCH_RESULT, res, resSz);
+        err = EVP_CIPHER_CTX_get_params(ctx, params) != 1;
+    }
+
+    EVP_CIPHER_CTX_free(ctx);
+
+    return err;
+}
+
+int test_aes128_wrap_batch(void *data)
+{
+    int err = 0;
+    unsigned char kek[16];
+    unsigned char keys[20 * 32];
+    unsigned char wrapExp[20 * 40];
+    unsigned char wrapped[20 * 40];
+    unsigned char unwrapped[20 * 32];
+    unsigned char res[3];
+    EVP_CIPHER *ocipher;
+    EVP_CIPHER *wcipher;
+    int outLen;
+    int i;
+
+    (void)data;
+
+    ocipher = EVP_CIPHER_fetch(osslLibCtx, "AES-128-WRAP", "");
+    wcipher = EVP_CIPHER_fetch(wpLibCtx, "AES-128-WRAP", "");
+
+    if ((RAND_bytes(kek, sizeof(kek)) != 1) ||
+            (RAND_bytes(keys, sizeof(keys)) != 1)) {
+        err = 1;
+    }
+
+    PRINT_MSG("Wrap each key with OpenSSL");
+    for (i = 0; (err == 0) && (i < 20); i++) {
+        err = test_wrap_crypt(ocipher, kek, 0, keys + i * 32, 32,
+            wrapExp + i * 40, &outLen, 1, NULL, 0);
+        if ((err == 0) && (outLen != 40)) {
+            err = 1;
+        }
+    }
+
+    if (err == 0) {
+        PRINT_MSG("Wrap batch of keys with wolfprovider");
+        err = test_wrap_crypt(wcipher, kek, 32, keys, sizeof(keys), wrapped,
+            &outLen, 1, NULL, 0);
+    }
+    if ((err == 0) && ((outLen != (int)sizeof(wrapped)) ||
+            (memcmp(wrapped, wrapExp, sizeof(wrapped)) != 0))) {
+        err = 1;
+    }
+
+    if (err == 0) {
+        PRINT_MSG("Unwrap batch of keys with one corrupted with wolfprovider");
+        wrapped[7 * 40 + 3] ^= 0x01;
+        err = test_wrap_crypt(wcipher, kek, 32, wrapped, sizeof(wrapped),
+            unwrapped, &outLen, 0, res, sizeof(res));
+    }
+    if ((err == 0) && (outLen != (int)sizeof(unwrapped))) {
+        err = 1;
+    }
+    for (i = 0; (err == 0) && (i < 20); i++) {
+        int ok = (res[i / 8] >> (i % 8)) & 1;
+
+        if (ok != (i != 7)) {
+            PRINT_ERR_MSG("Batch result wrong");
+            err = 1;
+        }
+        else if (ok && (memcmp(unwrapped + i * 32, keys + i * 32, 32) != 0)) {
+            PRINT_ERR_MSG("Unwrapped key wrong");
+            err = 1;
+        }
+    }
+
+    EVP_CIPHER_free(wcipher);
+    EVP_CIPHER_free(ocipher);
+
+    return err;
+}
+
+/******************************************************************************/
+
+#if defined(WP_HAVE_AESCBC) && defined(WP_HAVE_HMAC) && defined(WP_HAVE_SHA256)
+
+static int test_cbc_hmac_tls_crypt(EVP_CIPHER *cipher, unsigned char *key,
+    unsigned char *iv, unsigned char *macKey, unsigned char *aad,
+    unsigned char *rec, int len, int *outLen, int enc)
+{
+    int err;
+    EVP_CIPHER_CTX *ctx;
+    OSSL_PARAM params[2];
+    int ver = TLS1_2_VERSION;
+    int pad = 0;
+
+    params[0] = OSSL_PARAM_construct_int(OSSL_CIPHER_PARAM_TLS_VERSION, &ver);
+    params[1] = OSSL_PARAM_construct_end();
+
+    err = (ctx = EVP_CIPHER_CTX_new()) == NULL;
+    if (err == 0) {
+        err = EVP_CipherInit_ex(ctx, cipher, NULL, key, iv, enc) != 1;
+    }
+    if (err == 0) {
+        /* Set as libssl does. */
+        err = EVP_CIPHER_CTX_set_params(ctx, params) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_MAC_KEY, 32,
+            macKey) <= 0;
+    }
+    if (err == 0) {
+        pad = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_TLS1_AAD,
+            EVP_AEAD_TLS1_AAD_LEN, aad);
+        err = pad <= 0;
+    }
+    if (err == 0) {
+        if (enc) {
+            len += pad;
+        }
+        err = EVP_CipherUpdate(ctx, rec, outLen, rec, len) != 1;
+    }
+
+    EVP_CIPHER_CTX_free(ctx);
+
+    return err;
+}
+
+int test_aes128_cbc_hmac_sha256_tls(void *data)
+{
+    int err = 0;
+    unsigned char key[16];
+    unsigned char iv[16];
+    unsigned char macKey[32];
+    unsigned char aad[EVP_AEAD_TLS1_AAD_LEN] = {0,};
+    unsigned char msg[AES_BLOCK_SIZE + 100];
+    unsigned char rec[sizeof(msg) + 32 + AES_BLOCK_SIZE];
+    unsigned char dec[sizeof(rec)];
+    unsigned char macData[sizeof(aad) + sizeof(msg)];
+    unsigned char mac[32];
+    unsigned int macLen = 0;
+    size_t payloadLen = sizeof(msg) - AES_BLOCK_SIZE;
+    EVP_CIPHER *ocipher;
+    EVP_CIPHER *wcipher;
+    EVP_CIPHER_CTX *ctx = NULL;
+    int recLen = 0;
+    int outLen = 0;
+    int pad;
+    int i;
+
+    (void)data;
+
+    ocipher = EVP_CIPHER_fetch(osslLibCtx, "AES-128-CBC", "");
+    wcipher = EVP_CIPHER_fetch(wpLibCtx, "AES-128-CBC-HMAC-SHA256", "");
+
+    aad[7]  = 1;  /* Sequence number */
+    aad[8]  = 23; /* Content type */
+    aad[9]  = 3;  /* Protocol major version */
+    aad[10] = 3;  /* Protocol minor version */
+    aad[11] = (unsigned char)(sizeof(msg) >> 8);
+    aad[12] = (unsigned char)sizeof(msg);
+
+    if ((RAND_bytes(key, sizeof(key)) != 1) ||
+            (RAND_bytes(iv, sizeof(iv)) != 1) ||
+            (RAND_bytes(macKey, sizeof(macKey)) != 1) ||
+            (RAND_bytes(msg, sizeof(msg)) != 1)) {
+        err = 1;
+    }
+
+    if (err == 0) {
+        PRINT_MSG("Encrypt TLS record with wolfprovider");
+        memcpy(rec, msg, sizeof(msg));
+        err = test_cbc_hmac_tls_crypt(wcipher, key, iv, macKey, aad, rec,
+            sizeof(msg), &recLen, 1);
+    }
+    if ((err == 0) && ((recLen % AES_BLOCK_SIZE) != 0)) {
+        err = 1;
+    }
+
+    if (err == 0) {
+        PRINT_MSG("Decrypt with OpenSSL and check MAC and padding");
+        err = (ctx = EVP_CIPHER_CTX_new()) == NULL;
+    }
+    if (err == 0) {
+        err = EVP_DecryptInit_ex(ctx, ocipher, NULL, key, iv) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CIPHER_CTX_set_padding(ctx, 0) != 1;
+    }
+    if (err == 0) {
+        err = EVP_DecryptUpdate(ctx, dec, &outLen, rec, recLen) != 1;
+    }
+    EVP_CIPHER_CTX_free(ctx);
+    if (err == 0) {
+        /* MAC is over header with payload length - no explicit IV. */
+        memcpy(macData, aad, sizeof(aad));
+        macData[11] = (unsigned char)(payloadLen >> 8);
+        macData[12] = (unsigned char)payloadLen;
+        memcpy(macData + sizeof(aad), msg + AES_BLOCK_SIZE, payloadLen);
+        err = HMAC(EVP_sha256(), macKey, sizeof(macKey), macData,
+            sizeof(aad) + payloadLen, mac, &macLen) == NULL;
+    }
+    if (err == 0) {
+        pad = dec[recLen - 1];
+        if ((recLen != (int)sizeof(msg) + 32 + pad + 1) ||
+                (memcmp(dec + AES_BLOCK_SIZE, msg + AES_BLOCK_SIZE,
+                    payloadLen) != 0) ||
+                (memcmp(dec + sizeof(msg), mac, sizeof(mac)) != 0)) {
+            err = 1;
+        }
+        for (i = recLen - pad - 1; (err == 0) && (i < recLen); i++) {
+            err = dec[i] != pad;
+        }
+    }
+
+    if (err == 0) {
+        PRINT_MSG("Decrypt TLS record with wolfprovider");
+        aad[11] = (unsigned char)(recLen >> 8);
+        aad[12] = (unsigned char)recLen;
+        memcpy(dec, rec, recLen);
+        err = test_cbc_hmac_tls_crypt(wcipher, key, iv, macKey, aad, dec,
+            recLen, &outLen, 0);
+    }
+    if ((err == 0) && ((outLen != (int)payloadLen) ||
+            (memcmp(dec + AES_BLOCK_SIZE, msg + AES_BLOCK_SIZE,
+                payloadLen) != 0))) {
+        err = 1;
+    }
+
+    if (err == 0) {
+        PRINT_MSG("Corrupted TLS record fails with wolfprovider");
+        rec[recLen - AES_BLOCK_SIZE - 1] ^= 0x01;
+        err = test_cbc_hmac_tls_crypt(wcipher, key, iv, macKey, aad, rec,
+            recLen, &outLen, 0) == 0;
+    }
+
+    EVP_CIPHER_free(wcipher);
+    EVP_CIPHER_free(ocipher);
+
+    return err;
+}
+
+#endif /* WP_HAVE_AESCBC && WP_HAVE_HMAC && WP_HAVE_SHA256 */
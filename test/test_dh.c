@@ -20,6 +20,8 @@
 
 #include "unit.h"
 
+#include <openssl/core_names.h>
+
 #ifdef WP_HAVE_DH
 
 /* dh1024 p */
@@ -217,4 +219,50 @@ int test_dh_pkey(void *data)
     return err;
 }
 
+int test_dh_named_group(void *data)
+{
+    int err;
+    EVP_PKEY_CTX *ctx = NULL;
+    EVP_PKEY *key = NULL;
+    BIGNUM *priv = NULL;
+    OSSL_PARAM *params = NULL;
+    OSSL_PARAM *p;
+
+    (void)data;
+
+    PRINT_MSG("Generate DH key pair for named group with wolfProvider");
+    err = (ctx = EVP_PKEY_CTX_new_from_name(wpLibCtx, "DH", NULL)) == NULL;
+    if (err == 0) {
+        err = EVP_PKEY_keygen_init(ctx) != 1;
+    }
+    if (err == 0) {
+        err = EVP_PKEY_CTX_set_group_name(ctx, "ffdhe2048") != 1;
+    }
+    if (err == 0) {
+        err = EVP_PKEY_keygen(ctx, &key) != 1;
+    }
+    if (err == 0) {
+        PRINT_MSG("Check private key is a short exponent");
+        err = EVP_PKEY_todata(key, EVP_PKEY_KEYPAIR, &params) != 1;
+    }
+    if (err == 0) {
+        p = OSSL_PARAM_locate(params, OSSL_PKEY_PARAM_PRIV_KEY);
+        err = (p == NULL) || (OSSL_PARAM_get_BN(p, &priv) != 1);
+    }
+    if (err == 0) {
+        err = BN_num_bits(priv) != 225;
+    }
+
+    if (err == 0) {
+        err = test_dh_pkey_keygen(key);
+    }
+
+    BN_free(priv);
+    OSSL_PARAM_free(params);
+    EVP_PKEY_free(key);
+    EVP_PKEY_CTX_free(ctx);
+
+    return err;
+}
+
 #endif /* WP_HAVE_DH */
@@ -20,6 +20,9 @@
 
 #include "unit.h"
 
+#include <wolfprovider/wp_params.h>
+#include <wolfprovider/internal.h>
+
 #ifdef WP_HAVE_DIGEST
 
 int test_digest_op(const EVP_MD *md, unsigned char *msg, size_t len,
@@ -149,6 +152,147 @@ int test_sha512(void *data)
 
 /******************************************************************************/
 
+#if defined(WP_HAVE_SHA256) || defined(WP_HAVE_SHA512)
+static int test_digest_batch(const char *name)
+{
+    int err = 0;
+    static const size_t lens[] = { 0, 1, 55, 64, 4096, 1000 };
+    unsigned char msgs[sizeof(lens) / sizeof(*lens) * 4 + 6000];
+    unsigned char digests[sizeof(lens) / sizeof(*lens) * 64];
+    unsigned char digest[64];
+    unsigned int dLen;
+    size_t cnt = sizeof(lens) / sizeof(*lens);
+    size_t idx = 0;
+    size_t i;
+    unsigned char *msg[sizeof(lens) / sizeof(*lens)];
+    EVP_MD_CTX *ctx = NULL;
+    OSSL_PARAM params[3];
+    EVP_MD *omd;
+    EVP_MD *wmd;
+
+    omd = EVP_MD_fetch(osslLibCtx, name, "");
+    wmd = EVP_MD_fetch(wpLibCtx, name, "");
+
+    for (i = 0; (err == 0) && (i < cnt); i++) {
+        msgs[idx++] = (unsigned char)(lens[i] >> 24);
+        msgs[idx++] = (unsigned char)(lens[i] >> 16);
+        msgs[idx++] = (unsigned char)(lens[i] >>  8);
+        msgs[idx++] = (unsigned char)(lens[i] >>  0);
+        msg[i] = msgs + idx;
+        if ((lens[i] > 0) && (RAND_bytes(msgs + idx, (int)lens[i]) != 1)) {
+            err = 1;
+        }
+        idx += lens[i];
+    }
+
+    if (err == 0) {
+        err = (ctx = EVP_MD_CTX_new()) == NULL;
+    }
+    if (err == 0) {
+        err = EVP_DigestInit_ex(ctx, wmd, NULL) != 1;
+    }
+    if (err == 0) {
+        PRINT_MSG("Digest batch with wolfprovider");
+        params[0] = OSSL_PARAM_construct_octet_string(
+            WP_DIGEST_PARAM_BATCH_MSGS, msgs, idx);
+        params[1] = OSSL_PARAM_construct_octet_string(
+            WP_DIGEST_PARAM_BATCH_DIGESTS, digests, sizeof(digests));
+        params[2] = OSSL_PARAM_construct_end();
+        err = EVP_MD_CTX_get_params(ctx, params) != 1;
+    }
+    if ((err == 0) && (params[1].return_size !=
+            cnt * (size_t)EVP_MD_get_size(wmd))) {
+        err = 1;
+    }
+    for (i = 0; (err == 0) && (i < cnt); i++) {
+        PRINT_MSG("Digest message with OpenSSL");
+        err = EVP_Digest(msg[i], lens[i], digest, &dLen, omd, NULL) != 1;
+        if ((err == 0) && (memcmp(digests + i * dLen, digest, dLen) != 0)) {
+            PRINT_ERR_MSG("Digests don't match");
+            err = 1;
+        }
+    }
+    if (err == 0) {
+        PRINT_MSG("Truncated batch fails");
+        params[0] = OSSL_PARAM_construct_octet_string(
+            WP_DIGEST_PARAM_BATCH_MSGS, msgs, idx - 1);
+        err = EVP_MD_CTX_get_params(ctx, params) == 1;
+    }
+
+    EVP_MD_CTX_free(ctx);
+    EVP_MD_free(wmd);
+    EVP_MD_free(omd);
+
+    return err;
+}
+#endif
+
+#ifdef WP_HAVE_SHA256
+int test_sha256_batch(void *data)
+{
+    (void)data;
+    return test_digest_batch("SHA256");
+}
+#endif
+
+#ifdef WP_HAVE_SHA512
+int test_sha512_batch(void *data)
+{
+    (void)data;
+    return test_digest_batch("SHA-512");
+}
+#endif
+
+#ifndef TEST_MULTITHREADED
+/* Size of context allocated when pool not in use. */
+#define TEST_POOL_ALLOC_SZ      300
+/* Largest size in the same size class. */
+#define TEST_POOL_CLASS_SZ      512
+
+/* Block allocated when the pool is not in use and freed into a thread's
+ * cache must be usable for any size in its class. */
+int test_digest_pool(void *data)
+{
+    int err = 0;
+    unsigned char* ptr;
+    unsigned char* reused = NULL;
+    int i;
+
+    (void)data;
+
+    PRINT_MSG("Allocate with pool not in use");
+    wp_pool_cleanup();
+    ptr = (unsigned char*)wp_pool_zalloc(TEST_POOL_ALLOC_SZ);
+    if (!wp_pool_init()) {
+        err = 1;
+    }
+    if (ptr == NULL) {
+        err = 1;
+    }
+
+    if (err == 0) {
+        PRINT_MSG("Free with pool in use and reuse for whole class");
+        wp_pool_clear_free(ptr, TEST_POOL_ALLOC_SZ);
+        ptr = NULL;
+        err = (reused = (unsigned char*)wp_pool_zalloc(TEST_POOL_CLASS_SZ)) ==
+              NULL;
+    }
+    for (i = 0; (err == 0) && (i < TEST_POOL_CLASS_SZ); i++) {
+        err = reused[i] != 0;
+    }
+    if (err == 0) {
+        memset(reused, 0xff, TEST_POOL_CLASS_SZ);
+    }
+
+    wp_pool_clear_free(reused, TEST_POOL_CLASS_SZ);
+    wp_pool_clear_free(ptr, TEST_POOL_ALLOC_SZ);
+
+    return err;
+}
+#endif
+
+/******************************************************************************/
+
 #ifdef WP_HAVE_SHA3_224
 int test_sha3_224(void *data)
 {
@@ -185,7 +329,7 @@ int test_sha3_512(void *data)
 
 /******************************************************************************/
 
-#ifdef WP_HAVE_SHAKE_256
+#if defined(WP_HAVE_SHAKE_128) || defined(WP_HAVE_SHAKE_256)
 static int test_xof_op(const EVP_MD *md, unsigned char *msg, size_t len,
     unsigned char *prev, unsigned int *prevLen)
 {
@@ -274,11 +418,173 @@ static int test_create_xof(const char *name, void *data)
 }
 #endif
 
+#ifdef WP_HAVE_SHAKE_128
+int test_shake_128(void *data)
+{
+    return test_create_xof("SHAKE-128", data);
+}
+#endif
+
 #ifdef WP_HAVE_SHAKE_256
 int test_shake_256(void *data)
 {
     return test_create_xof("SHAKE-256", data);
 }
+
+static int test_xof_batch(const char *name)
+{
+    int err;
+    static const size_t lens[] = { 0, 1, 135, 136, 1000 };
+    size_t cnt = sizeof(lens) / sizeof(*lens);
+    unsigned char msgs[sizeof(lens) / sizeof(*lens) * 4 + 1272];
+    unsigned char outs[sizeof(lens) / sizeof(*lens) * 200];
+    unsigned char out[200];
+    unsigned char *msg[sizeof(lens) / sizeof(*lens)];
+    size_t xofLen = sizeof(out);
+    size_t idx = 0;
+    size_t i;
+    EVP_MD_CTX *ctx = NULL;
+    OSSL_PARAM params[3];
+    EVP_MD *omd;
+    EVP_MD *wmd;
+
+    omd = EVP_MD_fetch(osslLibCtx, name, "");
+    wmd = EVP_MD_fetch(wpLibCtx, name, "");
+
+    err = 0;
+    for (i = 0; (err == 0) && (i < cnt); i++) {
+        msgs[idx++] = (unsigned char)(lens[i] >> 24);
+        msgs[idx++] = (unsigned char)(lens[i] >> 16);
+        msgs[idx++] = (unsigned char)(lens[i] >>  8);
+        msgs[idx++] = (unsigned char)(lens[i] >>  0);
+        msg[i] = msgs + idx;
+        if ((lens[i] > 0) && (RAND_bytes(msgs + idx, (int)lens[i]) != 1)) {
+            err = 1;
+        }
+        idx += lens[i];
+    }
+
+    if (err == 0) {
+        err = (ctx = EVP_MD_CTX_new()) == NULL;
+    }
+    if (err == 0) {
+        err = EVP_DigestInit_ex(ctx, wmd, NULL) != 1;
+    }
+    if (err == 0) {
+        PRINT_MSG("XOF batch with wolfprovider");
+        params[0] = OSSL_PARAM_construct_size_t(OSSL_DIGEST_PARAM_XOFLEN,
+            &xofLen);
+        params[1] = OSSL_PARAM_construct_end();
+        err = EVP_MD_CTX_set_params(ctx, params) != 1;
+    }
+    if (err == 0) {
+        params[0] = OSSL_PARAM_construct_octet_string(
+            WP_DIGEST_PARAM_BATCH_MSGS, msgs, idx);
+        params[1] = OSSL_PARAM_construct_octet_string(
+            WP_DIGEST_PARAM_BATCH_DIGESTS, outs, sizeof(outs));
+        params[2] = OSSL_PARAM_construct_end();
+        err = EVP_MD_CTX_get_params(ctx, params) != 1;
+    }
+    if ((err == 0) && (params[1].return_size != cnt * xofLen)) {
+        err = 1;
+    }
+    for (i = 0; (err == 0) && (i < cnt); i++) {
+        PRINT_MSG("XOF message with OpenSSL");
+        err = EVP_DigestInit_ex(ctx, omd, NULL) != 1;
+        if (err == 0) {
+            err = EVP_DigestUpdate(ctx, msg[i], lens[i]) != 1;
+        }
+        if (err == 0) {
+            err = EVP_DigestFinalXOF(ctx, out, xofLen) != 1;
+        }
+        if ((err == 0) && (memcmp(outs + i * xofLen, out, xofLen) != 0)) {
+            PRINT_ERR_MSG("Outputs don't match");
+            err = 1;
+        }
+    }
+
+    EVP_MD_CTX_free(ctx);
+    EVP_MD_free(wmd);
+    EVP_MD_free(omd);
+
+    return err;
+}
+
+#if OPENSSL_VERSION_NUMBER >= 0x30300000L
+static int test_xof_squeeze(const char *name)
+{
+    int err;
+    static const size_t chunks[] = { 1, 16, 135, 136, 137, 300, 500, 1 };
+    unsigned char msg[100];
+    unsigned char exp[1226];
+    unsigned char out[1226];
+    size_t cnt = sizeof(chunks) / sizeof(*chunks);
+    size_t off = 0;
+    size_t i;
+    EVP_MD_CTX *ctx = NULL;
+    EVP_MD *omd;
+    EVP_MD *wmd;
+
+    omd = EVP_MD_fetch(osslLibCtx, name, "");
+    wmd = EVP_MD_fetch(wpLibCtx, name, "");
+
+    err = RAND_bytes(msg, sizeof(msg)) != 1;
+    if (err == 0) {
+        err = (ctx = EVP_MD_CTX_new()) == NULL;
+    }
+    if (err == 0) {
+        PRINT_MSG("XOF output in one final with OpenSSL");
+        err = EVP_DigestInit_ex(ctx, omd, NULL) != 1;
+    }
+    if (err == 0) {
+        err = EVP_DigestUpdate(ctx, msg, sizeof(msg)) != 1;
+    }
+    if (err == 0) {
+        err = EVP_DigestFinalXOF(ctx, exp, sizeof(exp)) != 1;
+    }
+    if (err == 0) {
+        PRINT_MSG("XOF output squeezed in pieces with wolfprovider");
+        err = EVP_DigestInit_ex(ctx, wmd, NULL) != 1;
+    }
+    if (err == 0) {
+        err = EVP_DigestUpdate(ctx, msg, sizeof(msg)) != 1;
+    }
+    for (i = 0; (err == 0) && (i < cnt); i++) {
+        err = EVP_DigestSqueeze(ctx, out + off, chunks[i]) != 1;
+        off += chunks[i];
+    }
+    if ((err == 0) && (memcmp(exp, out, sizeof(exp)) != 0)) {
+        PRINT_ERR_MSG("Outputs don't match");
+        err = 1;
+    }
+    if (err == 0) {
+        PRINT_MSG("Update after squeeze fails");
+        err = EVP_DigestUpdate(ctx, msg, sizeof(msg)) == 1;
+    }
+
+    EVP_MD_CTX_free(ctx);
+    EVP_MD_free(wmd);
+    EVP_MD_free(omd);
+
+    return err;
+}
+#endif
+
+int test_shake_256_stream(void *data)
+{
+    int err;
+
+    (void)data;
+
+    err = test_xof_batch("SHAKE-256");
+#if OPENSSL_VERSION_NUMBER >= 0x30300000L
+    if (err == 0) {
+        err = test_xof_squeeze("SHAKE-256");
+    }
+#endif
+
+    return err;
+}
 #endif
 
 /******************************************************************************/
@@ -20,8 +20,13 @@
 
 #include "unit.h"
 
+#include <unistd.h>
+
 #include <openssl/store.h>
 #include <openssl/core_names.h>
+#include <openssl/kdf.h>
+
+#include <wolfprovider/wp_params.h>
 
 #ifdef WP_HAVE_ECC
 
@@ -366,9 +371,60 @@ int test_eckeygen_p256(void *data)
         PRINT_MSG("Generate key");
         err = EVP_PKEY_keygen(ctx, &key) != 1;
     }
+    if (err == 0) {
+        size_t keyBytes = 0;
+
+        PRINT_MSG("Get memory held by key");
+        err = EVP_PKEY_get_size_t_param(key, "wolfprov-key-bytes",
+            &keyBytes) != 1;
+        if (err == 0) {
+            err = keyBytes == 0;
+        }
+    }
+
+    EVP_PKEY_free(key);
+    EVP_PKEY_CTX_free(ctx);
+
+    return err;
+}
+
+/* Keys pre-generated by the key pool must not be handed out by both a parent
+ * and a forked child. */
+int test_eckeygen_pool_fork(void *data)
+{
+    int err;
+    OSSL_LIB_CTX* libCtx;
+    EVP_PKEY_CTX *ctx = NULL;
+    EVP_PKEY *key = NULL;
+
+    (void)data;
+
+    PRINT_MSG("Load provider with key pool");
+    err = (libCtx = test_conf_libctx("keygen-pool-depth = 4")) == NULL;
+    if (err == 0) {
+        err = (ctx = EVP_PKEY_CTX_new_from_name(libCtx, "EC", NULL)) == NULL;
+    }
+    if (err == 0) {
+        err = EVP_PKEY_keygen_init(ctx) != 1;
+    }
+    if (err == 0) {
+        err = EVP_PKEY_CTX_set_ec_paramgen_curve_nid(ctx,
+                                                     NID_X9_62_prime256v1) != 1;
+    }
+    if (err == 0) {
+        PRINT_MSG("Generate key to start filling pool");
+        err = EVP_PKEY_keygen(ctx, &key) != 1;
+        /* Give the pool's threads time to fill the slot. */
+        sleep(1);
+    }
+    if (err == 0) {
+        PRINT_MSG("Generate keys in parent and forked child");
+        err = test_fork_keygen_differ(ctx);
+    }
 
     EVP_PKEY_free(key);
     EVP_PKEY_CTX_free(ctx);
+    OSSL_LIB_CTX_free(libCtx);
 
     return err;
 }
@@ -656,6 +712,214 @@ int test_ecdh_x448_keygen(void *data)
     return test_ecdh_keygen(NID_undef, "X448", 56);
 }
 #endif /* WP_HAVE_X448 */
+
+static int test_ecdh_hkdf_extract_derive(EVP_PKEY *key, EVP_PKEY *peerKey,
+    unsigned char *salt, size_t saltLen, unsigned char *prk)
+{
+    int err;
+    EVP_PKEY_CTX *ctx = NULL;
+    OSSL_PARAM params[4];
+    size_t outLen;
+
+    params[0] = OSSL_PARAM_construct_utf8_string(OSSL_EXCHANGE_PARAM_KDF_TYPE,
+        (char*)WP_EXCHANGE_KDF_NAME_HKDF_EXTRACT, 0);
+    params[1] = OSSL_PARAM_construct_utf8_string(
+        OSSL_EXCHANGE_PARAM_KDF_DIGEST, (char*)"SHA256", 0);
+    params[2] = OSSL_PARAM_construct_octet_string(WP_EXCHANGE_PARAM_KDF_SALT,
+        salt, saltLen);
+    params[3] = OSSL_PARAM_construct_end();
+
+    err = (ctx = EVP_PKEY_CTX_new_from_pkey(wpLibCtx, key, NULL)) == NULL;
+    if (err == 0) {
+        err = EVP_PKEY_derive_init_ex(ctx, params) != 1;
+    }
+    if (err == 0) {
+        err = EVP_PKEY_derive_set_peer(ctx, peerKey) != 1;
+    }
+    if (err == 0) {
+        err = EVP_PKEY_derive(ctx, NULL, &outLen) != 1;
+    }
+    if (err == 0) {
+        err = outLen != 32;
+    }
+    if (err == 0) {
+        err = EVP_PKEY_derive(ctx, prk, &outLen) != 1;
+    }
+    if (err == 0) {
+        err = outLen != 32;
+    }
+
+    EVP_PKEY_CTX_free(ctx);
+
+    return err;
+}
+
+static int test_ecdh_hkdf_extract_name(int nid, const char* name, int len)
+{
+    int err;
+    EVP_PKEY_CTX *kgCtx = NULL;
+    EVP_PKEY *keyA = NULL;
+    EVP_PKEY *keyB = NULL;
+    unsigned char *secret = NULL;
+    EVP_KDF *kdf = NULL;
+    EVP_KDF_CTX *kdfCtx = NULL;
+    OSSL_PARAM params[5];
+    int mode = EVP_KDF_HKDF_MODE_EXTRACT_ONLY;
+    unsigned char salt[16];
+    unsigned char prkA[32];
+    unsigned char prkB[32];
+    unsigned char exp[32];
+
+    memset(salt, 0x5a, sizeof(salt));
+
+    err = (kgCtx = EVP_PKEY_CTX_new_from_name(wpLibCtx, name, NULL)) == NULL;
+    if (err == 0) {
+        err = EVP_PKEY_keygen_init(kgCtx) != 1;
+    }
+    if ((err == 0) && (nid != NID_undef)) {
+        err = EVP_PKEY_CTX_set_ec_paramgen_curve_nid(kgCtx, nid) != 1;
+    }
+    if (err == 0) {
+        err = EVP_PKEY_keygen(kgCtx, &keyA) != 1;
+    }
+    if (err == 0) {
+        err = EVP_PKEY_keygen(kgCtx, &keyB) != 1;
+    }
+    if (err == 0) {
+        PRINT_MSG("Derive raw secret");
+        err = test_ecdh_derive(keyA, keyB, &secret, len);
+    }
+    if (err == 0) {
+        PRINT_MSG("HKDF-Extract raw secret with OpenSSL");
+        err = (kdf = EVP_KDF_fetch(osslLibCtx, "HKDF", NULL)) == NULL;
+    }
+    if (err == 0) {
+        err = (kdfCtx = EVP_KDF_CTX_new(kdf)) == NULL;
+    }
+    if (err == 0) {
+        params[0] = OSSL_PARAM_construct_utf8_string(OSSL_KDF_PARAM_DIGEST,
+            (char*)"SHA256", 0);
+        params[1] = OSSL_PARAM_construct_int(OSSL_KDF_PARAM_MODE, &mode);
+        params[2] = OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_KEY,
+            secret, len);
+        params[3] = OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_SALT,
+            salt, sizeof(salt));
+        params[4] = OSSL_PARAM_construct_end();
+        err = EVP_KDF_derive(kdfCtx, exp, sizeof(exp), params) != 1;
+    }
+    if (err == 0) {
+        PRINT_MSG("Derive and extract A");
+        err = test_ecdh_hkdf_extract_derive(keyA, keyB, salt, sizeof(salt),
+            prkA);
+    }
+    if (err == 0) {
+        PRINT_MSG("Derive and extract B");
+        err = test_ecdh_hkdf_extract_derive(keyB, keyA, salt, sizeof(salt),
+            prkB);
+    }
+    if (err == 0) {
+        PRINT_BUFFER("Expected", exp, sizeof(exp));
+        PRINT_BUFFER("PRK A", prkA, sizeof(prkA));
+        PRINT_BUFFER("PRK B", prkB, sizeof(prkB));
+        err = (memcmp(prkA, exp, sizeof(exp)) != 0) ||
+              (memcmp(prkB, exp, sizeof(exp)) != 0);
+        if (err != 0) {
+            PRINT_ERR_MSG("Extracted secrets do not match!");
+        }
+    }
+
+    EVP_KDF_CTX_free(kdfCtx);
+    EVP_KDF_free(kdf);
+    OPENSSL_free(secret);
+    EVP_PKEY_free(keyB);
+    EVP_PKEY_free(keyA);
+    EVP_PKEY_CTX_free(kgCtx);
+
+    return err;
+}
+
+int test_ecdh_hkdf_extract(void *data)
+{
+    int err = 0;
+
+    (void)data;
+
+#ifdef WP_HAVE_EC_P256
+    err = test_ecdh_hkdf_extract_name(NID_X9_62_prime256v1, "EC", 32);
+#endif
+#ifdef WP_HAVE_X25519
+    if (err == 0) {
+        err = test_ecdh_hkdf_extract_name(NID_undef, "X25519", 32);
+    }
+#endif
+#ifdef WP_HAVE_X448
+    if (err == 0) {
+        err = test_ecdh_hkdf_extract_name(NID_undef, "X448", 56);
+    }
+#endif
+
+    return err;
+}
+
+#ifdef WP_HAVE_EC_P256
+int test_ecdh_p256_peer_import(void *data)
+{
+    int err;
+    EVP_PKEY_CTX *kgCtx = NULL;
+    EVP_PKEY_CTX *ctx = NULL;
+    EVP_PKEY *key = NULL;
+    EVP_PKEY *peer = NULL;
+    unsigned char pub[65];
+    size_t pubLen = 0;
+
+    (void)data;
+
+    err = (kgCtx = EVP_PKEY_CTX_new_from_name(wpLibCtx, "EC", NULL)) == NULL;
+    if (err == 0) {
+        err = EVP_PKEY_keygen_init(kgCtx) != 1;
+    }
+    if (err == 0) {
+        err = EVP_PKEY_CTX_set_ec_paramgen_curve_nid(kgCtx,
+            NID_X9_62_prime256v1) != 1;
+    }
+    if (err == 0) {
+        err = EVP_PKEY_keygen(kgCtx, &key) != 1;
+    }
+    if (err == 0) {
+        err = EVP_PKEY_get_octet_string_param(key,
+            OSSL_PKEY_PARAM_ENCODED_PUBLIC_KEY, pub, sizeof(pub),
+            &pubLen) != 1;
+    }
+    if (err == 0) {
+        err = (peer = EVP_PKEY_new()) == NULL;
+    }
+    if (err == 0) {
+        err = EVP_PKEY_copy_parameters(peer, key) != 1;
+    }
+    if (err == 0) {
+        PRINT_MSG("Import valid peer point");
+        err = EVP_PKEY_set1_encoded_public_key(peer, pub, pubLen) != 1;
+    }
+    if (err == 0) {
+        err = (ctx = EVP_PKEY_CTX_new_from_pkey(wpLibCtx, peer, NULL)) == NULL;
+    }
+    if (err == 0) {
+        err = EVP_PKEY_public_check_quick(ctx) != 1;
+    }
+    if (err == 0) {
+        PRINT_MSG("Import point not on curve");
+        pub[pubLen - 1] ^= 0x01;
+        err = EVP_PKEY_set1_encoded_public_key(peer, pub, pubLen) == 1;
+    }
+
+    EVP_PKEY_CTX_free(ctx);
+    EVP_PKEY_free(peer);
+    EVP_PKEY_free(key);
+    EVP_PKEY_CTX_free(kgCtx);
+
+    return err;
+}
+#endif /* WP_HAVE_EC_P256 */
 #endif /* WP_HAVE_ECKEYGEN */
 
 static int test_ecdh(const unsigned char *privKey, size_t len,
@@ -1264,6 +1528,87 @@ int test_ecdsa_p256(void *data)
 
     return err;
 }
+
+/* Append a length prefixed field to batch verification data. */
+static size_t test_batch_add(unsigned char *batch, size_t idx,
+    const unsigned char *data, size_t len)
+{
+    batch[idx++] = (unsigned char)(len >> 24);
+    batch[idx++] = (unsigned char)(len >> 16);
+    batch[idx++] = (unsigned char)(len >>  8);
+    batch[idx++] = (unsigned char)(len >>  0);
+    memcpy(batch + idx, data, len);
+    return idx + len;
+}
+
+int test_ecdsa_p256_batch_verify(void *data)
+{
+    int err;
+    int i;
+    EVP_PKEY *pkey = NULL;
+    EVP_PKEY_CTX *ctx = NULL;
+    unsigned char hash[3][32];
+    unsigned char ecdsaSig[3][80];
+    size_t ecdsaSigLen[3];
+    unsigned char batch[3 * (4 + 32 + 4 + 80)];
+    size_t batchLen = 0;
+    unsigned char res[1] = { 0 };
+    OSSL_PARAM params[2];
+    const unsigned char *p = ecc_key_der_256;
+
+    (void)data;
+
+    pkey = d2i_PrivateKey(EVP_PKEY_EC, NULL, &p, sizeof(ecc_key_der_256));
+    err = pkey == NULL;
+    for (i = 0; (err == 0) && (i < 3); i++) {
+        err = RAND_bytes(hash[i], sizeof(hash[i])) == 0;
+        if (err == 0) {
+            ecdsaSigLen[i] = sizeof(ecdsaSig[i]);
+            err = test_pkey_sign_ecc(pkey, wpLibCtx, hash[i], sizeof(hash[i]),
+                                     ecdsaSig[i], &ecdsaSigLen[i]);
+        }
+    }
+    if (err == 0) {
+        PRINT_MSG("Batch verify with wolfprovider - second signature bad");
+        ecdsaSig[1][ecdsaSigLen[1] - 1] ^= 0x01;
+        for (i = 0; i < 3; i++) {
+            batchLen = test_batch_add(batch, batchLen, hash[i],
+                sizeof(hash[i]));
+            batchLen = test_batch_add(batch, batchLen, ecdsaSig[i],
+                ecdsaSigLen[i]);
+        }
+        ctx = EVP_PKEY_CTX_new_from_pkey(wpLibCtx, pkey, NULL);
+        err = ctx == NULL;
+    }
+    if (err == 0) {
+        err = EVP_PKEY_verify_init(ctx) != 1;
+    }
+    if (err == 0) {
+        params[0] = OSSL_PARAM_construct_octet_string(
+            WP_SIGNATURE_PARAM_BATCH_VERIFY, batch, batchLen);
+        params[1] = OSSL_PARAM_construct_end();
+        err = EVP_PKEY_CTX_set_params(ctx, params) != 1;
+    }
+    if (err == 0) {
+        params[0] = OSSL_PARAM_construct_octet_string(
+            WP_SIGNATURE_PARAM_BATCH_RESULT, res, sizeof(res));
+        err = EVP_PKEY_CTX_get_params(ctx, params) != 1;
+    }
+    if (err == 0) {
+        err = (params[0].return_size != sizeof(res)) || (res[0] != 0x05);
+    }
+    if (err == 0) {
+        PRINT_MSG("Batch verify with wolfprovider - truncated data");
+        params[0] = OSSL_PARAM_construct_octet_string(
+            WP_SIGNATURE_PARAM_BATCH_VERIFY, batch, batchLen - 1);
+        err = EVP_PKEY_CTX_set_params(ctx, params) == 1;
+    }
+
+    EVP_PKEY_CTX_free(ctx);
+    EVP_PKEY_free(pkey);
+
+    return err;
+}
 #endif /* WP_HAVE_EC_P256 */
 
 #ifdef WP_HAVE_EC_P384
@@ -1445,6 +1790,116 @@ int test_ec_load_cert(void* data)
     OSSL_STORE_close(ctx);
     return err;
 }
+static EVP_PKEY* test_ec_load_pkey(OSSL_LIB_CTX* libCtx)
+{
+    OSSL_STORE_CTX* ctx = NULL;
+    OSSL_STORE_INFO* info = NULL;
+    EVP_PKEY* pkey = NULL;
+
+    ctx = OSSL_STORE_open_ex("./certs/ecc-key.pem", libCtx, NULL, NULL, NULL,
+        NULL, NULL, NULL);
+    if (ctx != NULL) {
+        info = OSSL_STORE_load(ctx);
+    }
+    if (info != NULL) {
+        pkey = OSSL_STORE_INFO_get1_PKEY(info);
+    }
+
+    OSSL_STORE_INFO_free(info);
+    OSSL_STORE_close(ctx);
+    return pkey;
+}
+
+int test_ec_encode_spki(void* data)
+{
+    int err;
+    EVP_PKEY* pkey = NULL;
+    EVP_PKEY* osslPkey = NULL;
+    unsigned char* der[3] = { NULL, NULL, NULL };
+    int derLen[3] = { 0, 0, 0 };
+
+    (void)data;
+
+    PRINT_MSG("Load ECC private key with wolfProvider and OpenSSL");
+    pkey = test_ec_load_pkey(wpLibCtx);
+    osslPkey = test_ec_load_pkey(osslLibCtx);
+    err = (pkey == NULL) || (osslPkey == NULL);
+    if (err == 0) {
+        PRINT_MSG("Encode public key twice with wolfProvider");
+        derLen[0] = i2d_PUBKEY(pkey, &der[0]);
+        derLen[1] = i2d_PUBKEY(pkey, &der[1]);
+        err = (derLen[0] <= 0) || (derLen[1] <= 0);
+    }
+    if (err == 0) {
+        PRINT_MSG("Encode public key with OpenSSL");
+        derLen[2] = i2d_PUBKEY(osslPkey, &der[2]);
+        err = derLen[2] <= 0;
+    }
+    if (err == 0) {
+        PRINT_BUFFER("SubjectPublicKeyInfo", der[0], derLen[0]);
+        err = (derLen[0] != derLen[1]) || (derLen[0] != derLen[2]) ||
+              (memcmp(der[0], der[1], derLen[0]) != 0) ||
+              (memcmp(der[0], der[2], derLen[0]) != 0);
+    }
+
+    OPENSSL_free(der[2]);
+    OPENSSL_free(der[1]);
+    OPENSSL_free(der[0]);
+    EVP_PKEY_free(osslPkey);
+    EVP_PKEY_free(pkey);
+    return err;
+}
+
+int test_ec_export_keypair(void* data)
+{
+    int err;
+    EVP_PKEY* pkey = NULL;
+    EVP_PKEY* osslPkey = NULL;
+    OSSL_PARAM* params[3] = { NULL, NULL, NULL };
+    BIGNUM* priv[3] = { NULL, NULL, NULL };
+    unsigned char pub[3][133];
+    size_t pubLen[3] = { 0, 0, 0 };
+    int i;
+
+    (void)data;
+
+    PRINT_MSG("Load ECC private key with wolfProvider and OpenSSL");
+    pkey = test_ec_load_pkey(wpLibCtx);
+    osslPkey = test_ec_load_pkey(osslLibCtx);
+    err = (pkey == NULL) || (osslPkey == NULL);
+    if (err == 0) {
+        PRINT_MSG("Export key pair twice with wolfProvider");
+        err = (EVP_PKEY_todata(pkey, EVP_PKEY_KEYPAIR, &params[0]) != 1) ||
+              (EVP_PKEY_todata(pkey, EVP_PKEY_KEYPAIR, &params[1]) != 1);
+    }
+    if (err == 0) {
+        PRINT_MSG("Export key pair with OpenSSL");
+        err = EVP_PKEY_todata(osslPkey, EVP_PKEY_KEYPAIR, &params[2]) != 1;
+    }
+    for (i = 0; (err == 0) && (i < 3); i++) {
+        err = (OSSL_PARAM_get_BN(OSSL_PARAM_locate(params[i],
+                  OSSL_PKEY_PARAM_PRIV_KEY), &priv[i]) != 1) ||
+              (OSSL_PARAM_get_octet_string(OSSL_PARAM_locate(params[i],
+                  OSSL_PKEY_PARAM_PUB_KEY), (void**)&pub[i], sizeof(pub[i]),
+                  &pubLen[i]) != 1);
+    }
+    if (err == 0) {
+        PRINT_BUFFER("Public key", pub[0], pubLen[0]);
+        err = (BN_cmp(priv[0], priv[1]) != 0) ||
+              (BN_cmp(priv[0], priv[2]) != 0) ||
+              (pubLen[0] != pubLen[1]) || (pubLen[0] != pubLen[2]) ||
+              (memcmp(pub[0], pub[1], pubLen[0]) != 0) ||
+              (memcmp(pub[0], pub[2], pubLen[0]) != 0);
+    }
+
+    for (i = 0; i < 3; i++) {
+        BN_clear_free(priv[i]);
+        OSSL_PARAM_free(params[i]);
+    }
+    EVP_PKEY_free(osslPkey);
+    EVP_PKEY_free(pkey);
+    return err;
+}
 #endif /* WP_HAVE_ECDSA */
 
 #endif /* WP_HAVE_ECC */
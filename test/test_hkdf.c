@@ -20,6 +20,8 @@
 
 #include "unit.h"
 
+#include <wolfprovider/wp_params.h>
+
 #ifdef WP_HAVE_HKDF
 
 static int test_hkdf_calc(OSSL_LIB_CTX* libCtx, unsigned char *key, int keyLen,
@@ -447,6 +449,329 @@ int test_hkdf(void *data)
     return err;
 }
 
+
+static int test_tls13_kdf_calc(const char* md, int mode, unsigned char* key,
+    size_t keyLen, unsigned char* salt, size_t saltLen, const char* label,
+    unsigned char* data, size_t dataLen, unsigned char* out, size_t outLen)
+{
+    int err;
+    EVP_KDF* kdf = NULL;
+    EVP_KDF_CTX* kctx = NULL;
+    OSSL_PARAM params[8];
+    OSSL_PARAM* p = params;
+
+    *p++ = OSSL_PARAM_construct_utf8_string(OSSL_KDF_PARAM_DIGEST,
+        (char*)md, 0);
+    *p++ = OSSL_PARAM_construct_int(OSSL_KDF_PARAM_MODE, &mode);
+    if (key != NULL) {
+        *p++ = OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_KEY, key,
+            keyLen);
+    }
+    if (salt != NULL) {
+        *p++ = OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_SALT, salt,
+            saltLen);
+    }
+    *p++ = OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_PREFIX,
+        (void*)"tls13 ", 6);
+    *p++ = OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_LABEL,
+        (void*)label, strlen(label));
+    if (dataLen > 0) {
+        *p++ = OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_DATA, data,
+            dataLen);
+    }
+    *p = OSSL_PARAM_construct_end();
+
+    err = (kdf = EVP_KDF_fetch(osslLibCtx, "TLS13-KDF", NULL)) == NULL;
+    if (err == 0) {
+        err = (kctx = EVP_KDF_CTX_new(kdf)) == NULL;
+    }
+    if (err == 0) {
+        err = EVP_KDF_derive(kctx, out, outLen, params) != 1;
+    }
+
+    EVP_KDF_CTX_free(kctx);
+    EVP_KDF_free(kdf);
+    return err;
+}
+
+static int test_tls13_kdf_expand_labels(void)
+{
+    int err;
+    int mode = EVP_KDF_HKDF_MODE_EXPAND_ONLY;
+    EVP_KDF* kdf = NULL;
+    EVP_KDF_CTX* kctx = NULL;
+    OSSL_PARAM params[7];
+    OSSL_PARAM* p;
+    static const char* labels[4] = {
+        "quic key", "quic iv", "quic hp", "quic ku"
+    };
+    static const size_t lens[4] = { 16, 12, 16, 32 };
+    unsigned char secret[32];
+    unsigned char items[4 * 3 + 32];
+    unsigned char oKey[16 + 12 + 16 + 32];
+    unsigned char wKey[16 + 12 + 16 + 32];
+    size_t itemsLen = 0;
+    size_t off = 0;
+    size_t len;
+    int i;
+
+    memset(secret, 0x42, sizeof(secret));
+
+    PRINT_MSG("QUIC labels expanded separately with OpenSSL");
+    err = 0;
+    for (i = 0; (err == 0) && (i < 4); i++) {
+        len = strlen(labels[i]);
+        items[itemsLen++] = (unsigned char)(lens[i] >> 8);
+        items[itemsLen++] = (unsigned char)lens[i];
+        items[itemsLen++] = (unsigned char)len;
+        memcpy(items + itemsLen, labels[i], len);
+        itemsLen += len;
+        err = test_tls13_kdf_calc("SHA256", mode, secret, sizeof(secret),
+            NULL, 0, labels[i], NULL, 0, oKey + off, lens[i]);
+        off += lens[i];
+    }
+
+    if (err == 0) {
+        PRINT_MSG("QUIC labels expanded in one request with wolfSSL");
+        err = (kdf = EVP_KDF_fetch(wpLibCtx, "TLS13-KDF", NULL)) == NULL;
+    }
+    if (err == 0) {
+        err = (kctx = EVP_KDF_CTX_new(kdf)) == NULL;
+    }
+    if (err == 0) {
+        p = params;
+        *p++ = OSSL_PARAM_construct_utf8_string(OSSL_KDF_PARAM_DIGEST,
+            (char*)"SHA256", 0);
+        *p++ = OSSL_PARAM_construct_int(OSSL_KDF_PARAM_MODE, &mode);
+        *p++ = OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_KEY, secret,
+            sizeof(secret));
+        *p++ = OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_PREFIX,
+            (void*)"tls13 ", 6);
+        *p++ = OSSL_PARAM_construct_octet_string(
+            WP_KDF_PARAM_TLS13_EXPAND_LABELS, items, itemsLen);
+        *p = OSSL_PARAM_construct_end();
+        err = EVP_KDF_derive(kctx, wKey, sizeof(wKey), params) != 1;
+    }
+    if ((err == 0) && (memcmp(oKey, wKey, sizeof(oKey)) != 0)) {
+        PRINT_BUFFER("OpenSSL keys", oKey, sizeof(oKey));
+        PRINT_BUFFER("wolfSSL keys", wKey, sizeof(wKey));
+        err = 1;
+    }
+    if (err == 0) {
+        /* Output length must match sum of label output lengths. */
+        err = EVP_KDF_derive(kctx, wKey, sizeof(wKey) - 1, NULL) == 1;
+    }
+    if (err == 0) {
+        PRINT_MSG("Single label with key kept in context");
+        p = params;
+        /* Empty labels - expand label parameter only. */
+        *p++ = OSSL_PARAM_construct_octet_string(
+            WP_KDF_PARAM_TLS13_EXPAND_LABELS, items, 0);
+        *p++ = OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_LABEL,
+            (void*)labels[3], strlen(labels[3]));
+        *p = OSSL_PARAM_construct_end();
+        err = EVP_KDF_derive(kctx, wKey, lens[3], params) != 1;
+    }
+    if ((err == 0) && (memcmp(oKey + off - lens[3], wKey, lens[3]) != 0)) {
+        PRINT_BUFFER("OpenSSL key", oKey + off - lens[3], lens[3]);
+        PRINT_BUFFER("wolfSSL key", wKey, lens[3]);
+        err = 1;
+    }
+
+    EVP_KDF_CTX_free(kctx);
+    EVP_KDF_free(kdf);
+    return err;
+}
+
+static int test_tls13_ks_traffic_exp(const char* md, size_t mdLen,
+    unsigned char* out, int finished, size_t keyLen, size_t ivLen)
+{
+    int err = 0;
+    size_t idx = mdLen;
+
+    if (finished) {
+        err = test_tls13_kdf_calc(md, EVP_KDF_HKDF_MODE_EXPAND_ONLY, out,
+            mdLen, NULL, 0, "finished", NULL, 0, out + idx, mdLen);
+        idx += mdLen;
+    }
+    if ((err == 0) && (keyLen > 0)) {
+        err = test_tls13_kdf_calc(md, EVP_KDF_HKDF_MODE_EXPAND_ONLY, out,
+            mdLen, NULL, 0, "key", NULL, 0, out + idx, keyLen);
+        idx += keyLen;
+        if (err == 0) {
+            err = test_tls13_kdf_calc(md, EVP_KDF_HKDF_MODE_EXPAND_ONLY, out,
+                mdLen, NULL, 0, "iv", NULL, 0, out + idx, ivLen);
+        }
+    }
+
+    return err;
+}
+
+static int test_tls13_ks_exp(const char* md, size_t mdLen,
+    unsigned char* dhe, size_t dheLen, unsigned char* hsHash,
+    unsigned char* appHash, size_t keyLen, size_t ivLen, unsigned char* out)
+{
+    int err;
+    int ext = EVP_KDF_HKDF_MODE_EXTRACT_ONLY;
+    int exp = EVP_KDF_HKDF_MODE_EXPAND_ONLY;
+    unsigned char early[64];
+    unsigned char hs[64];
+    unsigned char* master;
+    size_t trafficLen = mdLen + ((keyLen > 0) ? keyLen + ivLen : 0);
+    size_t idx = 0;
+
+    err = test_tls13_kdf_calc(md, ext, NULL, 0, NULL, 0, "derived", NULL, 0,
+        early, mdLen);
+    if (err == 0) {
+        err = test_tls13_kdf_calc(md, ext, dhe, dheLen, early, mdLen,
+            "derived", NULL, 0, hs, mdLen);
+    }
+    if (err == 0) {
+        err = test_tls13_kdf_calc(md, exp, hs, mdLen, NULL, 0, "c hs traffic",
+            hsHash, mdLen, out + idx, mdLen);
+    }
+    if (err == 0) {
+        err = test_tls13_ks_traffic_exp(md, mdLen, out + idx, 1, keyLen,
+            ivLen);
+        idx += trafficLen + mdLen;
+    }
+    if (err == 0) {
+        err = test_tls13_kdf_calc(md, exp, hs, mdLen, NULL, 0, "s hs traffic",
+            hsHash, mdLen, out + idx, mdLen);
+    }
+    if (err == 0) {
+        err = test_tls13_ks_traffic_exp(md, mdLen, out + idx, 1, keyLen,
+            ivLen);
+        idx += trafficLen + mdLen;
+    }
+    if ((err == 0) && (appHash != NULL)) {
+        master = out + idx;
+        err = test_tls13_kdf_calc(md, ext, NULL, 0, hs, mdLen, "derived",
+            NULL, 0, master, mdLen);
+        idx += mdLen;
+        if (err == 0) {
+            err = test_tls13_kdf_calc(md, exp, master, mdLen, NULL, 0,
+                "c ap traffic", appHash, mdLen, out + idx, mdLen);
+        }
+        if (err == 0) {
+            err = test_tls13_ks_traffic_exp(md, mdLen, out + idx, 0, keyLen,
+                ivLen);
+            idx += trafficLen;
+        }
+        if (err == 0) {
+            err = test_tls13_kdf_calc(md, exp, master, mdLen, NULL, 0,
+                "s ap traffic", appHash, mdLen, out + idx, mdLen);
+        }
+        if (err == 0) {
+            err = test_tls13_ks_traffic_exp(md, mdLen, out + idx, 0, keyLen,
+                ivLen);
+            idx += trafficLen;
+        }
+        if (err == 0) {
+            err = test_tls13_kdf_calc(md, exp, master, mdLen, NULL, 0,
+                "exp master", appHash, mdLen, out + idx, mdLen);
+        }
+    }
+
+    return err;
+}
+
+static int test_tls13_ks_md(const char* md, size_t mdLen, size_t keyLen,
+    int app)
+{
+    int err;
+    EVP_KDF* kdf = NULL;
+    EVP_KDF_CTX* kctx = NULL;
+    OSSL_PARAM params[7];
+    OSSL_PARAM* p = params;
+    unsigned char dhe[32];
+    unsigned char hsHash[64];
+    unsigned char appHash[64];
+    unsigned char exp[512];
+    unsigned char out[512];
+    size_t ivLen = 12;
+    size_t outLen;
+
+    PRINT_MSG(md);
+
+    RAND_bytes(dhe, sizeof(dhe));
+    RAND_bytes(hsHash, sizeof(hsHash));
+    RAND_bytes(appHash, sizeof(appHash));
+
+    *p++ = OSSL_PARAM_construct_utf8_string(OSSL_KDF_PARAM_DIGEST,
+        (char*)md, 0);
+    *p++ = OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_KEY, dhe,
+        sizeof(dhe));
+    *p++ = OSSL_PARAM_construct_octet_string(WP_KDF_PARAM_TLS13_HS_HASH,
+        hsHash, mdLen);
+    if (app) {
+        *p++ = OSSL_PARAM_construct_octet_string(WP_KDF_PARAM_TLS13_APP_HASH,
+            appHash, mdLen);
+    }
+    *p++ = OSSL_PARAM_construct_size_t(WP_KDF_PARAM_TLS13_KEY_LEN, &keyLen);
+    *p++ = OSSL_PARAM_construct_size_t(WP_KDF_PARAM_TLS13_IV_LEN, &ivLen);
+    *p = OSSL_PARAM_construct_end();
+
+    err = test_tls13_ks_exp(md, mdLen, dhe, sizeof(dhe), hsHash,
+        app ? appHash : NULL, keyLen, ivLen, exp);
+    if (err != 0) {
+        PRINT_MSG("FAILED OpenSSL");
+    }
+    if (err == 0) {
+        err = (kdf = EVP_KDF_fetch(wpLibCtx, "TLS13-KEY-SCHEDULE",
+            NULL)) == NULL;
+    }
+    if (err == 0) {
+        err = (kctx = EVP_KDF_CTX_new(kdf)) == NULL;
+    }
+    if (err == 0) {
+        err = EVP_KDF_CTX_set_params(kctx, params) != 1;
+    }
+    if (err == 0) {
+        outLen = EVP_KDF_CTX_get_kdf_size(kctx);
+        err = (outLen == 0) || (outLen > sizeof(out));
+    }
+    if (err == 0) {
+        err = EVP_KDF_derive(kctx, out, outLen, NULL) != 1;
+        if (err != 0) {
+            PRINT_MSG("FAILED wolfSSL");
+        }
+    }
+    if ((err == 0) && (memcmp(out, exp, outLen) != 0)) {
+        PRINT_BUFFER("OpenSSL secrets", exp, outLen);
+        PRINT_BUFFER("wolfSSL secrets", out, outLen);
+        err = 1;
+    }
+    if (err == 0) {
+        PRINT_MSG("Output length must match");
+        err = EVP_KDF_derive(kctx, out, outLen - 1, NULL) == 1;
+    }
+
+    EVP_KDF_CTX_free(kctx);
+    EVP_KDF_free(kdf);
+    return err;
+}
+
+int test_tls13_key_schedule(void *data)
+{
+    int err;
+
+    (void)data;
+
+    err = test_tls13_ks_md("SHA256", 32, 16, 1);
+    if (err == 0) {
+        err = test_tls13_ks_md("SHA256", 32, 0, 0);
+    }
+    if (err == 0) {
+        err = test_tls13_ks_md("SHA384", 48, 32, 1);
+    }
+    if (err == 0) {
+        err = test_tls13_kdf_expand_labels();
+    }
+
+    return err;
+}
+
 #endif /* WP_HAVE_HKDF */
 
 
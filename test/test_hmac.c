@@ -283,6 +283,204 @@ int test_hmac_create(void *data)
     return ret;
 }
 
+
+static int test_hmac_reinit_check(EVP_MAC_CTX* mctx, const char* md,
+    unsigned char* pswd, int pswdSz, unsigned char* msg, int len)
+{
+    int err;
+    unsigned char exp[64];
+    int expLen = sizeof(exp);
+    unsigned char mac[64];
+    size_t macLen = 0;
+
+    err = test_mac_gen_mac(osslLibCtx, md, "HMAC", pswd, pswdSz, msg, len,
+        exp, &expLen);
+    if (err == 0) {
+        err = EVP_MAC_update(mctx, msg, len) != 1;
+    }
+    if (err == 0) {
+        err = EVP_MAC_final(mctx, mac, &macLen, sizeof(mac)) != 1;
+    }
+    if (err == 0) {
+        PRINT_BUFFER("MAC", mac, macLen);
+        if ((macLen != (size_t)expLen) || (memcmp(mac, exp, expLen) != 0)) {
+            PRINT_MSG("generated mac and expected mac differ");
+            err = 1;
+        }
+    }
+
+    return err;
+}
+
+int test_hmac_reinit(void *data)
+{
+    int err;
+    EVP_MAC* emac = NULL;
+    EVP_MAC_CTX* mctx = NULL;
+    EVP_MAC_CTX* dup = NULL;
+    OSSL_PARAM params[2];
+    unsigned char pswd[] = "My empire of dirt";
+    unsigned char otherPswd[] = "Everyone I know goes away";
+    unsigned char msg1[] = "Test message";
+    unsigned char msg2[] = "Another test message";
+
+    (void)data;
+
+    params[0] = OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST,
+        (char*)"SHA-256", 0);
+    params[1] = OSSL_PARAM_construct_end();
+
+    err = (emac = EVP_MAC_fetch(wpLibCtx, "HMAC", NULL)) == NULL;
+    if (err == 0) {
+        err = (mctx = EVP_MAC_CTX_new(emac)) == NULL;
+    }
+    if (err == 0) {
+        PRINT_MSG("Initialize with key");
+        err = EVP_MAC_init(mctx, pswd, sizeof(pswd), params) != 1;
+    }
+    if (err == 0) {
+        err = test_hmac_reinit_check(mctx, "SHA-256", pswd, sizeof(pswd),
+            msg1, sizeof(msg1));
+    }
+    if (err == 0) {
+        PRINT_MSG("Reinitialize without key");
+        err = EVP_MAC_init(mctx, NULL, 0, NULL) != 1;
+    }
+    if (err == 0) {
+        err = test_hmac_reinit_check(mctx, "SHA-256", pswd, sizeof(pswd),
+            msg2, sizeof(msg2));
+    }
+    if (err == 0) {
+        PRINT_MSG("Reinitialize with same key after partial update");
+        err = EVP_MAC_update(mctx, msg1, sizeof(msg1)) != 1;
+    }
+    if (err == 0) {
+        err = EVP_MAC_init(mctx, pswd, sizeof(pswd), NULL) != 1;
+    }
+    if (err == 0) {
+        err = test_hmac_reinit_check(mctx, "SHA-256", pswd, sizeof(pswd),
+            msg2, sizeof(msg2));
+    }
+    if (err == 0) {
+        PRINT_MSG("Duplicate after reinitialize");
+        err = EVP_MAC_init(mctx, NULL, 0, NULL) != 1;
+    }
+    if (err == 0) {
+        err = (dup = EVP_MAC_CTX_dup(mctx)) == NULL;
+    }
+    if (err == 0) {
+        err = test_hmac_reinit_check(dup, "SHA-256", pswd, sizeof(pswd),
+            msg1, sizeof(msg1));
+    }
+    if (err == 0) {
+        PRINT_MSG("Reinitialize with different key");
+        err = EVP_MAC_init(mctx, otherPswd, sizeof(otherPswd), NULL) != 1;
+    }
+    if (err == 0) {
+        err = test_hmac_reinit_check(mctx, "SHA-256", otherPswd,
+            sizeof(otherPswd), msg1, sizeof(msg1));
+    }
+    if (err == 0) {
+        PRINT_MSG("Reinitialize with different digest");
+        params[0] = OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST,
+            (char*)"SHA-384", 0);
+        err = EVP_MAC_init(mctx, NULL, 0, params) != 1;
+    }
+    if (err == 0) {
+        err = test_hmac_reinit_check(mctx, "SHA-384", otherPswd,
+            sizeof(otherPswd), msg1, sizeof(msg1));
+    }
+
+    EVP_MAC_CTX_free(dup);
+    EVP_MAC_CTX_free(mctx);
+    EVP_MAC_free(emac);
+
+    return err;
+}
+
+static int test_hmac_sign_reuse_check(EVP_MD_CTX* ctx, EVP_PKEY* pkey,
+    const char* md, unsigned char* pswd, int pswdSz, unsigned char* msg,
+    int len)
+{
+    int err;
+    unsigned char exp[64];
+    int expLen = sizeof(exp);
+    unsigned char mac[64];
+    size_t macLen = sizeof(mac);
+
+    err = test_mac_gen_mac(osslLibCtx, md, "HMAC", pswd, pswdSz, msg, len,
+        exp, &expLen);
+    if (err == 0) {
+        err = EVP_DigestSignInit_ex(ctx, NULL, md, wpLibCtx, NULL, pkey,
+            NULL) != 1;
+    }
+    if (err == 0) {
+        err = EVP_DigestSignUpdate(ctx, msg, len) != 1;
+    }
+    if (err == 0) {
+        err = EVP_DigestSignFinal(ctx, mac, &macLen) != 1;
+    }
+    if (err == 0) {
+        PRINT_BUFFER("MAC", mac, macLen);
+        if ((macLen != (size_t)expLen) || (memcmp(mac, exp, expLen) != 0)) {
+            PRINT_MSG("generated mac and expected mac differ");
+            err = 1;
+        }
+    }
+
+    return err;
+}
+
+int test_hmac_sign_reuse(void *data)
+{
+    int err;
+    EVP_PKEY* pkey = NULL;
+    EVP_MD_CTX* ctx[2] = { NULL, NULL };
+    unsigned char pswd[] = "My empire of dirt";
+    unsigned char msg1[] = "Test message";
+    unsigned char msg2[] = "Another test message";
+
+    (void)data;
+
+    err = (pkey = EVP_PKEY_new_raw_private_key_ex(wpLibCtx, "HMAC", NULL,
+        pswd, sizeof(pswd))) == NULL;
+    if (err == 0) {
+        err = ((ctx[0] = EVP_MD_CTX_new()) == NULL) ||
+              ((ctx[1] = EVP_MD_CTX_new()) == NULL);
+    }
+    if (err == 0) {
+        PRINT_MSG("Sign with key");
+        err = test_hmac_sign_reuse_check(ctx[0], pkey, "SHA-256", pswd,
+            sizeof(pswd), msg1, sizeof(msg1));
+    }
+    if (err == 0) {
+        PRINT_MSG("Sign with key again - same context");
+        err = test_hmac_sign_reuse_check(ctx[0], pkey, "SHA-256", pswd,
+            sizeof(pswd), msg2, sizeof(msg2));
+    }
+    if (err == 0) {
+        PRINT_MSG("Sign with key again - new context");
+        err = test_hmac_sign_reuse_check(ctx[1], pkey, "SHA-256", pswd,
+            sizeof(pswd), msg1, sizeof(msg1));
+    }
+    if (err == 0) {
+        PRINT_MSG("Sign with key and different digest");
+        err = test_hmac_sign_reuse_check(ctx[0], pkey, "SHA-384", pswd,
+            sizeof(pswd), msg2, sizeof(msg2));
+    }
+    if (err == 0) {
+        PRINT_MSG("Sign with key and first digest");
+        err = test_hmac_sign_reuse_check(ctx[0], pkey, "SHA-256", pswd,
+            sizeof(pswd), msg2, sizeof(msg2));
+    }
+
+    EVP_MD_CTX_free(ctx[1]);
+    EVP_MD_CTX_free(ctx[0]);
+    EVP_PKEY_free(pkey);
+
+    return err;
+}
+
 #endif /* WP_HAVE_HMAC */
 
 
@@ -20,12 +20,139 @@
 
 #include "unit.h"
 
+#include <stdlib.h>
+#include <pthread.h>
+
 /******************************************************************************/
 
+#ifdef WOLFPROV_DEBUG
+
+/* Number of messages logged to check asynchronous logging. */
+#define TEST_LOG_CNT        1000
+
+/* Number of messages seen by logging callback. */
+static int logCnt = 0;
+/* Number in last message seen. */
+static int logLast = -1;
+/* Messages seen were in the order logged. */
+static int logInOrder = 1;
+/* A message was seen on the thread that logged it. */
+static int logOnCaller = 0;
+/* Thread that logs the messages. */
+static pthread_t logCaller;
+
+/* Check messages come in order from the writer thread. */
+static void test_logging_cb(const int logLevel, const int component,
+    const char *const logMessage)
+{
+    int num = -1;
+
+    (void)logLevel;
+    (void)component;
+
+    if (pthread_equal(pthread_self(), logCaller)) {
+        logOnCaller = 1;
+    }
+    if (strncmp(logMessage, "async ", 6) == 0) {
+        num = atoi(logMessage + 6);
+    }
+    /* Numbers skipped when messages dropped but must always increase. */
+    if (num <= logLast) {
+        logInOrder = 0;
+    }
+    else {
+        logLast = num;
+    }
+    logCnt++;
+}
+
+/* Log through the ring, stop the writer and check what was written. */
+static int test_logging_async(int slots, int cnt, int expDropped)
+{
+    int err;
+    unsigned long dropped = 0;
+    unsigned long droppedStart = 0;
+    int i;
+
+    logCnt = 0;
+    logLast = -1;
+    logInOrder = 1;
+    logOnCaller = 0;
+    logCaller = pthread_self();
+
+    err = wolfProv_GetLogDropped(&droppedStart) != 0;
+    if (err == 0) {
+        err = wolfProv_SetLogAsync(slots) != 0;
+    }
+    if (err == 0) {
+        for (i = 0; i < cnt; i++) {
+            (WOLFPROV_MSG)(WP_LOG_PROVIDER, "async %d", i);
+        }
+        /* Stopping writes out all messages in the ring. */
+        err = wolfProv_SetLogAsync(0) != 0;
+    }
+    if (err == 0) {
+        err = wolfProv_GetLogDropped(&dropped) != 0;
+    }
+    if (err == 0) {
+        dropped -= droppedStart;
+        PRINT_MSG("Check every message was written or counted as dropped");
+        err = (logCnt + (int)dropped) != cnt;
+    }
+    if ((err == 0) && (!expDropped)) {
+        err = dropped != 0;
+    }
+    if (err == 0) {
+        PRINT_MSG("Check messages written in order on the writer thread");
+        err = (!logInOrder) || logOnCaller || (logCnt == 0);
+    }
+
+    return err;
+}
+
+#endif /* WOLFPROV_DEBUG */
+
 int test_logging(void *data)
 {
+    int err = 0;
+#ifdef WOLFPROV_DEBUG
+    unsigned long dropped;
+
+    if (wolfProv_GetLogDropped(&dropped) == NOT_COMPILED_IN) {
+        PRINT_MSG("Asynchronous logging not compiled in");
+    }
+    else {
+        err = wolfProv_Debugging_ON() != 0;
+        if (err == 0) {
+            err = wolfProv_SetLogLevel(WP_LOG_INFO) != 0;
+        }
+        if (err == 0) {
+            err = wolfProv_SetLogComponents(WP_LOG_PROVIDER) != 0;
+        }
+        if (err == 0) {
+            err = wolfProv_SetLoggingCb(test_logging_cb) != 0;
+        }
+        if (err == 0) {
+            PRINT_MSG("Log through ring large enough for all messages");
+            err = test_logging_async(TEST_LOG_CNT, TEST_LOG_CNT, 0);
+        }
+        if (err == 0) {
+            PRINT_MSG("Log through ring of one slot - messages dropped");
+            err = test_logging_async(1, TEST_LOG_CNT, 1);
+        }
+
+        wolfProv_SetLoggingCb(NULL);
+        wolfProv_SetLogLevel(WP_LOG_LEVEL_ALL);
+        wolfProv_SetLogComponents(WP_LOG_COMPONENTS_ALL);
+        if (!*(int*)data) {
+            wolfProv_Debugging_OFF();
+        }
+    }
+#else
     (void)data;
-    return 0;
+#endif
+
+    return err;
 }
 
 /******************************************************************************/
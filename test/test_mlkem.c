@@ -0,0 +1,280 @@
+/* test_mlkem.c
+ *
+ * Copyright (C) 2021 wolfSSL Inc.
+ *
+ * This file is part of wolfProvider.
+ *
+ * wolfProvider is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfProvider is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wolfProvider.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "unit.h"
+
+#include <openssl/core_names.h>
+
+#ifdef WP_HAVE_MLKEM
+
+/* Largest encodings - SecP256r1MLKEM768 public key and private key. */
+#define TEST_MLKEM_MAX_PUB_LEN      (1184 + 65)
+#define TEST_MLKEM_MAX_PRIV_LEN     (2400 + 32)
+#define TEST_MLKEM_MAX_CT_LEN       (1088 + 65)
+#define TEST_MLKEM_MAX_SS_LEN       (32 + 32)
+
+/* Generate a key pair as a TLS client does - set the group name. */
+static int test_mlkem_keygen(const char* name, EVP_PKEY** pkey)
+{
+    int err;
+    EVP_PKEY_CTX *ctx = NULL;
+
+    err = (ctx = EVP_PKEY_CTX_new_from_name(wpLibCtx, name, NULL)) == NULL;
+    if (err == 0) {
+        err = EVP_PKEY_keygen_init(ctx) != 1;
+    }
+    if (err == 0) {
+        err = EVP_PKEY_CTX_set_group_name(ctx, name) != 1;
+    }
+    if (err == 0) {
+        err = EVP_PKEY_keygen(ctx, pkey) != 1;
+    }
+
+    EVP_PKEY_CTX_free(ctx);
+    return err;
+}
+
+/* Create a key holding the peer's share as a TLS server does. */
+static int test_mlkem_peer(const char* name, const unsigned char* pub,
+    size_t pubLen, EVP_PKEY** pkey)
+{
+    int err;
+    EVP_PKEY_CTX *ctx = NULL;
+
+    err = (ctx = EVP_PKEY_CTX_new_from_name(wpLibCtx, name, NULL)) == NULL;
+    if (err == 0) {
+        err = EVP_PKEY_paramgen_init(ctx) != 1;
+    }
+    if (err == 0) {
+        err = EVP_PKEY_CTX_set_group_name(ctx, name) != 1;
+    }
+    if (err == 0) {
+        err = EVP_PKEY_paramgen(ctx, pkey) != 1;
+    }
+    if (err == 0) {
+        err = EVP_PKEY_set1_encoded_public_key(*pkey, pub, pubLen) != 1;
+    }
+
+    EVP_PKEY_CTX_free(ctx);
+    return err;
+}
+
+static int test_mlkem_encap(EVP_PKEY* peer, unsigned char* ct, size_t* ctLen,
+    unsigned char* ss, size_t* ssLen)
+{
+    int err;
+    EVP_PKEY_CTX *ctx = NULL;
+    size_t expCtLen = 0;
+    size_t expSsLen = 0;
+
+    err = (ctx = EVP_PKEY_CTX_new_from_pkey(wpLibCtx, peer, NULL)) == NULL;
+    if (err == 0) {
+        err = EVP_PKEY_encapsulate_init(ctx, NULL) != 1;
+    }
+    if (err == 0) {
+        err = EVP_PKEY_encapsulate(ctx, NULL, &expCtLen, NULL, &expSsLen) != 1;
+    }
+    if (err == 0) {
+        err = (expCtLen != *ctLen) || (expSsLen != *ssLen);
+    }
+    if (err == 0) {
+        err = EVP_PKEY_encapsulate(ctx, ct, ctLen, ss, ssLen) != 1;
+    }
+    if (err == 0) {
+        err = (expCtLen != *ctLen) || (expSsLen != *ssLen);
+    }
+
+    EVP_PKEY_CTX_free(ctx);
+    return err;
+}
+
+static int test_mlkem_decap(EVP_PKEY* pkey, const unsigned char* ct,
+    size_t ctLen, unsigned char* ss, size_t* ssLen, int expFail)
+{
+    int err;
+    EVP_PKEY_CTX *ctx = NULL;
+    size_t expSsLen = 0;
+
+    err = (ctx = EVP_PKEY_CTX_new_from_pkey(wpLibCtx, pkey, NULL)) == NULL;
+    if (err == 0) {
+        err = EVP_PKEY_decapsulate_init(ctx, NULL) != 1;
+    }
+    if (err == 0) {
+        err = EVP_PKEY_decapsulate(ctx, NULL, &expSsLen, ct, ctLen) != 1;
+    }
+    if (err == 0) {
+        err = expSsLen != *ssLen;
+    }
+    if (err == 0) {
+        int rc = EVP_PKEY_decapsulate(ctx, ss, ssLen, ct, ctLen);
+        err = expFail ? (rc == 1) : (rc != 1);
+    }
+
+    EVP_PKEY_CTX_free(ctx);
+    return err;
+}
+
+/* Check the X25519 half of X25519MLKEM768 against OpenSSL's X25519. */
+static int test_x25519mlkem768_classical(EVP_PKEY* pkey,
+    const unsigned char* pub, const unsigned char* ct, const unsigned char* ss)
+{
+    int err;
+    unsigned char priv[TEST_MLKEM_MAX_PRIV_LEN];
+    size_t privLen = 0;
+    unsigned char x25519Pub[32];
+    size_t x25519PubLen = sizeof(x25519Pub);
+    unsigned char secret[32];
+    size_t secretLen = sizeof(secret);
+    EVP_PKEY *privKey = NULL;
+    EVP_PKEY *peerKey = NULL;
+    EVP_PKEY_CTX *ctx = NULL;
+
+    err = EVP_PKEY_get_octet_string_param(pkey, OSSL_PKEY_PARAM_PRIV_KEY, priv,
+        sizeof(priv), &privLen) != 1;
+    if (err == 0) {
+        err = privLen != 2400 + 32;
+    }
+    if (err == 0) {
+        err = (privKey = EVP_PKEY_new_raw_private_key_ex(osslLibCtx, "X25519",
+            NULL, priv + 2400, 32)) == NULL;
+    }
+    if (err == 0) {
+        err = EVP_PKEY_get_raw_public_key(privKey, x25519Pub,
+            &x25519PubLen) != 1;
+    }
+    if (err == 0) {
+        PRINT_BUFFER("X25519 public", pub + 1184, 32);
+        err = memcmp(x25519Pub, pub + 1184, 32) != 0;
+    }
+    if (err == 0) {
+        err = (peerKey = EVP_PKEY_new_raw_public_key_ex(osslLibCtx, "X25519",
+            NULL, ct + 1088, 32)) == NULL;
+    }
+    if (err == 0) {
+        err = (ctx = EVP_PKEY_CTX_new_from_pkey(osslLibCtx, privKey,
+            NULL)) == NULL;
+    }
+    if (err == 0) {
+        err = EVP_PKEY_derive_init(ctx) != 1;
+    }
+    if (err == 0) {
+        err = EVP_PKEY_derive_set_peer(ctx, peerKey) != 1;
+    }
+    if (err == 0) {
+        err = EVP_PKEY_derive(ctx, secret, &secretLen) != 1;
+    }
+    if (err == 0) {
+        PRINT_BUFFER("X25519 secret", secret, secretLen);
+        err = (secretLen != 32) || (memcmp(secret, ss + 32, 32) != 0);
+    }
+
+    EVP_PKEY_CTX_free(ctx);
+    EVP_PKEY_free(peerKey);
+    EVP_PKEY_free(privKey);
+    OPENSSL_cleanse(priv, sizeof(priv));
+    return err;
+}
+
+static int test_mlkem_name(const char* name, size_t pubLen, size_t ctLen,
+    size_t ssLen)
+{
+    int err;
+    EVP_PKEY *pkey = NULL;
+    EVP_PKEY *peer = NULL;
+    unsigned char pub[TEST_MLKEM_MAX_PUB_LEN];
+    size_t len = 0;
+    unsigned char ct[TEST_MLKEM_MAX_CT_LEN];
+    size_t outCtLen = ctLen;
+    unsigned char ssEnc[TEST_MLKEM_MAX_SS_LEN];
+    size_t ssEncLen = ssLen;
+    unsigned char ssDec[TEST_MLKEM_MAX_SS_LEN];
+    size_t ssDecLen = ssLen;
+
+    PRINT_MSG(name);
+
+    err = test_mlkem_keygen(name, &pkey);
+    if (err == 0) {
+        err = EVP_PKEY_get_octet_string_param(pkey,
+            OSSL_PKEY_PARAM_ENCODED_PUBLIC_KEY, pub, sizeof(pub), &len) != 1;
+    }
+    if (err == 0) {
+        err = len != pubLen;
+    }
+    if (err == 0) {
+        err = test_mlkem_peer(name, pub, len, &peer);
+    }
+    if (err == 0) {
+        /* Wrong length of share must be rejected. */
+        err = EVP_PKEY_set1_encoded_public_key(peer, pub, len - 1) == 1;
+    }
+    if (err == 0) {
+        err = test_mlkem_encap(peer, ct, &outCtLen, ssEnc, &ssEncLen);
+    }
+    if (err == 0) {
+        err = test_mlkem_decap(pkey, ct, outCtLen, ssDec, &ssDecLen, 0);
+    }
+    if (err == 0) {
+        PRINT_BUFFER("Shared secret", ssDec, ssDecLen);
+        err = memcmp(ssEnc, ssDec, ssLen) != 0;
+    }
+    if ((err == 0) && (strcmp(name, "X25519MLKEM768") == 0)) {
+        err = test_x25519mlkem768_classical(pkey, pub, ct, ssEnc);
+    }
+    if ((err == 0) && (strcmp(name, "ML-KEM-768") == 0)) {
+        /* Implicit rejection - different secret for modified ciphertext. */
+        ct[0] ^= 0x01;
+        err = test_mlkem_decap(pkey, ct, outCtLen, ssDec, &ssDecLen, 0);
+        if (err == 0) {
+            err = memcmp(ssEnc, ssDec, ssLen) == 0;
+        }
+    }
+    if (err == 0) {
+        /* Wrong length of ciphertext must be rejected. */
+        err = test_mlkem_decap(pkey, ct, outCtLen - 1, ssDec, &ssDecLen, 1);
+    }
+
+    EVP_PKEY_free(peer);
+    EVP_PKEY_free(pkey);
+    return err;
+}
+
+int test_mlkem_768(void *data)
+{
+    (void)data;
+
+    return test_mlkem_name("ML-KEM-768", 1184, 1088, 32);
+}
+
+int test_x25519mlkem768(void *data)
+{
+    (void)data;
+
+    return test_mlkem_name("X25519MLKEM768", 1184 + 32, 1088 + 32, 32 + 32);
+}
+
+int test_secp256r1mlkem768(void *data)
+{
+    (void)data;
+
+    return test_mlkem_name("SecP256r1MLKEM768", 65 + 1184, 65 + 1088,
+        32 + 32);
+}
+
+#endif /* WP_HAVE_MLKEM */
@@ -20,6 +20,11 @@
 
 #include "unit.h"
 
+#include <openssl/x509.h>
+#include <openssl/decoder.h>
+
+#include <wolfprovider/wp_params.h>
+
 #ifdef WP_HAVE_PBE
 
 static const unsigned char pbeData[] = {
@@ -360,5 +365,311 @@ int test_pbe(void *data)
     return err;
 }
 
+
+static int test_pbkdf2_calc(OSSL_LIB_CTX* libCtx, const char* md,
+    unsigned int threads, unsigned char* key, size_t keyLen)
+{
+    int err;
+    EVP_KDF* kdf = NULL;
+    EVP_KDF_CTX* kctx = NULL;
+    OSSL_PARAM params[6];
+    OSSL_PARAM* p = params;
+    unsigned char pswd[] = "My empire of dirt";
+    unsigned char salt[16] = { 0, };
+    uint64_t iter = 1000;
+
+    *p++ = OSSL_PARAM_construct_utf8_string(OSSL_KDF_PARAM_DIGEST,
+        (char*)md, 0);
+    *p++ = OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_PASSWORD, pswd,
+        sizeof(pswd) - 1);
+    *p++ = OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_SALT, salt,
+        sizeof(salt));
+    *p++ = OSSL_PARAM_construct_uint64(OSSL_KDF_PARAM_ITER, &iter);
+    if (threads > 0) {
+        *p++ = OSSL_PARAM_construct_uint(WP_KDF_PARAM_THREADS, &threads);
+    }
+    *p = OSSL_PARAM_construct_end();
+
+    err = (kdf = EVP_KDF_fetch(libCtx, "PBKDF2", NULL)) == NULL;
+    if (err == 0) {
+        err = (kctx = EVP_KDF_CTX_new(kdf)) == NULL;
+    }
+    if (err == 0) {
+        err = EVP_KDF_derive(kctx, key, keyLen, params) != 1;
+    }
+
+    EVP_KDF_CTX_free(kctx);
+    EVP_KDF_free(kdf);
+    return err;
+}
+
+static int test_pbkdf2_threads_md(const char* md, size_t keyLen)
+{
+    int err;
+    unsigned int threads;
+    unsigned char exp[200];
+    unsigned char key[200];
+
+    PRINT_MSG(md);
+    err = test_pbkdf2_calc(osslLibCtx, md, 0, exp, keyLen);
+    if (err != 0) {
+        PRINT_MSG("FAILED OpenSSL");
+    }
+    for (threads = 0; (err == 0) && (threads <= 4); threads++) {
+        memset(key, 0, sizeof(key));
+        err = test_pbkdf2_calc(wpLibCtx, md, threads, key, keyLen);
+        if (err != 0) {
+            PRINT_MSG("FAILED wolfSSL");
+        }
+        else if (memcmp(key, exp, keyLen) != 0) {
+            PRINT_BUFFER("OpenSSL key", exp, keyLen);
+            PRINT_BUFFER("wolfSSL key", key, keyLen);
+            err = 1;
+        }
+    }
+
+    return err;
+}
+
+int test_pbkdf2_threads(void *data)
+{
+    int err;
+
+    (void)data;
+
+    err = test_pbkdf2_threads_md("SHA256", 64);
+    if (err == 0) {
+        err = test_pbkdf2_threads_md("SHA256", 100);
+    }
+    if (err == 0) {
+        err = test_pbkdf2_threads_md("SHA512", 200);
+    }
+    if (err == 0) {
+        err = test_pbkdf2_threads_md("SHA1", 20);
+    }
+
+    return err;
+}
+
+/* Passphrase that private keys are encrypted with. */
+static const char epkiPass[] = "wolfprov epki";
+
+/* Encrypt a private key into a DER encoded EncryptedPrivateKeyInfo with
+ * PBES2. */
+static int test_epki_encode(EVP_PKEY* pkey, const char* cipherName,
+    int prfNid, unsigned char** der, int* derLen)
+{
+    int err;
+    EVP_CIPHER* cipher = NULL;
+    PKCS8_PRIV_KEY_INFO* p8 = NULL;
+    X509_ALGOR* pbe = NULL;
+    X509_SIG* p8e = NULL;
+
+    err = (cipher = EVP_CIPHER_fetch(osslLibCtx, cipherName, "")) == NULL;
+    if (err == 0) {
+        err = (p8 = EVP_PKEY2PKCS8(pkey)) == NULL;
+    }
+    if (err == 0) {
+        err = (pbe = PKCS5_pbe2_set_iv_ex(cipher, 2048, NULL, 0, NULL, prfNid,
+                                          osslLibCtx)) == NULL;
+    }
+    if (err == 0) {
+        err = (p8e = PKCS8_set0_pbe_ex(epkiPass, sizeof(epkiPass) - 1, p8,
+                                       pbe, osslLibCtx, NULL)) == NULL;
+        if (err == 0) {
+            /* Owned by encrypted key now. */
+            pbe = NULL;
+        }
+    }
+    if (err == 0) {
+        err = (*derLen = i2d_X509_SIG(p8e, der)) <= 0;
+    }
+
+    X509_SIG_free(p8e);
+    X509_ALGOR_free(pbe);
+    PKCS8_PRIV_KEY_INFO_free(p8);
+    EVP_CIPHER_free(cipher);
+
+    return err;
+}
+
+/* Decode an EncryptedPrivateKeyInfo with wolfProvider and compare the key. */
+static int test_epki_decode(OSSL_LIB_CTX* libCtx, const unsigned char* der,
+    size_t derLen, const char* pass, EVP_PKEY* exp)
+{
+    int err;
+    OSSL_DECODER_CTX* dctx = NULL;
+    EVP_PKEY* pkey = NULL;
+
+    err = (dctx = OSSL_DECODER_CTX_new_for_pkey(&pkey, "DER", NULL, "EC",
+                                                EVP_PKEY_KEYPAIR, libCtx,
+                                                NULL)) == NULL;
+    if (err == 0) {
+        err = OSSL_DECODER_CTX_set_passphrase(dctx,
+                                              (const unsigned char*)pass,
+                                              strlen(pass)) != 1;
+    }
+    if (err == 0) {
+        err = OSSL_DECODER_from_data(dctx, &der, &derLen) != 1;
+    }
+    if (err == 0) {
+        err = (pkey == NULL) || (EVP_PKEY_eq(pkey, exp) != 1);
+    }
+
+    EVP_PKEY_free(pkey);
+    OSSL_DECODER_CTX_free(dctx);
+
+    return err;
+}
+
+/* Keep the first provider of the library context. */
+static int test_epki_get_prov(OSSL_PROVIDER* prov, void* arg)
+{
+    *(OSSL_PROVIDER**)arg = prov;
+    return 0;
+}
+
+/* Get the number of derived keys found in the PBKDF2 cache. */
+static int test_epki_cache_hits(OSSL_LIB_CTX* libCtx, uint64_t* hits)
+{
+    int err;
+    OSSL_PROVIDER* prov = NULL;
+    OSSL_PARAM params[2];
+
+    OSSL_PROVIDER_do_all(libCtx, test_epki_get_prov, &prov);
+    err = prov == NULL;
+    if (err == 0) {
+        params[0] = OSSL_PARAM_construct_uint64(
+            WP_PROV_PARAM_PBKDF2_CACHE_HITS, hits);
+        params[1] = OSSL_PARAM_construct_end();
+        err = OSSL_PROVIDER_get_params(prov, params) != 1;
+    }
+
+    return err;
+}
+
+/* Decode twice - second decode uses key from cache. */
+static int test_epki_cache_op(OSSL_LIB_CTX* libCtx, EVP_PKEY* pkey,
+    const char* cipherName, int prfNid)
+{
+    int err;
+    unsigned char* der = NULL;
+    int derLen = 0;
+    uint64_t hits[3] = { 0, 0, 0 };
+    int i;
+
+    err = test_epki_encode(pkey, cipherName, prfNid, &der, &derLen);
+    if (err == 0) {
+        err = test_epki_cache_hits(libCtx, &hits[0]);
+    }
+    for (i = 1; (err == 0) && (i < 3); i++) {
+        err = test_epki_decode(libCtx, der, derLen, epkiPass, pkey);
+        if (err == 0) {
+            err = test_epki_cache_hits(libCtx, &hits[i]);
+        }
+    }
+    if (err == 0) {
+        PRINT_MSG("Check first decode derived key and second used cache");
+        err = (hits[1] != hits[0]) || (hits[2] != hits[1] + 1);
+    }
+
+    OPENSSL_free(der);
+
+    return err;
+}
+
+/* Wrong passphrase, truncated and corrupted encodings fail to decode. */
+static int test_epki_cache_bad(OSSL_LIB_CTX* libCtx, EVP_PKEY* pkey)
+{
+    int err;
+    unsigned char* der = NULL;
+    int derLen = 0;
+    uint64_t hits[2] = { 0, 0 };
+    int i;
+
+    err = test_epki_encode(pkey, "AES-128-CBC", NID_hmacWithSHA256, &der,
+                           &derLen);
+    if (err == 0) {
+        err = test_epki_decode(libCtx, der, derLen, epkiPass, pkey);
+    }
+    if (err == 0) {
+        err = test_epki_cache_hits(libCtx, &hits[0]);
+    }
+    if (err == 0) {
+        PRINT_MSG("Wrong passphrase fails - derived key not from cache");
+        err = test_epki_decode(libCtx, der, derLen, "wrong", pkey) == 0;
+    }
+    if (err == 0) {
+        err = test_epki_cache_hits(libCtx, &hits[1]);
+    }
+    if (err == 0) {
+        err = hits[1] != hits[0];
+    }
+    if (err == 0) {
+        PRINT_MSG("Truncated encoding fails");
+        err = test_epki_decode(libCtx, der, derLen - 1, epkiPass, pkey) == 0;
+    }
+    if (err == 0) {
+        err = test_epki_decode(libCtx, der, derLen / 2, epkiPass, pkey) == 0;
+    }
+    if (err == 0) {
+        err = test_epki_decode(libCtx, der, 16, epkiPass, pkey) == 0;
+    }
+    /* Parameters are at the start of the encoding. Corrupted parameters
+     * either fail to decode or, when not used, give the same key. */
+    for (i = 0; (err == 0) && (i < 80) && (i < derLen); i++) {
+        unsigned char* corrupt = (unsigned char*)OPENSSL_memdup(der, derLen);
+
+        err = corrupt == NULL;
+        if (err == 0) {
+            corrupt[i] ^= 0x41;
+            (void)test_epki_decode(libCtx, corrupt, derLen, epkiPass, pkey);
+        }
+        OPENSSL_free(corrupt);
+    }
+
+    OPENSSL_free(der);
+
+    return err;
+}
+
+int test_pbe_epki_cache(void *data)
+{
+    int err;
+    OSSL_LIB_CTX* libCtx = NULL;
+    EVP_PKEY* pkey = NULL;
+
+    (void)data;
+
+    err = (libCtx = test_conf_libctx("pbkdf2-cache-size = 16")) == NULL;
+    if (err == 0) {
+        err = (pkey = EVP_PKEY_Q_keygen(osslLibCtx, NULL, "EC", "P-256")) ==
+              NULL;
+    }
+    if (err == 0) {
+        PRINT_MSG("PBES2 AES-128-CBC HMAC-SHA-256 decoded twice");
+        err = test_epki_cache_op(libCtx, pkey, "AES-128-CBC",
+                                 NID_hmacWithSHA256);
+    }
+    if (err == 0) {
+        PRINT_MSG("PBES2 AES-256-CBC HMAC-SHA-256 decoded twice");
+        err = test_epki_cache_op(libCtx, pkey, "AES-256-CBC",
+                                 NID_hmacWithSHA256);
+    }
+    if (err == 0) {
+        PRINT_MSG("PBES2 AES-256-CBC HMAC-SHA-512 decoded twice");
+        err = test_epki_cache_op(libCtx, pkey, "AES-256-CBC",
+                                 NID_hmacWithSHA512);
+    }
+    if (err == 0) {
+        err = test_epki_cache_bad(libCtx, pkey);
+    }
+
+    EVP_PKEY_free(pkey);
+    OSSL_LIB_CTX_free(libCtx);
+
+    return err;
+}
+
 #endif /* WP_HAVE_PBE */
 
@@ -20,6 +20,8 @@
 
 #include "unit.h"
 
+#include <wolfprovider/wp_params.h>
+
 #ifdef WP_HAVE_RANDOM
 
 static int test_random_api()
@@ -67,4 +69,86 @@ int test_random(void *data)
     return err;
 }
 
+int test_random_buffered(void *data)
+{
+    int err;
+    EVP_RAND* rand = NULL;
+    EVP_RAND_CTX* ctx = NULL;
+    OSSL_PARAM params[3];
+    size_t bufSize = 4096;
+    size_t badSize = 65537;
+    int useAdIn = 1;
+    unsigned char prev[16];
+    unsigned char buf[16];
+    unsigned char* big = NULL;
+    unsigned char adIn[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    int i;
+
+    (void)data;
+
+    err = (rand = EVP_RAND_fetch(wpLibCtx, "HASH-DRBG", NULL)) == NULL;
+    if (err == 0) {
+        err = (ctx = EVP_RAND_CTX_new(rand, NULL)) == NULL;
+    }
+    if (err == 0) {
+        PRINT_MSG("Set DRBG output buffer size");
+        params[0] = OSSL_PARAM_construct_size_t(WP_DRBG_PARAM_BUFFER_SIZE,
+            &bufSize);
+        params[1] = OSSL_PARAM_construct_end();
+        err = EVP_RAND_CTX_set_params(ctx, params) != 1;
+    }
+    if (err == 0) {
+        err = EVP_RAND_instantiate(ctx, 256, 0, NULL, 0, NULL) != 1;
+    }
+    if (err == 0) {
+        err = EVP_RAND_generate(ctx, prev, sizeof(prev), 256, 0, NULL,
+            0) != 1;
+    }
+    if (err == 0) {
+        PRINT_MSG("Generate small amounts through buffer");
+        for (i = 0; (err == 0) && (i < 1000); i++) {
+            err = EVP_RAND_generate(ctx, buf, sizeof(buf), 256, 0, NULL,
+                0) != 1;
+            if (err == 0) {
+                err = memcmp(prev, buf, sizeof(buf)) == 0;
+            }
+            memcpy(prev, buf, sizeof(buf));
+        }
+    }
+    if (err == 0) {
+        PRINT_MSG("Generate more than buffer size");
+        err = (big = OPENSSL_malloc(bufSize * 2)) == NULL;
+    }
+    if (err == 0) {
+        err = EVP_RAND_generate(ctx, big, bufSize * 2, 256, 0, NULL, 0) != 1;
+    }
+    if (err == 0) {
+        PRINT_MSG("Generate with additional input and prediction resistance");
+        params[0] = OSSL_PARAM_construct_int(WP_DRBG_PARAM_USE_ADIN,
+            &useAdIn);
+        params[1] = OSSL_PARAM_construct_end();
+        err = EVP_RAND_CTX_set_params(ctx, params) != 1;
+    }
+    if (err == 0) {
+        err = EVP_RAND_generate(ctx, buf, sizeof(buf), 256, 1, adIn,
+            sizeof(adIn)) != 1;
+    }
+    if (err == 0) {
+        err = memcmp(prev, buf, sizeof(buf)) == 0;
+    }
+    if (err == 0) {
+        PRINT_MSG("Check buffer size too big fails");
+        params[0] = OSSL_PARAM_construct_size_t(WP_DRBG_PARAM_BUFFER_SIZE,
+            &badSize);
+        params[1] = OSSL_PARAM_construct_end();
+        err = EVP_RAND_CTX_set_params(ctx, params) == 1;
+    }
+
+    OPENSSL_free(big);
+    EVP_RAND_CTX_free(ctx);
+    EVP_RAND_free(rand);
+
+    return err;
+}
+
 #endif /* WP_HAVE_RANDOM */
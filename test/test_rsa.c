@@ -21,8 +21,12 @@
 #include "unit.h"
 #include <wolfprovider/wp_fips.h>
 
+#include <unistd.h>
+
 #include <openssl/store.h>
+#include <openssl/decoder.h>
 #include <openssl/core_names.h>
+#include <openssl/param_build.h>
 
 #ifdef WP_HAVE_RSA
 
@@ -658,6 +662,106 @@ int test_rsa_pkey_keygen(void *data)
     return err;
 }
 
+/* Sign and verify with a key to check that it is a valid key pair. */
+static int test_rsa_pool_key_check(OSSL_LIB_CTX* libCtx, EVP_PKEY* pkey)
+{
+    int err;
+    EVP_MD_CTX* mdCtx = NULL;
+    unsigned char msg[32];
+    unsigned char sig[512];
+    size_t sigLen = sizeof(sig);
+
+    err = RAND_bytes(msg, sizeof(msg)) != 1;
+    if (err == 0) {
+        err = (mdCtx = EVP_MD_CTX_new()) == NULL;
+    }
+    if (err == 0) {
+        err = EVP_DigestSignInit_ex(mdCtx, NULL, "SHA256", libCtx, NULL, pkey,
+                                    NULL) != 1;
+    }
+    if (err == 0) {
+        err = EVP_DigestSign(mdCtx, sig, &sigLen, msg, sizeof(msg)) != 1;
+    }
+    if (err == 0) {
+        err = EVP_DigestVerifyInit_ex(mdCtx, NULL, "SHA256", libCtx, NULL,
+                                      pkey, NULL) != 1;
+    }
+    if (err == 0) {
+        err = EVP_DigestVerify(mdCtx, sig, sigLen, msg, sizeof(msg)) != 1;
+    }
+
+    EVP_MD_CTX_free(mdCtx);
+
+    return err;
+}
+
+/* RSA keys of pooled sizes are taken from the key pool once filled. Pooled
+ * keys must be valid, different and not shared with a forked child. */
+int test_rsa_pkey_keygen_pool(void *data)
+{
+    int err;
+    OSSL_LIB_CTX* libCtx;
+    EVP_PKEY_CTX *ctx = NULL;
+    EVP_PKEY *pkey[3] = { NULL, NULL, NULL };
+    BIGNUM *n[3] = { NULL, NULL, NULL };
+    int i;
+
+    (void)data;
+
+    PRINT_MSG("Load provider with RSA key pool");
+    err = (libCtx = test_conf_libctx("keygen-pool-rsa-depth = 2")) == NULL;
+    if (err == 0) {
+        err = (ctx = EVP_PKEY_CTX_new_from_name(libCtx, "RSA", NULL)) == NULL;
+    }
+    if (err == 0) {
+        err = EVP_PKEY_keygen_init(ctx) != 1;
+    }
+    if (err == 0) {
+        err = EVP_PKEY_CTX_set_rsa_keygen_bits(ctx, 2048) != 1;
+    }
+    if (err == 0) {
+        PRINT_MSG("Generate key to start filling pool");
+        err = EVP_PKEY_keygen(ctx, &pkey[0]) != 1;
+        /* Give the pool's threads time to fill the slot. */
+        sleep(3);
+    }
+    for (i = 1; (err == 0) && (i < 3); i++) {
+        PRINT_MSG("Generate key - from pool when filled");
+        err = EVP_PKEY_keygen(ctx, &pkey[i]) != 1;
+    }
+    for (i = 0; (err == 0) && (i < 3); i++) {
+        PRINT_MSG("Check key is a valid key pair");
+        err = test_rsa_pool_key_check(libCtx, pkey[i]);
+        if (err == 0) {
+            err = EVP_PKEY_get_bn_param(pkey[i], OSSL_PKEY_PARAM_RSA_N,
+                                        &n[i]) != 1;
+        }
+        if (err == 0) {
+            err = BN_num_bits(n[i]) != 2048;
+        }
+    }
+    if (err == 0) {
+        PRINT_MSG("Check keys are different");
+        err = (BN_cmp(n[0], n[1]) == 0) || (BN_cmp(n[0], n[2]) == 0) ||
+              (BN_cmp(n[1], n[2]) == 0);
+    }
+    if (err == 0) {
+        /* Refill pool so the parent's keys are inherited by the child. */
+        sleep(3);
+        PRINT_MSG("Generate keys in parent and forked child");
+        err = test_fork_keygen_differ(ctx);
+    }
+
+    for (i = 0; i < 3; i++) {
+        BN_free(n[i]);
+        EVP_PKEY_free(pkey[i]);
+    }
+    EVP_PKEY_CTX_free(ctx);
+    OSSL_LIB_CTX_free(libCtx);
+
+    return err;
+}
+
 int test_rsa_pkey_invalid_key_size(void *data) {
     int err;
     EVP_PKEY *pkey = NULL;
@@ -722,6 +826,254 @@ int test_rsa_pkey_invalid_key_size(void *data) {
     return err;
 }
 
+int test_rsa_import_no_crt(void *data)
+{
+    int err;
+    EVP_PKEY *pkey = NULL;
+    EVP_PKEY *imported = NULL;
+    EVP_PKEY_CTX *ctx = NULL;
+    OSSL_PARAM_BLD *bld = NULL;
+    OSSL_PARAM *params = NULL;
+    BIGNUM *num[5] = { NULL, NULL, NULL, NULL, NULL };
+    const char *keys[5] = {
+        OSSL_PKEY_PARAM_RSA_N, OSSL_PKEY_PARAM_RSA_E, OSSL_PKEY_PARAM_RSA_D,
+        OSSL_PKEY_PARAM_RSA_FACTOR1, OSSL_PKEY_PARAM_RSA_FACTOR2
+    };
+    unsigned char sig[256];
+    size_t sigLen = sizeof(sig);
+    unsigned char buf[20];
+    const unsigned char *p = rsa_key_der_2048;
+    int i;
+
+    (void)data;
+
+    PRINT_MSG("Load RSA key");
+    pkey = d2i_PrivateKey_ex(EVP_PKEY_RSA, NULL, &p, sizeof(rsa_key_der_2048),
+        osslLibCtx, NULL);
+    err = pkey == NULL;
+    for (i = 0; (err == 0) && (i < 5); i++) {
+        err = EVP_PKEY_get_bn_param(pkey, keys[i], &num[i]) != 1;
+    }
+    if (err == 0) {
+        err = (bld = OSSL_PARAM_BLD_new()) == NULL;
+    }
+    for (i = 0; (err == 0) && (i < 5); i++) {
+        err = OSSL_PARAM_BLD_push_BN(bld, keys[i], num[i]) != 1;
+    }
+    if (err == 0) {
+        err = (params = OSSL_PARAM_BLD_to_param(bld)) == NULL;
+    }
+    if (err == 0) {
+        PRINT_MSG("Import RSA private key without CRT numbers");
+        err = (ctx = EVP_PKEY_CTX_new_from_name(wpLibCtx, "RSA", NULL)) == NULL;
+    }
+    if (err == 0) {
+        err = EVP_PKEY_fromdata_init(ctx) != 1;
+    }
+    if (err == 0) {
+        err = EVP_PKEY_fromdata(ctx, &imported, EVP_PKEY_KEYPAIR,
+            params) != 1;
+    }
+    if (err == 0) {
+        err = RAND_bytes(buf, sizeof(buf)) == 0;
+    }
+    if (err == 0) {
+        PRINT_MSG("Sign with wolfprovider");
+        err = test_digest_sign(imported, wpLibCtx, buf, sizeof(buf),
+            "SHA-256", sig, &sigLen, RSA_PKCS1_PADDING);
+    }
+    if (err == 0) {
+        PRINT_MSG("Verify with OpenSSL");
+        err = test_digest_verify(pkey, osslLibCtx, buf, sizeof(buf),
+            "SHA-256", sig, sigLen, RSA_PKCS1_PADDING);
+    }
+
+    for (i = 0; i < 5; i++) {
+        BN_free(num[i]);
+    }
+    OSSL_PARAM_free(params);
+    OSSL_PARAM_BLD_free(bld);
+    EVP_PKEY_CTX_free(ctx);
+    EVP_PKEY_free(imported);
+    EVP_PKEY_free(pkey);
+
+    return err;
+}
+
+#ifdef WOLF_CRYPTO_CB
+int test_rsa_multi_prime(void *data)
+{
+    int err;
+    EVP_PKEY *pkey = NULL;
+    EVP_PKEY *imported = NULL;
+    EVP_PKEY *genKey = NULL;
+    EVP_PKEY_CTX *ctx = NULL;
+    OSSL_PARAM *params = NULL;
+    unsigned char sig[256];
+    size_t sigLen = sizeof(sig);
+    unsigned char ct[256];
+    unsigned char buf[20];
+
+    (void)data;
+
+    PRINT_MSG("Generate 3-prime RSA key with OpenSSL");
+    err = (ctx = EVP_PKEY_CTX_new_from_name(osslLibCtx, "RSA", NULL)) == NULL;
+    if (err == 0) {
+        err = EVP_PKEY_keygen_init(ctx) != 1;
+    }
+    if (err == 0) {
+        err = EVP_PKEY_CTX_set_rsa_keygen_bits(ctx, 2048) <= 0;
+    }
+    if (err == 0) {
+        err = EVP_PKEY_CTX_set_rsa_keygen_primes(ctx, 3) <= 0;
+    }
+    if (err == 0) {
+        err = EVP_PKEY_keygen(ctx, &pkey) != 1;
+    }
+    if (err == 0) {
+        err = EVP_PKEY_todata(pkey, EVP_PKEY_KEYPAIR, &params) != 1;
+    }
+    EVP_PKEY_CTX_free(ctx);
+    ctx = NULL;
+    if (err == 0) {
+        PRINT_MSG("Import 3-prime RSA key into wolfprovider");
+        err = (ctx = EVP_PKEY_CTX_new_from_name(wpLibCtx, "RSA", NULL)) == NULL;
+    }
+    if (err == 0) {
+        err = EVP_PKEY_fromdata_init(ctx) != 1;
+    }
+    if (err == 0) {
+        err = EVP_PKEY_fromdata(ctx, &imported, EVP_PKEY_KEYPAIR,
+            params) != 1;
+    }
+    EVP_PKEY_CTX_free(ctx);
+    ctx = NULL;
+    if (err == 0) {
+        err = RAND_bytes(buf, sizeof(buf)) == 0;
+    }
+    if (err == 0) {
+        PRINT_MSG("Sign with wolfprovider");
+        err = test_digest_sign(imported, wpLibCtx, buf, sizeof(buf),
+            "SHA-256", sig, &sigLen, RSA_PKCS1_PSS_PADDING);
+    }
+    if (err == 0) {
+        PRINT_MSG("Verify with OpenSSL");
+        err = test_digest_verify(pkey, osslLibCtx, buf, sizeof(buf),
+            "SHA-256", sig, sigLen, RSA_PKCS1_PSS_PADDING);
+    }
+    if (err == 0) {
+        PRINT_MSG("Encrypt with OpenSSL");
+        err = test_pkey_enc(pkey, osslLibCtx, buf, sizeof(buf), ct,
+            sizeof(ct), RSA_PKCS1_OAEP_PADDING, NULL, NULL);
+    }
+    if (err == 0) {
+        PRINT_MSG("Decrypt with wolfprovider");
+        err = test_pkey_dec(imported, wpLibCtx, buf, sizeof(buf), ct,
+            sizeof(ct), RSA_PKCS1_OAEP_PADDING, NULL, NULL);
+    }
+
+#if defined(WOLFSSL_KEY_GEN) && !defined(HAVE_FIPS)
+    if (err == 0) {
+        PRINT_MSG("Generate 3-prime RSA key with wolfprovider");
+        err = (ctx = EVP_PKEY_CTX_new_from_name(wpLibCtx, "RSA", NULL)) == NULL;
+    }
+    if (err == 0) {
+        err = EVP_PKEY_keygen_init(ctx) != 1;
+    }
+    if (err == 0) {
+        err = EVP_PKEY_CTX_set_rsa_keygen_bits(ctx, 2048) <= 0;
+    }
+    if (err == 0) {
+        err = EVP_PKEY_CTX_set_rsa_keygen_primes(ctx, 3) <= 0;
+    }
+    if (err == 0) {
+        err = EVP_PKEY_keygen(ctx, &genKey) != 1;
+    }
+    if (err == 0) {
+        PRINT_MSG("Sign with wolfprovider");
+        sigLen = sizeof(sig);
+        err = test_digest_sign(genKey, wpLibCtx, buf, sizeof(buf),
+            "SHA-256", sig, &sigLen, RSA_PKCS1_PADDING);
+    }
+    if (err == 0) {
+        PRINT_MSG("Verify with OpenSSL");
+        err = test_digest_verify(genKey, osslLibCtx, buf, sizeof(buf),
+            "SHA-256", sig, sigLen, RSA_PKCS1_PADDING);
+    }
+#endif
+
+    EVP_PKEY_CTX_free(ctx);
+    OSSL_PARAM_free(params);
+    EVP_PKEY_free(genKey);
+    EVP_PKEY_free(imported);
+    EVP_PKEY_free(pkey);
+
+    return err;
+}
+#endif /* WOLF_CRYPTO_CB */
+
+static EVP_PKEY* test_rsa_decode_der(const unsigned char* der, size_t len,
+    int selection)
+{
+    EVP_PKEY* pkey = NULL;
+    OSSL_DECODER_CTX* dctx;
+    const unsigned char* p = der;
+
+    dctx = OSSL_DECODER_CTX_new_for_pkey(&pkey, "DER", NULL, "RSA",
+        selection, wpLibCtx, NULL);
+    if (dctx != NULL) {
+        if (OSSL_DECODER_from_data(dctx, &p, &len) != 1) {
+            EVP_PKEY_free(pkey);
+            pkey = NULL;
+        }
+        OSSL_DECODER_CTX_free(dctx);
+    }
+
+    return pkey;
+}
+
+int test_rsa_decode_pub_only(void* data)
+{
+    int err;
+    EVP_PKEY* pub = NULL;
+    EVP_PKEY* full = NULL;
+    EVP_PKEY_CTX* ctx = NULL;
+
+    (void)data;
+
+    PRINT_MSG("Decode public key only from RSA private key DER");
+    pub = test_rsa_decode_der(rsa_key_der_2048, sizeof(rsa_key_der_2048),
+        EVP_PKEY_PUBLIC_KEY);
+    err = pub == NULL;
+    if (err == 0) {
+        PRINT_MSG("Decode full RSA private key DER");
+        full = test_rsa_decode_der(rsa_key_der_2048, sizeof(rsa_key_der_2048),
+            EVP_PKEY_KEYPAIR);
+        err = full == NULL;
+    }
+    if (err == 0) {
+        PRINT_MSG("Check public keys match");
+        err = EVP_PKEY_eq(pub, full) != 1;
+    }
+    if (err == 0) {
+        ctx = EVP_PKEY_CTX_new_from_pkey(wpLibCtx, pub, NULL);
+        err = ctx == NULL;
+    }
+    if (err == 0) {
+        PRINT_MSG("Check public key valid");
+        err = EVP_PKEY_public_check(ctx) != 1;
+    }
+    if (err == 0) {
+        PRINT_MSG("Check private key not decoded");
+        err = EVP_PKEY_private_check(ctx) == 1;
+    }
+
+    EVP_PKEY_CTX_free(ctx);
+    EVP_PKEY_free(full);
+    EVP_PKEY_free(pub);
+    return err;
+}
+
 int test_rsa_load_key(void* data)
 {
     int err;
@@ -791,4 +1143,75 @@ int test_rsa_load_cert(void* data)
     OSSL_STORE_close(ctx);
     return err;
 }
+
+int test_rsa_load_cert_chain(void* data)
+{
+    int err;
+    OSSL_STORE_CTX* ctx = NULL;
+    OSSL_STORE_INFO* info = NULL;
+    int cnt = 0;
+
+    (void)data;
+
+    PRINT_MSG("Open certificate chain");
+    ctx = OSSL_STORE_open_ex("./certs/server-cert.pem", wpLibCtx, NULL, NULL,
+        NULL, NULL, NULL, NULL);
+    err = ctx == NULL;
+    while ((err == 0) && (!OSSL_STORE_eof(ctx))) {
+        info = OSSL_STORE_load(ctx);
+        err = info == NULL;
+        if (err == 0) {
+            err = OSSL_STORE_INFO_get_type(info) != OSSL_STORE_INFO_CERT;
+        }
+        if (err == 0) {
+            cnt++;
+        }
+        OSSL_STORE_INFO_free(info);
+    }
+    if (err == 0) {
+        PRINT_MSG("Check one object loaded for each certificate");
+        err = cnt != 2;
+    }
+
+    OSSL_STORE_close(ctx);
+    return err;
+}
+
+int test_rsa_load_cert_dir(void* data)
+{
+    int err;
+    OSSL_STORE_CTX* ctx = NULL;
+    OSSL_STORE_INFO* info = NULL;
+    const char* name;
+    int found = 0;
+
+    (void)data;
+
+    PRINT_MSG("Open directory of certificates");
+    ctx = OSSL_STORE_open_ex("./certs", wpLibCtx, NULL, NULL, NULL, NULL,
+        NULL, NULL);
+    err = ctx == NULL;
+    while ((err == 0) && (!OSSL_STORE_eof(ctx))) {
+        info = OSSL_STORE_load(ctx);
+        err = info == NULL;
+        if (err == 0) {
+            err = OSSL_STORE_INFO_get_type(info) != OSSL_STORE_INFO_NAME;
+        }
+        if (err == 0) {
+            name = OSSL_STORE_INFO_get0_NAME(info);
+            if ((name != NULL) &&
+                    (strcmp(name, "./certs/server-cert.pem") == 0)) {
+                found = 1;
+            }
+        }
+        OSSL_STORE_INFO_free(info);
+    }
+    if (err == 0) {
+        PRINT_MSG("Check certificate file listed");
+        err = !found;
+    }
+
+    OSSL_STORE_close(ctx);
+    return err;
+}
 #endif /* WP_HAVE_RSA */
@@ -20,6 +20,8 @@
 
 #include "unit.h"
 
+#include <wolfprovider/wp_params.h>
+
 #ifdef WP_HAVE_TLS1_PRF
 
 static int test_tls1_prf_calc(OSSL_LIB_CTX* libCtx, unsigned char *key,
@@ -350,6 +352,128 @@ static int test_tls1_prf_fail()
     return err;
 }
 
+static int test_tls1_prf_kdf_calc(OSSL_LIB_CTX* libCtx, EVP_KDF_CTX* kctx,
+    const char* md, unsigned char* secret, size_t secretLen,
+    const char* label, unsigned char* seed, size_t seedLen,
+    unsigned char* kbSeed, size_t kbSeedLen, unsigned char* out,
+    size_t outLen)
+{
+    int err;
+    EVP_KDF* kdf = NULL;
+    EVP_KDF_CTX* ctx = kctx;
+    OSSL_PARAM params[6];
+    OSSL_PARAM* p = params;
+
+    if (md != NULL) {
+        *p++ = OSSL_PARAM_construct_utf8_string(OSSL_KDF_PARAM_DIGEST,
+            (char*)md, 0);
+    }
+    if (secret != NULL) {
+        *p++ = OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_SECRET,
+            secret, secretLen);
+    }
+    *p++ = OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_SEED,
+        (void*)label, strlen(label));
+    *p++ = OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_SEED, seed,
+        seedLen);
+    if (kbSeed != NULL) {
+        *p++ = OSSL_PARAM_construct_octet_string(
+            WP_KDF_PARAM_TLS1_KEY_BLOCK_SEED, kbSeed, kbSeedLen);
+    }
+    *p = OSSL_PARAM_construct_end();
+
+    err = 0;
+    if (ctx == NULL) {
+        err = (kdf = EVP_KDF_fetch(libCtx, "TLS1-PRF", NULL)) == NULL;
+        if (err == 0) {
+            err = (ctx = EVP_KDF_CTX_new(kdf)) == NULL;
+        }
+    }
+    if (err == 0) {
+        err = EVP_KDF_derive(ctx, out, outLen, params) != 1;
+    }
+
+    if (ctx != kctx) {
+        EVP_KDF_CTX_free(ctx);
+    }
+    EVP_KDF_free(kdf);
+    return err;
+}
+
+static int test_tls1_prf_key_block_md(const char* md)
+{
+    int err;
+    EVP_KDF* kdf = NULL;
+    EVP_KDF_CTX* kctx = NULL;
+    unsigned char pms[48];
+    unsigned char hash[48];
+    unsigned char randoms[64];
+    unsigned char kbSeed[13 + 64];
+    unsigned char oKey[48 + 136];
+    unsigned char wKey[48 + 136];
+    unsigned char oFin[12];
+    unsigned char wFin[12];
+
+    memset(pms, 0x03, sizeof(pms));
+    memset(hash, 0x5a, sizeof(hash));
+    memset(randoms, 0xa5, sizeof(randoms));
+    memcpy(kbSeed, "key expansion", 13);
+    memcpy(kbSeed + 13, randoms, sizeof(randoms));
+
+    PRINT_MSG("Master secret, key block and Finished with OpenSSL");
+    err = test_tls1_prf_kdf_calc(osslLibCtx, NULL, md, pms, sizeof(pms),
+        "extended master secret", hash, sizeof(hash), NULL, 0, oKey, 48);
+    if (err == 0) {
+        err = test_tls1_prf_kdf_calc(osslLibCtx, NULL, md, oKey, 48,
+            "key expansion", randoms, sizeof(randoms), NULL, 0, oKey + 48,
+            sizeof(oKey) - 48);
+    }
+    if (err == 0) {
+        err = test_tls1_prf_kdf_calc(osslLibCtx, NULL, md, oKey, 48,
+            "client finished", hash, sizeof(hash), NULL, 0, oFin,
+            sizeof(oFin));
+    }
+
+    if (err == 0) {
+        PRINT_MSG("Master secret and key block in one derive with wolfSSL");
+        err = (kdf = EVP_KDF_fetch(wpLibCtx, "TLS1-PRF", NULL)) == NULL;
+    }
+    if (err == 0) {
+        err = (kctx = EVP_KDF_CTX_new(kdf)) == NULL;
+    }
+    if (err == 0) {
+        err = test_tls1_prf_kdf_calc(wpLibCtx, kctx, md, pms, sizeof(pms),
+            "extended master secret", hash, sizeof(hash), kbSeed,
+            sizeof(kbSeed), wKey, sizeof(wKey));
+    }
+    if ((err == 0) && (memcmp(oKey, wKey, sizeof(oKey)) != 0)) {
+        PRINT_BUFFER("OpenSSL key", oKey, sizeof(oKey));
+        PRINT_BUFFER("wolfSSL key", wKey, sizeof(wKey));
+        err = 1;
+    }
+    if (err == 0) {
+        PRINT_MSG("Finished with master secret kept in context");
+        err = test_tls1_prf_kdf_calc(wpLibCtx, kctx, NULL, NULL, 0,
+            "client finished", hash, sizeof(hash), NULL, 0, wFin,
+            sizeof(wFin));
+    }
+    if ((err == 0) && (memcmp(oFin, wFin, sizeof(oFin)) != 0)) {
+        PRINT_BUFFER("OpenSSL Finished", oFin, sizeof(oFin));
+        PRINT_BUFFER("wolfSSL Finished", wFin, sizeof(wFin));
+        err = 1;
+    }
+    if (err == 0) {
+        /* Output must have room for more than the master secret. */
+        err = test_tls1_prf_kdf_calc(wpLibCtx, NULL, md, pms, sizeof(pms),
+            "extended master secret", hash, sizeof(hash), kbSeed,
+            sizeof(kbSeed), wKey, 48) == 0;
+    }
+
+    EVP_KDF_CTX_free(kctx);
+    EVP_KDF_free(kdf);
+    return err;
+}
+
 int test_tls1_prf(void *data)
 {
     int err;
@@ -369,6 +493,15 @@ int test_tls1_prf(void *data)
     if (err == 0) {
         err = test_tls1_prf_fail();
     }
+    if (err == 0) {
+        err = test_tls1_prf_key_block_md("SHA256");
+    }
+    if (err == 0) {
+        err = test_tls1_prf_key_block_md("SHA384");
+    }
+    if (err == 0) {
+        err = test_tls1_prf_key_block_md("MD5-SHA1");
+    }
 
     return err;
 }
@@ -0,0 +1,581 @@
+/* tls_bench.c
+ *
+ * Copyright (C) 2021 wolfSSL Inc.
+ *
+ * This file is part of wolfProvider.
+ *
+ * wolfProvider is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfProvider is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wolfProvider.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * End-to-end TLS benchmark.
+ *
+ * Full handshakes and bulk record transfer between a client and server in the
+ * same process connected by a memory BIO pair. The provider is loaded through
+ * a configuration file, as an application would, so that the cost of
+ * fetching, duplicating and freeing provider objects is included.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include <openssl/provider.h>
+
+/* Size of buffer in each direction of the BIO pair. */
+#define TLS_BENCH_BIO_LEN       (32 * 1024)
+/* Size of application data written in one call - maximum record size. */
+#define TLS_BENCH_REC_LEN       (16 * 1024)
+/* Maximum number of steps of a handshake before giving up. */
+#define TLS_BENCH_MAX_STEPS     64
+
+/* Kind of certificate and key the server uses. */
+#define TLS_BENCH_CERT_RSA      0
+#define TLS_BENCH_CERT_ECC      1
+
+/* Cipher suite and group to benchmark. */
+typedef struct TLS_BENCH_SUITE {
+    /* Protocol version. */
+    int version;
+    /* Name of cipher suite. */
+    const char* suite;
+    /* Name of group used in key exchange. */
+    const char* group;
+    /* Kind of certificate: TLS_BENCH_CERT_*. */
+    int cert;
+} TLS_BENCH_SUITE;
+
+/* Cipher suites and groups benchmarked. Groups are those in wp_tls_capa.c. */
+static const TLS_BENCH_SUITE tls_bench_suites[] = {
+    { TLS1_3_VERSION, "TLS_AES_128_GCM_SHA256", "P-256",
+      TLS_BENCH_CERT_ECC },
+    { TLS1_3_VERSION, "TLS_AES_128_GCM_SHA256", "P-384",
+      TLS_BENCH_CERT_ECC },
+    { TLS1_3_VERSION, "TLS_AES_128_GCM_SHA256", "P-521",
+      TLS_BENCH_CERT_ECC },
+    { TLS1_3_VERSION, "TLS_AES_128_GCM_SHA256", "x25519",
+      TLS_BENCH_CERT_ECC },
+    { TLS1_3_VERSION, "TLS_AES_128_GCM_SHA256", "x448",
+      TLS_BENCH_CERT_ECC },
+    { TLS1_3_VERSION, "TLS_AES_128_GCM_SHA256", "ffdhe2048",
+      TLS_BENCH_CERT_ECC },
+    { TLS1_3_VERSION, "TLS_AES_128_GCM_SHA256", "P-256",
+      TLS_BENCH_CERT_RSA },
+    { TLS1_3_VERSION, "TLS_AES_256_GCM_SHA384", "P-256",
+      TLS_BENCH_CERT_ECC },
+    { TLS1_3_VERSION, "TLS_AES_256_GCM_SHA384", "P-384",
+      TLS_BENCH_CERT_RSA },
+    { TLS1_3_VERSION, "TLS_AES_128_CCM_SHA256", "P-256",
+      TLS_BENCH_CERT_ECC },
+    { TLS1_3_VERSION, "TLS_CHACHA20_POLY1305_SHA256", "x25519",
+      TLS_BENCH_CERT_ECC },
+    { TLS1_2_VERSION, "ECDHE-ECDSA-AES128-GCM-SHA256", "P-256",
+      TLS_BENCH_CERT_ECC },
+    { TLS1_2_VERSION, "ECDHE-ECDSA-AES256-GCM-SHA384", "P-384",
+      TLS_BENCH_CERT_ECC },
+    { TLS1_2_VERSION, "ECDHE-ECDSA-CHACHA20-POLY1305", "x25519",
+      TLS_BENCH_CERT_ECC },
+    { TLS1_2_VERSION, "ECDHE-RSA-AES128-GCM-SHA256", "P-256",
+      TLS_BENCH_CERT_RSA },
+    { TLS1_2_VERSION, "ECDHE-RSA-AES256-GCM-SHA384", "P-384",
+      TLS_BENCH_CERT_RSA },
+    { TLS1_2_VERSION, "ECDHE-RSA-AES128-SHA256", "P-256",
+      TLS_BENCH_CERT_RSA },
+    { TLS1_2_VERSION, "DHE-RSA-AES128-GCM-SHA256", "ffdhe2048",
+      TLS_BENCH_CERT_RSA },
+    { TLS1_2_VERSION, "AES128-GCM-SHA256", "P-256",
+      TLS_BENCH_CERT_RSA },
+};
+/* Number of cipher suites and groups benchmarked. */
+#define TLS_BENCH_SUITE_CNT \
+    (int)(sizeof(tls_bench_suites) / sizeof(*tls_bench_suites))
+
+/* Options of benchmark run. */
+typedef struct TLS_BENCH_OPTS {
+    /* Directory containing provider shared library. */
+    const char* dir;
+    /* Configuration file that loads provider. */
+    const char* conf;
+    /* Directory containing certificates and keys. */
+    const char* certs;
+    /* Number of seconds to run each benchmark for. */
+    double secs;
+    /* Only benchmark suites with this protocol version. 0 for all. */
+    int version;
+    /* Only benchmark suites whose name or group contains this. */
+    const char* filter;
+} TLS_BENCH_OPTS;
+
+/* Client and server connected by a BIO pair. */
+typedef struct TLS_BENCH_CONN {
+    SSL* client;
+    SSL* server;
+} TLS_BENCH_CONN;
+
+/**
+ * Get the current time in seconds.
+ *
+ * @return  Monotonic time in seconds.
+ */
+static double tls_bench_time(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+}
+
+/**
+ * Create the client and server SSL contexts for a suite.
+ *
+ * Session caching and tickets are disabled so every handshake is full.
+ *
+ * @param [in]  opts     Options of run.
+ * @param [in]  libCtx   Library context with provider loaded.
+ * @param [in]  suite    Cipher suite and group.
+ * @param [out] cliCtx   Client SSL context.
+ * @param [out] srvCtx   Server SSL context.
+ * @return  0 on success.
+ * @return  1 on failure.
+ */
+static int tls_bench_ctx_new(const TLS_BENCH_OPTS* opts, OSSL_LIB_CTX* libCtx,
+    const TLS_BENCH_SUITE* suite, SSL_CTX** cliCtx, SSL_CTX** srvCtx)
+{
+    int err = 0;
+    char certFile[256];
+    char keyFile[256];
+    char groups[64];
+    SSL_CTX* ctx[2];
+    int i;
+
+    if (suite->cert == TLS_BENCH_CERT_RSA) {
+        snprintf(certFile, sizeof(certFile), "%s/server-cert.pem",
+            opts->certs);
+        snprintf(keyFile, sizeof(keyFile), "%s/server-key.pem", opts->certs);
+    }
+    else {
+        snprintf(certFile, sizeof(certFile), "%s/server-ecc.pem",
+            opts->certs);
+        snprintf(keyFile, sizeof(keyFile), "%s/ecc-key.pem", opts->certs);
+    }
+    /* TLS 1.2 ECDSA needs the certificate's curve in the supported groups. */
+    if ((suite->version == TLS1_2_VERSION) &&
+            (suite->cert == TLS_BENCH_CERT_ECC) &&
+            (strcmp(suite->group, "P-256") != 0)) {
+        snprintf(groups, sizeof(groups), "%s:P-256", suite->group);
+    }
+    else {
+        snprintf(groups, sizeof(groups), "%s", suite->group);
+    }
+
+    ctx[0] = SSL_CTX_new_ex(libCtx, NULL, TLS_client_method());
+    ctx[1] = SSL_CTX_new_ex(libCtx, NULL, TLS_server_method());
+    for (i = 0; i < 2; i++) {
+        if ((err == 0) && (ctx[i] == NULL)) {
+            err = 1;
+        }
+        if (err == 0) {
+            SSL_CTX_set_session_cache_mode(ctx[i], SSL_SESS_CACHE_OFF);
+            SSL_CTX_set_options(ctx[i], SSL_OP_NO_TICKET);
+            err = (SSL_CTX_set_min_proto_version(ctx[i], suite->version) != 1)
+               || (SSL_CTX_set_max_proto_version(ctx[i], suite->version) != 1)
+               || (SSL_CTX_set1_groups_list(ctx[i], groups) != 1);
+        }
+        if (err == 0) {
+            if (suite->version == TLS1_3_VERSION) {
+                err = SSL_CTX_set_ciphersuites(ctx[i], suite->suite) != 1;
+            }
+            else {
+                err = SSL_CTX_set_cipher_list(ctx[i], suite->suite) != 1;
+            }
+        }
+    }
+    if (err == 0) {
+        err = (SSL_CTX_use_certificate_chain_file(ctx[1], certFile) != 1) ||
+              (SSL_CTX_use_PrivateKey_file(ctx[1], keyFile,
+                  SSL_FILETYPE_PEM) != 1);
+    }
+    if ((err == 0) && (suite->version == TLS1_2_VERSION) &&
+            (strncmp(suite->suite, "DHE-", 4) == 0)) {
+        err = SSL_CTX_set_dh_auto(ctx[1], 1) != 1;
+    }
+
+    if (err == 0) {
+        *cliCtx = ctx[0];
+        *srvCtx = ctx[1];
+    }
+    else {
+        SSL_CTX_free(ctx[1]);
+        SSL_CTX_free(ctx[0]);
+    }
+
+    return err;
+}
+
+/**
+ * Create a client and server connected by a BIO pair.
+ *
+ * @param [in]  cliCtx  Client SSL context.
+ * @param [in]  srvCtx  Server SSL context.
+ * @param [out] conn    Connection.
+ * @return  0 on success.
+ * @return  1 on failure.
+ */
+static int tls_bench_conn_new(SSL_CTX* cliCtx, SSL_CTX* srvCtx,
+    TLS_BENCH_CONN* conn)
+{
+    int err = 0;
+    BIO* cliBio = NULL;
+    BIO* srvBio = NULL;
+
+    conn->client = SSL_new(cliCtx);
+    conn->server = SSL_new(srvCtx);
+    if ((conn->client == NULL) || (conn->server == NULL)) {
+        err = 1;
+    }
+    if (err == 0) {
+        err = BIO_new_bio_pair(&cliBio, TLS_BENCH_BIO_LEN, &srvBio,
+            TLS_BENCH_BIO_LEN) != 1;
+    }
+    if (err == 0) {
+        SSL_set_bio(conn->client, cliBio, cliBio);
+        SSL_set_bio(conn->server, srvBio, srvBio);
+        SSL_set_connect_state(conn->client);
+        SSL_set_accept_state(conn->server);
+    }
+    else {
+        SSL_free(conn->server);
+        SSL_free(conn->client);
+        conn->client = NULL;
+        conn->server = NULL;
+    }
+
+    return err;
+}
+
+/**
+ * Dispose of a client and server.
+ *
+ * @param [in, out] conn  Connection.
+ */
+static void tls_bench_conn_free(TLS_BENCH_CONN* conn)
+{
+    SSL_free(conn->server);
+    SSL_free(conn->client);
+    conn->client = NULL;
+    conn->server = NULL;
+}
+
+/**
+ * Check whether the SSL object is only waiting on the peer.
+ *
+ * @param [in] ssl  SSL object.
+ * @param [in] ret  Return from SSL call.
+ * @return  1 when waiting on I/O.
+ * @return  0 on error.
+ */
+static int tls_bench_want_io(SSL* ssl, int ret)
+{
+    int e = SSL_get_error(ssl, ret);
+
+    return (e == SSL_ERROR_WANT_READ) || (e == SSL_ERROR_WANT_WRITE);
+}
+
+/**
+ * Step the client and server until the handshake completes.
+ *
+ * @param [in, out] conn  Connection.
+ * @return  0 on success.
+ * @return  1 on failure.
+ */
+static int tls_bench_handshake(TLS_BENCH_CONN* conn)
+{
+    int err = 0;
+    int cliDone = 0;
+    int srvDone = 0;
+    int ret;
+    int i;
+
+    for (i = 0; (err == 0) && (i < TLS_BENCH_MAX_STEPS); i++) {
+        if (!cliDone) {
+            ret = SSL_do_handshake(conn->client);
+            cliDone = ret == 1;
+            err = (!cliDone) && (!tls_bench_want_io(conn->client, ret));
+        }
+        if ((err == 0) && (!srvDone)) {
+            ret = SSL_do_handshake(conn->server);
+            srvDone = ret == 1;
+            err = (!srvDone) && (!tls_bench_want_io(conn->server, ret));
+        }
+        if (cliDone && srvDone) {
+            break;
+        }
+    }
+    if ((!cliDone) || (!srvDone)) {
+        err = 1;
+    }
+
+    return err;
+}
+
+/**
+ * Send one record of application data from client to server.
+ *
+ * @param [in, out] conn  Connection.
+ * @param [in]      buf   Buffer of record length to send from and read into.
+ * @return  0 on success.
+ * @return  1 on failure.
+ */
+static int tls_bench_transfer(TLS_BENCH_CONN* conn, unsigned char* buf)
+{
+    int err = 0;
+    size_t len = 0;
+    size_t got = 0;
+    size_t total = 0;
+
+    err = SSL_write_ex(conn->client, buf, TLS_BENCH_REC_LEN, &len) != 1;
+    while ((err == 0) && (total < len)) {
+        err = SSL_read_ex(conn->server, buf, TLS_BENCH_REC_LEN - total,
+            &got) != 1;
+        total += got;
+    }
+
+    return err;
+}
+
+/**
+ * Benchmark full handshakes and then bulk transfer for a suite.
+ *
+ * @param [in] opts    Options of run.
+ * @param [in] libCtx  Library context with provider loaded.
+ * @param [in] suite   Cipher suite and group.
+ * @return  0 on success.
+ * @return  1 on failure.
+ */
+static int tls_bench_suite(const TLS_BENCH_OPTS* opts, OSSL_LIB_CTX* libCtx,
+    const TLS_BENCH_SUITE* suite)
+{
+    int err = 0;
+    SSL_CTX* cliCtx = NULL;
+    SSL_CTX* srvCtx = NULL;
+    TLS_BENCH_CONN conn = { NULL, NULL };
+    static unsigned char buf[TLS_BENCH_REC_LEN];
+    unsigned long cnt = 0;
+    double hsElapsed = 0;
+    double dataElapsed = 0;
+    double start;
+    double now;
+
+    printf("%-4s %-30s %-10s %-3s",
+        (suite->version == TLS1_3_VERSION) ? "1.3" : "1.2", suite->suite,
+        suite->group, (suite->cert == TLS_BENCH_CERT_RSA) ? "RSA" : "ECC");
+    fflush(stdout);
+
+    err = tls_bench_ctx_new(opts, libCtx, suite, &cliCtx, &srvCtx);
+
+    /* Each handshake creates and frees the SSL objects as a server would. */
+    if (err == 0) {
+        start = tls_bench_time();
+        do {
+            err = tls_bench_conn_new(cliCtx, srvCtx, &conn);
+            if (err == 0) {
+                err = tls_bench_handshake(&conn);
+                tls_bench_conn_free(&conn);
+            }
+            cnt++;
+            now = tls_bench_time();
+        }
+        while ((err == 0) && (now - start < opts->secs));
+        hsElapsed = now - start;
+    }
+    if (err == 0) {
+        printf(" %12.1f", cnt / hsElapsed);
+        fflush(stdout);
+    }
+
+    /* Bulk transfer over one connection. */
+    if (err == 0) {
+        err = tls_bench_conn_new(cliCtx, srvCtx, &conn);
+    }
+    if (err == 0) {
+        err = tls_bench_handshake(&conn);
+    }
+    if (err == 0) {
+        memset(buf, 0xa5, sizeof(buf));
+        cnt = 0;
+        start = tls_bench_time();
+        do {
+            err = tls_bench_transfer(&conn, buf);
+            cnt++;
+            now = tls_bench_time();
+        }
+        while ((err == 0) && (now - start < opts->secs));
+        dataElapsed = now - start;
+    }
+    if (err == 0) {
+        printf(" %10.1f\n", (double)cnt * TLS_BENCH_REC_LEN / dataElapsed /
+            1000000.0);
+    }
+    else {
+        printf(" %12s\n", "failed");
+        ERR_print_errors_fp(stdout);
+    }
+
+    tls_bench_conn_free(&conn);
+    SSL_CTX_free(srvCtx);
+    SSL_CTX_free(cliCtx);
+
+    return err;
+}
+
+/**
+ * Print usage of benchmark program.
+ */
+static void usage(void)
+{
+    printf("\n");
+    printf("Usage: tls_bench [options] [<filter>]\n");
+    printf("  --help            Show this usage information.\n");
+    printf("  --dir <path>      Location of wolfprovider shared library.\n");
+    printf("                    Default: .libs\n");
+    printf("  --conf <file>     Configuration file loading provider.\n");
+    printf("                    Default: provider.conf\n");
+    printf("  --certs <path>    Location of certificates and keys.\n");
+    printf("                    Default: certs\n");
+    printf("  --secs <num>      Seconds to run each benchmark. Default: 1\n");
+    printf("  --tls12           Only benchmark TLS 1.2 cipher suites.\n");
+    printf("  --tls13           Only benchmark TLS 1.3 cipher suites.\n");
+    printf("  --list            Display all cipher suites and groups.\n");
+    printf("  <filter>          Only benchmark suites or groups containing "
+                               "filter.\n");
+    printf("\n");
+    printf("Columns: full handshakes/sec and application data MB/sec.\n");
+}
+
+int main(int argc, char* argv[])
+{
+    int err = 0;
+    int run = 1;
+    int i;
+    TLS_BENCH_OPTS opts;
+    OSSL_LIB_CTX* libCtx = NULL;
+
+    memset(&opts, 0, sizeof(opts));
+    opts.dir = ".libs";
+    opts.conf = "provider.conf";
+    opts.certs = "certs";
+    opts.secs = 1;
+
+    for (--argc, ++argv; (err == 0) && (argc > 0); argc--, argv++) {
+        if (strcmp(*argv, "--help") == 0) {
+            usage();
+            run = 0;
+            break;
+        }
+        else if ((strcmp(*argv, "--dir") == 0) ||
+                 (strcmp(*argv, "--conf") == 0) ||
+                 (strcmp(*argv, "--certs") == 0) ||
+                 (strcmp(*argv, "--secs") == 0)) {
+            if (argc == 1) {
+                printf("Missing value for %s\n", *argv);
+                err = 1;
+            }
+            else if (strcmp(*argv, "--dir") == 0) {
+                opts.dir = *++argv;
+                argc--;
+            }
+            else if (strcmp(*argv, "--conf") == 0) {
+                opts.conf = *++argv;
+                argc--;
+            }
+            else if (strcmp(*argv, "--certs") == 0) {
+                opts.certs = *++argv;
+                argc--;
+            }
+            else {
+                opts.secs = atof(*++argv);
+                argc--;
+                if (opts.secs <= 0) {
+                    printf("Invalid seconds: %s\n", *argv);
+                    err = 1;
+                }
+            }
+        }
+        else if (strcmp(*argv, "--tls12") == 0) {
+            opts.version = TLS1_2_VERSION;
+        }
+        else if (strcmp(*argv, "--tls13") == 0) {
+            opts.version = TLS1_3_VERSION;
+        }
+        else if (strcmp(*argv, "--list") == 0) {
+            for (i = 0; i < TLS_BENCH_SUITE_CNT; i++) {
+                printf("%s %s\n", tls_bench_suites[i].suite,
+                    tls_bench_suites[i].group);
+            }
+            run = 0;
+            break;
+        }
+        else if (**argv == '-') {
+            printf("Unrecognized option: %s\n", *argv);
+            usage();
+            err = 1;
+        }
+        else {
+            opts.filter = *argv;
+        }
+    }
+
+    if ((err == 0) && run) {
+        libCtx = OSSL_LIB_CTX_new();
+        if (libCtx == NULL) {
+            err = 1;
+        }
+    }
+    if ((err == 0) && run) {
+        OSSL_PROVIDER_set_default_search_path(libCtx, opts.dir);
+        if (OSSL_LIB_CTX_load_config(libCtx, opts.conf) != 1) {
+            printf("Failed to load configuration: %s\n", opts.conf);
+            ERR_print_errors_fp(stdout);
+            err = 1;
+        }
+    }
+    if ((err == 0) && run) {
+        printf("Configuration: %s, seconds: %.2f\n", opts.conf, opts.secs);
+        printf("%-4s %-30s %-10s %-3s %12s %10s\n", "TLS", "Cipher suite",
+            "Group", "Key", "handshakes/s", "MB/sec");
+        for (i = 0; i < TLS_BENCH_SUITE_CNT; i++) {
+            const TLS_BENCH_SUITE* suite = &tls_bench_suites[i];
+
+            if ((opts.version != 0) && (opts.version != suite->version)) {
+                continue;
+            }
+            if ((opts.filter != NULL) &&
+                    (strstr(suite->suite, opts.filter) == NULL) &&
+                    (strstr(suite->group, opts.filter) == NULL)) {
+                continue;
+            }
+            /* Keep going so one unsupported suite doesn't hide the rest. */
+            if (tls_bench_suite(&opts, libCtx, suite) != 0) {
+                err = 1;
+            }
+        }
+    }
+
+    OSSL_LIB_CTX_free(libCtx);
+
+    return err;
+}
@@ -18,9 +18,11 @@
  * along with wolfProvider.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#ifdef TEST_MULTITHREADED
+#include <stdlib.h>
 #include <unistd.h>
-#endif
+#include <sys/wait.h>
+
+#include <openssl/x509.h>
 
 #include <wolfprovider/wp_wolfprov.h>
 
@@ -28,6 +30,122 @@
 
 OSSL_LIB_CTX* wpLibCtx = NULL;
 OSSL_LIB_CTX* osslLibCtx = NULL;
+/* Name of wolfProvider as loaded. */
+static const char* wpProvName = NULL;
+/* Directory wolfProvider is loaded from. */
+static const char* wpProvDir = NULL;
+
+/* Create a library context with wolfProvider loaded and configured.
+ *
+ * conf holds lines of "name = value" for the provider's section.
+ */
+OSSL_LIB_CTX* test_conf_libctx(const char* conf)
+{
+    OSSL_LIB_CTX* libCtx = NULL;
+    char fileName[] = "/tmp/wp_test_conf_XXXXXX";
+    FILE* f = NULL;
+    int fd = -1;
+    int err;
+
+    err = (fd = mkstemp(fileName)) < 0;
+    if (err == 0) {
+        err = (f = fdopen(fd, "w")) == NULL;
+        if (err) {
+            close(fd);
+        }
+    }
+    if (err == 0) {
+        fprintf(f, "openssl_conf = openssl_init\n\n"
+                   "[openssl_init]\n"
+                   "providers = provider_sect\n\n"
+                   "[provider_sect]\n"
+                   "%s = wp_sect\n\n"
+                   "[wp_sect]\n"
+                   "activate = 1\n"
+                   "%s\n", wpProvName, conf);
+        err = fclose(f) != 0;
+    }
+    if (err == 0) {
+        err = (libCtx = OSSL_LIB_CTX_new()) == NULL;
+    }
+    if (err == 0) {
+        OSSL_PROVIDER_set_default_search_path(libCtx, wpProvDir);
+        err = OSSL_LIB_CTX_load_config(libCtx, fileName) != 1;
+    }
+    if (fd >= 0) {
+        unlink(fileName);
+    }
+    if ((err != 0) && (libCtx != NULL)) {
+        OSSL_LIB_CTX_free(libCtx);
+        libCtx = NULL;
+    }
+
+    return libCtx;
+}
+
+/* Generate a key in a forked child and in this process and check that the
+ * public keys differ. */
+int test_fork_keygen_differ(EVP_PKEY_CTX* ctx)
+{
+    int err;
+    int fds[2];
+    pid_t pid;
+    int status;
+    EVP_PKEY* pkey = NULL;
+    unsigned char* der = NULL;
+    int derLen = 0;
+    unsigned char childDer[4096];
+    ssize_t childLen = 0;
+
+    err = pipe(fds) != 0;
+    if (err == 0) {
+        err = (pid = fork()) < 0;
+    }
+    if ((err == 0) && (pid == 0)) {
+        /* Child - send encoded public key to parent. */
+        close(fds[0]);
+        if (EVP_PKEY_keygen(ctx, &pkey) == 1) {
+            derLen = i2d_PUBKEY(pkey, &der);
+        }
+        if ((derLen > 0) && (derLen <= (int)sizeof(childDer)) &&
+                (write(fds[1], der, derLen) != derLen)) {
+            derLen = 0;
+        }
+        close(fds[1]);
+        _exit(0);
+    }
+    if (err == 0) {
+        close(fds[1]);
+        err = EVP_PKEY_keygen(ctx, &pkey) != 1;
+        if (err == 0) {
+            err = (derLen = i2d_PUBKEY(pkey, &der)) <= 0;
+        }
+        while ((childLen < (ssize_t)sizeof(childDer))) {
+            ssize_t n = read(fds[0], childDer + childLen,
+                             sizeof(childDer) - childLen);
+            if (n <= 0) {
+                break;
+            }
+            childLen += n;
+        }
+        close(fds[0]);
+        if (waitpid(pid, &status, 0) != pid) {
+            err = 1;
+        }
+    }
+    if (err == 0) {
+        PRINT_BUFFER("Parent public key", der, derLen);
+        PRINT_BUFFER("Child public key", childDer, childLen);
+        /* Child must have generated a key and it must not be the same. */
+        err = (childLen <= 0) || ((childLen == derLen) &&
+              (memcmp(childDer, der, derLen) == 0));
+    }
+
+    OPENSSL_free(der);
+    EVP_PKEY_free(pkey);
+
+    return err;
+}
 
 #ifdef WOLFPROV_DEBUG
 void print_buffer(const char *desc, const unsigned char *buffer, size_t len)
@@ -67,6 +185,15 @@ TEST_CASE test_case[] = {
 #ifdef WP_HAVE_SHA512
     TEST_DECL(test_sha512, NULL),
 #endif
+#ifdef WP_HAVE_SHA256
+    TEST_DECL(test_sha256_batch, NULL),
+#endif
+#ifdef WP_HAVE_SHA512
+    TEST_DECL(test_sha512_batch, NULL),
+#endif
+#ifndef TEST_MULTITHREADED
+    TEST_DECL(test_digest_pool, NULL),
+#endif
 #ifdef WP_HAVE_SHA3_224
     TEST_DECL(test_sha3_224, NULL),
 #endif
@@ -79,11 +206,17 @@ TEST_CASE test_case[] = {
 #ifdef WP_HAVE_SHA3_512
     TEST_DECL(test_sha3_512, NULL),
 #endif
+#ifdef WP_HAVE_SHAKE_128
+    TEST_DECL(test_shake_128, NULL),
+#endif
 #ifdef WP_HAVE_SHAKE_256
     TEST_DECL(test_shake_256, NULL),
+    TEST_DECL(test_shake_256_stream, NULL),
 #endif
 #ifdef WP_HAVE_HMAC
     TEST_DECL(test_hmac_create, NULL),
+    TEST_DECL(test_hmac_reinit, NULL),
+    TEST_DECL(test_hmac_sign_reuse, NULL),
 #endif
 #ifdef WP_HAVE_CMAC
     TEST_DECL(test_cmac_create, &flags),
@@ -96,6 +229,7 @@ TEST_CASE test_case[] = {
 #endif
 #ifdef WP_HAVE_HKDF
     TEST_DECL(test_hkdf, NULL),
+    TEST_DECL(test_tls13_key_schedule, NULL),
 #endif
 #ifdef WP_HAVE_DES3CBC
     TEST_DECL(test_des3_cbc, NULL),
@@ -128,6 +262,9 @@ TEST_CASE test_case[] = {
     TEST_DECL(test_aes256_gcm, NULL),
     TEST_DECL(test_aes128_gcm_fixed, NULL),
     TEST_DECL(test_aes128_gcm_tls, NULL),
+    TEST_DECL(test_aes128_gcm_tls_records, NULL),
+    TEST_DECL(test_aes128_gcm_dup, NULL),
+    TEST_DECL(test_aes128_gcm_stream, NULL),
 #endif
 #ifdef WP_HAVE_AESCCM
     TEST_DECL(test_aes128_ccm, NULL),
@@ -135,14 +272,31 @@ TEST_CASE test_case[] = {
     TEST_DECL(test_aes256_ccm, NULL),
 #if OPENSSL_VERSION_NUMBER >= 0x10100000L
     TEST_DECL(test_aes128_ccm_tls, NULL),
+    TEST_DECL(test_aes128_ccm_tls_batch, NULL),
+#endif
+#endif
+#ifdef WP_HAVE_AESXTS
+    TEST_DECL(test_aes128_xts, NULL),
+    TEST_DECL(test_aes256_xts, NULL),
+    TEST_DECL(test_aes256_xts_data_units, NULL),
+    TEST_DECL(test_aes128_xts_reinit, NULL),
 #endif
+    TEST_DECL(test_aes128_wrap_batch, NULL),
+#if defined(WP_HAVE_AESCBC) && defined(WP_HAVE_HMAC) && defined(WP_HAVE_SHA256)
+    TEST_DECL(test_aes128_cbc_hmac_sha256_tls, NULL),
+#endif
+#ifdef WP_HAVE_CHACHA20_POLY1305
+    TEST_DECL(test_chacha20_poly1305, NULL),
+    TEST_DECL(test_chacha20_poly1305_tls, NULL),
 #endif
 #ifdef WP_HAVE_RANDOM
     TEST_DECL(test_random, NULL),
+    TEST_DECL(test_random_buffered, NULL),
 #endif
 #ifdef WP_HAVE_DH
     TEST_DECL(test_dh_pgen_pkey, NULL),
     TEST_DECL(test_dh_pkey, NULL),
+    TEST_DECL(test_dh_named_group, NULL),
 #endif /* WP_HAVE_DH */
 #ifdef WP_HAVE_RSA
     TEST_DECL(test_rsa_sign_sha1, NULL),
@@ -151,9 +305,17 @@ TEST_CASE test_case[] = {
     TEST_DECL(test_rsa_enc_dec_pkcs1, NULL),
     TEST_DECL(test_rsa_enc_dec_oaep, NULL),
     TEST_DECL(test_rsa_pkey_keygen, NULL),
+    TEST_DECL(test_rsa_pkey_keygen_pool, NULL),
     TEST_DECL(test_rsa_pkey_invalid_key_size, NULL),
+    TEST_DECL(test_rsa_import_no_crt, NULL),
+#ifdef WOLF_CRYPTO_CB
+    TEST_DECL(test_rsa_multi_prime, NULL),
+#endif
+    TEST_DECL(test_rsa_decode_pub_only, NULL),
     TEST_DECL(test_rsa_load_key, NULL),
     TEST_DECL(test_rsa_load_cert, NULL),
+    TEST_DECL(test_rsa_load_cert_chain, NULL),
+    TEST_DECL(test_rsa_load_cert_dir, NULL),
 #endif /* WP_HAVE_RSA */
 #ifdef WP_HAVE_EC_P192
     #ifdef WP_HAVE_ECKEYGEN
@@ -188,16 +350,19 @@ TEST_CASE test_case[] = {
 #ifdef WP_HAVE_EC_P256
     #ifdef WP_HAVE_ECKEYGEN
         TEST_DECL(test_eckeygen_p256, NULL),
+        TEST_DECL(test_eckeygen_pool_fork, NULL),
     #endif
     #ifdef WP_HAVE_ECDH
     #ifdef WP_HAVE_ECKEYGEN
         TEST_DECL(test_ecdh_p256_keygen, NULL),
+        TEST_DECL(test_ecdh_p256_peer_import, NULL),
     #endif
         TEST_DECL(test_ecdh_p256, NULL),
     #endif
     #ifdef WP_HAVE_ECDSA
         TEST_DECL(test_ecdsa_p256_pkey, NULL),
         TEST_DECL(test_ecdsa_p256, NULL),
+        TEST_DECL(test_ecdsa_p256_batch_verify, NULL),
     #endif
 #endif
 #ifdef WP_HAVE_EC_P384
@@ -250,13 +415,28 @@ TEST_CASE test_case[] = {
     #endif
     #endif
 #endif
+#if defined(WP_HAVE_ECDH) && defined(WP_HAVE_ECKEYGEN)
+    TEST_DECL(test_ecdh_hkdf_extract, NULL),
+#endif
 #ifdef WP_HAVE_ECDSA
     TEST_DECL(test_ec_load_key, NULL),
     TEST_DECL(test_ec_load_cert, NULL),
+    TEST_DECL(test_ec_encode_spki, NULL),
+    TEST_DECL(test_ec_export_keypair, NULL),
 #endif /* WP_HAVE_ECDSA */
+#ifdef WP_HAVE_MLKEM
+    TEST_DECL(test_mlkem_768, NULL),
+    TEST_DECL(test_x25519mlkem768, NULL),
+    TEST_DECL(test_secp256r1mlkem768, NULL),
+#endif /* WP_HAVE_MLKEM */
+#ifdef WP_HAVE_ARENA
+    TEST_DECL(test_arena, NULL),
+#endif /* WP_HAVE_ARENA */
 
 #ifdef WP_HAVE_PBE
     TEST_DECL(test_pbe, NULL),
+    TEST_DECL(test_pbkdf2_threads, NULL),
+    TEST_DECL(test_pbe_epki_cache, NULL),
 #endif
 };
 #define TEST_CASE_CNT   (int)(sizeof(test_case) / sizeof(*test_case))
@@ -583,6 +763,8 @@ int main(int argc, char* argv[])
         printf("Running tests using dynamic provider.\n");
         OPENSSL_init_ssl(OPENSSL_INIT_LOAD_CONFIG, NULL);
 
+        wpProvName = name;
+        wpProvDir = dir;
         wpLibCtx = OSSL_LIB_CTX_new();
         OSSL_PROVIDER_set_default_search_path(wpLibCtx, dir);
         wpProv = OSSL_PROVIDER_load(wpLibCtx, name);
@@ -55,6 +55,9 @@
 #define WP_HAVE_SHA3_256
 #define WP_HAVE_SHA3_384
 #define WP_HAVE_SHA3_512
+#ifdef WOLFSSL_SHAKE128
+    #define WP_HAVE_SHAKE_128
+#endif
 #define WP_HAVE_SHAKE_256
 #define WP_HAVE_HMAC
 #define WP_HAVE_CMAC
@@ -64,6 +67,12 @@
 #define WP_HAVE_AESCTR
 #define WP_HAVE_AESGCM
 #define WP_HAVE_AESCCM
+#ifdef WOLFSSL_AES_XTS
+    #define WP_HAVE_AESXTS
+#endif
+#if defined(HAVE_CHACHA) && defined(HAVE_POLY1305)
+    #define WP_HAVE_CHACHA20_POLY1305
+#endif
 #define WP_HAVE_RANDOM
 #define WP_HAVE_HKDF
 #define WP_HAVE_TLS1_PRF
@@ -82,6 +91,15 @@
 #define WP_HAVE_ECDH
 #define WP_HAVE_EC_KEY
 #define WP_HAVE_ECKEYGEN
+#if defined(WOLFSSL_HAVE_MLKEM) || defined(WOLFSSL_HAVE_KYBER)
+    #define WP_HAVE_MLKEM
+#endif
+#if defined(USE_WOLFSSL_MEMORY) && !defined(WOLFSSL_STATIC_MEMORY) && \
+    !defined(WOLFSSL_DEBUG_MEMORY) && !defined(XMALLOC_USER) && \
+    !defined(XMALLOC_OVERRIDE) && !defined(WP_SINGLE_THREADED) && \
+    (defined(__GNUC__) || defined(__clang__))
+    #define WP_HAVE_ARENA
+#endif
 
 #include <wolfprovider/wp_logging.h>
 
@@ -127,6 +145,13 @@ int test_logging(void *data);
 extern OSSL_LIB_CTX* wpLibCtx;
 extern OSSL_LIB_CTX* osslLibCtx;
 
+OSSL_LIB_CTX* test_conf_libctx(const char* conf);
+int test_fork_keygen_differ(EVP_PKEY_CTX* ctx);
+
+#ifdef WP_HAVE_ARENA
+int test_arena(void *data);
+#endif /* WP_HAVE_ARENA */
+
 
 #ifdef WP_HAVE_DIGEST
 
@@ -138,18 +163,29 @@ int test_sha224(void *data);
 int test_sha256(void *data);
 int test_sha384(void *data);
 int test_sha512(void *data);
+int test_sha256_batch(void *data);
+int test_sha512_batch(void *data);
+#ifndef TEST_MULTITHREADED
+int test_digest_pool(void *data);
+#endif
 int test_sha3_224(void *data);
 int test_sha3_256(void *data);
 int test_sha3_384(void *data);
 int test_sha3_512(void *data);
+#ifdef WP_HAVE_SHAKE_128
+int test_shake_128(void *data);
+#endif
 #ifdef WP_HAVE_SHAKE_256
 int test_shake_256(void *data);
+int test_shake_256_stream(void *data);
 #endif
 
 #endif /* WP_HAVE_DIGEST */
 
 #ifdef WP_HAVE_HMAC
 int test_hmac_create(void *data);
+int test_hmac_reinit(void *data);
+int test_hmac_sign_reuse(void *data);
 #endif /* WP_HAVE_HMAC */
 
 #ifdef WP_HAVE_CMAC
@@ -166,6 +202,7 @@ int test_tls1_prf(void *data);
 
 #ifdef WP_HAVE_HKDF
 int test_hkdf(void *data);
+int test_tls13_key_schedule(void *data);
 #endif
 
 #ifdef WP_HAVE_DES3CBC
@@ -210,6 +247,9 @@ int test_aes192_gcm(void *data);
 int test_aes256_gcm(void *data);
 int test_aes128_gcm_fixed(void *data);
 int test_aes128_gcm_tls(void *data);
+int test_aes128_gcm_tls_records(void *data);
+int test_aes128_gcm_dup(void *data);
+int test_aes128_gcm_stream(void *data);
 
 #endif /* WP_HAVE_AESGCM */
 
@@ -219,12 +259,36 @@ int test_aes128_ccm(void *data);
 int test_aes192_ccm(void *data);
 int test_aes256_ccm(void *data);
 int test_aes128_ccm_tls(void *data);
+int test_aes128_ccm_tls_batch(void *data);
 
 #endif /* WP_HAVE_AESCCM */
 
+#ifdef WP_HAVE_AESXTS
+
+int test_aes128_xts(void *data);
+int test_aes256_xts(void *data);
+int test_aes256_xts_data_units(void *data);
+int test_aes128_xts_reinit(void *data);
+
+#endif /* WP_HAVE_AESXTS */
+
+int test_aes128_wrap_batch(void *data);
+
+#if defined(WP_HAVE_AESCBC) && defined(WP_HAVE_HMAC) && defined(WP_HAVE_SHA256)
+int test_aes128_cbc_hmac_sha256_tls(void *data);
+#endif
+
+#ifdef WP_HAVE_CHACHA20_POLY1305
+
+int test_chacha20_poly1305(void *data);
+int test_chacha20_poly1305_tls(void *data);
+
+#endif /* WP_HAVE_CHACHA20_POLY1305 */
+
 #ifdef WP_HAVE_RANDOM
 
 int test_random(void *data);
+int test_random_buffered(void *data);
 
 #endif
 
@@ -263,15 +327,24 @@ int test_rsa_sign_verify_pss(void *data);
 int test_rsa_enc_dec_pkcs1(void *data);
 int test_rsa_enc_dec_oaep(void *data);
 int test_rsa_pkey_keygen(void *data);
+int test_rsa_pkey_keygen_pool(void *data);
 int test_rsa_pkey_invalid_key_size(void *data);
 
+int test_rsa_import_no_crt(void *data);
+#ifdef WOLF_CRYPTO_CB
+int test_rsa_multi_prime(void *data);
+#endif
+int test_rsa_decode_pub_only(void* data);
 int test_rsa_load_key(void* data);
 int test_rsa_load_cert(void* data);
+int test_rsa_load_cert_chain(void* data);
+int test_rsa_load_cert_dir(void* data);
 #endif /* WP_HAVE_RSA */
 
 #ifdef WP_HAVE_DH
 int test_dh_pgen_pkey(void *data);
 int test_dh_pkey(void *data);
+int test_dh_named_group(void *data);
 #endif /* WP_HAVE_DH */
 
 #ifdef WP_HAVE_ECC
@@ -288,6 +361,7 @@ int test_eckeygen_p224(void *data);
 
 #ifdef WP_HAVE_EC_P256
 int test_eckeygen_p256(void *data);
+int test_eckeygen_pool_fork(void *data);
 #endif /* WP_HAVE_EC_P256 */
 
 #ifdef WP_HAVE_EC_P384
@@ -333,6 +407,10 @@ int test_ecdh_x25519_keygen(void *data);
 #ifdef WP_HAVE_X448
 int test_ecdh_x448_keygen(void *data);
 #endif /* WP_HAVE_X448 */
+int test_ecdh_hkdf_extract(void *data);
+#ifdef WP_HAVE_EC_P256
+int test_ecdh_p256_peer_import(void *data);
+#endif /* WP_HAVE_EC_P256 */
 
 #endif /* WP_HAVE_ECKEYGEN */
 
@@ -373,6 +451,7 @@ int test_ecdsa_p521_pkey(void *data);
 #ifdef WP_HAVE_EC_P256
 int test_ecdsa_p256_pkey(void *data);
 int test_ecdsa_p256(void *data);
+int test_ecdsa_p256_batch_verify(void *data);
 #endif /* WP_HAVE_EC_P256 */
 
 #ifdef WP_HAVE_EC_P384
@@ -386,12 +465,22 @@ int test_ecdsa_p521(void *data);
 
 int test_ec_load_key(void* data);
 int test_ec_load_cert(void* data);
+int test_ec_encode_spki(void* data);
+int test_ec_export_keypair(void* data);
 #endif /* WP_HAVE_ECDSA */
 
 #endif /* WP_HAVE_ECC */
 
+#ifdef WP_HAVE_MLKEM
+int test_mlkem_768(void *data);
+int test_x25519mlkem768(void *data);
+int test_secp256r1mlkem768(void *data);
+#endif /* WP_HAVE_MLKEM */
+
 #ifdef WP_HAVE_PBE
 int test_pbe(void *data);
+int test_pbkdf2_threads(void *data);
+int test_pbe_epki_cache(void *data);
 #endif /* WP_HAVE_PBE */
 
 #endif /* UNIT_H */